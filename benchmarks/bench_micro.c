@@ -0,0 +1,820 @@
+/**
+ * Microbenchmark Regression Suite
+ *
+ * Machine-readable benchmarks for hot components:
+ * - Placement (consistent hash ring lookup)
+ * - Registry cache hits
+ * - xl.meta serialization / deserialization
+ * - AWS SigV4 verification
+ * - Erasure coding encode / decode (8+4)
+ * - BLAKE2b-256
+ * - Atomic write / read of a 4KB file
+ *
+ * Each case reports ns/op, allocations/op, allocated bytes/op and
+ * syscalls/op (via per-request accounting), plus MB/s for
+ * payload-processing cases. Results can be written as JSON or CSV and
+ * compared against a checked-in baseline; any case slower than the
+ * baseline by more than the tolerance, or allocating or making syscalls
+ * more, fails the run, as does a case a populated baseline has no entry
+ * for. An empty baseline (none generated yet for this machine) only warns;
+ * create one with `make bench-baseline` on the reference machine. A budget
+ * file caps allocs/op and syscalls/op absolutely, independent of the
+ * baseline.
+ *
+ * Usage:
+ *   bench_micro [--json FILE] [--csv FILE] [--baseline FILE]
+ *               [--tolerance PCT] [--budget FILE] [--filter SUBSTR]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_io.h"
+#include "buckets_cluster.h"
+#include "buckets_placement.h"
+#include "buckets_registry.h"
+#include "buckets_storage.h"
+#include "buckets_erasure.h"
+#include "buckets_crypto.h"
+#include "buckets_s3.h"
+#include "cJSON.h"
+
+/* Benchmark configuration */
+#define MICRO_MIN_RUN_NS   (50 * 1000 * 1000ULL)   /* Calibrate to >= 50ms per run */
+#define MICRO_REPEATS      5                        /* Best of N runs */
+#define MICRO_MAX_CASES    32
+#define MICRO_DATA_DIR     "/tmp/buckets-bench-micro"
+#define MICRO_DISKS        12
+#define MICRO_DEFAULT_TOLERANCE 10.0                /* Percent */
+
+/* ========================================================================
+ * Runner
+ * ======================================================================== */
+
+typedef void (*micro_op_fn)(void *state);
+
+typedef struct {
+    const char *name;
+    size_t payload;             /* Bytes processed per op (0 = not a throughput case) */
+    micro_op_fn op;
+    void *state;
+} micro_case_t;
+
+typedef struct {
+    char name[64];
+    u64 iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    double syscalls_per_op;
+    double mb_per_s;
+} micro_result_t;
+
+static inline u64 now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static u64 time_iterations(const micro_case_t *c, u64 iters)
+{
+    u64 start = now_ns();
+    for (u64 i = 0; i < iters; i++) {
+        c->op(c->state);
+    }
+    return now_ns() - start;
+}
+
+static void run_case(const micro_case_t *c, micro_result_t *r)
+{
+    /* Calibrate iteration count */
+    u64 iters = 1;
+    while (time_iterations(c, iters) < MICRO_MIN_RUN_NS && iters < (1ULL << 30)) {
+        iters *= 2;
+    }
+
+    /* Best of N: the minimum is the least noisy estimator on a shared box */
+    u64 best_ns = UINT64_MAX;
+    for (int rep = 0; rep < MICRO_REPEATS; rep++) {
+        u64 ns = time_iterations(c, iters);
+        if (ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+
+    /* Separate pass with accounting on so counters don't skew timing */
+    buckets_account_t account;
+    buckets_account_enable(true);
+    buckets_account_begin(&account);
+    time_iterations(c, iters);
+    buckets_account_end(&account);
+    buckets_account_enable(false);
+
+    snprintf(r->name, sizeof(r->name), "%s", c->name);
+    r->iterations = iters;
+    r->ns_per_op = (double)best_ns / (double)iters;
+    r->allocs_per_op = (double)account.allocs / (double)iters;
+    r->bytes_per_op = (double)account.alloc_bytes / (double)iters;
+    r->syscalls_per_op = (double)buckets_account_syscall_total(&account) / (double)iters;
+    r->mb_per_s = c->payload ? ((double)c->payload / r->ns_per_op) * 1e3 : 0.0;
+}
+
+/* ========================================================================
+ * Cases: Placement
+ * ======================================================================== */
+
+static char *g_disk_paths[MICRO_DISKS];
+static bool g_placement_ready = false;
+static u64 g_placement_counter = 0;
+
+static bool setup_placement(void)
+{
+    buckets_format_t *format = buckets_format_new(1, MICRO_DISKS);
+    if (!format) {
+        return false;
+    }
+
+    for (int i = 0; i < MICRO_DISKS; i++) {
+        g_disk_paths[i] = buckets_format("%s/disk%d", MICRO_DATA_DIR, i);
+        mkdir(g_disk_paths[i], 0755);
+        snprintf(format->erasure.this_disk, sizeof(format->erasure.this_disk), "%s",
+                 format->erasure.sets[0][i]);
+        if (buckets_format_save(g_disk_paths[i], format) != BUCKETS_OK) {
+            buckets_format_free(format);
+            return false;
+        }
+    }
+
+    buckets_cluster_topology_t *topology = buckets_topology_from_format(format);
+    buckets_format_free(format);
+    if (!topology) {
+        return false;
+    }
+    for (int i = 0; i < MICRO_DISKS; i++) {
+        buckets_topology_save(g_disk_paths[i], topology);
+    }
+    buckets_topology_free(topology);
+
+    if (buckets_topology_manager_init(g_disk_paths, MICRO_DISKS) != BUCKETS_OK ||
+        buckets_topology_manager_load() != BUCKETS_OK ||
+        buckets_placement_init() != 0) {
+        return false;
+    }
+
+    g_placement_ready = true;
+    return true;
+}
+
+static void op_placement_compute(void *state)
+{
+    (void)state;
+    char object[64];
+    snprintf(object, sizeof(object), "photos/%llu.jpg",
+             (unsigned long long)(g_placement_counter++ & 4095));
+
+    buckets_placement_result_t *result = NULL;
+    if (buckets_placement_compute("bench-bucket", object, &result) == 0) {
+        buckets_placement_free_result(result);
+    }
+}
+
+/* ========================================================================
+ * Cases: Registry
+ * ======================================================================== */
+
+static void setup_registry(void)
+{
+    buckets_object_location_t loc = {0};
+    loc.bucket = "bench-bucket";
+    loc.object = "bench-object";
+    loc.version_id = "v1";
+    loc.set_idx = 0;
+    loc.disk_count = MICRO_DISKS;
+    for (u32 i = 0; i < MICRO_DISKS; i++) {
+        loc.disk_idxs[i] = i;
+    }
+    loc.generation = 1;
+    loc.mod_time = time(NULL);
+    loc.size = 1024 * 1024;
+
+    buckets_registry_record(&loc);
+}
+
+static void op_registry_lookup_hit(void *state)
+{
+    (void)state;
+    buckets_object_location_t *result = NULL;
+    buckets_registry_lookup("bench-bucket", "bench-object", "v1", &result);
+    buckets_registry_location_free(result);
+}
+
+/* ========================================================================
+ * Cases: xl.meta
+ * ======================================================================== */
+
+typedef struct {
+    buckets_xl_meta_t meta;
+    char *json;
+} xlmeta_state_t;
+
+static void setup_xlmeta(xlmeta_state_t *st)
+{
+    buckets_xl_meta_t *meta = &st->meta;
+    memset(meta, 0, sizeof(*meta));
+
+    meta->version = 1;
+    snprintf(meta->format, sizeof(meta->format), "xl");
+    meta->stat.size = 16 * 1024 * 1024;
+    buckets_get_iso8601_time(meta->stat.modTime);
+
+    snprintf(meta->erasure.algorithm, sizeof(meta->erasure.algorithm), "ReedSolomon");
+    meta->erasure.data = 8;
+    meta->erasure.parity = 4;
+    meta->erasure.blockSize = 2 * 1024 * 1024;
+    meta->erasure.index = 1;
+    meta->erasure.distribution = buckets_calloc(12, sizeof(u32));
+    meta->erasure.checksums = buckets_calloc(12, sizeof(buckets_checksum_t));
+    for (u32 i = 0; i < 12; i++) {
+        meta->erasure.distribution[i] = i + 1;
+        snprintf(meta->erasure.checksums[i].algo, sizeof(meta->erasure.checksums[i].algo),
+                 "BLAKE2b-256");
+        memset(meta->erasure.checksums[i].hash, (int)i, sizeof(meta->erasure.checksums[i].hash));
+    }
+
+    meta->meta.content_type = buckets_strdup("application/octet-stream");
+    meta->meta.etag = buckets_strdup("d41d8cd98f00b204e9800998ecf8427e");
+    meta->versioning.versionId = buckets_strdup("3f2a9c1e-5b7d-4e8f-a1b2-c3d4e5f60718");
+    meta->versioning.isLatest = true;
+
+    st->json = buckets_xl_meta_to_json(meta);
+}
+
+static void op_xlmeta_serialize(void *state)
+{
+    xlmeta_state_t *st = state;
+    char *json = buckets_xl_meta_to_json(&st->meta);
+    buckets_free(json);
+}
+
+static void op_xlmeta_deserialize(void *state)
+{
+    xlmeta_state_t *st = state;
+    buckets_xl_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    if (buckets_xl_meta_from_json(st->json, &meta) == 0) {
+        buckets_xl_meta_free(&meta);
+    }
+}
+
+/* ========================================================================
+ * Cases: SigV4
+ * ======================================================================== */
+
+static buckets_s3_request_t *g_sigv4_req = NULL;
+
+static void setup_sigv4(void)
+{
+    buckets_s3_auth_init(true);
+
+    g_sigv4_req = buckets_calloc(1, sizeof(*g_sigv4_req));
+    snprintf(g_sigv4_req->bucket, sizeof(g_sigv4_req->bucket), "bench-bucket");
+    snprintf(g_sigv4_req->key, sizeof(g_sigv4_req->key), "photos/cat.jpg");
+    snprintf(g_sigv4_req->access_key, sizeof(g_sigv4_req->access_key), "AKIABENCHMARK");
+    snprintf(g_sigv4_req->signature, sizeof(g_sigv4_req->signature),
+             "%064d", 0);
+    snprintf(g_sigv4_req->signed_headers, sizeof(g_sigv4_req->signed_headers),
+             "host;x-amz-content-sha256;x-amz-date");
+    snprintf(g_sigv4_req->date, sizeof(g_sigv4_req->date), "20250101T000000Z");
+    snprintf(g_sigv4_req->region, sizeof(g_sigv4_req->region), "us-east-1");
+}
+
+static void op_sigv4_verify(void *state)
+{
+    (void)state;
+    /* Signature never matches: the full derivation and compare still run */
+    buckets_s3_verify_signature(g_sigv4_req, "benchmarkSecretKey/EXAMPLEKEY0123456789");
+}
+
+/* ========================================================================
+ * Cases: Erasure Coding
+ * ======================================================================== */
+
+typedef struct {
+    buckets_ec_ctx_t ctx;
+    u32 k;
+    u32 m;
+    size_t data_size;
+    size_t chunk_size;
+    u8 *data;
+    u8 *decoded;
+    u8 **data_chunks;
+    u8 **parity_chunks;
+    u8 **all_chunks;
+} ec_state_t;
+
+static bool setup_ec(ec_state_t *st, size_t data_size)
+{
+    st->k = 8;
+    st->m = 4;
+    st->data_size = data_size;
+    if (buckets_ec_init(&st->ctx, st->k, st->m) != 0) {
+        return false;
+    }
+
+    st->chunk_size = buckets_ec_calc_chunk_size(data_size, st->k);
+    st->data = buckets_malloc(data_size);
+    for (size_t i = 0; i < data_size; i++) {
+        st->data[i] = (u8)((i * 17 + 42) % 256);
+    }
+    st->decoded = buckets_malloc(st->chunk_size * st->k);
+
+    st->data_chunks = buckets_malloc(st->k * sizeof(u8 *));
+    st->parity_chunks = buckets_malloc(st->m * sizeof(u8 *));
+    st->all_chunks = buckets_malloc((st->k + st->m) * sizeof(u8 *));
+    for (u32 i = 0; i < st->k; i++) {
+        st->data_chunks[i] = buckets_malloc(st->chunk_size);
+    }
+    for (u32 i = 0; i < st->m; i++) {
+        st->parity_chunks[i] = buckets_malloc(st->chunk_size);
+    }
+
+    buckets_ec_encode(&st->ctx, st->data, data_size, st->chunk_size,
+                      st->data_chunks, st->parity_chunks);
+    return true;
+}
+
+static void op_ec_encode(void *state)
+{
+    ec_state_t *st = state;
+    buckets_ec_encode(&st->ctx, st->data, st->data_size, st->chunk_size,
+                      st->data_chunks, st->parity_chunks);
+}
+
+static void op_ec_decode_degraded(void *state)
+{
+    ec_state_t *st = state;
+
+    /* Two data shards missing: exercises the reconstruction path */
+    for (u32 i = 0; i < st->k; i++) {
+        st->all_chunks[i] = st->data_chunks[i];
+    }
+    for (u32 i = 0; i < st->m; i++) {
+        st->all_chunks[st->k + i] = st->parity_chunks[i];
+    }
+    st->all_chunks[1] = NULL;
+    st->all_chunks[5] = NULL;
+
+    buckets_ec_decode(&st->ctx, st->all_chunks, st->chunk_size, st->decoded, st->data_size);
+}
+
+static void free_ec(ec_state_t *st)
+{
+    for (u32 i = 0; i < st->k; i++) {
+        buckets_free(st->data_chunks[i]);
+    }
+    for (u32 i = 0; i < st->m; i++) {
+        buckets_free(st->parity_chunks[i]);
+    }
+    buckets_free(st->data_chunks);
+    buckets_free(st->parity_chunks);
+    buckets_free(st->all_chunks);
+    buckets_free(st->decoded);
+    buckets_free(st->data);
+    buckets_ec_free(&st->ctx);
+}
+
+/* ========================================================================
+ * Cases: BLAKE2b
+ * ======================================================================== */
+
+typedef struct {
+    u8 *data;
+    size_t size;
+} hash_state_t;
+
+static void op_blake2b_256(void *state)
+{
+    hash_state_t *st = state;
+    u8 hash[32];
+    buckets_blake2b_256(hash, st->data, st->size);
+}
+
+/* ========================================================================
+ * Cases: Atomic File I/O
+ * ======================================================================== */
+
+typedef struct {
+    char path[256];
+    u8 data[4096];
+} file_state_t;
+
+static void op_atomic_write(void *state)
+{
+    file_state_t *st = state;
+    buckets_atomic_write(st->path, st->data, sizeof(st->data));
+}
+
+static void op_atomic_read(void *state)
+{
+    file_state_t *st = state;
+    void *data = NULL;
+    size_t size = 0;
+    if (buckets_atomic_read(st->path, &data, &size) == BUCKETS_OK) {
+        buckets_free(data);
+    }
+}
+
+/* ========================================================================
+ * Output
+ * ======================================================================== */
+
+static int write_json(const char *path, const micro_result_t *results, int count)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "version", 1);
+    cJSON *arr = cJSON_AddArrayToObject(root, "results");
+    for (int i = 0; i < count; i++) {
+        cJSON *r = cJSON_CreateObject();
+        cJSON_AddStringToObject(r, "name", results[i].name);
+        cJSON_AddNumberToObject(r, "iterations", (double)results[i].iterations);
+        cJSON_AddNumberToObject(r, "ns_per_op", results[i].ns_per_op);
+        cJSON_AddNumberToObject(r, "allocs_per_op", results[i].allocs_per_op);
+        cJSON_AddNumberToObject(r, "bytes_per_op", results[i].bytes_per_op);
+        cJSON_AddNumberToObject(r, "syscalls_per_op", results[i].syscalls_per_op);
+        cJSON_AddNumberToObject(r, "mb_per_s", results[i].mb_per_s);
+        cJSON_AddItemToArray(arr, r);
+    }
+
+    char *json = cJSON_Print(root);
+    cJSON_Delete(root);
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        buckets_free(json);
+        return -1;
+    }
+    fprintf(fp, "%s\n", json);
+    fclose(fp);
+    buckets_free(json);
+    return 0;
+}
+
+static int write_csv(const char *path, const micro_result_t *results, int count)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return -1;
+    }
+    fprintf(fp, "name,iterations,ns_per_op,allocs_per_op,bytes_per_op,syscalls_per_op,mb_per_s\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(fp, "%s,%llu,%.2f,%.2f,%.1f,%.2f,%.2f\n",
+                results[i].name, (unsigned long long)results[i].iterations,
+                results[i].ns_per_op, results[i].allocs_per_op,
+                results[i].bytes_per_op, results[i].syscalls_per_op,
+                results[i].mb_per_s);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* ========================================================================
+ * Baseline Comparison
+ * ======================================================================== */
+
+/* Load a JSON file and return its root plus the named array (NULL on error) */
+static cJSON* load_json_array(const char *path, const char *key, cJSON **arr_out)
+{
+    void *data = NULL;
+    size_t size = 0;
+    if (buckets_atomic_read(path, &data, &size) != BUCKETS_OK) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return NULL;
+    }
+
+    /* buckets_atomic_read NUL-terminates the buffer */
+    cJSON *root = cJSON_Parse(data);
+    buckets_free(data);
+    cJSON *arr = root ? cJSON_GetObjectItem(root, key) : NULL;
+    if (!cJSON_IsArray(arr)) {
+        fprintf(stderr, "Malformed %s (missing \"%s\" array)\n", path, key);
+        cJSON_Delete(root);
+        return NULL;
+    }
+
+    *arr_out = arr;
+    return root;
+}
+
+static cJSON* find_named(cJSON *arr, const char *name)
+{
+    cJSON *item;
+    cJSON_ArrayForEach(item, arr) {
+        cJSON *n = cJSON_GetObjectItem(item, "name");
+        if (cJSON_IsString(n) && strcmp(n->valuestring, name) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+/* Returns number of regressions (including cases missing from a
+ * populated baseline), or -1 if the baseline can't be read */
+static int compare_baseline(const char *path, const micro_result_t *results, int count,
+                            double tolerance_pct)
+{
+    cJSON *arr = NULL;
+    cJSON *root = load_json_array(path, "results", &arr);
+    if (!root) {
+        return -1;
+    }
+
+    if (cJSON_GetArraySize(arr) == 0) {
+        printf("\nWARNING: baseline %s is empty; nothing compared "
+               "(run `make bench-baseline` on the reference machine)\n", path);
+        cJSON_Delete(root);
+        return 0;
+    }
+
+    double factor = 1.0 + tolerance_pct / 100.0;
+    int regressions = 0;
+
+    printf("\nBaseline comparison (%s, tolerance %.1f%%):\n", path, tolerance_pct);
+    for (int i = 0; i < count; i++) {
+        const micro_result_t *r = &results[i];
+        cJSON *base = find_named(arr, r->name);
+
+        if (!base) {
+            printf("  %-28s MISSING (no baseline entry)\n", r->name);
+            regressions++;
+            continue;
+        }
+
+        double base_ns = cJSON_GetNumberValue(cJSON_GetObjectItem(base, "ns_per_op"));
+        double base_allocs = cJSON_GetNumberValue(cJSON_GetObjectItem(base, "allocs_per_op"));
+        cJSON *base_sys_item = cJSON_GetObjectItem(base, "syscalls_per_op");
+        double delta = base_ns > 0 ? (r->ns_per_op / base_ns - 1.0) * 100.0 : 0.0;
+
+        /* Allocation and syscall counts are deterministic: allow only rounding noise */
+        bool slow = base_ns > 0 && r->ns_per_op > base_ns * factor;
+        bool allocs = r->allocs_per_op > base_allocs + 0.5;
+        bool syscalls = cJSON_IsNumber(base_sys_item) &&
+                        r->syscalls_per_op > base_sys_item->valuedouble + 0.5;
+
+        printf("  %-28s %+7.1f%% ns/op  allocs %.1f -> %.1f  syscalls %.1f -> %.1f  %s\n",
+               r->name, delta, base_allocs, r->allocs_per_op,
+               cJSON_IsNumber(base_sys_item) ? base_sys_item->valuedouble : 0.0,
+               r->syscalls_per_op,
+               (slow || allocs || syscalls) ? "REGRESSION" : "ok");
+        if (slow || allocs || syscalls) {
+            regressions++;
+        }
+    }
+
+    cJSON_Delete(root);
+    return regressions;
+}
+
+/* ========================================================================
+ * Budgets
+ * ======================================================================== */
+
+/* Returns number of cases over budget, or -1 if the budget file can't be read */
+static int check_budgets(const char *path, const micro_result_t *results, int count)
+{
+    cJSON *arr = NULL;
+    cJSON *root = load_json_array(path, "budgets", &arr);
+    if (!root) {
+        return -1;
+    }
+
+    int violations = 0;
+    printf("\nBudget check (%s):\n", path);
+    for (int i = 0; i < count; i++) {
+        const micro_result_t *r = &results[i];
+        cJSON *budget = find_named(arr, r->name);
+        if (!budget) {
+            continue;
+        }
+
+        cJSON *max_allocs = cJSON_GetObjectItem(budget, "max_allocs_per_op");
+        cJSON *max_syscalls = cJSON_GetObjectItem(budget, "max_syscalls_per_op");
+        bool over_allocs = cJSON_IsNumber(max_allocs) &&
+                           r->allocs_per_op > max_allocs->valuedouble;
+        bool over_syscalls = cJSON_IsNumber(max_syscalls) &&
+                             r->syscalls_per_op > max_syscalls->valuedouble;
+
+        char allocs_cap[32] = "-";
+        char syscalls_cap[32] = "-";
+        if (cJSON_IsNumber(max_allocs)) {
+            snprintf(allocs_cap, sizeof(allocs_cap), "%.1f", max_allocs->valuedouble);
+        }
+        if (cJSON_IsNumber(max_syscalls)) {
+            snprintf(syscalls_cap, sizeof(syscalls_cap), "%.1f", max_syscalls->valuedouble);
+        }
+
+        printf("  %-28s allocs %.1f / %s  syscalls %.1f / %s  %s\n",
+               r->name, r->allocs_per_op, allocs_cap,
+               r->syscalls_per_op, syscalls_cap,
+               (over_allocs || over_syscalls) ? "OVER BUDGET" : "ok");
+        if (over_allocs || over_syscalls) {
+            violations++;
+        }
+    }
+
+    cJSON_Delete(root);
+    return violations;
+}
+
+/* ========================================================================
+ * Main
+ * ======================================================================== */
+
+static void *counting_malloc(size_t size)
+{
+    return buckets_malloc(size);
+}
+
+static void cleanup_data_dir(void)
+{
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", MICRO_DATA_DIR);
+    int ret = system(cmd);
+    (void)ret;
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = NULL;
+    const char *csv_path = NULL;
+    const char *baseline_path = NULL;
+    const char *budget_path = NULL;
+    const char *filter = NULL;
+    double tolerance = MICRO_DEFAULT_TOLERANCE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            budget_path = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--json FILE] [--csv FILE] [--baseline FILE] "
+                    "[--tolerance PCT] [--budget FILE] [--filter SUBSTR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* Disable debug logging for clean benchmark output */
+    setenv("BUCKETS_LOG_LEVEL", "ERROR", 1);
+
+    if (buckets_init() != 0) {
+        fprintf(stderr, "Failed to initialize buckets\n");
+        return 1;
+    }
+
+    /* Route cJSON through buckets_malloc so its allocations are counted */
+    cJSON_Hooks hooks = { .malloc_fn = counting_malloc, .free_fn = buckets_free };
+    cJSON_InitHooks(&hooks);
+
+    cleanup_data_dir();
+    mkdir(MICRO_DATA_DIR, 0755);
+
+    buckets_storage_config_t storage_config = {
+        .data_dir = MICRO_DATA_DIR,
+        .inline_threshold = 128 * 1024,
+        .default_ec_k = 8,
+        .default_ec_m = 4,
+        .verify_checksums = true
+    };
+    buckets_storage_init(&storage_config);
+    buckets_registry_init(NULL);
+
+    /* Fixtures */
+    xlmeta_state_t xlmeta;
+    setup_xlmeta(&xlmeta);
+    setup_registry();
+    setup_sigv4();
+    if (!setup_placement()) {
+        fprintf(stderr, "Placement setup failed - skipping placement case\n");
+    }
+
+    ec_state_t ec_1m;
+    ec_state_t ec_128k;
+    bool ec_ready = setup_ec(&ec_1m, 1024 * 1024) && setup_ec(&ec_128k, 128 * 1024);
+
+    hash_state_t hash_4k = { buckets_malloc(4096), 4096 };
+    hash_state_t hash_1m = { buckets_malloc(1024 * 1024), 1024 * 1024 };
+    memset(hash_4k.data, 0xab, hash_4k.size);
+    memset(hash_1m.data, 0xcd, hash_1m.size);
+
+    file_state_t file_4k;
+    snprintf(file_4k.path, sizeof(file_4k.path), "%s/io/file.bin", MICRO_DATA_DIR);
+    memset(file_4k.data, 0x5a, sizeof(file_4k.data));
+    buckets_atomic_write(file_4k.path, file_4k.data, sizeof(file_4k.data));
+
+    micro_case_t cases[MICRO_MAX_CASES];
+    int case_count = 0;
+
+    if (g_placement_ready) {
+        cases[case_count++] = (micro_case_t){ "placement_compute", 0, op_placement_compute, NULL };
+    }
+    cases[case_count++] = (micro_case_t){ "registry_lookup_hit", 0, op_registry_lookup_hit, NULL };
+    cases[case_count++] = (micro_case_t){ "xlmeta_serialize", 0, op_xlmeta_serialize, &xlmeta };
+    cases[case_count++] = (micro_case_t){ "xlmeta_deserialize", 0, op_xlmeta_deserialize, &xlmeta };
+    cases[case_count++] = (micro_case_t){ "sigv4_verify", 0, op_sigv4_verify, NULL };
+    if (ec_ready) {
+        cases[case_count++] = (micro_case_t){ "ec_encode_8+4_128KB", 128 * 1024, op_ec_encode, &ec_128k };
+        cases[case_count++] = (micro_case_t){ "ec_encode_8+4_1MB", 1024 * 1024, op_ec_encode, &ec_1m };
+        cases[case_count++] = (micro_case_t){ "ec_decode_8+4_1MB_degraded", 1024 * 1024,
+                                              op_ec_decode_degraded, &ec_1m };
+    }
+    cases[case_count++] = (micro_case_t){ "blake2b_256_4KB", 4096, op_blake2b_256, &hash_4k };
+    cases[case_count++] = (micro_case_t){ "blake2b_256_1MB", 1024 * 1024, op_blake2b_256, &hash_1m };
+    cases[case_count++] = (micro_case_t){ "atomic_write_4KB", 4096, op_atomic_write, &file_4k };
+    cases[case_count++] = (micro_case_t){ "atomic_read_4KB", 4096, op_atomic_read, &file_4k };
+
+    micro_result_t results[MICRO_MAX_CASES];
+    int result_count = 0;
+
+    printf("%-28s %12s %14s %10s %12s %10s %10s\n",
+           "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op", "sys/op", "MB/s");
+    for (int i = 0; i < case_count; i++) {
+        if (filter && !strstr(cases[i].name, filter)) {
+            continue;
+        }
+        micro_result_t *r = &results[result_count++];
+        run_case(&cases[i], r);
+        printf("%-28s %12llu %14.1f %10.2f %12.1f %10.2f %10.1f\n",
+               r->name, (unsigned long long)r->iterations, r->ns_per_op,
+               r->allocs_per_op, r->bytes_per_op, r->syscalls_per_op, r->mb_per_s);
+    }
+
+    int ret = 0;
+    if (json_path && write_json(json_path, results, result_count) != 0) {
+        ret = 1;
+    }
+    if (csv_path && write_csv(csv_path, results, result_count) != 0) {
+        ret = 1;
+    }
+    if (baseline_path) {
+        int regressions = compare_baseline(baseline_path, results, result_count, tolerance);
+        if (regressions != 0) {
+            if (regressions > 0) {
+                printf("\n%d regression(s) or missing baseline entries\n", regressions);
+            }
+            ret = 1;
+        } else {
+            printf("\nNo regressions against baseline\n");
+        }
+    }
+    if (budget_path) {
+        int violations = check_budgets(budget_path, results, result_count);
+        if (violations != 0) {
+            if (violations > 0) {
+                printf("\n%d case(s) over budget\n", violations);
+            }
+            ret = 1;
+        } else {
+            printf("\nAll cases within budget\n");
+        }
+    }
+
+    /* Cleanup */
+    buckets_free(hash_4k.data);
+    buckets_free(hash_1m.data);
+    if (ec_ready) {
+        free_ec(&ec_1m);
+        free_ec(&ec_128k);
+    }
+    buckets_free(xlmeta.json);
+    buckets_xl_meta_free(&xlmeta.meta);
+    buckets_free(g_sigv4_req);
+    if (g_placement_ready) {
+        buckets_placement_cleanup();
+    }
+    buckets_topology_manager_cleanup();
+    buckets_registry_cleanup();
+    buckets_storage_cleanup();
+    for (int i = 0; i < MICRO_DISKS; i++) {
+        buckets_free(g_disk_paths[i]);
+    }
+    cleanup_data_dir();
+    buckets_cleanup();
+
+    return ret;
+}
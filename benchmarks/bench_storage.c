@@ -7,6 +7,21 @@
  * - Erasure coding encode/decode
  * - Metadata cache performance
  * - Scalability across different object sizes
+ * - Disk I/O mode comparison (--io-modes): chunk writes/reads through
+ *   io_uring, group commit (none/batched/immediate) and atomic write
+ * - Shard file fragmentation (--frag): extents per file and cold read
+ *   throughput with and without fallocate preallocation
+ * - Peer transport encryption (--peer-tls): CPU seconds per GB of shard
+ *   traffic over loopback, plaintext vs mutual TLS (kTLS when available)
+ *
+ * Usage:
+ *   bench_storage
+ *   bench_storage --io-modes [--dir DIR] [--sizes 4K,64K,1M] [--threads N]
+ *                 [--ops N] [--modes io_uring,gc-none,gc-batched,gc-immediate,atomic]
+ *   bench_storage --frag [--dir DIR] [--size 8M] [--piece 64K] [--threads N]
+ *                 [--files N]
+ *   bench_storage --peer-tls [--size 1G] [--piece 1M] [--cert PEM] [--key PEM]
+ *                 [--ca PEM]
  */
 
 #include <stdio.h>
@@ -17,12 +32,25 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
 
 #include "buckets.h"
 #include "buckets_storage.h"
 #include "buckets_cluster.h"
 #include "buckets_erasure.h"
 #include "buckets_crypto.h"
+#include "buckets_io.h"
+#include "buckets_net.h"
 
 /* Benchmark configuration */
 #define BENCH_WARMUP_ITERS 10
@@ -133,11 +161,12 @@ static void bench_single_disk_operations(size_t obj_size, const char *size_label
     buckets_storage_config_t config = {
         .data_dir = BENCH_DATA_DIR,
         .inline_threshold = 128 * 1024,
-        .ec_data_blocks = 8,
-        .ec_parity_blocks = 4
+        .default_ec_k = 8,
+        .default_ec_m = 4,
+        .verify_checksums = true
     };
     
-    if (!buckets_storage_init(&config)) {
+    if (buckets_storage_init(&config) != 0) {
         fprintf(stderr, "Failed to initialize storage\n");
         return;
     }
@@ -155,7 +184,7 @@ static void bench_single_disk_operations(size_t obj_size, const char *size_label
         char bucket[64], object[64];
         snprintf(bucket, sizeof(bucket), "warmup-bucket");
         snprintf(object, sizeof(object), "warmup-obj-%d", i);
-        buckets_storage_put(bucket, object, data, obj_size, NULL);
+        buckets_put_object(bucket, object, data, obj_size, NULL);
     }
     
     /* Benchmark PUT */
@@ -164,7 +193,7 @@ static void bench_single_disk_operations(size_t obj_size, const char *size_label
         char bucket[64], object[64];
         snprintf(bucket, sizeof(bucket), "bench-bucket");
         snprintf(object, sizeof(object), "obj-%d", i);
-        buckets_storage_put(bucket, object, data, obj_size, NULL);
+        buckets_put_object(bucket, object, data, obj_size, NULL);
     }
     double put_end = get_time_us();
     double put_total_us = put_end - put_start;
@@ -177,9 +206,9 @@ static void bench_single_disk_operations(size_t obj_size, const char *size_label
         char bucket[64], object[64];
         snprintf(bucket, sizeof(bucket), "bench-bucket");
         snprintf(object, sizeof(object), "obj-%d", i);
-        size_t size;
-        u8 *retrieved = buckets_storage_get(bucket, object, &size);
-        if (retrieved) {
+        void *retrieved = NULL;
+        size_t size = 0;
+        if (buckets_get_object(bucket, object, &retrieved, &size) == 0) {
             buckets_free(retrieved);
         }
     }
@@ -194,7 +223,7 @@ static void bench_single_disk_operations(size_t obj_size, const char *size_label
         char bucket[64], object[64];
         snprintf(bucket, sizeof(bucket), "bench-bucket");
         snprintf(object, sizeof(object), "obj-%d", i);
-        buckets_storage_delete(bucket, object);
+        buckets_delete_object(bucket, object);
     }
     double del_end = get_time_us();
     double del_total_us = del_end - del_start;
@@ -230,8 +259,8 @@ static void bench_erasure_coding(size_t data_size, const char *size_label)
     printf("\n" COLOR_CYAN "→ Erasure Coding (8+4, %s)" COLOR_RESET "\n", size_label);
     
     const int k = 8, m = 4;
-    buckets_ec_ctx_t *ctx = buckets_ec_init(k, m);
-    if (!ctx) {
+    buckets_ec_ctx_t ctx;
+    if (buckets_ec_init(&ctx, k, m) != 0) {
         fprintf(stderr, "Failed to initialize erasure coding context\n");
         return;
     }
@@ -240,7 +269,7 @@ static void bench_erasure_coding(size_t data_size, const char *size_label)
     u8 *data = generate_random_data(data_size);
     if (!data) {
         fprintf(stderr, "Failed to generate test data\n");
-        buckets_ec_free(ctx);
+        buckets_ec_free(&ctx);
         return;
     }
     
@@ -256,13 +285,13 @@ static void bench_erasure_coding(size_t data_size, const char *size_label)
     
     /* Warmup */
     for (int i = 0; i < BENCH_WARMUP_ITERS; i++) {
-        buckets_ec_encode(ctx, data, data_size, chunks, chunk_size);
+        buckets_ec_encode(&ctx, data, data_size, chunk_size, chunks, chunks + k);
     }
     
     /* Benchmark ENCODE */
     double enc_start = get_time_us();
     for (int i = 0; i < BENCH_MEASURE_ITERS; i++) {
-        buckets_ec_encode(ctx, data, data_size, chunks, chunk_size);
+        buckets_ec_encode(&ctx, data, data_size, chunk_size, chunks, chunks + k);
     }
     double enc_end = get_time_us();
     double enc_total_us = enc_end - enc_start;
@@ -273,7 +302,7 @@ static void bench_erasure_coding(size_t data_size, const char *size_label)
     u8 *decoded = buckets_malloc(aligned_size);
     double dec_start = get_time_us();
     for (int i = 0; i < BENCH_MEASURE_ITERS; i++) {
-        buckets_ec_decode(ctx, chunks, chunk_size, decoded, data_size);
+        buckets_ec_decode(&ctx, chunks, chunk_size, decoded, data_size);
     }
     double dec_end = get_time_us();
     double dec_total_us = dec_end - dec_start;
@@ -302,7 +331,7 @@ static void bench_erasure_coding(size_t data_size, const char *size_label)
     }
     buckets_free(chunks);
     buckets_free(data);
-    buckets_ec_free(ctx);
+    buckets_ec_free(&ctx);
 }
 
 /* ========================================================================
@@ -313,27 +342,28 @@ static void bench_metadata_cache(void)
 {
     printf("\n" COLOR_CYAN "→ Metadata Cache Performance" COLOR_RESET "\n");
     
-    buckets_metadata_cache_t *cache = buckets_metadata_cache_init(10000, 300);
-    if (!cache) {
+    if (buckets_metadata_cache_init(10000, 300) != 0) {
         fprintf(stderr, "Failed to initialize metadata cache\n");
         return;
     }
     
     /* Create sample xl.meta */
-    buckets_xlmeta_t meta = {0};
+    buckets_xl_meta_t meta = {0};
+    meta.version = 1;
+    strcpy(meta.format, "xl");
     meta.stat.size = 1024;
-    meta.stat.mod_time = time(NULL);
+    buckets_get_iso8601_time(meta.stat.modTime);
     strcpy(meta.erasure.algorithm, "ReedSolomon");
-    meta.erasure.data_blocks = 8;
-    meta.erasure.parity_blocks = 4;
-    meta.erasure.block_size = 1024 * 1024;
+    meta.erasure.data = 8;
+    meta.erasure.parity = 4;
+    meta.erasure.blockSize = 1024 * 1024;
     
     /* Populate cache with test data */
     const int cache_entries = 1000;
     for (int i = 0; i < cache_entries; i++) {
         char key[128];
-        snprintf(key, sizeof(key), "bucket/object-%d", i);
-        buckets_metadata_cache_put(cache, key, &meta);
+        snprintf(key, sizeof(key), "object-%d", i);
+        buckets_metadata_cache_put("bucket", key, NULL, &meta);
     }
     
     /* Benchmark cache HIT */
@@ -341,11 +371,11 @@ static void bench_metadata_cache(void)
     int hits = 0;
     for (int i = 0; i < BENCH_MEASURE_ITERS * 10; i++) {
         char key[128];
-        snprintf(key, sizeof(key), "bucket/object-%d", i % cache_entries);
-        buckets_xlmeta_t *retrieved = buckets_metadata_cache_get(cache, key);
-        if (retrieved) {
+        snprintf(key, sizeof(key), "object-%d", i % cache_entries);
+        buckets_xl_meta_t retrieved;
+        if (buckets_metadata_cache_get("bucket", key, NULL, &retrieved) == 0) {
             hits++;
-            /* Don't free - cache owns it */
+            buckets_xl_meta_free(&retrieved);
         }
     }
     double hit_end = get_time_us();
@@ -357,10 +387,12 @@ static void bench_metadata_cache(void)
     int misses = 0;
     for (int i = 0; i < BENCH_MEASURE_ITERS * 10; i++) {
         char key[128];
-        snprintf(key, sizeof(key), "bucket/object-miss-%d", i);
-        buckets_xlmeta_t *retrieved = buckets_metadata_cache_get(cache, key);
-        if (!retrieved) {
+        snprintf(key, sizeof(key), "object-miss-%d", i);
+        buckets_xl_meta_t retrieved;
+        if (buckets_metadata_cache_get("bucket", key, NULL, &retrieved) != 0) {
             misses++;
+        } else {
+            buckets_xl_meta_free(&retrieved);
         }
     }
     double miss_end = get_time_us();
@@ -368,23 +400,26 @@ static void bench_metadata_cache(void)
     double miss_avg_us = miss_total_us / (BENCH_MEASURE_ITERS * 10);
     
     /* Get cache statistics */
-    buckets_metadata_cache_stats_t stats;
-    buckets_metadata_cache_get_stats(cache, &stats);
+    u64 stat_hits = 0, stat_misses = 0, stat_evictions = 0;
+    u32 stat_count = 0;
+    buckets_metadata_cache_stats(&stat_hits, &stat_misses, &stat_evictions, &stat_count);
     
     /* Format and print results */
     char hit_lat_str[64], miss_lat_str[64];
     format_latency(hit_avg_us, hit_lat_str, sizeof(hit_lat_str));
     format_latency(miss_avg_us, miss_lat_str, sizeof(miss_lat_str));
     
-    printf("  Cache HIT:  %s/op  (%.0f ops/sec)\n", hit_lat_str, 1e6 / hit_avg_us);
-    printf("  Cache MISS: %s/op  (%.0f ops/sec)\n", miss_lat_str, 1e6 / miss_avg_us);
-    printf("  Hit ratio: %.1f%% (%zu hits, %zu misses)\n",
-           stats.hits * 100.0 / (stats.hits + stats.misses),
-           stats.hits, stats.misses);
+    printf("  Cache HIT:  %s/op  (%.0f ops/sec, %d hits)\n", hit_lat_str, 1e6 / hit_avg_us, hits);
+    printf("  Cache MISS: %s/op  (%.0f ops/sec, %d misses)\n", miss_lat_str, 1e6 / miss_avg_us, misses);
+    if (stat_hits + stat_misses > 0) {
+        printf("  Hit ratio: %.1f%% (%llu hits, %llu misses)\n",
+               (double)stat_hits * 100.0 / (double)(stat_hits + stat_misses),
+               (unsigned long long)stat_hits, (unsigned long long)stat_misses);
+    }
     printf("  Speedup: %.1fx faster on cache hit\n", miss_avg_us / hit_avg_us);
     
     /* Cleanup */
-    buckets_metadata_cache_free(cache);
+    buckets_metadata_cache_cleanup();
 }
 
 /* ========================================================================
@@ -439,18 +474,881 @@ static void bench_crypto_hash(size_t data_size, const char *size_label)
     buckets_free(data);
 }
 
+/* ========================================================================
+ * Benchmark 5: Disk I/O Mode Comparison
+ *
+ * Writes and reads chunks through buckets_write_chunk/buckets_read_chunk
+ * with the write path pinned to each mode. Syscalls are counted with the
+ * per-thread buckets_account counters, so open/write/fsync/rename/mkdir
+ * issued by the worker threads are all included. Work a background
+ * flusher does on their behalf is not attributed.
+ * ======================================================================== */
+
+#define IO_MAX_SIZES 16
+#define IO_MAX_THREADS 256
+#define IO_DEFAULT_DIR "/tmp/buckets-bench-io"
+#define IO_DEFAULT_THREADS 4
+#define IO_DEFAULT_OPS 2000
+
+typedef struct {
+    const char *name;                   /* Label and --modes token */
+    buckets_chunk_write_mode_t mode;    /* Pinned write path */
+    int durability;                     /* Group commit durability (-1 = untouched) */
+} io_mode_t;
+
+static const io_mode_t g_io_modes[] = {
+    { "io_uring",     BUCKETS_CHUNK_WRITE_IO_URING,     -1 },
+    { "gc-none",      BUCKETS_CHUNK_WRITE_GROUP_COMMIT,  0 },
+    { "gc-batched",   BUCKETS_CHUNK_WRITE_GROUP_COMMIT,  1 },
+    { "gc-immediate", BUCKETS_CHUNK_WRITE_GROUP_COMMIT,  2 },
+    { "atomic",       BUCKETS_CHUNK_WRITE_ATOMIC,       -1 },
+};
+
+#define IO_MODE_COUNT (sizeof(g_io_modes) / sizeof(g_io_modes[0]))
+
+typedef struct {
+    const char *dir;
+    size_t sizes[IO_MAX_SIZES];
+    int size_count;
+    int threads;
+    int ops;
+    const char *modes;                  /* Comma-separated filter (NULL = all) */
+} io_bench_config_t;
+
+typedef struct {
+    const io_bench_config_t *cfg;
+    const char *mode_name;
+    const u8 *data;
+    size_t size;
+    int thread_id;
+    int ops;
+    double *write_lat;                  /* Per-op latency (μs) */
+    double *read_lat;
+    int write_fail;
+    int read_fail;
+    void *(*phase_fn)(void *);          /* Phase body run under accounting */
+    buckets_account_t account;          /* Syscalls issued by this phase */
+} io_worker_t;
+
+static int compare_double(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static double percentile(const double *sorted, int count, double pct)
+{
+    if (count <= 0) {
+        return 0;
+    }
+    int idx = (int)((double)count * pct / 100.0);
+    if (idx >= count) {
+        idx = count - 1;
+    }
+    return sorted[idx];
+}
+
+static void io_object_path(const io_worker_t *w, int op, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "io-bench/%s/%zu/t%d-%d/",
+             w->mode_name, w->size, w->thread_id, op);
+}
+
+static void* io_write_worker(void *arg)
+{
+    io_worker_t *w = arg;
+    for (int i = 0; i < w->ops; i++) {
+        char object_path[256];
+        io_object_path(w, i, object_path, sizeof(object_path));
+
+        double start = get_time_us();
+        if (buckets_write_chunk(w->cfg->dir, object_path, 1, w->data, w->size) != 0) {
+            w->write_fail++;
+        }
+        w->write_lat[i] = get_time_us() - start;
+    }
+    return NULL;
+}
+
+static void* io_read_worker(void *arg)
+{
+    io_worker_t *w = arg;
+    for (int i = 0; i < w->ops; i++) {
+        char object_path[256];
+        io_object_path(w, i, object_path, sizeof(object_path));
+
+        void *buf = NULL;
+        size_t size = 0;
+        double start = get_time_us();
+        if (buckets_read_chunk(w->cfg->dir, object_path, 1, &buf, &size) != 0 ||
+            size != w->size) {
+            w->read_fail++;
+        }
+        w->read_lat[i] = get_time_us() - start;
+        if (buf) {
+            buckets_free(buf);
+        }
+    }
+    return NULL;
+}
+
+/* Run a worker's phase body with its syscall account attached */
+static void* io_phase_thread(void *arg)
+{
+    io_worker_t *w = arg;
+    buckets_account_begin(&w->account);
+    w->phase_fn(w);
+    buckets_account_end(&w->account);
+    return NULL;
+}
+
+/* Run one phase on all threads, returning wall time (μs) and syscall count */
+static double io_run_phase(io_worker_t *workers, int threads,
+                           void *(*fn)(void *), u64 *syscalls)
+{
+    pthread_t tids[IO_MAX_THREADS];
+    double start = get_time_us();
+
+    for (int t = 0; t < threads; t++) {
+        workers[t].phase_fn = fn;
+        pthread_create(&tids[t], NULL, io_phase_thread, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+
+    double elapsed = get_time_us() - start;
+    *syscalls = 0;
+    for (int t = 0; t < threads; t++) {
+        *syscalls += buckets_account_syscall_total(&workers[t].account);
+    }
+    return elapsed;
+}
+
+static void io_report(const char *label, const char *op, io_worker_t *workers,
+                      int threads, bool write, double elapsed_us, u64 syscalls)
+{
+    int per_thread = workers[0].ops;
+    int total = per_thread * threads;
+    double *all = buckets_malloc((size_t)total * sizeof(double));
+    int fail = 0;
+
+    for (int t = 0; t < threads; t++) {
+        memcpy(all + (size_t)t * per_thread,
+               write ? workers[t].write_lat : workers[t].read_lat,
+               (size_t)per_thread * sizeof(double));
+        fail += write ? workers[t].write_fail : workers[t].read_fail;
+    }
+    qsort(all, (size_t)total, sizeof(double), compare_double);
+
+    double secs = elapsed_us / 1e6;
+    double iops = secs > 0 ? total / secs : 0;
+    double mbps = secs > 0 ? (double)(workers[0].size * (size_t)total) / secs / 1e6 : 0;
+
+    printf("  %-13s %-5s %9.0f IOPS %9.1f MB/s  p50 %8.1f  p95 %8.1f  p99 %8.1f  "
+           "p99.9 %9.1f μs  %5.1f sys/op%s\n",
+           label, op, iops, mbps,
+           percentile(all, total, 50), percentile(all, total, 95),
+           percentile(all, total, 99), percentile(all, total, 99.9),
+           (double)syscalls / total,
+           fail ? "  (failures)" : "");
+
+    buckets_free(all);
+}
+
+static bool io_mode_selected(const io_bench_config_t *cfg, const char *name)
+{
+    if (!cfg->modes) {
+        return true;
+    }
+
+    size_t len = strlen(name);
+    const char *p = cfg->modes;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t tok = end ? (size_t)(end - p) : strlen(p);
+        if (tok == len && strncmp(p, name, len) == 0) {
+            return true;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+static void bench_io_mode(const io_bench_config_t *cfg, const io_mode_t *mode, size_t size)
+{
+    const char *label = mode->name;
+    if (mode->mode == BUCKETS_CHUNK_WRITE_IO_URING && !buckets_chunk_get_io_uring_ctx()) {
+        label = "io_uring(n/a)";    /* Falls through to group commit */
+    }
+
+    buckets_chunk_set_write_mode(mode->mode);
+    if (mode->durability >= 0 && buckets_storage_set_durability(mode->durability) != 0) {
+        fprintf(stderr, "Failed to set durability for %s\n", mode->name);
+        return;
+    }
+
+    u8 *data = generate_random_data(size);
+    int per_thread = cfg->ops / cfg->threads;
+    if (!data || per_thread < 1) {
+        buckets_free(data);
+        return;
+    }
+
+    io_worker_t *workers = buckets_calloc((size_t)cfg->threads, sizeof(io_worker_t));
+    for (int t = 0; t < cfg->threads; t++) {
+        workers[t].cfg = cfg;
+        workers[t].mode_name = mode->name;
+        workers[t].data = data;
+        workers[t].size = size;
+        workers[t].thread_id = t;
+        workers[t].ops = per_thread;
+        workers[t].write_lat = buckets_calloc((size_t)per_thread, sizeof(double));
+        workers[t].read_lat = buckets_calloc((size_t)per_thread, sizeof(double));
+    }
+
+    u64 syscalls = 0;
+    double elapsed = io_run_phase(workers, cfg->threads, io_write_worker, &syscalls);
+    io_report(label, "write", workers, cfg->threads, true, elapsed, syscalls);
+
+    elapsed = io_run_phase(workers, cfg->threads, io_read_worker, &syscalls);
+    io_report(label, "read", workers, cfg->threads, false, elapsed, syscalls);
+
+    for (int t = 0; t < cfg->threads; t++) {
+        buckets_free(workers[t].write_lat);
+        buckets_free(workers[t].read_lat);
+    }
+    buckets_free(workers);
+    buckets_free(data);
+}
+
+static size_t parse_size(const char *s)
+{
+    char *end = NULL;
+    size_t value = (size_t)strtoull(s, &end, 10);
+    if (end && (*end == 'K' || *end == 'k')) {
+        value *= 1024;
+    } else if (end && (*end == 'M' || *end == 'm')) {
+        value *= 1024 * 1024;
+    } else if (end && (*end == 'G' || *end == 'g')) {
+        value *= 1024 * 1024 * 1024;
+    }
+    return value;
+}
+
+static int parse_sizes(io_bench_config_t *cfg, const char *spec)
+{
+    cfg->size_count = 0;
+    const char *p = spec;
+    while (*p && cfg->size_count < IO_MAX_SIZES) {
+        size_t size = parse_size(p);
+        if (size == 0) {
+            return -1;
+        }
+        cfg->sizes[cfg->size_count++] = size;
+        const char *end = strchr(p, ',');
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    return cfg->size_count > 0 ? 0 : -1;
+}
+
+static int run_io_modes(int argc, char **argv)
+{
+    io_bench_config_t cfg = {
+        .dir = IO_DEFAULT_DIR,
+        .sizes = { 4 * 1024, 64 * 1024, 1024 * 1024 },
+        .size_count = 3,
+        .threads = IO_DEFAULT_THREADS,
+        .ops = IO_DEFAULT_OPS,
+        .modes = NULL
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--io-modes") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            cfg.dir = argv[++i];
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            if (parse_sizes(&cfg, argv[++i]) != 0) {
+                fprintf(stderr, "Invalid --sizes: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cfg.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            cfg.ops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--modes") == 0 && i + 1 < argc) {
+            cfg.modes = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s --io-modes [--dir DIR] [--sizes 4K,64K,1M] "
+                    "[--threads N] [--ops N] [--modes io_uring,gc-none,gc-batched,"
+                    "gc-immediate,atomic]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.threads < 1 || cfg.threads > IO_MAX_THREADS || cfg.ops < cfg.threads) {
+        fprintf(stderr, "Need 1 <= threads <= %d and ops >= threads\n", IO_MAX_THREADS);
+        return 1;
+    }
+
+    if (buckets_ensure_directory(cfg.dir) != BUCKETS_OK) {
+        fprintf(stderr, "Failed to create %s\n", cfg.dir);
+        return 1;
+    }
+
+    buckets_storage_config_t storage_config = {
+        .data_dir = (char *)cfg.dir,
+        .inline_threshold = 128 * 1024,
+        .default_ec_k = 8,
+        .default_ec_m = 4,
+        .verify_checksums = true
+    };
+    if (buckets_storage_init(&storage_config) != 0) {
+        fprintf(stderr, "Failed to initialize storage\n");
+        return 1;
+    }
+    buckets_account_enable(true);
+
+    printf(COLOR_BOLD "\n━━━ Disk I/O Modes ━━━" COLOR_RESET "\n");
+    printf("  Dir: %s  Threads: %d  Ops: %d per size\n", cfg.dir, cfg.threads, cfg.ops);
+    printf("  sys/op counts every accounted syscall (open/write/fsync/rename)\n");
+
+    for (int s = 0; s < cfg.size_count; s++) {
+        printf("\n" COLOR_CYAN "→ Chunk size %zu KB" COLOR_RESET "\n", cfg.sizes[s] / 1024);
+        for (size_t m = 0; m < IO_MODE_COUNT; m++) {
+            if (io_mode_selected(&cfg, g_io_modes[m].name)) {
+                bench_io_mode(&cfg, &g_io_modes[m], cfg.sizes[s]);
+            }
+        }
+    }
+
+    buckets_account_enable(false);
+    buckets_chunk_set_write_mode(BUCKETS_CHUNK_WRITE_AUTO);
+    buckets_storage_cleanup();
+    return 0;
+}
+
+/* ========================================================================
+ * Benchmark 6: Shard File Fragmentation
+ *
+ * Many concurrent PUTs grow their shard files side by side. Each thread
+ * keeps several shard files open and writes them round-robin in small
+ * pieces, so the filesystem sees interleaved growth. The files are then
+ * mapped with FIEMAP (extents per file), evicted from the page cache and
+ * read back sequentially. Modes:
+ *   none       - plain writes, no preallocation (previous behaviour)
+ *   fallocate  - buckets_disk_prepare_file with the final size
+ *   keep-size  - the same with FALLOC_FL_KEEP_SIZE (streaming writers)
+ * ======================================================================== */
+
+#define FRAG_DEFAULT_DIR "/tmp/buckets-bench-frag"
+#define FRAG_MAX_FILES_PER_THREAD 64
+#define FRAG_READ_BUF (1024 * 1024)
+
+typedef enum {
+    FRAG_NONE = 0,
+    FRAG_FALLOCATE,
+    FRAG_KEEP_SIZE
+} frag_mode_t;
+
+static const char *g_frag_mode_names[] = { "none", "fallocate", "keep-size" };
+
+typedef struct {
+    const char *dir;
+    size_t file_size;
+    size_t piece;                       /* Bytes per write before switching file */
+    int threads;
+    int files;                          /* Per thread */
+} frag_config_t;
+
+typedef struct {
+    const frag_config_t *cfg;
+    frag_mode_t mode;
+    int thread_id;
+    const u8 *data;
+    int fail;
+} frag_worker_t;
+
+static void frag_file_path(const frag_config_t *cfg, frag_mode_t mode, int thread,
+                           int file, char *buf, size_t buf_size)
+{
+    snprintf(buf, buf_size, "%s/%s-t%d-f%d.part", cfg->dir,
+             g_frag_mode_names[mode], thread, file);
+}
+
+static void* frag_write_worker(void *arg)
+{
+    frag_worker_t *w = arg;
+    const frag_config_t *cfg = w->cfg;
+    int fds[FRAG_MAX_FILES_PER_THREAD];
+
+    for (int f = 0; f < cfg->files; f++) {
+        char path[PATH_MAX];
+        frag_file_path(cfg, w->mode, w->thread_id, f, path, sizeof(path));
+        fds[f] = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fds[f] < 0) {
+            w->fail++;
+            continue;
+        }
+        if (w->mode != FRAG_NONE) {
+            buckets_disk_prepare_file(fds[f], BUCKETS_FILE_LIFE_SHARD, cfg->file_size,
+                                      w->mode == FRAG_KEEP_SIZE);
+        }
+    }
+
+    /* Round-robin: every file grows by one piece per pass */
+    for (size_t off = 0; off < cfg->file_size; off += cfg->piece) {
+        size_t len = cfg->file_size - off < cfg->piece ? cfg->file_size - off : cfg->piece;
+        for (int f = 0; f < cfg->files; f++) {
+            if (fds[f] >= 0 && pwrite(fds[f], w->data + off, len, (off_t)off) != (ssize_t)len) {
+                w->fail++;
+            }
+        }
+    }
+
+    for (int f = 0; f < cfg->files; f++) {
+        if (fds[f] >= 0) {
+            if (fsync(fds[f]) != 0) {
+                w->fail++;
+            }
+            close(fds[f]);
+        }
+    }
+    return NULL;
+}
+
+/* Number of extents backing a file, or -1 if FIEMAP is unsupported */
+static long frag_count_extents(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct fiemap fm;
+    memset(&fm, 0, sizeof(fm));
+    fm.fm_length = FIEMAP_MAX_OFFSET;
+    fm.fm_flags = FIEMAP_FLAG_SYNC;
+    fm.fm_extent_count = 0;             /* Count only */
+    long extents = ioctl(fd, FS_IOC_FIEMAP, &fm) == 0 ? (long)fm.fm_mapped_extents : -1;
+
+    close(fd);
+    return extents;
+}
+
+/* Evict from the page cache and read back; returns bytes read */
+static size_t frag_read_file(const char *path, u8 *buf)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, FRAG_READ_BUF)) > 0) {
+        total += (size_t)n;
+    }
+    close(fd);
+    return total;
+}
+
+static void bench_frag_mode(const frag_config_t *cfg, frag_mode_t mode, const u8 *data)
+{
+    pthread_t tids[IO_MAX_THREADS];
+    frag_worker_t *workers = buckets_calloc((size_t)cfg->threads, sizeof(frag_worker_t));
+
+    double start = get_time_us();
+    for (int t = 0; t < cfg->threads; t++) {
+        workers[t].cfg = cfg;
+        workers[t].mode = mode;
+        workers[t].thread_id = t;
+        workers[t].data = data;
+        pthread_create(&tids[t], NULL, frag_write_worker, &workers[t]);
+    }
+    int fail = 0;
+    for (int t = 0; t < cfg->threads; t++) {
+        pthread_join(tids[t], NULL);
+        fail += workers[t].fail;
+    }
+    double write_us = get_time_us() - start;
+
+    /* Extents per file */
+    int nfiles = cfg->threads * cfg->files;
+    long extents_total = 0;
+    long extents_max = 0;
+    bool fiemap = true;
+    for (int t = 0; t < cfg->threads && fiemap; t++) {
+        for (int f = 0; f < cfg->files; f++) {
+            char path[PATH_MAX];
+            frag_file_path(cfg, mode, t, f, path, sizeof(path));
+            long n = frag_count_extents(path);
+            if (n < 0) {
+                fiemap = false;
+                break;
+            }
+            extents_total += n;
+            extents_max = n > extents_max ? n : extents_max;
+        }
+    }
+
+    /* Cold sequential read of every file */
+    u8 *buf = buckets_malloc(FRAG_READ_BUF);
+    size_t read_bytes = 0;
+    start = get_time_us();
+    for (int t = 0; t < cfg->threads; t++) {
+        for (int f = 0; f < cfg->files; f++) {
+            char path[PATH_MAX];
+            frag_file_path(cfg, mode, t, f, path, sizeof(path));
+            read_bytes += frag_read_file(path, buf);
+        }
+    }
+    double read_us = get_time_us() - start;
+    buckets_free(buf);
+
+    double written = (double)cfg->file_size * nfiles;
+    printf("  %-10s write %8.1f MB/s  read %8.1f MB/s  ", g_frag_mode_names[mode],
+           write_us > 0 ? written / write_us : 0,
+           read_us > 0 ? (double)read_bytes / read_us : 0);
+    if (fiemap) {
+        printf("extents/file avg %6.1f  max %4ld", (double)extents_total / nfiles, extents_max);
+    } else {
+        printf("extents/file n/a (no FIEMAP)");
+    }
+    printf("%s\n", fail || read_bytes != (size_t)written ? "  (failures)" : "");
+
+    for (int t = 0; t < cfg->threads; t++) {
+        for (int f = 0; f < cfg->files; f++) {
+            char path[PATH_MAX];
+            frag_file_path(cfg, mode, t, f, path, sizeof(path));
+            unlink(path);
+        }
+    }
+    buckets_free(workers);
+}
+
+static int run_frag(int argc, char **argv)
+{
+    frag_config_t cfg = {
+        .dir = FRAG_DEFAULT_DIR,
+        .file_size = 8 * 1024 * 1024,
+        .piece = 64 * 1024,
+        .threads = 8,
+        .files = 8
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frag") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            cfg.dir = argv[++i];
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            cfg.file_size = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--piece") == 0 && i + 1 < argc) {
+            cfg.piece = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cfg.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--files") == 0 && i + 1 < argc) {
+            cfg.files = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s --frag [--dir DIR] [--size 8M] [--piece 64K] "
+                    "[--threads N] [--files N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.threads < 1 || cfg.threads > IO_MAX_THREADS ||
+        cfg.files < 1 || cfg.files > FRAG_MAX_FILES_PER_THREAD ||
+        cfg.file_size == 0 || cfg.piece == 0) {
+        fprintf(stderr, "Need 1 <= threads <= %d, 1 <= files <= %d, non-zero sizes\n",
+                IO_MAX_THREADS, FRAG_MAX_FILES_PER_THREAD);
+        return 1;
+    }
+
+    if (buckets_ensure_directory(cfg.dir) != BUCKETS_OK) {
+        fprintf(stderr, "Failed to create %s\n", cfg.dir);
+        return 1;
+    }
+
+    u8 *data = generate_random_data(cfg.file_size);
+    if (!data) {
+        return 1;
+    }
+
+    printf(COLOR_BOLD "\n━━━ Shard File Fragmentation ━━━" COLOR_RESET "\n");
+    printf("  Dir: %s  Threads: %d  Files/thread: %d  File: %zu KB  Piece: %zu KB\n",
+           cfg.dir, cfg.threads, cfg.files, cfg.file_size / 1024, cfg.piece / 1024);
+    printf("  Reads are cold only where POSIX_FADV_DONTNEED can evict the pages\n\n");
+
+    for (int m = FRAG_NONE; m <= FRAG_KEEP_SIZE; m++) {
+        bench_frag_mode(&cfg, (frag_mode_t)m, data);
+    }
+
+    buckets_free(data);
+    return 0;
+}
+
+/* ========================================================================
+ * Peer Transport Encryption
+ *
+ * One sender streams --size bytes to a receiver thread over loopback, the
+ * way a node ships shards to a peer. CPU is process user+sys time, so it
+ * covers both ends of the connection.
+ *
+ *   plain  - the existing plaintext transport
+ *   tls    - buckets_peer_tls_connect + buckets_peer_send; the kernel
+ *            encrypts when kTLS is available, OpenSSL otherwise
+ * ======================================================================== */
+
+typedef struct {
+    const char *cert;
+    const char *key;
+    const char *ca;
+    size_t size;
+    size_t piece;
+} peer_tls_config_t;
+
+typedef struct {
+    int listen_fd;
+    SSL_CTX *ctx;                       /* NULL for plaintext */
+    size_t received;
+    bool ktls_rx;
+} peer_tls_receiver_t;
+
+static void* peer_tls_receive(void *arg)
+{
+    peer_tls_receiver_t *r = arg;
+    int fd = accept(r->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    u8 *buf = buckets_malloc(1024 * 1024);
+    if (r->ctx) {
+        SSL *ssl = SSL_new(r->ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) == 1) {
+#ifdef SSL_OP_ENABLE_KTLS
+            r->ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(ssl)) > 0;
+#endif
+            size_t n = 0;
+            while (SSL_read_ex(ssl, buf, 1024 * 1024, &n) == 1) {
+                r->received += n;
+            }
+        }
+        SSL_free(ssl);
+    } else {
+        ssize_t n;
+        while ((n = recv(fd, buf, 1024 * 1024, 0)) > 0) {
+            r->received += (size_t)n;
+        }
+    }
+    buckets_free(buf);
+    close(fd);
+    return NULL;
+}
+
+static SSL_CTX* peer_tls_server_ctx(const peer_tls_config_t *cfg)
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        return NULL;
+    }
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+    if (SSL_CTX_use_certificate_chain_file(ctx, cfg->cert) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, cfg->key, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_load_verify_locations(ctx, cfg->ca, NULL) != 1) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+    return ctx;
+}
+
+static double peer_tls_cpu_seconds(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static int bench_peer_tls_mode(const peer_tls_config_t *cfg, bool tls, const u8 *data)
+{
+    peer_tls_receiver_t r = { .listen_fd = socket(AF_INET, SOCK_STREAM, 0) };
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (r.listen_fd < 0 ||
+        bind(r.listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(r.listen_fd, 1) != 0 ||
+        getsockname(r.listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        fprintf(stderr, "Failed to listen on loopback\n");
+        return 1;
+    }
+    if (tls && !(r.ctx = peer_tls_server_ctx(cfg))) {
+        fprintf(stderr, "Failed to load %s / %s\n", cfg->cert, cfg->key);
+        close(r.listen_fd);
+        return 1;
+    }
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, peer_tls_receive, &r);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int ret = 0;
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        (tls && buckets_peer_tls_connect(fd, "127.0.0.1", ntohs(addr.sin_port)) != BUCKETS_OK)) {
+        fprintf(stderr, "Failed to connect (%s)\n", tls ? "tls" : "plain");
+        ret = 1;
+    }
+
+    double cpu_start = peer_tls_cpu_seconds();
+    double start = get_time_us();
+    size_t sent = 0;
+    while (ret == 0 && sent < cfg->size) {
+        size_t len = cfg->size - sent < cfg->piece ? cfg->size - sent : cfg->piece;
+        ssize_t n = buckets_peer_send(fd, data, len);
+        if (n <= 0) {
+            ret = 1;
+            break;
+        }
+        sent += (size_t)n;
+    }
+    if (fd >= 0) {
+        buckets_peer_tls_close(fd);
+        shutdown(fd, SHUT_WR);
+    }
+    pthread_join(tid, NULL);
+    double elapsed_us = get_time_us() - start;
+    double cpu = peer_tls_cpu_seconds() - cpu_start;
+    if (fd >= 0) {
+        close(fd);
+    }
+    close(r.listen_fd);
+
+    buckets_peer_tls_stats_t stats;
+    buckets_peer_tls_get_stats(&stats);
+    double gb = (double)r.received / (1024.0 * 1024.0 * 1024.0);
+    printf("  %-6s %8.1f MB/s  %6.3f CPU s/GB  %s%s\n", tls ? "tls" : "plain",
+           elapsed_us > 0 ? (double)r.received / elapsed_us : 0,
+           gb > 0 ? cpu / gb : 0,
+           !tls ? "" : stats.ktls > 0 && r.ktls_rx ? "(kTLS both ends)" :
+           stats.ktls > 0 ? "(kTLS sender only)" : "(userspace AES-GCM)",
+           ret || r.received != cfg->size ? "  (failures)" : "");
+
+    SSL_CTX_free(r.ctx);
+    return ret;
+}
+
+static int run_peer_tls(int argc, char **argv)
+{
+    peer_tls_config_t cfg = {
+        .cert = "tests/net/certs/cert.pem",
+        .key = "tests/net/certs/key.pem",
+        .ca = "tests/net/certs/cert.pem",
+        .size = (size_t)1024 * 1024 * 1024,
+        .piece = 1024 * 1024
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--peer-tls") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            cfg.size = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--piece") == 0 && i + 1 < argc) {
+            cfg.piece = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--cert") == 0 && i + 1 < argc) {
+            cfg.cert = argv[++i];
+        } else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+            cfg.key = argv[++i];
+        } else if (strcmp(argv[i], "--ca") == 0 && i + 1 < argc) {
+            cfg.ca = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s --peer-tls [--size 1G] [--piece 1M] [--cert PEM] "
+                    "[--key PEM] [--ca PEM]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg.size == 0 || cfg.piece == 0) {
+        fprintf(stderr, "Need non-zero sizes\n");
+        return 1;
+    }
+    if (buckets_peer_tls_init(cfg.cert, cfg.key, cfg.ca) != BUCKETS_OK) {
+        fprintf(stderr, "Failed to set up peer TLS\n");
+        return 1;
+    }
+
+    u8 *data = generate_random_data(cfg.piece);
+    if (!data) {
+        return 1;
+    }
+
+    printf(COLOR_BOLD "\n━━━ Peer Transport Encryption ━━━" COLOR_RESET "\n");
+    printf("  Transfer: %zu MB over loopback in %zu KB sends\n",
+           cfg.size / (1024 * 1024), cfg.piece / 1024);
+    printf("  CPU is user+sys for sender and receiver together\n\n");
+
+    int ret = bench_peer_tls_mode(&cfg, false, data);
+    ret |= bench_peer_tls_mode(&cfg, true, data);
+
+    buckets_peer_tls_cleanup();
+    buckets_free(data);
+    return ret;
+}
+
 /* ========================================================================
  * Main Benchmark Suite
  * ======================================================================== */
 
 int main(int argc, char **argv)
 {
-    (void)argc;
-    (void)argv;
-    
     /* Disable debug logging for clean benchmark output */
     setenv("BUCKETS_LOG_LEVEL", "ERROR", 1);
     
+    if (argc > 1 && strcmp(argv[1], "--io-modes") == 0) {
+        if (buckets_init() != 0) {
+            fprintf(stderr, "Failed to initialize buckets\n");
+            return 1;
+        }
+        int ret = run_io_modes(argc, argv);
+        buckets_cleanup();
+        return ret;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--frag") == 0) {
+        if (buckets_init() != 0) {
+            fprintf(stderr, "Failed to initialize buckets\n");
+            return 1;
+        }
+        int ret = run_frag(argc, argv);
+        buckets_cleanup();
+        return ret;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--peer-tls") == 0) {
+        if (buckets_init() != 0) {
+            fprintf(stderr, "Failed to initialize buckets\n");
+            return 1;
+        }
+        int ret = run_peer_tls(argc, argv);
+        buckets_cleanup();
+        return ret;
+    }
+    
     printf(COLOR_BOLD "\n");
     printf("═══════════════════════════════════════════════════════════════\n");
     printf("  Buckets Storage Layer Performance Benchmarks\n");
@@ -468,7 +1366,7 @@ int main(int argc, char **argv)
     }
     
     /* Initialize buckets */
-    if (!buckets_init()) {
+    if (buckets_init() != 0) {
         fprintf(stderr, "Failed to initialize buckets\n");
         return 1;
     }
@@ -0,0 +1,812 @@
+/**
+ * Multi-Node Cluster Harness Implementation
+ *
+ * Child-process nodes on loopback with generated configs, temp-dir disks
+ * and per-node delay proxies. See cluster_harness.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "buckets.h"
+#include "cJSON.h"
+#include "cluster_harness.h"
+
+#define HARNESS_PROXY_BUF_SIZE (64 * 1024)
+#define HARNESS_POLL_MS 200
+
+/* ===================================================================
+ * Internal Structures
+ * ===================================================================*/
+
+typedef struct {
+    int listen_fd;                  /* Proxy listen socket (-1 if disabled) */
+    pthread_t thread;               /* Accept thread */
+    atomic_bool running;            /* Accept/pipe threads keep going */
+    atomic_uint delay_ms;           /* Per-segment forwarding delay */
+    atomic_int active_pipes;        /* Live connection pipes */
+    int upstream_port;              /* Real node port */
+} harness_proxy_t;
+
+typedef struct {
+    int index;
+    pid_t pid;                      /* Server process (0 if not running) */
+    int port;                       /* Real listen port */
+    char endpoint[64];              /* Advertised endpoint */
+    char node_id[32];
+    char dir[PATH_MAX];
+    char config_path[PATH_MAX];
+    char log_path[PATH_MAX];
+    char disks[BUCKETS_HARNESS_MAX_DISKS][PATH_MAX];
+    u32 slow_ms[BUCKETS_HARNESS_MAX_DISKS];
+    bool failed[BUCKETS_HARNESS_MAX_DISKS];
+    harness_proxy_t proxy;
+} harness_node_t;
+
+struct buckets_harness {
+    buckets_harness_config_t config;
+    char root[PATH_MAX];
+    char binary[PATH_MAX];
+    harness_node_t nodes[BUCKETS_HARNESS_MAX_NODES];
+};
+
+typedef struct {
+    harness_proxy_t *proxy;
+    int client_fd;
+    int upstream_fd;
+} harness_pipe_t;
+
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static void sleep_ms(u32 ms)
+{
+    struct timespec ts = {
+        .tv_sec = ms / 1000,
+        .tv_nsec = (long)(ms % 1000) * 1000000L
+    };
+    nanosleep(&ts, NULL);
+}
+
+static u64 now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+static int connect_loopback(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u16)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+static int mkdir_p(const char *path)
+{
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ===================================================================
+ * Delay Proxy
+ * ===================================================================*/
+
+static void* proxy_pipe_thread(void *arg)
+{
+    harness_pipe_t *pipe_ctx = arg;
+    harness_proxy_t *proxy = pipe_ctx->proxy;
+    char *buf = buckets_malloc(HARNESS_PROXY_BUF_SIZE);
+
+    struct pollfd fds[2] = {
+        { .fd = pipe_ctx->client_fd, .events = POLLIN },
+        { .fd = pipe_ctx->upstream_fd, .events = POLLIN }
+    };
+
+    while (atomic_load(&proxy->running)) {
+        int ready = poll(fds, 2, HARNESS_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        bool closed = false;
+        for (int i = 0; i < 2 && !closed; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+
+            ssize_t n = read(fds[i].fd, buf, HARNESS_PROXY_BUF_SIZE);
+            if (n <= 0) {
+                closed = true;
+                break;
+            }
+
+            u32 delay = atomic_load(&proxy->delay_ms);
+            if (delay > 0) {
+                sleep_ms(delay);
+            }
+
+            if (write_all(fds[1 - i].fd, buf, (size_t)n) != 0) {
+                closed = true;
+            }
+        }
+        if (closed) {
+            break;
+        }
+    }
+
+    close(pipe_ctx->client_fd);
+    close(pipe_ctx->upstream_fd);
+    buckets_free(buf);
+    buckets_free(pipe_ctx);
+    atomic_fetch_sub(&proxy->active_pipes, 1);
+    return NULL;
+}
+
+static void* proxy_accept_thread(void *arg)
+{
+    harness_proxy_t *proxy = arg;
+    struct pollfd pfd = { .fd = proxy->listen_fd, .events = POLLIN };
+
+    while (atomic_load(&proxy->running)) {
+        int ready = poll(&pfd, 1, HARNESS_POLL_MS);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int client_fd = accept(proxy->listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            continue;
+        }
+
+        /* Upstream down (dead peer): drop the connection like a real reset */
+        int upstream_fd = connect_loopback(proxy->upstream_port);
+        if (upstream_fd < 0) {
+            close(client_fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        harness_pipe_t *pipe_ctx = buckets_malloc(sizeof(*pipe_ctx));
+        pipe_ctx->proxy = proxy;
+        pipe_ctx->client_fd = client_fd;
+        pipe_ctx->upstream_fd = upstream_fd;
+
+        atomic_fetch_add(&proxy->active_pipes, 1);
+
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, proxy_pipe_thread, pipe_ctx) != 0) {
+            close(client_fd);
+            close(upstream_fd);
+            buckets_free(pipe_ctx);
+            atomic_fetch_sub(&proxy->active_pipes, 1);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    return NULL;
+}
+
+static int proxy_start(harness_proxy_t *proxy, int listen_port, int upstream_port)
+{
+    proxy->upstream_port = upstream_port;
+    atomic_store(&proxy->delay_ms, 0);
+    atomic_store(&proxy->active_pipes, 0);
+
+    proxy->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (proxy->listen_fd < 0) {
+        return BUCKETS_ERR_NETWORK;
+    }
+
+    int one = 1;
+    setsockopt(proxy->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((u16)listen_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(proxy->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(proxy->listen_fd, 512) != 0) {
+        buckets_error("Harness proxy: cannot listen on %d: %s", listen_port, strerror(errno));
+        close(proxy->listen_fd);
+        proxy->listen_fd = -1;
+        return BUCKETS_ERR_NETWORK;
+    }
+
+    atomic_store(&proxy->running, true);
+    if (pthread_create(&proxy->thread, NULL, proxy_accept_thread, proxy) != 0) {
+        atomic_store(&proxy->running, false);
+        close(proxy->listen_fd);
+        proxy->listen_fd = -1;
+        return BUCKETS_ERR_INIT;
+    }
+
+    return BUCKETS_OK;
+}
+
+static void proxy_stop(harness_proxy_t *proxy)
+{
+    if (proxy->listen_fd < 0) {
+        return;
+    }
+
+    atomic_store(&proxy->running, false);
+    pthread_join(proxy->thread, NULL);
+    close(proxy->listen_fd);
+    proxy->listen_fd = -1;
+
+    /* Pipe threads notice !running within one poll interval */
+    while (atomic_load(&proxy->active_pipes) > 0) {
+        sleep_ms(10);
+    }
+}
+
+/* ===================================================================
+ * Config Generation
+ * ===================================================================*/
+
+static cJSON* disk_array(harness_node_t *node, int disk_count)
+{
+    cJSON *disks = cJSON_CreateArray();
+    for (int d = 0; d < disk_count; d++) {
+        cJSON_AddItemToArray(disks, cJSON_CreateString(node->disks[d]));
+    }
+    return disks;
+}
+
+static int write_node_config(buckets_harness_t *h, harness_node_t *node)
+{
+    const buckets_harness_config_t *cfg = &h->config;
+    int total_disks = cfg->nodes * cfg->disks_per_node;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "deployment_id", "harness-cluster");
+
+    cJSON *n = cJSON_AddObjectToObject(root, "node");
+    cJSON_AddStringToObject(n, "id", node->node_id);
+    cJSON_AddStringToObject(n, "address", "127.0.0.1");
+    cJSON_AddNumberToObject(n, "port", node->port);
+    cJSON_AddStringToObject(n, "endpoint", node->endpoint);
+    cJSON_AddStringToObject(n, "data_dir", node->dir);
+
+    cJSON *storage = cJSON_AddObjectToObject(root, "storage");
+    cJSON_AddItemToObject(storage, "disks", disk_array(node, cfg->disks_per_node));
+
+    cJSON *cluster = cJSON_AddObjectToObject(root, "cluster");
+    cJSON_AddBoolToObject(cluster, "enabled", true);
+    cJSON_AddStringToObject(cluster, "deployment_id", "harness-cluster");
+    cJSON *nodes = cJSON_AddArrayToObject(cluster, "nodes");
+    for (int i = 0; i < cfg->nodes; i++) {
+        cJSON *peer = cJSON_CreateObject();
+        cJSON_AddStringToObject(peer, "id", h->nodes[i].node_id);
+        cJSON_AddStringToObject(peer, "endpoint", h->nodes[i].endpoint);
+        cJSON_AddItemToObject(peer, "disks", disk_array(&h->nodes[i], cfg->disks_per_node));
+        cJSON_AddItemToArray(nodes, peer);
+    }
+    cJSON_AddNumberToObject(cluster, "sets", cfg->sets);
+    cJSON_AddNumberToObject(cluster, "disks_per_set", total_disks / cfg->sets);
+
+    cJSON *erasure = cJSON_AddObjectToObject(root, "erasure");
+    cJSON_AddBoolToObject(erasure, "enabled", true);
+    cJSON_AddNumberToObject(erasure, "data_shards", cfg->data_shards);
+    cJSON_AddNumberToObject(erasure, "parity_shards", cfg->parity_shards);
+
+    cJSON *server = cJSON_AddObjectToObject(root, "server");
+    cJSON_AddStringToObject(server, "bind_address", "127.0.0.1");
+    cJSON_AddNumberToObject(server, "bind_port", node->port);
+
+    char *json = cJSON_Print(root);
+    cJSON_Delete(root);
+    if (!json) {
+        return BUCKETS_ERR_NOMEM;
+    }
+
+    FILE *fp = fopen(node->config_path, "w");
+    if (!fp) {
+        buckets_error("Harness: cannot write %s: %s", node->config_path, strerror(errno));
+        buckets_free(json);
+        return BUCKETS_ERR_IO;
+    }
+    fputs(json, fp);
+    fclose(fp);
+    buckets_free(json);
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * Process Control
+ * ===================================================================*/
+
+/* Build the BUCKETS_FAULT_* values for a node's current disk faults */
+static void build_fault_env(buckets_harness_t *h, harness_node_t *node,
+                            char *slow, size_t slow_len, char *fail, size_t fail_len)
+{
+    slow[0] = '\0';
+    fail[0] = '\0';
+
+    for (int d = 0; d < h->config.disks_per_node; d++) {
+        if (node->slow_ms[d] > 0) {
+            size_t used = strlen(slow);
+            snprintf(slow + used, slow_len - used, "%s%s:%u",
+                     used ? "," : "", node->disks[d], node->slow_ms[d]);
+        }
+        if (node->failed[d]) {
+            size_t used = strlen(fail);
+            snprintf(fail + used, fail_len - used, "%s%s",
+                     used ? "," : "", node->disks[d]);
+        }
+    }
+}
+
+static pid_t spawn_binary(buckets_harness_t *h, harness_node_t *node, const char *command)
+{
+    char slow[4096];
+    char fail[4096];
+    build_fault_env(h, node, slow, sizeof(slow), fail, sizeof(fail));
+
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    /* Child */
+    int log_fd = open(node->log_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log_fd >= 0) {
+        dup2(log_fd, STDOUT_FILENO);
+        dup2(log_fd, STDERR_FILENO);
+        close(log_fd);
+    }
+
+    if (slow[0]) {
+        setenv("BUCKETS_FAULT_SLOW_DISK", slow, 1);
+    } else {
+        unsetenv("BUCKETS_FAULT_SLOW_DISK");
+    }
+    if (fail[0]) {
+        setenv("BUCKETS_FAULT_FAIL_DISK", fail, 1);
+    } else {
+        unsetenv("BUCKETS_FAULT_FAIL_DISK");
+    }
+
+    execl(h->binary, h->binary, command, "--config", node->config_path, (char *)NULL);
+    _exit(127);
+}
+
+static int format_node(buckets_harness_t *h, harness_node_t *node)
+{
+    pid_t pid = spawn_binary(h, node, "format");
+    if (pid < 0) {
+        return BUCKETS_ERR_INIT;
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        buckets_error("Harness: format failed for %s (see %s)", node->node_id, node->log_path);
+        return BUCKETS_ERR_INIT;
+    }
+    return BUCKETS_OK;
+}
+
+static int start_node(buckets_harness_t *h, harness_node_t *node)
+{
+    node->pid = spawn_binary(h, node, "server");
+    if (node->pid < 0) {
+        node->pid = 0;
+        return BUCKETS_ERR_INIT;
+    }
+    return BUCKETS_OK;
+}
+
+static void reap_node(harness_node_t *node)
+{
+    if (node->pid > 0) {
+        waitpid(node->pid, NULL, 0);
+        node->pid = 0;
+    }
+}
+
+static harness_node_t* get_node(buckets_harness_t *h, int node)
+{
+    if (!h || node < 0 || node >= h->config.nodes) {
+        return NULL;
+    }
+    return &h->nodes[node];
+}
+
+/* ===================================================================
+ * Lifecycle
+ * ===================================================================*/
+
+buckets_harness_config_t buckets_harness_default_config(void)
+{
+    buckets_harness_config_t config = {
+        .nodes = 4,
+        .disks_per_node = 4,
+        .sets = 1,
+        .data_shards = 2,
+        .parity_shards = 2,
+        .base_port = 19001,
+        .proxy_port_offset = 100,
+        .link_proxy = true,
+        .keep_data = false,
+        .ready_timeout_ms = 15000,
+        .server_binary = "bin/buckets",
+        .root_dir = NULL
+    };
+    return config;
+}
+
+static int validate_config(const buckets_harness_config_t *cfg)
+{
+    if (cfg->nodes <= 0 || cfg->nodes > BUCKETS_HARNESS_MAX_NODES ||
+        cfg->disks_per_node <= 0 || cfg->disks_per_node > BUCKETS_HARNESS_MAX_DISKS ||
+        cfg->sets <= 0) {
+        buckets_error("Harness: invalid node/disk/set counts");
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    int total_disks = cfg->nodes * cfg->disks_per_node;
+    if (total_disks % cfg->sets != 0) {
+        buckets_error("Harness: %d disks do not divide into %d sets", total_disks, cfg->sets);
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    if (cfg->data_shards + cfg->parity_shards != total_disks / cfg->sets) {
+        buckets_error("Harness: K+M (%d+%d) must equal disks per set (%d)",
+                      cfg->data_shards, cfg->parity_shards, total_disks / cfg->sets);
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    return BUCKETS_OK;
+}
+
+buckets_harness_t* buckets_harness_start(const buckets_harness_config_t *config)
+{
+    buckets_harness_config_t defaults = buckets_harness_default_config();
+    if (!config) {
+        config = &defaults;
+    }
+    if (validate_config(config) != BUCKETS_OK) {
+        return NULL;
+    }
+
+    buckets_harness_t *h = buckets_calloc(1, sizeof(*h));
+    h->config = *config;
+
+    if (!realpath(config->server_binary, h->binary)) {
+        buckets_error("Harness: server binary %s not found", config->server_binary);
+        buckets_free(h);
+        return NULL;
+    }
+
+    if (config->root_dir) {
+        snprintf(h->root, sizeof(h->root), "%s", config->root_dir);
+        if (mkdir_p(h->root) != 0) {
+            buckets_error("Harness: cannot create %s: %s", h->root, strerror(errno));
+            buckets_free(h);
+            return NULL;
+        }
+    } else {
+        snprintf(h->root, sizeof(h->root), "/tmp/buckets-harness-XXXXXX");
+        if (!mkdtemp(h->root)) {
+            buckets_error("Harness: mkdtemp failed: %s", strerror(errno));
+            buckets_free(h);
+            return NULL;
+        }
+    }
+    h->config.root_dir = h->root;
+
+    /* No proxies yet: stop on any early failure must not touch them */
+    for (int i = 0; i < config->nodes; i++) {
+        h->nodes[i].proxy.listen_fd = -1;
+    }
+
+    /* Lay out nodes first: every config lists every peer */
+    for (int i = 0; i < config->nodes; i++) {
+        harness_node_t *node = &h->nodes[i];
+        node->index = i;
+        node->port = config->base_port + i;
+        snprintf(node->node_id, sizeof(node->node_id), "node%d", i + 1);
+        snprintf(node->dir, sizeof(node->dir), "%s/%s", h->root, node->node_id);
+        snprintf(node->config_path, sizeof(node->config_path), "%s/config.json", node->dir);
+        snprintf(node->log_path, sizeof(node->log_path), "%s/server.log", node->dir);
+
+        int advertised = config->link_proxy ?
+                         config->base_port + config->proxy_port_offset + i : node->port;
+        snprintf(node->endpoint, sizeof(node->endpoint), "http://127.0.0.1:%d", advertised);
+
+        for (int d = 0; d < config->disks_per_node; d++) {
+            snprintf(node->disks[d], sizeof(node->disks[d]), "%s/disk%d", node->dir, d + 1);
+            if (mkdir_p(node->disks[d]) != 0) {
+                buckets_error("Harness: cannot create %s: %s", node->disks[d], strerror(errno));
+                buckets_harness_stop(h);
+                return NULL;
+            }
+        }
+    }
+
+    for (int i = 0; i < config->nodes; i++) {
+        harness_node_t *node = &h->nodes[i];
+        if (write_node_config(h, node) != BUCKETS_OK ||
+            format_node(h, node) != BUCKETS_OK) {
+            buckets_harness_stop(h);
+            return NULL;
+        }
+        if (config->link_proxy &&
+            proxy_start(&node->proxy, config->base_port + config->proxy_port_offset + i,
+                        node->port) != BUCKETS_OK) {
+            buckets_harness_stop(h);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < config->nodes; i++) {
+        if (start_node(h, &h->nodes[i]) != BUCKETS_OK) {
+            buckets_harness_stop(h);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < config->nodes; i++) {
+        if (buckets_harness_wait_ready(h, i, config->ready_timeout_ms) != BUCKETS_OK) {
+            buckets_error("Harness: %s not ready after %d ms (see %s)",
+                          h->nodes[i].node_id, config->ready_timeout_ms, h->nodes[i].log_path);
+            buckets_harness_stop(h);
+            return NULL;
+        }
+    }
+
+    buckets_info("Harness: %d nodes ready under %s (%d sets, K=%d M=%d%s)",
+                 config->nodes, h->root, config->sets, config->data_shards,
+                 config->parity_shards, config->link_proxy ? ", proxied" : "");
+    return h;
+}
+
+void buckets_harness_stop(buckets_harness_t *h)
+{
+    if (!h) {
+        return;
+    }
+
+    for (int i = 0; i < h->config.nodes; i++) {
+        harness_node_t *node = &h->nodes[i];
+        if (node->pid > 0) {
+            kill(node->pid, SIGCONT);
+            kill(node->pid, SIGKILL);
+            reap_node(node);
+        }
+    }
+
+    for (int i = 0; i < h->config.nodes; i++) {
+        proxy_stop(&h->nodes[i].proxy);
+    }
+
+    if (!h->config.keep_data && h->root[0]) {
+        nftw(h->root, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+    }
+
+    buckets_free(h);
+}
+
+/* ===================================================================
+ * Node Access
+ * ===================================================================*/
+
+int buckets_harness_node_count(buckets_harness_t *h)
+{
+    return h ? h->config.nodes : 0;
+}
+
+const char* buckets_harness_node_endpoint(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    return n ? n->endpoint : NULL;
+}
+
+const char* buckets_harness_disk_path(buckets_harness_t *h, int node, int disk)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || disk < 0 || disk >= h->config.disks_per_node) {
+        return NULL;
+    }
+    return n->disks[disk];
+}
+
+const char* buckets_harness_log_path(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    return n ? n->log_path : NULL;
+}
+
+int buckets_harness_wait_ready(buckets_harness_t *h, int node, int timeout_ms)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    static const char request[] =
+        "GET /health HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    u64 deadline = now_ms() + (u64)timeout_ms;
+
+    while (now_ms() < deadline) {
+        /* Probe the real port so link delay doesn't skew readiness */
+        int fd = connect_loopback(n->port);
+        if (fd >= 0) {
+            char response[64] = {0};
+            if (write_all(fd, request, sizeof(request) - 1) == 0 &&
+                read(fd, response, sizeof(response) - 1) > 0 &&
+                strncmp(response, "HTTP/1.1 200", 12) == 0) {
+                close(fd);
+                return BUCKETS_OK;
+            }
+            close(fd);
+        }
+        sleep_ms(50);
+    }
+
+    return BUCKETS_ERR_TIMEOUT;
+}
+
+/* ===================================================================
+ * Fault Knobs
+ * ===================================================================*/
+
+int buckets_harness_kill_node(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || n->pid <= 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    kill(n->pid, SIGCONT);
+    kill(n->pid, SIGKILL);
+    reap_node(n);
+    return BUCKETS_OK;
+}
+
+int buckets_harness_pause_node(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || n->pid <= 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    return kill(n->pid, SIGSTOP) == 0 ? BUCKETS_OK : BUCKETS_ERR_INTERNAL;
+}
+
+int buckets_harness_resume_node(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || n->pid <= 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    return kill(n->pid, SIGCONT) == 0 ? BUCKETS_OK : BUCKETS_ERR_INTERNAL;
+}
+
+int buckets_harness_restart_node(buckets_harness_t *h, int node)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    if (n->pid > 0) {
+        buckets_harness_kill_node(h, node);
+    }
+
+    int ret = start_node(h, n);
+    if (ret != BUCKETS_OK) {
+        return ret;
+    }
+    return buckets_harness_wait_ready(h, node, h->config.ready_timeout_ms);
+}
+
+int buckets_harness_set_slow_disk(buckets_harness_t *h, int node, int disk, u32 delay_ms)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || disk < 0 || disk >= h->config.disks_per_node) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    n->slow_ms[disk] = delay_ms;
+    return BUCKETS_OK;
+}
+
+int buckets_harness_set_failed_disk(buckets_harness_t *h, int node, int disk, bool failed)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || disk < 0 || disk >= h->config.disks_per_node) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    n->failed[disk] = failed;
+    return BUCKETS_OK;
+}
+
+int buckets_harness_set_link_delay(buckets_harness_t *h, int node, u32 delay_ms)
+{
+    harness_node_t *n = get_node(h, node);
+    if (!n || n->proxy.listen_fd < 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    atomic_store(&n->proxy.delay_ms, delay_ms);
+    return BUCKETS_OK;
+}
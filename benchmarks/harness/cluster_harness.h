@@ -0,0 +1,165 @@
+/**
+ * Multi-Node Cluster Harness
+ *
+ * Starts N Buckets nodes as child processes on loopback for reproducible
+ * multi-node performance tests. Each node gets temp-dir disks and a
+ * generated config; all nodes share one topology (sets, K+M).
+ *
+ * Fault knobs:
+ * - Slow or failed disk: passed to the node via BUCKETS_FAULT_SLOW_DISK /
+ *   BUCKETS_FAULT_FAIL_DISK (see buckets_fault.h), applied on (re)start
+ * - Dead or hung peer: SIGKILL / SIGSTOP the node process
+ * - Packet delay: with link_proxy enabled every node advertises a local
+ *   TCP proxy as its endpoint, so all peer and client traffic to that node
+ *   crosses a proxy whose per-direction delay can be changed at runtime
+ *
+ * Usage:
+ *   buckets_harness_config_t cfg = buckets_harness_default_config();
+ *   cfg.nodes = 6;
+ *   buckets_harness_t *h = buckets_harness_start(&cfg);
+ *   buckets_harness_set_link_delay(h, 2, 20);
+ *   ... drive requests at buckets_harness_node_endpoint(h, i) ...
+ *   buckets_harness_stop(h);
+ */
+
+#ifndef BUCKETS_CLUSTER_HARNESS_H
+#define BUCKETS_CLUSTER_HARNESS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUCKETS_HARNESS_MAX_NODES 32
+#define BUCKETS_HARNESS_MAX_DISKS 16
+
+/**
+ * Harness configuration
+ */
+typedef struct {
+    int nodes;                  /* Number of nodes (default: 4) */
+    int disks_per_node;         /* Temp-dir disks per node (default: 4) */
+    int sets;                   /* Erasure sets (default: 1) */
+    int data_shards;            /* K (default: 2) */
+    int parity_shards;          /* M (default: 2) */
+    int base_port;              /* Node i listens on base_port + i (default: 19001) */
+    int proxy_port_offset;      /* Proxy i listens on base_port + offset + i (default: 100) */
+    bool link_proxy;            /* Route traffic through delay proxies (default: true) */
+    bool keep_data;             /* Keep temp dirs on stop (default: false) */
+    int ready_timeout_ms;       /* Max wait for /health per node (default: 15000) */
+    const char *server_binary;  /* Server binary (default: "bin/buckets") */
+    const char *root_dir;       /* Data root (NULL = mkdtemp under /tmp) */
+} buckets_harness_config_t;
+
+/**
+ * Opaque harness handle
+ */
+typedef struct buckets_harness buckets_harness_t;
+
+/* ===================================================================
+ * Lifecycle
+ * ===================================================================*/
+
+/**
+ * Get default harness configuration
+ */
+buckets_harness_config_t buckets_harness_default_config(void);
+
+/**
+ * Create disks and configs, format every node, and start the cluster
+ *
+ * Returns once every node answers /health or the ready timeout expires.
+ *
+ * @param config Harness configuration (NULL for defaults)
+ * @return Harness handle, or NULL on error (partially started nodes are stopped)
+ */
+buckets_harness_t* buckets_harness_start(const buckets_harness_config_t *config);
+
+/**
+ * Stop all nodes and proxies, and remove temp dirs unless keep_data is set
+ */
+void buckets_harness_stop(buckets_harness_t *h);
+
+/* ===================================================================
+ * Node Access
+ * ===================================================================*/
+
+/**
+ * Get number of nodes
+ */
+int buckets_harness_node_count(buckets_harness_t *h);
+
+/**
+ * Get the advertised endpoint of a node ("http://127.0.0.1:<port>")
+ *
+ * This is the proxy endpoint when link_proxy is enabled.
+ */
+const char* buckets_harness_node_endpoint(buckets_harness_t *h, int node);
+
+/**
+ * Get a node's disk path
+ */
+const char* buckets_harness_disk_path(buckets_harness_t *h, int node, int disk);
+
+/**
+ * Get a node's log file path
+ */
+const char* buckets_harness_log_path(buckets_harness_t *h, int node);
+
+/**
+ * Wait until a node answers /health with 200
+ *
+ * @return BUCKETS_OK, or BUCKETS_ERR_TIMEOUT
+ */
+int buckets_harness_wait_ready(buckets_harness_t *h, int node, int timeout_ms);
+
+/* ===================================================================
+ * Fault Knobs
+ * ===================================================================*/
+
+/**
+ * Kill a node (SIGKILL) - simulates a dead peer
+ */
+int buckets_harness_kill_node(buckets_harness_t *h, int node);
+
+/**
+ * Pause a node (SIGSTOP) - simulates a hung peer that still accepts TCP
+ */
+int buckets_harness_pause_node(buckets_harness_t *h, int node);
+
+/**
+ * Resume a paused node (SIGCONT)
+ */
+int buckets_harness_resume_node(buckets_harness_t *h, int node);
+
+/**
+ * Restart a node, applying the current disk fault settings
+ */
+int buckets_harness_restart_node(buckets_harness_t *h, int node);
+
+/**
+ * Delay every I/O on a disk by delay_ms (0 clears). Takes effect on restart.
+ */
+int buckets_harness_set_slow_disk(buckets_harness_t *h, int node, int disk, u32 delay_ms);
+
+/**
+ * Fail every I/O on a disk (false clears). Takes effect on restart.
+ */
+int buckets_harness_set_failed_disk(buckets_harness_t *h, int node, int disk, bool failed);
+
+/**
+ * Delay traffic to and from a node by delay_ms per forwarded segment
+ *
+ * Requires link_proxy. Takes effect immediately.
+ */
+int buckets_harness_set_link_delay(buckets_harness_t *h, int node, u32 delay_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_CLUSTER_HARNESS_H */
@@ -17,6 +17,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <pthread.h>
 
 /* Version information */
 #define BUCKETS_VERSION_MAJOR 0
@@ -86,6 +87,79 @@ void* buckets_calloc(size_t count, size_t size);
 void* buckets_realloc(void *ptr, size_t size);
 void  buckets_free(void *ptr);
 
+/* Allocation accounting (disabled by default, used by benchmarks) */
+typedef struct {
+    u64 allocs;             /* buckets_malloc/calloc/realloc calls */
+    u64 bytes;              /* Bytes requested */
+    u64 frees;              /* buckets_free calls (non-NULL) */
+} buckets_alloc_stats_t;
+
+void buckets_alloc_stats_enable(bool enabled);
+void buckets_alloc_stats_get(buckets_alloc_stats_t *stats);
+void buckets_alloc_stats_reset(void);
+
+/* Per-request syscall and allocation accounting
+ *
+ * When enabled (BUCKETS_ACCOUNTING=1 or buckets_account_enable), syscalls
+ * made through the instrumented I/O helpers (atomic_io, chunk, layout, the
+ * peer transports) and buckets_malloc/calloc/realloc calls are added to the
+ * account attached to the calling thread. Threads spawned on behalf of a
+ * request attach the parent's account so fan-out work is charged to it.
+ * Finished accounts are folded into process-wide totals. */
+typedef enum {
+    BUCKETS_SYS_OPEN = 0,
+    BUCKETS_SYS_CLOSE,
+    BUCKETS_SYS_READ,
+    BUCKETS_SYS_WRITE,
+    BUCKETS_SYS_FSYNC,
+    BUCKETS_SYS_RENAME,
+    BUCKETS_SYS_MKDIR,
+    BUCKETS_SYS_UNLINK,
+    BUCKETS_SYS_STAT,
+    BUCKETS_SYS_SOCKET,
+    BUCKETS_SYS_CONNECT,
+    BUCKETS_SYS_SEND,
+    BUCKETS_SYS_RECV,
+    BUCKETS_SYS_POLL,
+    BUCKETS_SYS_THREAD,     /* pthread_create (clone) */
+    BUCKETS_SYS_FALLOCATE,
+    BUCKETS_SYS_COUNT
+} buckets_syscall_kind_t;
+
+typedef struct {
+    u64 syscalls[BUCKETS_SYS_COUNT];    /* Per-kind syscall counts */
+    u64 allocs;                         /* buckets_malloc/calloc/realloc calls */
+    u64 alloc_bytes;                    /* Bytes requested */
+} buckets_account_t;
+
+void buckets_account_enable(bool enabled);
+bool buckets_account_enabled(void);
+void buckets_account_begin(buckets_account_t *acct);            /* Zero and attach */
+void buckets_account_end(buckets_account_t *acct);              /* Detach and fold into totals */
+buckets_account_t* buckets_account_attach(buckets_account_t *acct); /* Returns previous */
+buckets_account_t* buckets_account_current(void);
+void buckets_account_record(buckets_syscall_kind_t kind, u64 count);
+void buckets_account_add(buckets_account_t *dst, const buckets_account_t *src);
+u64  buckets_account_syscall_total(const buckets_account_t *acct);
+void buckets_account_get_totals(buckets_account_t *totals, u64 *requests);
+void buckets_account_reset_totals(void);
+const char* buckets_syscall_kind_name(buckets_syscall_kind_t kind);
+
+/* pthread_create that charges the new thread's work to the caller's account */
+int buckets_account_thread_create(pthread_t *thread, void *(*fn)(void *), void *arg);
+
+/* Most threads one buckets_parallel_for runs, the caller included */
+#define BUCKETS_PARALLEL_MAX_THREADS 64
+
+/* Run fn(arg, i) for every i in [0, count) on up to max_threads threads,
+ * the caller being one of them. Indices are claimed in order; a nonzero
+ * return stops further claims and is returned (the first one wins). */
+int buckets_parallel_for(int count, int max_threads,
+                         int (*fn)(void *arg, int index), void *arg);
+
+#define BUCKETS_ACCOUNT_SYSCALL(kind) \
+    do { if (buckets_account_enabled()) buckets_account_record(kind, 1); } while (0)
+
 /* String utilities */
 char* buckets_strdup(const char *str);
 int   buckets_strcmp(const char *s1, const char *s2);
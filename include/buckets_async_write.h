@@ -4,6 +4,10 @@
  * Enables pipelined ACK responses by queueing writes to complete in background.
  * This allows sending HTTP 200 to client immediately after erasure encoding,
  * while chunk writes complete asynchronously.
+ *
+ * Every queued job is first appended to a local write-ahead journal and made
+ * durable with a group-committed fdatasync, so an acknowledged PUT survives a
+ * crash: pending jobs are replayed (or rolled back) on the next startup.
  */
 
 #ifndef BUCKETS_ASYNC_WRITE_H
@@ -20,9 +24,14 @@ extern "C" {
 #include "buckets_storage.h"
 #include "buckets_placement.h"
 
-/* Maximum pending async writes */
+/* Maximum pending async writes (queued plus waiting for a retry) */
 #define MAX_ASYNC_WRITES 1024
 
+/* Failed jobs are retried at runtime after RETRY_BASE_MS << attempts,
+ * capped at RETRY_MAX_MS, until they succeed or are superseded */
+#define ASYNC_WRITE_RETRY_BASE_MS 500
+#define ASYNC_WRITE_RETRY_MAX_MS  (60 * 1000)
+
 /* Async write states */
 typedef enum {
     ASYNC_WRITE_PENDING,      /* Queued, not yet started */
@@ -51,6 +60,8 @@ typedef struct async_write_job {
     int result;                     /* 0 on success, -1 on failure */
     uint64_t queued_time_us;        /* When queued */
     uint64_t complete_time_us;      /* When completed */
+    uint32_t attempts;              /* Failed attempts so far */
+    uint64_t not_before_us;         /* Earliest retry (0 = run now) */
     
     /* Synchronization */
     pthread_mutex_t lock;
@@ -65,6 +76,8 @@ typedef struct {
     async_write_job_t *head;
     async_write_job_t *tail;
     size_t count;
+    async_write_job_t *retry;       /* Failed jobs waiting for their backoff */
+    size_t retry_count;
     pthread_mutex_t lock;
     pthread_cond_t cond;
     bool shutdown;
@@ -76,7 +89,8 @@ typedef struct {
     /* Stats */
     uint64_t total_queued;
     uint64_t total_completed;
-    uint64_t total_failed;
+    uint64_t total_failed;          /* Failed attempts (each is retried) */
+    uint64_t total_superseded;      /* Jobs dropped: a newer version won */
 } async_write_queue_t;
 
 /**
@@ -146,6 +160,124 @@ int buckets_async_write_wait(uint64_t job_id, uint32_t timeout_ms);
 void buckets_async_write_stats(uint64_t *queued, uint64_t *completed, 
                                 uint64_t *failed, size_t *queue_depth);
 
+/**
+ * Replay jobs recovered from the journal
+ * 
+ * Call once storage (and distributed storage, in a cluster) is up. Jobs
+ * whose object has since been overwritten by a newer xl.meta on a read
+ * quorum of its disks are dropped; the rest are queued to the workers and
+ * finished.
+ * 
+ * @return Number of jobs queued for replay
+ */
+int buckets_async_write_replay(void);
+
+/**
+ * Free a job and everything it owns (chunks, placement, metadata)
+ */
+void buckets_async_write_job_free(async_write_job_t *job);
+
+/* ===================================================================
+ * Write-Ahead Journal
+ * ===================================================================*/
+
+/* Journal file name inside the node data directory */
+#define BUCKETS_ASYNC_JOURNAL_FILE "async_write.journal"
+
+/* Truncate the journal once it is idle and larger than this */
+#define BUCKETS_ASYNC_JOURNAL_COMPACT_BYTES (64ULL * 1024 * 1024)
+
+/* Default size cap (BUCKETS_ASYNC_JOURNAL_MAX_MB); full journal = sync PUT */
+#define BUCKETS_ASYNC_JOURNAL_DEFAULT_MAX_MB 1024
+
+typedef struct buckets_async_journal buckets_async_journal_t;
+
+/* Journal statistics */
+typedef struct {
+    uint64_t appends;           /* Job records written */
+    uint64_t completions;       /* Done records written */
+    uint64_t syncs;             /* fdatasync calls (one per commit group) */
+    uint64_t bytes_written;     /* Total bytes appended */
+    uint64_t size_bytes;        /* Current journal size */
+    uint64_t pending;           /* Jobs journaled but not yet complete */
+    uint64_t compactions;       /* Idle truncations */
+    uint64_t replayed;          /* Jobs replayed at startup */
+    uint64_t superseded;        /* Replayed jobs dropped as already applied */
+    uint64_t discarded;         /* Corrupt/torn records rolled back */
+} buckets_async_journal_stats_t;
+
+/**
+ * Load incomplete jobs from a journal file
+ * 
+ * Scans the journal, pairing job records with their done records. A torn
+ * or corrupt tail (crash during append, never acknowledged) ends the scan.
+ * 
+ * @param path Journal file path (missing file = no pending jobs)
+ * @param jobs_out Output: linked list (via ->next) of pending jobs, in order
+ * @param count_out Output: number of pending jobs
+ * @param discarded_out Output: number of records rolled back (optional)
+ * @return BUCKETS_OK on success
+ */
+int buckets_async_journal_load(const char *path, async_write_job_t **jobs_out,
+                               size_t *count_out, size_t *discarded_out);
+
+/**
+ * Open a journal for appending
+ * 
+ * Atomically rewrites the file so it holds only the given pending jobs
+ * (compacting whatever was completed before the restart).
+ * 
+ * @param path Journal file path
+ * @param pending Pending jobs to carry over (may be NULL)
+ * @return Journal handle, or NULL on error
+ */
+buckets_async_journal_t* buckets_async_journal_open(const char *path,
+                                                    const async_write_job_t *pending);
+
+/**
+ * Close journal (does not delete the file)
+ */
+void buckets_async_journal_close(buckets_async_journal_t *journal);
+
+/**
+ * Append a job record (not yet durable)
+ * 
+ * @param journal Journal handle
+ * @param job Job to record (id, names, placement, chunks, metadata)
+ * @param seq_out Output: sequence number to pass to buckets_async_journal_sync
+ * @return BUCKETS_OK, BUCKETS_ERR_NOMEM if the journal is full, BUCKETS_ERR_IO
+ */
+int buckets_async_journal_append(buckets_async_journal_t *journal,
+                                 const async_write_job_t *job, uint64_t *seq_out);
+
+/**
+ * Make all records up to seq durable
+ * 
+ * Concurrent callers share one fdatasync: the first becomes the leader and
+ * syncs everything appended so far, the rest wait for it.
+ * 
+ * @return BUCKETS_OK on success, BUCKETS_ERR_IO on sync failure
+ */
+int buckets_async_journal_sync(buckets_async_journal_t *journal, uint64_t seq);
+
+/**
+ * Record that a job's writes are durable on the storage disks
+ * 
+ * Not synced itself; a lost done record only causes an idempotent replay.
+ */
+int buckets_async_journal_complete(buckets_async_journal_t *journal, uint64_t job_id);
+
+/**
+ * Get journal statistics
+ */
+void buckets_async_journal_get_stats(buckets_async_journal_t *journal,
+                                     buckets_async_journal_stats_t *stats);
+
+/**
+ * Get statistics of the async write system's journal (zeroed if none)
+ */
+void buckets_async_write_journal_stats(buckets_async_journal_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,76 @@
+/**
+ * Sampling CPU Profiler
+ *
+ * Built-in SIGPROF profiler for production nodes where perf is not
+ * available. While a profile runs, ITIMER_PROF fires at the requested
+ * rate; the kernel delivers each SIGPROF to a thread that is burning CPU,
+ * and the handler records that thread's backtrace into a preallocated
+ * sample buffer. Samples are symbolized and aggregated into folded stacks
+ * ("root;caller;callee count" per line) after the timer is disarmed, so
+ * the output can be fed directly to flamegraph.pl or speedscope.
+ *
+ * Costs nothing when idle: no timer runs, and the handler (left installed
+ * after the first profile so a late SIGPROF is harmless) returns at once.
+ * While sampling, each sample is one unwind of at most
+ * BUCKETS_CPUPROF_MAX_DEPTH frames; at the default 99 Hz this is well
+ * under 1% of a core.
+ *
+ * Only one profile runs at a time.
+ */
+
+#ifndef BUCKETS_CPUPROF_H
+#define BUCKETS_CPUPROF_H
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUCKETS_CPUPROF_DEFAULT_HZ      99
+#define BUCKETS_CPUPROF_MAX_HZ          1000
+#define BUCKETS_CPUPROF_MAX_SECONDS     120
+#define BUCKETS_CPUPROF_MAX_DEPTH       48
+#define BUCKETS_CPUPROF_MAX_SAMPLES     20000
+
+/**
+ * Profile result
+ */
+typedef struct {
+    char *folded;           /* Folded stacks, one "stack count\n" per line */
+    size_t folded_len;      /* Length of folded */
+    u64 samples;            /* Samples recorded */
+    u64 dropped;            /* Samples dropped (buffer full) */
+    u32 hz;                 /* Sampling rate used */
+    u32 duration_ms;        /* Profile duration */
+} buckets_cpuprof_result_t;
+
+/**
+ * Profile the whole process for duration_ms and return folded stacks
+ *
+ * Blocks the calling thread for the duration; call from a worker thread,
+ * never from an event loop.
+ *
+ * @param duration_ms Profile duration (1 ms .. BUCKETS_CPUPROF_MAX_SECONDS)
+ * @param hz Sampling rate (0 = BUCKETS_CPUPROF_DEFAULT_HZ)
+ * @param result Output (free with buckets_cpuprof_result_free)
+ * @return BUCKETS_OK, BUCKETS_ERR_INVALID_ARG, or BUCKETS_ERR_LIMIT if a
+ *         profile is already running
+ */
+int buckets_cpuprof_collect(u32 duration_ms, u32 hz, buckets_cpuprof_result_t *result);
+
+/**
+ * Free a profile result
+ */
+void buckets_cpuprof_result_free(buckets_cpuprof_result_t *result);
+
+/**
+ * Check whether a profile is currently running
+ */
+bool buckets_cpuprof_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_CPUPROF_H */
@@ -15,6 +15,8 @@ extern "C" {
 #include <stdbool.h>
 #include <time.h>
 
+#include "buckets.h"
+
 /* ===================================================================
  * Configuration
  * ===================================================================*/
@@ -81,6 +83,9 @@ typedef struct {
     struct timespec rpc_end_time;
     struct timespec end_time;
     
+    buckets_account_t account;              /* Syscalls/allocs (BUCKETS_ACCOUNTING) */
+    buckets_account_t *prev_account;        /* Account attached before this request */
+    
     uint64_t request_id;
     char operation[32];
     char bucket[256];
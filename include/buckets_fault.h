@@ -0,0 +1,53 @@
+/**
+ * Fault Injection
+ *
+ * Deterministic disk faults for multi-node performance tests. Faults are
+ * configured through environment variables so that a test harness can
+ * start unmodified server binaries with a degraded disk:
+ *
+ *   BUCKETS_FAULT_SLOW_DISK="<disk-path>:<delay-ms>[,<disk-path>:<delay-ms>...]"
+ *       Sleep <delay-ms> before every read/write under <disk-path>
+ *
+ *   BUCKETS_FAULT_FAIL_DISK="<disk-path>[,<disk-path>...]"
+ *       Fail every read/write under <disk-path> with BUCKETS_ERR_IO
+ *
+ * When neither variable is set the hooks reduce to a single branch.
+ */
+
+#ifndef BUCKETS_FAULT_H
+#define BUCKETS_FAULT_H
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of disks that can carry an injected fault */
+#define BUCKETS_FAULT_MAX_DISKS 32
+
+/**
+ * Check whether any disk fault is configured
+ *
+ * Parses the environment on first call.
+ *
+ * @return true if BUCKETS_FAULT_SLOW_DISK or BUCKETS_FAULT_FAIL_DISK is set
+ */
+bool buckets_fault_enabled(void);
+
+/**
+ * Apply configured disk faults for a file path
+ *
+ * Sleeps if the path lives on a slow disk. Called from the storage I/O
+ * helpers before touching the filesystem.
+ *
+ * @param path File path about to be read or written
+ * @return BUCKETS_OK, or BUCKETS_ERR_IO if the path lives on a failed disk
+ */
+int buckets_fault_disk_io(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_FAULT_H */
@@ -0,0 +1,91 @@
+/**
+ * Disk I/O Priority
+ *
+ * Three I/O classes so metadata does not queue behind bulk shard transfers
+ * on the same disk:
+ *
+ *   META    - xl.meta reads, writes and deletes (best-effort level 0)
+ *   DEFAULT - everything else (the kernel's default best-effort level 4)
+ *   BULK    - shard I/O of large transfers (best-effort level 7)
+ *
+ * The class belongs to the calling thread and is applied with ioprio_set,
+ * so blocking reads and writes carry it and threads created while it is
+ * set inherit it. io_uring submissions carry it in the SQE because the
+ * ring's own threads issue the I/O. Priorities only take effect under an
+ * I/O scheduler that honours them (BFQ, mq-deadline); elsewhere they are
+ * a no-op. BUCKETS_IO_PRIORITY=off disables them (on by default).
+ */
+
+#ifndef BUCKETS_IO_PRIORITY_H
+#define BUCKETS_IO_PRIORITY_H
+
+#include <stdbool.h>
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BUCKETS_IO_CLASS_DEFAULT = 0,
+    BUCKETS_IO_CLASS_META,
+    BUCKETS_IO_CLASS_BULK
+} buckets_io_class_t;
+
+/**
+ * I/O priority counters
+ */
+typedef struct {
+    u64 meta_scopes;            /* Switches into META */
+    u64 bulk_scopes;            /* Switches into BULK */
+    u64 failures;               /* ioprio_set refused (class kept in SQEs) */
+} buckets_io_priority_stats_t;
+
+/**
+ * Read BUCKETS_IO_PRIORITY
+ *
+ * Safe to call more than once; the other calls initialize on first use.
+ */
+void buckets_io_priority_init(void);
+
+/**
+ * Check whether I/O classes are applied to the disk
+ */
+bool buckets_io_priority_enabled(void);
+
+/**
+ * Set the calling thread's I/O class
+ *
+ * Only issues a syscall when the class changes.
+ *
+ * @param cls New class
+ * @return The previous class, to restore when the scope ends
+ */
+buckets_io_class_t buckets_io_class_set(buckets_io_class_t cls);
+
+/**
+ * Get the calling thread's I/O class
+ */
+buckets_io_class_t buckets_io_class_get(void);
+
+/**
+ * ioprio value for an SQE submitted by the calling thread
+ *
+ * DEFAULT is encoded explicitly (best-effort level 4) rather than left to
+ * whatever priority the async worker running the SQE inherited.
+ *
+ * @return Encoded priority, or 0 (the ring's default) when disabled
+ */
+u16 buckets_io_class_sqe_ioprio(void);
+
+/**
+ * Get I/O priority counters
+ */
+void buckets_io_priority_get_stats(buckets_io_priority_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_IO_PRIORITY_H */
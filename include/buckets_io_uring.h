@@ -47,6 +47,8 @@ typedef struct {
     uint32_t batch_size;      /* Submit batch size (default: 32) */
     bool sq_poll;             /* Use kernel polling (IORING_SETUP_SQPOLL) */
     bool io_poll;             /* Use polled I/O (IORING_SETUP_IOPOLL) */
+    bool sq_thread_pin;       /* Bind the SQPOLL thread to sq_thread_cpu */
+    uint32_t sq_thread_cpu;   /* CPU for the SQPOLL thread (IORING_SETUP_SQ_AFF) */
 } buckets_io_uring_config_t;
 
 /* Statistics */
@@ -0,0 +1,138 @@
+/**
+ * Node-Wide Memory Budget
+ *
+ * Byte semaphore that large requests reserve against before buffering
+ * whole objects (request bodies, streaming upload reassembly, GET decode
+ * and response buffers, multipart completion), so a burst of concurrent
+ * multi-GB requests waits instead of OOM-killing the node.
+ *
+ * Two ways to reserve:
+ * - Event loop: buckets_mem_budget_try_reserve never blocks. When it fails
+ *   the server stops reading from that connection and retries from the
+ *   release hook as budget frees.
+ * - Worker threads: inside a request scope (buckets_mem_budget_scope_begin
+ *   / _end), buckets_mem_budget_charge blocks until the bytes are free and
+ *   adds them to the scope; the server releases the scope total once the
+ *   response has been written. Outside a scope, charges are no-ops.
+ *
+ * A single reservation larger than the whole budget is admitted once
+ * nothing else is reserved. A blocked charge that waits longer than the
+ * configured limit proceeds anyway (counted as an overdraft) so requests
+ * holding budget while queued for a worker cannot deadlock the pool.
+ *
+ * Reservations below BUCKETS_MEM_BUDGET_MIN_RESERVE are not tracked.
+ */
+
+#ifndef BUCKETS_MEM_BUDGET_H
+#define BUCKETS_MEM_BUDGET_H
+
+#include <stdbool.h>
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUCKETS_MEM_BUDGET_MIN_RESERVE      (1024 * 1024)   /* 1 MB */
+#define BUCKETS_MEM_BUDGET_DEFAULT_WAIT_MS  10000
+#define BUCKETS_MEM_BUDGET_MAX_HOOKS        8
+
+/**
+ * Memory budget statistics
+ */
+typedef struct {
+    u64 limit;                  /* Budget in bytes (0 = disabled) */
+    u64 used;                   /* Bytes currently reserved */
+    u64 peak;                   /* Highest used */
+    u64 reservations;           /* Successful reservations */
+    u64 waits;                  /* Charges that had to wait */
+    u64 wait_time_us;           /* Total time spent waiting */
+    u64 overdrafts;             /* Charges admitted after the wait limit */
+    u64 deferred;               /* Event-loop reservations that failed (read paused) */
+} buckets_mem_budget_stats_t;
+
+/**
+ * Callback run (with the budget lock held) whenever bytes are released
+ *
+ * Must not block or call back into the budget; typically uv_async_send.
+ */
+typedef void (*buckets_mem_budget_hook_t)(void *arg);
+
+/**
+ * Initialize the budget
+ *
+ * @param limit_bytes Budget (0 = disabled: every reservation succeeds)
+ * @param wait_ms Longest a charge waits before overdrafting
+ * @return BUCKETS_OK
+ */
+int buckets_mem_budget_init(u64 limit_bytes, u32 wait_ms);
+
+/**
+ * Initialize from BUCKETS_MEM_BUDGET_MB (default: half of physical memory,
+ * 0 disables) and BUCKETS_MEM_BUDGET_WAIT_MS
+ *
+ * @param shares Processes splitting the node budget (forked workers; 0 = 1)
+ */
+int buckets_mem_budget_init_from_env(u32 shares);
+
+/**
+ * Disable the budget and wake all waiters
+ */
+void buckets_mem_budget_cleanup(void);
+
+/**
+ * Check whether a budget is being enforced
+ */
+bool buckets_mem_budget_enabled(void);
+
+/**
+ * Reserve bytes without blocking
+ *
+ * @return true if reserved (or below the tracking threshold / disabled)
+ */
+bool buckets_mem_budget_try_reserve(u64 bytes);
+
+/**
+ * Return bytes reserved with try_reserve or held by a scope
+ */
+void buckets_mem_budget_release(u64 bytes);
+
+/**
+ * Start collecting charges made by this thread into a request scope
+ */
+void buckets_mem_budget_scope_begin(void);
+
+/**
+ * Stop collecting charges for this thread
+ *
+ * @return Bytes charged in the scope; the caller releases them when the
+ *         memory they stand for is gone
+ */
+u64 buckets_mem_budget_scope_end(void);
+
+/**
+ * Charge bytes to the current request scope, waiting for budget if needed
+ *
+ * No-op outside a scope or below the tracking threshold.
+ */
+void buckets_mem_budget_charge(u64 bytes);
+
+/**
+ * Register / unregister a release hook
+ *
+ * @return BUCKETS_OK, or BUCKETS_ERR_LIMIT if all hook slots are taken
+ */
+int buckets_mem_budget_add_hook(buckets_mem_budget_hook_t hook, void *arg);
+void buckets_mem_budget_remove_hook(buckets_mem_budget_hook_t hook, void *arg);
+
+/**
+ * Get budget statistics
+ */
+void buckets_mem_budget_get_stats(buckets_mem_budget_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_MEM_BUDGET_H */
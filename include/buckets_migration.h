@@ -516,6 +516,28 @@ void buckets_throttle_cleanup(buckets_throttle_t *throttle);
  */
 int buckets_throttle_wait(buckets_throttle_t *throttle, i64 bytes);
 
+/**
+ * Consume tokens if available, without waiting
+ * 
+ * @param throttle Throttle handle
+ * @param bytes Number of bytes to consume
+ * @return true if consumed (or throttling is disabled), false if short
+ */
+bool buckets_throttle_try_consume(buckets_throttle_t *throttle, i64 bytes);
+
+/**
+ * Consume tokens without waiting, going into debt if there are too few
+ * 
+ * For callers that cannot block (an event loop): the bytes have already
+ * moved, and the caller pauses for the returned time instead of sleeping.
+ * A negative count refunds tokens; 0 just reports the current debt.
+ * 
+ * @param throttle Throttle handle
+ * @param bytes Number of bytes to charge
+ * @return Microseconds until the bucket is out of debt (0 if it is not)
+ */
+i64 buckets_throttle_charge(buckets_throttle_t *throttle, i64 bytes);
+
 /**
  * Set throttle rate (can be changed dynamically)
  * 
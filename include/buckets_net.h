@@ -16,11 +16,14 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
+#include <sys/types.h>
 
 #include "buckets.h"
 
 /* Forward declarations */
 typedef struct buckets_router buckets_router_t;
+struct uv_http_server;
+struct iovec;
 
 /* ===================================================================
  * HTTP Server (Week 31)
@@ -379,6 +382,103 @@ int buckets_conn_send_request(buckets_connection_t *conn,
                                char **response,
                                int *status_code);
 
+/* ===================================================================
+ * Peer Transport Security
+ * ===================================================================*/
+
+/**
+ * Peer TLS statistics
+ */
+typedef struct {
+    u64 handshakes;            /* Completed client handshakes */
+    u64 resumed;               /* ...of which resumed a cached session */
+    u64 ktls;                  /* ...of which the kernel encrypts both ways */
+    u64 failures;              /* Failed handshakes */
+} buckets_peer_tls_stats_t;
+
+/**
+ * Configure mutually authenticated TLS for inter-node connections
+ *
+ * Every node presents cert_file and requires peers to present a
+ * certificate signed by ca_file. Sessions are pinned to TLS 1.2 with
+ * AES-GCM so that the kernel can take over record encryption in both
+ * directions (kTLS) and no post-handshake messages arrive on idle pooled
+ * sockets. Passing NULL for any file disables peer TLS.
+ *
+ * @param cert_file Node certificate (PEM)
+ * @param key_file Node private key (PEM)
+ * @param ca_file Cluster CA bundle (PEM)
+ * @return BUCKETS_OK on success
+ */
+int buckets_peer_tls_init(const char *cert_file, const char *key_file,
+                          const char *ca_file);
+
+/**
+ * Configure peer TLS from BUCKETS_PEER_TLS_CERT, BUCKETS_PEER_TLS_KEY
+ * and BUCKETS_PEER_TLS_CA (disabled unless all three are set)
+ *
+ * @return BUCKETS_OK on success
+ */
+int buckets_peer_tls_init_from_env(void);
+
+/**
+ * Release peer TLS state and cached sessions
+ */
+void buckets_peer_tls_cleanup(void);
+
+/**
+ * Check whether peer connections are encrypted
+ */
+bool buckets_peer_tls_enabled(void);
+
+/**
+ * Cluster CA file, or NULL when peer TLS is off
+ */
+const char* buckets_peer_tls_ca_file(void);
+
+/**
+ * Serve the node's peer certificate on a UV server and require a
+ * cluster-signed client certificate on internal routes
+ *
+ * @param server UV server handle
+ * @return BUCKETS_OK on success (no-op when peer TLS is off)
+ */
+int buckets_peer_tls_enable_server(struct uv_http_server *server);
+
+/**
+ * Run the client handshake on a freshly connected blocking socket
+ *
+ * Resumes the last session cached for host:port when possible. No-op
+ * when peer TLS is off.
+ *
+ * @param fd Connected socket
+ * @param host Peer host (session cache key, SNI)
+ * @param port Peer port
+ * @return BUCKETS_OK on success
+ */
+int buckets_peer_tls_connect(int fd, const char *host, int port);
+
+/**
+ * Drop the TLS state for a peer socket (does not close fd)
+ */
+void buckets_peer_tls_close(int fd);
+
+/**
+ * Socket I/O on peer connections
+ *
+ * Same contract as send(2)/recv(2)/writev(2). Sockets whose records the
+ * kernel encrypts (or plaintext sockets) go straight to the syscall, so
+ * writev stays zero-copy; otherwise OpenSSL encrypts in userspace.
+ */
+ssize_t buckets_peer_send(int fd, const void *buf, size_t len);
+ssize_t buckets_peer_recv(int fd, void *buf, size_t len);
+ssize_t buckets_peer_writev(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * Get peer TLS statistics
+ */
+void buckets_peer_tls_get_stats(buckets_peer_tls_stats_t *stats);
+
 /* ===================================================================
  * Peer Discovery (Week 33)
  * ===================================================================*/
@@ -432,7 +532,7 @@ int buckets_peer_grid_remove_peer(buckets_peer_grid_t *grid,
  * 
  * @param grid Peer grid
  * @param count Output: number of peers
- * @return Array of peer pointers (internal, do not free)
+ * @return Array of peer pointers (free the array with buckets_free)
  */
 buckets_peer_t** buckets_peer_grid_get_peers(buckets_peer_grid_t *grid,
                                               int *count);
@@ -609,6 +709,17 @@ int buckets_rpc_register_handler(buckets_rpc_context_t *ctx,
                                   buckets_rpc_handler_t handler,
                                   void *user_data);
 
+/**
+ * Unregister RPC method handler
+ * 
+ * The caller must ensure no dispatch of the method is still running.
+ * 
+ * @param ctx RPC context
+ * @param method Method name
+ * @return BUCKETS_OK on success, BUCKETS_ERR_NOT_FOUND if not registered
+ */
+int buckets_rpc_unregister_handler(buckets_rpc_context_t *ctx, const char *method);
+
 /**
  * Call RPC method on peer
  * 
@@ -739,6 +850,294 @@ int buckets_rpc_broadcast(buckets_rpc_context_t *ctx,
  */
 void buckets_broadcast_result_free(buckets_broadcast_result_t *result);
 
+/**
+ * Call one RPC method on many endpoints concurrently
+ * 
+ * Up to 16 calls are in flight at once; returns when all have finished.
+ * params is shared read-only by all calls.
+ * 
+ * @param ctx RPC context
+ * @param endpoints Endpoints to call (NULL entries are skipped)
+ * @param count Number of endpoints
+ * @param method RPC method name
+ * @param params JSON parameters (may be NULL)
+ * @param responses Output: per endpoint, the response if the call and the
+ *                  handler succeeded, else NULL (caller frees each)
+ * @param timeout_ms Timeout per call in milliseconds (0 = default 5000ms)
+ * @return BUCKETS_OK on success (even if some calls fail)
+ */
+int buckets_rpc_fanout(buckets_rpc_context_t *ctx,
+                       const char **endpoints,
+                       int count,
+                       const char *method,
+                       struct cJSON *params,
+                       buckets_rpc_response_t **responses,
+                       int timeout_ms);
+
+/* ===================================================================
+ * Gossip Membership
+ * ===================================================================*/
+
+/**
+ * Gossip membership (opaque)
+ * 
+ * SWIM-style failure detection and dissemination over the RPC transport.
+ * Each period a node pings one member; if the ping fails it asks a few
+ * others to ping the member for it, and only if those fail too is the
+ * member suspected. Suspected members are declared dead after a timeout
+ * that grows with log(N) unless they refute it. Membership changes,
+ * topology generations and cache invalidations ride on the pings, so
+ * per-node probe load and detection time stay constant as the cluster
+ * grows and dissemination takes O(log N) periods.
+ * 
+ * A phi-accrual detector per member tracks the gaps between successful
+ * contacts: members whose silence is already anomalous are probed out of
+ * turn, and suspicion of a member with high phi is confirmed in half the
+ * time.
+ */
+typedef struct buckets_gossip buckets_gossip_t;
+
+/**
+ * Membership shared by the forked workers of one node (opaque)
+ */
+typedef struct buckets_gossip_shared buckets_gossip_shared_t;
+
+/**
+ * Member state
+ */
+typedef enum {
+    BUCKETS_MEMBER_ALIVE = 0,
+    BUCKETS_MEMBER_SUSPECT,
+    BUCKETS_MEMBER_DEAD
+} buckets_member_state_t;
+
+/**
+ * Gossip configuration
+ */
+typedef struct {
+    int period_ms;              /* Protocol period: one probe each */
+    int probe_timeout_ms;       /* Direct and indirect ping timeout */
+    int indirect_probes;        /* Members asked to ping on our behalf */
+    double phi_threshold;       /* Phi above which a member looks failed */
+    int suspicion_mult;         /* Suspect timeout = mult * log10(N+1) periods */
+    int retransmit_mult;        /* Updates are sent mult * log10(N+1) times */
+    int max_piggyback;          /* Updates carried per message */
+} buckets_gossip_config_t;
+
+/**
+ * Gossip callbacks
+ * 
+ * member_changed and invalidate may run on the server's event loop and must
+ * not block; topology_generation runs on the protocol thread.
+ */
+typedef struct {
+    void (*member_changed)(const char *node_id, const char *endpoint,
+                           buckets_member_state_t state, void *user_data);
+    void (*topology_generation)(i64 generation, void *user_data);
+    void (*invalidate)(const char *bucket, const char *object, void *user_data);
+    void *user_data;
+} buckets_gossip_callbacks_t;
+
+/**
+ * Member snapshot
+ */
+typedef struct {
+    char node_id[64];
+    char endpoint[256];
+    buckets_member_state_t state;
+    u64 incarnation;
+    double phi;                 /* Current suspicion level */
+} buckets_gossip_member_t;
+
+/**
+ * Gossip counters
+ */
+typedef struct {
+    u64 probes;                 /* Direct pings sent */
+    u64 probe_failures;         /* Direct pings unanswered */
+    u64 indirect_probes;        /* Ping requests sent to helpers */
+    u64 indirect_acks;          /* Members reached only through helpers */
+    u64 phi_probes;             /* Probes sent out of turn for high phi */
+    u64 suspicions;             /* Members we suspected */
+    u64 deaths;                 /* Members we declared dead */
+    u64 refutations;            /* Times we refuted suspicion of ourselves */
+    u64 updates_sent;           /* Piggybacked updates sent */
+    u64 updates_received;       /* Piggybacked updates received */
+    u64 forwarded;              /* Messages a follower passed to the agent */
+    u64 forward_drops;          /* Messages the agent's inbox could not take */
+} buckets_gossip_stats_t;
+
+/**
+ * Fill gossip configuration from defaults and the environment
+ * 
+ * BUCKETS_GOSSIP_PERIOD_MS (1000), BUCKETS_GOSSIP_PROBE_TIMEOUT_MS (300),
+ * BUCKETS_GOSSIP_INDIRECT (3), BUCKETS_GOSSIP_PHI (8).
+ * 
+ * @param config Output configuration
+ */
+void buckets_gossip_config_default(buckets_gossip_config_t *config);
+
+/**
+ * Create gossip membership and register its RPC methods on ctx
+ * 
+ * @param ctx RPC context (used for outgoing probes and incoming messages)
+ * @param node_id This node's ID
+ * @param endpoint This node's RPC endpoint
+ * @param config Configuration (NULL = defaults)
+ * @return Gossip handle or NULL on error
+ */
+buckets_gossip_t* buckets_gossip_create(buckets_rpc_context_t *ctx,
+                                        const char *node_id,
+                                        const char *endpoint,
+                                        const buckets_gossip_config_t *config);
+
+/**
+ * Add a seed member (initially alive)
+ * 
+ * @param gossip Gossip handle
+ * @param node_id Member node ID
+ * @param endpoint Member RPC endpoint
+ * @return BUCKETS_OK on success
+ */
+int buckets_gossip_add_member(buckets_gossip_t *gossip,
+                              const char *node_id,
+                              const char *endpoint);
+
+/**
+ * Set callbacks (call before start)
+ */
+void buckets_gossip_set_callbacks(buckets_gossip_t *gossip,
+                                  const buckets_gossip_callbacks_t *callbacks);
+
+/**
+ * Map the segment the workers of one node share (call before fork)
+ * 
+ * @return Shared segment or NULL on error
+ */
+buckets_gossip_shared_t* buckets_gossip_shared_create(void);
+
+/**
+ * Unmap a shared segment
+ * 
+ * @param shared Shared segment
+ */
+void buckets_gossip_shared_destroy(buckets_gossip_shared_t *shared);
+
+/**
+ * Join the node's shared membership (call before start)
+ * 
+ * Exactly one worker per node is the agent: it runs the protocol and
+ * mirrors its incarnation and member states into the segment. The other
+ * workers follow: they run no threads, answer peers' messages for the node
+ * and forward them to the agent, and read membership from the segment.
+ * 
+ * @param gossip Gossip handle
+ * @param shared Shared segment
+ * @param agent true in the one worker that runs the protocol
+ */
+void buckets_gossip_share(buckets_gossip_t *gossip, buckets_gossip_shared_t *shared,
+                          bool agent);
+
+/**
+ * Start the protocol thread
+ * 
+ * @param gossip Gossip handle
+ * @return BUCKETS_OK on success
+ */
+int buckets_gossip_start(buckets_gossip_t *gossip);
+
+/**
+ * Stop the protocol thread
+ * 
+ * @param gossip Gossip handle
+ */
+void buckets_gossip_stop(buckets_gossip_t *gossip);
+
+/**
+ * Run one protocol period in the calling thread
+ * 
+ * Probes one member and expires suspicions. Used by the protocol thread
+ * and by tests.
+ * 
+ * @param gossip Gossip handle
+ */
+void buckets_gossip_tick(buckets_gossip_t *gossip);
+
+/**
+ * Disseminate a new topology generation
+ * 
+ * @param gossip Gossip handle
+ * @param generation Topology generation
+ */
+void buckets_gossip_publish_topology(buckets_gossip_t *gossip, i64 generation);
+
+/**
+ * Disseminate a cache invalidation
+ * 
+ * @param gossip Gossip handle
+ * @param bucket Bucket name
+ * @param object Object key
+ */
+void buckets_gossip_publish_invalidation(buckets_gossip_t *gossip,
+                                         const char *bucket,
+                                         const char *object);
+
+/**
+ * Check whether the member at an endpoint has been declared dead
+ * 
+ * @param gossip Gossip handle
+ * @param endpoint Member RPC endpoint
+ * @return true only for a known member in the DEAD state
+ */
+bool buckets_gossip_endpoint_dead(buckets_gossip_t *gossip, const char *endpoint);
+
+/**
+ * Snapshot the member list
+ * 
+ * @param gossip Gossip handle
+ * @param members Output array (caller frees with buckets_free)
+ * @param count Output number of members
+ * @return BUCKETS_OK on success
+ */
+int buckets_gossip_get_members(buckets_gossip_t *gossip,
+                               buckets_gossip_member_t **members,
+                               int *count);
+
+/**
+ * Get gossip counters
+ */
+void buckets_gossip_get_stats(buckets_gossip_t *gossip, buckets_gossip_stats_t *stats);
+
+/**
+ * Stop, unregister RPC methods and free
+ * 
+ * @param gossip Gossip handle
+ */
+void buckets_gossip_free(buckets_gossip_t *gossip);
+
+/**
+ * Phi-accrual failure detector state for one member
+ */
+#define BUCKETS_PHI_WINDOW 32
+
+typedef struct {
+    u64 last_ms;                       /* Last heartbeat (0 = none yet) */
+    double intervals[BUCKETS_PHI_WINDOW];  /* Recent inter-arrival times */
+    int count;
+    int next;
+} buckets_phi_detector_t;
+
+/**
+ * Record a heartbeat (any successful contact) at now_ms
+ */
+void buckets_phi_heartbeat(buckets_phi_detector_t *detector, u64 now_ms);
+
+/**
+ * Suspicion level at now_ms: -log10 of the probability that a heartbeat
+ * this late is still coming. 0 until two heartbeats have been seen.
+ */
+double buckets_phi_value(const buckets_phi_detector_t *detector, u64 now_ms);
+
 /* ===================================================================
  * UV HTTP Server (Streaming Support)
  * ===================================================================*/
@@ -772,6 +1171,19 @@ int uv_http_server_enable_tls(uv_http_server_t *server,
                                const char *cert_file,
                                const char *key_file);
 
+/**
+ * Restrict internal routes (/_internal/, /rpc) to cluster nodes
+ * 
+ * Clients may present a certificate; internal routes answer 403 unless
+ * it was signed by ca_file. Requires TLS on the server.
+ * 
+ * @param server Server handle
+ * @param ca_file Cluster CA bundle (PEM)
+ * @return BUCKETS_OK on success
+ */
+int uv_http_server_require_peer_certs(uv_http_server_t *server,
+                                       const char *ca_file);
+
 /**
  * Start UV HTTP server (runs in background thread)
  * 
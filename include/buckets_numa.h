@@ -0,0 +1,120 @@
+/**
+ * NUMA / CPU Affinity
+ *
+ * Topology-aware placement for multi-socket nodes, enabled with
+ * BUCKETS_NUMA=on (off by default):
+ *
+ * - Forked HTTP workers are spread round-robin over NUMA nodes. Each worker
+ *   process is pinned to its node's CPUs before it creates any threads, so
+ *   its event loop, libuv pool threads and io_uring poller stay on that
+ *   socket, and its memory policy prefers the node so request and shard
+ *   buffers are allocated locally.
+ * - Each worker also gets a home CPU on its node. The listening socket
+ *   carries it as SO_INCOMING_CPU so SO_REUSEPORT prefers the worker whose
+ *   home CPU took the connection's receive interrupt.
+ * - Threads doing local disk I/O for one chunk run on the node the disk's
+ *   controller is attached to (from sysfs).
+ *
+ * Disk reads and writes are counted as node-local or cross-socket whether
+ * or not placement is enabled, so the effect shows in metrics.
+ */
+
+#ifndef BUCKETS_NUMA_H
+#define BUCKETS_NUMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUCKETS_NUMA_MAX_NODES  64
+
+/**
+ * Disk I/O locality counters
+ */
+typedef struct {
+    u32 nodes;                  /* NUMA nodes detected */
+    int home_node;              /* Node this process is pinned to (-1 = none) */
+    int home_cpu;               /* SO_INCOMING_CPU of this process (-1 = none) */
+    u64 local_ops;              /* Disk I/O issued from the disk's node */
+    u64 local_bytes;
+    u64 remote_ops;             /* Disk I/O crossing sockets */
+    u64 remote_bytes;
+    u64 unknown_ops;            /* Disk node not reported by sysfs */
+} buckets_numa_stats_t;
+
+/**
+ * Discover the topology and read BUCKETS_NUMA
+ *
+ * Safe to call more than once. On hosts without NUMA information the
+ * whole machine is treated as one node.
+ */
+void buckets_numa_init(void);
+
+/**
+ * Check whether topology-aware placement is enabled
+ */
+bool buckets_numa_enabled(void);
+
+/**
+ * Number of NUMA nodes
+ */
+u32 buckets_numa_node_count(void);
+
+/**
+ * Pin the calling worker process to a node
+ *
+ * Call first thing in a freshly forked worker, before it starts threads.
+ * No-op unless placement is enabled.
+ *
+ * @param worker_id Worker number (0-based)
+ * @return BUCKETS_OK, or BUCKETS_ERR_IO if the affinity could not be set
+ */
+int buckets_numa_pin_worker(int worker_id);
+
+/**
+ * Node / CPU the process was pinned to (-1 if not pinned)
+ */
+int buckets_numa_home_node(void);
+int buckets_numa_home_cpu(void);
+
+/**
+ * Node the calling thread is currently running on (-1 if unknown)
+ */
+int buckets_numa_current_node(void);
+
+/**
+ * Node the block device holding a path is attached to (-1 if unknown)
+ *
+ * Results are cached per path.
+ */
+int buckets_numa_node_of_path(const char *path);
+
+/**
+ * Move the calling thread onto a node's CPUs
+ *
+ * No-op unless placement is enabled or when node is -1. The pinning
+ * outlives the call: use it only on threads spawned for the I/O, never on
+ * pool or loop threads that go on to serve other requests.
+ */
+void buckets_numa_run_on_node(int node);
+
+/**
+ * Count one disk I/O against the disk at disk_path
+ */
+void buckets_numa_record_io(const char *disk_path, size_t bytes);
+
+/**
+ * Get locality statistics
+ */
+void buckets_numa_get_stats(buckets_numa_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_NUMA_H */
@@ -30,6 +30,7 @@ extern "C" {
 #define BUCKETS_REGISTRY_CACHE_SIZE (1000000)  /* 1M entries */
 #define BUCKETS_REGISTRY_CACHE_TTL (300)       /* 5 minutes */
 #define BUCKETS_REGISTRY_MAX_DISKS (16)        /* Max disks per set */
+#define BUCKETS_REGISTRY_SHARED_KEY_MAX (384)  /* Longest key in the shared cache */
 
 /**
  * Object location information
@@ -244,6 +245,19 @@ int buckets_registry_cache_invalidate(const char *bucket, const char *object,
  */
 void buckets_registry_cache_clear(void);
 
+/**
+ * List cached keys, most recently used first
+ * 
+ * Only the private cache is listed; a shared cache yields no keys.
+ * 
+ * @param keys Output array of "bucket/object/version-id" keys (caller frees
+ *             each key and the array with buckets_free)
+ * @param count Output number of keys
+ * @param max Maximum number of keys to return
+ * @return 0 on success, -1 on error
+ */
+int buckets_registry_cache_keys(char ***keys, u32 *count, u32 max);
+
 /**
  * Get cache statistics
  * 
@@ -252,6 +266,17 @@ void buckets_registry_cache_clear(void);
  */
 int buckets_registry_get_stats(buckets_registry_stats_t *stats);
 
+/**
+ * Move the location cache into a shared-memory segment
+ *
+ * Call in the master before forking workers so every worker uses the same
+ * cache (see buckets_shm_cache.h). Entries cached so far are dropped; keys
+ * longer than BUCKETS_REGISTRY_SHARED_KEY_MAX are not cached.
+ *
+ * @return 0 on success, -1 on error (the private cache stays in use)
+ */
+int buckets_registry_cache_share(void);
+
 /* ===== Memory Management ===== */
 
 /**
@@ -19,6 +19,7 @@ extern "C" {
 
 #include "buckets.h"
 #include "buckets_net.h"
+#include "buckets_storage.h"
 
 /* ===================================================================
  * S3 Request/Response Types
@@ -137,6 +138,51 @@ void buckets_s3_handler(buckets_http_request_t *req,
                         buckets_http_response_t *res,
                         void *user_data);
 
+/**
+ * Parse and authenticate an S3 request
+ * 
+ * The first half of buckets_s3_handler, for callers that route a request
+ * themselves. On failure res holds the 400/403 reply.
+ * 
+ * @param req HTTP request
+ * @param res HTTP response (filled on failure only)
+ * @param s3_req Output: S3 request (caller must free with buckets_s3_request_free)
+ * @return BUCKETS_OK on success
+ */
+int buckets_s3_accept_request(buckets_http_request_t *req,
+                               buckets_http_response_t *res,
+                               buckets_s3_request_t **s3_req);
+
+/**
+ * Route an already accepted S3 request
+ * 
+ * The second half of buckets_s3_handler, for callers that ran
+ * buckets_s3_accept_request themselves and then decided not to handle the
+ * request, so it is not parsed and authenticated twice.
+ * 
+ * @param req HTTP request
+ * @param s3_req S3 request from buckets_s3_accept_request (freed here)
+ * @param res HTTP response
+ */
+void buckets_s3_handle_accepted(buckets_http_request_t *req,
+                                buckets_s3_request_t *s3_req,
+                                buckets_http_response_t *res);
+
+/**
+ * Convert an S3 response to the HTTP response sent to the client
+ * 
+ * Moves the body into res (dropped for HEAD, whose Content-Length is taken
+ * from content_length) and sets ETag, Last-Modified, Content-Type,
+ * x-amz-version-id and x-amz-meta-* headers.
+ * 
+ * @param method HTTP method of the request
+ * @param s3_res S3 response (still owned by the caller)
+ * @param res HTTP response
+ */
+void buckets_s3_to_http_response(const char *method,
+                                 buckets_s3_response_t *s3_res,
+                                 buckets_http_response_t *res);
+
 /**
  * Parse S3 request from HTTP request
  * 
@@ -366,6 +412,38 @@ int buckets_s3_put_object(buckets_s3_request_t *req,
 int buckets_s3_get_object(buckets_s3_request_t *req,
                           buckets_s3_response_t *res);
 
+/**
+ * First half of GET Object: validate the request and try the object cache
+ * 
+ * @param req S3 request
+ * @param res Output: S3 response
+ * @param cache_token Output: token to pass to buckets_s3_get_object_complete
+ * @return 1 if res is final (invalid request or cache hit), 0 if the object
+ *         must be read from storage
+ */
+int buckets_s3_get_object_prepare(buckets_s3_request_t *req,
+                                  buckets_s3_response_t *res,
+                                  u64 *cache_token);
+
+/**
+ * Second half of GET Object: build the response around the object read
+ * 
+ * Sets the ETag, content type and user metadata and offers the object to
+ * the cache.
+ * 
+ * @param req S3 request
+ * @param res Output: S3 response (takes ownership of object_data)
+ * @param object_data Object contents
+ * @param object_size Object size
+ * @param meta Object metadata if already read, NULL to read it here
+ * @param cache_token Token from buckets_s3_get_object_prepare
+ */
+void buckets_s3_get_object_complete(buckets_s3_request_t *req,
+                                    buckets_s3_response_t *res,
+                                    void *object_data, size_t object_size,
+                                    const buckets_xl_meta_t *meta,
+                                    u64 cache_token);
+
 /**
  * DELETE Object operation
  * 
@@ -783,6 +861,158 @@ bool buckets_s3_is_list_versions_request(buckets_s3_request_t *req);
 int buckets_get_bucket_versioning(const char *bucket, bool *enabled, bool *suspended);
 int buckets_set_bucket_versioning(const char *bucket, bool enabled);
 
+/**
+ * Move the versioning status cache into shared memory
+ *
+ * Call in the master before forking workers so every worker sees status
+ * changes made through the others.
+ *
+ * @return BUCKETS_OK, or BUCKETS_ERR_NOMEM if the segment cannot be mapped
+ */
+int buckets_s3_versioning_cache_share(void);
+
+/* ===================================================================
+ * Per-Tenant QoS
+ *
+ * Request-rate and bandwidth token buckets (see buckets_throttle_t), two
+ * levels deep: one per access key and, under it, one per (access key,
+ * bucket). A request is admitted only if both levels have a request token
+ * and neither is too far behind on bandwidth; otherwise it is refused with
+ * 503 SlowDown. Body and response bytes are charged to both levels and the
+ * connection is paused for the larger debt.
+ *
+ * Limits are per process: with N worker processes each enforces 1/N.
+ *
+ * The access key in a request is only trusted once its signature checks
+ * out. With authentication on, admission charges the client address
+ * ("anonymous@<addr>", at the per-key limits); buckets_s3_qos_authenticate
+ * moves a verified request onto its key and bucket.
+ *
+ * A tenant handle stays valid until buckets_s3_qos_release. Tenants idle
+ * for idle_ms with no requests in flight are evicted when the table fills.
+ * ===================================================================*/
+
+#define BUCKETS_S3_QOS_MAX_TENANTS          4096    /* Keys + (key, bucket) pairs */
+#define BUCKETS_S3_QOS_DEFAULT_MAX_DELAY_MS 2000
+#define BUCKETS_S3_QOS_DEFAULT_IDLE_MS      60000
+#define BUCKETS_S3_QOS_ANONYMOUS            "anonymous"
+
+/**
+ * QoS limits (0 = unlimited)
+ */
+typedef struct {
+    u32 key_rps;               /* Requests/s per access key */
+    u64 key_bps;               /* Bytes/s per access key, in + out */
+    u32 bucket_rps;            /* Requests/s per (access key, bucket) */
+    u64 bucket_bps;            /* Bytes/s per (access key, bucket) */
+    u32 max_delay_ms;          /* Refuse requests once this far behind */
+    u32 idle_ms;               /* Evictable after this long unused */
+} buckets_s3_qos_config_t;
+
+/**
+ * Usage of one tenant since init
+ */
+typedef struct {
+    char access_key[128];
+    char bucket[64];           /* Empty for the access key's totals */
+    u64 requests;              /* Admitted */
+    u64 rejected;              /* Refused with SlowDown */
+    u64 throttled;             /* Charges that paused the connection */
+    u64 bytes_in;
+    u64 bytes_out;
+} buckets_s3_qos_usage_t;
+
+typedef struct buckets_s3_qos_tenant buckets_s3_qos_tenant_t;
+
+/**
+ * Initialize QoS (QoS is off until a limit is set)
+ */
+int buckets_s3_qos_init(const buckets_s3_qos_config_t *config);
+
+/**
+ * Initialize from BUCKETS_QOS_KEY_RPS, BUCKETS_QOS_KEY_MBPS,
+ * BUCKETS_QOS_BUCKET_RPS, BUCKETS_QOS_BUCKET_MBPS, BUCKETS_QOS_MAX_DELAY_MS
+ * and BUCKETS_QOS_IDLE_MS
+ *
+ * @param shares Processes sharing the limits (worker count, or 1)
+ */
+int buckets_s3_qos_init_from_env(u32 shares);
+
+/**
+ * Free all tenants and disable QoS
+ */
+void buckets_s3_qos_cleanup(void);
+
+bool buckets_s3_qos_enabled(void);
+
+/**
+ * Get the tenant of a request
+ *
+ * The access key comes from a V4 or V2 Authorization header or from
+ * presigned query parameters ("anonymous" if unsigned); the bucket is the
+ * first path segment (empty for service and admin requests).
+ *
+ * @param authorization Authorization header or NULL
+ * @param url Request target, path and query
+ */
+void buckets_s3_qos_identify(const char *authorization, const char *url,
+                             char *access_key, size_t access_key_len,
+                             char *bucket, size_t bucket_len);
+
+/**
+ * Get the tenant of a request whose signature has not been checked yet
+ *
+ * @param client_addr Client IP address, or NULL
+ */
+void buckets_s3_qos_identify_client(const char *client_addr,
+                                    char *access_key, size_t access_key_len);
+
+/**
+ * Admit a request, taking a request token from the key and the bucket
+ *
+ * @param access_key Access key
+ * @param bucket Bucket name, or "" for requests without one
+ * @param tenant Output: handle to charge bytes to (NULL if QoS is off),
+ *               released with buckets_s3_qos_release
+ * @return BUCKETS_OK, or BUCKETS_ERR_LIMIT if the request should be refused
+ */
+int buckets_s3_qos_admit(const char *access_key, const char *bucket,
+                         buckets_s3_qos_tenant_t **tenant);
+
+/**
+ * Move a request whose signature verified onto its access key
+ *
+ * Returns the request token taken from the tenant it was admitted under
+ * and admits it again for (access_key, bucket). The caller still releases
+ * `admitted`.
+ *
+ * @param admitted Tenant from admission (may be NULL)
+ * @param tenant Output: the key's tenant, as from buckets_s3_qos_admit
+ * @return BUCKETS_OK, or BUCKETS_ERR_LIMIT if the key is over its limit
+ */
+int buckets_s3_qos_authenticate(buckets_s3_qos_tenant_t *admitted, const char *access_key,
+                                const char *bucket, buckets_s3_qos_tenant_t **tenant);
+
+/**
+ * Drop a request's hold on its tenant
+ */
+void buckets_s3_qos_release(buckets_s3_qos_tenant_t *tenant);
+
+/**
+ * Charge bytes that have moved for a tenant
+ *
+ * @param inbound true for request body bytes, false for response bytes
+ * @return Microseconds the connection should pause (0 = none)
+ */
+u64 buckets_s3_qos_charge(buckets_s3_qos_tenant_t *tenant, size_t bytes, bool inbound);
+
+/**
+ * Copy out per-tenant usage; an access key's totals precede its buckets
+ *
+ * @return Number of entries written
+ */
+size_t buckets_s3_qos_get_usage(buckets_s3_qos_usage_t *usage, size_t max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,117 @@
+/**
+ * Shared-Memory Cache
+ *
+ * Fixed-size key/value cache in an anonymous MAP_SHARED segment, so forked
+ * workers (BUCKETS_WORKERS) share one warm copy of the registry and bucket
+ * metadata caches instead of each filling its own.
+ *
+ * - Create the cache in the master before the workers are forked; every
+ *   worker inherits the same mapping.
+ * - Entries are addressed by offset from the segment base (no pointers), so
+ *   the layout is valid in every process. Keys and values are copied in and
+ *   out; a key or value larger than the configured maximum is not cached.
+ * - The table is set-associative (BUCKETS_SHM_CACHE_WAYS slots per set,
+ *   least recently used slot replaced) with one process-shared mutex per
+ *   stripe of sets. Mutexes are robust: if a worker dies holding one, the
+ *   next locker discards that stripe's entries and carries on.
+ */
+
+#ifndef BUCKETS_SHM_CACHE_H
+#define BUCKETS_SHM_CACHE_H
+
+#include <stdbool.h>
+
+#include "buckets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUCKETS_SHM_CACHE_WAYS     8
+#define BUCKETS_SHM_CACHE_STRIPES  1024
+
+/**
+ * Opaque cache handle (process-local view of the shared segment)
+ */
+typedef struct buckets_shm_cache buckets_shm_cache_t;
+
+/**
+ * Shared-memory cache statistics (shared by all processes)
+ */
+typedef struct {
+    u64 capacity;               /* Slots in the segment */
+    u64 entries;                /* Slots currently in use */
+    u64 hits;
+    u64 misses;
+    u64 evictions;
+    u64 oversized;              /* Puts skipped: key or value too large */
+    u64 recovered;              /* Stripes reset after a holder died */
+    u64 segment_bytes;          /* Size of the mapping */
+} buckets_shm_cache_stats_t;
+
+/**
+ * Check whether BUCKETS_SHARED_CACHE asks for shared caches ("1", "on", "true")
+ */
+bool buckets_shm_cache_requested(void);
+
+/**
+ * Create a shared cache
+ *
+ * @param name Name used in log messages
+ * @param entries Number of slots (rounded up to a whole set)
+ * @param key_max Longest key stored, in bytes
+ * @param value_max Largest value stored, in bytes
+ * @param ttl_seconds Entry lifetime (0 = no expiry)
+ * @return Cache handle, or NULL on error
+ */
+buckets_shm_cache_t* buckets_shm_cache_create(const char *name, u32 entries,
+                                              u32 key_max, u32 value_max,
+                                              u32 ttl_seconds);
+
+/**
+ * Unmap the segment from this process and free the handle
+ */
+void buckets_shm_cache_destroy(buckets_shm_cache_t *cache);
+
+/**
+ * Look up a key
+ *
+ * @param value Output buffer
+ * @param value_size Size of the output buffer
+ * @param value_len Output: bytes copied
+ * @return true on hit
+ */
+bool buckets_shm_cache_get(buckets_shm_cache_t *cache, const char *key,
+                           void *value, u32 value_size, u32 *value_len);
+
+/**
+ * Insert or replace a key
+ *
+ * @return BUCKETS_OK, or BUCKETS_ERR_LIMIT if the key or value is too large
+ */
+int buckets_shm_cache_put(buckets_shm_cache_t *cache, const char *key,
+                          const void *value, u32 value_len);
+
+/**
+ * Remove a key
+ *
+ * @return true if the key was cached
+ */
+bool buckets_shm_cache_invalidate(buckets_shm_cache_t *cache, const char *key);
+
+/**
+ * Remove every entry
+ */
+void buckets_shm_cache_clear(buckets_shm_cache_t *cache);
+
+/**
+ * Get statistics
+ */
+void buckets_shm_cache_get_stats(buckets_shm_cache_t *cache,
+                                 buckets_shm_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUCKETS_SHM_CACHE_H */
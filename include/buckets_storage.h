@@ -17,6 +17,7 @@ extern "C" {
 #include <stdbool.h>
 #include <time.h>
 #include <limits.h>
+#include <sys/types.h>
 
 #include "buckets.h"
 #include "buckets_placement.h"
@@ -92,8 +93,26 @@ typedef struct {
     
     /* Inline data for small objects */
     char *inline_data;                  /* Base64-encoded (optional) */
+    
+    /* Segment layout of very large objects (count = 0: not segmented) */
+    struct {
+        u32 count;                      /* Number of segments */
+        u64 size;                       /* Bytes per segment (last may be shorter) */
+        char *prefix;                   /* System-bucket key prefix of the segments */
+    } segments;
 } buckets_xl_meta_t;
 
+/**
+ * One entry of a batched xl.meta write
+ */
+typedef struct {
+    const char *bucket;         /* Bucket name */
+    const char *object;         /* Object key */
+    const char *disk_path;      /* Disk root path */
+    const char *meta_json;      /* Serialized xl.meta (buckets_xl_meta_to_json) */
+    int result;                 /* Output: 0 on success */
+} buckets_xl_meta_batch_item_t;
+
 /**
  * Storage configuration
  */
@@ -146,6 +165,19 @@ const buckets_storage_config_t* buckets_storage_get_config(void);
 struct buckets_group_commit_context;
 struct buckets_group_commit_context* buckets_storage_get_group_commit_ctx(void);
 
+/**
+ * Recreate the global group commit context with a durability level
+ *
+ * 0 = none (no fsync), 1 = batched (default), 2 = immediate; see
+ * buckets_durability_level_t. Pending writes are flushed first; call only
+ * while no chunk writes are in flight. storage_init honors
+ * BUCKETS_DURABILITY (none|batched|immediate).
+ *
+ * @param durability Durability level
+ * @return 0 on success, -1 on error
+ */
+int buckets_storage_set_durability(int durability);
+
 /**
  * Initialize distributed storage RPC handlers
  * 
@@ -191,6 +223,31 @@ struct buckets_rpc_context* buckets_distributed_storage_get_rpc_context(void);
  */
 int buckets_distributed_set_local_endpoint(const char *node_endpoint);
 
+/**
+ * Map the membership the worker pool shares (call before the fork)
+ * 
+ * No-op with BUCKETS_GOSSIP=off.
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int buckets_distributed_gossip_share(void);
+
+/**
+ * Start gossip membership with the configured cluster nodes
+ * 
+ * Detects failed peers, spreads topology generations and carries cache
+ * invalidations that direct delivery missed. Call after the local endpoint
+ * is set, in each process that serves peer RPCs: with a worker pool, in
+ * every worker after the fork (the gossip threads do not survive it).
+ * After buckets_distributed_gossip_share() only the agent probes; the other
+ * workers answer peers for the node and follow the agent's view.
+ * No-op outside cluster mode or with BUCKETS_GOSSIP=off.
+ * 
+ * @param agent true in the one process per node that runs the protocol
+ * @return 0 on success, error code otherwise
+ */
+int buckets_distributed_gossip_start(bool agent);
+
 /**
  * Extract node endpoint from full disk endpoint
  * 
@@ -211,6 +268,45 @@ int buckets_distributed_extract_node_endpoint(const char *disk_endpoint, char *n
  */
 bool buckets_distributed_is_local_disk(const char *disk_endpoint);
 
+/**
+ * Check whether a placement disk looks usable for a new write
+ * 
+ * Local disks must not be marked offline; remote ones must not be on a
+ * node gossip has declared dead. Unknown disks count as available.
+ * 
+ * @param disk_endpoint Full disk endpoint (NULL or "" = local)
+ * @param disk_path Disk path
+ * @return true if available
+ */
+bool buckets_distributed_disk_available(const char *disk_endpoint, const char *disk_path);
+
+/**
+ * Write many xl.meta files to a remote node in one RPC
+ * 
+ * The peer applies the batch with buckets_write_xl_meta_batch.
+ * 
+ * @param peer_endpoint Remote node endpoint
+ * @param items Entries to write (result set per entry)
+ * @param count Number of entries
+ * @return BUCKETS_OK if the RPC completed (check per-entry results)
+ */
+int buckets_distributed_write_xlmeta_batch(const char *peer_endpoint,
+                                           buckets_xl_meta_batch_item_t *items,
+                                           size_t count);
+
+/**
+ * Tell every other cluster node to drop an object from its hot object cache
+ * 
+ * Best effort with a short timeout, all peers at once; peers that miss the
+ * message get it by gossip when that runs, and the cache TTL bounds
+ * staleness otherwise.
+ * 
+ * @param bucket Bucket name
+ * @param object Object key
+ * @return Number of peers that could not be reached
+ */
+int buckets_distributed_invalidate_object(const char *bucket, const char *object);
+
 /**
  * Write chunk to remote node via RPC
  * 
@@ -291,6 +387,65 @@ int buckets_put_object(const char *bucket, const char *object,
 int buckets_get_object(const char *bucket, const char *object,
                        void **data, size_t *size);
 
+/**
+ * Object read split into stages
+ *
+ * buckets_get_object runs the stages back to back. The event-driven S3
+ * GET/HEAD path runs them as separate steps so no thread waits while
+ * shards are in flight: locate (registry, placement and xl.meta), one
+ * read_shard per shard (independent, may run concurrently on different
+ * indices), then decode.
+ */
+typedef struct {
+    char *bucket;
+    char *object;
+    char object_path[PATH_MAX];
+    buckets_placement_result_t *placement;  /* NULL = single-disk fallback */
+    char **disk_paths;                      /* Borrowed from placement or fallback */
+    int disk_count;
+    buckets_xl_meta_t meta;
+    bool have_meta;
+    u32 k;                                  /* 0 for inline objects */
+    u32 m;
+    void *shards[BUCKETS_MAX_CHUNKS];       /* NULL = not read / unavailable */
+    size_t shard_sizes[BUCKETS_MAX_CHUNKS];
+} buckets_object_read_t;
+
+/**
+ * Find an object and read its xl.meta
+ *
+ * Always release rd with buckets_object_read_free, even on failure.
+ *
+ * @return 0 on success, -1 if the object was not found
+ */
+int buckets_object_read_locate(buckets_object_read_t *rd,
+                               const char *bucket, const char *object);
+
+/**
+ * Read one shard (0-based) of an erasure-coded object
+ *
+ * @return 0 on success, -1 if the shard is unavailable
+ */
+int buckets_object_read_shard(buckets_object_read_t *rd, u32 index);
+
+/**
+ * Number of shards read so far
+ */
+u32 buckets_object_read_shards_available(const buckets_object_read_t *rd);
+
+/**
+ * Reconstruct the object from its inline data or the shards read
+ *
+ * @param data Output buffer (caller must free)
+ * @return 0 on success, -1 if fewer than k shards are available
+ */
+int buckets_object_read_decode(buckets_object_read_t *rd, void **data, size_t *size);
+
+/**
+ * Release a staged read
+ */
+void buckets_object_read_free(buckets_object_read_t *rd);
+
 /**
  * Get storage data directory
  * 
@@ -366,6 +521,179 @@ void buckets_compute_hash_prefix(u64 hash, char *prefix, size_t prefix_len);
  */
 void buckets_compute_object_hash(const char *object_key, char *hash, size_t hash_len);
 
+/* ===== Disk Directory Handles ===== */
+
+/**
+ * Each local disk is opened once as a directory fd, and its 256 hash-prefix
+ * directories (00-ff) are created up front and held open. Object files are
+ * then opened, created, renamed and removed with the *at() syscalls relative
+ * to the prefix fd, so the kernel resolves one or two path components
+ * instead of the whole absolute path, and a PUT creates at most its own
+ * object directory. Object directories are created lazily on ENOENT.
+ *
+ * Disks that cannot be opened (missing root, BUCKETS_DISK_DIRFDS=off) fall
+ * back to the absolute-path code, so callers never need to check.
+ */
+#define BUCKETS_DISK_PREFIX_DIRS    256
+#define BUCKETS_DISK_DIRS_MAX       128
+#define BUCKETS_DISK_DIRS_CHECK_MS  1000    /* Root identity recheck interval */
+
+/**
+ * Open a disk and its prefix directories (idempotent)
+ *
+ * Called for every local disk at multi-disk init; other disks are opened
+ * on first use.
+ *
+ * @return BUCKETS_OK, BUCKETS_ERR_IO if the disk root cannot be opened,
+ *         BUCKETS_ERR_LIMIT if the table is full or handles are disabled
+ */
+int buckets_disk_dirs_open(const char *disk_path);
+
+/**
+ * Close every disk handle (shutdown)
+ */
+void buckets_disk_dirs_close_all(void);
+
+/**
+ * Release a failed disk's handles so it can be unmounted
+ *
+ * I/O on the disk falls back to absolute paths; the handles are reopened
+ * by buckets_disk_dirs_reopen or once the periodic root check finds the
+ * disk back.
+ */
+void buckets_disk_dirs_drop(const char *disk_path);
+
+/**
+ * Reopen a disk's handles (replaced, remounted or healed disk)
+ *
+ * Also done automatically after EIO/ESTALE and when the disk root changes
+ * identity. A disk whose root cannot be opened is dropped.
+ *
+ * @return BUCKETS_OK, BUCKETS_ERR_IO if the root cannot be opened,
+ *         BUCKETS_ERR_LIMIT if handles are disabled or the table is full
+ */
+int buckets_disk_dirs_reopen(const char *disk_path);
+
+/**
+ * Report a failed *at() call on a handle from buckets_disk_object_at
+ *
+ * EIO and ESTALE reopen the disk's handles; other errors are ignored.
+ * errno is preserved.
+ */
+void buckets_disk_dirs_io_error(const char *disk_path, int err);
+
+/**
+ * Resolve an object file to its prefix directory fd and relative name
+ *
+ * @param object_path Object path as from buckets_compute_object_path
+ * @param file File inside the object directory ("xl.meta", "part.3"), or NULL
+ * @param rel Output: path relative to the returned fd
+ * @return Directory fd (owned by the disk table), or -1 to fall back to paths
+ */
+int buckets_disk_object_at(const char *disk_path, const char *object_path,
+                           const char *file, char *rel, size_t rel_len);
+
+/**
+ * Open a file in an object directory
+ *
+ * With O_CREAT the object directory is created if missing.
+ *
+ * @return File descriptor, or -1 with errno set
+ */
+int buckets_disk_openat(const char *disk_path, const char *object_path,
+                        const char *file, int flags, mode_t mode);
+
+/**
+ * Create an object directory (and any missing parents)
+ *
+ * @return 0 on success, -1 on error
+ */
+int buckets_disk_mkdir_object(const char *disk_path, const char *object_path);
+
+/**
+ * Read a whole file of an object directory
+ *
+ * @param data Output buffer (caller must free), NUL-terminated for text
+ * @return BUCKETS_OK or BUCKETS_ERR_IO
+ */
+int buckets_disk_read_file(const char *disk_path, const char *object_path,
+                           const char *file, void **data, size_t *size);
+
+/**
+ * Atomically replace a file of an object directory
+ *
+ * Temp file, fsync, renameat over the target and fsync of the object
+ * directory, like buckets_atomic_write.
+ *
+ * @return BUCKETS_OK or an error code
+ */
+int buckets_disk_write_file(const char *disk_path, const char *object_path,
+                            const char *file, const void *data, size_t size);
+
+/**
+ * Unique temporary name for a file of an object directory
+ *
+ * "<file>.tmp.<pid>.<seq>", so concurrent writers of the same object
+ * (threads, forked workers, entries of one batch) never share a temp file.
+ */
+void buckets_disk_temp_name(char *out, size_t out_len, const char *file);
+
+/**
+ * fsync an object directory, persisting renames into it
+ *
+ * @return 0 on success, -1 on error
+ */
+int buckets_disk_sync_object_dir(const char *disk_path, const char *object_path);
+
+/**
+ * Rename a file within an object directory (e.g. publish xl.meta.tmp)
+ *
+ * @return 0 on success, -1 on error
+ */
+int buckets_disk_rename_file(const char *disk_path, const char *object_path,
+                             const char *from, const char *to);
+
+/**
+ * Remove a file of an object directory
+ *
+ * @return 0 on success, -1 on error
+ */
+int buckets_disk_unlink_file(const char *disk_path, const char *object_path,
+                             const char *file);
+
+/**
+ * Remove an object directory if it is empty
+ *
+ * @return 0 on success, -1 on error (e.g. not empty)
+ */
+int buckets_disk_rmdir_object(const char *disk_path, const char *object_path);
+
+/**
+ * Expected lifetime of a file's data, passed to the kernel as a write
+ * hint (F_SET_RW_HINT) so devices that support placement (NVMe streams,
+ * FDP, zoned) keep short-lived metadata apart from long-lived shards
+ */
+typedef enum {
+    BUCKETS_FILE_LIFE_METADATA = 0,     /* xl.meta and its temp files */
+    BUCKETS_FILE_LIFE_SHARD = 1         /* Shard data, written once */
+} buckets_file_life_t;
+
+/**
+ * Prepare a freshly created file for a write of known size
+ *
+ * Sets the lifetime hint and, for files of at least BUCKETS_PREALLOC_MIN
+ * bytes (default 64 KiB), reserves the whole size with fallocate so the
+ * filesystem can allocate one contiguous extent instead of growing the
+ * file write by write. With keep_size the space is reserved without
+ * changing the file size, for writers that stream and may stop short.
+ *
+ * Best-effort: filesystems without fallocate or kernels without write
+ * hints are silently skipped. BUCKETS_PREALLOC=off and
+ * BUCKETS_WRITE_HINTS=off disable either part.
+ */
+void buckets_disk_prepare_file(int fd, buckets_file_life_t life,
+                               size_t size, bool keep_size);
+
 /* ===== xl.meta Operations ===== */
 
 /**
@@ -390,6 +718,33 @@ int buckets_read_xl_meta(const char *disk_path, const char *object_path,
 int buckets_write_xl_meta(const char *disk_path, const char *object_path,
                           const buckets_xl_meta_t *meta);
 
+/** Largest batch accepted by buckets_write_xl_meta_batch and its RPC */
+#define BUCKETS_XL_META_BATCH_MAX 1024
+
+/**
+ * Write many xl.meta files with one group commit
+ * 
+ * Each file is written to a unique temporary name, all of them are made
+ * durable in a single group-commit flush, then renamed into place and the
+ * object directory is fsynced. Falls back to per-file atomic writes when
+ * group commit is disabled. When several entries target the same file,
+ * only the last one is written; the earlier ones report its result.
+ * 
+ * @param items Entries to write (result set per entry)
+ * @param count Number of entries (at most BUCKETS_XL_META_BATCH_MAX)
+ * @return Number of entries that failed
+ */
+int buckets_write_xl_meta_batch(buckets_xl_meta_batch_item_t *items, size_t count);
+
+/**
+ * Delete an object's xl.meta (log record and/or file)
+ *
+ * @param disk_path Disk root path
+ * @param object_path Object path (relative to disk)
+ * @return 0 if metadata was removed, -1 if there was none or on error
+ */
+int buckets_delete_xl_meta(const char *disk_path, const char *object_path);
+
 /**
  * Free xl.meta resources
  * 
@@ -414,6 +769,104 @@ char* buckets_xl_meta_to_json(const buckets_xl_meta_t *meta);
  */
 int buckets_xl_meta_from_json(const char *json, buckets_xl_meta_t *meta);
 
+/* ===== Metadata Log ===== */
+
+/**
+ * Optional per-disk metadata engine (BUCKETS_META_LOG=on). xl.meta records
+ * of plain object paths go to an append-only log per disk,
+ * <disk>/.buckets.sys/meta.log, indexed in memory by object hash. PUT
+ * commits and deletes are one append plus a group-committed fdatasync
+ * (skipped at durability none); HEAD is an index lookup and one pread.
+ * The log is compacted once it passes BUCKETS_META_LOG_COMPACT_MB
+ * (default 64) and is more than half dead records.
+ *
+ * buckets_read/write_xl_meta, buckets_delete_xl_meta and
+ * buckets_object_exists use the log transparently; xl.meta files written
+ * before it was enabled are still read, and removed on delete. Version
+ * directories, fault injection and disks whose log cannot be opened stay
+ * on files: every call below then returns BUCKETS_ERR_UNSUPPORTED.
+ */
+
+typedef struct {
+    u64 objects;            /* Live keys in the index */
+    u64 live_bytes;         /* Record bytes of live keys */
+    u64 log_bytes;          /* Log file size */
+    u64 appends;            /* Records appended by this process */
+    u64 syncs;              /* fdatasync calls by this process */
+    u64 compactions;
+} buckets_meta_log_stats_t;
+
+/* Callback for buckets_meta_log_foreach; non-zero stops the walk */
+typedef int (*buckets_meta_log_fn)(const char *object_path, const char *json,
+                                   size_t len, void *arg);
+
+bool buckets_meta_log_enabled(void);
+void buckets_meta_log_set_enabled(bool enabled);
+
+/**
+ * Look up an object's xl.meta JSON
+ *
+ * @param json Output NUL-terminated JSON (caller must free)
+ * @return BUCKETS_OK, BUCKETS_ERR_NOT_FOUND (not in the log: check for a
+ *         file), BUCKETS_ERR_UNSUPPORTED, BUCKETS_ERR_CORRUPT or BUCKETS_ERR_IO
+ */
+int buckets_meta_log_get(const char *disk_path, const char *object_path,
+                         char **json, size_t *len);
+
+/**
+ * Whether the log holds a live record for the object
+ */
+bool buckets_meta_log_contains(const char *disk_path, const char *object_path);
+
+/**
+ * Append xl.meta JSON and wait until it is durable
+ *
+ * @return BUCKETS_OK, BUCKETS_ERR_UNSUPPORTED or BUCKETS_ERR_IO
+ */
+int buckets_meta_log_put(const char *disk_path, const char *object_path,
+                         const char *json, size_t len);
+
+/**
+ * Append without waiting; pass the ticket to buckets_meta_log_sync
+ *
+ * Lets a batch append many records and pay for one fdatasync per disk.
+ */
+int buckets_meta_log_append(const char *disk_path, const char *object_path,
+                            const char *json, size_t len, u64 *ticket);
+int buckets_meta_log_sync(const char *disk_path, u64 ticket);
+
+/**
+ * Append a delete record
+ *
+ * @return BUCKETS_OK, BUCKETS_ERR_NOT_FOUND if the log had no record,
+ *         BUCKETS_ERR_UNSUPPORTED or BUCKETS_ERR_IO
+ */
+int buckets_meta_log_delete(const char *disk_path, const char *object_path);
+
+/**
+ * Call fn for every live record of a disk's log (listing, rebuilds)
+ */
+int buckets_meta_log_foreach(const char *disk_path, buckets_meta_log_fn fn, void *arg);
+
+/**
+ * Compact a disk's log now, regardless of the dead-record ratio
+ */
+int buckets_meta_log_compact(const char *disk_path);
+
+int buckets_meta_log_get_stats(const char *disk_path, buckets_meta_log_stats_t *stats);
+
+/**
+ * Close every log (shutdown)
+ */
+void buckets_meta_log_close_all(void);
+
+/**
+ * Drop logs inherited across fork(); workers reopen their own
+ *
+ * flock locks belong to the open file, which the parent still holds.
+ */
+void buckets_meta_log_reinit_after_fork(void);
+
 /* ===== Chunk Operations ===== */
 
 /**
@@ -457,6 +910,38 @@ struct buckets_io_uring_context* buckets_chunk_get_io_uring_ctx(void);
  */
 void buckets_chunk_reinit_after_fork(void);
 
+/**
+ * Chunk write path selection
+ *
+ * AUTO keeps the historical order: io_uring if it initialized, then group
+ * commit, then buckets_atomic_write. The other modes pin one path (falling
+ * through to the next one only if the pinned path is unavailable), which
+ * lets benchmarks and operators compare them on the same hardware.
+ */
+typedef enum {
+    BUCKETS_CHUNK_WRITE_AUTO = 0,       /* io_uring -> group commit -> atomic */
+    BUCKETS_CHUNK_WRITE_IO_URING,       /* io_uring (no fsync) */
+    BUCKETS_CHUNK_WRITE_GROUP_COMMIT,   /* Group commit (durability per storage config) */
+    BUCKETS_CHUNK_WRITE_ATOMIC          /* Temp file + fsync + rename */
+} buckets_chunk_write_mode_t;
+
+/**
+ * Set chunk write path
+ *
+ * Default comes from BUCKETS_CHUNK_WRITE_MODE (auto|io_uring|group_commit|atomic).
+ */
+void buckets_chunk_set_write_mode(buckets_chunk_write_mode_t mode);
+
+/**
+ * Get chunk write path
+ */
+buckets_chunk_write_mode_t buckets_chunk_get_write_mode(void);
+
+/**
+ * Get chunk write mode name ("auto", "io_uring", "group_commit", "atomic")
+ */
+const char* buckets_chunk_write_mode_name(buckets_chunk_write_mode_t mode);
+
 /**
  * Verify chunk checksum
  * 
@@ -763,6 +1248,644 @@ int buckets_metadata_cache_invalidate(const char *bucket, const char *object,
  */
 void buckets_metadata_cache_stats(u64 *hits, u64 *misses, u64 *evictions, u32 *count);
 
+/* ===== Hot Object Cache ===== */
+
+/* Defaults (BUCKETS_OBJECT_CACHE_MB enables; 0/unset = off) */
+#define BUCKETS_OBJECT_CACHE_DEFAULT_MAX_OBJECT_KB 1024
+#define BUCKETS_OBJECT_CACHE_DEFAULT_TTL_SEC       60
+
+/**
+ * Decoded object as served to S3 GET
+ * 
+ * Returned by buckets_object_cache_get (caller frees with
+ * buckets_cached_object_free) and passed to buckets_object_cache_admit.
+ */
+typedef struct {
+    void *data;                     /* Object bytes */
+    size_t size;                    /* Object size */
+    char etag[64];                  /* Stored ETag (served as-is on hit) */
+    char *content_type;             /* Content-Type (NULL = default) */
+    char **user_keys;               /* x-amz-meta-* keys */
+    char **user_values;             /* x-amz-meta-* values */
+    u32 user_count;                 /* Number of user metadata entries */
+} buckets_cached_object_t;
+
+/**
+ * Object cache statistics
+ */
+typedef struct {
+    u64 hits;
+    u64 misses;
+    u64 admissions;                 /* Objects inserted */
+    u64 rejections;                 /* Refused by TinyLFU (colder than victims) */
+    u64 oversized;                  /* Above the per-object size limit */
+    u64 stale_admits;               /* Refused: invalidated while being read */
+    u64 evictions;
+    u64 invalidations;
+    u64 expirations;
+    u64 bytes;                      /* Bytes currently cached */
+    u64 max_bytes;                  /* Memory budget */
+    u32 entries;
+} buckets_object_cache_stats_t;
+
+/**
+ * Initialize the hot object cache
+ * 
+ * Admission uses TinyLFU: a count-min sketch of recent request frequency
+ * decides whether a new object is worth more than the entries it would evict.
+ * 
+ * @param max_bytes Memory budget for cached object data
+ * @param max_object_size Largest object eligible for caching
+ * @param ttl_seconds Safety expiry for missed invalidations (0 = none)
+ * @return BUCKETS_OK on success
+ */
+int buckets_object_cache_init(u64 max_bytes, size_t max_object_size, u32 ttl_seconds);
+
+/**
+ * Initialize from BUCKETS_OBJECT_CACHE_MB, BUCKETS_OBJECT_CACHE_MAX_OBJECT_KB
+ * and BUCKETS_OBJECT_CACHE_TTL_SEC; no-op when the budget is unset or 0
+ */
+int buckets_object_cache_init_from_env(void);
+
+/**
+ * Cleanup object cache
+ */
+void buckets_object_cache_cleanup(void);
+
+/**
+ * Check whether the object cache is enabled
+ */
+bool buckets_object_cache_enabled(void);
+
+/**
+ * Look up an object (records an access for admission either way)
+ * 
+ * @param bucket Bucket name
+ * @param object Object key
+ * @param out Output: copy of the cached object on hit
+ * @param token Output: admission token to pass to buckets_object_cache_admit
+ *              after a miss (optional)
+ * @return 0 on hit, -1 on miss
+ */
+int buckets_object_cache_get(const char *bucket, const char *object,
+                             buckets_cached_object_t *out, u64 *token);
+
+/**
+ * Offer an object read from storage after a miss
+ * 
+ * Refused if the key was invalidated since the token was taken (a PUT or
+ * DELETE raced the read), if it is too large, or if TinyLFU judges it colder
+ * than the entries that would have to be evicted. The object is copied.
+ * 
+ * @return 0 if admitted, -1 otherwise
+ */
+int buckets_object_cache_admit(const char *bucket, const char *object,
+                               const buckets_cached_object_t *obj, u64 token);
+
+/**
+ * Drop an object from this node's cache
+ * 
+ * Also retires it in sibling BUCKETS_WORKERS processes: the per-key epoch
+ * is shared, and their entries admitted under an older epoch are dropped
+ * on their next lookup.
+ */
+void buckets_object_cache_invalidate(const char *bucket, const char *object);
+
+/**
+ * Drop an object from this node's cache and every peer's
+ * 
+ * Call after any PUT/DELETE/version change of the latest object. Also
+ * detaches in-flight coalesced GETs of the object on this node and on
+ * peers; that part is sent whether or not the object cache is enabled.
+ */
+void buckets_object_cache_publish_invalidation(const char *bucket, const char *object);
+
+/**
+ * Free the contents of a cached object copy
+ */
+void buckets_cached_object_free(buckets_cached_object_t *obj);
+
+/**
+ * Get object cache statistics
+ */
+void buckets_object_cache_get_stats(buckets_object_cache_stats_t *stats);
+
+/**
+ * List cached objects, most recently used first
+ * 
+ * @param keys Output array of "bucket/object" keys (caller frees each key
+ *             and the array with buckets_free)
+ * @param count Output number of keys
+ * @param max Maximum number of keys to return
+ * @return BUCKETS_OK on success
+ */
+int buckets_object_cache_keys(char ***keys, u32 *count, u32 max);
+
+/* ===== Startup Timing and Cache Warm-up ===== */
+
+#define BUCKETS_CACHE_SNAPSHOT_DEFAULT_KEYS     10000
+#define BUCKETS_WARMUP_DEFAULT_THREADS          4
+
+/**
+ * Startup timing and warm-up statistics
+ * 
+ * Times are milliseconds since buckets_startup_begin; 0 means "not yet".
+ */
+typedef struct {
+    u64 ready_ms;                   /* Time to ready: serving requests */
+    u64 warm_ms;                    /* Time to warm: snapshot replayed */
+    u32 warm_keys;                  /* Keys replayed from the snapshot */
+    u32 warm_failed;                /* Keys that no longer resolve */
+    u32 saved_keys;                 /* Keys written by the last snapshot save */
+} buckets_startup_stats_t;
+
+/**
+ * Mark process start (call first thing in main)
+ */
+void buckets_startup_begin(void);
+
+/**
+ * Mark the server ready to accept requests; logs the time to ready
+ */
+void buckets_startup_ready(void);
+
+/**
+ * Get startup timing and warm-up statistics
+ */
+void buckets_startup_get_stats(buckets_startup_stats_t *stats);
+
+/**
+ * Cache snapshot file from BUCKETS_CACHE_SNAPSHOT
+ * 
+ * Forked workers each get their own file (path + ".w<worker id>") since
+ * their caches are private. BUCKETS_CACHE_SNAPSHOT_KEYS caps the keys saved
+ * per cache.
+ * 
+ * @return Path, or NULL when snapshots are disabled (the default)
+ */
+const char* buckets_cache_snapshot_path(void);
+
+/**
+ * Save the keys of the registry and object caches (no values)
+ * 
+ * Written atomically, most recently used first.
+ * 
+ * @param path Snapshot file
+ * @return BUCKETS_OK on success
+ */
+int buckets_cache_snapshot_save(const char *path);
+
+/**
+ * Replay a snapshot in the background
+ * 
+ * BUCKETS_WARMUP_THREADS threads (default 4) look up every saved key at
+ * bulk I/O priority: registry keys through buckets_registry_lookup and
+ * object keys through buckets_head_object. Entries are re-read from storage,
+ * never trusted from the file, so a stale snapshot only wastes reads.
+ * 
+ * @param path Snapshot file
+ * @return BUCKETS_OK if started, BUCKETS_ERR_NOT_FOUND if there is no
+ *         snapshot, BUCKETS_ERR_INVALID_ARG if it cannot be parsed
+ */
+int buckets_cache_warmup_start(const char *path);
+
+/**
+ * Wait for a running warm-up to finish
+ */
+void buckets_cache_warmup_wait(void);
+
+/**
+ * Abandon the remaining keys of a running warm-up and wait for its threads
+ */
+void buckets_cache_warmup_stop(void);
+
+/* ===== GET Request Coalescing ===== */
+
+/**
+ * GET coalescing statistics
+ */
+typedef struct {
+    u64 leaders;                    /* Reads actually performed */
+    u64 followers;                  /* Requests served by another's read */
+    u64 detached;                   /* Flights cut off by a PUT/DELETE */
+    u64 bytes_copied;               /* Bytes copied out to coalesced callers */
+    u64 in_flight;                  /* Reads currently in progress */
+} buckets_get_coalesce_stats_t;
+
+/**
+ * Object read performed by the leader of a flight
+ *
+ * @return 0 on success (data is owned by the caller), non-zero on error
+ */
+typedef int (*buckets_get_fetch_fn_t)(void *arg, void **data, size_t *size);
+
+/**
+ * Read settings from BUCKETS_GET_COALESCE ("0"/"off" disables; on by default)
+ */
+void buckets_get_coalesce_init_from_env(void);
+
+/**
+ * Enable or disable GET coalescing
+ */
+void buckets_get_coalesce_set_enabled(bool enabled);
+
+/**
+ * Run fetch once for all concurrent callers with the same key
+ *
+ * The first caller runs fetch; callers with the same (bucket, object,
+ * version) that arrive before it finishes wait and receive the same result
+ * and their own copy of the bytes.
+ *
+ * @param version_id Version ID (NULL = latest)
+ * @return fetch's return code
+ */
+int buckets_get_coalesce_do(const char *bucket, const char *object,
+                            const char *version_id,
+                            buckets_get_fetch_fn_t fetch, void *arg,
+                            void **data, size_t *size);
+
+/**
+ * In-progress read led by a non-blocking caller
+ */
+typedef struct get_flight buckets_get_flight_t;
+
+/**
+ * Delivers a flight's result to a caller that joined without blocking
+ *
+ * Runs on the leader's thread. data is the callee's own copy to free; it
+ * is not charged to the memory budget, which the callee does from its own
+ * request (the leader's charge ends with the leader's request).
+ */
+typedef void (*buckets_get_flight_cb_t)(void *arg, int result, void *data, size_t size);
+
+/**
+ * Non-blocking form of buckets_get_coalesce_do for event-driven callers
+ *
+ * @param flight Set when the caller leads the read; NULL when coalescing
+ *               is disabled (read without landing)
+ * @return 1 if the caller joined a read already in flight (cb will run),
+ *         0 if the caller must read the object itself and then call
+ *         buckets_get_coalesce_land, -1 on invalid arguments
+ */
+int buckets_get_coalesce_join(const char *bucket, const char *object,
+                              const char *version_id,
+                              buckets_get_flight_cb_t cb, void *arg,
+                              buckets_get_flight_t **flight);
+
+/**
+ * Hand a leader's result to everyone who joined its flight
+ *
+ * @param data In: the leader's buffer. Out: the leader's own copy
+ *             (may be NULL when result is non-zero)
+ * @param size In/out: matching size
+ */
+void buckets_get_coalesce_land(buckets_get_flight_t *flight, int result,
+                               void **data, size_t *size);
+
+/**
+ * Coalesced buckets_get_object / buckets_get_object_by_version
+ *
+ * @param version_id Version ID (NULL = latest via buckets_get_object)
+ * @return Same as the underlying read (-2 for a delete marker)
+ */
+int buckets_get_object_coalesced(const char *bucket, const char *object,
+                                 const char *version_id,
+                                 void **data, size_t *size);
+
+/**
+ * Stop new GETs of an object from joining reads already in progress
+ *
+ * Called when the object changes so later readers see the new version.
+ * Reaches sibling BUCKETS_WORKERS processes through a shared epoch table
+ * (set up by buckets_get_coalesce_init_from_env before the fork).
+ */
+void buckets_get_coalesce_forget(const char *bucket, const char *object);
+
+/**
+ * Get GET coalescing statistics
+ */
+void buckets_get_coalesce_get_stats(buckets_get_coalesce_stats_t *stats);
+
+/* ===== Storage Classes ===== */
+
+/*
+ * Objects above the inline threshold are stored either as full copies on
+ * several disks of their set or erasure-coded, chosen per object by size
+ * and bucket policy. The choice is recorded in xl.meta: replicas use
+ * algorithm "Replication" with data = 1 and parity = copies - 1, each part
+ * file holding the whole object, so chunk I/O, write quorum, the heal
+ * queue and deletes treat a replica exactly like a shard.
+ */
+
+#define BUCKETS_ALGO_REED_SOLOMON     "ReedSolomon"
+#define BUCKETS_ALGO_REPLICATION      "Replication"
+#define BUCKETS_REPLICA_MAX_DEFAULT   (4 * 1024 * 1024)  /* Replicate below 4 MB */
+#define BUCKETS_REPLICAS_DEFAULT      3
+
+typedef enum {
+    BUCKETS_STORAGE_CLASS_INLINE,       /* Data inside xl.meta */
+    BUCKETS_STORAGE_CLASS_REPLICATED,   /* Full copies */
+    BUCKETS_STORAGE_CLASS_ERASURE       /* Reed-Solomon K+M */
+} buckets_storage_class_type_t;
+
+/**
+ * Storage policy of a bucket (or the node default)
+ */
+typedef struct {
+    u64 replica_max;                /* Replicate objects below this size (0 = never) */
+    u32 replicas;                   /* Copies of a replicated object */
+    u32 ec_k;                       /* K for erasure coding (0 = storage default) */
+    u32 ec_m;                       /* M for erasure coding */
+} buckets_storage_policy_t;
+
+/**
+ * Storage class chosen for one object
+ */
+typedef struct {
+    buckets_storage_class_type_t type;
+    u32 data;                       /* K, or 1 for replicas */
+    u32 parity;                     /* M, or copies - 1 */
+} buckets_storage_class_t;
+
+/**
+ * Read policies from the environment
+ *
+ * BUCKETS_STORAGE_POLICY sets the default and BUCKETS_BUCKET_STORAGE_POLICY
+ * per-bucket overrides, e.g.
+ *   BUCKETS_STORAGE_POLICY="replicas=3,replica_max=4M,ec=8+4"
+ *   BUCKETS_BUCKET_STORAGE_POLICY="logs:ec=4+2;media:replica_max=0,ec=12+4"
+ * Keys missing from a bucket override are taken from the default.
+ */
+void buckets_storage_policy_init_from_env(void);
+
+/**
+ * Parse a policy string ("replicas=N,replica_max=SIZE,ec=K+M")
+ *
+ * @param policy In: values for keys not in spec. Out: parsed policy
+ * @return BUCKETS_OK, or BUCKETS_ERR_INVALID_ARG (policy unchanged)
+ */
+int buckets_storage_policy_parse(const char *spec, buckets_storage_policy_t *policy);
+
+/**
+ * Set the policy of a bucket
+ *
+ * @param bucket Bucket name (NULL = node default)
+ * @param policy Policy (NULL = drop the bucket's override)
+ * @return BUCKETS_OK, BUCKETS_ERR_INVALID_ARG or BUCKETS_ERR_NOMEM
+ */
+int buckets_storage_policy_set(const char *bucket, const buckets_storage_policy_t *policy);
+
+/**
+ * Get the effective policy of a bucket
+ */
+void buckets_storage_policy_get(const char *bucket, buckets_storage_policy_t *policy);
+
+/**
+ * Choose the storage class of a new object
+ *
+ * Replication is only chosen when the set has a disk for every copy.
+ *
+ * @param bucket Bucket name
+ * @param size Object size
+ * @param set_disks Disks in the object's erasure set (0 if unknown)
+ * @param sc Output class
+ */
+void buckets_storage_class_select(const char *bucket, size_t size, u32 set_disks,
+                                  buckets_storage_class_t *sc);
+
+/**
+ * Check whether xl.meta describes a replicated object
+ */
+bool buckets_xl_meta_is_replicated(const buckets_xl_meta_t *meta);
+
+/**
+ * Placement restricted to the disks holding a replicated object's copies
+ */
+typedef struct {
+    buckets_placement_result_t placement;   /* Disk i holds copy i */
+    char *disk_paths[BUCKETS_MAX_CHUNKS];
+    char *disk_uuids[BUCKETS_MAX_CHUNKS];
+    char *disk_endpoints[BUCKETS_MAX_CHUNKS];
+} buckets_replica_view_t;
+
+/**
+ * Map a replicated object's copies to set disks using erasure.distribution
+ *
+ * The view borrows placement's strings and is valid while placement is.
+ *
+ * @param placement The object's set
+ * @param meta Replicated object's xl.meta
+ * @param view Output
+ * @return 0 on success, -1 on a bad layout
+ */
+int buckets_replica_view(const buckets_placement_result_t *placement,
+                         const buckets_xl_meta_t *meta,
+                         buckets_replica_view_t *view);
+
+/**
+ * Write a replicated object: one full copy per disk, then xl.meta
+ *
+ * Fills in meta's layout. The copies start at a disk chosen by the
+ * object's hash and prefer disks that are online and on live nodes.
+ * xl.meta goes to every disk of the set, replacing any earlier version's.
+ * Returns at write quorum like erasure-coded PUTs.
+ *
+ * @param placement Object placement (must have at least copies disks)
+ * @param meta Object metadata (layout fields are set here)
+ * @return 0 on success, -1 on error
+ */
+int buckets_write_replicas(const char *bucket, const char *object,
+                           const char *object_path,
+                           buckets_placement_result_t *placement,
+                           const void *data, size_t size, u32 copies,
+                           buckets_xl_meta_t *meta);
+
+/**
+ * Take the first intact copy of a replicated object
+ *
+ * Copies of the wrong size or failing their checksum are freed and set
+ * to NULL so the caller can read the others.
+ *
+ * @param copies Copies read so far (NULL = not read); the chosen one
+ *               is handed to the caller
+ * @param sizes Matching sizes
+ * @param count Number of copies (data + parity)
+ * @return 0 on success, -1 if no intact copy was read
+ */
+int buckets_replica_pick(const buckets_xl_meta_t *meta, void **copies,
+                         const size_t *sizes, u32 count,
+                         void **data, size_t *size);
+
+/* ===== Segmented Objects ===== */
+
+/*
+ * Objects above the segment size are split into fixed-size segments, each
+ * stored as an ordinary object "segments/<id>/<index>" in the system
+ * bucket. Every segment is placed on the ring by its own key, so one large
+ * object spreads over all erasure sets instead of pinning one. The
+ * object's xl.meta is a manifest: stat and S3 metadata, the segment layout
+ * and no data of its own (erasure.data = 0).
+ */
+
+#define BUCKETS_SEGMENT_PREFIX          "segments/"
+#define BUCKETS_SEGMENT_PARALLEL_DEFAULT 4
+#define BUCKETS_SEGMENT_GRACE_S_DEFAULT 900     /* Longest expected GET */
+
+/**
+ * Segmentation settings
+ */
+typedef struct {
+    u64 segment_size;               /* Split objects larger than this (0 = off) */
+    u32 parallel;                   /* Segments in flight per object */
+    u32 grace_ms;                   /* Keep replaced segments this long (0 = none) */
+} buckets_segment_config_t;
+
+/** Left in the data directory once segmentation has been enabled */
+#define BUCKETS_SEGMENT_MARKER ".buckets.sys/segments"
+
+/**
+ * Read BUCKETS_SEGMENT_MB (off by default), BUCKETS_SEGMENT_PARALLEL and
+ * BUCKETS_SEGMENT_GRACE_S
+ *
+ * Safe to call more than once; the other calls initialize on first use.
+ */
+void buckets_segments_init_from_env(void);
+
+/**
+ * Attach the data directory that records whether segmentation was ever on
+ *
+ * Leaves BUCKETS_SEGMENT_MARKER there while segmentation is enabled; with
+ * it off, an existing marker keeps replaced segments being looked for.
+ */
+void buckets_segments_open(const char *data_dir);
+
+/**
+ * Whether segmented objects may exist: segmentation is on now, or was
+ * when the data directory was last used
+ */
+bool buckets_segments_may_exist(void);
+
+/**
+ * Replace the segmentation settings
+ *
+ * Objects already written keep their layout; reads of segmented objects
+ * work whether or not segmentation is enabled.
+ */
+void buckets_segments_configure(const buckets_segment_config_t *config);
+
+/**
+ * Get the segmentation settings
+ */
+void buckets_segments_get_config(buckets_segment_config_t *config);
+
+/**
+ * Check whether a new object is written as segments
+ *
+ * System buckets are never segmented.
+ */
+bool buckets_segments_should_split(const char *bucket, size_t size);
+
+/**
+ * Check whether xl.meta is the manifest of a segmented object
+ */
+bool buckets_xl_meta_is_segmented(const buckets_xl_meta_t *meta);
+
+/**
+ * System-bucket key of one segment ("<prefix>/<index>")
+ */
+void buckets_segment_key(const char *prefix, u32 index, char *key, size_t size);
+
+/**
+ * Write a segmented object: the segments in parallel, then the manifest
+ *
+ * Fills in meta's segment layout. On failure the segments written so far
+ * are removed; on success they are queued for the grace-period check in
+ * case a concurrent overwrite's manifest replaced this one. Reclaiming the
+ * replaced version is up to the caller (buckets_segments_defer_reclaim).
+ *
+ * @param placement Object placement (NULL = manifest on disk_path only)
+ * @param disk_path Disk for the manifest without placement
+ * @param meta Object metadata (segment fields are set here)
+ * @return 0 on success, -1 on error
+ */
+int buckets_write_segments(const char *bucket, const char *object,
+                           const char *object_path,
+                           buckets_placement_result_t *placement,
+                           const char *disk_path,
+                           const void *data, size_t size,
+                           buckets_xl_meta_t *meta);
+
+/**
+ * Read all segments of a manifest in parallel into one buffer
+ *
+ * @param data Output buffer of meta->stat.size bytes (caller frees)
+ * @param size Output size
+ * @return 0 on success, -1 if any segment is missing or the wrong size
+ */
+int buckets_read_segments(const buckets_xl_meta_t *meta, void **data, size_t *size);
+
+/**
+ * Delete all segments of a manifest (idempotent)
+ */
+int buckets_delete_segments(const buckets_xl_meta_t *meta);
+
+/**
+ * Read the manifest of a segmented object from its set
+ *
+ * Tries local disks first, then peers over RPC.
+ *
+ * @param placement Object placement (NULL = disk_path only)
+ * @param meta Output manifest (caller frees)
+ * @return 0 if a segmented manifest was found, -1 otherwise
+ */
+int buckets_segments_read_manifest(const char *bucket, const char *object,
+                                   const char *object_path,
+                                   buckets_placement_result_t *placement,
+                                   const char *disk_path,
+                                   buckets_xl_meta_t *meta);
+
+/**
+ * Find the segmented manifest of an object about to be overwritten or
+ * deleted
+ *
+ * Reads xl.meta across the object's set, so it answers false without a
+ * lookup unless buckets_segments_may_exist().
+ *
+ * @param meta Output manifest (caller frees)
+ * @return true if the object's xl.meta lists segments
+ */
+bool buckets_segments_find_manifest(const char *bucket, const char *object,
+                                    buckets_xl_meta_t *meta);
+
+/**
+ * Reclaim a manifest's segments after the grace period
+ *
+ * Once the grace period (buckets_segment_config_t.grace_ms) is over the
+ * segments are deleted unless the object's current manifest names them.
+ * With no grace period this happens now.
+ */
+void buckets_segments_defer_reclaim(const char *bucket, const char *object,
+                                    const buckets_xl_meta_t *manifest);
+
+/**
+ * Reclaim queued segments whose grace period is over (or all of them)
+ *
+ * Runs on a background thread; exposed for shutdown and tests.
+ *
+ * @return Manifests whose segments were deleted
+ */
+u32 buckets_segments_reap(bool all);
+
+/**
+ * Stop the reclaim thread and reclaim everything still queued
+ */
+void buckets_segments_cleanup(void);
+
+/**
+ * Reset the reclaim queue in a forked worker (the parent reclaims its own)
+ */
+void buckets_segments_reinit_after_fork(void);
+
 /* ===== Multi-Disk Management (Week 14-16) ===== */
 
 /**
@@ -825,6 +1948,14 @@ int buckets_multidisk_write_xl_meta(int set_index, const char *object_path,
  */
 int buckets_multidisk_get_online_count(int set_index);
 
+/**
+ * Check whether a local disk is online
+ * 
+ * @param disk_path Disk path
+ * @return false only for a known disk marked offline
+ */
+bool buckets_multidisk_disk_online(const char *disk_path);
+
 /**
  * Mark disk as offline (failure detection)
  * 
@@ -834,6 +1965,15 @@ int buckets_multidisk_get_online_count(int set_index);
  */
 int buckets_multidisk_mark_offline(int set_index, int disk_index);
 
+/**
+ * Mark disk as online again and reopen its directory handles
+ * 
+ * @param set_index Set index
+ * @param disk_index Disk index within set
+ * @return 0 on success, -1 on error
+ */
+int buckets_multidisk_mark_online(int set_index, int disk_index);
+
 /**
  * Get cluster statistics
  * 
@@ -923,6 +2063,18 @@ int buckets_parallel_write_chunks(const char *bucket,
                                    size_t chunk_size,
                                    u32 num_chunks);
 
+/**
+ * Read one chunk from the disk placement assigns it (local or remote)
+ *
+ * @param index Chunk index (0-based)
+ * @param data Output buffer (caller must free)
+ * @return 0 on success, -1 on error
+ */
+int buckets_read_placed_chunk(const char *bucket, const char *object,
+                              const char *object_path,
+                              buckets_placement_result_t *placement,
+                              u32 index, void **data, size_t *size);
+
 /**
  * Write multiple chunks in parallel with automatic batching (OPTIMIZED)
  * 
@@ -974,6 +2126,178 @@ int buckets_parallel_write_metadata(const char *bucket,
                                      u32 num_disks,
                                      bool has_endpoints);
 
+/* ===================================================================
+ * Write Quorum
+ *
+ * A PUT is durable once a write quorum of shards and xl.meta copies has
+ * landed; it does not need to wait for the slowest of the K+M writes.
+ * The quorum variants below return as soon as the quorum is reached (or
+ * can no longer be reached). Remaining writes finish in the background
+ * on private copies of their data, and shards that fail after a committed
+ * write are handed to the heal queue for retry. Heal attempts first check
+ * that a committed copy still carries the version they repair.
+ *
+ * Policy comes from BUCKETS_WRITE_QUORUM: "k", "k+1", "all" (default), or
+ * an explicit shard count. Anything below "all" lets a straggler that is
+ * already in flight land after a newer PUT or DELETE of the same key.
+ * ===================================================================*/
+
+/**
+ * Write quorum for a K+M erasure set under the configured policy
+ *
+ * @param data_shards K
+ * @param parity_shards M
+ * @return Quorum in [K, K+M]
+ */
+u32 buckets_write_quorum(u32 data_shards, u32 parity_shards);
+
+/**
+ * Write quorum statistics
+ */
+typedef struct {
+    u64 writes;                 /* Quorum writes (chunk and xl.meta fan-outs) */
+    u64 early_acks;             /* Writes acknowledged before every shard finished */
+    u64 quorum_failures;        /* Writes that could not reach quorum */
+    u64 stragglers;             /* Shards that finished after the acknowledgement */
+    u64 straggler_failures;     /* ... of which failed */
+    u64 heal_queued;            /* Failed shards handed to the heal queue */
+    u64 heal_repaired;          /* Heal queue entries written successfully */
+    u64 heal_failed;            /* Heal queue entries abandoned after retries */
+    u64 heal_superseded;        /* Entries dropped: a newer write or a delete won */
+    u64 heal_dropped;           /* Entries rejected because the queue was full */
+    u64 heal_pending;           /* Entries currently queued */
+} buckets_write_quorum_stats_t;
+
+/**
+ * Get write quorum statistics
+ */
+void buckets_write_quorum_get_stats(buckets_write_quorum_stats_t *stats);
+
+/**
+ * Quorum tracker (opaque)
+ *
+ * Shared by a waiter and the workers of one fan-out. Each worker reports
+ * once with buckets_quorum_tracker_done; the waiter blocks in
+ * buckets_quorum_tracker_wait. Whoever drops the last reference calls
+ * finish(owner, committed) after every worker has reported.
+ */
+typedef struct buckets_quorum_tracker buckets_quorum_tracker_t;
+
+/**
+ * Create a quorum tracker
+ *
+ * @param total Total shards in the fan-out
+ * @param quorum Shards needed to commit
+ * @param workers Number of buckets_quorum_tracker_done calls to expect
+ * @param finish Called once all workers reported and the waiter returned
+ * @param owner Argument passed to finish
+ * @return Tracker, or NULL on allocation failure
+ */
+buckets_quorum_tracker_t* buckets_quorum_tracker_create(u32 total, u32 quorum, u32 workers,
+                                                        void (*finish)(void *owner, bool committed),
+                                                        void *owner);
+
+/**
+ * Report a worker's result (drops the worker's reference)
+ *
+ * @param tracker Tracker
+ * @param ok_shards Shards written successfully
+ * @param failed_shards Shards that failed
+ * @param account Worker's syscall/allocation account (charged to the
+ *                request only if it finished before the acknowledgement)
+ */
+void buckets_quorum_tracker_done(buckets_quorum_tracker_t *tracker, u32 ok_shards,
+                                 u32 failed_shards, const buckets_account_t *account);
+
+/**
+ * Wait until quorum is reached or lost (drops the waiter's reference)
+ *
+ * @return 0 if quorum was reached, -1 otherwise
+ */
+int buckets_quorum_tracker_wait(buckets_quorum_tracker_t *tracker);
+
+/**
+ * Batched parallel chunk write that returns at write quorum
+ *
+ * Same as buckets_batched_parallel_write_chunks, but returns once
+ * write_quorum shards are durable. With write_quorum >= num_chunks this
+ * is exactly buckets_batched_parallel_write_chunks. meta is the xl.meta the
+ * shards will be committed under; heals of failed shards check against it.
+ *
+ * @return 0 if write_quorum shards were written, -1 otherwise
+ */
+int buckets_batched_parallel_write_chunks_quorum(const char *bucket,
+                                                 const char *object,
+                                                 const char *object_path,
+                                                 buckets_placement_result_t *placement,
+                                                 const void **chunk_data_array,
+                                                 size_t chunk_size,
+                                                 u32 num_chunks,
+                                                 u32 write_quorum,
+                                                 const buckets_xl_meta_t *meta);
+
+/**
+ * Parallel xl.meta write that returns at write quorum
+ *
+ * Same as buckets_parallel_write_metadata, but returns once write_quorum
+ * copies are durable.
+ *
+ * @return 0 if write_quorum copies were written, -1 otherwise
+ */
+int buckets_parallel_write_metadata_quorum(const char *bucket,
+                                           const char *object,
+                                           const char *object_path,
+                                           buckets_placement_result_t *placement,
+                                           char **disk_paths,
+                                           const buckets_xl_meta_t *base_meta,
+                                           u32 num_disks,
+                                           bool has_endpoints,
+                                           u32 write_quorum);
+
+/**
+ * Disk holding a committed copy of the write being healed
+ *
+ * Before each attempt the heal queue reads xl.meta there. The entry is
+ * written only if that copy has the same modTime and ETag; it is dropped
+ * once a different version shows up, and retried while none is visible.
+ */
+typedef struct {
+    const char *disk_path;      /* Disk path (local or on the remote node) */
+    const char *node_endpoint;  /* Remote node endpoint, or NULL for a local disk */
+} buckets_heal_ref_t;
+
+/**
+ * Queue a failed shard write for background retry
+ *
+ * @param bucket Bucket name
+ * @param object Object key
+ * @param object_path Hashed object path
+ * @param chunk_index Chunk index (1-based)
+ * @param disk_path Disk path (local or on the remote node)
+ * @param node_endpoint Remote node endpoint, or NULL for a local disk
+ * @param data Chunk data (copied)
+ * @param size Chunk size
+ * @param meta xl.meta of the write the shard belongs to (version check)
+ * @param ref Committed copy to check against (NULL: check the target only)
+ * @return 0 if queued, -1 if the queue is full
+ */
+int buckets_heal_queue_shard(const char *bucket, const char *object, const char *object_path,
+                             u32 chunk_index, const char *disk_path, const char *node_endpoint,
+                             const void *data, size_t size, const buckets_xl_meta_t *meta,
+                             const buckets_heal_ref_t *ref);
+
+/**
+ * Queue a failed xl.meta write for background retry
+ *
+ * @param meta Metadata to write (copied)
+ * @param ref Committed copy to check against (NULL: skip only if the
+ *            target already holds a newer version)
+ * @return 0 if queued, -1 if the queue is full
+ */
+int buckets_heal_queue_xl_meta(const char *bucket, const char *object, const char *object_path,
+                               const char *disk_path, const char *node_endpoint,
+                               const buckets_xl_meta_t *meta, const buckets_heal_ref_t *ref);
+
 /* ===================================================================
  * Binary Chunk Transport
  * 
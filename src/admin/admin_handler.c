@@ -0,0 +1,178 @@
+/**
+ * Admin Endpoints
+ *
+ * Operator endpoints under /_admin/, reached through the S3 handler after
+ * signature verification:
+ *
+ *   GET /_admin/profile/cpu?seconds=N&hz=H
+ *       Sample the process for N seconds (default 10) at H Hz (default 99)
+ *       and return folded stacks as text/plain. Disabled unless
+ *       BUCKETS_CPUPROF=1; returns 409 if a profile is already running.
+ *
+ *   GET /_admin/qos
+ *       Per-tenant QoS usage of this process as JSON: admitted, refused
+ *       and paced requests and bytes in and out, per access key and per
+ *       (access key, bucket). 404 unless a BUCKETS_QOS_* limit is set.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+#include "buckets_cpuprof.h"
+#include "buckets_s3.h"
+#include "cJSON.h"
+
+#define ADMIN_PROFILE_DEFAULT_SECONDS 10
+
+static bool cpuprof_enabled(void)
+{
+    const char *env = getenv("BUCKETS_CPUPROF");
+    return env && (strcmp(env, "1") == 0 || strcmp(env, "true") == 0);
+}
+
+/**
+ * Get an unsigned query parameter, or def if absent/invalid
+ */
+static u32 query_u32(const char *query, const char *key, u32 def)
+{
+    if (!query) {
+        return def;
+    }
+    if (query[0] == '?') {
+        query++;
+    }
+
+    size_t key_len = strlen(key);
+    const char *p = query;
+    while (*p) {
+        if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            char *end = NULL;
+            unsigned long v = strtoul(p + key_len + 1, &end, 10);
+            if (end == p + key_len + 1) {
+                return def;
+            }
+            return v > UINT32_MAX ? UINT32_MAX : (u32)v;
+        }
+        p = strchr(p, '&');
+        if (!p) {
+            break;
+        }
+        p++;
+    }
+    return def;
+}
+
+static void handle_profile_cpu(buckets_http_request_t *req, buckets_http_response_t *res)
+{
+    if (!cpuprof_enabled()) {
+        buckets_http_response_error(res, 404, "CPU profiler disabled (set BUCKETS_CPUPROF=1)");
+        return;
+    }
+
+    u32 seconds = query_u32(req->query_string, "seconds", ADMIN_PROFILE_DEFAULT_SECONDS);
+    u32 hz = query_u32(req->query_string, "hz", BUCKETS_CPUPROF_DEFAULT_HZ);
+    if (seconds == 0 || seconds > BUCKETS_CPUPROF_MAX_SECONDS ||
+        hz == 0 || hz > BUCKETS_CPUPROF_MAX_HZ) {
+        buckets_http_response_error(res, 400, "Invalid seconds or hz");
+        return;
+    }
+
+    buckets_cpuprof_result_t result;
+    int ret = buckets_cpuprof_collect(seconds * 1000, hz, &result);
+    if (ret == BUCKETS_ERR_LIMIT) {
+        buckets_http_response_error(res, 409, "A profile is already running");
+        return;
+    }
+    if (ret != BUCKETS_OK) {
+        buckets_http_response_error(res, 500, "Profiling failed");
+        return;
+    }
+
+    char value[32];
+    res->status_code = 200;
+    buckets_http_response_set_header(res, "Content-Type", "text/plain");
+    snprintf(value, sizeof(value), "%lu", result.samples);
+    buckets_http_response_set_header(res, "X-Profile-Samples", value);
+    snprintf(value, sizeof(value), "%lu", result.dropped);
+    buckets_http_response_set_header(res, "X-Profile-Dropped", value);
+    snprintf(value, sizeof(value), "%u", result.hz);
+    buckets_http_response_set_header(res, "X-Profile-Hz", value);
+
+    /* Hand the folded buffer to the response; it is freed after sending */
+    res->body = result.folded;
+    res->body_len = result.folded_len;
+    result.folded = NULL;
+    buckets_cpuprof_result_free(&result);
+}
+
+static void handle_qos(buckets_http_response_t *res)
+{
+    if (!buckets_s3_qos_enabled()) {
+        buckets_http_response_error(res, 404, "Tenant QoS disabled (set BUCKETS_QOS_* limits)");
+        return;
+    }
+
+    buckets_s3_qos_usage_t *usage = buckets_calloc(BUCKETS_S3_QOS_MAX_TENANTS + 1,
+                                                   sizeof(*usage));
+    if (!usage) {
+        buckets_http_response_error(res, 500, "Out of memory");
+        return;
+    }
+    size_t count = buckets_s3_qos_get_usage(usage, BUCKETS_S3_QOS_MAX_TENANTS + 1);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *tenants = cJSON_AddArrayToObject(root, "tenants");
+    for (size_t i = 0; i < count; i++) {
+        cJSON *t = cJSON_CreateObject();
+        cJSON_AddStringToObject(t, "accessKey", usage[i].access_key);
+        if (usage[i].bucket[0]) {
+            cJSON_AddStringToObject(t, "bucket", usage[i].bucket);
+        }
+        cJSON_AddNumberToObject(t, "requests", (double)usage[i].requests);
+        cJSON_AddNumberToObject(t, "rejected", (double)usage[i].rejected);
+        cJSON_AddNumberToObject(t, "throttled", (double)usage[i].throttled);
+        cJSON_AddNumberToObject(t, "bytesIn", (double)usage[i].bytes_in);
+        cJSON_AddNumberToObject(t, "bytesOut", (double)usage[i].bytes_out);
+        cJSON_AddItemToArray(tenants, t);
+    }
+    buckets_free(usage);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) {
+        buckets_http_response_error(res, 500, "Out of memory");
+        return;
+    }
+
+    res->status_code = 200;
+    buckets_http_response_set_header(res, "Content-Type", "application/json");
+    res->body = buckets_strdup(json);
+    res->body_len = strlen(json);
+    cJSON_free(json);
+}
+
+void buckets_admin_http_handler(buckets_http_request_t *req, buckets_http_response_t *res)
+{
+    /* uri carries the query string; match on the path only */
+    const char *path = req->uri;
+    size_t path_len = strcspn(path, "?");
+
+    if (strcmp(req->method, "GET") == 0 &&
+        path_len == strlen("/_admin/profile/cpu") &&
+        strncmp(path, "/_admin/profile/cpu", path_len) == 0) {
+        handle_profile_cpu(req, res);
+        return;
+    }
+
+    if (strcmp(req->method, "GET") == 0 &&
+        path_len == strlen("/_admin/qos") &&
+        strncmp(path, "/_admin/qos", path_len) == 0) {
+        handle_qos(res);
+        return;
+    }
+
+    buckets_http_response_error(res, 404, "Unknown admin endpoint");
+}
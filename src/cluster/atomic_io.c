@@ -16,6 +16,7 @@
 
 #include "buckets.h"
 #include "buckets_io.h"
+#include "buckets_fault.h"
 
 int buckets_atomic_write(const char *path, const void *data, size_t size)
 {
@@ -23,6 +24,10 @@ int buckets_atomic_write(const char *path, const void *data, size_t size)
         return BUCKETS_ERR_INVALID_ARG;
     }
     
+    if (buckets_fault_disk_io(path) != BUCKETS_OK) {
+        return BUCKETS_ERR_IO;
+    }
+    
     /* Create temp file path: <path>.tmp.<pid> */
     char *temp_path = buckets_format("%s.tmp.%d", path, getpid());
     if (!temp_path) {
@@ -44,6 +49,7 @@ int buckets_atomic_write(const char *path, const void *data, size_t size)
     }
     
     /* Write to temp file */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
     FILE *fp = fopen(temp_path, "wb");
     if (!fp) {
         buckets_error("Failed to create temp file %s: %s", temp_path, strerror(errno));
@@ -60,7 +66,8 @@ int buckets_atomic_write(const char *path, const void *data, size_t size)
         return BUCKETS_ERR_IO;
     }
     
-    /* Flush and sync to disk */
+    /* Flush and sync to disk (stdio issues the write on flush) */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
     if (fflush(fp) != 0) {
         buckets_error("Failed to flush %s: %s", temp_path, strerror(errno));
         fclose(fp);
@@ -70,6 +77,7 @@ int buckets_atomic_write(const char *path, const void *data, size_t size)
     }
     
     int fd = fileno(fp);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
     if (fsync(fd) != 0) {
         buckets_error("Failed to sync %s: %s", temp_path, strerror(errno));
         fclose(fp);
@@ -78,9 +86,11 @@ int buckets_atomic_write(const char *path, const void *data, size_t size)
         return BUCKETS_ERR_IO;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
     fclose(fp);
     
     /* Atomic rename */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RENAME);
     if (rename(temp_path, path) != 0) {
         buckets_error("Failed to rename %s to %s: %s", temp_path, path, strerror(errno));
         unlink(temp_path);
@@ -106,7 +116,12 @@ int buckets_atomic_read(const char *path, void **data_out, size_t *size_out)
     *data_out = NULL;
     *size_out = 0;
     
+    if (buckets_fault_disk_io(path) != BUCKETS_OK) {
+        return BUCKETS_ERR_IO;
+    }
+    
     /* Open file */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
     FILE *fp = fopen(path, "rb");
     if (!fp) {
         buckets_error("Failed to open %s: %s", path, strerror(errno));
@@ -136,7 +151,11 @@ int buckets_atomic_read(const char *path, void **data_out, size_t *size_out)
     /* Allocate buffer */
     void *data = buckets_malloc(file_size + 1);  /* +1 for null terminator */
     
-    /* Read entire file */
+    /* Read entire file (fstat from stdio buffering, data read, EOF read) */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (buckets_account_enabled()) {
+        buckets_account_record(BUCKETS_SYS_READ, 2);
+    }
     size_t read_bytes = fread(data, 1, file_size, fp);
     if (read_bytes != (size_t)file_size) {
         buckets_error("Failed to read %ld bytes from %s: %s", file_size, path, strerror(errno));
@@ -145,6 +164,7 @@ int buckets_atomic_read(const char *path, void **data_out, size_t *size_out)
         return BUCKETS_ERR_IO;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
     fclose(fp);
     
     /* Null-terminate for convenience (if data is text) */
@@ -164,6 +184,7 @@ int buckets_ensure_directory(const char *path)
     
     /* Check if directory exists */
     struct stat st;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
     if (stat(path, &st) == 0) {
         if (S_ISDIR(st.st_mode)) {
             return BUCKETS_OK;  /* Already exists */
@@ -188,6 +209,7 @@ int buckets_ensure_directory(const char *path)
     buckets_free(path_copy);
     
     /* Create directory with rwx for owner, rx for group/others */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_MKDIR);
     if (mkdir(path, 0755) != 0) {
         if (errno != EEXIST) {
             buckets_error("Failed to create directory %s: %s", path, strerror(errno));
@@ -204,18 +226,21 @@ int buckets_sync_directory(const char *path)
         return BUCKETS_ERR_INVALID_ARG;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
     int fd = open(path, O_RDONLY | O_DIRECTORY);
     if (fd < 0) {
         buckets_error("Failed to open directory %s: %s", path, strerror(errno));
         return BUCKETS_ERR_IO;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
     if (fsync(fd) != 0) {
         buckets_error("Failed to sync directory %s: %s", path, strerror(errno));
         close(fd);
         return BUCKETS_ERR_IO;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
     close(fd);
     return BUCKETS_OK;
 }
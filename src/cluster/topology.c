@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "buckets.h"
 #include "buckets_cluster.h"
@@ -532,6 +533,78 @@ int buckets_topology_mark_set_removed(buckets_cluster_topology_t *topology,
  * - Automatic healing: stale disks are updated to match quorum
  */
 
+/* Per-disk result of the parallel read phase of buckets_topology_load_quorum */
+typedef struct {
+    buckets_cluster_topology_t *topology;
+    u64 hash;
+} topology_read_t;
+
+/* One quorum operation spread over disks; saves when topology is set,
+ * otherwise loads into reads */
+typedef struct {
+    char **disk_paths;
+    int disk_count;
+    buckets_cluster_topology_t *topology;
+    topology_read_t *reads;
+    int *results;
+} topology_disk_job_t;
+
+#define TOPOLOGY_DISK_MAX_THREADS 16
+
+/* Load, serialize and hash one disk's topology; leaves topology NULL on failure */
+static void topology_read_one(char *disk_path, topology_read_t *read)
+{
+    buckets_cluster_topology_t *topo = buckets_topology_load(disk_path);
+    if (!topo) {
+        buckets_warn("Failed to load topology from: %s", disk_path);
+        return;
+    }
+    
+    /* Serialize to JSON for hashing */
+    cJSON *json = topology_to_json(topo);
+    if (!json) {
+        buckets_warn("Failed to serialize topology from: %s", disk_path);
+        buckets_topology_free(topo);
+        return;
+    }
+    
+    char *json_str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    
+    if (!json_str) {
+        buckets_topology_free(topo);
+        return;
+    }
+    
+    /* Compute hash of JSON content */
+    read->hash = buckets_xxhash64(0, json_str, strlen(json_str));
+    read->topology = topo;
+    buckets_free(json_str);
+}
+
+static int topology_disk_worker(void *arg, int i)
+{
+    topology_disk_job_t *job = (topology_disk_job_t*)arg;
+    
+    if (!job->disk_paths[i]) {
+        return 0;
+    }
+    if (job->topology) {
+        job->results[i] = buckets_topology_save(job->disk_paths[i], job->topology);
+    } else {
+        topology_read_one(job->disk_paths[i], &job->reads[i]);
+    }
+    return 0;
+}
+
+/* Run the job on up to TOPOLOGY_DISK_MAX_THREADS threads, the caller being
+ * one of them; a cold start otherwise pays one disk round-trip per drive */
+static void topology_disk_job_run(topology_disk_job_t *job)
+{
+    buckets_parallel_for(job->disk_count, TOPOLOGY_DISK_MAX_THREADS,
+                         topology_disk_worker, job);
+}
+
 int buckets_topology_save_quorum(char **disk_paths, int disk_count,
                                   buckets_cluster_topology_t *topology)
 {
@@ -544,14 +617,23 @@ int buckets_topology_save_quorum(char **disk_paths, int disk_count,
     
     buckets_debug("Writing topology to %d disks (quorum=%d)", disk_count, required_quorum);
     
-    /* Write to all disks in parallel (conceptually) */
+    /* Write to all disks in parallel */
+    int *results = buckets_calloc(disk_count, sizeof(int));
+    topology_disk_job_t job = {
+        .disk_paths = disk_paths,
+        .disk_count = disk_count,
+        .topology = topology,
+        .results = results
+    };
+    topology_disk_job_run(&job);
+    
     for (int i = 0; i < disk_count; i++) {
         if (!disk_paths[i]) {
             buckets_warn("Disk path %d is NULL, skipping", i);
             continue;
         }
         
-        int ret = buckets_topology_save(disk_paths[i], topology);
+        int ret = results[i];
         if (ret == BUCKETS_OK) {
             success_count++;
             buckets_debug("Topology write succeeded: %s (%d/%d)",
@@ -562,6 +644,8 @@ int buckets_topology_save_quorum(char **disk_paths, int disk_count,
         }
     }
     
+    buckets_free(results);
+    
     /* Check if quorum achieved */
     if (success_count >= required_quorum) {
         buckets_info("Topology write quorum achieved: %d/%d (need %d)",
@@ -574,6 +658,15 @@ int buckets_topology_save_quorum(char **disk_paths, int disk_count,
     return BUCKETS_ERR_QUORUM;
 }
 
+/* Free reads the vote did not consume (disks after the quorum was reached) */
+static void topology_reads_free(topology_read_t *reads, int count)
+{
+    for (int i = 0; i < count; i++) {
+        buckets_topology_free(reads[i].topology);
+    }
+    buckets_free(reads);
+}
+
 buckets_cluster_topology_t* buckets_topology_load_quorum(char **disk_paths,
                                                           int disk_count)
 {
@@ -597,38 +690,28 @@ buckets_cluster_topology_t* buckets_topology_load_quorum(char **disk_paths,
     vote_entry_t *votes = NULL;
     int vote_count = 0;
     
-    /* Read from all disks */
+    /* Read all disks concurrently */
+    topology_read_t *reads = buckets_calloc(disk_count, sizeof(topology_read_t));
+    topology_disk_job_t job = {
+        .disk_paths = disk_paths,
+        .disk_count = disk_count,
+        .reads = reads
+    };
+    topology_disk_job_run(&job);
+    
+    /* Tally votes in disk order so the winner matches a sequential read */
     for (int i = 0; i < disk_count; i++) {
         if (!disk_paths[i]) {
             buckets_warn("Disk path %d is NULL, skipping", i);
             continue;
         }
         
-        buckets_cluster_topology_t *topo = buckets_topology_load(disk_paths[i]);
+        buckets_cluster_topology_t *topo = reads[i].topology;
         if (!topo) {
-            buckets_warn("Failed to load topology from: %s", disk_paths[i]);
-            continue;
-        }
-        
-        /* Serialize to JSON for hashing */
-        cJSON *json = topology_to_json(topo);
-        if (!json) {
-            buckets_warn("Failed to serialize topology from: %s", disk_paths[i]);
-            buckets_topology_free(topo);
             continue;
         }
-        
-        char *json_str = cJSON_PrintUnformatted(json);
-        cJSON_Delete(json);
-        
-        if (!json_str) {
-            buckets_topology_free(topo);
-            continue;
-        }
-        
-        /* Compute hash of JSON content */
-        u64 hash = buckets_xxhash64(0, json_str, strlen(json_str));
-        buckets_free(json_str);
+        reads[i].topology = NULL;
+        u64 hash = reads[i].hash;
         
         /* Find or create vote entry */
         bool found = false;
@@ -655,6 +738,7 @@ buckets_cluster_topology_t* buckets_topology_load_quorum(char **disk_paths,
                         }
                     }
                     buckets_free(votes);
+                    topology_reads_free(reads, disk_count);
                     
                     return result;
                 }
@@ -685,6 +769,7 @@ buckets_cluster_topology_t* buckets_topology_load_quorum(char **disk_paths,
                     buckets_topology_free(votes[k].topology);
                 }
                 buckets_free(votes);
+                topology_reads_free(reads, disk_count);
                 
                 return result;
             }
@@ -700,6 +785,7 @@ buckets_cluster_topology_t* buckets_topology_load_quorum(char **disk_paths,
         buckets_topology_free(votes[i].topology);
     }
     buckets_free(votes);
+    topology_reads_free(reads, disk_count);
     
     return NULL;
 }
@@ -20,8 +20,237 @@ static buckets_log_level_t g_log_level = BUCKETS_LOG_INFO;
 static FILE *g_log_file = NULL;
 static pthread_mutex_t g_log_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Allocation accounting */
+static bool g_alloc_stats_enabled = false;
+static buckets_alloc_stats_t g_alloc_stats;
+
+/* Per-request accounting */
+static bool g_account_enabled = false;
+static __thread buckets_account_t *t_account = NULL;
+static buckets_account_t g_account_totals;
+static u64 g_account_requests = 0;
+
+static inline void alloc_stats_record(size_t size) {
+    if (g_alloc_stats_enabled) {
+        __atomic_fetch_add(&g_alloc_stats.allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_alloc_stats.bytes, size, __ATOMIC_RELAXED);
+    }
+    if (g_account_enabled && t_account) {
+        __atomic_fetch_add(&t_account->allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&t_account->alloc_bytes, size, __ATOMIC_RELAXED);
+    }
+}
+
+void buckets_alloc_stats_enable(bool enabled) {
+    g_alloc_stats_enabled = enabled;
+}
+
+void buckets_alloc_stats_get(buckets_alloc_stats_t *stats) {
+    if (!stats) return;
+    stats->allocs = __atomic_load_n(&g_alloc_stats.allocs, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&g_alloc_stats.bytes, __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&g_alloc_stats.frees, __ATOMIC_RELAXED);
+}
+
+void buckets_alloc_stats_reset(void) {
+    __atomic_store_n(&g_alloc_stats.allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_alloc_stats.bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_alloc_stats.frees, 0, __ATOMIC_RELAXED);
+}
+
+/* Per-request accounting */
+void buckets_account_enable(bool enabled) {
+    g_account_enabled = enabled;
+}
+
+bool buckets_account_enabled(void) {
+    return g_account_enabled;
+}
+
+void buckets_account_begin(buckets_account_t *acct) {
+    if (!acct) return;
+    memset(acct, 0, sizeof(*acct));
+    t_account = acct;
+}
+
+void buckets_account_end(buckets_account_t *acct) {
+    if (!acct) return;
+    if (t_account == acct) {
+        t_account = NULL;
+    }
+    if (!g_account_enabled) return;
+
+    for (int i = 0; i < BUCKETS_SYS_COUNT; i++) {
+        __atomic_fetch_add(&g_account_totals.syscalls[i],
+                           __atomic_load_n(&acct->syscalls[i], __ATOMIC_RELAXED),
+                           __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&g_account_totals.allocs,
+                       __atomic_load_n(&acct->allocs, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_account_totals.alloc_bytes,
+                       __atomic_load_n(&acct->alloc_bytes, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_account_requests, 1, __ATOMIC_RELAXED);
+}
+
+buckets_account_t* buckets_account_attach(buckets_account_t *acct) {
+    buckets_account_t *prev = t_account;
+    t_account = acct;
+    return prev;
+}
+
+buckets_account_t* buckets_account_current(void) {
+    return t_account;
+}
+
+void buckets_account_record(buckets_syscall_kind_t kind, u64 count) {
+    if (!t_account || kind >= BUCKETS_SYS_COUNT) return;
+    __atomic_fetch_add(&t_account->syscalls[kind], count, __ATOMIC_RELAXED);
+}
+
+void buckets_account_add(buckets_account_t *dst, const buckets_account_t *src) {
+    if (!dst || !src) return;
+    for (int i = 0; i < BUCKETS_SYS_COUNT; i++) {
+        __atomic_fetch_add(&dst->syscalls[i], src->syscalls[i], __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&dst->allocs, src->allocs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dst->alloc_bytes, src->alloc_bytes, __ATOMIC_RELAXED);
+}
+
+u64 buckets_account_syscall_total(const buckets_account_t *acct) {
+    u64 total = 0;
+    if (!acct) return 0;
+    for (int i = 0; i < BUCKETS_SYS_COUNT; i++) {
+        total += acct->syscalls[i];
+    }
+    return total;
+}
+
+void buckets_account_get_totals(buckets_account_t *totals, u64 *requests) {
+    if (totals) {
+        for (int i = 0; i < BUCKETS_SYS_COUNT; i++) {
+            totals->syscalls[i] = __atomic_load_n(&g_account_totals.syscalls[i], __ATOMIC_RELAXED);
+        }
+        totals->allocs = __atomic_load_n(&g_account_totals.allocs, __ATOMIC_RELAXED);
+        totals->alloc_bytes = __atomic_load_n(&g_account_totals.alloc_bytes, __ATOMIC_RELAXED);
+    }
+    if (requests) {
+        *requests = __atomic_load_n(&g_account_requests, __ATOMIC_RELAXED);
+    }
+}
+
+void buckets_account_reset_totals(void) {
+    for (int i = 0; i < BUCKETS_SYS_COUNT; i++) {
+        __atomic_store_n(&g_account_totals.syscalls[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g_account_totals.allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_account_totals.alloc_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_account_requests, 0, __ATOMIC_RELAXED);
+}
+
+typedef struct {
+    void *(*fn)(void *);
+    void *arg;
+    buckets_account_t *account;
+} account_thread_t;
+
+static void* account_thread_main(void *arg) {
+    account_thread_t start = *(account_thread_t *)arg;
+    free(arg);
+
+    t_account = start.account;
+    void *ret = start.fn(start.arg);
+    t_account = NULL;
+    return ret;
+}
+
+int buckets_account_thread_create(pthread_t *thread, void *(*fn)(void *), void *arg) {
+    if (!g_account_enabled || !t_account) {
+        return pthread_create(thread, NULL, fn, arg);
+    }
+
+    buckets_account_record(BUCKETS_SYS_THREAD, 1);
+
+    /* Plain malloc: the trampoline itself is not part of the request */
+    account_thread_t *start = malloc(sizeof(*start));
+    if (!start) {
+        return pthread_create(thread, NULL, fn, arg);
+    }
+    start->fn = fn;
+    start->arg = arg;
+    start->account = t_account;
+
+    int ret = pthread_create(thread, NULL, account_thread_main, start);
+    if (ret != 0) {
+        free(start);
+    }
+    return ret;
+}
+
+typedef struct {
+    int (*fn)(void *arg, int index);
+    void *arg;
+    int count;
+    int next;                           /* Next index to claim (atomic) */
+    int status;                         /* First nonzero return (atomic) */
+} parallel_job_t;
+
+static void* parallel_worker(void *arg) {
+    parallel_job_t *job = arg;
+    while (__atomic_load_n(&job->status, __ATOMIC_RELAXED) == 0) {
+        int i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (i >= job->count) {
+            break;
+        }
+        int ret = job->fn(job->arg, i);
+        if (ret != 0) {
+            int none = 0;
+            __atomic_compare_exchange_n(&job->status, &none, ret, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+int buckets_parallel_for(int count, int max_threads,
+                         int (*fn)(void *arg, int index), void *arg) {
+    if (!fn || count <= 0) {
+        return 0;
+    }
+
+    parallel_job_t job = { .fn = fn, .arg = arg, .count = count };
+    int workers = max_threads < count ? max_threads : count;
+    if (workers > BUCKETS_PARALLEL_MAX_THREADS) {
+        workers = BUCKETS_PARALLEL_MAX_THREADS;
+    }
+
+    /* Fewer helpers than asked for is fine: the caller drains the rest */
+    pthread_t threads[BUCKETS_PARALLEL_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < workers; i++) {
+        if (buckets_account_thread_create(&threads[started], parallel_worker, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+    parallel_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return job.status;
+}
+
+const char* buckets_syscall_kind_name(buckets_syscall_kind_t kind) {
+    static const char *names[BUCKETS_SYS_COUNT] = {
+        "open", "close", "read", "write", "fsync", "rename", "mkdir", "unlink",
+        "stat", "socket", "connect", "send", "recv", "poll", "thread",
+        "fallocate"
+    };
+    return kind < BUCKETS_SYS_COUNT ? names[kind] : "unknown";
+}
+
 /* Memory management */
 void* buckets_malloc(size_t size) {
+    alloc_stats_record(size);
     void *ptr = malloc(size);
     if (!ptr && size > 0) {
         buckets_fatal("Out of memory: failed to allocate %zu bytes", size);
@@ -31,6 +260,7 @@ void* buckets_malloc(size_t size) {
 }
 
 void* buckets_calloc(size_t count, size_t size) {
+    alloc_stats_record(count * size);
     void *ptr = calloc(count, size);
     if (!ptr && (count * size) > 0) {
         buckets_fatal("Out of memory: failed to allocate %zu bytes", count * size);
@@ -40,6 +270,7 @@ void* buckets_calloc(size_t count, size_t size) {
 }
 
 void* buckets_realloc(void *ptr, size_t size) {
+    alloc_stats_record(size);
     void *new_ptr = realloc(ptr, size);
     if (!new_ptr && size > 0) {
         buckets_fatal("Out of memory: failed to reallocate to %zu bytes", size);
@@ -49,6 +280,9 @@ void* buckets_realloc(void *ptr, size_t size) {
 }
 
 void buckets_free(void *ptr) {
+    if (g_alloc_stats_enabled && ptr) {
+        __atomic_fetch_add(&g_alloc_stats.frees, 1, __ATOMIC_RELAXED);
+    }
     free(ptr);
 }
 
@@ -203,6 +437,12 @@ int buckets_init(void) {
     
     buckets_debug("Initializing Buckets v%s", BUCKETS_VERSION);
     
+    const char *accounting = getenv("BUCKETS_ACCOUNTING");
+    if (accounting && (strcmp(accounting, "1") == 0 || strcmp(accounting, "true") == 0)) {
+        buckets_account_enable(true);
+        buckets_info("Per-request syscall/allocation accounting enabled");
+    }
+    
     /* Initialize cache subsystems */
     buckets_format_cache_init();
     buckets_topology_cache_init();
@@ -0,0 +1,324 @@
+/**
+ * Sampling CPU Profiler Implementation
+ *
+ * SIGPROF handler records raw backtraces; symbolization and folding
+ * happen after sampling stops (see buckets_cpuprof.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+
+#include "buckets.h"
+#include "buckets_cpuprof.h"
+
+/* Frames to skip at the top of each trace: the handler and the signal trampoline */
+#define CPUPROF_SKIP_FRAMES 2
+
+/* Symbol cache (open addressing, power of two) */
+#define CPUPROF_SYM_CACHE_SIZE 8192
+
+/* ===================================================================
+ * Global State
+ * ===================================================================*/
+
+typedef struct {
+    u32 depth;                                  /* 0 = slot not filled */
+    void *pcs[BUCKETS_CPUPROF_MAX_DEPTH];
+} cpuprof_sample_t;
+
+typedef struct {
+    cpuprof_sample_t *samples;                  /* Preallocated before arming */
+    u32 capacity;
+    u32 next;                                   /* Next free slot (atomic) */
+    u64 dropped;                                /* Atomic */
+    bool active;                                /* Handler records only when set */
+    u32 in_handler;                             /* Handlers running now (atomic) */
+} cpuprof_state_t;
+
+static cpuprof_state_t g_prof;
+static bool g_prof_running = false;             /* One profile at a time */
+static bool g_prof_installed = false;           /* Handler stays installed once set */
+static pthread_mutex_t g_prof_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ===================================================================
+ * Signal Handler
+ * ===================================================================*/
+
+static void cpuprof_signal_handler(int sig, siginfo_t *info, void *ucontext)
+{
+    (void)sig;
+    (void)info;
+    (void)ucontext;
+
+    int saved_errno = errno;
+
+    /* Announce ourselves before looking at active: the collector clears
+     * active and then waits for in_handler to drain before freeing samples */
+    __atomic_fetch_add(&g_prof.in_handler, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&g_prof.active, __ATOMIC_SEQ_CST)) {
+        u32 idx = __atomic_fetch_add(&g_prof.next, 1, __ATOMIC_RELAXED);
+        if (idx < g_prof.capacity) {
+            cpuprof_sample_t *s = &g_prof.samples[idx];
+            int n = backtrace(s->pcs, BUCKETS_CPUPROF_MAX_DEPTH);
+            __atomic_store_n(&s->depth, n > 0 ? (u32)n : 0, __ATOMIC_RELEASE);
+        } else {
+            __atomic_fetch_add(&g_prof.dropped, 1, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_fetch_sub(&g_prof.in_handler, 1, __ATOMIC_RELEASE);
+
+    errno = saved_errno;
+}
+
+static int cpuprof_set_timer(u32 hz)
+{
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    if (hz > 0) {
+        timer.it_interval.tv_usec = (suseconds_t)(1000000 / hz);
+        timer.it_value = timer.it_interval;
+    }
+    return setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+/* ===================================================================
+ * Symbolization
+ * ===================================================================*/
+
+typedef struct {
+    void *pc;
+    char *name;
+} sym_entry_t;
+
+static const char* symbolize(sym_entry_t *cache, void *pc)
+{
+    size_t slot = ((uintptr_t)pc >> 4) & (CPUPROF_SYM_CACHE_SIZE - 1);
+    for (size_t probe = 0; probe < CPUPROF_SYM_CACHE_SIZE; probe++) {
+        sym_entry_t *e = &cache[(slot + probe) & (CPUPROF_SYM_CACHE_SIZE - 1)];
+        if (e->pc == pc) {
+            return e->name;
+        }
+        if (e->pc == NULL) {
+            /* Return addresses point past the call; look up the call itself */
+            Dl_info dl;
+            char buf[256];
+            if (dladdr((char *)pc - 1, &dl) && dl.dli_sname) {
+                snprintf(buf, sizeof(buf), "%s", dl.dli_sname);
+            } else if (dladdr((char *)pc - 1, &dl) && dl.dli_fname) {
+                /* Unexported symbol: module+offset, resolvable with addr2line */
+                const char *base = strrchr(dl.dli_fname, '/');
+                snprintf(buf, sizeof(buf), "%s+0x%lx", base ? base + 1 : dl.dli_fname,
+                         (unsigned long)((uintptr_t)pc - (uintptr_t)dl.dli_fbase));
+            } else {
+                snprintf(buf, sizeof(buf), "0x%lx", (unsigned long)(uintptr_t)pc);
+            }
+
+            /* Folded format reserves ';' and ' ' */
+            for (char *c = buf; *c; c++) {
+                if (*c == ';' || *c == ' ') {
+                    *c = '_';
+                }
+            }
+
+            e->pc = pc;
+            e->name = buckets_strdup(buf);
+            return e->name;
+        }
+    }
+    return "[unknown]";
+}
+
+/* ===================================================================
+ * Folding
+ * ===================================================================*/
+
+static int compare_str(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int cpuprof_fold(u32 count, buckets_cpuprof_result_t *result)
+{
+    sym_entry_t *cache = buckets_calloc(CPUPROF_SYM_CACHE_SIZE, sizeof(sym_entry_t));
+    char **stacks = buckets_calloc(count ? count : 1, sizeof(char *));
+    u32 stack_count = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        cpuprof_sample_t *s = &g_prof.samples[i];
+        u32 depth = __atomic_load_n(&s->depth, __ATOMIC_ACQUIRE);
+        if (depth <= CPUPROF_SKIP_FRAMES) {
+            continue;
+        }
+
+        /* Root first: walk from the outermost frame to the interrupted one */
+        char line[BUCKETS_CPUPROF_MAX_DEPTH * 64];
+        size_t off = 0;
+        for (u32 f = depth; f-- > CPUPROF_SKIP_FRAMES;) {
+            const char *name = symbolize(cache, s->pcs[f]);
+            int n = snprintf(line + off, sizeof(line) - off, "%s%s",
+                             off ? ";" : "", name);
+            if (n < 0 || (size_t)n >= sizeof(line) - off) {
+                break;
+            }
+            off += (size_t)n;
+        }
+        stacks[stack_count++] = buckets_strdup(line);
+    }
+
+    qsort(stacks, stack_count, sizeof(char *), compare_str);
+
+    /* Emit "stack count" for each run of identical stacks */
+    size_t capacity = 4096;
+    size_t len = 0;
+    char *out = buckets_malloc(capacity);
+    out[0] = '\0';
+    for (u32 i = 0; i < stack_count;) {
+        u32 j = i + 1;
+        while (j < stack_count && strcmp(stacks[j], stacks[i]) == 0) {
+            j++;
+        }
+
+        size_t need = strlen(stacks[i]) + 24;
+        if (len + need > capacity) {
+            while (len + need > capacity) {
+                capacity *= 2;
+            }
+            out = buckets_realloc(out, capacity);
+        }
+        len += (size_t)snprintf(out + len, capacity - len, "%s %u\n", stacks[i], j - i);
+        i = j;
+    }
+
+    for (u32 i = 0; i < stack_count; i++) {
+        buckets_free(stacks[i]);
+    }
+    buckets_free(stacks);
+    for (size_t i = 0; i < CPUPROF_SYM_CACHE_SIZE; i++) {
+        buckets_free(cache[i].name);
+    }
+    buckets_free(cache);
+
+    result->folded = out;
+    result->folded_len = len;
+    result->samples = stack_count;
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * Public API
+ * ===================================================================*/
+
+int buckets_cpuprof_collect(u32 duration_ms, u32 hz, buckets_cpuprof_result_t *result)
+{
+    if (!result || duration_ms == 0 || duration_ms > BUCKETS_CPUPROF_MAX_SECONDS * 1000) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    if (hz == 0) {
+        hz = BUCKETS_CPUPROF_DEFAULT_HZ;
+    }
+    if (hz > BUCKETS_CPUPROF_MAX_HZ) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    memset(result, 0, sizeof(*result));
+
+    pthread_mutex_lock(&g_prof_lock);
+    if (g_prof_running) {
+        pthread_mutex_unlock(&g_prof_lock);
+        return BUCKETS_ERR_LIMIT;
+    }
+    g_prof_running = true;
+    pthread_mutex_unlock(&g_prof_lock);
+
+    /* Process-wide sample budget: rate x duration across a few busy threads */
+    u64 want = (u64)hz * duration_ms / 1000 * 8 + 64;
+    g_prof.capacity = want < BUCKETS_CPUPROF_MAX_SAMPLES ? (u32)want : BUCKETS_CPUPROF_MAX_SAMPLES;
+    g_prof.samples = buckets_calloc(g_prof.capacity, sizeof(cpuprof_sample_t));
+    g_prof.next = 0;
+    g_prof.dropped = 0;
+
+    /* First backtrace() call loads the unwinder; never let that happen in the handler */
+    void *warmup[4];
+    backtrace(warmup, 4);
+
+    /* Installed once and never removed: a SIGPROF still pending on some
+     * thread after the timer is disarmed must not hit SIG_DFL (terminate) */
+    if (!g_prof_installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = cpuprof_signal_handler;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGPROF, &sa, NULL) != 0) {
+            buckets_error("cpuprof: sigaction failed: %s", strerror(errno));
+            buckets_free(g_prof.samples);
+            g_prof.samples = NULL;
+            __atomic_store_n(&g_prof_running, false, __ATOMIC_RELEASE);
+            return BUCKETS_ERR_IO;
+        }
+        g_prof_installed = true;
+    }
+
+    __atomic_store_n(&g_prof.active, true, __ATOMIC_RELEASE);
+    cpuprof_set_timer(hz);
+    buckets_info("cpuprof: sampling at %u Hz for %u ms", hz, duration_ms);
+
+    struct timespec ts = {
+        .tv_sec = duration_ms / 1000,
+        .tv_nsec = (long)(duration_ms % 1000) * 1000000L
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        /* SIGPROF may land on this thread; keep sleeping */
+    }
+
+    cpuprof_set_timer(0);
+    __atomic_store_n(&g_prof.active, false, __ATOMIC_SEQ_CST);
+
+    /* Handlers that saw active set may still be writing samples; any that
+     * start from here on see it clear and touch nothing */
+    struct timespec settle = { .tv_sec = 0, .tv_nsec = 1000000L };
+    while (__atomic_load_n(&g_prof.in_handler, __ATOMIC_SEQ_CST) > 0) {
+        nanosleep(&settle, NULL);
+    }
+
+    u32 recorded = __atomic_load_n(&g_prof.next, __ATOMIC_ACQUIRE);
+    if (recorded > g_prof.capacity) {
+        recorded = g_prof.capacity;
+    }
+
+    cpuprof_fold(recorded, result);
+    result->dropped = __atomic_load_n(&g_prof.dropped, __ATOMIC_RELAXED);
+    result->hz = hz;
+    result->duration_ms = duration_ms;
+
+    buckets_free(g_prof.samples);
+    g_prof.samples = NULL;
+    g_prof.capacity = 0;
+
+    buckets_info("cpuprof: %lu samples (%lu dropped)", result->samples, result->dropped);
+
+    __atomic_store_n(&g_prof_running, false, __ATOMIC_RELEASE);
+    return BUCKETS_OK;
+}
+
+void buckets_cpuprof_result_free(buckets_cpuprof_result_t *result)
+{
+    if (!result) {
+        return;
+    }
+    buckets_free(result->folded);
+    result->folded = NULL;
+    result->folded_len = 0;
+}
+
+bool buckets_cpuprof_running(void)
+{
+    return __atomic_load_n(&g_prof_running, __ATOMIC_ACQUIRE);
+}
@@ -154,6 +154,11 @@ buckets_request_timing_t* buckets_debug_timing_start(const char *operation,
     snprintf(timing->bucket, sizeof(timing->bucket), "%s", bucket ? bucket : "");
     snprintf(timing->object, sizeof(timing->object), "%s", object ? object : "");
     
+    if (buckets_account_enabled()) {
+        timing->prev_account = buckets_account_current();
+        buckets_account_begin(&timing->account);
+    }
+    
     buckets_debug("[REQ %lu] START %s %s/%s", 
                   timing->request_id, timing->operation, 
                   timing->bucket, timing->object);
@@ -219,5 +224,22 @@ void buckets_debug_timing_end(buckets_request_timing_t *timing)
                  timing->request_id, timing->operation, timing->bucket, timing->object,
                  total, storage_time, erasure_time, rpc_time);
     
+    if (buckets_account_enabled()) {
+        buckets_account_end(&timing->account);
+        buckets_account_attach(timing->prev_account);
+        buckets_info("[REQ %lu] COST syscalls=%lu (open=%lu write=%lu fsync=%lu rename=%lu "
+                     "mkdir=%lu send=%lu recv=%lu) allocs=%lu alloc_bytes=%lu",
+                     timing->request_id,
+                     buckets_account_syscall_total(&timing->account),
+                     timing->account.syscalls[BUCKETS_SYS_OPEN],
+                     timing->account.syscalls[BUCKETS_SYS_WRITE],
+                     timing->account.syscalls[BUCKETS_SYS_FSYNC],
+                     timing->account.syscalls[BUCKETS_SYS_RENAME],
+                     timing->account.syscalls[BUCKETS_SYS_MKDIR],
+                     timing->account.syscalls[BUCKETS_SYS_SEND],
+                     timing->account.syscalls[BUCKETS_SYS_RECV],
+                     timing->account.allocs, timing->account.alloc_bytes);
+    }
+    
     buckets_free(timing);
 }
@@ -0,0 +1,161 @@
+/**
+ * Fault Injection Implementation
+ *
+ * Disk faults parsed once from the environment (see buckets_fault.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_fault.h"
+
+/* ===================================================================
+ * Global State
+ * ===================================================================*/
+
+typedef struct {
+    char path[256];         /* Disk path prefix */
+    u32 delay_ms;           /* Delay per I/O (0 = none) */
+    bool fail;              /* Fail every I/O */
+} fault_disk_t;
+
+static fault_disk_t g_fault_disks[BUCKETS_FAULT_MAX_DISKS];
+static int g_fault_disk_count = 0;
+static bool g_fault_enabled = false;
+static pthread_once_t g_fault_once = PTHREAD_ONCE_INIT;
+
+/* ===================================================================
+ * Parsing
+ * ===================================================================*/
+
+static fault_disk_t* fault_disk_slot(const char *path, size_t len)
+{
+    for (int i = 0; i < g_fault_disk_count; i++) {
+        if (strlen(g_fault_disks[i].path) == len &&
+            strncmp(g_fault_disks[i].path, path, len) == 0) {
+            return &g_fault_disks[i];
+        }
+    }
+
+    if (g_fault_disk_count >= BUCKETS_FAULT_MAX_DISKS ||
+        len == 0 || len >= sizeof(g_fault_disks[0].path)) {
+        return NULL;
+    }
+
+    fault_disk_t *disk = &g_fault_disks[g_fault_disk_count++];
+    memcpy(disk->path, path, len);
+    disk->path[len] = '\0';
+    return disk;
+}
+
+static void parse_slow_disks(const char *spec)
+{
+    const char *p = spec;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t entry_len = end ? (size_t)(end - p) : strlen(p);
+
+        /* Last ':' separates the delay so disk paths may contain ':' */
+        const char *colon = NULL;
+        for (const char *c = p; c < p + entry_len; c++) {
+            if (*c == ':') {
+                colon = c;
+            }
+        }
+
+        if (colon) {
+            fault_disk_t *disk = fault_disk_slot(p, (size_t)(colon - p));
+            if (disk) {
+                disk->delay_ms = (u32)strtoul(colon + 1, NULL, 10);
+                buckets_warn("Fault injection: disk %s delayed by %u ms per I/O",
+                             disk->path, disk->delay_ms);
+            }
+        }
+
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+}
+
+static void parse_failed_disks(const char *spec)
+{
+    const char *p = spec;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t entry_len = end ? (size_t)(end - p) : strlen(p);
+
+        fault_disk_t *disk = fault_disk_slot(p, entry_len);
+        if (disk) {
+            disk->fail = true;
+            buckets_warn("Fault injection: disk %s fails all I/O", disk->path);
+        }
+
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+}
+
+static void fault_init_once(void)
+{
+    const char *slow = getenv("BUCKETS_FAULT_SLOW_DISK");
+    const char *fail = getenv("BUCKETS_FAULT_FAIL_DISK");
+
+    if (slow && slow[0] != '\0') {
+        parse_slow_disks(slow);
+    }
+    if (fail && fail[0] != '\0') {
+        parse_failed_disks(fail);
+    }
+
+    g_fault_enabled = (g_fault_disk_count > 0);
+}
+
+/* ===================================================================
+ * Public API
+ * ===================================================================*/
+
+bool buckets_fault_enabled(void)
+{
+    pthread_once(&g_fault_once, fault_init_once);
+    return g_fault_enabled;
+}
+
+int buckets_fault_disk_io(const char *path)
+{
+    if (!path || !buckets_fault_enabled()) {
+        return BUCKETS_OK;
+    }
+
+    for (int i = 0; i < g_fault_disk_count; i++) {
+        fault_disk_t *disk = &g_fault_disks[i];
+        size_t len = strlen(disk->path);
+
+        if (strncmp(path, disk->path, len) != 0 ||
+            (path[len] != '\0' && path[len] != '/')) {
+            continue;
+        }
+
+        if (disk->fail) {
+            return BUCKETS_ERR_IO;
+        }
+
+        if (disk->delay_ms > 0) {
+            struct timespec ts = {
+                .tv_sec = disk->delay_ms / 1000,
+                .tv_nsec = (long)(disk->delay_ms % 1000) * 1000000L
+            };
+            nanosleep(&ts, NULL);
+        }
+        return BUCKETS_OK;
+    }
+
+    return BUCKETS_OK;
+}
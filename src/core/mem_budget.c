@@ -0,0 +1,264 @@
+/**
+ * Node-Wide Memory Budget Implementation
+ *
+ * A mutex-protected byte counter with a condition variable for blocking
+ * charges and release hooks for event loops (see buckets_mem_budget.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_mem_budget.h"
+
+typedef struct {
+    buckets_mem_budget_hook_t fn;
+    void *arg;
+} budget_hook_t;
+
+static pthread_mutex_t g_budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_budget_cond = PTHREAD_COND_INITIALIZER;
+static u32 g_budget_wait_ms = BUCKETS_MEM_BUDGET_DEFAULT_WAIT_MS;
+static budget_hook_t g_budget_hooks[BUCKETS_MEM_BUDGET_MAX_HOOKS];
+static buckets_mem_budget_stats_t g_budget;     /* limit == 0: disabled */
+
+/* Request scope of the calling thread */
+static __thread bool t_scope_active = false;
+static __thread u64 t_scope_bytes = 0;
+
+/* ===================================================================
+ * Helpers (caller holds g_budget_lock)
+ * ===================================================================*/
+
+static bool budget_fits(u64 bytes)
+{
+    /* An oversized request runs alone rather than never */
+    return g_budget.used + bytes <= g_budget.limit || g_budget.used == 0;
+}
+
+static void budget_take(u64 bytes)
+{
+    g_budget.used += bytes;
+    g_budget.reservations++;
+    if (g_budget.used > g_budget.peak) {
+        g_budget.peak = g_budget.used;
+    }
+}
+
+static u64 now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000ULL + (u64)ts.tv_nsec / 1000;
+}
+
+/* ===================================================================
+ * Initialization
+ * ===================================================================*/
+
+int buckets_mem_budget_init(u64 limit_bytes, u32 wait_ms)
+{
+    pthread_mutex_lock(&g_budget_lock);
+    memset(&g_budget, 0, sizeof(g_budget));
+    g_budget.limit = limit_bytes;
+    g_budget_wait_ms = wait_ms;
+    pthread_cond_broadcast(&g_budget_cond);
+    pthread_mutex_unlock(&g_budget_lock);
+
+    if (limit_bytes > 0) {
+        buckets_info("Memory budget: %lu MB for in-flight request buffers (wait limit %u ms)",
+                     limit_bytes / (1024 * 1024), wait_ms);
+    }
+    return BUCKETS_OK;
+}
+
+int buckets_mem_budget_init_from_env(u32 shares)
+{
+    u64 limit = 0;
+    const char *env = getenv("BUCKETS_MEM_BUDGET_MB");
+    if (env) {
+        long long mb = atoll(env);
+        limit = mb > 0 ? (u64)mb * 1024 * 1024 : 0;
+    } else {
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (pages > 0 && page_size > 0) {
+            limit = (u64)pages * (u64)page_size / 2;
+        }
+    }
+
+    if (shares > 1) {
+        limit /= shares;
+    }
+
+    u32 wait_ms = BUCKETS_MEM_BUDGET_DEFAULT_WAIT_MS;
+    env = getenv("BUCKETS_MEM_BUDGET_WAIT_MS");
+    if (env && atoi(env) >= 0) {
+        wait_ms = (u32)atoi(env);
+    }
+
+    return buckets_mem_budget_init(limit, wait_ms);
+}
+
+void buckets_mem_budget_cleanup(void)
+{
+    pthread_mutex_lock(&g_budget_lock);
+    g_budget.limit = 0;
+    pthread_cond_broadcast(&g_budget_cond);
+    pthread_mutex_unlock(&g_budget_lock);
+}
+
+bool buckets_mem_budget_enabled(void)
+{
+    pthread_mutex_lock(&g_budget_lock);
+    bool enabled = g_budget.limit > 0;
+    pthread_mutex_unlock(&g_budget_lock);
+    return enabled;
+}
+
+/* ===================================================================
+ * Reservations
+ * ===================================================================*/
+
+bool buckets_mem_budget_try_reserve(u64 bytes)
+{
+    if (bytes < BUCKETS_MEM_BUDGET_MIN_RESERVE) {
+        return true;
+    }
+
+    pthread_mutex_lock(&g_budget_lock);
+    bool ok = true;
+    if (g_budget.limit > 0) {
+        ok = budget_fits(bytes);
+        if (ok) {
+            budget_take(bytes);
+        } else {
+            g_budget.deferred++;
+        }
+    }
+    pthread_mutex_unlock(&g_budget_lock);
+    return ok;
+}
+
+void buckets_mem_budget_release(u64 bytes)
+{
+    if (bytes < BUCKETS_MEM_BUDGET_MIN_RESERVE) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_budget_lock);
+    g_budget.used = g_budget.used > bytes ? g_budget.used - bytes : 0;
+    pthread_cond_broadcast(&g_budget_cond);
+    for (int i = 0; i < BUCKETS_MEM_BUDGET_MAX_HOOKS; i++) {
+        if (g_budget_hooks[i].fn) {
+            g_budget_hooks[i].fn(g_budget_hooks[i].arg);
+        }
+    }
+    pthread_mutex_unlock(&g_budget_lock);
+}
+
+void buckets_mem_budget_scope_begin(void)
+{
+    t_scope_active = true;
+    t_scope_bytes = 0;
+}
+
+u64 buckets_mem_budget_scope_end(void)
+{
+    u64 bytes = t_scope_bytes;
+    t_scope_active = false;
+    t_scope_bytes = 0;
+    return bytes;
+}
+
+void buckets_mem_budget_charge(u64 bytes)
+{
+    if (!t_scope_active || bytes < BUCKETS_MEM_BUDGET_MIN_RESERVE) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_budget_lock);
+    if (g_budget.limit == 0) {
+        pthread_mutex_unlock(&g_budget_lock);
+        return;
+    }
+
+    if (!budget_fits(bytes)) {
+        u64 start = now_us();
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += g_budget_wait_ms / 1000;
+        deadline.tv_nsec += (long)(g_budget_wait_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        g_budget.waits++;
+        int rc = 0;
+        while (g_budget.limit > 0 && !budget_fits(bytes) && rc == 0) {
+            rc = pthread_cond_timedwait(&g_budget_cond, &g_budget_lock, &deadline);
+        }
+        g_budget.wait_time_us += now_us() - start;
+
+        if (g_budget.limit == 0) {
+            pthread_mutex_unlock(&g_budget_lock);
+            return;
+        }
+        if (!budget_fits(bytes)) {
+            g_budget.overdrafts++;
+            buckets_warn("Memory budget: admitting %lu bytes over budget after %u ms "
+                         "(used %lu of %lu)", bytes, g_budget_wait_ms,
+                         g_budget.used, g_budget.limit);
+        }
+    }
+
+    budget_take(bytes);
+    t_scope_bytes += bytes;
+    pthread_mutex_unlock(&g_budget_lock);
+}
+
+/* ===================================================================
+ * Hooks and Stats
+ * ===================================================================*/
+
+int buckets_mem_budget_add_hook(buckets_mem_budget_hook_t hook, void *arg)
+{
+    pthread_mutex_lock(&g_budget_lock);
+    for (int i = 0; i < BUCKETS_MEM_BUDGET_MAX_HOOKS; i++) {
+        if (!g_budget_hooks[i].fn) {
+            g_budget_hooks[i].fn = hook;
+            g_budget_hooks[i].arg = arg;
+            pthread_mutex_unlock(&g_budget_lock);
+            return BUCKETS_OK;
+        }
+    }
+    pthread_mutex_unlock(&g_budget_lock);
+    return BUCKETS_ERR_LIMIT;
+}
+
+void buckets_mem_budget_remove_hook(buckets_mem_budget_hook_t hook, void *arg)
+{
+    pthread_mutex_lock(&g_budget_lock);
+    for (int i = 0; i < BUCKETS_MEM_BUDGET_MAX_HOOKS; i++) {
+        if (g_budget_hooks[i].fn == hook && g_budget_hooks[i].arg == arg) {
+            g_budget_hooks[i].fn = NULL;
+            g_budget_hooks[i].arg = NULL;
+        }
+    }
+    pthread_mutex_unlock(&g_budget_lock);
+}
+
+void buckets_mem_budget_get_stats(buckets_mem_budget_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    pthread_mutex_lock(&g_budget_lock);
+    *stats = g_budget;
+    pthread_mutex_unlock(&g_budget_lock);
+}
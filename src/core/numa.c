@@ -0,0 +1,347 @@
+/**
+ * NUMA / CPU Affinity Implementation
+ *
+ * Topology comes from /sys/devices/system/node and disk locality from the
+ * numa_node attribute of the block device's parent bus device. Memory
+ * policy is set with the raw set_mempolicy syscall so no libnuma is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#include "buckets.h"
+#include "buckets_numa.h"
+
+#define NUMA_SYSFS_NODES    "/sys/devices/system/node"
+#define NUMA_PATH_CACHE     64
+#define NUMA_MPOL_PREFERRED 1           /* From <linux/mempolicy.h> */
+
+typedef struct {
+    char path[PATH_MAX];
+    int node;
+} numa_path_entry_t;
+
+static struct {
+    pthread_once_t once;
+    bool enabled;
+    u32 nodes;
+    cpu_set_t node_cpus[BUCKETS_NUMA_MAX_NODES];
+    short cpu_node[CPU_SETSIZE];        /* -1 = offline / unknown */
+    int home_node;
+    int home_cpu;
+
+    pthread_rwlock_t paths_lock;
+    numa_path_entry_t paths[NUMA_PATH_CACHE];
+    u32 path_count;
+
+    buckets_numa_stats_t stats;
+} g_numa = {
+    .once = PTHREAD_ONCE_INIT,
+    .home_node = -1,
+    .home_cpu = -1,
+    .paths_lock = PTHREAD_RWLOCK_INITIALIZER
+};
+
+/* ===================================================================
+ * Topology Discovery
+ * ===================================================================*/
+
+/* Parse a sysfs cpulist ("0-3,8-11") into a set */
+static void parse_cpulist(const char *list, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET((int)cpu, set);
+        }
+        p = *end == ',' ? end + 1 : end;
+        if (*p == '\n') {
+            break;
+        }
+    }
+}
+
+static bool read_sysfs_line(const char *path, char *buf, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    bool ok = fgets(buf, (int)size, f) != NULL;
+    fclose(f);
+    return ok;
+}
+
+static void numa_discover(void)
+{
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        g_numa.cpu_node[cpu] = -1;
+    }
+
+    char path[128];
+    char list[4096];
+    for (u32 node = 0; node < BUCKETS_NUMA_MAX_NODES; node++) {
+        snprintf(path, sizeof(path), NUMA_SYSFS_NODES "/node%u/cpulist", node);
+        if (!read_sysfs_line(path, list, sizeof(list))) {
+            break;
+        }
+        parse_cpulist(list, &g_numa.node_cpus[node]);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &g_numa.node_cpus[node])) {
+                g_numa.cpu_node[cpu] = (short)node;
+            }
+        }
+        g_numa.nodes = node + 1;
+    }
+
+    if (g_numa.nodes == 0) {
+        /* No NUMA sysfs (container / non-NUMA kernel): one node */
+        sched_getaffinity(0, sizeof(cpu_set_t), &g_numa.node_cpus[0]);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &g_numa.node_cpus[0])) {
+                g_numa.cpu_node[cpu] = 0;
+            }
+        }
+        g_numa.nodes = 1;
+    }
+}
+
+static void numa_init_once(void)
+{
+    numa_discover();
+
+    const char *env = getenv("BUCKETS_NUMA");
+    g_numa.enabled = env && (strcmp(env, "1") == 0 || strcmp(env, "on") == 0 ||
+                             strcmp(env, "true") == 0);
+    g_numa.stats.nodes = g_numa.nodes;
+
+    if (g_numa.enabled) {
+        buckets_info("NUMA placement enabled: %u node(s)", g_numa.nodes);
+    }
+}
+
+void buckets_numa_init(void)
+{
+    pthread_once(&g_numa.once, numa_init_once);
+}
+
+bool buckets_numa_enabled(void)
+{
+    buckets_numa_init();
+    return g_numa.enabled;
+}
+
+u32 buckets_numa_node_count(void)
+{
+    buckets_numa_init();
+    return g_numa.nodes;
+}
+
+/* ===================================================================
+ * Process and Thread Placement
+ * ===================================================================*/
+
+/* Pick the n-th CPU (wrapping) of a node */
+static int node_nth_cpu(u32 node, u32 n)
+{
+    int count = CPU_COUNT(&g_numa.node_cpus[node]);
+    if (count == 0) {
+        return -1;
+    }
+    int want = (int)(n % (u32)count);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &g_numa.node_cpus[node]) && want-- == 0) {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+int buckets_numa_pin_worker(int worker_id)
+{
+    buckets_numa_init();
+    if (!g_numa.enabled || worker_id < 0) {
+        return BUCKETS_OK;
+    }
+
+    u32 node = (u32)worker_id % g_numa.nodes;
+    g_numa.home_node = (int)node;
+    g_numa.home_cpu = node_nth_cpu(node, (u32)worker_id / g_numa.nodes);
+
+    if (g_numa.nodes < 2) {
+        /* Nothing to keep apart; the home CPU still steers connections */
+        return BUCKETS_OK;
+    }
+
+    /* Threads started later inherit both the mask and the memory policy */
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &g_numa.node_cpus[node]) != 0) {
+        buckets_warn("Worker %d: failed to pin to NUMA node %u: %s",
+                     worker_id, node, strerror(errno));
+        return BUCKETS_ERR_IO;
+    }
+
+    unsigned long mask[(BUCKETS_NUMA_MAX_NODES + 63) / 64] = {0};
+    mask[node / 64] = 1UL << (node % 64);
+    if (syscall(SYS_set_mempolicy, NUMA_MPOL_PREFERRED, mask,
+                (unsigned long)BUCKETS_NUMA_MAX_NODES + 1) != 0) {
+        buckets_warn("Worker %d: failed to prefer memory on node %u: %s",
+                     worker_id, node, strerror(errno));
+    }
+
+    buckets_info("Worker %d pinned to NUMA node %u (%d CPUs, home CPU %d)",
+                 worker_id, node, CPU_COUNT(&g_numa.node_cpus[node]), g_numa.home_cpu);
+    return BUCKETS_OK;
+}
+
+int buckets_numa_home_node(void)
+{
+    return g_numa.home_node;
+}
+
+int buckets_numa_home_cpu(void)
+{
+    return g_numa.home_cpu;
+}
+
+int buckets_numa_current_node(void)
+{
+    buckets_numa_init();
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return -1;
+    }
+    return g_numa.cpu_node[cpu];
+}
+
+void buckets_numa_run_on_node(int node)
+{
+    buckets_numa_init();
+    if (!g_numa.enabled || node < 0 || (u32)node >= g_numa.nodes || g_numa.nodes < 2) {
+        return;
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &g_numa.node_cpus[node]);
+}
+
+/* ===================================================================
+ * Disk Locality
+ * ===================================================================*/
+
+/* Walk up from the block device's sysfs node to the first numa_node */
+static int device_numa_node(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+
+    char link[64];
+    char dir[PATH_MAX];
+    snprintf(link, sizeof(link), "/sys/dev/block/%u:%u",
+             major(st.st_dev), minor(st.st_dev));
+    if (!realpath(link, dir)) {
+        return -1;
+    }
+
+    char attr[PATH_MAX + 16];
+    char value[32];
+    while (strlen(dir) > strlen("/sys/devices")) {
+        snprintf(attr, sizeof(attr), "%s/numa_node", dir);
+        if (read_sysfs_line(attr, value, sizeof(value))) {
+            int node = atoi(value);
+            return node >= 0 && (u32)node < g_numa.nodes ? node : -1;
+        }
+        char *slash = strrchr(dir, '/');
+        if (!slash) {
+            break;
+        }
+        *slash = '\0';
+    }
+    return -1;
+}
+
+int buckets_numa_node_of_path(const char *path)
+{
+    if (!path) {
+        return -1;
+    }
+    buckets_numa_init();
+    if (g_numa.nodes < 2) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&g_numa.paths_lock);
+    for (u32 i = 0; i < g_numa.path_count; i++) {
+        if (strcmp(g_numa.paths[i].path, path) == 0) {
+            int node = g_numa.paths[i].node;
+            pthread_rwlock_unlock(&g_numa.paths_lock);
+            return node;
+        }
+    }
+    pthread_rwlock_unlock(&g_numa.paths_lock);
+
+    int node = device_numa_node(path);
+
+    pthread_rwlock_wrlock(&g_numa.paths_lock);
+    if (g_numa.path_count < NUMA_PATH_CACHE && strlen(path) < PATH_MAX) {
+        numa_path_entry_t *entry = &g_numa.paths[g_numa.path_count++];
+        snprintf(entry->path, sizeof(entry->path), "%s", path);
+        entry->node = node;
+        buckets_debug("Disk %s is on NUMA node %d", path, node);
+    }
+    pthread_rwlock_unlock(&g_numa.paths_lock);
+    return node;
+}
+
+void buckets_numa_record_io(const char *disk_path, size_t bytes)
+{
+    /* A pinned worker's buffers live on its home node wherever the
+     * issuing thread runs; otherwise go by the current CPU */
+    int disk_node = buckets_numa_node_of_path(disk_path);
+    int cur_node = g_numa.home_node >= 0 ? g_numa.home_node : buckets_numa_current_node();
+
+    if (disk_node < 0 || cur_node < 0) {
+        __atomic_add_fetch(&g_numa.stats.unknown_ops, 1, __ATOMIC_RELAXED);
+    } else if (disk_node == cur_node) {
+        __atomic_add_fetch(&g_numa.stats.local_ops, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&g_numa.stats.local_bytes, bytes, __ATOMIC_RELAXED);
+    } else {
+        __atomic_add_fetch(&g_numa.stats.remote_ops, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&g_numa.stats.remote_bytes, bytes, __ATOMIC_RELAXED);
+    }
+}
+
+void buckets_numa_get_stats(buckets_numa_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    buckets_numa_init();
+    stats->nodes = g_numa.nodes;
+    stats->home_node = g_numa.home_node;
+    stats->home_cpu = g_numa.home_cpu;
+    stats->local_ops = __atomic_load_n(&g_numa.stats.local_ops, __ATOMIC_RELAXED);
+    stats->local_bytes = __atomic_load_n(&g_numa.stats.local_bytes, __ATOMIC_RELAXED);
+    stats->remote_ops = __atomic_load_n(&g_numa.stats.remote_ops, __ATOMIC_RELAXED);
+    stats->remote_bytes = __atomic_load_n(&g_numa.stats.remote_bytes, __ATOMIC_RELAXED);
+    stats->unknown_ops = __atomic_load_n(&g_numa.stats.unknown_ops, __ATOMIC_RELAXED);
+}
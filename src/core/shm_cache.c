@@ -0,0 +1,399 @@
+/**
+ * Shared-Memory Cache Implementation
+ *
+ * Segment layout (all offsets from the segment base):
+ *   [header][stripe mutexes][set 0: way 0 .. way N-1][set 1] ...
+ * Each slot is a fixed-size record: slot header, key bytes, value bytes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "buckets.h"
+#include "buckets_hash.h"
+#include "buckets_shm_cache.h"
+
+#define SHM_CACHE_MAGIC 0x53484d43u     /* "SHMC" */
+#define SHM_ALIGN(n, a) (((n) + (a) - 1) & ~((size_t)(a) - 1))
+
+/**
+ * Slot header (followed by key_max key bytes and value_max value bytes)
+ */
+typedef struct {
+    u64 hash;
+    u64 last_used;                  /* Cache clock at last access */
+    i64 expiry;                     /* Wall-clock expiry (0 = never) */
+    u32 key_len;
+    u32 value_len;
+    u32 valid;
+    u32 reserved;
+} shm_slot_t;
+
+/**
+ * Stripe lock, padded to its own cache line
+ */
+typedef union {
+    pthread_mutex_t lock;
+    char pad[64];
+} shm_stripe_t;
+
+/**
+ * Segment header
+ */
+typedef struct {
+    u32 magic;
+    u32 set_count;
+    u32 stripe_count;
+    u32 key_max;
+    u32 value_max;
+    u32 slot_size;
+    u32 ttl_seconds;
+    u32 reserved;
+    u64 stripes_off;
+    u64 slots_off;
+    u64 clock;                      /* Access counter for LRU */
+    buckets_shm_cache_stats_t stats;
+} shm_header_t;
+
+struct buckets_shm_cache {
+    u8 *base;
+    size_t map_size;
+    char name[32];
+};
+
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static shm_header_t* shm_header(buckets_shm_cache_t *cache)
+{
+    return (shm_header_t *)cache->base;
+}
+
+static shm_stripe_t* shm_stripe(buckets_shm_cache_t *cache, u32 set)
+{
+    shm_header_t *hdr = shm_header(cache);
+    shm_stripe_t *stripes = (shm_stripe_t *)(cache->base + hdr->stripes_off);
+    return &stripes[set % hdr->stripe_count];
+}
+
+static shm_slot_t* shm_slot(buckets_shm_cache_t *cache, u32 set, u32 way)
+{
+    shm_header_t *hdr = shm_header(cache);
+    u64 index = (u64)set * BUCKETS_SHM_CACHE_WAYS + way;
+    return (shm_slot_t *)(cache->base + hdr->slots_off + index * hdr->slot_size);
+}
+
+static char* slot_key(shm_slot_t *slot)
+{
+    return (char *)(slot + 1);
+}
+
+static u8* slot_value(buckets_shm_cache_t *cache, shm_slot_t *slot)
+{
+    return (u8 *)(slot + 1) + shm_header(cache)->key_max;
+}
+
+static void stat_add(u64 *counter, i64 delta)
+{
+    __atomic_add_fetch(counter, (u64)delta, __ATOMIC_RELAXED);
+}
+
+/* Caller holds the set's stripe lock */
+static void slot_drop(buckets_shm_cache_t *cache, shm_slot_t *slot)
+{
+    if (slot->valid) {
+        slot->valid = 0;
+        stat_add(&shm_header(cache)->stats.entries, -1);
+    }
+}
+
+/**
+ * Lock the stripe covering a set
+ *
+ * A worker that died holding the lock may have left one of the stripe's
+ * slots half-written, so all of the stripe's entries are dropped.
+ */
+static void stripe_lock(buckets_shm_cache_t *cache, u32 set)
+{
+    shm_header_t *hdr = shm_header(cache);
+    shm_stripe_t *stripe = shm_stripe(cache, set);
+
+    if (pthread_mutex_lock(&stripe->lock) == EOWNERDEAD) {
+        for (u32 s = set % hdr->stripe_count; s < hdr->set_count; s += hdr->stripe_count) {
+            for (u32 w = 0; w < BUCKETS_SHM_CACHE_WAYS; w++) {
+                slot_drop(cache, shm_slot(cache, s, w));
+            }
+        }
+        stat_add(&hdr->stats.recovered, 1);
+        pthread_mutex_consistent(&stripe->lock);
+        buckets_warn("Shared cache %s: reset stripe %u after its holder died",
+                     cache->name, set % hdr->stripe_count);
+    }
+}
+
+static void stripe_unlock(buckets_shm_cache_t *cache, u32 set)
+{
+    pthread_mutex_unlock(&shm_stripe(cache, set)->lock);
+}
+
+/* Caller holds the set's stripe lock */
+static shm_slot_t* set_find(buckets_shm_cache_t *cache, u32 set, u64 hash,
+                            const char *key, u32 key_len)
+{
+    for (u32 w = 0; w < BUCKETS_SHM_CACHE_WAYS; w++) {
+        shm_slot_t *slot = shm_slot(cache, set, w);
+        if (slot->valid && slot->hash == hash && slot->key_len == key_len &&
+            memcmp(slot_key(slot), key, key_len) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static bool slot_expired(const shm_slot_t *slot, time_t now)
+{
+    return slot->expiry != 0 && slot->expiry < (i64)now;
+}
+
+/* ===================================================================
+ * Lifecycle
+ * ===================================================================*/
+
+bool buckets_shm_cache_requested(void)
+{
+    const char *env = getenv("BUCKETS_SHARED_CACHE");
+    return env && (strcmp(env, "1") == 0 || strcmp(env, "on") == 0 ||
+                   strcmp(env, "true") == 0);
+}
+
+buckets_shm_cache_t* buckets_shm_cache_create(const char *name, u32 entries,
+                                              u32 key_max, u32 value_max,
+                                              u32 ttl_seconds)
+{
+    if (!name || entries == 0 || key_max == 0 || value_max == 0) {
+        return NULL;
+    }
+
+    u32 set_count = (entries + BUCKETS_SHM_CACHE_WAYS - 1) / BUCKETS_SHM_CACHE_WAYS;
+    u32 stripe_count = set_count < BUCKETS_SHM_CACHE_STRIPES ?
+                       set_count : BUCKETS_SHM_CACHE_STRIPES;
+    size_t slot_size = SHM_ALIGN(sizeof(shm_slot_t) + key_max + value_max, 8);
+    size_t stripes_off = SHM_ALIGN(sizeof(shm_header_t), 64);
+    size_t slots_off = SHM_ALIGN(stripes_off + stripe_count * sizeof(shm_stripe_t), 64);
+    size_t map_size = slots_off + (size_t)set_count * BUCKETS_SHM_CACHE_WAYS * slot_size;
+
+    /* Anonymous shared pages are zero-filled and only backed once touched */
+    void *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        buckets_error("Shared cache %s: mmap of %zu bytes failed: %s",
+                      name, map_size, strerror(errno));
+        return NULL;
+    }
+
+    buckets_shm_cache_t *cache = buckets_calloc(1, sizeof(buckets_shm_cache_t));
+    cache->base = base;
+    cache->map_size = map_size;
+    snprintf(cache->name, sizeof(cache->name), "%s", name);
+
+    shm_header_t *hdr = shm_header(cache);
+    hdr->set_count = set_count;
+    hdr->stripe_count = stripe_count;
+    hdr->key_max = key_max;
+    hdr->value_max = value_max;
+    hdr->slot_size = (u32)slot_size;
+    hdr->ttl_seconds = ttl_seconds;
+    hdr->stripes_off = stripes_off;
+    hdr->slots_off = slots_off;
+    hdr->stats.capacity = (u64)set_count * BUCKETS_SHM_CACHE_WAYS;
+    hdr->stats.segment_bytes = map_size;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    shm_stripe_t *stripes = (shm_stripe_t *)(cache->base + stripes_off);
+    for (u32 i = 0; i < stripe_count; i++) {
+        pthread_mutex_init(&stripes[i].lock, &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+    hdr->magic = SHM_CACHE_MAGIC;
+
+    buckets_info("Shared cache %s: %lu slots, %zu MB segment (%u stripes)",
+                 name, hdr->stats.capacity, map_size / (1024 * 1024), stripe_count);
+    return cache;
+}
+
+void buckets_shm_cache_destroy(buckets_shm_cache_t *cache)
+{
+    if (!cache) {
+        return;
+    }
+    munmap(cache->base, cache->map_size);
+    buckets_free(cache);
+}
+
+/* ===================================================================
+ * Operations
+ * ===================================================================*/
+
+bool buckets_shm_cache_get(buckets_shm_cache_t *cache, const char *key,
+                           void *value, u32 value_size, u32 *value_len)
+{
+    if (!cache || !key || !value) {
+        return false;
+    }
+
+    shm_header_t *hdr = shm_header(cache);
+    u32 key_len = (u32)strlen(key);
+    if (key_len > hdr->key_max) {
+        stat_add(&hdr->stats.misses, 1);
+        return false;
+    }
+
+    u64 hash = buckets_xxhash64(0, key, key_len);
+    u32 set = (u32)(hash % hdr->set_count);
+    bool hit = false;
+
+    stripe_lock(cache, set);
+    shm_slot_t *slot = set_find(cache, set, hash, key, key_len);
+    if (slot && slot_expired(slot, time(NULL))) {
+        slot_drop(cache, slot);
+    } else if (slot && slot->value_len <= value_size) {
+        memcpy(value, slot_value(cache, slot), slot->value_len);
+        if (value_len) {
+            *value_len = slot->value_len;
+        }
+        slot->last_used = __atomic_add_fetch(&hdr->clock, 1, __ATOMIC_RELAXED);
+        hit = true;
+    }
+    stripe_unlock(cache, set);
+
+    stat_add(hit ? &hdr->stats.hits : &hdr->stats.misses, 1);
+    return hit;
+}
+
+int buckets_shm_cache_put(buckets_shm_cache_t *cache, const char *key,
+                          const void *value, u32 value_len)
+{
+    if (!cache || !key || (!value && value_len > 0)) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    shm_header_t *hdr = shm_header(cache);
+    u32 key_len = (u32)strlen(key);
+    if (key_len > hdr->key_max || value_len > hdr->value_max) {
+        stat_add(&hdr->stats.oversized, 1);
+        return BUCKETS_ERR_LIMIT;
+    }
+
+    u64 hash = buckets_xxhash64(0, key, key_len);
+    u32 set = (u32)(hash % hdr->set_count);
+    time_t now = time(NULL);
+
+    stripe_lock(cache, set);
+    shm_slot_t *slot = set_find(cache, set, hash, key, key_len);
+    if (!slot) {
+        /* Prefer a free or expired slot, else replace the least recently used */
+        shm_slot_t *victim = NULL;
+        for (u32 w = 0; w < BUCKETS_SHM_CACHE_WAYS; w++) {
+            shm_slot_t *s = shm_slot(cache, set, w);
+            if (!s->valid || slot_expired(s, now)) {
+                victim = s;
+                break;
+            }
+            if (!victim || s->last_used < victim->last_used) {
+                victim = s;
+            }
+        }
+        if (victim->valid) {
+            if (!slot_expired(victim, now)) {
+                stat_add(&hdr->stats.evictions, 1);
+            }
+            slot_drop(cache, victim);
+        }
+        slot = victim;
+        slot->hash = hash;
+        slot->key_len = key_len;
+        memcpy(slot_key(slot), key, key_len);
+    }
+
+    if (value_len > 0) {
+        memcpy(slot_value(cache, slot), value, value_len);
+    }
+    slot->value_len = value_len;
+    slot->expiry = hdr->ttl_seconds > 0 ? (i64)now + hdr->ttl_seconds : 0;
+    slot->last_used = __atomic_add_fetch(&hdr->clock, 1, __ATOMIC_RELAXED);
+    if (!slot->valid) {
+        slot->valid = 1;
+        stat_add(&hdr->stats.entries, 1);
+    }
+    stripe_unlock(cache, set);
+    return BUCKETS_OK;
+}
+
+bool buckets_shm_cache_invalidate(buckets_shm_cache_t *cache, const char *key)
+{
+    if (!cache || !key) {
+        return false;
+    }
+
+    shm_header_t *hdr = shm_header(cache);
+    u32 key_len = (u32)strlen(key);
+    if (key_len > hdr->key_max) {
+        return false;
+    }
+
+    u64 hash = buckets_xxhash64(0, key, key_len);
+    u32 set = (u32)(hash % hdr->set_count);
+
+    stripe_lock(cache, set);
+    shm_slot_t *slot = set_find(cache, set, hash, key, key_len);
+    if (slot) {
+        slot_drop(cache, slot);
+    }
+    stripe_unlock(cache, set);
+    return slot != NULL;
+}
+
+void buckets_shm_cache_clear(buckets_shm_cache_t *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    shm_header_t *hdr = shm_header(cache);
+    for (u32 stripe = 0; stripe < hdr->stripe_count; stripe++) {
+        stripe_lock(cache, stripe);
+        for (u32 set = stripe; set < hdr->set_count; set += hdr->stripe_count) {
+            for (u32 w = 0; w < BUCKETS_SHM_CACHE_WAYS; w++) {
+                slot_drop(cache, shm_slot(cache, set, w));
+            }
+        }
+        stripe_unlock(cache, stripe);
+    }
+}
+
+void buckets_shm_cache_get_stats(buckets_shm_cache_t *cache,
+                                 buckets_shm_cache_stats_t *stats)
+{
+    if (!cache || !stats) {
+        return;
+    }
+
+    buckets_shm_cache_stats_t *s = &shm_header(cache)->stats;
+    stats->capacity = s->capacity;
+    stats->segment_bytes = s->segment_bytes;
+    stats->entries = __atomic_load_n(&s->entries, __ATOMIC_RELAXED);
+    stats->hits = __atomic_load_n(&s->hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&s->misses, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&s->evictions, __ATOMIC_RELAXED);
+    stats->oversized = __atomic_load_n(&s->oversized, __ATOMIC_RELAXED);
+    stats->recovered = __atomic_load_n(&s->recovered, __ATOMIC_RELAXED);
+}
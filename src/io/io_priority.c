@@ -0,0 +1,148 @@
+/**
+ * Disk I/O Priority Implementation
+ *
+ * Uses the raw ioprio_set/ioprio_get syscalls (no glibc wrappers). The
+ * thread's class is cached so scopes that do not change it cost nothing;
+ * a thread's first use reads back the priority it inherited from its
+ * creator, so shard threads spawned by a bulk stage stay BULK.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "buckets.h"
+#include "buckets_io_priority.h"
+
+/* From <linux/ioprio.h> */
+#define IOPRIO_CLASS_SHIFT  13
+#define IOPRIO_CLASS_BE     2
+#define IOPRIO_WHO_PROCESS  1
+#define IOPRIO_PRIO_VALUE(cls, data)  (((cls) << IOPRIO_CLASS_SHIFT) | (data))
+
+#define IO_LEVEL_META       0
+#define IO_LEVEL_DEFAULT    4
+#define IO_LEVEL_BULK       7
+
+static struct {
+    pthread_once_t once;
+    bool enabled;
+    buckets_io_priority_stats_t stats;
+} g_ioprio = {
+    .once = PTHREAD_ONCE_INIT
+};
+
+static __thread bool t_class_known = false;
+static __thread buckets_io_class_t t_class = BUCKETS_IO_CLASS_DEFAULT;
+
+static void io_priority_init_once(void)
+{
+    const char *env = getenv("BUCKETS_IO_PRIORITY");
+    g_ioprio.enabled = !(env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0 ||
+                                 strcmp(env, "false") == 0));
+#ifndef SYS_ioprio_set
+    g_ioprio.enabled = false;
+#endif
+    if (!g_ioprio.enabled) {
+        buckets_info("Disk I/O priorities disabled");
+    }
+}
+
+void buckets_io_priority_init(void)
+{
+    pthread_once(&g_ioprio.once, io_priority_init_once);
+}
+
+bool buckets_io_priority_enabled(void)
+{
+    buckets_io_priority_init();
+    return g_ioprio.enabled;
+}
+
+static int class_level(buckets_io_class_t cls)
+{
+    switch (cls) {
+        case BUCKETS_IO_CLASS_META: return IO_LEVEL_META;
+        case BUCKETS_IO_CLASS_BULK: return IO_LEVEL_BULK;
+        default:                    return IO_LEVEL_DEFAULT;
+    }
+}
+
+/* Adopt whatever the thread inherited the first time it is asked */
+static void class_load(void)
+{
+    if (t_class_known) {
+        return;
+    }
+    t_class_known = true;
+    t_class = BUCKETS_IO_CLASS_DEFAULT;
+
+#ifdef SYS_ioprio_get
+    if (!buckets_io_priority_enabled()) {
+        return;
+    }
+    long prio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    if (prio == IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, IO_LEVEL_META)) {
+        t_class = BUCKETS_IO_CLASS_META;
+    } else if (prio == IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, IO_LEVEL_BULK)) {
+        t_class = BUCKETS_IO_CLASS_BULK;
+    }
+#endif
+}
+
+buckets_io_class_t buckets_io_class_set(buckets_io_class_t cls)
+{
+    class_load();
+
+    buckets_io_class_t prev = t_class;
+    if (cls == prev) {
+        return prev;
+    }
+    t_class = cls;
+
+    if (!buckets_io_priority_enabled()) {
+        return prev;
+    }
+    if (cls == BUCKETS_IO_CLASS_META) {
+        __atomic_add_fetch(&g_ioprio.stats.meta_scopes, 1, __ATOMIC_RELAXED);
+    } else if (cls == BUCKETS_IO_CLASS_BULK) {
+        __atomic_add_fetch(&g_ioprio.stats.bulk_scopes, 1, __ATOMIC_RELAXED);
+    }
+
+#ifdef SYS_ioprio_set
+    /* who = 0: the calling thread */
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, class_level(cls))) != 0) {
+        __atomic_add_fetch(&g_ioprio.stats.failures, 1, __ATOMIC_RELAXED);
+    }
+#endif
+    return prev;
+}
+
+buckets_io_class_t buckets_io_class_get(void)
+{
+    class_load();
+    return t_class;
+}
+
+u16 buckets_io_class_sqe_ioprio(void)
+{
+    if (!buckets_io_priority_enabled()) {
+        return 0;
+    }
+    /* DEFAULT is spelled out too: 0 would mean whatever the io-wq worker
+     * inherited, which can be BULK if a bulk stage spawned it */
+    return (u16)IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, class_level(buckets_io_class_get()));
+}
+
+void buckets_io_priority_get_stats(buckets_io_priority_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    stats->meta_scopes = __atomic_load_n(&g_ioprio.stats.meta_scopes, __ATOMIC_RELAXED);
+    stats->bulk_scopes = __atomic_load_n(&g_ioprio.stats.bulk_scopes, __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&g_ioprio.stats.failures, __ATOMIC_RELAXED);
+}
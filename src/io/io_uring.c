@@ -14,6 +14,7 @@
 
 #include "buckets.h"
 #include "buckets_io_uring.h"
+#include "buckets_io_priority.h"
 
 /* Per-operation context */
 typedef struct {
@@ -187,6 +188,10 @@ buckets_io_uring_context_t* buckets_io_uring_init(const buckets_io_uring_config_
     if (ctx->config.sq_poll) {
         params.flags |= IORING_SETUP_SQPOLL;
         params.sq_thread_idle = 2000;  /* 2 second idle before kernel thread sleeps */
+        if (ctx->config.sq_thread_pin) {
+            params.flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = ctx->config.sq_thread_cpu;
+        }
     }
     if (ctx->config.io_poll) {
         params.flags |= IORING_SETUP_IOPOLL;
@@ -313,6 +318,11 @@ static int submit_io_op(buckets_io_uring_context_t *ctx,
             return -1;
     }
     
+    /* The ring's threads issue the I/O: carry the submitter's class */
+    if (op_type != BUCKETS_IO_OP_FSYNC && op_type != BUCKETS_IO_OP_FDATASYNC) {
+        sqe->ioprio = buckets_io_class_sqe_ioprio();
+    }
+    
     /* Attach operation context to sqe */
     io_uring_sqe_set_data(sqe, op_ctx);
     
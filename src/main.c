@@ -20,6 +20,8 @@
 #include "buckets_worker_pool.h"
 #include "buckets_debug.h"
 #include "buckets_async_write.h"
+#include "buckets_mem_budget.h"
+#include "buckets_shm_cache.h"
 #include "storage/async_replication.h"
 
 /* Global config pointer for distributed operations */
@@ -308,6 +310,108 @@ typedef struct {
     int port;
 } server_worker_config_t;
 
+/* Set by SIGINT/SIGTERM in single-process mode */
+static volatile sig_atomic_t g_shutdown_requested = 0;
+
+static void server_signal_handler(int signo)
+{
+    (void)signo;
+    g_shutdown_requested = 1;
+}
+
+/* Credentials load from the data directory independently of the storage
+ * bring-up, so it runs alongside it instead of after it */
+typedef struct {
+    const char *data_dir;
+    pthread_t thread;
+    bool started;
+    int result;
+} credentials_loader_t;
+
+static void* credentials_load_thread(void *arg)
+{
+    credentials_loader_t *loader = (credentials_loader_t*)arg;
+    loader->result = buckets_credentials_init(loader->data_dir);
+    return NULL;
+}
+
+static credentials_loader_t g_credentials_loader = {0};
+
+static void credentials_load_begin(const char *data_dir)
+{
+    g_credentials_loader.data_dir = data_dir;
+    g_credentials_loader.started = buckets_account_thread_create(
+        &g_credentials_loader.thread, credentials_load_thread, &g_credentials_loader) == 0;
+}
+
+/* Wait for the background load, or load now if none was started */
+static int credentials_load_finish(const char *data_dir)
+{
+    if (!g_credentials_loader.started) {
+        return buckets_credentials_init(data_dir);
+    }
+    pthread_join(g_credentials_loader.thread, NULL);
+    g_credentials_loader.started = false;
+    return g_credentials_loader.result;
+}
+
+/* Warm the caches from the last snapshot, if snapshots are enabled */
+static void cache_warmup_begin(void)
+{
+    const char *snapshot = buckets_cache_snapshot_path();
+    if (snapshot) {
+        buckets_cache_warmup_start(snapshot);
+    }
+}
+
+/* Save cache keys for the next start (also runs at worker exit) */
+static void cache_snapshot_save_on_exit(void)
+{
+    const char *snapshot = buckets_cache_snapshot_path();
+    if (snapshot) {
+        buckets_cache_warmup_stop();
+        buckets_cache_snapshot_save(snapshot);
+    }
+}
+
+/* Start the pipelined-ACK write workers if BUCKETS_ASYNC_WRITE=1 */
+static void async_write_start(void)
+{
+    const char *async_write_enabled = getenv("BUCKETS_ASYNC_WRITE");
+    if (!async_write_enabled || strcmp(async_write_enabled, "1") != 0) {
+        return;
+    }
+    buckets_info("Initializing async write system (pipelined ACK mode, 8 workers)...");
+    if (buckets_async_write_init(8) != BUCKETS_OK) {
+        buckets_warn("Failed to initialize async write system, using sync mode");
+    } else {
+        buckets_info("✨ Async write system initialized - pipelined ACK enabled!");
+        buckets_info("   Client latency will be reduced by 10-15x for large objects");
+    }
+}
+
+/* Set once distributed storage is up; gossip then starts in every process
+ * that serves peer RPCs (each worker, after the fork: threads and locks
+ * held by the parent's gossip would not survive it). One of them is the
+ * node's agent; the rest follow it through the shared segment. */
+static bool g_gossip_wanted = false;
+
+static void gossip_start(bool agent)
+{
+    if (g_gossip_wanted && buckets_distributed_gossip_start(agent) != BUCKETS_OK) {
+        buckets_warn("Failed to start gossip membership");
+    }
+}
+
+/* Finish pipelined-ACK writes left in the journal by a crash */
+static void async_write_replay_journal(void)
+{
+    int replayed = buckets_async_write_replay();
+    if (replayed > 0) {
+        buckets_info("Replaying %d journaled async writes", replayed);
+    }
+}
+
 /**
  * Worker process callback - runs the HTTP server
  * Called in each forked worker process
@@ -319,6 +423,10 @@ static int worker_process_main(int worker_id, void *user_data)
     buckets_info("Worker %d starting HTTP server on %s:%d", 
                  worker_id, cfg->bind_addr, cfg->port);
     
+    /* Peers' gossip RPCs reach any worker through SO_REUSEPORT; worker 0
+     * probes for the node and the others forward to it */
+    gossip_start(worker_id == 0);
+    
     /* Create server */
     uv_http_server_t *uv_server = uv_http_server_create(cfg->bind_addr, cfg->port);
     if (!uv_server) {
@@ -326,6 +434,13 @@ static int worker_process_main(int worker_id, void *user_data)
         return 1;
     }
     
+    /* Peers connect to the same port */
+    if (buckets_peer_tls_enable_server(uv_server) != BUCKETS_OK) {
+        buckets_error("Worker %d: Failed to enable peer TLS", worker_id);
+        uv_http_server_free(uv_server);
+        return 1;
+    }
+    
     /* Register streaming S3 handlers */
     if (s3_streaming_register_handlers(uv_server) != BUCKETS_OK) {
         buckets_error("Worker %d: Failed to register S3 handlers", worker_id);
@@ -339,6 +454,11 @@ static int worker_process_main(int worker_id, void *user_data)
         uv_http_server_free(uv_server);
         return 1;
     }
+    buckets_startup_ready();
+    
+    /* Workers leave through exit() on SIGTERM; save the snapshot then */
+    cache_warmup_begin();
+    atexit(cache_snapshot_save_on_exit);
     
     /* Keep running */
     while (1) {
@@ -373,6 +493,9 @@ int main(int argc, char *argv[]) {
         buckets_info("UV thread pool size: 512 (optimized for multi-client workloads)");
     }
 
+    /* Time to ready / time to warm are measured from here */
+    buckets_startup_begin();
+
     /* Initialize logging first */
     buckets_log_init();
 
@@ -439,6 +562,13 @@ int main(int argc, char *argv[]) {
             }
         }
         
+        /* Encrypted node-to-node transport, before anything talks to peers */
+        if (buckets_peer_tls_init_from_env() != BUCKETS_OK) {
+            fprintf(stderr, "Error: failed to set up peer TLS\n\n");
+            ret = 1;
+            goto cleanup;
+        }
+        
         /* Load configuration if specified */
         buckets_config_t *config = NULL;
         if (config_file) {
@@ -463,6 +593,9 @@ int main(int argc, char *argv[]) {
             /* Use configuration values */
             port = config->server.bind_port;
             
+            /* Credentials load while the disks come up */
+            credentials_load_begin(config->node.data_dir);
+            
             /* Initialize multi-disk storage */
             if (config->storage.disk_count > 0) {
                 buckets_info("Initializing multi-disk storage with %d disks...", config->storage.disk_count);
@@ -507,14 +640,12 @@ int main(int argc, char *argv[]) {
                             if (buckets_topology_populate_endpoints_from_config(topology, config) == BUCKETS_OK) {
                                 buckets_info("Topology endpoints populated successfully");
                                 
-                                /* Save updated topology with endpoints to all disks */
+                                /* Save updated topology with endpoints to all disks (in parallel) */
                                 buckets_info("Saving topology with populated endpoints...");
-                                for (int i = 0; i < config->storage.disk_count; i++) {
-                                    if (buckets_topology_save(config->storage.disks[i], topology) != BUCKETS_OK) {
-                                        buckets_warn("Failed to save topology to disk: %s", config->storage.disks[i]);
-                                    }
+                                if (buckets_topology_save_quorum(config->storage.disks, config->storage.disk_count,
+                                                                 topology) != BUCKETS_OK) {
+                                    buckets_warn("Failed to save topology to a quorum of disks");
                                 }
-                                buckets_info("Topology saved to %d disks", config->storage.disk_count);
                             } else {
                                 buckets_warn("Failed to populate topology endpoints");
                             }
@@ -581,16 +712,7 @@ int main(int argc, char *argv[]) {
                     }
                     
                     /* Initialize async write system for pipelined ACK */
-                    const char *async_write_enabled = getenv("BUCKETS_ASYNC_WRITE");
-                    if (async_write_enabled && strcmp(async_write_enabled, "1") == 0) {
-                        buckets_info("Initializing async write system (pipelined ACK mode, 8 workers)...");
-                        if (buckets_async_write_init(8) != BUCKETS_OK) {
-                            buckets_warn("Failed to initialize async write system, using sync mode");
-                        } else {
-                            buckets_info("✨ Async write system initialized - pipelined ACK enabled!");
-                            buckets_info("   Client latency will be reduced by 10-15x for large objects");
-                        }
-                    }
+                    async_write_start();
                     
                     /* Initialize distributed storage (RPC for remote chunks) */
                     buckets_info("Initializing distributed storage...");
@@ -614,6 +736,13 @@ int main(int argc, char *argv[]) {
                     }
                     
                     buckets_info("Distributed storage initialized");
+
+                    /* Failure detection and dissemination among cluster
+                     * nodes, started by the process that serves RPCs */
+                    g_gossip_wanted = true;
+
+                    /* Needs distributed storage for remote disks */
+                    async_write_replay_journal();
                 }
             }
         }
@@ -660,12 +789,16 @@ int main(int argc, char *argv[]) {
             } else {
                 buckets_info("Async replication initialized");
             }
+            
+            /* Pipelined ACK and its journal work the same without a cluster */
+            async_write_start();
+            async_write_replay_journal();
         }
         
         /* Initialize credential system */
         const char *data_dir = config ? config->node.data_dir : "/tmp/buckets-data";
         buckets_info("Initializing credential system...");
-        if (buckets_credentials_init(data_dir) != BUCKETS_OK) {
+        if (credentials_load_finish(data_dir) != BUCKETS_OK) {
             buckets_error("Failed to initialize credential system");
             /* Continue anyway - auth will be disabled */
             buckets_s3_auth_set_enabled(false);
@@ -690,6 +823,15 @@ int main(int argc, char *argv[]) {
             num_workers = buckets_http_worker_get_optimal_count();
         }
         
+        /* Memory budget for buffered bodies and objects; forked workers
+         * each take an equal share of the node budget */
+        buckets_mem_budget_init_from_env(num_workers > 0 ? (u32)num_workers : 1);
+        
+        /* Per-tenant rate limits, split between workers the same way */
+        if (buckets_s3_qos_init_from_env(num_workers > 0 ? (u32)num_workers : 1) != BUCKETS_OK) {
+            buckets_warn("Tenant QoS disabled: failed to initialize");
+        }
+        
         /* Use multi-process worker pool if requested */
         if (num_workers > 0) {
             buckets_info("==================================================");
@@ -697,6 +839,22 @@ int main(int argc, char *argv[]) {
             buckets_info("Each worker runs independent event loop");
             buckets_info("==================================================");
             
+            /* One registry / versioning cache for all workers instead of
+             * a cold copy per worker (must happen before the fork) */
+            if (buckets_shm_cache_requested()) {
+                if (config && buckets_registry_cache_share() != 0) {
+                    buckets_warn("Shared registry cache unavailable");
+                }
+                if (buckets_s3_versioning_cache_share() != BUCKETS_OK) {
+                    buckets_warn("Shared versioning cache unavailable");
+                }
+            }
+            
+            /* One gossip agent per node, whichever worker gets a message */
+            if (g_gossip_wanted && buckets_distributed_gossip_share() != BUCKETS_OK) {
+                buckets_warn("Shared gossip membership unavailable");
+            }
+            
             /* Prepare worker configuration */
             server_worker_config_t worker_cfg = {
                 .bind_addr = bind_addr,
@@ -745,6 +903,8 @@ int main(int argc, char *argv[]) {
         buckets_info("Using libuv HTTP server with streaming support (single-process)");
         buckets_info("Set BUCKETS_WORKERS=auto for multi-process scaling");
         
+        gossip_start(true);
+        
         uv_http_server_t *uv_server = uv_http_server_create(bind_addr, port);
         if (!uv_server) {
             buckets_error("Failed to create UV HTTP server");
@@ -759,6 +919,9 @@ int main(int argc, char *argv[]) {
             goto cleanup;
         }
         
+        /* Peers connect to the same port */
+        buckets_peer_tls_enable_server(uv_server);
+        
         /* Register streaming S3 handlers */
         if (s3_streaming_register_handlers(uv_server) != BUCKETS_OK) {
             buckets_error("Failed to register streaming S3 handlers");
@@ -789,6 +952,9 @@ int main(int argc, char *argv[]) {
             goto cleanup;
         }
         
+        buckets_startup_ready();
+        cache_warmup_begin();
+        
         buckets_info("Server started successfully!");
         buckets_info("S3 API available at: http://localhost:%d/", port);
         buckets_info("");
@@ -801,12 +967,15 @@ int main(int argc, char *argv[]) {
         buckets_info("Server is running. Press Ctrl+C to stop...");
         
         /* Keep server running */
-        while (1) {
+        signal(SIGINT, server_signal_handler);
+        signal(SIGTERM, server_signal_handler);
+        while (!g_shutdown_requested) {
             sleep(1);
         }
         
         /* Cleanup (reached on Ctrl+C) */
         buckets_info("Shutting down server...");
+        cache_snapshot_save_on_exit();
         uv_http_server_stop(uv_server);
         uv_http_server_free(uv_server);
         s3_streaming_cleanup();
@@ -1060,6 +1229,11 @@ int main(int argc, char *argv[]) {
     }
 
 cleanup:
+    if (g_credentials_loader.started) {
+        credentials_load_finish(NULL);
+    }
+    buckets_s3_qos_cleanup();
+    buckets_peer_tls_cleanup();
     buckets_cleanup();
     return ret;
 }
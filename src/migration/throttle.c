@@ -166,6 +166,59 @@ int buckets_throttle_wait(buckets_throttle_t *throttle, i64 bytes)
     }
 }
 
+/**
+ * Consume tokens if available, without waiting
+ */
+bool buckets_throttle_try_consume(buckets_throttle_t *throttle, i64 bytes)
+{
+    if (!throttle) {
+        return false;
+    }
+    
+    if (!throttle->enabled || throttle->rate_bytes_per_sec == 0 || bytes <= 0) {
+        return true;
+    }
+    
+    pthread_mutex_lock(&throttle->lock);
+    refill_tokens(throttle, get_time_us());
+    bool ok = (throttle->tokens >= bytes);
+    if (ok) {
+        throttle->tokens -= bytes;
+    }
+    pthread_mutex_unlock(&throttle->lock);
+    
+    return ok;
+}
+
+/**
+ * Consume tokens unconditionally, going into debt if there are too few
+ */
+i64 buckets_throttle_charge(buckets_throttle_t *throttle, i64 bytes)
+{
+    if (!throttle || !throttle->enabled || throttle->rate_bytes_per_sec == 0) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&throttle->lock);
+    
+    refill_tokens(throttle, get_time_us());
+    
+    // Negative charges refund, never past a full bucket
+    throttle->tokens -= bytes;
+    if (throttle->tokens > throttle->burst_bytes) {
+        throttle->tokens = throttle->burst_bytes;
+    }
+    
+    i64 debt_us = 0;
+    if (throttle->tokens < 0) {
+        debt_us = (-throttle->tokens * 1000000LL) / throttle->rate_bytes_per_sec;
+    }
+    
+    pthread_mutex_unlock(&throttle->lock);
+    
+    return debt_us;
+}
+
 /**
  * Set throttle rate (can be changed dynamically)
  */
@@ -1,7 +1,8 @@
 /**
  * Broadcast Implementation
  * 
- * Broadcast RPC calls to all peers in grid.
+ * Broadcast RPC calls to all peers in grid. Calls to different peers run
+ * concurrently, so a broadcast costs one round trip to the slowest peer.
  */
 
 #include <stdio.h>
@@ -13,10 +14,90 @@
 #include "buckets_net.h"
 #include "cJSON.h"
 
+/* Most calls a fan-out keeps in flight */
+#define FANOUT_MAX_THREADS 16
+
+/* ===================================================================
+ * Fan-out
+ * ===================================================================*/
+
+typedef struct {
+    buckets_rpc_context_t *ctx;
+    const char **endpoints;
+    int count;
+    const char *method;
+    cJSON *params;
+    buckets_rpc_response_t **responses;
+    int timeout_ms;
+} fanout_job_t;
+
+static int fanout_worker(void *arg, int i)
+{
+    fanout_job_t *job = arg;
+    job->responses[i] = NULL;
+    if (!job->endpoints[i]) {
+        return 0;
+    }
+
+    buckets_rpc_response_t *response = NULL;
+    int ret = buckets_rpc_call(job->ctx, job->endpoints[i], job->method,
+                               job->params, &response, job->timeout_ms);
+    if (ret == BUCKETS_OK && response && response->error_code == 0) {
+        job->responses[i] = response;
+    } else if (response) {
+        buckets_rpc_response_free(response);
+    }
+    return 0;
+}
+
+int buckets_rpc_fanout(buckets_rpc_context_t *ctx,
+                       const char **endpoints,
+                       int count,
+                       const char *method,
+                       cJSON *params,
+                       buckets_rpc_response_t **responses,
+                       int timeout_ms)
+{
+    if (!ctx || (count > 0 && (!endpoints || !responses)) || !method || count < 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    fanout_job_t job = {
+        .ctx = ctx,
+        .endpoints = endpoints,
+        .count = count,
+        .method = method,
+        .params = params,
+        .responses = responses,
+        .timeout_ms = timeout_ms
+    };
+
+    /* One thread per call actually made: skipped (NULL) endpoints, most of
+     * them on a PUT's invalidation, need none */
+    int calls = 0;
+    for (int i = 0; i < count; i++) {
+        if (endpoints[i]) {
+            calls++;
+        }
+    }
+    buckets_parallel_for(count, calls < FANOUT_MAX_THREADS ? calls : FANOUT_MAX_THREADS,
+                         fanout_worker, &job);
+    return BUCKETS_OK;
+}
+
 /* ===================================================================
  * Broadcast API
  * ===================================================================*/
 
+static void add_failed_peer(buckets_broadcast_result_t *res, const char *endpoint)
+{
+    char *failed_endpoint = buckets_strdup(endpoint);
+    if (failed_endpoint) {
+        res->failed_peers[res->failed] = failed_endpoint;
+        res->failed++;
+    }
+}
+
 int buckets_rpc_broadcast(buckets_rpc_context_t *ctx,
                           buckets_peer_grid_t *grid,
                           const char *method,
@@ -32,91 +113,59 @@ int buckets_rpc_broadcast(buckets_rpc_context_t *ctx,
     int peer_count = 0;
     buckets_peer_t **peers = buckets_peer_grid_get_peers(grid, &peer_count);
     
-    if (peer_count == 0) {
-        /* No peers - return empty result */
-        buckets_broadcast_result_t *res = buckets_calloc(1, sizeof(buckets_broadcast_result_t));
-        if (!res) {
-            return BUCKETS_ERR_NOMEM;
-        }
-        res->total = 0;
-        res->success = 0;
-        res->failed = 0;
-        res->responses = NULL;
-        res->failed_peers = NULL;
-        *result = res;
-        return BUCKETS_OK;
-    }
-    
     /* Allocate result structure */
     buckets_broadcast_result_t *res = buckets_calloc(1, sizeof(buckets_broadcast_result_t));
     if (!res) {
+        buckets_free(peers);
         return BUCKETS_ERR_NOMEM;
     }
     
     res->total = peer_count;
-    res->success = 0;
-    res->failed = 0;
+    if (peer_count == 0) {
+        /* No peers - return empty result */
+        buckets_free(peers);
+        *result = res;
+        return BUCKETS_OK;
+    }
     
     /* Allocate arrays for responses and failed peers (worst case: all succeed or all fail) */
     res->responses = buckets_calloc(peer_count, sizeof(buckets_rpc_response_t*));
     res->failed_peers = buckets_calloc(peer_count, sizeof(char*));
+    const char **endpoints = buckets_calloc(peer_count, sizeof(char*));
+    buckets_rpc_response_t **responses = buckets_calloc(peer_count, sizeof(buckets_rpc_response_t*));
     
-    if (!res->responses || !res->failed_peers) {
+    if (!res->responses || !res->failed_peers || !endpoints || !responses) {
+        buckets_free(endpoints);
+        buckets_free(responses);
         buckets_free(res->responses);
         buckets_free(res->failed_peers);
         buckets_free(res);
+        buckets_free(peers);
         return BUCKETS_ERR_NOMEM;
     }
     
-    /* Call RPC on each peer */
+    /* Offline peers are skipped (NULL endpoint) and reported as failed */
     for (int i = 0; i < peer_count; i++) {
-        buckets_peer_t *peer = peers[i];
-        
-        /* Skip offline peers */
-        if (!peer->online) {
-            char *failed_endpoint = buckets_malloc(strlen(peer->endpoint) + 1);
-            if (failed_endpoint) {
-                strcpy(failed_endpoint, peer->endpoint);
-                res->failed_peers[res->failed] = failed_endpoint;
-                res->failed++;
-            }
-            continue;
-        }
-        
-        /* Call RPC */
-        buckets_rpc_response_t *response = NULL;
-        int ret = buckets_rpc_call(ctx, peer->endpoint, method, params,
-                                    &response, timeout_ms);
-        
-        if (ret == BUCKETS_OK && response) {
-            /* Success - check if response indicates error */
-            if (response->error_code == 0) {
-                res->responses[res->success] = response;
-                res->success++;
-            } else {
-                /* RPC succeeded but handler returned error */
-                buckets_rpc_response_free(response);
-                char *failed_endpoint = buckets_malloc(strlen(peer->endpoint) + 1);
-                if (failed_endpoint) {
-                    strcpy(failed_endpoint, peer->endpoint);
-                    res->failed_peers[res->failed] = failed_endpoint;
-                    res->failed++;
-                }
-            }
+        endpoints[i] = peers[i]->online ? peers[i]->endpoint : NULL;
+    }
+    
+    /* Call every peer at once so the broadcast takes one round trip, not N */
+    buckets_rpc_fanout(ctx, endpoints, peer_count, method, params, responses, timeout_ms);
+    
+    /* Collect in peer order */
+    for (int i = 0; i < peer_count; i++) {
+        if (responses[i]) {
+            res->responses[res->success] = responses[i];
+            res->success++;
         } else {
-            /* RPC call failed */
-            if (response) {
-                buckets_rpc_response_free(response);
-            }
-            char *failed_endpoint = buckets_malloc(strlen(peer->endpoint) + 1);
-            if (failed_endpoint) {
-                strcpy(failed_endpoint, peer->endpoint);
-                res->failed_peers[res->failed] = failed_endpoint;
-                res->failed++;
-            }
+            add_failed_peer(res, peers[i]->endpoint);
         }
     }
     
+    buckets_free(endpoints);
+    buckets_free(responses);
+    buckets_free(peers);
+    
     buckets_debug("Broadcast: %s to %d peers: %d success, %d failed",
                   method, res->total, res->success, res->failed);
     
@@ -66,6 +66,7 @@ static int create_connection(const char *host, int port)
     int sockfd;
     
     /* Create socket */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SOCKET);
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
         buckets_error("Failed to create socket: %s", strerror(errno));
@@ -76,6 +77,7 @@ static int create_connection(const char *host, int port)
     server = gethostbyname(host);
     if (server == NULL) {
         buckets_error("Failed to resolve host %s", host);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         close(sockfd);
         return -1;
     }
@@ -90,6 +92,7 @@ static int create_connection(const char *host, int port)
     int flags = fcntl(sockfd, F_GETFL, 0);
     fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CONNECT);
     int connect_result = connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr));
     
     if (connect_result < 0) {
@@ -108,6 +111,7 @@ static int create_connection(const char *host, int port)
             if (select_result <= 0) {
                 /* Timeout or error */
                 buckets_error("Connection to %s:%d timed out or failed", host, port);
+                BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
                 close(sockfd);
                 return -1;
             }
@@ -118,12 +122,14 @@ static int create_connection(const char *host, int port)
             if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &sock_error, &len) < 0 || sock_error != 0) {
                 buckets_error("Failed to connect to %s:%d: %s", host, port, 
                              sock_error ? strerror(sock_error) : "unknown error");
+                BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
                 close(sockfd);
                 return -1;
             }
         } else {
             /* Immediate connection error (e.g., connection refused) */
             buckets_error("Failed to connect to %s:%d: %s", host, port, strerror(errno));
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
             close(sockfd);
             return -1;
         }
@@ -132,9 +138,32 @@ static int create_connection(const char *host, int port)
     /* Set socket back to blocking mode */
     fcntl(sockfd, F_SETFL, flags);
     
+    /* Mutual TLS when the cluster runs encrypted peer transport; bound the
+     * handshake like the request that follows */
+    if (buckets_peer_tls_enabled()) {
+        struct timeval timeout = { .tv_sec = 5, .tv_usec = 0 };
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (buckets_peer_tls_connect(sockfd, host, port) != BUCKETS_OK) {
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+            close(sockfd);
+            return -1;
+        }
+    }
+    
     return sockfd;
 }
 
+/**
+ * Close a pooled connection's socket and its TLS state
+ */
+static void close_connection_fd(int fd)
+{
+    buckets_peer_tls_close(fd);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+    close(fd);
+}
+
 /**
  * Check if connection is still alive (fast check)
  * 
@@ -149,6 +178,7 @@ static bool is_connection_alive(int fd)
     pfd.events = POLLIN | POLLERR | POLLHUP | POLLNVAL;
     pfd.revents = 0;
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_POLL);
     int ret = poll(&pfd, 1, 0);  /* Non-blocking check */
     
     if (ret < 0) {
@@ -164,6 +194,7 @@ static bool is_connection_alive(int fd)
     if (pfd.revents & POLLIN) {
         /* There's data waiting - check if it's EOF or actual data */
         char buf[1];
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
         ssize_t result = recv(fd, buf, 1, MSG_PEEK | MSG_DONTWAIT);
         
         if (result == 0) {
@@ -244,7 +275,7 @@ int buckets_conn_pool_get(buckets_conn_pool_t *pool,
             } else {
                 /* Connection is dead, remove it */
                 buckets_debug("Removing dead connection to %s:%d (fd=%d)", host, port, cur->fd);
-                close(cur->fd);
+                close_connection_fd(cur->fd);
                 
                 if (prev) {
                     prev->next = cur->next;
@@ -287,7 +318,7 @@ int buckets_conn_pool_get(buckets_conn_pool_t *pool,
     /* Allocate connection structure */
     buckets_connection_t *new_conn = buckets_calloc(1, sizeof(buckets_connection_t));
     if (!new_conn) {
-        close(fd);
+        close_connection_fd(fd);
         return BUCKETS_ERR_NOMEM;
     }
     
@@ -303,7 +334,7 @@ int buckets_conn_pool_get(buckets_conn_pool_t *pool,
     /* Check limit again (could have changed while we were creating connection) */
     if (pool->max_conns > 0 && pool->total_conns >= pool->max_conns) {
         pthread_mutex_unlock(&pool->lock);
-        close(fd);
+        close_connection_fd(fd);
         buckets_free(new_conn);
         buckets_error("Connection pool limit reached (%d) after connect", pool->max_conns);
         return BUCKETS_ERR_NOMEM;
@@ -372,7 +403,7 @@ int buckets_conn_pool_close(buckets_conn_pool_t *pool,
             }
             
             /* Close socket */
-            close(cur->fd);
+            close_connection_fd(cur->fd);
             
             /* Update counters */
             pool->total_conns--;
@@ -430,7 +461,7 @@ void buckets_conn_pool_free(buckets_conn_pool_t *pool)
     buckets_connection_t *cur = pool->connections;
     while (cur) {
         buckets_connection_t *next = cur->next;
-        close(cur->fd);
+        close_connection_fd(cur->fd);
         buckets_free(cur);
         cur = next;
     }
@@ -491,7 +522,8 @@ int buckets_conn_send_request(buckets_connection_t *conn,
     }
     
     /* Send headers */
-    ssize_t sent = send(conn->fd, headers, header_len, 0);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SEND);
+    ssize_t sent = buckets_peer_send(conn->fd, headers, header_len);
     if (sent < 0) {
         buckets_error("Failed to send request headers: %s", strerror(errno));
         return BUCKETS_ERR_IO;
@@ -501,7 +533,8 @@ int buckets_conn_send_request(buckets_connection_t *conn,
     if (body && body_len > 0) {
         size_t total_sent = 0;
         while (total_sent < body_len) {
-            ssize_t n = send(conn->fd, body + total_sent, body_len - total_sent, 0);
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SEND);
+            ssize_t n = buckets_peer_send(conn->fd, body + total_sent, body_len - total_sent);
             if (n < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     /* Timeout or would block - retry */
@@ -535,8 +568,9 @@ int buckets_conn_send_request(buckets_connection_t *conn,
     
     /* Read in chunks until we find \r\n\r\n (end of headers) */
     while (header_bytes < sizeof(header_buffer) - 256) {
-        ssize_t n = recv(conn->fd, header_buffer + header_bytes, 
-                        sizeof(header_buffer) - header_bytes - 1, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t n = buckets_peer_recv(conn->fd, header_buffer + header_bytes, 
+                                      sizeof(header_buffer) - header_bytes - 1);
         if (n < 0) {
             buckets_error("Failed to receive response headers: %s", strerror(errno));
             return BUCKETS_ERR_IO;
@@ -600,8 +634,9 @@ int buckets_conn_send_request(buckets_connection_t *conn,
         
         /* Read remaining body */
         while (total_body_bytes < content_length) {
-            ssize_t n = recv(conn->fd, body_data + total_body_bytes,
-                           content_length - total_body_bytes, 0);
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+            ssize_t n = buckets_peer_recv(conn->fd, body_data + total_body_bytes,
+                                          content_length - total_body_bytes);
             if (n < 0) {
                 buckets_error("Failed to receive response body: %s", strerror(errno));
                 buckets_free(body_data);
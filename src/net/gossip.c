@@ -0,0 +1,1737 @@
+/**
+ * Gossip Membership Implementation
+ *
+ * SWIM failure detection with piggybacked dissemination, carried over the
+ * existing JSON-RPC transport. Three methods:
+ *
+ *   gossip.ping        - answered inline with an ack and piggybacked updates
+ *   gossip.pingReq     - queued for a relay thread, which pings the target
+ *                        and reports success with gossip.indirectAck
+ *   gossip.indirectAck - wakes the prober waiting on that probe
+ *
+ * RPC handlers run on the server's event loop, so none of them makes an
+ * outgoing call; the ping-req relay is asynchronous for that reason.
+ *
+ * With forked workers, one process per node (the agent) runs the protocol.
+ * The others follow: peers' messages that SO_REUSEPORT hands them are
+ * answered for the node and forwarded to the agent through a shared
+ * segment, and the agent mirrors its incarnation and member states back
+ * into it for them to read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+#include "cJSON.h"
+
+#define GOSSIP_SEEN_SLOTS      512     /* Recent invalidation IDs */
+#define GOSSIP_MAX_UPDATES     1024    /* Queued updates kept */
+#define GOSSIP_MAX_EVENTS      32      /* Callbacks raised per message */
+#define GOSSIP_RELAY_QUEUE     64      /* Pending ping-req relays */
+#define GOSSIP_RELAY_THREADS   2
+
+#define GOSSIP_SHARED_MEMBERS  256     /* Members mirrored to followers */
+#define GOSSIP_INBOX_SLOTS     256     /* Messages forwarded to the agent */
+#define GOSSIP_INBOX_MSG_MAX   8192    /* Largest forwarded message */
+#define GOSSIP_INBOX_WAIT_MS   100
+
+#define PHI_MIN_STDDEV_MS      100.0
+
+/* ===================================================================
+ * Structures
+ * ===================================================================*/
+
+typedef struct {
+    char node_id[64];
+    char endpoint[256];
+    buckets_member_state_t state;
+    u64 incarnation;
+    u64 state_since_ms;                /* When the state was entered */
+    buckets_phi_detector_t phi;
+} gossip_member_t;
+
+typedef enum {
+    UPDATE_MEMBER = 0,
+    UPDATE_TOPOLOGY,
+    UPDATE_INVALIDATE
+} update_kind_t;
+
+typedef struct gossip_update {
+    update_kind_t kind;
+    buckets_member_state_t state;      /* MEMBER */
+    char node_id[64];                  /* MEMBER */
+    char endpoint[256];                /* MEMBER */
+    u64 incarnation;                   /* MEMBER */
+    i64 generation;                    /* TOPOLOGY */
+    u64 id;                            /* INVALIDATE */
+    char *bucket;                      /* INVALIDATE */
+    char *object;                      /* INVALIDATE */
+    u32 transmits;
+    struct gossip_update *next;
+} gossip_update_t;
+
+/* Callbacks collected under the lock and raised after it is released */
+typedef struct {
+    update_kind_t kind;
+    buckets_member_state_t state;
+    char node_id[64];
+    char endpoint[256];
+    char *bucket;
+    char *object;
+} gossip_event_t;
+
+typedef struct {
+    gossip_event_t events[GOSSIP_MAX_EVENTS];
+    int count;
+} gossip_events_t;
+
+typedef struct {
+    char requester[256];               /* Where to send the indirect ack */
+    char target[256];
+    char target_id[64];
+    u64 seq;
+} relay_job_t;
+
+/* Shared between the workers of one node (anonymous MAP_SHARED mapping) */
+typedef struct {
+    char node_id[64];
+    char endpoint[256];
+    u32 state;
+    u64 incarnation;
+} gossip_shared_member_t;
+
+typedef struct {
+    char method[32];
+    char params[GOSSIP_INBOX_MSG_MAX];
+} gossip_inbox_slot_t;
+
+struct buckets_gossip_shared {
+    pthread_mutex_t lock;              /* Process-shared, robust */
+    pthread_cond_t inbox_cond;         /* Process-shared */
+    bool agent_running;
+    u64 incarnation;                   /* The agent's */
+    u32 member_count;
+    gossip_shared_member_t members[GOSSIP_SHARED_MEMBERS];
+    u32 inbox_head;
+    u32 inbox_count;
+    gossip_inbox_slot_t inbox[GOSSIP_INBOX_SLOTS];
+};
+
+struct buckets_gossip {
+    buckets_rpc_context_t *rpc;
+    buckets_gossip_config_t config;
+    buckets_gossip_callbacks_t callbacks;
+    char node_id[64];
+    char endpoint[256];
+
+    pthread_mutex_t lock;
+    u64 incarnation;
+    i64 topology_generation;
+    i64 topology_pending;              /* Learned, callback not yet raised */
+
+    gossip_member_t *members;
+    int member_count;
+    int member_cap;
+    int probe_pos;                     /* Round-robin position */
+    u64 rng;
+
+    gossip_update_t *updates;          /* Newest first */
+    int update_count;
+    u64 seen[GOSSIP_SEEN_SLOTS];
+    u32 seen_next;
+    u64 invalidation_seq;
+
+    /* Indirect probe in progress */
+    pthread_cond_t ack_cond;
+    u64 probe_seq;
+    bool probe_acked;
+
+    /* Ping-req relay */
+    relay_job_t relay[GOSSIP_RELAY_QUEUE];
+    int relay_head;
+    int relay_count;
+    pthread_cond_t relay_cond;
+    pthread_t relay_threads[GOSSIP_RELAY_THREADS];
+
+    pthread_t thread;
+    bool running;
+    pthread_cond_t stop_cond;
+
+    /* Workers of one node: the agent runs the protocol, followers forward */
+    buckets_gossip_shared_t *shared;
+    bool follower;
+    pthread_t inbox_thread;
+
+    buckets_gossip_stats_t stats;
+};
+
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static u64 now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+static struct timespec deadline_ts(u64 deadline_ms)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ms / 1000),
+        .tv_nsec = (long)(deadline_ms % 1000) * 1000000
+    };
+    return ts;
+}
+
+static int cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    int ret = pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return ret;
+}
+
+static u64 next_random(buckets_gossip_t *g)
+{
+    /* xorshift64*, under the lock */
+    g->rng ^= g->rng >> 12;
+    g->rng ^= g->rng << 25;
+    g->rng ^= g->rng >> 27;
+    return g->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static int env_int(const char *name, int def)
+{
+    const char *env = getenv(name);
+    if (!env || !*env) {
+        return def;
+    }
+    int value = atoi(env);
+    return value > 0 ? value : def;
+}
+
+static u64 hash_str(const char *s)
+{
+    u64 h = 0xcbf29ce484222325ULL;
+    for (; *s; s++) {
+        h = (h ^ (u8)*s) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static gossip_member_t* find_member(buckets_gossip_t *g, const char *node_id)
+{
+    for (int i = 0; i < g->member_count; i++) {
+        if (strcmp(g->members[i].node_id, node_id) == 0) {
+            return &g->members[i];
+        }
+    }
+    return NULL;
+}
+
+static gossip_member_t* add_member_locked(buckets_gossip_t *g, const char *node_id,
+                                          const char *endpoint, u64 incarnation)
+{
+    if (g->member_count == g->member_cap) {
+        int cap = g->member_cap ? g->member_cap * 2 : 16;
+        gossip_member_t *members = buckets_realloc(g->members, cap * sizeof(gossip_member_t));
+        if (!members) {
+            return NULL;
+        }
+        g->members = members;
+        g->member_cap = cap;
+    }
+
+    gossip_member_t *m = &g->members[g->member_count++];
+    memset(m, 0, sizeof(*m));
+    snprintf(m->node_id, sizeof(m->node_id), "%s", node_id);
+    snprintf(m->endpoint, sizeof(m->endpoint), "%s", endpoint);
+    m->state = BUCKETS_MEMBER_ALIVE;
+    m->incarnation = incarnation;
+    m->state_since_ms = now_ms();
+    return m;
+}
+
+/* log10 of the cluster size, at least 1: scales retransmits and suspicion */
+static double cluster_scale(buckets_gossip_t *g)
+{
+    double scale = log10((double)g->member_count + 2.0);
+    return scale < 1.0 ? 1.0 : scale;
+}
+
+/* ===================================================================
+ * Phi-Accrual Detector
+ * ===================================================================*/
+
+void buckets_phi_heartbeat(buckets_phi_detector_t *detector, u64 now)
+{
+    if (!detector) {
+        return;
+    }
+    if (detector->last_ms != 0 && now > detector->last_ms) {
+        detector->intervals[detector->next] = (double)(now - detector->last_ms);
+        detector->next = (detector->next + 1) % BUCKETS_PHI_WINDOW;
+        if (detector->count < BUCKETS_PHI_WINDOW) {
+            detector->count++;
+        }
+    }
+    detector->last_ms = now;
+}
+
+double buckets_phi_value(const buckets_phi_detector_t *detector, u64 now)
+{
+    if (!detector || detector->count == 0 || now <= detector->last_ms) {
+        return 0.0;
+    }
+
+    double mean = 0.0;
+    for (int i = 0; i < detector->count; i++) {
+        mean += detector->intervals[i];
+    }
+    mean /= detector->count;
+
+    double var = 0.0;
+    for (int i = 0; i < detector->count; i++) {
+        double d = detector->intervals[i] - mean;
+        var += d * d;
+    }
+    double stddev = sqrt(var / detector->count);
+    if (stddev < PHI_MIN_STDDEV_MS) {
+        stddev = PHI_MIN_STDDEV_MS;
+    }
+
+    /* Logistic approximation of the normal CDF (as in Akka's detector) */
+    double elapsed = (double)(now - detector->last_ms);
+    double y = (elapsed - mean) / stddev;
+    double e = exp(-y * (1.5976 + 0.070566 * y * y));
+    double p_later = elapsed > mean ? e / (1.0 + e) : 1.0 - 1.0 / (1.0 + e);
+    if (p_later < 1e-300) {
+        p_later = 1e-300;
+    }
+    return -log10(p_later);
+}
+
+/* ===================================================================
+ * Update Queue
+ * ===================================================================*/
+
+static void update_free(gossip_update_t *u)
+{
+    buckets_free(u->bucket);
+    buckets_free(u->object);
+    buckets_free(u);
+}
+
+static void queue_update(buckets_gossip_t *g, gossip_update_t *u)
+{
+    /* Newer news about the same member or topology replaces the old */
+    if (u->kind != UPDATE_INVALIDATE) {
+        gossip_update_t **link = &g->updates;
+        while (*link) {
+            gossip_update_t *cur = *link;
+            if (cur->kind == u->kind &&
+                (u->kind == UPDATE_TOPOLOGY || strcmp(cur->node_id, u->node_id) == 0)) {
+                *link = cur->next;
+                update_free(cur);
+                g->update_count--;
+                break;
+            }
+            link = &cur->next;
+        }
+    }
+
+    u->transmits = 0;
+    u->next = g->updates;
+    g->updates = u;
+    g->update_count++;
+
+    /* Drop the oldest when flooded */
+    if (g->update_count > GOSSIP_MAX_UPDATES) {
+        gossip_update_t **link = &g->updates;
+        while ((*link)->next) {
+            link = &(*link)->next;
+        }
+        update_free(*link);
+        *link = NULL;
+        g->update_count--;
+    }
+}
+
+static void queue_member(buckets_gossip_t *g, buckets_member_state_t state,
+                         const char *node_id, const char *endpoint, u64 incarnation)
+{
+    gossip_update_t *u = buckets_calloc(1, sizeof(gossip_update_t));
+    if (!u) {
+        return;
+    }
+    u->kind = UPDATE_MEMBER;
+    u->state = state;
+    snprintf(u->node_id, sizeof(u->node_id), "%s", node_id);
+    snprintf(u->endpoint, sizeof(u->endpoint), "%s", endpoint);
+    u->incarnation = incarnation;
+    queue_update(g, u);
+}
+
+static void add_update_json(cJSON *array, const gossip_update_t *u)
+{
+    cJSON *item = cJSON_CreateObject();
+    char id[32];
+    switch (u->kind) {
+        case UPDATE_MEMBER:
+            cJSON_AddStringToObject(item, "t", "m");
+            cJSON_AddNumberToObject(item, "s", u->state);
+            cJSON_AddStringToObject(item, "n", u->node_id);
+            cJSON_AddStringToObject(item, "e", u->endpoint);
+            cJSON_AddNumberToObject(item, "i", (double)u->incarnation);
+            break;
+        case UPDATE_TOPOLOGY:
+            cJSON_AddStringToObject(item, "t", "g");
+            cJSON_AddNumberToObject(item, "g", (double)u->generation);
+            break;
+        case UPDATE_INVALIDATE:
+            snprintf(id, sizeof(id), "%016llx", (unsigned long long)u->id);
+            cJSON_AddStringToObject(item, "t", "x");
+            cJSON_AddStringToObject(item, "id", id);
+            cJSON_AddStringToObject(item, "b", u->bucket);
+            cJSON_AddStringToObject(item, "o", u->object);
+            break;
+    }
+    cJSON_AddItemToArray(array, item);
+}
+
+/**
+ * Take the least-sent updates for one message
+ *
+ * New updates sit at the head, so the first few are the least sent. Each
+ * is retired after retransmit_mult * log10(N) sends, which reaches the
+ * whole cluster with high probability.
+ */
+static cJSON* take_piggyback(buckets_gossip_t *g)
+{
+    cJSON *array = cJSON_CreateArray();
+    u32 limit = (u32)ceil(g->config.retransmit_mult * cluster_scale(g));
+
+    int taken = 0;
+    for (gossip_update_t *u = g->updates; u && taken < g->config.max_piggyback; u = u->next) {
+        add_update_json(array, u);
+        u->transmits++;
+        taken++;
+    }
+    g->stats.updates_sent += taken;
+
+    gossip_update_t **link = &g->updates;
+    while (*link) {
+        gossip_update_t *cur = *link;
+        if (cur->transmits >= limit) {
+            *link = cur->next;
+            update_free(cur);
+            g->update_count--;
+        } else {
+            link = &cur->next;
+        }
+    }
+    return array;
+}
+
+/* ===================================================================
+ * Merging
+ * ===================================================================*/
+
+static gossip_event_t* add_event(gossip_events_t *events, update_kind_t kind)
+{
+    if (events->count >= GOSSIP_MAX_EVENTS) {
+        return NULL;
+    }
+    gossip_event_t *ev = &events->events[events->count++];
+    memset(ev, 0, sizeof(*ev));
+    ev->kind = kind;
+    return ev;
+}
+
+static void member_event(gossip_events_t *events, const gossip_member_t *m)
+{
+    gossip_event_t *ev = add_event(events, UPDATE_MEMBER);
+    if (ev) {
+        ev->state = m->state;
+        memcpy(ev->node_id, m->node_id, sizeof(ev->node_id));
+        memcpy(ev->endpoint, m->endpoint, sizeof(ev->endpoint));
+    }
+}
+
+static void set_state(buckets_gossip_t *g, gossip_member_t *m,
+                      buckets_member_state_t state, u64 incarnation,
+                      gossip_events_t *events)
+{
+    bool changed = m->state != state;
+    m->incarnation = incarnation;
+    if (changed) {
+        m->state = state;
+        m->state_since_ms = now_ms();
+        member_event(events, m);
+    }
+    queue_member(g, state, m->node_id, m->endpoint, incarnation);
+}
+
+/**
+ * Apply a membership update (SWIM precedence rules)
+ *
+ * Alive overrides anything with a lower incarnation; suspect overrides
+ * alive at the same incarnation; dead overrides both. Suspicion of
+ * ourselves is refuted by raising our incarnation.
+ */
+static void apply_member(buckets_gossip_t *g, buckets_member_state_t state,
+                         const char *node_id, const char *endpoint, u64 incarnation,
+                         gossip_events_t *events)
+{
+    if (strcmp(node_id, g->node_id) == 0) {
+        if (state != BUCKETS_MEMBER_ALIVE && incarnation >= g->incarnation) {
+            g->incarnation = incarnation + 1;
+            queue_member(g, BUCKETS_MEMBER_ALIVE, g->node_id, g->endpoint, g->incarnation);
+            g->stats.refutations++;
+            buckets_warn("Gossip: refuting suspicion of this node (incarnation %llu)",
+                         (unsigned long long)g->incarnation);
+        }
+        return;
+    }
+
+    gossip_member_t *m = find_member(g, node_id);
+    if (!m) {
+        if (state == BUCKETS_MEMBER_DEAD || !endpoint || !*endpoint) {
+            return;
+        }
+        m = add_member_locked(g, node_id, endpoint, incarnation);
+        if (m) {
+            m->state = state;
+            member_event(events, m);
+            queue_member(g, state, node_id, endpoint, incarnation);
+        }
+        return;
+    }
+
+    switch (state) {
+        case BUCKETS_MEMBER_ALIVE:
+            if (incarnation > m->incarnation) {
+                if (endpoint && *endpoint) {
+                    snprintf(m->endpoint, sizeof(m->endpoint), "%s", endpoint);
+                }
+                set_state(g, m, BUCKETS_MEMBER_ALIVE, incarnation, events);
+            }
+            break;
+        case BUCKETS_MEMBER_SUSPECT:
+            if (incarnation > m->incarnation ||
+                (incarnation == m->incarnation && m->state == BUCKETS_MEMBER_ALIVE)) {
+                set_state(g, m, BUCKETS_MEMBER_SUSPECT, incarnation, events);
+            }
+            break;
+        case BUCKETS_MEMBER_DEAD:
+            if (incarnation >= m->incarnation && m->state != BUCKETS_MEMBER_DEAD) {
+                set_state(g, m, BUCKETS_MEMBER_DEAD, incarnation, events);
+            }
+            break;
+    }
+}
+
+static bool seen_invalidation(buckets_gossip_t *g, u64 id)
+{
+    for (int i = 0; i < GOSSIP_SEEN_SLOTS; i++) {
+        if (g->seen[i] == id) {
+            return true;
+        }
+    }
+    g->seen[g->seen_next] = id;
+    g->seen_next = (g->seen_next + 1) % GOSSIP_SEEN_SLOTS;
+    return false;
+}
+
+static void apply_update(buckets_gossip_t *g, cJSON *item, gossip_events_t *events)
+{
+    cJSON *type = cJSON_GetObjectItem(item, "t");
+    if (!cJSON_IsString(type)) {
+        return;
+    }
+    g->stats.updates_received++;
+
+    if (strcmp(type->valuestring, "m") == 0) {
+        cJSON *s = cJSON_GetObjectItem(item, "s");
+        cJSON *n = cJSON_GetObjectItem(item, "n");
+        cJSON *e = cJSON_GetObjectItem(item, "e");
+        cJSON *i = cJSON_GetObjectItem(item, "i");
+        if (!cJSON_IsNumber(s) || !cJSON_IsString(n) || !cJSON_IsNumber(i) ||
+            s->valueint < BUCKETS_MEMBER_ALIVE || s->valueint > BUCKETS_MEMBER_DEAD) {
+            return;
+        }
+        apply_member(g, (buckets_member_state_t)s->valueint, n->valuestring,
+                     cJSON_IsString(e) ? e->valuestring : NULL,
+                     (u64)i->valuedouble, events);
+    } else if (strcmp(type->valuestring, "g") == 0) {
+        cJSON *gen = cJSON_GetObjectItem(item, "g");
+        if (!cJSON_IsNumber(gen) || (i64)gen->valuedouble <= g->topology_generation) {
+            return;
+        }
+        g->topology_generation = (i64)gen->valuedouble;
+        gossip_update_t *u = buckets_calloc(1, sizeof(gossip_update_t));
+        if (u) {
+            u->kind = UPDATE_TOPOLOGY;
+            u->generation = g->topology_generation;
+            queue_update(g, u);
+        }
+        /* Raised from the protocol thread: the callback may reload from disk */
+        g->topology_pending = g->topology_generation;
+    } else if (strcmp(type->valuestring, "x") == 0) {
+        cJSON *id = cJSON_GetObjectItem(item, "id");
+        cJSON *b = cJSON_GetObjectItem(item, "b");
+        cJSON *o = cJSON_GetObjectItem(item, "o");
+        if (!cJSON_IsString(id) || !cJSON_IsString(b) || !cJSON_IsString(o)) {
+            return;
+        }
+        u64 uid = strtoull(id->valuestring, NULL, 16);
+        if (seen_invalidation(g, uid)) {
+            return;
+        }
+        gossip_update_t *u = buckets_calloc(1, sizeof(gossip_update_t));
+        if (u) {
+            u->kind = UPDATE_INVALIDATE;
+            u->id = uid;
+            u->bucket = buckets_strdup(b->valuestring);
+            u->object = buckets_strdup(o->valuestring);
+            queue_update(g, u);
+        }
+        gossip_event_t *ev = add_event(events, UPDATE_INVALIDATE);
+        if (ev) {
+            ev->bucket = buckets_strdup(b->valuestring);
+            ev->object = buckets_strdup(o->valuestring);
+        }
+    }
+}
+
+/**
+ * Merge a message: the sender is alive (and a heartbeat for its
+ * detector), then each piggybacked update
+ */
+static void merge_message(buckets_gossip_t *g, cJSON *msg, gossip_events_t *events)
+{
+    cJSON *from = cJSON_GetObjectItem(msg, "from");
+    cJSON *endpoint = cJSON_GetObjectItem(msg, "endpoint");
+    cJSON *inc = cJSON_GetObjectItem(msg, "inc");
+    if (cJSON_IsString(from) && cJSON_IsNumber(inc)) {
+        apply_member(g, BUCKETS_MEMBER_ALIVE, from->valuestring,
+                     cJSON_IsString(endpoint) ? endpoint->valuestring : NULL,
+                     (u64)inc->valuedouble, events);
+        gossip_member_t *m = find_member(g, from->valuestring);
+        if (m) {
+            buckets_phi_heartbeat(&m->phi, now_ms());
+        }
+    }
+
+    cJSON *updates = cJSON_GetObjectItem(msg, "updates");
+    cJSON *item;
+    int applied = 0;
+    cJSON_ArrayForEach(item, updates) {
+        if (applied++ >= GOSSIP_MAX_EVENTS - 1) {
+            break;
+        }
+        apply_update(g, item, events);
+    }
+}
+
+static void fire_events(buckets_gossip_t *g, gossip_events_t *events)
+{
+    buckets_gossip_callbacks_t *cb = &g->callbacks;
+    for (int i = 0; i < events->count; i++) {
+        gossip_event_t *ev = &events->events[i];
+        switch (ev->kind) {
+            case UPDATE_MEMBER:
+                if (cb->member_changed) {
+                    cb->member_changed(ev->node_id, ev->endpoint, ev->state, cb->user_data);
+                }
+                break;
+            case UPDATE_TOPOLOGY:
+                break;
+            case UPDATE_INVALIDATE:
+                if (cb->invalidate && ev->bucket && ev->object) {
+                    cb->invalidate(ev->bucket, ev->object, cb->user_data);
+                }
+                buckets_free(ev->bucket);
+                buckets_free(ev->object);
+                break;
+        }
+    }
+    events->count = 0;
+}
+
+/* Message header plus piggyback; caller holds the lock */
+static cJSON* build_message(buckets_gossip_t *g)
+{
+    cJSON *msg = cJSON_CreateObject();
+    cJSON_AddStringToObject(msg, "from", g->node_id);
+    cJSON_AddStringToObject(msg, "endpoint", g->endpoint);
+    cJSON_AddNumberToObject(msg, "inc", (double)g->incarnation);
+    cJSON_AddItemToObject(msg, "updates", take_piggyback(g));
+    return msg;
+}
+
+/* ===================================================================
+ * Shared Segment (forked workers)
+ * ===================================================================*/
+
+/* A worker died holding the lock: the agent rewrites the member table
+ * every period, but a half-copied inbox slot can't be trusted */
+static void shared_recover(buckets_gossip_shared_t *s)
+{
+    s->inbox_head = 0;
+    s->inbox_count = 0;
+    pthread_mutex_consistent(&s->lock);
+    buckets_warn("Gossip: reset the shared inbox after its holder died");
+}
+
+static void shared_lock(buckets_gossip_shared_t *s)
+{
+    if (pthread_mutex_lock(&s->lock) == EOWNERDEAD) {
+        shared_recover(s);
+    }
+}
+
+/* Mirror incarnation and member states for the followers; caller holds g->lock */
+static void shared_publish_locked(buckets_gossip_t *g)
+{
+    buckets_gossip_shared_t *s = g->shared;
+    if (!s || g->follower) {
+        return;
+    }
+
+    shared_lock(s);
+    s->incarnation = g->incarnation;
+    u32 n = 0;
+    for (int i = 0; i < g->member_count && n < GOSSIP_SHARED_MEMBERS; i++, n++) {
+        gossip_member_t *m = &g->members[i];
+        gossip_shared_member_t *out = &s->members[n];
+        memcpy(out->node_id, m->node_id, sizeof(out->node_id));
+        memcpy(out->endpoint, m->endpoint, sizeof(out->endpoint));
+        out->state = m->state;
+        out->incarnation = m->incarnation;
+    }
+    s->member_count = n;
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * Queue a message for the agent (follower)
+ *
+ * @return true if queued; false if the agent is not running, its inbox is
+ *         full or the message is too large
+ */
+static bool forward_to_agent(buckets_gossip_t *g, const char *method, cJSON *params)
+{
+    char *text = cJSON_PrintUnformatted(params);
+    if (!text) {
+        return false;
+    }
+    size_t len = strlen(text);
+
+    buckets_gossip_shared_t *s = g->shared;
+    bool queued = false;
+    shared_lock(s);
+    if (s->agent_running && len < GOSSIP_INBOX_MSG_MAX && s->inbox_count < GOSSIP_INBOX_SLOTS) {
+        gossip_inbox_slot_t *slot = &s->inbox[(s->inbox_head + s->inbox_count) % GOSSIP_INBOX_SLOTS];
+        snprintf(slot->method, sizeof(slot->method), "%s", method);
+        memcpy(slot->params, text, len + 1);
+        s->inbox_count++;
+        pthread_cond_signal(&s->inbox_cond);
+        queued = true;
+    }
+    pthread_mutex_unlock(&s->lock);
+    cJSON_free(text);
+
+    pthread_mutex_lock(&g->lock);
+    if (queued) {
+        g->stats.forwarded++;
+    } else {
+        g->stats.forward_drops++;
+    }
+    pthread_mutex_unlock(&g->lock);
+    return queued;
+}
+
+/* Answer for the node with the agent's incarnation (follower) */
+static cJSON* build_follower_message(buckets_gossip_t *g)
+{
+    shared_lock(g->shared);
+    u64 incarnation = g->shared->incarnation;
+    pthread_mutex_unlock(&g->shared->lock);
+
+    cJSON *msg = cJSON_CreateObject();
+    cJSON_AddStringToObject(msg, "from", g->node_id);
+    cJSON_AddStringToObject(msg, "endpoint", g->endpoint);
+    cJSON_AddNumberToObject(msg, "inc", (double)incarnation);
+    cJSON_AddItemToObject(msg, "updates", cJSON_CreateArray());
+    return msg;
+}
+
+/* ===================================================================
+ * RPC Handlers (event loop; no outgoing calls)
+ * ===================================================================*/
+
+/**
+ * Queue a ping-req for a relay thread; caller holds the lock
+ *
+ * @return true if accepted
+ */
+static bool queue_relay_locked(buckets_gossip_t *g, cJSON *params)
+{
+    cJSON *endpoint = cJSON_GetObjectItem(params, "endpoint");
+    cJSON *target = cJSON_GetObjectItem(params, "target");
+    cJSON *target_id = cJSON_GetObjectItem(params, "target_id");
+    cJSON *seq = cJSON_GetObjectItem(params, "seq");
+    if (!g->running || g->relay_count >= GOSSIP_RELAY_QUEUE ||
+        !cJSON_IsString(endpoint) || !cJSON_IsString(target) ||
+        !cJSON_IsString(target_id) || !cJSON_IsNumber(seq)) {
+        return false;
+    }
+
+    relay_job_t *job = &g->relay[(g->relay_head + g->relay_count) % GOSSIP_RELAY_QUEUE];
+    snprintf(job->requester, sizeof(job->requester), "%s", endpoint->valuestring);
+    snprintf(job->target, sizeof(job->target), "%s", target->valuestring);
+    snprintf(job->target_id, sizeof(job->target_id), "%s", target_id->valuestring);
+    job->seq = (u64)seq->valuedouble;
+    g->relay_count++;
+    pthread_cond_signal(&g->relay_cond);
+    return true;
+}
+
+/* Wake the prober if this acks its probe; caller holds the lock */
+static void ack_probe_locked(buckets_gossip_t *g, cJSON *params)
+{
+    cJSON *seq = cJSON_GetObjectItem(params, "seq");
+    if (cJSON_IsNumber(seq) && (u64)seq->valuedouble == g->probe_seq) {
+        g->probe_acked = true;
+        pthread_cond_broadcast(&g->ack_cond);
+    }
+}
+
+static int handle_ping(const char *method, cJSON *params, cJSON **result,
+                       int *error_code, char *error_message, void *user_data)
+{
+    (void)error_code;
+    (void)error_message;
+    buckets_gossip_t *g = user_data;
+    gossip_events_t events = { .count = 0 };
+
+    if (g->follower) {
+        forward_to_agent(g, method, params);
+        *result = build_follower_message(g);
+        return BUCKETS_OK;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    merge_message(g, params, &events);
+    *result = build_message(g);
+
+    /* Tell a sender we think is suspect or dead, so it can refute now */
+    cJSON *from = cJSON_GetObjectItem(params, "from");
+    gossip_member_t *m = cJSON_IsString(from) ? find_member(g, from->valuestring) : NULL;
+    if (m && m->state != BUCKETS_MEMBER_ALIVE) {
+        gossip_update_t notice = {
+            .kind = UPDATE_MEMBER,
+            .state = m->state,
+            .incarnation = m->incarnation
+        };
+        memcpy(notice.node_id, m->node_id, sizeof(notice.node_id));
+        memcpy(notice.endpoint, m->endpoint, sizeof(notice.endpoint));
+        add_update_json(cJSON_GetObjectItem(*result, "updates"), &notice);
+    }
+    pthread_mutex_unlock(&g->lock);
+
+    fire_events(g, &events);
+    return BUCKETS_OK;
+}
+
+static int handle_ping_req(const char *method, cJSON *params, cJSON **result,
+                           int *error_code, char *error_message, void *user_data)
+{
+    buckets_gossip_t *g = user_data;
+    if (!cJSON_IsString(cJSON_GetObjectItem(params, "endpoint")) ||
+        !cJSON_IsString(cJSON_GetObjectItem(params, "target")) ||
+        !cJSON_IsString(cJSON_GetObjectItem(params, "target_id")) ||
+        !cJSON_IsNumber(cJSON_GetObjectItem(params, "seq"))) {
+        *error_code = BUCKETS_ERR_INVALID_ARG;
+        snprintf(error_message, 256, "Malformed ping request");
+        return BUCKETS_OK;
+    }
+
+    if (g->follower) {
+        /* The agent's relay threads make the call */
+        bool accepted = forward_to_agent(g, method, params);
+        *result = build_follower_message(g);
+        cJSON_AddBoolToObject(*result, "accepted", accepted);
+        return BUCKETS_OK;
+    }
+
+    gossip_events_t events = { .count = 0 };
+    pthread_mutex_lock(&g->lock);
+    merge_message(g, params, &events);
+    bool accepted = queue_relay_locked(g, params);
+    *result = build_message(g);
+    cJSON_AddBoolToObject(*result, "accepted", accepted);
+    pthread_mutex_unlock(&g->lock);
+
+    fire_events(g, &events);
+    return BUCKETS_OK;
+}
+
+static int handle_indirect_ack(const char *method, cJSON *params, cJSON **result,
+                               int *error_code, char *error_message, void *user_data)
+{
+    (void)error_code;
+    (void)error_message;
+    buckets_gossip_t *g = user_data;
+
+    if (g->follower) {
+        forward_to_agent(g, method, params);
+    } else {
+        pthread_mutex_lock(&g->lock);
+        ack_probe_locked(g, params);
+        pthread_mutex_unlock(&g->lock);
+    }
+
+    *result = cJSON_CreateObject();
+    return BUCKETS_OK;
+}
+
+static void publish_topology_locked(buckets_gossip_t *g, i64 generation)
+{
+    if (generation > g->topology_generation) {
+        g->topology_generation = generation;
+        gossip_update_t *u = buckets_calloc(1, sizeof(gossip_update_t));
+        if (u) {
+            u->kind = UPDATE_TOPOLOGY;
+            u->generation = generation;
+            queue_update(g, u);
+        }
+    }
+}
+
+static void publish_invalidation_locked(buckets_gossip_t *g, const char *bucket,
+                                        const char *object)
+{
+    gossip_update_t *u = buckets_calloc(1, sizeof(gossip_update_t));
+    if (!u) {
+        return;
+    }
+    u->kind = UPDATE_INVALIDATE;
+    u->bucket = buckets_strdup(bucket);
+    u->object = buckets_strdup(object);
+
+    g->invalidation_seq++;
+    u->id = hash_str(g->node_id) ^ (g->invalidation_seq * 0x9E3779B97F4A7C15ULL);
+    seen_invalidation(g, u->id);
+    queue_update(g, u);
+}
+
+/**
+ * Apply a message a follower forwarded (agent)
+ *
+ * Handled as if it had arrived here, except that nothing is answered: the
+ * follower already replied for the node.
+ */
+static void absorb_forwarded(buckets_gossip_t *g, const char *method, const char *text)
+{
+    cJSON *params = cJSON_Parse(text);
+    if (!params) {
+        return;
+    }
+
+    gossip_events_t events = { .count = 0 };
+    pthread_mutex_lock(&g->lock);
+    if (strcmp(method, "gossip.ping") == 0) {
+        merge_message(g, params, &events);
+    } else if (strcmp(method, "gossip.pingReq") == 0) {
+        merge_message(g, params, &events);
+        queue_relay_locked(g, params);
+    } else if (strcmp(method, "gossip.indirectAck") == 0) {
+        ack_probe_locked(g, params);
+    } else if (strcmp(method, "gossip.publish") == 0) {
+        cJSON *generation = cJSON_GetObjectItem(params, "g");
+        cJSON *bucket = cJSON_GetObjectItem(params, "b");
+        cJSON *object = cJSON_GetObjectItem(params, "o");
+        if (cJSON_IsNumber(generation)) {
+            publish_topology_locked(g, (i64)generation->valuedouble);
+        }
+        if (cJSON_IsString(bucket) && cJSON_IsString(object)) {
+            publish_invalidation_locked(g, bucket->valuestring, object->valuestring);
+        }
+    }
+    shared_publish_locked(g);
+    pthread_mutex_unlock(&g->lock);
+
+    fire_events(g, &events);
+    cJSON_Delete(params);
+}
+
+/* ===================================================================
+ * Probing
+ * ===================================================================*/
+
+/**
+ * Ping one endpoint and merge its ack
+ */
+static bool send_ping(buckets_gossip_t *g, const char *endpoint)
+{
+    pthread_mutex_lock(&g->lock);
+    cJSON *params = build_message(g);
+    pthread_mutex_unlock(&g->lock);
+
+    buckets_rpc_response_t *response = NULL;
+    int ret = buckets_rpc_call(g->rpc, endpoint, "gossip.ping", params,
+                               &response, g->config.probe_timeout_ms);
+    cJSON_Delete(params);
+
+    bool ok = ret == BUCKETS_OK && response && response->error_code == 0 && response->result;
+    if (ok) {
+        gossip_events_t events = { .count = 0 };
+        pthread_mutex_lock(&g->lock);
+        merge_message(g, response->result, &events);
+        pthread_mutex_unlock(&g->lock);
+        fire_events(g, &events);
+    }
+    if (response) {
+        buckets_rpc_response_free(response);
+    }
+    return ok;
+}
+
+/**
+ * Choose the member to probe
+ *
+ * An alive member whose phi already exceeds the threshold goes first;
+ * otherwise round-robin over a list reshuffled each pass, so every member
+ * is probed within one pass and the time to first probe is bounded.
+ */
+static bool pick_target(buckets_gossip_t *g, char *node_id, char *endpoint)
+{
+    if (g->member_count == 0) {
+        return false;
+    }
+
+    u64 now = now_ms();
+    gossip_member_t *best = NULL;
+    double best_phi = g->config.phi_threshold;
+    for (int i = 0; i < g->member_count; i++) {
+        gossip_member_t *m = &g->members[i];
+        if (m->state != BUCKETS_MEMBER_ALIVE) {
+            continue;
+        }
+        double phi = buckets_phi_value(&m->phi, now);
+        if (phi >= best_phi) {
+            best = m;
+            best_phi = phi;
+        }
+    }
+    if (best) {
+        g->stats.phi_probes++;
+    }
+
+    for (int n = 0; !best && n < g->member_count; n++) {
+        if (g->probe_pos >= g->member_count) {
+            g->probe_pos = 0;
+            for (int i = g->member_count - 1; i > 0; i--) {
+                int j = (int)(next_random(g) % (u64)(i + 1));
+                gossip_member_t tmp = g->members[i];
+                g->members[i] = g->members[j];
+                g->members[j] = tmp;
+            }
+        }
+        gossip_member_t *m = &g->members[g->probe_pos++];
+        if (m->state != BUCKETS_MEMBER_DEAD) {
+            best = m;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+
+    memcpy(node_id, best->node_id, 64);
+    memcpy(endpoint, best->endpoint, 256);
+    return true;
+}
+
+/**
+ * Ask up to indirect_probes other alive members to ping the target
+ *
+ * @return true if one of them reached it before the period ended
+ */
+static bool probe_indirect(buckets_gossip_t *g, const char *node_id,
+                           const char *endpoint, u64 period_end)
+{
+    int k = g->config.indirect_probes;
+    const char **helpers = buckets_calloc(k > 0 ? k : 1, sizeof(char*));
+    buckets_rpc_response_t **responses = buckets_calloc(k > 0 ? k : 1,
+                                                        sizeof(buckets_rpc_response_t*));
+    if (!helpers || !responses) {
+        buckets_free(helpers);
+        buckets_free(responses);
+        return false;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    int *candidates = buckets_calloc(g->member_count > 0 ? g->member_count : 1, sizeof(int));
+    if (!candidates) {
+        pthread_mutex_unlock(&g->lock);
+        buckets_free(helpers);
+        buckets_free(responses);
+        return false;
+    }
+    g->probe_seq++;
+    g->probe_acked = false;
+    u64 seq = g->probe_seq;
+
+    int ncand = 0;
+    for (int i = 0; i < g->member_count; i++) {
+        if (g->members[i].state == BUCKETS_MEMBER_ALIVE &&
+            strcmp(g->members[i].node_id, node_id) != 0) {
+            candidates[ncand++] = i;
+        }
+    }
+    int count = 0;
+    for (; count < k && count < ncand; count++) {
+        int j = count + (int)(next_random(g) % (u64)(ncand - count));
+        int tmp = candidates[count];
+        candidates[count] = candidates[j];
+        candidates[j] = tmp;
+        helpers[count] = buckets_strdup(g->members[candidates[count]].endpoint);
+    }
+
+    cJSON *params = build_message(g);
+    cJSON_AddStringToObject(params, "target", endpoint);
+    cJSON_AddStringToObject(params, "target_id", node_id);
+    cJSON_AddNumberToObject(params, "seq", (double)seq);
+    g->stats.indirect_probes += count;
+    buckets_free(candidates);
+    pthread_mutex_unlock(&g->lock);
+
+    /* Helpers answer at once and report back with gossip.indirectAck */
+    int accepted = 0;
+    if (count > 0) {
+        buckets_rpc_fanout(g->rpc, helpers, count, "gossip.pingReq", params, responses, g->config.probe_timeout_ms);
+    }
+    cJSON_Delete(params);
+
+    gossip_events_t events = { .count = 0 };
+    pthread_mutex_lock(&g->lock);
+    for (int i = 0; i < count; i++) {
+        if (responses[i] && responses[i]->result) {
+            merge_message(g, responses[i]->result, &events);
+            cJSON *ok = cJSON_GetObjectItem(responses[i]->result, "accepted");
+            if (cJSON_IsTrue(ok)) {
+                accepted++;
+            }
+        }
+        buckets_rpc_response_free(responses[i]);
+        buckets_free((char*)helpers[i]);
+    }
+
+    if (accepted > 0) {
+        u64 deadline = period_end;
+        if (deadline < now_ms() + (u64)g->config.probe_timeout_ms) {
+            deadline = now_ms() + (u64)g->config.probe_timeout_ms;
+        }
+        struct timespec ts = deadline_ts(deadline);
+        while (!g->probe_acked) {
+            if (pthread_cond_timedwait(&g->ack_cond, &g->lock, &ts) != 0) {
+                break;
+            }
+        }
+    }
+    bool acked = g->probe_acked;
+    if (acked) {
+        g->stats.indirect_acks++;
+    }
+    pthread_mutex_unlock(&g->lock);
+    fire_events(g, &events);
+
+    buckets_free(helpers);
+    buckets_free(responses);
+    return acked;
+}
+
+static void probe_member(buckets_gossip_t *g, const char *node_id,
+                         const char *endpoint, u64 period_end)
+{
+    bool direct = send_ping(g, endpoint);
+    bool reached = direct || probe_indirect(g, node_id, endpoint, period_end);
+
+    gossip_events_t events = { .count = 0 };
+    pthread_mutex_lock(&g->lock);
+    g->stats.probes++;
+    if (!direct) {
+        g->stats.probe_failures++;
+    }
+    gossip_member_t *m = find_member(g, node_id);
+    if (m && reached) {
+        buckets_phi_heartbeat(&m->phi, now_ms());
+    } else if (m && m->state == BUCKETS_MEMBER_ALIVE) {
+        set_state(g, m, BUCKETS_MEMBER_SUSPECT, m->incarnation, &events);
+        g->stats.suspicions++;
+        buckets_warn("Gossip: suspecting %s (%s)", m->node_id, m->endpoint);
+    }
+    pthread_mutex_unlock(&g->lock);
+    fire_events(g, &events);
+}
+
+/**
+ * Declare dead the suspects that did not refute in time
+ *
+ * The timeout is suspicion_mult * log10(N) periods, halved when our own
+ * phi for the member also exceeds the threshold.
+ */
+static void expire_suspects(buckets_gossip_t *g)
+{
+    gossip_events_t events = { .count = 0 };
+    u64 now = now_ms();
+
+    pthread_mutex_lock(&g->lock);
+    double timeout = g->config.suspicion_mult * cluster_scale(g) * g->config.period_ms;
+    for (int i = 0; i < g->member_count; i++) {
+        gossip_member_t *m = &g->members[i];
+        if (m->state != BUCKETS_MEMBER_SUSPECT) {
+            continue;
+        }
+        double limit = timeout;
+        if (buckets_phi_value(&m->phi, now) >= g->config.phi_threshold) {
+            limit /= 2.0;
+        }
+        if ((double)(now - m->state_since_ms) >= limit) {
+            set_state(g, m, BUCKETS_MEMBER_DEAD, m->incarnation, &events);
+            g->stats.deaths++;
+            buckets_warn("Gossip: %s (%s) is dead", m->node_id, m->endpoint);
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    fire_events(g, &events);
+}
+
+void buckets_gossip_tick(buckets_gossip_t *g)
+{
+    if (!g || g->follower) {
+        return;
+    }
+    u64 period_end = now_ms() + (u64)g->config.period_ms;
+
+    char node_id[64];
+    char endpoint[256];
+    pthread_mutex_lock(&g->lock);
+    bool picked = pick_target(g, node_id, endpoint);
+    i64 generation = g->topology_pending;
+    g->topology_pending = 0;
+    pthread_mutex_unlock(&g->lock);
+
+    if (generation > 0 && g->callbacks.topology_generation) {
+        g->callbacks.topology_generation(generation, g->callbacks.user_data);
+    }
+
+    if (picked) {
+        probe_member(g, node_id, endpoint, period_end);
+    }
+    expire_suspects(g);
+
+    pthread_mutex_lock(&g->lock);
+    shared_publish_locked(g);
+    pthread_mutex_unlock(&g->lock);
+}
+
+/* ===================================================================
+ * Threads
+ * ===================================================================*/
+
+static void* relay_thread(void *arg)
+{
+    buckets_gossip_t *g = arg;
+
+    pthread_mutex_lock(&g->lock);
+    while (g->running) {
+        if (g->relay_count == 0) {
+            pthread_cond_wait(&g->relay_cond, &g->lock);
+            continue;
+        }
+        relay_job_t job = g->relay[g->relay_head];
+        g->relay_head = (g->relay_head + 1) % GOSSIP_RELAY_QUEUE;
+        g->relay_count--;
+        pthread_mutex_unlock(&g->lock);
+
+        if (send_ping(g, job.target)) {
+            cJSON *params = cJSON_CreateObject();
+            cJSON_AddNumberToObject(params, "seq", (double)job.seq);
+            cJSON_AddStringToObject(params, "target", job.target_id);
+            buckets_rpc_response_t *response = NULL;
+            buckets_rpc_call(g->rpc, job.requester, "gossip.indirectAck", params,
+                             &response, g->config.probe_timeout_ms);
+            if (response) {
+                buckets_rpc_response_free(response);
+            }
+            cJSON_Delete(params);
+        }
+
+        pthread_mutex_lock(&g->lock);
+    }
+    pthread_mutex_unlock(&g->lock);
+    return NULL;
+}
+
+static void* gossip_thread(void *arg)
+{
+    buckets_gossip_t *g = arg;
+
+    pthread_mutex_lock(&g->lock);
+    while (g->running) {
+        u64 start = now_ms();
+        pthread_mutex_unlock(&g->lock);
+
+        buckets_gossip_tick(g);
+
+        pthread_mutex_lock(&g->lock);
+        struct timespec ts = deadline_ts(start + (u64)g->config.period_ms);
+        while (g->running && pthread_cond_timedwait(&g->stop_cond, &g->lock, &ts) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return NULL;
+}
+
+static void* inbox_thread(void *arg)
+{
+    buckets_gossip_t *g = arg;
+    buckets_gossip_shared_t *s = g->shared;
+    gossip_inbox_slot_t *slot = buckets_malloc(sizeof(gossip_inbox_slot_t));
+    if (!slot) {
+        return NULL;
+    }
+
+    shared_lock(s);
+    while (s->agent_running) {
+        if (s->inbox_count == 0) {
+            struct timespec ts = deadline_ts(now_ms() + GOSSIP_INBOX_WAIT_MS);
+            if (pthread_cond_timedwait(&s->inbox_cond, &s->lock, &ts) == EOWNERDEAD) {
+                shared_recover(s);
+            }
+            continue;
+        }
+        *slot = s->inbox[s->inbox_head];
+        s->inbox_head = (s->inbox_head + 1) % GOSSIP_INBOX_SLOTS;
+        s->inbox_count--;
+        pthread_mutex_unlock(&s->lock);
+
+        absorb_forwarded(g, slot->method, slot->params);
+
+        shared_lock(s);
+    }
+    pthread_mutex_unlock(&s->lock);
+    buckets_free(slot);
+    return NULL;
+}
+
+/* ===================================================================
+ * Public API
+ * ===================================================================*/
+
+void buckets_gossip_config_default(buckets_gossip_config_t *config)
+{
+    if (!config) {
+        return;
+    }
+    config->period_ms = env_int("BUCKETS_GOSSIP_PERIOD_MS", 1000);
+    config->probe_timeout_ms = env_int("BUCKETS_GOSSIP_PROBE_TIMEOUT_MS", 300);
+    config->indirect_probes = env_int("BUCKETS_GOSSIP_INDIRECT", 3);
+    config->phi_threshold = env_int("BUCKETS_GOSSIP_PHI", 8);
+    config->suspicion_mult = 4;
+    config->retransmit_mult = 3;
+    config->max_piggyback = 8;
+}
+
+buckets_gossip_t* buckets_gossip_create(buckets_rpc_context_t *ctx,
+                                        const char *node_id,
+                                        const char *endpoint,
+                                        const buckets_gossip_config_t *config)
+{
+    if (!ctx || !node_id || !endpoint) {
+        return NULL;
+    }
+
+    buckets_gossip_t *g = buckets_calloc(1, sizeof(buckets_gossip_t));
+    if (!g) {
+        return NULL;
+    }
+    g->rpc = ctx;
+    if (config) {
+        g->config = *config;
+    } else {
+        buckets_gossip_config_default(&g->config);
+    }
+    if (g->config.max_piggyback > GOSSIP_MAX_EVENTS - 2) {
+        g->config.max_piggyback = GOSSIP_MAX_EVENTS - 2;
+    }
+    snprintf(g->node_id, sizeof(g->node_id), "%s", node_id);
+    snprintf(g->endpoint, sizeof(g->endpoint), "%s", endpoint);
+
+    /* Wall-clock start time, so a restarted node outranks its old self */
+    g->incarnation = (u64)time(NULL);
+    g->rng = hash_str(node_id) ^ now_ms() ^ 0x9E3779B97F4A7C15ULL;
+    if (g->rng == 0) {
+        g->rng = 1;
+    }
+
+    pthread_mutex_init(&g->lock, NULL);
+    cond_init_monotonic(&g->ack_cond);
+    cond_init_monotonic(&g->stop_cond);
+    pthread_cond_init(&g->relay_cond, NULL);
+
+    if (buckets_rpc_register_handler(ctx, "gossip.ping", handle_ping, g) != BUCKETS_OK ||
+        buckets_rpc_register_handler(ctx, "gossip.pingReq", handle_ping_req, g) != BUCKETS_OK ||
+        buckets_rpc_register_handler(ctx, "gossip.indirectAck", handle_indirect_ack, g) != BUCKETS_OK) {
+        buckets_error("Gossip: failed to register RPC methods");
+        buckets_gossip_free(g);
+        return NULL;
+    }
+
+    /* Announce ourselves on the first messages */
+    queue_member(g, BUCKETS_MEMBER_ALIVE, g->node_id, g->endpoint, g->incarnation);
+    return g;
+}
+
+buckets_gossip_shared_t* buckets_gossip_shared_create(void)
+{
+    buckets_gossip_shared_t *s = mmap(NULL, sizeof(buckets_gossip_shared_t),
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (s == MAP_FAILED) {
+        buckets_error("Gossip: failed to map shared membership: %s", strerror(errno));
+        return NULL;
+    }
+
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&s->lock, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->inbox_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+    return s;
+}
+
+void buckets_gossip_shared_destroy(buckets_gossip_shared_t *s)
+{
+    if (!s) {
+        return;
+    }
+    munmap(s, sizeof(buckets_gossip_shared_t));
+}
+
+void buckets_gossip_share(buckets_gossip_t *g, buckets_gossip_shared_t *s, bool agent)
+{
+    if (!g || !s) {
+        return;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    g->shared = s;
+    g->follower = !agent;
+    if (agent) {
+        /* A restarted agent must outrank the incarnation its predecessor
+         * announced, even within the same second */
+        shared_lock(s);
+        u64 previous = s->incarnation;
+        pthread_mutex_unlock(&s->lock);
+        if (previous >= g->incarnation) {
+            g->incarnation = previous + 1;
+            queue_member(g, BUCKETS_MEMBER_ALIVE, g->node_id, g->endpoint, g->incarnation);
+        }
+        shared_publish_locked(g);
+    }
+    pthread_mutex_unlock(&g->lock);
+}
+
+int buckets_gossip_add_member(buckets_gossip_t *g, const char *node_id, const char *endpoint)
+{
+    if (!g || !node_id || !endpoint) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    if (strcmp(node_id, g->node_id) == 0) {
+        return BUCKETS_OK;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    int ret = BUCKETS_OK;
+    if (!find_member(g, node_id) && !add_member_locked(g, node_id, endpoint, 0)) {
+        ret = BUCKETS_ERR_NOMEM;
+    }
+    pthread_mutex_unlock(&g->lock);
+    return ret;
+}
+
+void buckets_gossip_set_callbacks(buckets_gossip_t *g, const buckets_gossip_callbacks_t *callbacks)
+{
+    if (!g) {
+        return;
+    }
+    pthread_mutex_lock(&g->lock);
+    if (callbacks) {
+        g->callbacks = *callbacks;
+    } else {
+        memset(&g->callbacks, 0, sizeof(g->callbacks));
+    }
+    pthread_mutex_unlock(&g->lock);
+}
+
+int buckets_gossip_start(buckets_gossip_t *g)
+{
+    if (!g) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    if (g->running) {
+        pthread_mutex_unlock(&g->lock);
+        return BUCKETS_OK;
+    }
+    g->running = true;
+    pthread_mutex_unlock(&g->lock);
+
+    if (g->follower) {
+        buckets_info("Gossip following the node's agent");
+        return BUCKETS_OK;
+    }
+
+    if (buckets_account_thread_create(&g->thread, gossip_thread, g) != 0) {
+        g->running = false;
+        return BUCKETS_ERR_IO;
+    }
+    for (int i = 0; i < GOSSIP_RELAY_THREADS; i++) {
+        if (buckets_account_thread_create(&g->relay_threads[i], relay_thread, g) != 0) {
+            buckets_gossip_stop(g);
+            return BUCKETS_ERR_IO;
+        }
+    }
+    if (g->shared) {
+        shared_lock(g->shared);
+        g->shared->agent_running = true;
+        pthread_mutex_unlock(&g->shared->lock);
+        if (buckets_account_thread_create(&g->inbox_thread, inbox_thread, g) != 0) {
+            buckets_gossip_stop(g);
+            return BUCKETS_ERR_IO;
+        }
+    }
+
+    buckets_info("Gossip started: %d members, period %dms, %d indirect probes",
+                 g->member_count, g->config.period_ms, g->config.indirect_probes);
+    return BUCKETS_OK;
+}
+
+void buckets_gossip_stop(buckets_gossip_t *g)
+{
+    if (!g) {
+        return;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    if (!g->running) {
+        pthread_mutex_unlock(&g->lock);
+        return;
+    }
+    g->running = false;
+    pthread_cond_broadcast(&g->stop_cond);
+    pthread_cond_broadcast(&g->relay_cond);
+    pthread_cond_broadcast(&g->ack_cond);
+    pthread_mutex_unlock(&g->lock);
+
+    if (g->follower) {
+        return;
+    }
+    if (g->shared) {
+        shared_lock(g->shared);
+        g->shared->agent_running = false;
+        pthread_cond_broadcast(&g->shared->inbox_cond);
+        pthread_mutex_unlock(&g->shared->lock);
+        if (g->inbox_thread) {
+            pthread_join(g->inbox_thread, NULL);
+            g->inbox_thread = 0;
+        }
+    }
+
+    pthread_join(g->thread, NULL);
+    for (int i = 0; i < GOSSIP_RELAY_THREADS; i++) {
+        if (g->relay_threads[i]) {
+            pthread_join(g->relay_threads[i], NULL);
+            g->relay_threads[i] = 0;
+        }
+    }
+    buckets_info("Gossip stopped");
+}
+
+void buckets_gossip_publish_topology(buckets_gossip_t *g, i64 generation)
+{
+    if (!g) {
+        return;
+    }
+    if (g->follower) {
+        cJSON *params = cJSON_CreateObject();
+        cJSON_AddNumberToObject(params, "g", (double)generation);
+        forward_to_agent(g, "gossip.publish", params);
+        cJSON_Delete(params);
+        return;
+    }
+    pthread_mutex_lock(&g->lock);
+    publish_topology_locked(g, generation);
+    pthread_mutex_unlock(&g->lock);
+}
+
+void buckets_gossip_publish_invalidation(buckets_gossip_t *g, const char *bucket,
+                                         const char *object)
+{
+    if (!g || !bucket || !object) {
+        return;
+    }
+    if (g->follower) {
+        cJSON *params = cJSON_CreateObject();
+        cJSON_AddStringToObject(params, "b", bucket);
+        cJSON_AddStringToObject(params, "o", object);
+        forward_to_agent(g, "gossip.publish", params);
+        cJSON_Delete(params);
+        return;
+    }
+    pthread_mutex_lock(&g->lock);
+    publish_invalidation_locked(g, bucket, object);
+    pthread_mutex_unlock(&g->lock);
+}
+
+bool buckets_gossip_endpoint_dead(buckets_gossip_t *g, const char *endpoint)
+{
+    if (!g || !endpoint) {
+        return false;
+    }
+    bool dead = false;
+    if (g->follower) {
+        buckets_gossip_shared_t *s = g->shared;
+        shared_lock(s);
+        for (u32 i = 0; i < s->member_count; i++) {
+            if (strcmp(s->members[i].endpoint, endpoint) == 0) {
+                dead = s->members[i].state == BUCKETS_MEMBER_DEAD;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+        return dead;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    for (int i = 0; i < g->member_count; i++) {
+        if (strcmp(g->members[i].endpoint, endpoint) == 0) {
+            dead = g->members[i].state == BUCKETS_MEMBER_DEAD;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g->lock);
+    return dead;
+}
+
+int buckets_gossip_get_members(buckets_gossip_t *g, buckets_gossip_member_t **members, int *count)
+{
+    if (!g || !members || !count) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    if (g->follower) {
+        /* The agent's view; phi lives with its detectors */
+        buckets_gossip_shared_t *s = g->shared;
+        shared_lock(s);
+        int n = (int)s->member_count;
+        buckets_gossip_member_t *out = buckets_calloc(n > 0 ? n : 1, sizeof(buckets_gossip_member_t));
+        if (!out) {
+            pthread_mutex_unlock(&s->lock);
+            return BUCKETS_ERR_NOMEM;
+        }
+        for (int i = 0; i < n; i++) {
+            memcpy(out[i].node_id, s->members[i].node_id, sizeof(out[i].node_id));
+            memcpy(out[i].endpoint, s->members[i].endpoint, sizeof(out[i].endpoint));
+            out[i].state = (buckets_member_state_t)s->members[i].state;
+            out[i].incarnation = s->members[i].incarnation;
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        *members = out;
+        *count = n;
+        return BUCKETS_OK;
+    }
+
+    pthread_mutex_lock(&g->lock);
+    int n = g->member_count;
+    buckets_gossip_member_t *out = buckets_calloc(n > 0 ? n : 1, sizeof(buckets_gossip_member_t));
+    if (!out) {
+        pthread_mutex_unlock(&g->lock);
+        return BUCKETS_ERR_NOMEM;
+    }
+    u64 now = now_ms();
+    for (int i = 0; i < n; i++) {
+        gossip_member_t *m = &g->members[i];
+        memcpy(out[i].node_id, m->node_id, sizeof(out[i].node_id));
+        memcpy(out[i].endpoint, m->endpoint, sizeof(out[i].endpoint));
+        out[i].state = m->state;
+        out[i].incarnation = m->incarnation;
+        out[i].phi = buckets_phi_value(&m->phi, now);
+    }
+    pthread_mutex_unlock(&g->lock);
+
+    *members = out;
+    *count = n;
+    return BUCKETS_OK;
+}
+
+void buckets_gossip_get_stats(buckets_gossip_t *g, buckets_gossip_stats_t *stats)
+{
+    if (!g || !stats) {
+        return;
+    }
+    pthread_mutex_lock(&g->lock);
+    *stats = g->stats;
+    pthread_mutex_unlock(&g->lock);
+}
+
+void buckets_gossip_free(buckets_gossip_t *g)
+{
+    if (!g) {
+        return;
+    }
+
+    buckets_gossip_stop(g);
+    buckets_rpc_unregister_handler(g->rpc, "gossip.ping");
+    buckets_rpc_unregister_handler(g->rpc, "gossip.pingReq");
+    buckets_rpc_unregister_handler(g->rpc, "gossip.indirectAck");
+
+    while (g->updates) {
+        gossip_update_t *next = g->updates->next;
+        update_free(g->updates);
+        g->updates = next;
+    }
+    buckets_free(g->members);
+
+    pthread_cond_destroy(&g->relay_cond);
+    pthread_cond_destroy(&g->stop_cond);
+    pthread_cond_destroy(&g->ack_cond);
+    pthread_mutex_destroy(&g->lock);
+    buckets_free(g);
+}
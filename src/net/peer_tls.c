@@ -0,0 +1,476 @@
+/**
+ * Peer Transport Security
+ *
+ * Mutually authenticated TLS for node-to-node connections (binary chunk
+ * transport, batch transport and RPC). Connections are already long-lived
+ * and reused through the transport caches, so the handshake cost is paid
+ * once per connection and mostly avoided on reconnect by resuming the
+ * last session for the peer.
+ *
+ * Sessions use TLS 1.2 with AES-GCM only: OpenSSL hands both directions of
+ * such sessions to the kernel (kTLS), after which the socket carries
+ * plaintext for us and send/writev need no userspace crypto or copies.
+ * When the kernel can't take a direction, OpenSSL encrypts it with its
+ * AES-NI/PCLMUL code paths instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+
+/* Descriptors above this are refused rather than tracked */
+#define PEER_TLS_MAX_FDS 65536
+
+/* Cached client sessions (one per peer endpoint) */
+#define PEER_TLS_SESSION_SLOTS 64
+
+#define PEER_TLS_CIPHERS "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:" \
+                         "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384"
+
+/**
+ * TLS state of one peer socket
+ */
+typedef struct {
+    SSL *ssl;
+    bool ktls_tx;                /* Kernel encrypts: send() takes plaintext */
+    bool ktls_rx;                /* Kernel decrypts: recv() returns plaintext */
+} peer_conn_t;
+
+typedef struct {
+    char key[280];               /* host:port */
+    SSL_SESSION *session;
+    time_t last_used;
+} peer_session_slot_t;
+
+static struct {
+    bool enabled;
+    SSL_CTX *ctx;
+    char cert_file[512];
+    char key_file[512];
+    char ca_file[512];
+
+    /* Indexed by fd; each socket has a single owner at a time (the
+     * transport caches hand them out exclusively) */
+    peer_conn_t *conns[PEER_TLS_MAX_FDS];
+
+    peer_session_slot_t sessions[PEER_TLS_SESSION_SLOTS];
+    pthread_mutex_t session_lock;
+
+    buckets_peer_tls_stats_t stats;
+    bool warned_userspace;
+} g_peer_tls = {
+    .session_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* ===================================================================
+ * Configuration
+ * ===================================================================*/
+
+static bool peer_tls_ktls_allowed(void)
+{
+    const char *env = getenv("BUCKETS_KTLS");
+    return !(env && (strcmp(env, "off") == 0 || strcmp(env, "0") == 0));
+}
+
+int buckets_peer_tls_init(const char *cert_file, const char *key_file,
+                          const char *ca_file)
+{
+    buckets_peer_tls_cleanup();
+
+    if (!cert_file || !key_file || !ca_file) {
+        return BUCKETS_OK;
+    }
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    if (!ctx) {
+        buckets_error("Failed to create peer TLS context");
+        return BUCKETS_ERR_IO;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    if (SSL_CTX_set_cipher_list(ctx, PEER_TLS_CIPHERS) != 1) {
+        buckets_error("No AES-GCM cipher suites available for peer TLS");
+        SSL_CTX_free(ctx);
+        return BUCKETS_ERR_IO;
+    }
+#ifdef SSL_OP_ENABLE_KTLS
+    if (peer_tls_ktls_allowed()) {
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT |
+                                        SSL_SESS_CACHE_NO_INTERNAL_STORE);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert_file) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, key_file, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        buckets_error("Failed to load peer TLS certificate %s / key %s",
+                      cert_file, key_file);
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(ctx);
+        return BUCKETS_ERR_IO;
+    }
+    if (SSL_CTX_load_verify_locations(ctx, ca_file, NULL) != 1) {
+        buckets_error("Failed to load peer TLS CA: %s", ca_file);
+        SSL_CTX_free(ctx);
+        return BUCKETS_ERR_IO;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+
+    /* OpenSSL's socket BIO writes without MSG_NOSIGNAL: a peer that goes
+     * away mid-record must surface as EPIPE, not kill the node */
+    signal(SIGPIPE, SIG_IGN);
+
+    g_peer_tls.ctx = ctx;
+    snprintf(g_peer_tls.cert_file, sizeof(g_peer_tls.cert_file), "%s", cert_file);
+    snprintf(g_peer_tls.key_file, sizeof(g_peer_tls.key_file), "%s", key_file);
+    snprintf(g_peer_tls.ca_file, sizeof(g_peer_tls.ca_file), "%s", ca_file);
+    g_peer_tls.enabled = true;
+
+    buckets_info("Peer TLS enabled (cert %s, CA %s, kTLS %s)",
+                 cert_file, ca_file, peer_tls_ktls_allowed() ? "allowed" : "off");
+    return BUCKETS_OK;
+}
+
+int buckets_peer_tls_init_from_env(void)
+{
+    const char *cert = getenv("BUCKETS_PEER_TLS_CERT");
+    const char *key = getenv("BUCKETS_PEER_TLS_KEY");
+    const char *ca = getenv("BUCKETS_PEER_TLS_CA");
+
+    if (!cert && !key && !ca) {
+        return BUCKETS_OK;
+    }
+    if (!cert || !key || !ca) {
+        buckets_error("Peer TLS needs BUCKETS_PEER_TLS_CERT, BUCKETS_PEER_TLS_KEY "
+                      "and BUCKETS_PEER_TLS_CA");
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    return buckets_peer_tls_init(cert, key, ca);
+}
+
+void buckets_peer_tls_cleanup(void)
+{
+    if (!g_peer_tls.ctx) {
+        return;
+    }
+
+    for (int fd = 0; fd < PEER_TLS_MAX_FDS; fd++) {
+        if (g_peer_tls.conns[fd]) {
+            buckets_peer_tls_close(fd);
+        }
+    }
+
+    pthread_mutex_lock(&g_peer_tls.session_lock);
+    for (int i = 0; i < PEER_TLS_SESSION_SLOTS; i++) {
+        if (g_peer_tls.sessions[i].session) {
+            SSL_SESSION_free(g_peer_tls.sessions[i].session);
+        }
+        memset(&g_peer_tls.sessions[i], 0, sizeof(g_peer_tls.sessions[i]));
+    }
+    pthread_mutex_unlock(&g_peer_tls.session_lock);
+
+    SSL_CTX_free(g_peer_tls.ctx);
+    g_peer_tls.ctx = NULL;
+    g_peer_tls.enabled = false;
+    memset(&g_peer_tls.stats, 0, sizeof(g_peer_tls.stats));
+    g_peer_tls.warned_userspace = false;
+}
+
+bool buckets_peer_tls_enabled(void)
+{
+    return g_peer_tls.enabled;
+}
+
+const char* buckets_peer_tls_ca_file(void)
+{
+    return g_peer_tls.enabled ? g_peer_tls.ca_file : NULL;
+}
+
+int buckets_peer_tls_enable_server(struct uv_http_server *server)
+{
+    if (!g_peer_tls.enabled) {
+        return BUCKETS_OK;
+    }
+    int ret = uv_http_server_enable_tls(server, g_peer_tls.cert_file, g_peer_tls.key_file);
+    if (ret != BUCKETS_OK) {
+        return ret;
+    }
+    return uv_http_server_require_peer_certs(server, g_peer_tls.ca_file);
+}
+
+/* ===================================================================
+ * Session Cache
+ * ===================================================================*/
+
+static SSL_SESSION* session_lookup(const char *key)
+{
+    SSL_SESSION *session = NULL;
+
+    pthread_mutex_lock(&g_peer_tls.session_lock);
+    for (int i = 0; i < PEER_TLS_SESSION_SLOTS; i++) {
+        peer_session_slot_t *slot = &g_peer_tls.sessions[i];
+        if (slot->session && strcmp(slot->key, key) == 0) {
+            if (SSL_SESSION_is_resumable(slot->session)) {
+                SSL_SESSION_up_ref(slot->session);
+                session = slot->session;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_peer_tls.session_lock);
+
+    return session;
+}
+
+static void session_store(const char *key, SSL_SESSION *session)
+{
+    time_t now = time(NULL);
+    int victim = 0;
+
+    pthread_mutex_lock(&g_peer_tls.session_lock);
+    for (int i = 0; i < PEER_TLS_SESSION_SLOTS; i++) {
+        peer_session_slot_t *slot = &g_peer_tls.sessions[i];
+        if (!slot->session || strcmp(slot->key, key) == 0) {
+            victim = i;
+            break;
+        }
+        if (slot->last_used < g_peer_tls.sessions[victim].last_used) {
+            victim = i;
+        }
+    }
+
+    peer_session_slot_t *slot = &g_peer_tls.sessions[victim];
+    if (slot->session) {
+        SSL_SESSION_free(slot->session);
+    }
+    snprintf(slot->key, sizeof(slot->key), "%s", key);
+    slot->session = session;
+    slot->last_used = now;
+    pthread_mutex_unlock(&g_peer_tls.session_lock);
+}
+
+/* ===================================================================
+ * Connections
+ * ===================================================================*/
+
+static inline peer_conn_t* peer_conn(int fd)
+{
+    if (fd < 0 || fd >= PEER_TLS_MAX_FDS) {
+        return NULL;
+    }
+    return __atomic_load_n(&g_peer_tls.conns[fd], __ATOMIC_ACQUIRE);
+}
+
+int buckets_peer_tls_connect(int fd, const char *host, int port)
+{
+    if (!g_peer_tls.enabled) {
+        return BUCKETS_OK;
+    }
+    if (fd < 0 || fd >= PEER_TLS_MAX_FDS || !host) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    SSL *ssl = SSL_new(g_peer_tls.ctx);
+    if (!ssl || SSL_set_fd(ssl, fd) != 1) {
+        SSL_free(ssl);
+        return BUCKETS_ERR_NOMEM;
+    }
+
+    /* SNI only carries names, not addresses */
+    unsigned char addr[16];
+    if (inet_pton(AF_INET, host, addr) != 1 && inet_pton(AF_INET6, host, addr) != 1) {
+        SSL_set_tlsext_host_name(ssl, host);
+    }
+
+    char key[280];
+    snprintf(key, sizeof(key), "%s:%d", host, port);
+    SSL_SESSION *cached = session_lookup(key);
+    if (cached) {
+        SSL_set_session(ssl, cached);
+        SSL_SESSION_free(cached);
+    }
+
+    errno = 0;
+    int ret = SSL_connect(ssl);
+    if (ret != 1) {
+        char reason[256];
+        if (ERR_peek_last_error()) {
+            ERR_error_string_n(ERR_peek_last_error(), reason, sizeof(reason));
+        } else {
+            snprintf(reason, sizeof(reason), "%s",
+                     errno ? strerror(errno) : "connection closed");
+        }
+        buckets_error("[PEER_TLS] Handshake with %s failed: %s (verify: %s)", key, reason,
+                      X509_verify_cert_error_string(SSL_get_verify_result(ssl)));
+        ERR_clear_error();
+        SSL_free(ssl);
+        __atomic_fetch_add(&g_peer_tls.stats.failures, 1, __ATOMIC_RELAXED);
+        return BUCKETS_ERR_IO;
+    }
+
+    peer_conn_t *conn = buckets_calloc(1, sizeof(peer_conn_t));
+    conn->ssl = ssl;
+#ifdef SSL_OP_ENABLE_KTLS
+    conn->ktls_tx = BIO_get_ktls_send(SSL_get_wbio(ssl)) > 0;
+    conn->ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(ssl)) > 0;
+#endif
+
+    bool resumed = SSL_session_reused(ssl);
+    if (!resumed) {
+        SSL_SESSION *session = SSL_get1_session(ssl);
+        if (session) {
+            session_store(key, session);
+        }
+    }
+
+    __atomic_fetch_add(&g_peer_tls.stats.handshakes, 1, __ATOMIC_RELAXED);
+    if (resumed) {
+        __atomic_fetch_add(&g_peer_tls.stats.resumed, 1, __ATOMIC_RELAXED);
+    }
+    if (conn->ktls_tx && conn->ktls_rx) {
+        __atomic_fetch_add(&g_peer_tls.stats.ktls, 1, __ATOMIC_RELAXED);
+    } else if (!__atomic_exchange_n(&g_peer_tls.warned_userspace, true, __ATOMIC_RELAXED)) {
+        buckets_warn("[PEER_TLS] Kernel TLS unavailable (tx=%d rx=%d); "
+                     "encrypting peer traffic in userspace",
+                     conn->ktls_tx, conn->ktls_rx);
+    }
+
+    buckets_debug("[PEER_TLS] Connected to %s (%s, %s, kTLS tx=%d rx=%d)", key,
+                  SSL_get_cipher_name(ssl), resumed ? "resumed" : "full",
+                  conn->ktls_tx, conn->ktls_rx);
+
+    __atomic_store_n(&g_peer_tls.conns[fd], conn, __ATOMIC_RELEASE);
+    return BUCKETS_OK;
+}
+
+void buckets_peer_tls_close(int fd)
+{
+    peer_conn_t *conn = peer_conn(fd);
+    if (!conn) {
+        return;
+    }
+    __atomic_store_n(&g_peer_tls.conns[fd], NULL, __ATOMIC_RELEASE);
+
+    /* No close_notify: the peer treats EOF on an idle connection as a
+     * normal close, and a blocking write here could stall the caller */
+    SSL_set_quiet_shutdown(conn->ssl, 1);
+    SSL_shutdown(conn->ssl);
+    SSL_free(conn->ssl);
+    buckets_free(conn);
+}
+
+/* ===================================================================
+ * I/O
+ * ===================================================================*/
+
+/* Map an OpenSSL I/O failure onto errno so callers keep their
+ * send/recv error handling */
+static ssize_t peer_tls_error(SSL *ssl, int ret)
+{
+    int err = SSL_get_error(ssl, ret);
+    switch (err) {
+        case SSL_ERROR_ZERO_RETURN:
+            return 0;
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            break;
+        case SSL_ERROR_SYSCALL:
+            if (errno == 0) {
+                return 0;  /* EOF without close_notify */
+            }
+            break;
+        default:
+            errno = EIO;
+            break;
+    }
+    ERR_clear_error();
+    return -1;
+}
+
+ssize_t buckets_peer_send(int fd, const void *buf, size_t len)
+{
+    peer_conn_t *conn = peer_conn(fd);
+    if (!conn || conn->ktls_tx) {
+        return send(fd, buf, len, MSG_NOSIGNAL);
+    }
+
+    size_t written = 0;
+    errno = 0;
+    int ret = SSL_write_ex(conn->ssl, buf, len, &written);
+    if (ret != 1) {
+        return peer_tls_error(conn->ssl, ret);
+    }
+    return (ssize_t)written;
+}
+
+ssize_t buckets_peer_recv(int fd, void *buf, size_t len)
+{
+    peer_conn_t *conn = peer_conn(fd);
+    if (!conn || conn->ktls_rx) {
+        return recv(fd, buf, len, 0);
+    }
+
+    size_t got = 0;
+    errno = 0;
+    int ret = SSL_read_ex(conn->ssl, buf, len, &got);
+    if (ret != 1) {
+        return peer_tls_error(conn->ssl, ret);
+    }
+    return (ssize_t)got;
+}
+
+ssize_t buckets_peer_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    peer_conn_t *conn = peer_conn(fd);
+    if (!conn || conn->ktls_tx) {
+        return writev(fd, iov, iovcnt);
+    }
+
+    /* Userspace encryption copies anyway; one record stream per vector */
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t n = buckets_peer_send(fd, iov[i].iov_base, iov[i].iov_len);
+        if (n <= 0) {
+            return total > 0 ? total : n;
+        }
+        total += n;
+        if ((size_t)n < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+/* ===================================================================
+ * Statistics
+ * ===================================================================*/
+
+void buckets_peer_tls_get_stats(buckets_peer_tls_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    stats->handshakes = __atomic_load_n(&g_peer_tls.stats.handshakes, __ATOMIC_RELAXED);
+    stats->resumed = __atomic_load_n(&g_peer_tls.stats.resumed, __ATOMIC_RELAXED);
+    stats->ktls = __atomic_load_n(&g_peer_tls.stats.ktls, __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&g_peer_tls.stats.failures, __ATOMIC_RELAXED);
+}
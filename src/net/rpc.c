@@ -166,6 +166,31 @@ int buckets_rpc_register_handler(buckets_rpc_context_t *ctx,
     return BUCKETS_OK;
 }
 
+int buckets_rpc_unregister_handler(buckets_rpc_context_t *ctx, const char *method)
+{
+    if (!ctx || !method) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    rpc_handler_entry_t **link = &ctx->handlers;
+    while (*link && strcmp((*link)->method, method) != 0) {
+        link = &(*link)->next;
+    }
+    rpc_handler_entry_t *entry = *link;
+    if (entry) {
+        *link = entry->next;
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    if (!entry) {
+        return BUCKETS_ERR_NOT_FOUND;
+    }
+    buckets_free(entry);
+    buckets_debug("RPC: Unregistered handler for method '%s'", method);
+    return BUCKETS_OK;
+}
+
 void buckets_rpc_context_free(buckets_rpc_context_t *ctx)
 {
     if (!ctx) {
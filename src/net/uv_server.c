@@ -11,9 +11,13 @@
 #include <ctype.h>
 #include <errno.h>
 #include <sys/socket.h>
+#include <openssl/evp.h>
 
 #include "buckets.h"
 #include "buckets_net.h"
+#include "buckets_mem_budget.h"
+#include "buckets_numa.h"
+#include "buckets_io_priority.h"
 #include "uv_server_internal.h"
 #include "uv_server_metrics.h"
 
@@ -46,10 +50,20 @@ static void on_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf);
 static void on_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
 static void on_write_complete(uv_write_t *req, int status);
 static void on_handle_close(uv_handle_t *handle);
+static void conn_close_handles(uv_http_conn_t *conn);
+static void conn_destroy(uv_http_conn_t *conn);
 static void on_timeout(uv_timer_t *timer);
 static void on_shutdown_async(uv_async_t *handle);
+static void on_budget_async(uv_async_t *handle);
+static void on_resume_async(uv_async_t *handle);
+static void budget_release_hook(void *arg);
 static void* server_thread_main(void *arg);
 static int safe_uv_write(uv_http_conn_t *conn, char *write_buf, size_t write_len);
+static int conn_write(uv_http_conn_t *conn, uv_write_t *req, char *data, size_t len);
+
+/* TLS handshake helpers */
+static int tls_handshake_start(uv_http_conn_t *conn);
+static void tls_poll_close(uv_http_conn_t *conn);
 
 static void process_request(uv_http_conn_t *conn);
 static void setup_parser_callbacks(llhttp_settings_t *settings);
@@ -58,6 +72,17 @@ static void setup_parser_callbacks(llhttp_settings_t *settings);
 static uv_route_t* find_streaming_route(uv_http_conn_t *conn);
 static void build_stream_request(uv_http_conn_t *conn, uv_stream_request_t *req);
 
+/* Memory budget helpers */
+static void conn_budget_reserve(uv_http_conn_t *conn, uint64_t bytes);
+static void conn_budget_release(uv_http_conn_t *conn);
+static void conn_qos_charge(uv_http_conn_t *conn, size_t bytes, bool inbound);
+static void conn_qos_release(uv_http_conn_t *conn);
+static void conn_qos_pace(uv_http_conn_t *conn);
+static void qos_timer_close(uv_http_conn_t *conn);
+
+/* Priority lane helpers */
+static void conn_classify_lane(uv_http_conn_t *conn);
+
 /* ===================================================================
  * HTTP Status Codes
  * ===================================================================*/
@@ -91,6 +116,34 @@ static const char* http_status_string(int status) {
  * Server Creation and Lifecycle
  * ===================================================================*/
 
+/**
+ * Default priority lanes: BUCKETS_BULK_LANE_THREADS caps the pool threads
+ * bulk work may hold (0 = no lanes; default three quarters of
+ * UV_THREADPOOL_SIZE), BUCKETS_BULK_MIN_BYTES is the smallest bulk transfer.
+ */
+static void lane_config_default(int *bulk_limit, uint64_t *bulk_min_bytes)
+{
+    const char *env = getenv("UV_THREADPOOL_SIZE");
+    int pool = env ? atoi(env) : 0;
+    if (pool <= 0) {
+        pool = 4;               /* libuv's default */
+    }
+    *bulk_limit = pool - (pool / 4 > 0 ? pool / 4 : 1);
+    if (*bulk_limit < 1) {
+        *bulk_limit = 1;
+    }
+    *bulk_min_bytes = BUCKETS_DEFAULT_BULK_MIN_BYTES;
+    
+    env = getenv("BUCKETS_BULK_LANE_THREADS");
+    if (env && *env && atoi(env) >= 0) {
+        *bulk_limit = atoi(env);
+    }
+    env = getenv("BUCKETS_BULK_MIN_BYTES");
+    if (env && strtoull(env, NULL, 10) > 0) {
+        *bulk_min_bytes = strtoull(env, NULL, 10);
+    }
+}
+
 uv_http_server_t* uv_http_server_create(const char *addr, int port)
 {
     if (!addr || port <= 0 || port > 65535) {
@@ -114,7 +167,10 @@ uv_http_server_t* uv_http_server_create(const char *addr, int port)
     server->keepalive_timeout_ms = BUCKETS_DEFAULT_KEEPALIVE_TIMEOUT_MS;
     server->write_timeout_ms = BUCKETS_DEFAULT_WRITE_TIMEOUT_MS;
     
+    lane_config_default(&server->bulk_limit, &server->bulk_min_bytes);
+    
     pthread_mutex_init(&server->lock, NULL);
+    pthread_mutex_init(&server->resume_lock, NULL);
     
     buckets_info("Created UV HTTP server for %s:%d", addr, port);
     
@@ -136,6 +192,44 @@ int uv_http_server_enable_tls(uv_http_server_t *server,
     return BUCKETS_OK;
 }
 
+int uv_http_server_require_peer_certs(uv_http_server_t *server,
+                                       const char *ca_file)
+{
+    if (!server || !ca_file) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    strncpy(server->peer_ca_file, ca_file, sizeof(server->peer_ca_file) - 1);
+    
+    return BUCKETS_OK;
+}
+
+int uv_http_server_set_qos(uv_http_server_t *server, const uv_http_qos_t *qos)
+{
+    if (!server || !qos || !qos->admit || !qos->charge) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    server->qos = *qos;
+    
+    return BUCKETS_OK;
+}
+
+int uv_http_server_set_lanes(uv_http_server_t *server, int bulk_threads,
+                              uint64_t bulk_min_bytes)
+{
+    if (!server || bulk_threads < 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    server->bulk_limit = bulk_threads;
+    if (bulk_min_bytes > 0) {
+        server->bulk_min_bytes = bulk_min_bytes;
+    }
+    
+    return BUCKETS_OK;
+}
+
 int uv_http_server_set_handler(uv_http_server_t *server,
                                 uv_http_handler_t handler,
                                 void *user_data)
@@ -272,12 +366,84 @@ int uv_http_server_add_async_route(uv_http_server_t *server,
  * TLS Initialization
  * ===================================================================*/
 
+/* TLS tuning, read once from the environment:
+ *   BUCKETS_KTLS=off                 keep record encryption in user space
+ *   BUCKETS_TLS_SESSION_CACHE=<n>    server session cache entries (0 = off)
+ *   BUCKETS_TLS_SESSION_TIMEOUT=<s>  lifetime of cached sessions and tickets
+ *   BUCKETS_TLS_TICKET_KEY=<secret>  ticket key shared by every worker, so a
+ *                                    client resumes whichever one it reaches */
+static struct {
+    bool ktls;
+    long session_cache;
+    long session_timeout;
+    const char *ticket_key;
+} g_tls_config = {
+    .ktls = true,
+    .session_cache = 20480,
+    .session_timeout = 7200,
+    .ticket_key = NULL,
+};
+static pthread_once_t g_tls_config_once = PTHREAD_ONCE_INIT;
+
+static void tls_config_load(void)
+{
+    const char *env = getenv("BUCKETS_KTLS");
+    if (env && (strcmp(env, "off") == 0 || strcmp(env, "0") == 0)) {
+        g_tls_config.ktls = false;
+    }
+    env = getenv("BUCKETS_TLS_SESSION_CACHE");
+    if (env && *env) {
+        g_tls_config.session_cache = strtol(env, NULL, 10);
+    }
+    env = getenv("BUCKETS_TLS_SESSION_TIMEOUT");
+    if (env && strtol(env, NULL, 10) > 0) {
+        g_tls_config.session_timeout = strtol(env, NULL, 10);
+    }
+    env = getenv("BUCKETS_TLS_TICKET_KEY");
+    if (env && *env) {
+        g_tls_config.ticket_key = env;
+    }
+}
+
+/* Derive the 80-byte ticket key block (name, HMAC key, AES key) from the
+ * configured secret */
+static int tls_set_ticket_key(SSL_CTX *ctx, const char *secret)
+{
+    unsigned char keys[80];
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    
+    if (!EVP_Digest(secret, strlen(secret), digest, &digest_len, EVP_sha256(), NULL)) {
+        return -1;
+    }
+    memcpy(keys, digest, 16);
+    
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    static const char label[] = "buckets tls ticket keys";
+    int ok = md &&
+             EVP_DigestInit_ex(md, EVP_sha512(), NULL) &&
+             EVP_DigestUpdate(md, label, sizeof(label) - 1) &&
+             EVP_DigestUpdate(md, secret, strlen(secret)) &&
+             EVP_DigestFinal_ex(md, digest, &digest_len);
+    EVP_MD_CTX_free(md);
+    if (ok) {
+        memcpy(keys + 16, digest, 64);
+        ok = SSL_CTX_set_tlsext_ticket_keys(ctx, keys, sizeof(keys)) == 1;
+    }
+    
+    OPENSSL_cleanse(keys, sizeof(keys));
+    OPENSSL_cleanse(digest, sizeof(digest));
+    return ok ? 0 : -1;
+}
+
 int uv_http_tls_init(uv_http_server_t *server)
 {
     if (!server->tls_enabled) {
         return BUCKETS_OK;
     }
     
+    pthread_once(&g_tls_config_once, tls_config_load);
+    
     /* Initialize OpenSSL */
     SSL_library_init();
     SSL_load_error_strings();
@@ -294,6 +460,38 @@ int uv_http_tls_init(uv_http_server_t *server)
     /* Set minimum TLS version to 1.2 */
     SSL_CTX_set_min_proto_version(server->ssl_ctx, TLS1_2_VERSION);
     
+    /* Hand record encryption to the kernel after the handshake when the
+     * cipher and kernel allow it; the socket then carries plaintext as far
+     * as we are concerned (see tls_handshake_done) */
+#ifdef SSL_OP_ENABLE_KTLS
+    if (g_tls_config.ktls) {
+        SSL_CTX_set_options(server->ssl_ctx, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+    
+    /* Session resumption: a server-side cache for session IDs, plus
+     * tickets (on by default) for clients that prefer them */
+    static const unsigned char sid_ctx[] = "buckets";
+    SSL_CTX_set_session_id_context(server->ssl_ctx, sid_ctx, sizeof(sid_ctx) - 1);
+    SSL_CTX_set_timeout(server->ssl_ctx, g_tls_config.session_timeout);
+    if (g_tls_config.session_cache > 0) {
+        SSL_CTX_set_session_cache_mode(server->ssl_ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(server->ssl_ctx, g_tls_config.session_cache);
+    } else {
+        SSL_CTX_set_session_cache_mode(server->ssl_ctx, SSL_SESS_CACHE_OFF);
+    }
+    if (g_tls_config.ticket_key) {
+        if (tls_set_ticket_key(server->ssl_ctx, g_tls_config.ticket_key) != 0) {
+            buckets_error("Failed to install TLS session ticket key");
+            SSL_CTX_free(server->ssl_ctx);
+            server->ssl_ctx = NULL;
+            return BUCKETS_ERR_IO;
+        }
+    } else if (getenv("BUCKETS_WORKERS")) {
+        buckets_warn("TLS session tickets only resume on the issuing worker; "
+                     "set BUCKETS_TLS_TICKET_KEY to share them");
+    }
+    
     /* Load certificate */
     if (SSL_CTX_use_certificate_file(server->ssl_ctx, server->cert_file, 
                                       SSL_FILETYPE_PEM) <= 0) {
@@ -322,7 +520,25 @@ int uv_http_tls_init(uv_http_server_t *server)
         return BUCKETS_ERR_IO;
     }
     
-    buckets_info("TLS initialized with certificate: %s", server->cert_file);
+    /* Ask for (but don't require) a client certificate: S3 clients
+     * connect without one, peer nodes present theirs */
+    if (server->peer_ca_file[0]) {
+        STACK_OF(X509_NAME) *names = SSL_load_client_CA_file(server->peer_ca_file);
+        if (!names ||
+            SSL_CTX_load_verify_locations(server->ssl_ctx, server->peer_ca_file, NULL) != 1) {
+            buckets_error("Failed to load peer CA: %s", server->peer_ca_file);
+            sk_X509_NAME_pop_free(names, X509_NAME_free);
+            SSL_CTX_free(server->ssl_ctx);
+            server->ssl_ctx = NULL;
+            return BUCKETS_ERR_IO;
+        }
+        SSL_CTX_set_client_CA_list(server->ssl_ctx, names);
+        SSL_CTX_set_verify(server->ssl_ctx, SSL_VERIFY_PEER, NULL);
+    }
+    
+    buckets_info("TLS initialized with certificate: %s (kTLS %s, session cache %ld)",
+                 server->cert_file, g_tls_config.ktls ? "allowed" : "off",
+                 g_tls_config.session_cache);
     
     return BUCKETS_OK;
 }
@@ -420,6 +636,15 @@ int uv_http_server_start(uv_http_server_t *server)
         }
         buckets_info("SO_REUSEPORT enabled for multi-process worker pool");
         
+#ifdef SO_INCOMING_CPU
+        /* Prefer this worker for connections whose packets land on its CPU */
+        int home_cpu = buckets_numa_home_cpu();
+        if (home_cpu >= 0 &&
+            setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &home_cpu, sizeof(home_cpu)) < 0) {
+            buckets_warn("Failed to set SO_INCOMING_CPU: %s", strerror(errno));
+        }
+#endif
+        
         /* Optimize socket buffers for better performance */
         int sndbuf = 256 * 1024;  /* 256 KB send buffer */
         int rcvbuf = 256 * 1024;  /* 256 KB receive buffer */
@@ -518,6 +743,33 @@ int uv_http_server_start(uv_http_server_t *server)
     }
     server->shutdown_async.data = server;
     
+    /* Initialize memory budget wakeup (resumes paused uploads) */
+    ret = uv_async_init(server->loop, &server->budget_async, on_budget_async);
+    if (ret != 0) {
+        buckets_error("Failed to init budget async: %s", uv_strerror(ret));
+        uv_close((uv_handle_t*)&server->shutdown_async, NULL);
+        uv_close((uv_handle_t*)&server->tcp, NULL);
+        uv_loop_close(server->loop);
+        buckets_free(server->loop);
+        server->loop = NULL;
+        return BUCKETS_ERR_IO;
+    }
+    server->budget_async.data = server;
+    
+    /* Initialize resume wakeup (suspended resumable handlers) */
+    ret = uv_async_init(server->loop, &server->resume_async, on_resume_async);
+    if (ret != 0) {
+        buckets_error("Failed to init resume async: %s", uv_strerror(ret));
+        uv_close((uv_handle_t*)&server->budget_async, NULL);
+        uv_close((uv_handle_t*)&server->shutdown_async, NULL);
+        uv_close((uv_handle_t*)&server->tcp, NULL);
+        uv_loop_close(server->loop);
+        buckets_free(server->loop);
+        server->loop = NULL;
+        return BUCKETS_ERR_IO;
+    }
+    server->resume_async.data = server;
+    
     server->running = true;
     
     /* Start server thread */
@@ -525,6 +777,8 @@ int uv_http_server_start(uv_http_server_t *server)
     if (ret != 0) {
         buckets_error("Failed to create server thread");
         server->running = false;
+        uv_close((uv_handle_t*)&server->resume_async, NULL);
+        uv_close((uv_handle_t*)&server->budget_async, NULL);
         uv_close((uv_handle_t*)&server->shutdown_async, NULL);
         uv_close((uv_handle_t*)&server->tcp, NULL);
         uv_loop_close(server->loop);
@@ -533,6 +787,11 @@ int uv_http_server_start(uv_http_server_t *server)
         return BUCKETS_ERR_IO;
     }
     
+    if (buckets_mem_budget_add_hook(budget_release_hook, server) != BUCKETS_OK) {
+        buckets_warn("Memory budget hook slots exhausted; paused uploads resume "
+                     "only on this server's own releases");
+    }
+    
     const char *proto = server->tls_enabled ? "https" : "http";
     buckets_info("UV HTTP server started: %s://%s:%d", proto, server->address, server->port);
     
@@ -611,7 +870,10 @@ static void on_shutdown_async(uv_async_t *handle)
     }
     
     /* Stop accepting new connections */
+    buckets_mem_budget_remove_hook(budget_release_hook, server);
     uv_close((uv_handle_t*)&server->tcp, NULL);
+    uv_close((uv_handle_t*)&server->resume_async, NULL);
+    uv_close((uv_handle_t*)&server->budget_async, NULL);
     uv_close((uv_handle_t*)&server->shutdown_async, NULL);
     
     /* Stop the event loop */
@@ -636,6 +898,7 @@ void uv_http_server_free(uv_http_server_t *server)
     }
     
     pthread_mutex_destroy(&server->lock);
+    pthread_mutex_destroy(&server->resume_lock);
     buckets_free(server);
 }
 
@@ -688,9 +951,8 @@ uv_http_conn_t* uv_http_conn_create(uv_http_server_t *server)
             return NULL;
         }
         
-        conn->read_bio = BIO_new(BIO_s_mem());
-        conn->write_bio = BIO_new(BIO_s_mem());
-        SSL_set_bio(conn->ssl, conn->read_bio, conn->write_bio);
+        /* BIOs are attached once the socket is accepted (see
+         * tls_handshake_start) */
         SSL_set_accept_state(conn->ssl);
         
         /* Allocate TLS read buffer */
@@ -761,6 +1023,12 @@ void uv_http_conn_reset(uv_http_conn_t *conn)
     }
     conn->content_length = 0;
     
+    /* Request buffers are gone: return their memory budget */
+    conn_budget_release(conn);
+    conn_qos_release(conn);
+    conn->qos_refused = 0;
+    conn->lane = UV_HTTP_LANE_INTERACTIVE;
+    
     /* Reset response state */
     conn->response_started = false;
     conn->response_chunked = false;
@@ -807,8 +1075,28 @@ void uv_http_conn_close(uv_http_conn_t *conn)
         return;
     }
     
+    if (conn->tls_handshaking) {
+        /* A pool thread is using the socket; tls_handshake_after closes the
+         * handles once it returns */
+        buckets_debug("  TLS handshake in progress, deferring close (conn=%p)", conn);
+        return;
+    }
+    
+    conn_close_handles(conn);
+}
+
+/**
+ * Close a closing connection's handles; the connection is freed once the
+ * last close callback has run
+ */
+static void conn_close_handles(uv_http_conn_t *conn)
+{
     buckets_info("  Proceeding to close handles (conn=%p)", conn);
     
+    /* Before the TCP handle, whose close releases the descriptor */
+    tls_poll_close(conn);
+    qos_timer_close(conn);
+    
     /* Stop timeout timer */
     uv_timer_stop(&conn->timeout_timer);
     
@@ -850,6 +1138,22 @@ static void on_handle_close(uv_handle_t *handle)
         return;
     }
     
+    /* A resumable handler reads the connection between stages; the stage
+     * chain frees it when it unwinds (see async_finish) */
+    if (conn->async_work) {
+        buckets_debug("on_handle_close: async work in progress, deferring free (conn=%p)", conn);
+        conn->free_deferred = true;
+        return;
+    }
+    
+    conn_destroy(conn);
+}
+
+/**
+ * Free a connection whose handles have all closed
+ */
+static void conn_destroy(uv_http_conn_t *conn)
+{
     /* All handles are now closed - safe to free the connection */
     buckets_info("on_handle_close: All handles closed, freeing connection (conn=%p)", conn);
     uv_http_server_t *server = conn->server;
@@ -869,6 +1173,11 @@ static void on_handle_close(uv_handle_t *handle)
     
     /* Clean up TLS */
     if (conn->ssl) {
+        /* No close_notify is exchanged; without marking the connection
+         * shut down, SSL_free would evict its session from the cache */
+        if (conn->tls_handshake_complete) {
+            SSL_set_shutdown(conn->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
         SSL_free(conn->ssl);  /* Also frees BIOs */
         conn->ssl = NULL;
     }
@@ -888,6 +1197,229 @@ static void on_handle_close(uv_handle_t *handle)
     buckets_free(conn);
 }
 
+/* ===================================================================
+ * Memory Budget Backpressure
+ * ===================================================================*/
+
+/**
+ * Release hook: runs on whichever thread frees budget (budget lock held),
+ * so only poke the loop when something is actually waiting.
+ */
+static void budget_release_hook(void *arg)
+{
+    uv_http_server_t *server = (uv_http_server_t*)arg;
+    if (__atomic_load_n(&server->budget_waiting, __ATOMIC_ACQUIRE) > 0) {
+        uv_async_send(&server->budget_async);
+    }
+}
+
+/**
+ * Resume paused connections in arrival order while their reservations fit.
+ * Stops at the first that does not, so a large upload is not overtaken
+ * forever by smaller ones behind it.
+ */
+static void budget_drain(uv_http_server_t *server)
+{
+    while (server->budget_wait_head) {
+        uv_http_conn_t *conn = server->budget_wait_head;
+        if (!buckets_mem_budget_try_reserve(conn->budget_wanted)) {
+            break;
+        }
+        
+        server->budget_wait_head = conn->budget_next;
+        if (!server->budget_wait_head) {
+            server->budget_wait_tail = NULL;
+        }
+        __atomic_sub_fetch(&server->budget_waiting, 1, __ATOMIC_RELEASE);
+        
+        conn->budget_next = NULL;
+        conn->budget_paused = false;
+        conn->budget_reserved += conn->budget_wanted;
+        conn->budget_wanted = 0;
+        
+        if (conn->state != CONN_STATE_CLOSING && !uv_is_closing((uv_handle_t*)&conn->tcp) &&
+            !conn->qos_paused) {
+            buckets_debug("Memory budget available, resuming reads (conn=%p)", conn);
+            uv_http_conn_reset_timeout(conn, server->body_timeout_ms);
+            uv_read_start((uv_stream_t*)&conn->tcp, on_alloc, on_read);
+        }
+    }
+}
+
+static void on_budget_async(uv_async_t *handle)
+{
+    budget_drain((uv_http_server_t*)handle->data);
+}
+
+/**
+ * Reserve budget for a request body, pausing reads until it is available
+ */
+static void conn_budget_reserve(uv_http_conn_t *conn, uint64_t bytes)
+{
+    uv_http_server_t *server = conn->server;
+    
+    /* Never overtake connections that are already waiting */
+    if (!server->budget_wait_head && buckets_mem_budget_try_reserve(bytes)) {
+        conn->budget_reserved += bytes;
+        return;
+    }
+    
+    buckets_debug("Memory budget exhausted, pausing reads for %lu-byte body (conn=%p)",
+                  (unsigned long)bytes, conn);
+    
+    conn->budget_wanted = bytes;
+    conn->budget_paused = true;
+    conn->budget_next = NULL;
+    if (server->budget_wait_tail) {
+        server->budget_wait_tail->budget_next = conn;
+    } else {
+        server->budget_wait_head = conn;
+    }
+    server->budget_wait_tail = conn;
+    __atomic_add_fetch(&server->budget_waiting, 1, __ATOMIC_RELEASE);
+    
+    /* We are the ones holding things up: no body timeout while paused */
+    uv_read_stop((uv_stream_t*)&conn->tcp);
+    uv_http_conn_stop_timeout(conn);
+    
+    /* Budget may have been released before we were queued */
+    budget_drain(server);
+}
+
+/**
+ * Return a connection's budget and leave the wait queue (loop thread)
+ */
+static void conn_budget_release(uv_http_conn_t *conn)
+{
+    uv_http_server_t *server = conn->server;
+    
+    if (conn->budget_paused) {
+        uv_http_conn_t **pp = &server->budget_wait_head;
+        uv_http_conn_t *prev = NULL;
+        while (*pp && *pp != conn) {
+            prev = *pp;
+            pp = &(*pp)->budget_next;
+        }
+        if (*pp) {
+            *pp = conn->budget_next;
+            if (server->budget_wait_tail == conn) {
+                server->budget_wait_tail = prev;
+            }
+            __atomic_sub_fetch(&server->budget_waiting, 1, __ATOMIC_RELEASE);
+        }
+        conn->budget_next = NULL;
+        conn->budget_paused = false;
+        conn->budget_wanted = 0;
+    }
+    
+    if (conn->budget_reserved > 0) {
+        uint64_t bytes = conn->budget_reserved;
+        conn->budget_reserved = 0;
+        buckets_mem_budget_release(bytes);
+    }
+}
+
+/* ===================================================================
+ * Tenant QoS Pacing
+ *
+ * Bytes are charged as they move; what the tenant then owes is paid by
+ * not reading from the connection for that long, once the current read
+ * has been parsed (request bodies) or the response has been written
+ * (before the next request on a keep-alive connection).
+ * ===================================================================*/
+
+static void on_qos_timer(uv_timer_t *timer);
+
+static void on_qos_timer_close(uv_handle_t *handle)
+{
+    buckets_free(handle);
+}
+
+static void qos_timer_close(uv_http_conn_t *conn)
+{
+    if (conn->qos_timer) {
+        if (!uv_is_closing((uv_handle_t*)conn->qos_timer)) {
+            uv_close((uv_handle_t*)conn->qos_timer, on_qos_timer_close);
+        }
+        conn->qos_timer = NULL;
+    }
+}
+
+static void conn_qos_release(uv_http_conn_t *conn)
+{
+    if (conn->qos_tenant && conn->server->qos.release) {
+        conn->server->qos.release(conn->qos_tenant);
+    }
+    conn->qos_tenant = NULL;
+}
+
+static void conn_qos_charge(uv_http_conn_t *conn, size_t bytes, bool inbound)
+{
+    if (!conn->qos_tenant || bytes == 0) {
+        return;
+    }
+    
+    uint64_t pause_us = conn->server->qos.charge(conn->qos_tenant, bytes, inbound);
+    if (pause_us > conn->qos_pause_us) {
+        conn->qos_pause_us = pause_us;
+    }
+}
+
+/**
+ * Stop reading for as long as the connection's tenant owes (loop thread)
+ */
+static void conn_qos_pace(uv_http_conn_t *conn)
+{
+    if (conn->qos_pause_us == 0 || conn->qos_paused || conn->state == CONN_STATE_CLOSING) {
+        return;
+    }
+    
+    if (!conn->qos_timer) {
+        conn->qos_timer = buckets_malloc(sizeof(uv_timer_t));
+        if (!conn->qos_timer) {
+            conn->qos_pause_us = 0;
+            return;
+        }
+        uv_timer_init(conn->server->loop, conn->qos_timer);
+        conn->qos_timer->data = conn;
+    }
+    
+    uint64_t pause_ms = (conn->qos_pause_us + 999) / 1000;
+    conn->qos_pause_us = 0;
+    conn->qos_paused = true;
+    
+    buckets_debug("Tenant over its limit, pausing reads for %lu ms (conn=%p)",
+                  (unsigned long)pause_ms, conn);
+    
+    /* As with the memory budget: no timeout while we hold things up */
+    uv_read_stop((uv_stream_t*)&conn->tcp);
+    uv_http_conn_stop_timeout(conn);
+    uv_timer_start(conn->qos_timer, on_qos_timer, pause_ms, 0);
+}
+
+static void on_qos_timer(uv_timer_t *timer)
+{
+    uv_http_conn_t *conn = (uv_http_conn_t*)timer->data;
+    
+    conn->qos_paused = false;
+    if (conn->state == CONN_STATE_CLOSING || uv_is_closing((uv_handle_t*)&conn->tcp)) {
+        return;
+    }
+    
+    /* Response bytes written while paused */
+    if (conn->qos_pause_us > 0) {
+        conn_qos_pace(conn);
+        return;
+    }
+    
+    uv_http_conn_reset_timeout(conn, conn->state == CONN_STATE_READING_BODY ?
+                               conn->server->body_timeout_ms :
+                               conn->server->keepalive_timeout_ms);
+    if (!conn->budget_paused) {
+        uv_read_start((uv_stream_t*)&conn->tcp, on_alloc, on_read);
+    }
+}
+
 /* ===================================================================
  * Timeout Management
  * ===================================================================*/
@@ -918,8 +1450,10 @@ static void on_timeout(uv_timer_t *timer)
         return;
     }
     
-    /* Send timeout response if we haven't started a response */
-    if (!conn->response_started && conn->state != CONN_STATE_CLOSING) {
+    /* Send timeout response if we haven't started a response (not while
+     * the socket still expects TLS records we would have to encrypt) */
+    if (!conn->response_started && conn->state != CONN_STATE_CLOSING &&
+        (!conn->ssl || conn->ktls_tx)) {
         const char *response = "HTTP/1.1 408 Request Timeout\r\n"
                               "Connection: close\r\n"
                               "Content-Length: 0\r\n"
@@ -1010,9 +1544,18 @@ static void on_connection(uv_stream_t *server_handle, int status)
         }
     }
     
-    /* Start timeout for headers */
+    /* Start timeout for headers (TLS: the handshake counts against it) */
     uv_http_conn_reset_timeout(conn, server->headers_timeout_ms);
     
+    /* TLS connections handshake first; reading starts once it completes */
+    if (conn->ssl) {
+        if (tls_handshake_start(conn) != 0) {
+            buckets_error("Failed to start TLS handshake");
+            uv_http_conn_close(conn);
+        }
+        return;
+    }
+    
     /* Start reading */
     ret = uv_read_start((uv_stream_t*)&conn->tcp, on_alloc, on_read);
     if (ret != 0) {
@@ -1033,83 +1576,238 @@ static void on_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
 }
 
 /* ===================================================================
- * TLS Handling
+ * TLS Handshake
+ *
+ * The handshake runs off the event loop: the loop only watches the
+ * socket with a poll handle, and each SSL_do_handshake step (where the
+ * signature and key exchange cost lies) runs on the thread pool against
+ * the non-blocking socket itself. A burst of new TLS clients therefore
+ * no longer stalls requests on established connections, and no pool
+ * thread ever waits for the network.
+ *
+ * Doing the handshake on the socket rather than memory BIOs is also what
+ * lets OpenSSL install kernel TLS keys when it finishes. Afterwards the
+ * poll handle is closed and the TCP handle takes over the socket.
  * ===================================================================*/
 
-static int tls_flush_write_bio(uv_http_conn_t *conn)
+static void on_tls_poll(uv_poll_t *handle, int status, int events);
+
+static void on_tls_poll_close(uv_handle_t *handle)
 {
-    char buf[16384];
-    int pending;
-    
-    while ((pending = BIO_pending(conn->write_bio)) > 0) {
-        int n = BIO_read(conn->write_bio, buf, sizeof(buf));
-        if (n <= 0) break;
-        
-        /* Validate stream before write */
-        if (!is_stream_valid_for_write(conn)) {
-            return -1;
-        }
-        
-        /* Write to TCP */
-        char *write_buf = buckets_malloc(n);
-        memcpy(write_buf, buf, n);
-        
-        uv_buf_t uv_buf = uv_buf_init(write_buf, n);
-        uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
-        req->data = write_buf;
-        
-        int ret = uv_write(req, (uv_stream_t*)&conn->tcp, &uv_buf, 1, on_write_complete);
-        if (ret != 0) {
-            buckets_free(write_buf);
-            buckets_free(req);
-            return -1;
+    buckets_free(handle);
+}
+
+static void tls_poll_close(uv_http_conn_t *conn)
+{
+    if (conn->tls_poll) {
+        /* Server shutdown may already have closed it (uv_walk) */
+        if (!uv_is_closing((uv_handle_t*)conn->tls_poll)) {
+            uv_close((uv_handle_t*)conn->tls_poll, on_tls_poll_close);
         }
+        conn->tls_poll = NULL;
     }
-    
-    return 0;
 }
 
-static int tls_do_handshake(uv_http_conn_t *conn)
+static int tls_handshake_start(uv_http_conn_t *conn)
 {
+    int fd = -1;
+    if (uv_fileno((uv_handle_t*)&conn->tcp, &fd) != 0 || !SSL_set_fd(conn->ssl, fd)) {
+        return -1;
+    }
+    
+    conn->tls_poll = buckets_malloc(sizeof(uv_poll_t));
+    if (!conn->tls_poll) {
+        return -1;
+    }
+    if (uv_poll_init_socket(conn->server->loop, conn->tls_poll, fd) != 0) {
+        buckets_free(conn->tls_poll);
+        conn->tls_poll = NULL;
+        return -1;
+    }
+    conn->tls_poll->data = conn;
+    
+    return uv_poll_start(conn->tls_poll, UV_READABLE, on_tls_poll) == 0 ? 0 : -1;
+}
+
+/* Pool thread: one handshake step */
+static void tls_handshake_work(uv_work_t *req)
+{
+    uv_http_conn_t *conn = (uv_http_conn_t*)req->data;
+    
+    ERR_clear_error();
     int ret = SSL_do_handshake(conn->ssl);
+    conn->tls_handshake_err = (ret == 1) ? SSL_ERROR_NONE : SSL_get_error(conn->ssl, ret);
     
-    if (ret == 1) {
-        /* Handshake complete */
-        conn->tls_handshake_complete = true;
-        buckets_debug("TLS handshake complete");
-        return 0;
+    /* The error queue is per thread: report it here */
+    if (conn->tls_handshake_err == SSL_ERROR_SSL) {
+        char reason[256];
+        ERR_error_string_n(ERR_peek_last_error(), reason, sizeof(reason));
+        buckets_debug("TLS handshake failed: %s", reason);
     }
+}
+
+static void tls_handshake_done(uv_http_conn_t *conn)
+{
+    /* The poll handle's close drops its epoll registration, so it must go
+     * before the TCP handle starts reading the same descriptor */
+    tls_poll_close(conn);
+    conn->tls_handshake_complete = true;
+    
+#ifdef SSL_OP_ENABLE_KTLS
+    conn->ktls_tx = BIO_get_ktls_send(SSL_get_wbio(conn->ssl)) > 0;
+    conn->ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(conn->ssl)) > 0;
+#endif
     
-    int err = SSL_get_error(conn->ssl, ret);
-    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-        /* Need more data or need to write */
-        tls_flush_write_bio(conn);
-        return 1;  /* Continue */
+    /* Whatever the kernel doesn't handle goes through memory BIOs, so all
+     * socket I/O stays on the event loop */
+    if (!conn->ktls_rx) {
+        conn->read_bio = BIO_new(BIO_s_mem());
+        if (!conn->read_bio) {
+            uv_http_conn_close(conn);
+            return;
+        }
+        SSL_set0_rbio(conn->ssl, conn->read_bio);
     }
+    if (!conn->ktls_tx) {
+        conn->write_bio = BIO_new(BIO_s_mem());
+        if (!conn->write_bio) {
+            uv_http_conn_close(conn);
+            return;
+        }
+        SSL_set0_wbio(conn->ssl, conn->write_bio);
+    }
+    
+    /* Verification failures abort the handshake, so a certificate here
+     * chains to the peer CA */
+    if (conn->server->peer_ca_file[0]) {
+        X509 *peer = SSL_get_peer_certificate(conn->ssl);
+        conn->tls_peer_verified = peer && SSL_get_verify_result(conn->ssl) == X509_V_OK;
+        X509_free(peer);
+    }
+    
+    bool resumed = SSL_session_reused(conn->ssl);
+    uv_metrics_tls_handshake(resumed, conn->ktls_tx && conn->ktls_rx);
+    buckets_debug("TLS handshake complete (%s, %s, kTLS tx=%d rx=%d)",
+                  SSL_get_version(conn->ssl), resumed ? "resumed" : "full",
+                  conn->ktls_tx, conn->ktls_rx);
     
-    /* Error */
-    buckets_error("TLS handshake failed: %d", err);
-    ERR_print_errors_fp(stderr);
-    return -1;
+    if (uv_read_start((uv_stream_t*)&conn->tcp, on_alloc, on_read) != 0) {
+        uv_http_conn_close(conn);
+    }
 }
 
-static int process_tls_data(uv_http_conn_t *conn, const char *data, ssize_t len)
+static void tls_handshake_after(uv_work_t *req, int status)
 {
-    /* Write encrypted data to read BIO */
-    BIO_write(conn->read_bio, data, len);
+    uv_http_conn_t *conn = (uv_http_conn_t*)req->data;
+    conn->tls_handshaking = false;
+    
+    if (conn->state == CONN_STATE_CLOSING) {
+        /* uv_http_conn_close waited for the pool thread to leave the socket */
+        conn_close_handles(conn);
+        return;
+    }
+    if (status != 0) {
+        uv_http_conn_close(conn);
+        return;
+    }
+    
+    int events = 0;
+    switch (conn->tls_handshake_err) {
+        case SSL_ERROR_NONE:
+            tls_handshake_done(conn);
+            return;
+        case SSL_ERROR_WANT_READ:
+            events = UV_READABLE;
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            events = UV_WRITABLE;
+            break;
+        default:
+            uv_metrics_tls_failure();
+            uv_http_conn_close(conn);
+            return;
+    }
+    
+    if (uv_poll_start(conn->tls_poll, events, on_tls_poll) != 0) {
+        uv_http_conn_close(conn);
+    }
+}
+
+static void on_tls_poll(uv_poll_t *handle, int status, int events)
+{
+    (void)events;
+    uv_http_conn_t *conn = (uv_http_conn_t*)handle->data;
+    
+    uv_poll_stop(handle);
+    if (status < 0) {
+        uv_http_conn_close(conn);
+        return;
+    }
     
-    if (!conn->tls_handshake_complete) {
-        /* Continue handshake */
-        int ret = tls_do_handshake(conn);
-        if (ret < 0) {
-            return -1;  /* Handshake failed */
+    conn->tls_work.data = conn;
+    if (uv_queue_work(conn->server->loop, &conn->tls_work,
+                      tls_handshake_work, tls_handshake_after) != 0) {
+        uv_http_conn_close(conn);
+        return;
+    }
+    conn->tls_handshaking = true;
+}
+
+/* ===================================================================
+ * TLS Records
+ *
+ * Used only for the directions kernel TLS isn't handling on a connection.
+ * ===================================================================*/
+
+/* User-space TLS still encrypts this connection's writes */
+static inline bool conn_tls_encrypts(uv_http_conn_t *conn)
+{
+    return conn->ssl && !conn->ktls_tx;
+}
+
+/* Send records OpenSSL produced on its own (alerts, key updates) */
+static int tls_flush_write_bio(uv_http_conn_t *conn)
+{
+    char buf[16384];
+    int pending;
+    
+    if (!conn->write_bio) {
+        return 0;
+    }
+    
+    while ((pending = BIO_pending(conn->write_bio)) > 0) {
+        int n = BIO_read(conn->write_bio, buf, sizeof(buf));
+        if (n <= 0) break;
+        
+        /* Validate stream before write */
+        if (!is_stream_valid_for_write(conn)) {
+            return -1;
         }
-        if (ret > 0) {
-            return 0;  /* Need more data */
+        
+        /* Write to TCP */
+        char *write_buf = buckets_malloc(n);
+        memcpy(write_buf, buf, n);
+        
+        uv_buf_t uv_buf = uv_buf_init(write_buf, n);
+        uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
+        req->data = write_buf;
+        
+        int ret = uv_write(req, (uv_stream_t*)&conn->tcp, &uv_buf, 1, on_write_complete);
+        if (ret != 0) {
+            buckets_free(write_buf);
+            buckets_free(req);
+            return -1;
         }
-        /* Fall through if handshake just completed */
     }
     
+    return 0;
+}
+
+static int process_tls_data(uv_http_conn_t *conn, const char *data, ssize_t len)
+{
+    /* Write encrypted data to read BIO */
+    BIO_write(conn->read_bio, data, len);
+    
     /* Decrypt data */
     char decrypted[BUCKETS_READ_BUFFER_SIZE];
     int n;
@@ -1122,6 +1820,15 @@ static int process_tls_data(uv_http_conn_t *conn, const char *data, ssize_t len)
             buckets_error("HTTP parse error: %s", llhttp_errno_name(err));
             return -1;
         }
+        
+        /* As for plain HTTP: dispatch after llhttp_execute() returns */
+        if (conn->message_complete) {
+            conn->message_complete = false;
+            process_request(conn);
+        }
+        if (conn->state == CONN_STATE_CLOSING) {
+            return 0;
+        }
     }
     
     int ssl_err = SSL_get_error(conn->ssl, n);
@@ -1132,7 +1839,7 @@ static int process_tls_data(uv_http_conn_t *conn, const char *data, ssize_t len)
         }
     }
     
-    return 0;
+    return tls_flush_write_bio(conn);
 }
 
 /* ===================================================================
@@ -1169,8 +1876,8 @@ static void on_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
         conn->state = CONN_STATE_READING_HEADERS;
     }
     
-    /* Handle TLS or plain text */
-    if (conn->ssl) {
+    /* Handle TLS or plain text (kernel TLS already decrypted it) */
+    if (conn->ssl && !conn->ktls_rx) {
         if (process_tls_data(conn, conn->read_buffer, nread) < 0) {
             uv_http_conn_close(conn);
         }
@@ -1186,7 +1893,7 @@ static void on_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
                          conn->requests_served);
             
             /* Send error response */
-            if (!conn->response_started) {
+            if (!conn->response_started && !conn_tls_encrypts(conn)) {
                 const char *response = "HTTP/1.1 400 Bad Request\r\n"
                                       "Connection: close\r\n"
                                       "Content-Length: 0\r\n"
@@ -1205,6 +1912,10 @@ static void on_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
             process_request(conn);
         }
     }
+    
+    if (conn->state == CONN_STATE_READING_BODY) {
+        conn_qos_pace(conn);
+    }
 }
 
 /* ===================================================================
@@ -1233,6 +1944,10 @@ int on_message_begin(llhttp_t *parser)
     
     /* Reset for new request (already done if keep-alive) */
     conn->state = CONN_STATE_READING_HEADERS;
+    conn->peer_route_denied = false;
+    conn_qos_release(conn);
+    conn->qos_refused = 0;
+    conn->lane = UV_HTTP_LANE_INTERACTIVE;
     
     return 0;
 }
@@ -1366,6 +2081,16 @@ int on_header_value_complete(llhttp_t *parser)
     return 0;
 }
 
+/* Node-to-node routes: chunk and batch transport, RPC */
+static bool is_peer_route(const char *url, size_t url_len)
+{
+    if (url_len >= 11 && strncmp(url, "/_internal/", 11) == 0) {
+        return true;
+    }
+    return url_len >= 4 && strncmp(url, "/rpc", 4) == 0 &&
+           (url_len == 4 || url[4] == '?' || url[4] == '/');
+}
+
 int on_headers_complete(llhttp_t *parser)
 {
     uv_http_conn_t *conn = (uv_http_conn_t*)parser->data;
@@ -1391,12 +2116,14 @@ int on_headers_complete(llhttp_t *parser)
     if (expect && strcasecmp(expect, "100-continue") == 0) {
         /* Send 100 Continue response to tell client to proceed with body */
         static const char continue_response[] = "HTTP/1.1 100 Continue\r\n\r\n";
-        uv_buf_t buf = uv_buf_init((char*)continue_response, sizeof(continue_response) - 1);
         
         /* Synchronous write - must complete before body arrives */
         uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
         req->data = NULL;  /* No buffer to free */
-        uv_write(req, (uv_stream_t*)&conn->tcp, &buf, 1, on_write_complete);
+        if (conn_write(conn, req, (char*)continue_response,
+                       sizeof(continue_response) - 1) != 0) {
+            buckets_free(req);
+        }
     }
     
     conn->state = CONN_STATE_READING_BODY;
@@ -1404,6 +2131,25 @@ int on_headers_complete(llhttp_t *parser)
     /* Reset timeout for body */
     uv_http_conn_reset_timeout(conn, conn->server->body_timeout_ms);
     
+    /* Refused in process_request; the body is read and dropped */
+    if (conn->server->peer_ca_file[0] && !conn->tls_peer_verified &&
+        is_peer_route(conn->url, conn->url_len)) {
+        conn->peer_route_denied = true;
+        return 0;
+    }
+    
+    /* Likewise for tenants over their limits */
+    if (conn->server->qos.admit && !is_peer_route(conn->url, conn->url_len)) {
+        int status = conn->server->qos.admit(conn, &conn->qos_tenant);
+        if (status != 0) {
+            conn->qos_tenant = NULL;
+            conn->qos_refused = status;
+            return 0;
+        }
+    }
+    
+    conn_classify_lane(conn);
+    
     /* Check for streaming handler */
     uv_route_t *route = find_streaming_route(conn);
     if (route) {
@@ -1421,6 +2167,16 @@ int on_headers_complete(llhttp_t *parser)
         }
     }
     
+    /* Both modes hold the whole body in memory (streaming uploads also
+     * reassemble it on completion): reserve it before reading any */
+    if (conn->content_length >= BUCKETS_MEM_BUDGET_MIN_RESERVE) {
+        uint64_t bytes = conn->content_length;
+        if (conn->streaming_route) {
+            bytes *= 2;
+        }
+        conn_budget_reserve(conn, bytes);
+    }
+    
     return 0;
 }
 
@@ -1428,6 +2184,8 @@ int on_body(llhttp_t *parser, const char *at, size_t len)
 {
     uv_http_conn_t *conn = (uv_http_conn_t*)parser->data;
     
+    conn_qos_charge(conn, len, true);
+    
     /* For streaming handlers, call on_body_chunk */
     if (conn->streaming_route) {
         uv_route_t *route = conn->streaming_route;
@@ -1449,6 +2207,10 @@ int on_body(llhttp_t *parser, const char *at, size_t len)
         return 0;
     }
     
+    if (conn->peer_route_denied || conn->qos_refused) {
+        return 0;
+    }
+    
     /* For non-streaming: buffer the body */
     size_t needed = conn->body_len + len;
     if (needed > conn->body_capacity) {
@@ -1554,6 +2316,45 @@ int uv_http_iterate_headers_with_prefix(void *conn_ptr, const char *prefix,
     return count;
 }
 
+/**
+ * Client IP address of a connection
+ * Returns 0 on success.
+ */
+int uv_http_get_client_addr(uv_http_conn_t *conn, char *out, size_t out_len)
+{
+    struct sockaddr_storage addr;
+    int len = sizeof(addr);
+    if (!conn || !out || out_len == 0 ||
+        uv_tcp_getpeername(&conn->tcp, (struct sockaddr*)&addr, &len) != 0) {
+        return -1;
+    }
+    return uv_ip_name((struct sockaddr*)&addr, out, out_len) == 0 ? 0 : -1;
+}
+
+/* ===================================================================
+ * Tenant QoS Access
+ * ===================================================================*/
+
+void* uv_http_get_qos_tenant(void *conn_ptr)
+{
+    uv_http_conn_t *conn = (uv_http_conn_t *)conn_ptr;
+    return conn ? conn->qos_tenant : NULL;
+}
+
+/**
+ * Charge the rest of the request to another tenant (a handler that has
+ * authenticated it); the previous tenant is released
+ */
+void uv_http_set_qos_tenant(void *conn_ptr, void *tenant)
+{
+    uv_http_conn_t *conn = (uv_http_conn_t *)conn_ptr;
+    if (!conn) {
+        return;
+    }
+    conn_qos_release(conn);
+    conn->qos_tenant = tenant;
+}
+
 /* ===================================================================
  * Streaming Route Matching
  * ===================================================================*/
@@ -1618,6 +2419,21 @@ static void build_stream_request(uv_http_conn_t *conn, uv_stream_request_t *req)
  * Async Handler Thread Pool Support
  * ===================================================================*/
 
+/**
+ * One fan-out leg of a resumable handler stage
+ */
+struct uv_async_leg {
+    uv_work_t work;                /* Must be first for casting */
+    uv_async_work_t *async;
+    uv_http_leg_t fn;
+    void *ctx;
+    uv_async_leg_t *next;
+    uv_lane_item_t lane_item;
+};
+
+static void async_handler_after_work(uv_work_t *work, int status);
+static void async_finish(uv_async_work_t *async);
+
 /**
  * Worker thread function for async handlers.
  * Runs in libuv thread pool, NOT the event loop thread.
@@ -1629,10 +2445,32 @@ static void async_handler_work(uv_work_t *work)
 {
     uv_async_work_t *async = (uv_async_work_t *)work;
     
+    /* Every stage and leg charges the one account the request started
+     * with (zeroed at allocation, folded into the totals by async_finish) */
+    buckets_account_t *prev_account = NULL;
+    if (buckets_account_enabled()) {
+        prev_account = buckets_account_attach(&async->account);
+    }
+    
+    /* Decode and response buffers the handler charges are held until the
+     * response has been written (released by uv_http_conn_reset) */
+    buckets_mem_budget_scope_begin();
+    
+    buckets_io_class_t io_class = buckets_io_class_set(
+        async->lane_item.bulk ? BUCKETS_IO_CLASS_BULK : BUCKETS_IO_CLASS_DEFAULT);
+    
     /* Call the actual handler in the worker thread.
      * The handler will call uv_http_response_* which will buffer the response
      * since conn->async_work is set. */
-    if (async->route) {
+    if (async->next_stage) {
+        /* Next stage of a resumable handler; it may name another */
+        uv_http_stage_t stage = async->next_stage;
+        void *ctx = async->stage_ctx;
+        async->next_stage = NULL;
+        async->stage_ctx = NULL;
+        uv_metrics_stage_run();
+        stage(async->conn, ctx);
+    } else if (async->route) {
         /* Use route handler */
         async->route->handler.legacy(async->conn, async->route->user_data);
     } else {
@@ -1641,6 +2479,357 @@ static void async_handler_work(uv_work_t *work)
     }
     
     /* Note: response_ready is set by uv_http_response_end, not here */
+    
+    buckets_io_class_set(io_class);
+    async->budget_charged += buckets_mem_budget_scope_end();
+    
+    if (buckets_account_enabled()) {
+        buckets_account_attach(prev_account);
+    }
+}
+
+/* ===================================================================
+ * Priority Lanes
+ * ===================================================================*/
+
+/**
+ * Submit a stage or leg to the pool, or queue it behind the bulk cap.
+ * Event loop thread only.
+ */
+static int lane_queue_work(uv_http_server_t *server, uv_lane_item_t *item)
+{
+    if (item->bulk && server->bulk_limit > 0 && server->bulk_running >= server->bulk_limit) {
+        item->next = NULL;
+        if (server->bulk_wait_tail) {
+            server->bulk_wait_tail->next = item;
+        } else {
+            server->bulk_wait_head = item;
+        }
+        server->bulk_wait_tail = item;
+        uv_metrics_lane_bulk_waiting(1);
+        return 0;
+    }
+    
+    if (item->bulk) {
+        server->bulk_running++;
+    }
+    int ret = uv_queue_work(server->loop, item->work, item->work_cb, item->after_work_cb);
+    if (ret != 0 && item->bulk) {
+        server->bulk_running--;
+    }
+    return ret;
+}
+
+/**
+ * A stage or leg finished: give back its bulk slot and start waiting bulk
+ * work it makes room for. Event loop thread only.
+ */
+static void lane_done(uv_http_server_t *server, uv_lane_item_t *item)
+{
+    if (!item->bulk) {
+        return;
+    }
+    item->bulk = false;
+    server->bulk_running--;
+    
+    while (server->bulk_wait_head &&
+           (server->bulk_limit == 0 || server->bulk_running < server->bulk_limit)) {
+        uv_lane_item_t *next = server->bulk_wait_head;
+        server->bulk_wait_head = next->next;
+        if (!server->bulk_wait_head) {
+            server->bulk_wait_tail = NULL;
+        }
+        next->next = NULL;
+        uv_metrics_lane_bulk_waiting(-1);
+        
+        server->bulk_running++;
+        int ret = uv_queue_work(server->loop, next->work, next->work_cb, next->after_work_cb);
+        if (ret != 0) {
+            buckets_error("Failed to queue bulk work: %s", uv_strerror(ret));
+            server->bulk_running--;
+            next->bulk = false;
+            next->after_work_cb(next->work, ret);
+        }
+    }
+}
+
+static void lane_item_init(uv_lane_item_t *item, uv_work_t *work, uv_work_cb work_cb,
+                           uv_after_work_cb after_work_cb, uv_http_conn_t *conn)
+{
+    item->work = work;
+    item->work_cb = work_cb;
+    item->after_work_cb = after_work_cb;
+    item->bulk = conn->lane == UV_HTTP_LANE_BULK;
+    item->next = NULL;
+}
+
+/* Span of a single "bytes=first-last" range (0: open-ended or not one range) */
+static uint64_t range_span(const char *range)
+{
+    if (!range || strncmp(range, "bytes=", 6) != 0 || strchr(range, ',')) {
+        return 0;
+    }
+    char *end = NULL;
+    const char *p = range + 6;
+    if (!isdigit((unsigned char)*p)) {
+        /* Suffix range "bytes=-N": the last N bytes */
+        return *p == '-' ? strtoull(p + 1, NULL, 10) : 0;
+    }
+    uint64_t first = strtoull(p, &end, 10);
+    if (*end != '-' || !isdigit((unsigned char)end[1])) {
+        return 0;
+    }
+    uint64_t last = strtoull(end + 1, NULL, 10);
+    return last >= first ? last - first + 1 : 0;
+}
+
+/**
+ * Pick the request's lane from its headers (event loop thread)
+ */
+static void conn_classify_lane(uv_http_conn_t *conn)
+{
+    uv_http_server_t *server = conn->server;
+    bool bulk = false;
+    
+    if (server->bulk_limit == 0) {
+        return;
+    }
+    
+    if (conn->content_length >= server->bulk_min_bytes ||
+        (conn->parser.flags & F_CHUNKED)) {
+        /* Large or unsized upload */
+        bulk = true;
+    } else if (conn->parser.method == HTTP_PUT &&
+               uv_http_get_header(conn, "x-amz-copy-source")) {
+        /* Server-side copy moves the whole source object */
+        bulk = true;
+    } else if (conn->parser.method == HTTP_GET &&
+               range_span(uv_http_get_header(conn, "Range")) >= server->bulk_min_bytes) {
+        bulk = true;
+    }
+    
+    if (bulk) {
+        conn->lane = UV_HTTP_LANE_BULK;
+        uv_metrics_lane_bulk_request();
+    }
+}
+
+void uv_http_async_set_lane(uv_http_conn_t *conn, uv_http_lane_t lane)
+{
+    if (!conn || conn->lane == lane || conn->server->bulk_limit == 0) {
+        return;
+    }
+    conn->lane = lane;
+    if (lane == UV_HTTP_LANE_BULK) {
+        uv_metrics_lane_bulk_request();
+    }
+    
+    /* The rest of the calling stage's disk I/O too */
+    if (conn->async_work) {
+        buckets_io_class_set(lane == UV_HTTP_LANE_BULK ? BUCKETS_IO_CLASS_BULK
+                                                       : BUCKETS_IO_CLASS_DEFAULT);
+    }
+}
+
+bool uv_http_is_bulk_size(uv_http_conn_t *conn, uint64_t bytes)
+{
+    return conn && conn->server->bulk_limit > 0 && bytes >= conn->server->bulk_min_bytes;
+}
+
+/* ===================================================================
+ * Resumable Async Handlers
+ * ===================================================================*/
+
+/**
+ * Drop one pending unit (stage, leg or suspension); the last one moves the
+ * request on. Event loop thread only.
+ */
+static void async_release(uv_async_work_t *async)
+{
+    if (__atomic_sub_fetch(&async->pending, 1, __ATOMIC_ACQ_REL) > 0) {
+        if (!async->parked) {
+            async->parked = true;
+            uv_metrics_stage_parked(1);
+        }
+        return;
+    }
+    
+    if (async->parked) {
+        async->parked = false;
+        uv_metrics_stage_parked(-1);
+    }
+    
+    if (!async->next_stage) {
+        async_finish(async);
+        return;
+    }
+    
+    /* Stages still run after a disconnect so they can release their
+     * state, but they are told not to start any more I/O */
+    uv_http_conn_t *conn = async->conn;
+    async->cancelled = conn->state == CONN_STATE_CLOSING ||
+                       uv_is_closing((uv_handle_t*)&conn->tcp);
+    async->pending = 1;
+    
+    lane_item_init(&async->lane_item, &async->work, async_handler_work,
+                   async_handler_after_work, conn);
+    int ret = lane_queue_work(conn->server, &async->lane_item);
+    if (ret != 0) {
+        buckets_error("Failed to queue handler stage: %s", uv_strerror(ret));
+        async->next_stage = NULL;
+        async_finish(async);
+    }
+}
+
+static void async_leg_work(uv_work_t *work)
+{
+    uv_async_leg_t *leg = (uv_async_leg_t *)work;
+    
+    buckets_account_t *prev_account = NULL;
+    if (buckets_account_enabled()) {
+        prev_account = buckets_account_attach(&leg->async->account);
+    }
+    buckets_mem_budget_scope_begin();
+    buckets_io_class_t io_class = buckets_io_class_set(
+        leg->lane_item.bulk ? BUCKETS_IO_CLASS_BULK : BUCKETS_IO_CLASS_DEFAULT);
+    leg->fn(leg->ctx);
+    buckets_io_class_set(io_class);
+    __atomic_add_fetch(&leg->async->budget_charged, buckets_mem_budget_scope_end(),
+                       __ATOMIC_RELAXED);
+    if (buckets_account_enabled()) {
+        buckets_account_attach(prev_account);
+    }
+}
+
+static void async_leg_after_work(uv_work_t *work, int status)
+{
+    uv_async_leg_t *leg = (uv_async_leg_t *)work;
+    uv_async_work_t *async = leg->async;
+    
+    (void)status;
+    
+    lane_done(async->conn->server, &leg->lane_item);
+    buckets_free(leg);
+    async_release(async);
+}
+
+/**
+ * Resume queued suspended handlers (event loop thread)
+ */
+static void on_resume_async(uv_async_t *handle)
+{
+    uv_http_server_t *server = (uv_http_server_t*)handle->data;
+    
+    pthread_mutex_lock(&server->resume_lock);
+    uv_async_work_t *async = server->resume_head;
+    server->resume_head = NULL;
+    pthread_mutex_unlock(&server->resume_lock);
+    
+    while (async) {
+        uv_async_work_t *next = async->resume_next;
+        async->resume_next = NULL;
+        async_release(async);
+        async = next;
+    }
+}
+
+int uv_http_async_start(uv_http_conn_t *conn, uv_http_stage_t stage, void *ctx)
+{
+    if (!conn || !stage || conn->async_work) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    uv_async_work_t *async = buckets_calloc(1, sizeof(uv_async_work_t));
+    if (!async) {
+        return BUCKETS_ERR_NOMEM;
+    }
+    
+    async->conn = conn;
+    async->next_stage = stage;
+    async->stage_ctx = ctx;
+    async->pending = 1;
+    async->queued_time_us = uv_metrics_now_us();
+    
+    /* Link async to connection so response functions can buffer */
+    conn->async_work = async;
+    conn->state = CONN_STATE_PROCESSING;
+    
+    uv_metrics_async_start();
+    
+    lane_item_init(&async->lane_item, &async->work, async_handler_work,
+                   async_handler_after_work, conn);
+    int ret = lane_queue_work(conn->server, &async->lane_item);
+    if (ret != 0) {
+        buckets_error("Failed to queue resumable handler: %s", uv_strerror(ret));
+        uv_metrics_async_end(0);
+        conn->async_work = NULL;
+        buckets_free(async);
+        return BUCKETS_ERR_IO;
+    }
+    
+    return BUCKETS_OK;
+}
+
+void uv_http_async_then(uv_http_conn_t *conn, uv_http_stage_t next, void *ctx)
+{
+    uv_async_work_t *async = conn->async_work;
+    if (!async) {
+        buckets_error("uv_http_async_then called outside an async handler");
+        return;
+    }
+    async->next_stage = next;
+    async->stage_ctx = ctx;
+}
+
+int uv_http_async_fork(uv_http_conn_t *conn, uv_http_leg_t leg_fn, void *leg_ctx)
+{
+    uv_async_work_t *async = conn->async_work;
+    if (!async || !leg_fn) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    uv_async_leg_t *leg = buckets_calloc(1, sizeof(uv_async_leg_t));
+    if (!leg) {
+        return BUCKETS_ERR_NOMEM;
+    }
+    leg->async = async;
+    leg->fn = leg_fn;
+    leg->ctx = leg_ctx;
+    leg->next = async->legs;
+    async->legs = leg;
+    
+    __atomic_add_fetch(&async->pending, 1, __ATOMIC_ACQ_REL);
+    return BUCKETS_OK;
+}
+
+uv_async_work_t* uv_http_async_suspend(uv_http_conn_t *conn)
+{
+    uv_async_work_t *async = conn->async_work;
+    if (!async) {
+        return NULL;
+    }
+    __atomic_add_fetch(&async->pending, 1, __ATOMIC_ACQ_REL);
+    return async;
+}
+
+void uv_http_async_resume(uv_async_work_t *handle)
+{
+    if (!handle) {
+        return;
+    }
+    uv_http_server_t *server = handle->conn->server;
+    
+    pthread_mutex_lock(&server->resume_lock);
+    handle->resume_next = server->resume_head;
+    server->resume_head = handle;
+    pthread_mutex_unlock(&server->resume_lock);
+    
+    uv_async_send(&server->resume_async);
+}
+
+bool uv_http_async_cancelled(uv_http_conn_t *conn)
+{
+    return conn->async_work && conn->async_work->cancelled;
 }
 
 /**
@@ -1713,7 +2902,6 @@ static void send_buffered_response(uv_http_conn_t *conn, uv_async_work_t *async,
     conn->pending_final_write = true;
     
     /* Write response (now safe - we're on event loop thread) */
-    uv_buf_t buf = uv_buf_init(write_buf, total_len);
     uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
     if (!req) {
         buckets_free(write_buf);
@@ -1766,7 +2954,7 @@ static void send_buffered_response(uv_http_conn_t *conn, uv_async_work_t *async,
     }
     pthread_mutex_unlock(&conn->write_lock);
     
-    int ret = uv_write(req, stream, &buf, 1, on_write_complete);
+    int ret = conn_write(conn, req, write_buf, total_len);
     if (ret != 0) {
         /* Decrement on failure since write callback won't be called */
         pthread_mutex_lock(&conn->write_lock);
@@ -1783,22 +2971,73 @@ static void send_buffered_response(uv_http_conn_t *conn, uv_async_work_t *async,
 
 /**
  * After-work callback for async handlers.
- * Runs in the event loop thread after worker completes.
- * This is where we actually send the buffered response (safe to use uv_write here).
+ * Runs in the event loop thread after a stage completes. Queues the legs
+ * the stage forked; the response goes out once nothing is left pending.
  */
 static void async_handler_after_work(uv_work_t *work, int status)
 {
     uv_async_work_t *async = (uv_async_work_t *)work;
-    uv_http_conn_t *conn = async->conn;
     
     (void)status;  /* Ignore cancel status for now */
     
+    lane_done(async->conn->server, &async->lane_item);
+    
+    uv_async_leg_t *leg = async->legs;
+    async->legs = NULL;
+    while (leg) {
+        uv_async_leg_t *next = leg->next;
+        uv_metrics_stage_leg();
+        lane_item_init(&leg->lane_item, &leg->work, async_leg_work,
+                       async_leg_after_work, async->conn);
+        int ret = lane_queue_work(async->conn->server, &leg->lane_item);
+        if (ret != 0) {
+            buckets_error("Failed to queue handler leg: %s", uv_strerror(ret));
+            buckets_free(leg);
+            __atomic_sub_fetch(&async->pending, 1, __ATOMIC_ACQ_REL);
+        }
+        leg = next;
+    }
+    
+    async_release(async);
+}
+
+static void async_work_free(uv_async_work_t *async)
+{
+    for (int i = 0; i < async->num_headers && async->response_headers[i]; i++) {
+        buckets_free(async->response_headers[i]);
+    }
+    if (async->response_body) {
+        buckets_free(async->response_body);
+    }
+    buckets_free(async);
+}
+
+/**
+ * Send the response of a finished async handler.
+ * Runs in the event loop thread once no stage or leg is pending.
+ * This is where we actually send the buffered response (safe to use uv_write here).
+ */
+static void async_finish(uv_async_work_t *async)
+{
+    uv_http_conn_t *conn = async->conn;
+    
     /* Track async work completion */
     if (async->queued_time_us > 0) {
         uint64_t wait_time_us = uv_metrics_now_us() - async->queued_time_us;
         uv_metrics_async_end(wait_time_us);
     }
     
+    if (buckets_account_enabled()) {
+        /* Once per request, however many stages and legs it took */
+        buckets_account_end(&async->account);
+        uv_metrics_request_cost(&async->account);
+        buckets_debug("[ACCOUNT] %s %s: syscalls=%lu allocs=%lu alloc_bytes=%lu",
+                      llhttp_method_name((llhttp_method_t)conn->parser.method),
+                      conn->url ? conn->url : "",
+                      buckets_account_syscall_total(&async->account),
+                      async->account.allocs, async->account.alloc_bytes);
+    }
+    
     /* CRITICAL: Check if connection is still alive BEFORE doing anything.
      * The connection could have timed out or been closed while we were in the thread pool.
      * If connection is closing, just cleanup and return.
@@ -1816,17 +3055,17 @@ static void async_handler_after_work(uv_work_t *work, int status)
                      conn, conn->state);
         /* Clear async_work pointer */
         conn->async_work = NULL;
+        buckets_mem_budget_release(async->budget_charged);
         /* Free async work structure and its buffers */
-        for (int i = 0; i < async->num_headers && async->response_headers[i]; i++) {
-            buckets_free(async->response_headers[i]);
-        }
-        if (async->response_body) {
-            buckets_free(async->response_body);
+        async_work_free(async);
+        if (conn->free_deferred) {
+            conn_destroy(conn);
         }
-        buckets_free(async);
         return;
     }
     
+    conn->budget_reserved += async->budget_charged;
+    
     /* Connection is still alive - increment pending_writes to prevent close during send.
      * We hold the lock from the state check through the response queueing to ensure
      * atomicity. The lock will be released by send_buffered_response after incrementing
@@ -1856,13 +3095,7 @@ static void async_handler_after_work(uv_work_t *work, int status)
     }
     
     /* Free async work structure and its buffers */
-    for (int i = 0; i < async->num_headers && async->response_headers[i]; i++) {
-        buckets_free(async->response_headers[i]);
-    }
-    if (async->response_body) {
-        buckets_free(async->response_body);
-    }
-    buckets_free(async);
+    async_work_free(async);
 }
 
 /**
@@ -1879,6 +3112,7 @@ static int queue_async_handler(uv_http_conn_t *conn, uv_route_t *route)
     async->route = route;
     async->response_ready = false;
     async->response_started = false;
+    async->pending = 1;
     async->queued_time_us = uv_metrics_now_us();
     
     /* Link async to connection so response functions can buffer */
@@ -1891,8 +3125,9 @@ static int queue_async_handler(uv_http_conn_t *conn, uv_route_t *route)
     uv_metrics_async_start();
     
     /* Queue work to libuv thread pool */
-    int ret = uv_queue_work(conn->server->loop, &async->work,
-                            async_handler_work, async_handler_after_work);
+    lane_item_init(&async->lane_item, &async->work, async_handler_work,
+                   async_handler_after_work, conn);
+    int ret = lane_queue_work(conn->server, &async->lane_item);
     
     if (ret != 0) {
         buckets_error("Failed to queue async work: %s", uv_strerror(ret));
@@ -1923,6 +3158,7 @@ static int queue_async_default_handler(uv_http_conn_t *conn,
     async->handler_data = user_data;
     async->response_ready = false;
     async->response_started = false;
+    async->pending = 1;
     async->queued_time_us = uv_metrics_now_us();
     
     /* Link async to connection so response functions can buffer */
@@ -1935,8 +3171,9 @@ static int queue_async_default_handler(uv_http_conn_t *conn,
     uv_metrics_async_start();
     
     /* Queue work to libuv thread pool */
-    int ret = uv_queue_work(conn->server->loop, &async->work,
-                            async_handler_work, async_handler_after_work);
+    lane_item_init(&async->lane_item, &async->work, async_handler_work,
+                   async_handler_after_work, conn);
+    int ret = lane_queue_work(conn->server, &async->lane_item);
     
     if (ret != 0) {
         buckets_error("Failed to queue async default handler: %s", uv_strerror(ret));
@@ -1960,11 +3197,36 @@ static void process_request(uv_http_conn_t *conn)
     conn->request_start_time_us = uv_metrics_now_us();
     uv_metrics_request_start();
     
+    /* A streaming handler handed the request to a resumable handler */
+    if (conn->async_work) {
+        return;
+    }
+    
     /* If response already started (e.g., from streaming handler), skip to done */
     if (conn->response_started) {
         goto done;
     }
     
+    if (conn->peer_route_denied) {
+        buckets_warn("Refused internal request %s without a cluster certificate", conn->url);
+        conn->keep_alive = false;
+        uv_http_response_start(conn, 403, NULL, 0, 0);
+        uv_http_response_end(conn);
+        goto done;
+    }
+    
+    if (conn->qos_refused) {
+        const char *body = server->qos.refusal_body;
+        size_t body_len = body ? strlen(body) : 0;
+        const char *headers[] = { "Content-Type", server->qos.refusal_content_type };
+        int num_headers = (body_len > 0 && headers[1]) ? 2 : 0;
+        
+        uv_http_response_start(conn, conn->qos_refused, headers, num_headers, body_len);
+        uv_http_response_write(conn, body, body_len);
+        uv_http_response_end(conn);
+        goto done;
+    }
+    
     /* Parse query string from URL */
     char *query = strchr(conn->url, '?');
     char *path = conn->url;
@@ -2087,6 +3349,12 @@ int uv_http_response_start(uv_http_conn_t *conn, int status,
         async->content_length = content_length;
         async->response_started = true;
         
+        /* Body is buffered here, then copied into one write buffer with the
+         * headers; HEAD reports a length but sends no body */
+        if (llhttp_get_method(&conn->parser) != HTTP_HEAD) {
+            buckets_mem_budget_charge((u64)content_length * 2);
+        }
+        
         /* Copy headers */
         async->num_headers = 0;
         for (int i = 0; i < num_headers && headers && headers[i] && async->num_headers < 62; i += 2) {
@@ -2146,7 +3414,6 @@ int uv_http_response_start(uv_http_conn_t *conn, int status,
     if (!write_buf) return BUCKETS_ERR_NOMEM;
     memcpy(write_buf, header_buf, offset);
     
-    uv_buf_t buf = uv_buf_init(write_buf, offset);
     uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
     if (!req) {
         buckets_free(write_buf);
@@ -2156,7 +3423,12 @@ int uv_http_response_start(uv_http_conn_t *conn, int status,
     
     conn->response_started = true;
     
-    return uv_write(req, (uv_stream_t*)&conn->tcp, &buf, 1, on_write_complete);
+    int ret = conn_write(conn, req, write_buf, offset);
+    if (ret != 0) {
+        buckets_free(write_buf);
+        buckets_free(req);
+    }
+    return ret;
 }
 
 int uv_http_response_write(uv_http_conn_t *conn, const void *data, size_t len)
@@ -2215,24 +3487,6 @@ int uv_http_response_write(uv_http_conn_t *conn, const void *data, size_t len)
         write_len = len;
     }
     
-    /* Handle TLS */
-    if (conn->ssl && conn->tls_handshake_complete) {
-        int n = SSL_write(conn->ssl, write_buf, write_len);
-        buckets_free(write_buf);
-        
-        if (n <= 0) {
-            int err = SSL_get_error(conn->ssl, n);
-            if (err != SSL_ERROR_WANT_WRITE) {
-                return BUCKETS_ERR_IO;
-            }
-        }
-        
-        /* Flush write BIO to TCP */
-        return tls_flush_write_bio(conn);
-    }
-    
-    /* Plain TCP write */
-    uv_buf_t buf = uv_buf_init(write_buf, write_len);
     uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
     if (!req) {
         buckets_free(write_buf);
@@ -2240,7 +3494,7 @@ int uv_http_response_write(uv_http_conn_t *conn, const void *data, size_t len)
     }
     req->data = write_buf;
     
-    int ret = uv_write(req, (uv_stream_t*)&conn->tcp, &buf, 1, on_write_complete);
+    int ret = conn_write(conn, req, write_buf, write_len);
     if (ret != 0) {
         buckets_free(write_buf);
         buckets_free(req);
@@ -2273,9 +3527,6 @@ int uv_http_response_end(uv_http_conn_t *conn)
         if (!write_buf) return BUCKETS_ERR_NOMEM;
         memcpy(write_buf, terminator, terminator_len);
         
-        /* For TLS, the write goes through SSL layer in uv_http_response_write
-         * But since that checks for len==0, we need to write directly here. */
-        uv_buf_t buf = uv_buf_init(write_buf, terminator_len);
         uv_write_t *req = buckets_malloc(sizeof(uv_write_t));
         if (!req) {
             buckets_free(write_buf);
@@ -2283,11 +3534,70 @@ int uv_http_response_end(uv_http_conn_t *conn)
         }
         req->data = write_buf;
         
-        return uv_write(req, (uv_stream_t*)&conn->tcp, &buf, 1, on_write_complete);
+        int ret = conn_write(conn, req, write_buf, terminator_len);
+        if (ret != 0) {
+            buckets_free(write_buf);
+            buckets_free(req);
+        }
+        return ret;
     }
     return BUCKETS_OK;
 }
 
+/**
+ * Queue a write on the connection with on_write_complete as callback.
+ *
+ * Ownership follows uv_write: on success on_write_complete frees req and
+ * req->data; on failure both stay with the caller. Where user-space TLS
+ * still encrypts, the data is turned into records first and req->data
+ * is swapped for the ciphertext.
+ */
+static int conn_write(uv_http_conn_t *conn, uv_write_t *req, char *data, size_t len)
+{
+    uv_stream_t *stream = (uv_stream_t*)&conn->tcp;
+    
+    conn_qos_charge(conn, len, false);
+    
+    if (!conn_tls_encrypts(conn)) {
+        uv_buf_t buf = uv_buf_init(data, len);
+        return uv_write(req, stream, &buf, 1, on_write_complete);
+    }
+    
+    if (!conn->tls_handshake_complete || !conn->write_bio) {
+        return UV_EPROTO;
+    }
+    
+    size_t written = 0;
+    if (len > 0 && (SSL_write_ex(conn->ssl, data, len, &written) != 1 || written != len)) {
+        return UV_EPROTO;
+    }
+    
+    size_t cipher_len = BIO_ctrl_pending(conn->write_bio);
+    char *cipher = buckets_malloc(cipher_len > 0 ? cipher_len : 1);
+    if (!cipher) {
+        return UV_ENOMEM;
+    }
+    if (cipher_len > 0 && BIO_read(conn->write_bio, cipher, (int)cipher_len) != (int)cipher_len) {
+        buckets_free(cipher);
+        return UV_EPROTO;
+    }
+    
+    void *plain = req->data;
+    req->data = cipher;
+    uv_buf_t buf = uv_buf_init(cipher, cipher_len);
+    int ret = uv_write(req, stream, &buf, 1, on_write_complete);
+    if (ret != 0) {
+        req->data = plain;
+        buckets_free(cipher);
+        return ret;
+    }
+    
+    if (plain) {
+        buckets_free(plain);
+    }
+    return 0;
+}
+
 /**
  * Safe wrapper for uv_write that validates stream type.
  * Takes ownership of write_buf (will free on error).
@@ -2408,6 +3718,7 @@ static void on_write_complete(uv_write_t *req, int status)
             uv_http_conn_reset(conn);
             conn->state = CONN_STATE_KEEPALIVE_WAIT;
             uv_http_conn_reset_timeout(conn, conn->server->keepalive_timeout_ms);
+            conn_qos_pace(conn);
         } else {
             uv_http_conn_close(conn);
         }
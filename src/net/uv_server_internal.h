@@ -16,6 +16,7 @@
 #include <pthread.h>
 
 #include "../../third_party/llhttp/include/llhttp.h"
+#include "buckets.h"
 
 /* ===================================================================
  * Configuration Constants
@@ -36,6 +37,9 @@
 #define BUCKETS_MAX_HEADERS_SIZE             65536   /* 64KB max headers */
 #define BUCKETS_INITIAL_BODY_BUFFER          262144  /* 256KB initial body buffer */
 
+/* Priority lanes */
+#define BUCKETS_DEFAULT_BULK_MIN_BYTES       (1024 * 1024)  /* Smallest bulk transfer */
+
 /* ===================================================================
  * Forward Declarations
  * ===================================================================*/
@@ -70,6 +74,33 @@ typedef enum {
     CONN_STATE_CLOSING
 } uv_conn_state_t;
 
+/* ===================================================================
+ * Priority Lanes
+ *
+ * Requests are classified when their headers arrive: uploads at or above
+ * the bulk size (or chunked with no length), large ranged reads and
+ * server-side copies go to the bulk lane, everything else is interactive.
+ * A handler that only learns the size later (a GET once xl.meta is read)
+ * moves its request with uv_http_async_set_lane. Bulk stages and legs may
+ * only hold part of the thread pool at once; the rest is kept for
+ * interactive requests, and bulk work over the cap waits in FIFO order.
+ * Bulk work also runs with the BULK disk I/O class.
+ * ===================================================================*/
+
+typedef enum {
+    UV_HTTP_LANE_INTERACTIVE,
+    UV_HTTP_LANE_BULK
+} uv_http_lane_t;
+
+/* Pool submission that may have to wait for a bulk slot */
+typedef struct uv_lane_item {
+    uv_work_t *work;
+    uv_work_cb work_cb;
+    uv_after_work_cb after_work_cb;
+    bool bulk;                     /* Holds (or waits for) a bulk slot */
+    struct uv_lane_item *next;     /* Bulk wait queue link */
+} uv_lane_item_t;
+
 /* ===================================================================
  * HTTP Connection
  * ===================================================================*/
@@ -89,9 +120,17 @@ struct uv_http_conn {
     
     /* TLS state */
     SSL *ssl;
-    BIO *read_bio;
-    BIO *write_bio;
+    BIO *read_bio;                 /* Memory BIOs once the handshake is done; */
+    BIO *write_bio;                /* NULL for a direction the kernel handles */
     bool tls_handshake_complete;
+    bool tls_handshaking;          /* Handshake step running on the thread pool */
+    int tls_handshake_err;         /* SSL_get_error() of that step */
+    bool ktls_tx;                  /* Kernel encrypts: plain writes and sendfile work */
+    bool ktls_rx;                  /* Kernel decrypts: reads return plaintext */
+    uv_poll_t *tls_poll;           /* Socket readiness while handshaking */
+    uv_work_t tls_work;
+    bool tls_peer_verified;        /* Client cert signed by the cluster CA */
+    bool peer_route_denied;        /* Internal route without a peer cert */
     
     /* HTTP parser */
     llhttp_t parser;
@@ -150,6 +189,7 @@ struct uv_http_conn {
     
     /* Close synchronization - count of handles pending close */
     int pending_close_count;
+    bool free_deferred;            /* Handles closed while async work held the conn */
     
     /* Write tracking - prevents use-after-free race conditions */
     int pending_writes;            /* Number of writes in flight */
@@ -157,6 +197,22 @@ struct uv_http_conn {
     
     /* Performance metrics */
     uint64_t request_start_time_us; /* Timestamp when request processing started */
+    
+    /* Memory budget (see buckets_mem_budget.h) */
+    uint64_t budget_reserved;      /* Bytes held for the current request */
+    uint64_t budget_wanted;        /* Bytes awaited while reading is paused */
+    bool budget_paused;            /* Queued on server->budget_wait_head */
+    uv_http_conn_t *budget_next;   /* Budget wait queue link */
+    
+    /* Tenant QoS (see uv_http_qos_t) */
+    void *qos_tenant;              /* Charged for this request's bytes */
+    int qos_refused;               /* Status to refuse the request with */
+    uint64_t qos_pause_us;         /* Owed before reading again */
+    bool qos_paused;               /* Reads stopped until qos_timer fires */
+    uv_timer_t *qos_timer;
+    
+    /* Priority lane of the current request */
+    uv_http_lane_t lane;
 };
 
 /* ===================================================================
@@ -213,9 +269,55 @@ typedef struct {
     void *user_data;
 } uv_stream_handler_t;
 
+/**
+ * Per-tenant admission and pacing (see uv_http_server_set_qos)
+ *
+ * Internal peer routes are exempt.
+ */
+typedef struct {
+    /**
+     * Called when request headers are complete.
+     * Return 0 to admit the request, setting *tenant to what its bytes are
+     * charged to; otherwise the HTTP status to refuse it with once its body
+     * has been read and dropped.
+     */
+    int (*admit)(uv_http_conn_t *conn, void **tenant);
+    
+    /**
+     * Called as request body and response bytes move.
+     * Returns microseconds to stop reading from the connection for.
+     */
+    uint64_t (*charge)(void *tenant, size_t bytes, bool inbound);
+    
+    /**
+     * Called once the request is done with a tenant (optional).
+     */
+    void (*release)(void *tenant);
+    
+    /* Body sent with refusals (static, may be NULL) */
+    const char *refusal_body;
+    const char *refusal_content_type;
+} uv_http_qos_t;
+
 /* Legacy (non-streaming) handler - buffers entire body */
 typedef void (*uv_http_handler_t)(uv_http_conn_t *conn, void *user_data);
 
+/**
+ * One stage of a resumable async handler (see uv_http_async_then)
+ *
+ * Runs on a thread-pool thread like any async handler and may block on
+ * disk or peer I/O for the duration of the stage.
+ */
+typedef void (*uv_http_stage_t)(uv_http_conn_t *conn, void *ctx);
+
+/**
+ * One leg of a stage's fan-out (see uv_http_async_fork)
+ *
+ * Runs on a thread-pool thread concurrently with the stage's other legs.
+ * Legs must not touch the connection or the response.
+ */
+typedef void (*uv_http_leg_t)(void *leg_ctx);
+
 /* ===================================================================
  * Route Entry
  * ===================================================================*/
@@ -237,6 +339,8 @@ struct uv_route {
  * Async Handler Work Structure
  * ===================================================================*/
 
+typedef struct uv_async_leg uv_async_leg_t;
+
 typedef struct uv_async_work {
     uv_work_t work;                /* Must be first for casting */
     uv_http_conn_t *conn;
@@ -259,6 +363,19 @@ typedef struct uv_async_work {
     
     /* Performance metrics */
     uint64_t queued_time_us;       /* When this work was queued to thread pool */
+    buckets_account_t account;     /* Syscalls/allocs charged to this request */
+    uint64_t budget_charged;       /* Memory budget charged by the handler */
+    
+    /* Resumable handlers: what runs once the current stage's legs and
+     * suspension have completed (NULL = the response is final) */
+    uv_http_stage_t next_stage;
+    void *stage_ctx;
+    uv_async_leg_t *legs;          /* Forked by the running stage, not yet queued */
+    int pending;                   /* Running stage + legs + suspension (atomic) */
+    bool cancelled;                /* Connection closed before the next stage */
+    bool parked;                   /* Waiting with no stage running (loop thread) */
+    struct uv_async_work *resume_next;  /* Server resume queue link */
+    uv_lane_item_t lane_item;      /* Current stage's pool submission */
 } uv_async_work_t;
 
 /* ===================================================================
@@ -287,6 +404,17 @@ struct uv_http_server {
     SSL_CTX *ssl_ctx;
     char cert_file[512];
     char key_file[512];
+    char peer_ca_file[512];        /* Internal routes require a cert from this CA */
+    
+    /* Tenant QoS (admit == NULL: off) */
+    uv_http_qos_t qos;
+    
+    /* Priority lanes (bulk_limit == 0: off; counters are loop thread) */
+    int bulk_limit;                /* Pool threads bulk work may hold */
+    uint64_t bulk_min_bytes;       /* Smallest transfer classed as bulk */
+    int bulk_running;
+    uv_lane_item_t *bulk_wait_head;
+    uv_lane_item_t *bulk_wait_tail;
     
     /* Routing */
     uv_route_t *routes;
@@ -299,6 +427,17 @@ struct uv_http_server {
     int connection_count;
     int max_connections;
     
+    /* Connections paused until the memory budget frees (FIFO, loop thread) */
+    uv_async_t budget_async;
+    uv_http_conn_t *budget_wait_head;
+    uv_http_conn_t *budget_wait_tail;
+    int budget_waiting;            /* Queue length (read by release hook) */
+    
+    /* Suspended async handlers resumed from other threads */
+    uv_async_t resume_async;
+    pthread_mutex_t resume_lock;
+    uv_async_work_t *resume_head;
+    
     /* Server state */
     pthread_t thread;
     bool running;
@@ -338,8 +477,54 @@ int uv_http_server_add_async_route(uv_http_server_t *server,
 int uv_http_server_set_async_handler(uv_http_server_t *server,
                                       uv_http_handler_t handler,
                                       void *user_data);
+
+/* Admit and pace requests per tenant; hooks are copied */
+int uv_http_server_set_qos(uv_http_server_t *server, const uv_http_qos_t *qos);
+
+/* Cap bulk-lane pool threads (0: no lanes) and set the bulk size */
+int uv_http_server_set_lanes(uv_http_server_t *server, int bulk_threads,
+                              uint64_t bulk_min_bytes);
 int uv_http_server_start(uv_http_server_t *server);
 int uv_http_server_stop(uv_http_server_t *server);
+
+/* ===================================================================
+ * Resumable Async Handlers
+ *
+ * An async handler normally holds its pool thread until the response is
+ * complete. A resumable handler is instead a chain of stages: before a
+ * stage returns it names the next one with uv_http_async_then, optionally
+ * after forking parallel legs or suspending until another thread calls
+ * uv_http_async_resume. The event loop queues the next stage only once
+ * every leg has finished and the suspension has been resumed, so a
+ * request waiting on I/O holds no thread at all; the pool only has to
+ * cover the stages and legs actually running.
+ *
+ * All of these may only be called from the request's current stage,
+ * except uv_http_async_start (event loop) and uv_http_async_resume (any
+ * thread).
+ * ===================================================================*/
+
+/* Start a resumable handler for a request (event loop thread) */
+int uv_http_async_start(uv_http_conn_t *conn, uv_http_stage_t stage, void *ctx);
+
+/* Run `next` on the pool once the current stage's legs and suspension end */
+void uv_http_async_then(uv_http_conn_t *conn, uv_http_stage_t next, void *ctx);
+
+/* Run `leg` on the pool after the current stage returns */
+int uv_http_async_fork(uv_http_conn_t *conn, uv_http_leg_t leg, void *leg_ctx);
+
+/* Hold the next stage until uv_http_async_resume(handle) is called */
+uv_async_work_t* uv_http_async_suspend(uv_http_conn_t *conn);
+void uv_http_async_resume(uv_async_work_t *handle);
+
+/* The client went away: the stage should release its state and return */
+bool uv_http_async_cancelled(uv_http_conn_t *conn);
+
+/* Move the request to another lane from its next stage and legs on */
+void uv_http_async_set_lane(uv_http_conn_t *conn, uv_http_lane_t lane);
+
+/* Whether a transfer of this many bytes belongs in the bulk lane */
+bool uv_http_is_bulk_size(uv_http_conn_t *conn, uint64_t bytes);
 void uv_http_server_free(uv_http_server_t *server);
 
 /* ===================================================================
@@ -380,6 +565,11 @@ int uv_http_response_end(uv_http_conn_t *conn);
 
 /* Header access */
 const char* uv_http_get_header(uv_http_conn_t *conn, const char *name);
+int uv_http_get_client_addr(uv_http_conn_t *conn, char *out, size_t out_len);
+
+/* Tenant QoS: swap the tenant a request is charged to */
+void* uv_http_get_qos_tenant(void *conn);
+void uv_http_set_qos_tenant(void *conn, void *tenant);
 
 /* Timeout management */
 void uv_http_conn_reset_timeout(uv_http_conn_t *conn, uint64_t timeout_ms);
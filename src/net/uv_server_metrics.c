@@ -6,6 +6,11 @@
 #include <string.h>
 #include <time.h>
 #include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_async_write.h"
+#include "buckets_mem_budget.h"
+#include "buckets_numa.h"
+#include "storage/async_replication.h"
 #include "uv_server_metrics.h"
 
 /* Global metrics */
@@ -85,6 +90,57 @@ void uv_metrics_async_end(uint64_t wait_time_us) {
     pthread_mutex_unlock(&g_uv_metrics.lock);
 }
 
+void uv_metrics_stage_run(void) {
+    __atomic_add_fetch(&g_uv_metrics.stage_runs, 1, __ATOMIC_RELAXED);
+}
+
+void uv_metrics_stage_leg(void) {
+    __atomic_add_fetch(&g_uv_metrics.stage_legs, 1, __ATOMIC_RELAXED);
+}
+
+void uv_metrics_stage_parked(int delta) {
+    __atomic_add_fetch(&g_uv_metrics.stage_parked, (uint64_t)(int64_t)delta, __ATOMIC_RELAXED);
+}
+
+void uv_metrics_lane_bulk_request(void) {
+    __atomic_add_fetch(&g_uv_metrics.lane_bulk_requests, 1, __ATOMIC_RELAXED);
+}
+
+void uv_metrics_lane_bulk_waiting(int delta) {
+    if (delta > 0) {
+        __atomic_add_fetch(&g_uv_metrics.lane_bulk_deferred, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&g_uv_metrics.lane_bulk_waiting, (uint64_t)(int64_t)delta, __ATOMIC_RELAXED);
+}
+
+void uv_metrics_request_cost(const buckets_account_t *account) {
+    u64 syscalls = buckets_account_syscall_total(account);
+    pthread_mutex_lock(&g_uv_metrics.lock);
+    buckets_account_add(&g_uv_metrics.request_cost_sum, account);
+    g_uv_metrics.request_cost_count++;
+    if (syscalls > g_uv_metrics.request_cost_max_syscalls) {
+        g_uv_metrics.request_cost_max_syscalls = syscalls;
+    }
+    if (account->allocs > g_uv_metrics.request_cost_max_allocs) {
+        g_uv_metrics.request_cost_max_allocs = account->allocs;
+    }
+    pthread_mutex_unlock(&g_uv_metrics.lock);
+}
+
+void uv_metrics_tls_handshake(bool resumed, bool ktls) {
+    __atomic_add_fetch(&g_uv_metrics.tls_handshakes, 1, __ATOMIC_RELAXED);
+    if (resumed) {
+        __atomic_add_fetch(&g_uv_metrics.tls_resumed, 1, __ATOMIC_RELAXED);
+    }
+    if (ktls) {
+        __atomic_add_fetch(&g_uv_metrics.tls_ktls, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void uv_metrics_tls_failure(void) {
+    __atomic_add_fetch(&g_uv_metrics.tls_failures, 1, __ATOMIC_RELAXED);
+}
+
 void uv_metrics_write_lock_wait(uint64_t wait_time_us) {
     pthread_mutex_lock(&g_uv_metrics.lock);
     g_uv_metrics.write_lock_wait_time_sum += wait_time_us;
@@ -145,6 +201,24 @@ void uv_metrics_print(void) {
                  g_uv_metrics.active_requests,
                  g_uv_metrics.async_requests);
     
+    if (g_uv_metrics.stage_runs > 0) {
+        buckets_info("Stages: %lu runs, %lu legs, %lu requests parked without a thread",
+                     g_uv_metrics.stage_runs, g_uv_metrics.stage_legs,
+                     g_uv_metrics.stage_parked);
+    }
+    
+    if (g_uv_metrics.lane_bulk_requests > 0) {
+        buckets_info("Lanes: %lu bulk requests, %lu bulk units deferred, %lu waiting",
+                     g_uv_metrics.lane_bulk_requests, g_uv_metrics.lane_bulk_deferred,
+                     g_uv_metrics.lane_bulk_waiting);
+    }
+    
+    if (g_uv_metrics.tls_handshakes > 0 || g_uv_metrics.tls_failures > 0) {
+        buckets_info("TLS: %lu handshakes, %lu resumed, %lu kTLS, %lu failed",
+                     g_uv_metrics.tls_handshakes, g_uv_metrics.tls_resumed,
+                     g_uv_metrics.tls_ktls, g_uv_metrics.tls_failures);
+    }
+    
     if (g_uv_metrics.request_latency_count > 0) {
         uint64_t avg_latency = g_uv_metrics.request_latency_sum / 
                                 g_uv_metrics.request_latency_count;
@@ -176,6 +250,112 @@ void uv_metrics_print(void) {
                  g_uv_metrics.parse_errors,
                  g_uv_metrics.write_errors);
     
+    if (g_uv_metrics.request_cost_count > 0) {
+        const buckets_account_t *totals = &g_uv_metrics.request_cost_sum;
+        u64 requests = g_uv_metrics.request_cost_count;
+        buckets_info("Per-Request Cost: syscalls=%.1f allocs=%.1f alloc_bytes=%.0f "
+                     "(%lu requests; max syscalls=%lu allocs=%lu)",
+                     (double)buckets_account_syscall_total(totals) / requests,
+                     (double)totals->allocs / requests,
+                     (double)totals->alloc_bytes / requests,
+                     requests, g_uv_metrics.request_cost_max_syscalls,
+                     g_uv_metrics.request_cost_max_allocs);
+        
+        char breakdown[512];
+        int off = 0;
+        for (int i = 0; i < BUCKETS_SYS_COUNT && off < (int)sizeof(breakdown); i++) {
+            if (totals->syscalls[i] > 0) {
+                off += snprintf(breakdown + off, sizeof(breakdown) - off, " %s=%.1f",
+                                buckets_syscall_kind_name((buckets_syscall_kind_t)i),
+                                (double)totals->syscalls[i] / requests);
+            }
+        }
+        buckets_info("Per-Request Syscalls:%s", off > 0 ? breakdown : " none");
+    }
+    
+    buckets_write_quorum_stats_t wq;
+    buckets_write_quorum_get_stats(&wq);
+    if (wq.writes > 0) {
+        buckets_info("Write Quorum: %lu writes, %lu early acks (%.1f%% skipped tail), "
+                     "%lu quorum failures",
+                     wq.writes, wq.early_acks, 100.0 * wq.early_acks / wq.writes,
+                     wq.quorum_failures);
+        buckets_info("Write Stragglers: %lu shards (%lu failed); heal queued=%lu "
+                     "repaired=%lu failed=%lu superseded=%lu dropped=%lu pending=%lu",
+                     wq.stragglers, wq.straggler_failures, wq.heal_queued,
+                     wq.heal_repaired, wq.heal_failed, wq.heal_superseded,
+                     wq.heal_dropped, wq.heal_pending);
+    }
+    
+    async_replication_metrics_t repl;
+    async_replication_get_metrics(&repl);
+    if (repl.batches > 0 || repl.pending > 0) {
+        buckets_info("Async Replication: pending=%zu/%zu completed=%zu failed=%zu dropped=%zu",
+                     repl.pending, repl.capacity, repl.completed, repl.failed, repl.dropped);
+        buckets_info("Async Replication Batching: %lu batches, %.1f replicas/batch, "
+                     "lag avg=%.1f ms max=%.1f ms oldest=%.1f ms, backpressure waits=%lu",
+                     repl.batches, repl.avg_batch_size, repl.avg_lag_ms, repl.max_lag_ms,
+                     repl.oldest_pending_ms, repl.backpressure_waits);
+    }
+    
+    buckets_object_cache_stats_t oc;
+    buckets_object_cache_get_stats(&oc);
+    if (oc.hits + oc.misses > 0) {
+        buckets_info("Object Cache: %.1f%% hit (%lu/%lu), %u objects, %.1f/%.1f MB",
+                     100.0 * oc.hits / (oc.hits + oc.misses), oc.hits, oc.hits + oc.misses,
+                     oc.entries, oc.bytes / (1024.0 * 1024.0), oc.max_bytes / (1024.0 * 1024.0));
+        buckets_info("Object Cache Admission: admitted=%lu rejected=%lu oversized=%lu "
+                     "stale=%lu evicted=%lu invalidated=%lu expired=%lu",
+                     oc.admissions, oc.rejections, oc.oversized, oc.stale_admits,
+                     oc.evictions, oc.invalidations, oc.expirations);
+    }
+    
+    buckets_get_coalesce_stats_t gc;
+    buckets_get_coalesce_get_stats(&gc);
+    if (gc.followers > 0) {
+        buckets_info("GET Coalescing: %lu reads served %lu requests (%.1f%% coalesced), "
+                     "detached=%lu copied=%.1f MB",
+                     gc.leaders, gc.leaders + gc.followers,
+                     100.0 * gc.followers / (gc.leaders + gc.followers),
+                     gc.detached, gc.bytes_copied / (1024.0 * 1024.0));
+    }
+    
+    buckets_mem_budget_stats_t mb;
+    buckets_mem_budget_get_stats(&mb);
+    if (mb.limit > 0 && mb.reservations > 0) {
+        buckets_info("Memory Budget: %.1f/%.1f MB in use (peak %.1f MB), %lu reservations",
+                     mb.used / (1024.0 * 1024.0), mb.limit / (1024.0 * 1024.0),
+                     mb.peak / (1024.0 * 1024.0), mb.reservations);
+        buckets_info("Memory Budget Waits: paused-reads=%lu waits=%lu avg-wait=%.1f ms "
+                     "overdrafts=%lu",
+                     mb.deferred, mb.waits,
+                     mb.waits ? mb.wait_time_us / 1000.0 / mb.waits : 0.0, mb.overdrafts);
+    }
+    
+    buckets_numa_stats_t numa;
+    buckets_numa_get_stats(&numa);
+    if (numa.nodes > 1 && numa.local_ops + numa.remote_ops > 0) {
+        u64 ops = numa.local_ops + numa.remote_ops;
+        buckets_info("NUMA: node %d/%u (home CPU %d), disk I/O local=%lu cross-socket=%lu "
+                     "(%.1f%%, %.1f MB) unknown=%lu",
+                     numa.home_node, numa.nodes, numa.home_cpu, numa.local_ops,
+                     numa.remote_ops, numa.remote_ops * 100.0 / ops,
+                     numa.remote_bytes / (1024.0 * 1024.0), numa.unknown_ops);
+    }
+    
+    buckets_async_journal_stats_t aj;
+    buckets_async_write_journal_stats(&aj);
+    if (aj.appends > 0 || aj.replayed > 0) {
+        buckets_info("Async Write Journal: %lu jobs, %lu fsyncs (%.1f jobs/fsync), "
+                     "pending=%lu size=%.1f MB compactions=%lu",
+                     aj.appends, aj.syncs, aj.syncs ? (double)aj.appends / aj.syncs : 0.0,
+                     aj.pending, aj.size_bytes / (1024.0 * 1024.0), aj.compactions);
+        if (aj.replayed > 0 || aj.superseded > 0 || aj.discarded > 0) {
+            buckets_info("Async Write Recovery: replayed=%lu already-applied=%lu torn=%lu",
+                         aj.replayed, aj.superseded, aj.discarded);
+        }
+    }
+    
     buckets_info("=========================");
     
     pthread_mutex_unlock(&g_uv_metrics.lock);
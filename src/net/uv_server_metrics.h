@@ -12,6 +12,8 @@
 #include <pthread.h>
 #include <time.h>
 
+#include "buckets.h"
+
 /* Enable metrics collection */
 #define UV_SERVER_METRICS_ENABLED 1
 
@@ -37,6 +39,28 @@ typedef struct {
     uint64_t threadpool_wait_time_sum;  /* Time waiting for thread pool */
     uint64_t threadpool_wait_count;
     
+    /* Resumable handler metrics */
+    uint64_t stage_runs;            /* Handler stages run */
+    uint64_t stage_legs;            /* Fan-out legs run */
+    uint64_t stage_parked;          /* Requests waiting without a thread */
+    
+    /* Priority lane metrics */
+    uint64_t lane_bulk_requests;    /* Requests run in the bulk lane */
+    uint64_t lane_bulk_deferred;    /* Bulk stages/legs held back for the reserve */
+    uint64_t lane_bulk_waiting;     /* ... currently held back */
+    
+    /* TLS metrics */
+    uint64_t tls_handshakes;        /* Completed handshakes */
+    uint64_t tls_resumed;           /* ... that resumed a session */
+    uint64_t tls_ktls;              /* ... offloaded to kernel TLS (both directions) */
+    uint64_t tls_failures;          /* Failed handshakes */
+    
+    /* Per-request cost (BUCKETS_ACCOUNTING=1) */
+    buckets_account_t request_cost_sum; /* Summed over accounted requests */
+    uint64_t request_cost_count;
+    uint64_t request_cost_max_syscalls; /* Costliest single request */
+    uint64_t request_cost_max_allocs;
+    
     /* Lock contention metrics */
     uint64_t write_lock_wait_time_sum;  /* Time waiting for write_lock */
     uint64_t write_lock_wait_count;
@@ -69,6 +93,16 @@ void uv_metrics_request_start(void);
 void uv_metrics_request_end(uint64_t latency_us);
 void uv_metrics_async_start(void);
 void uv_metrics_async_end(uint64_t wait_time_us);
+void uv_metrics_stage_run(void);
+void uv_metrics_stage_leg(void);
+void uv_metrics_stage_parked(int delta);
+void uv_metrics_lane_bulk_request(void);
+void uv_metrics_lane_bulk_waiting(int delta);
+void uv_metrics_request_cost(const buckets_account_t *account);
+
+/* TLS tracking */
+void uv_metrics_tls_handshake(bool resumed, bool ktls);
+void uv_metrics_tls_failure(void);
 
 /* Lock contention tracking */
 void uv_metrics_write_lock_wait(uint64_t wait_time_us);
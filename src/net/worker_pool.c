@@ -28,6 +28,7 @@
 #include "buckets.h"
 #include "buckets_worker_pool.h"
 #include "buckets_storage.h"  /* For buckets_chunk_reinit_after_fork */
+#include "buckets_numa.h"
 
 /* Maximum number of worker processes */
 #define MAX_WORKERS 64
@@ -93,8 +94,14 @@ static int worker_main(int worker_id, buckets_http_worker_callback_t callback, v
     
     buckets_info("Worker %d started (pid=%d)", worker_id, getpid());
     
+    /* Pin to a socket before any thread (io_uring poller, libuv pool)
+     * exists so they all inherit the placement */
+    buckets_numa_pin_worker(worker_id);
+    
     /* Reinitialize io_uring after fork - CRITICAL for correct operation */
     buckets_chunk_reinit_after_fork();
+    buckets_meta_log_reinit_after_fork();
+    buckets_segments_reinit_after_fork();
     
     /* Set environment variable so worker knows its ID */
     char worker_id_str[32];
@@ -16,6 +16,7 @@
 #include "buckets_storage.h"
 #include "buckets_json.h"
 #include "buckets_hash.h"
+#include "buckets_shm_cache.h"
 
 /* Registry cache entry */
 typedef struct registry_cache_entry {
@@ -52,6 +53,7 @@ typedef struct {
 static struct {
     buckets_registry_config_t config;
     registry_cache_t *cache;
+    buckets_shm_cache_t *shared;            /* Replaces cache when shared */
     bool initialized;
     pthread_mutex_t init_lock;
 } g_registry = {
@@ -325,6 +327,128 @@ static void cache_destroy(registry_cache_t *cache)
     buckets_free(cache);
 }
 
+/* ========================================================================
+ * Shared Cache (multi-process mode)
+ * ======================================================================== */
+
+/* Location as stored in a shared cache slot */
+typedef struct {
+    u32 pool_idx;
+    u32 set_idx;
+    u32 disk_count;
+    u32 disk_idxs[BUCKETS_REGISTRY_MAX_DISKS];
+    u64 generation;
+    i64 mod_time;
+    u64 size;
+    u16 bucket_len;
+    u16 object_len;
+    u16 version_len;
+    u16 reserved;
+    char names[];                           /* bucket, object, version_id */
+} shared_location_t;
+
+#define SHARED_LOCATION_MAX (sizeof(shared_location_t) + BUCKETS_REGISTRY_SHARED_KEY_MAX)
+
+static u32 shared_location_pack(const buckets_object_location_t *location,
+                                u8 *buf, size_t buf_size)
+{
+    size_t bucket_len = location->bucket ? strlen(location->bucket) : 0;
+    size_t object_len = location->object ? strlen(location->object) : 0;
+    size_t version_len = location->version_id ? strlen(location->version_id) : 0;
+    size_t total = sizeof(shared_location_t) + bucket_len + object_len + version_len;
+    if (total > buf_size) {
+        return 0;
+    }
+
+    shared_location_t *packed = (shared_location_t *)buf;
+    memset(packed, 0, sizeof(*packed));
+    packed->pool_idx = location->pool_idx;
+    packed->set_idx = location->set_idx;
+    packed->disk_count = location->disk_count;
+    memcpy(packed->disk_idxs, location->disk_idxs, sizeof(packed->disk_idxs));
+    packed->generation = location->generation;
+    packed->mod_time = (i64)location->mod_time;
+    packed->size = (u64)location->size;
+    packed->bucket_len = (u16)bucket_len;
+    packed->object_len = (u16)object_len;
+    packed->version_len = (u16)version_len;
+
+    char *p = packed->names;
+    memcpy(p, location->bucket, bucket_len);
+    memcpy(p + bucket_len, location->object, object_len);
+    memcpy(p + bucket_len + object_len, location->version_id, version_len);
+    return (u32)total;
+}
+
+static char* shared_name_dup(const char *src, u16 len)
+{
+    char *name = buckets_malloc(len + 1);
+    memcpy(name, src, len);
+    name[len] = '\0';
+    return name;
+}
+
+static buckets_object_location_t* shared_location_unpack(const u8 *buf)
+{
+    const shared_location_t *packed = (const shared_location_t *)buf;
+    buckets_object_location_t *location = buckets_registry_location_new();
+    if (!location) {
+        return NULL;
+    }
+
+    const char *p = packed->names;
+    location->bucket = shared_name_dup(p, packed->bucket_len);
+    location->object = shared_name_dup(p + packed->bucket_len, packed->object_len);
+    location->version_id = shared_name_dup(p + packed->bucket_len + packed->object_len,
+                                           packed->version_len);
+    location->pool_idx = packed->pool_idx;
+    location->set_idx = packed->set_idx;
+    location->disk_count = packed->disk_count;
+    memcpy(location->disk_idxs, packed->disk_idxs, sizeof(location->disk_idxs));
+    location->generation = packed->generation;
+    location->mod_time = (time_t)packed->mod_time;
+    location->size = (size_t)packed->size;
+    return location;
+}
+
+/* ========================================================================
+ * Cache Dispatch (private or shared)
+ * ======================================================================== */
+
+static buckets_object_location_t* registry_cache_get(const char *key)
+{
+    if (g_registry.shared) {
+        u64 buf[SHARED_LOCATION_MAX / sizeof(u64) + 1];
+        u32 len = 0;
+        if (!buckets_shm_cache_get(g_registry.shared, key, buf, sizeof(buf), &len)) {
+            return NULL;
+        }
+        return shared_location_unpack((const u8 *)buf);
+    }
+    return g_registry.cache ? cache_get(g_registry.cache, key) : NULL;
+}
+
+static void registry_cache_put(const char *key, const buckets_object_location_t *location)
+{
+    if (g_registry.shared) {
+        u64 buf[SHARED_LOCATION_MAX / sizeof(u64) + 1];
+        u32 len = shared_location_pack(location, (u8 *)buf, SHARED_LOCATION_MAX);
+        if (len > 0) {
+            buckets_shm_cache_put(g_registry.shared, key, buf, len);
+        }
+    } else if (g_registry.cache) {
+        cache_put(g_registry.cache, key, location);
+    }
+}
+
+static int registry_cache_drop(const char *key)
+{
+    if (g_registry.shared) {
+        return buckets_shm_cache_invalidate(g_registry.shared, key) ? 0 : -1;
+    }
+    return g_registry.cache ? cache_invalidate(g_registry.cache, key) : -1;
+}
+
 /* ========================================================================
  * Registry Initialization
  * ======================================================================== */
@@ -382,12 +506,52 @@ void buckets_registry_cleanup(void)
         g_registry.cache = NULL;
     }
     
+    if (g_registry.shared) {
+        buckets_shm_cache_destroy(g_registry.shared);
+        g_registry.shared = NULL;
+    }
+    
     g_registry.initialized = false;
     pthread_mutex_unlock(&g_registry.init_lock);
     
     buckets_info("Registry cleanup complete");
 }
 
+int buckets_registry_cache_share(void)
+{
+    pthread_mutex_lock(&g_registry.init_lock);
+    
+    if (!g_registry.initialized || !g_registry.config.enable_cache) {
+        pthread_mutex_unlock(&g_registry.init_lock);
+        return -1;
+    }
+    if (g_registry.shared) {
+        pthread_mutex_unlock(&g_registry.init_lock);
+        return 0;
+    }
+    
+    buckets_shm_cache_t *shared = buckets_shm_cache_create("registry",
+                                                           g_registry.config.cache_size,
+                                                           BUCKETS_REGISTRY_SHARED_KEY_MAX,
+                                                           (u32)SHARED_LOCATION_MAX,
+                                                           g_registry.config.cache_ttl_seconds);
+    if (!shared) {
+        pthread_mutex_unlock(&g_registry.init_lock);
+        buckets_warn("Registry cache stays per-process");
+        return -1;
+    }
+    
+    /* Called before workers exist, so nothing else is using the old cache */
+    g_registry.shared = shared;
+    if (g_registry.cache) {
+        cache_destroy(g_registry.cache);
+        g_registry.cache = NULL;
+    }
+    
+    pthread_mutex_unlock(&g_registry.init_lock);
+    return 0;
+}
+
 const buckets_registry_config_t* buckets_registry_get_config(void)
 {
     return &g_registry.config;
@@ -645,9 +809,7 @@ int buckets_registry_record(const buckets_object_location_t *location)
     }
     
     /* Update cache */
-    if (g_registry.cache) {
-        cache_put(g_registry.cache, key, location);
-    }
+    registry_cache_put(key, location);
     
     buckets_free(key);
     buckets_free(json);
@@ -683,13 +845,11 @@ int buckets_registry_lookup(const char *bucket, const char *object,
     }
     
     /* Try cache first */
-    if (g_registry.cache) {
-        *location = cache_get(g_registry.cache, key);
-        if (*location) {
-            buckets_free(key);
-            buckets_debug("Cache hit: %s/%s/%s", bucket, object, vid);
-            return 0;
-        }
+    *location = registry_cache_get(key);
+    if (*location) {
+        buckets_free(key);
+        buckets_debug("Cache hit: %s/%s/%s", bucket, object, vid);
+        return 0;
     }
     
     /* Cache miss - fetch from storage */
@@ -729,9 +889,7 @@ int buckets_registry_lookup(const char *bucket, const char *object,
     }
     
     /* Update cache for future lookups */
-    if (g_registry.cache) {
-        cache_put(g_registry.cache, key, *location);
-    }
+    registry_cache_put(key, *location);
     
     buckets_free(key);
     buckets_debug("Cache miss, loaded from storage: %s/%s/%s", bucket, object, vid);
@@ -768,9 +926,7 @@ int buckets_registry_delete(const char *bucket, const char *object,
     }
     
     /* Invalidate cache */
-    if (g_registry.cache) {
-        cache_invalidate(g_registry.cache, key);
-    }
+    registry_cache_drop(key);
     
     buckets_free(key);
     buckets_debug("Deleted location: %s/%s/%s", bucket, object, vid);
@@ -781,7 +937,7 @@ int buckets_registry_delete(const char *bucket, const char *object,
 int buckets_registry_cache_invalidate(const char *bucket, const char *object,
                                        const char *version_id)
 {
-    if (!g_registry.initialized || !g_registry.cache) {
+    if (!g_registry.initialized || (!g_registry.cache && !g_registry.shared)) {
         return -1;
     }
     
@@ -791,22 +947,68 @@ int buckets_registry_cache_invalidate(const char *bucket, const char *object,
         return -1;
     }
     
-    int result = cache_invalidate(g_registry.cache, key);
+    int result = registry_cache_drop(key);
     buckets_free(key);
     
     return result;
 }
 
+int buckets_registry_cache_keys(char ***keys, u32 *count, u32 max)
+{
+    if (!keys || !count) {
+        return -1;
+    }
+    *keys = NULL;
+    *count = 0;
+    
+    registry_cache_t *cache = g_registry.cache;
+    if (g_registry.shared || !cache || max == 0) {
+        return 0;
+    }
+    
+    pthread_rwlock_rdlock(&cache->lock);
+    u32 n = cache->entry_count < max ? cache->entry_count : max;
+    char **out = buckets_calloc(n > 0 ? n : 1, sizeof(char*));
+    u32 i = 0;
+    for (registry_cache_entry_t *entry = cache->lru_head; entry && i < n;
+         entry = entry->lru_next) {
+        out[i++] = buckets_strdup(entry->key);
+    }
+    pthread_rwlock_unlock(&cache->lock);
+    
+    *keys = out;
+    *count = i;
+    return 0;
+}
+
 void buckets_registry_cache_clear(void)
 {
-    if (g_registry.cache) {
+    if (g_registry.shared) {
+        buckets_shm_cache_clear(g_registry.shared);
+    } else if (g_registry.cache) {
         cache_clear(g_registry.cache);
     }
 }
 
 int buckets_registry_get_stats(buckets_registry_stats_t *stats)
 {
-    if (!g_registry.initialized || !g_registry.cache || !stats) {
+    if (!g_registry.initialized || !stats) {
+        return -1;
+    }
+    
+    if (g_registry.shared) {
+        buckets_shm_cache_stats_t shared;
+        buckets_shm_cache_get_stats(g_registry.shared, &shared);
+        stats->hits = shared.hits;
+        stats->misses = shared.misses;
+        stats->evictions = shared.evictions;
+        stats->total_entries = shared.entries;
+        u64 total = stats->hits + stats->misses;
+        stats->hit_rate = total > 0 ? (double)stats->hits * 100.0 / total : 0.0;
+        return 0;
+    }
+    
+    if (!g_registry.cache) {
         return -1;
     }
     
@@ -897,7 +1099,7 @@ int buckets_registry_update(const char *bucket, const char *object,
         return -1;
     }
     
-    cache_invalidate(g_registry.cache, cache_key);
+    registry_cache_drop(cache_key);
     buckets_free(cache_key);
     
     /* Now record the new location (overwrites storage) */
@@ -1043,6 +1245,173 @@ static buckets_object_location_t* parse_registry_json(const char *json_str)
     return loc;
 }
 
+/* Location for one xl.meta of the local listing, or NULL to skip it */
+static buckets_object_location_t* location_from_meta(const char *meta_content,
+                                                     const char *bucket,
+                                                     const char *prefix)
+{
+    /* Parse xl.meta JSON */
+    cJSON *meta_json = cJSON_Parse(meta_content);
+    if (!meta_json) return NULL;
+    
+    /* Try to get bucket/object directly from xl.meta (new format) */
+    cJSON *bucket_json = cJSON_GetObjectItem(meta_json, "bucket");
+    cJSON *object_json = cJSON_GetObjectItem(meta_json, "object");
+    
+    buckets_object_location_t *loc = NULL;
+    
+    if (bucket_json && cJSON_IsString(bucket_json) && 
+        object_json && cJSON_IsString(object_json)) {
+        /* New format: bucket/object stored directly in xl.meta */
+        const char *meta_bucket = bucket_json->valuestring;
+        const char *meta_object = object_json->valuestring;
+        
+        /* Skip if not matching our bucket */
+        if (strcmp(meta_bucket, bucket) != 0) {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        /* Skip internal buckets */
+        if (meta_bucket[0] == '.') {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        /* Check prefix filter if specified */
+        if (prefix && strncmp(meta_object, prefix, strlen(prefix)) != 0) {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        /* Create location from xl.meta */
+        loc = buckets_calloc(1, sizeof(buckets_object_location_t));
+        if (loc) {
+            loc->bucket = buckets_strdup(meta_bucket);
+            loc->object = buckets_strdup(meta_object);
+            loc->version_id = buckets_strdup("latest");
+            
+            /* Get size from stat */
+            cJSON *stat = cJSON_GetObjectItem(meta_json, "stat");
+            if (stat) {
+                cJSON *size_json = cJSON_GetObjectItem(stat, "size");
+                if (size_json && cJSON_IsNumber(size_json)) {
+                    loc->size = (size_t)size_json->valuedouble;
+                }
+                cJSON *mod_time_json = cJSON_GetObjectItem(stat, "modTime");
+                if (mod_time_json && cJSON_IsString(mod_time_json)) {
+                    /* Parse ISO8601 time - just use current time for now */
+                    loc->mod_time = time(NULL);
+                }
+            }
+            
+            loc->pool_idx = 0;
+            loc->set_idx = 0;
+            loc->disk_count = 1;
+            loc->disk_idxs[0] = 0;
+            loc->generation = 1;
+        }
+        cJSON_Delete(meta_json);
+    } else {
+        /* Legacy format: check for registry entries (application/json) */
+        cJSON *meta_obj = cJSON_GetObjectItem(meta_json, "meta");
+        if (!meta_obj) {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        cJSON *content_type = cJSON_GetObjectItem(meta_obj, "content-type");
+        if (!content_type || !cJSON_IsString(content_type) ||
+            strcmp(content_type->valuestring, "application/json") != 0) {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        /* Get inline data (base64 encoded registry JSON) */
+        cJSON *inline_data = cJSON_GetObjectItem(meta_json, "inline");
+        if (!inline_data || !cJSON_IsString(inline_data)) {
+            cJSON_Delete(meta_json);
+            return NULL;
+        }
+        
+        /* Decode and parse registry entry */
+        size_t decoded_len = 0;
+        char *decoded = decode_base64_inline(inline_data->valuestring, &decoded_len);
+        cJSON_Delete(meta_json);
+        
+        if (!decoded) return NULL;
+        
+        loc = parse_registry_json(decoded);
+        buckets_free(decoded);
+        
+        if (!loc || !loc->bucket) {
+            if (loc) buckets_registry_location_free(loc);
+            return NULL;
+        }
+        
+        /* Check if this entry matches our bucket */
+        if (strcmp(loc->bucket, bucket) != 0) {
+            buckets_registry_location_free(loc);
+            return NULL;
+        }
+        
+        /* Check prefix filter if specified */
+        if (prefix && loc->object) {
+            if (strncmp(loc->object, prefix, strlen(prefix)) != 0) {
+                buckets_registry_location_free(loc);
+                return NULL;
+            }
+        }
+        
+        /* Skip delete markers (version_id starts with "delete-") */
+        if (loc->version_id && strncmp(loc->version_id, "delete-", 7) == 0) {
+            buckets_registry_location_free(loc);
+            return NULL;
+        }
+    }
+    
+    return loc;
+}
+
+typedef struct {
+    const char *bucket;
+    const char *prefix;
+    size_t max_keys;
+    buckets_object_location_t **results;
+    size_t capacity;
+    size_t found;
+} local_list_t;
+
+/* Append to the local listing (grow array if needed) */
+static void local_list_push(local_list_t *list, buckets_object_location_t *loc)
+{
+    if (list->found >= list->capacity) {
+        size_t capacity = list->capacity * 2;
+        buckets_object_location_t **new_results = buckets_realloc(
+            list->results, capacity * sizeof(buckets_object_location_t*));
+        if (!new_results) {
+            buckets_registry_location_free(loc);
+            return;
+        }
+        list->results = new_results;
+        list->capacity = capacity;
+    }
+    list->results[list->found++] = loc;
+}
+
+static int local_list_log_entry(const char *object_path, const char *json,
+                                size_t len, void *arg)
+{
+    (void)object_path;
+    (void)len;
+    local_list_t *list = (local_list_t*)arg;
+    buckets_object_location_t *loc = location_from_meta(json, list->bucket, list->prefix);
+    if (loc) {
+        local_list_push(list, loc);
+    }
+    return list->max_keys > 0 && list->found >= list->max_keys;
+}
+
 /**
  * List all objects in a bucket with optional prefix
  * 
@@ -1139,10 +1508,15 @@ int buckets_registry_list(const char *bucket, const char *prefix,
     const char *base_dir = storage_config->data_dir;
     
     /* Allocate results array (will grow as needed) */
-    size_t capacity = 64;
-    size_t found = 0;
-    buckets_object_location_t **results = buckets_calloc(capacity, sizeof(buckets_object_location_t*));
-    if (!results) {
+    local_list_t list = {
+        .bucket = bucket,
+        .prefix = prefix,
+        .max_keys = max_keys,
+        .capacity = 64,
+        .found = 0
+    };
+    list.results = buckets_calloc(list.capacity, sizeof(buckets_object_location_t*));
+    if (!list.results) {
         return -1;
     }
     
@@ -1163,7 +1537,7 @@ int buckets_registry_list(const char *bucket, const char *prefix,
     /* Scan all hash prefix directories (00-ff) */
     DIR *prefix_dir = opendir(data_dir);
     if (!prefix_dir) {
-        buckets_free(results);
+        buckets_free(list.results);
         return -1;
     }
     
@@ -1197,12 +1571,20 @@ int buckets_registry_list(const char *bucket, const char *prefix,
             if (hash_entry->d_name[0] == '.') continue;
             
             /* Check for max_keys limit */
-            if (max_keys > 0 && found >= max_keys) {
+            if (max_keys > 0 && list.found >= max_keys) {
                 closedir(hash_dir);
                 closedir(prefix_dir);
                 goto done;
             }
             
+            /* Objects in the metadata log are listed from it below */
+            char object_path[PATH_MAX];
+            snprintf(object_path, sizeof(object_path), "%s/%s/",
+                     prefix_entry->d_name, hash_entry->d_name);
+            if (buckets_meta_log_contains(data_dir, object_path)) {
+                continue;
+            }
+            
             /* Read xl.meta */
             char meta_path[PATH_MAX * 2];
 #pragma GCC diagnostic push
@@ -1234,142 +1616,12 @@ int buckets_registry_list(const char *bucket, const char *prefix,
             fclose(f);
             meta_content[read_size] = '\0';
             
-            /* Parse xl.meta JSON */
-            cJSON *meta_json = cJSON_Parse(meta_content);
+            buckets_object_location_t *loc = location_from_meta(meta_content, bucket, prefix);
             buckets_free(meta_content);
-            if (!meta_json) continue;
             
-            /* Try to get bucket/object directly from xl.meta (new format) */
-            cJSON *bucket_json = cJSON_GetObjectItem(meta_json, "bucket");
-            cJSON *object_json = cJSON_GetObjectItem(meta_json, "object");
-            
-            buckets_object_location_t *loc = NULL;
-            
-            if (bucket_json && cJSON_IsString(bucket_json) && 
-                object_json && cJSON_IsString(object_json)) {
-                /* New format: bucket/object stored directly in xl.meta */
-                const char *meta_bucket = bucket_json->valuestring;
-                const char *meta_object = object_json->valuestring;
-                
-                /* Skip if not matching our bucket */
-                if (strcmp(meta_bucket, bucket) != 0) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Skip internal buckets */
-                if (meta_bucket[0] == '.') {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Check prefix filter if specified */
-                if (prefix && strncmp(meta_object, prefix, strlen(prefix)) != 0) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Create location from xl.meta */
-                loc = buckets_calloc(1, sizeof(buckets_object_location_t));
-                if (loc) {
-                    loc->bucket = buckets_strdup(meta_bucket);
-                    loc->object = buckets_strdup(meta_object);
-                    loc->version_id = buckets_strdup("latest");
-                    
-                    /* Get size from stat */
-                    cJSON *stat = cJSON_GetObjectItem(meta_json, "stat");
-                    if (stat) {
-                        cJSON *size_json = cJSON_GetObjectItem(stat, "size");
-                        if (size_json && cJSON_IsNumber(size_json)) {
-                            loc->size = (size_t)size_json->valuedouble;
-                        }
-                        cJSON *mod_time_json = cJSON_GetObjectItem(stat, "modTime");
-                        if (mod_time_json && cJSON_IsString(mod_time_json)) {
-                            /* Parse ISO8601 time - just use current time for now */
-                            loc->mod_time = time(NULL);
-                        }
-                    }
-                    
-                    loc->pool_idx = 0;
-                    loc->set_idx = 0;
-                    loc->disk_count = 1;
-                    loc->disk_idxs[0] = 0;
-                    loc->generation = 1;
-                }
-                cJSON_Delete(meta_json);
-            } else {
-                /* Legacy format: check for registry entries (application/json) */
-                cJSON *meta_obj = cJSON_GetObjectItem(meta_json, "meta");
-                if (!meta_obj) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                cJSON *content_type = cJSON_GetObjectItem(meta_obj, "content-type");
-                if (!content_type || !cJSON_IsString(content_type) ||
-                    strcmp(content_type->valuestring, "application/json") != 0) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Get inline data (base64 encoded registry JSON) */
-                cJSON *inline_data = cJSON_GetObjectItem(meta_json, "inline");
-                if (!inline_data || !cJSON_IsString(inline_data)) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Decode and parse registry entry */
-                size_t decoded_len = 0;
-                char *decoded = decode_base64_inline(inline_data->valuestring, &decoded_len);
-                cJSON_Delete(meta_json);
-                
-                if (!decoded) continue;
-                
-                loc = parse_registry_json(decoded);
-                buckets_free(decoded);
-                
-                if (!loc || !loc->bucket) {
-                    if (loc) buckets_registry_location_free(loc);
-                    continue;
-                }
-                
-                /* Check if this entry matches our bucket */
-                if (strcmp(loc->bucket, bucket) != 0) {
-                    buckets_registry_location_free(loc);
-                    continue;
-                }
-                
-                /* Check prefix filter if specified */
-                if (prefix && loc->object) {
-                    if (strncmp(loc->object, prefix, strlen(prefix)) != 0) {
-                        buckets_registry_location_free(loc);
-                        continue;
-                    }
-                }
-                
-                /* Skip delete markers (version_id starts with "delete-") */
-                if (loc->version_id && strncmp(loc->version_id, "delete-", 7) == 0) {
-                    buckets_registry_location_free(loc);
-                    continue;
-                }
-            }
-            
-            if (!loc) continue;
-            
-            /* Add to results (grow array if needed) */
-            if (found >= capacity) {
-                capacity *= 2;
-                buckets_object_location_t **new_results = buckets_realloc(
-                    results, capacity * sizeof(buckets_object_location_t*));
-                if (!new_results) {
-                    buckets_registry_location_free(loc);
-                    continue;
-                }
-                results = new_results;
+            if (loc) {
+                local_list_push(&list, loc);
             }
-            
-            results[found++] = loc;
         }
         
         closedir(hash_dir);
@@ -1377,12 +1629,16 @@ int buckets_registry_list(const char *bucket, const char *prefix,
     
     closedir(prefix_dir);
     
+    if (max_keys == 0 || list.found < max_keys) {
+        buckets_meta_log_foreach(data_dir, local_list_log_entry, &list);
+    }
+    
 done:
-    *locations = results;
-    *count = found;
+    *locations = list.results;
+    *count = list.found;
     
     buckets_debug("Registry list: bucket=%s, prefix=%s, found=%zu", 
-                  bucket, prefix ? prefix : "(none)", found);
+                  bucket, prefix ? prefix : "(none)", list.found);
     
     return 0;
 }
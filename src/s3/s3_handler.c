@@ -148,6 +148,8 @@ extern const char* uv_http_get_header(void *conn, const char *name);
 extern int uv_http_iterate_headers_with_prefix(void *conn_ptr, const char *prefix,
                                                 void (*callback)(const char *name, const char *value, void *user_data),
                                                 void *user_data);
+extern void* uv_http_get_qos_tenant(void *conn);
+extern void uv_http_set_qos_tenant(void *conn, void *tenant);
 
 /* External auth functions from s3_auth.c */
 extern int buckets_s3_parse_auth_header(const char *auth_header, buckets_s3_request_t *req,
@@ -408,39 +410,36 @@ static bool has_query_param(buckets_s3_request_t *req, const char *key)
     return false;
 }
 
-void buckets_s3_handler(buckets_http_request_t *req,
-                        buckets_http_response_t *res,
-                        void *user_data)
+/**
+ * Charge a request whose signature verified to its access key and bucket
+ * (admission only knew the client address)
+ */
+static int s3_qos_authenticated(buckets_http_request_t *req, buckets_s3_request_t *s3_req)
 {
-    (void)user_data;
-    
-    /* Check for health endpoint */
-    if (req->uri && strcmp(req->uri, "/health") == 0) {
-        res->status_code = 200;
-        /* Note: Don't set body to string literal - it would be freed in s3_streaming.c.
-         * A 200 with no body is sufficient for health checks. */
-        res->body = NULL;
-        res->body_len = 0;
-        return;
+    buckets_s3_qos_tenant_t *admitted = req->internal ? uv_http_get_qos_tenant(req->internal) : NULL;
+    if (!admitted) {
+        /* QoS off, or an internal route */
+        return BUCKETS_OK;
     }
     
-    /* Check for RPC endpoint */
-    if (req->uri && strcmp(req->uri, "/rpc") == 0) {
-        buckets_info("RPC request received: method=%s, uri=%s, body_len=%zu",
-                     req->method ? req->method : "NULL", req->uri, req->body_len);
-        /* Forward to RPC handler */
-        extern void buckets_rpc_http_handler(buckets_http_request_t *req,
-                                             buckets_http_response_t *res);
-        buckets_rpc_http_handler(req, res);
-        return;
+    buckets_s3_qos_tenant_t *tenant = NULL;
+    int ret = buckets_s3_qos_authenticate(admitted, s3_req->access_key, s3_req->bucket, &tenant);
+    if (ret == BUCKETS_OK) {
+        uv_http_set_qos_tenant(req->internal, tenant);
     }
-    
+    return ret;
+}
+
+int buckets_s3_accept_request(buckets_http_request_t *req,
+                               buckets_http_response_t *res,
+                               buckets_s3_request_t **s3_req_out)
+{
     /* Parse S3 request */
     buckets_s3_request_t *s3_req = NULL;
     int ret = buckets_s3_parse_request(req, &s3_req);
     if (ret != BUCKETS_OK) {
         buckets_http_response_error(res, 400, "Invalid S3 request");
-        return;
+        return ret;
     }
     
     /* Verify AWS Signature V4 authentication */
@@ -467,10 +466,147 @@ void buckets_s3_handler(buckets_http_request_t *req,
                 res->body = buckets_strdup(xml);
                 res->body_len = strlen(xml);
             }
-            return;
+            return ret;
+        }
+        
+        ret = s3_qos_authenticated(req, s3_req);
+        if (ret != BUCKETS_OK) {
+            buckets_debug("SlowDown: %s/%s over its limit", s3_req->access_key, s3_req->bucket);
+            buckets_s3_request_free(s3_req);
+            res->status_code = 503;
+            buckets_http_response_set_header(res, "Content-Type", "application/xml");
+            if (strcmp(req->method, "HEAD") != 0) {
+                const char *xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                    "<Error><Code>SlowDown</Code>"
+                    "<Message>Please reduce your request rate.</Message></Error>";
+                res->body = buckets_strdup(xml);
+                res->body_len = strlen(xml);
+            }
+            return ret;
+        }
+    }
+    
+    *s3_req_out = s3_req;
+    return BUCKETS_OK;
+}
+
+void buckets_s3_to_http_response(const char *method,
+                                 buckets_s3_response_t *s3_res,
+                                 buckets_http_response_t *res)
+{
+    res->status_code = s3_res->status_code;
+    
+    /* HEAD requests must not have a body per HTTP spec */
+    if (strcmp(method, "HEAD") == 0) {
+        /* Don't send body for HEAD, but preserve Content-Length for object metadata */
+        if (s3_res->body) {
+            buckets_free(s3_res->body);
+            s3_res->body = NULL;
         }
+        res->body = NULL;
+        res->body_len = 0;
+    } else if (s3_res->body) {
+        res->body = s3_res->body;
+        res->body_len = s3_res->body_len;
+        s3_res->body = NULL;  /* Transfer ownership */
+    }
+    
+    /* Set headers */
+    if (s3_res->etag[0] != '\0') {
+        buckets_http_response_set_header(res, "ETag", s3_res->etag);
+    }
+    
+    if (s3_res->last_modified[0] != '\0') {
+        buckets_http_response_set_header(res, "Last-Modified", s3_res->last_modified);
+    }
+    
+    if (s3_res->content_type[0] != '\0') {
+        buckets_http_response_set_header(res, "Content-Type", s3_res->content_type);
+    } else {
+        buckets_http_response_set_header(res, "Content-Type", "application/xml");
+    }
+    
+    /* Set version ID header if present */
+    if (s3_res->version_id[0] != '\0') {
+        buckets_http_response_set_header(res, "x-amz-version-id", s3_res->version_id);
+        buckets_debug("Setting response header: x-amz-version-id: %s", s3_res->version_id);
     }
     
+    /* Set user metadata headers (x-amz-meta-*) */
+    for (int i = 0; i < s3_res->user_meta_count; i++) {
+        char header_name[256];
+        snprintf(header_name, sizeof(header_name), "x-amz-meta-%s", s3_res->user_meta_keys[i]);
+        buckets_http_response_set_header(res, header_name, s3_res->user_meta_values[i]);
+        buckets_debug("Setting response header: %s: %s", header_name, s3_res->user_meta_values[i]);
+    }
+    
+    /* For HEAD requests, set body_len from s3_res->content_length 
+     * so the HTTP layer uses it for Content-Length header.
+     * We don't send body for HEAD, but Content-Length should be object size. */
+    if (strcmp(method, "HEAD") == 0) {
+        buckets_debug("HEAD response: content_length=%lld, body_len=%zu", 
+                      (long long)s3_res->content_length, s3_res->body_len);
+        if (s3_res->content_length > 0) {
+            res->body_len = (size_t)s3_res->content_length;
+            buckets_debug("HEAD: Set res->body_len to %zu for Content-Length", res->body_len);
+        } else if (s3_res->body_len > 0) {
+            /* Fallback: use body_len if content_length wasn't set */
+            res->body_len = s3_res->body_len;
+            buckets_debug("HEAD: Fallback to body_len=%zu for Content-Length", res->body_len);
+        }
+    }
+}
+
+void buckets_s3_handler(buckets_http_request_t *req,
+                        buckets_http_response_t *res,
+                        void *user_data)
+{
+    (void)user_data;
+    
+    /* Check for health endpoint */
+    if (req->uri && strcmp(req->uri, "/health") == 0) {
+        res->status_code = 200;
+        /* Note: Don't set body to string literal - it would be freed in s3_streaming.c.
+         * A 200 with no body is sufficient for health checks. */
+        res->body = NULL;
+        res->body_len = 0;
+        return;
+    }
+    
+    /* Check for RPC endpoint */
+    if (req->uri && strcmp(req->uri, "/rpc") == 0) {
+        buckets_info("RPC request received: method=%s, uri=%s, body_len=%zu",
+                     req->method ? req->method : "NULL", req->uri, req->body_len);
+        /* Forward to RPC handler */
+        extern void buckets_rpc_http_handler(buckets_http_request_t *req,
+                                             buckets_http_response_t *res);
+        buckets_rpc_http_handler(req, res);
+        return;
+    }
+    
+    /* Parse and authenticate */
+    buckets_s3_request_t *s3_req = NULL;
+    if (buckets_s3_accept_request(req, res, &s3_req) != BUCKETS_OK) {
+        return;
+    }
+    buckets_s3_handle_accepted(req, s3_req, res);
+}
+
+void buckets_s3_handle_accepted(buckets_http_request_t *req,
+                                buckets_s3_request_t *s3_req,
+                                buckets_http_response_t *res)
+{
+    int ret = BUCKETS_OK;
+
+    /* Admin endpoints share S3 authentication but not S3 routing */
+    if (strncmp(req->uri, "/_admin/", 8) == 0) {
+        buckets_s3_request_free(s3_req);
+        extern void buckets_admin_http_handler(buckets_http_request_t *req,
+                                               buckets_http_response_t *res);
+        buckets_admin_http_handler(req, res);
+        return;
+    }
+
     /* Allocate S3 response */
     buckets_s3_response_t *s3_res = buckets_calloc(1, sizeof(buckets_s3_response_t));
     if (!s3_res) {
@@ -608,68 +744,12 @@ void buckets_s3_handler(buckets_http_request_t *req,
                             "Method not allowed", req->uri);
     }
     
-    /* Convert S3 response to HTTP response */
-    res->status_code = s3_res->status_code;
-    
-    /* HEAD requests must not have a body per HTTP spec */
-    if (strcmp(method, "HEAD") == 0) {
-        /* Don't send body for HEAD, but preserve Content-Length for object metadata */
-        if (s3_res->body) {
-            buckets_free(s3_res->body);
-            s3_res->body = NULL;
-        }
-        res->body = NULL;
-        res->body_len = 0;
-    } else if (s3_res->body) {
-        res->body = s3_res->body;
-        res->body_len = s3_res->body_len;
-        s3_res->body = NULL;  /* Transfer ownership */
-    }
-    
-    /* Set headers */
-    if (s3_res->etag[0] != '\0') {
-        buckets_http_response_set_header(res, "ETag", s3_res->etag);
-    }
-    
-    if (s3_res->last_modified[0] != '\0') {
-        buckets_http_response_set_header(res, "Last-Modified", s3_res->last_modified);
-    }
-    
-    if (s3_res->content_type[0] != '\0') {
-        buckets_http_response_set_header(res, "Content-Type", s3_res->content_type);
-    } else {
-        buckets_http_response_set_header(res, "Content-Type", "application/xml");
-    }
-    
-    /* Set version ID header if present */
-    if (s3_res->version_id[0] != '\0') {
-        buckets_http_response_set_header(res, "x-amz-version-id", s3_res->version_id);
-        buckets_debug("Setting response header: x-amz-version-id: %s", s3_res->version_id);
-    }
-    
-    /* Set user metadata headers (x-amz-meta-*) */
-    for (int i = 0; i < s3_res->user_meta_count; i++) {
-        char header_name[256];
-        snprintf(header_name, sizeof(header_name), "x-amz-meta-%s", s3_res->user_meta_keys[i]);
-        buckets_http_response_set_header(res, header_name, s3_res->user_meta_values[i]);
-        buckets_debug("Setting response header: %s: %s", header_name, s3_res->user_meta_values[i]);
+    if (ret != BUCKETS_OK) {
+        buckets_debug("S3 %s %s failed: %d", method, req->uri, ret);
     }
     
-    /* For HEAD requests, set body_len from s3_res->content_length 
-     * so the HTTP layer uses it for Content-Length header.
-     * We don't send body for HEAD, but Content-Length should be object size. */
-    if (strcmp(method, "HEAD") == 0) {
-        buckets_debug("HEAD response: content_length=%lld, body_len=%zu", 
-                      (long long)s3_res->content_length, s3_res->body_len);
-        if (s3_res->content_length > 0) {
-            res->body_len = (size_t)s3_res->content_length;
-            buckets_debug("HEAD: Set res->body_len to %zu for Content-Length", res->body_len);
-        } else if (s3_res->body_len > 0) {
-            /* Fallback: use body_len if content_length wasn't set */
-            res->body_len = s3_res->body_len;
-            buckets_debug("HEAD: Fallback to body_len=%zu for Content-Length", res->body_len);
-        }
-    }
+    /* Convert S3 response to HTTP response */
+    buckets_s3_to_http_response(method, s3_res, res);
     
     /* Cleanup */
     buckets_s3_response_free(s3_res);
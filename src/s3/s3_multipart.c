@@ -26,6 +26,7 @@
 #include "buckets.h"
 #include "buckets_s3.h"
 #include "buckets_storage.h"
+#include "buckets_mem_budget.h"
 
 #include "../../third_party/cJSON/cJSON.h"
 
@@ -606,7 +607,8 @@ int buckets_s3_complete_multipart_upload(buckets_s3_request_t *req, buckets_s3_r
     buckets_info("⏱️  CompleteMultipart: Total size = %zu bytes (%.2f MB)", 
                  total_size, total_size / 1024.0 / 1024.0);
     
-    /* Allocate buffer for complete object */
+    /* Allocate buffer for complete object (waits for memory budget) */
+    buckets_mem_budget_charge(total_size);
     char *final_data = buckets_malloc(total_size);
     if (!final_data) {
         buckets_error("⏱️  CompleteMultipart FAILED: Cannot allocate %zu bytes", total_size);
@@ -689,6 +691,7 @@ int buckets_s3_complete_multipart_upload(buckets_s3_request_t *req, buckets_s3_r
     }
     
     buckets_free(final_data);
+    buckets_object_cache_publish_invalidation(req->bucket, req->key);
     
     if (ret != 0) {
         buckets_error("⏱️  CompleteMultipart FAILED: put_object returned %d for %s/%s", 
@@ -264,6 +264,9 @@ int buckets_s3_put_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
         }
     }
     
+    /* Even a failed PUT may have replaced some shards; never serve the old copy */
+    buckets_object_cache_publish_invalidation(req->bucket, req->key);
+    
     /* Free metadata strings we allocated */
     if (meta.meta.content_type) {
         buckets_free(meta.meta.content_type);
@@ -306,40 +309,57 @@ int buckets_s3_put_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
     return BUCKETS_OK;
 }
 
-int buckets_s3_get_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
+int buckets_s3_get_object_prepare(buckets_s3_request_t *req, buckets_s3_response_t *res,
+                                  u64 *cache_token)
 {
-    if (!req || !res) {
-        return BUCKETS_ERR_INVALID_ARG;
-    }
-    
     /* Validate bucket and key */
     if (!buckets_s3_validate_bucket_name(req->bucket)) {
         buckets_s3_xml_error(res, "InvalidBucketName",
                             "The specified bucket name is not valid",
                             req->bucket);
-        return BUCKETS_OK;
+        return 1;
     }
     
     if (!buckets_s3_validate_object_key(req->key)) {
         buckets_s3_xml_error(res, "InvalidKey",
                             "The specified key is not valid",
                             req->key);
-        return BUCKETS_OK;
+        return 1;
     }
     
-    /* Use distributed storage layer */
-    void *object_data = NULL;
-    size_t object_size = 0;
-    
-    int ret = buckets_get_object(req->bucket, req->key, &object_data, &object_size);
-    if (ret != 0) {
-        /* Object not found or error */
-        buckets_s3_xml_error(res, "NoSuchKey",
-                            "The specified key does not exist",
-                            req->key);
-        return BUCKETS_OK;
+    /* Hot object cache: popular small objects are served from memory */
+    buckets_cached_object_t cached;
+    if (buckets_object_cache_get(req->bucket, req->key, &cached, cache_token) == 0) {
+        res->status_code = 200;
+        res->body = cached.data;  /* Caller owns this memory */
+        res->body_len = cached.size;
+        res->content_length = cached.size;
+        cached.data = NULL;
+        snprintf(res->etag, sizeof(res->etag), "%s", cached.etag);
+        snprintf(res->content_type, sizeof(res->content_type), "%s",
+                 cached.content_type ? cached.content_type : "application/octet-stream");
+        for (u32 i = 0; i < cached.user_count && res->user_meta_count < BUCKETS_S3_MAX_USER_METADATA; i++) {
+            res->user_meta_keys[res->user_meta_count] = cached.user_keys[i];
+            res->user_meta_values[res->user_meta_count] = cached.user_values[i];
+            res->user_meta_count++;
+            cached.user_keys[i] = NULL;
+            cached.user_values[i] = NULL;
+        }
+        buckets_cached_object_free(&cached);
+        buckets_s3_format_timestamp(time(NULL), res->last_modified);
+        
+        buckets_debug("GET object: %s/%s (%zu bytes, ETag: %s) - object cache hit",
+                      req->bucket, req->key, res->body_len, res->etag);
+        return 1;
     }
     
+    return 0;
+}
+
+void buckets_s3_get_object_complete(buckets_s3_request_t *req, buckets_s3_response_t *res,
+                                    void *object_data, size_t object_size,
+                                    const buckets_xl_meta_t *meta, u64 cache_token)
+{
     /* Calculate ETag */
     buckets_s3_calculate_etag(object_data, object_size, res->etag);
     
@@ -349,30 +369,38 @@ int buckets_s3_get_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
     res->body_len = object_size;
     res->content_length = object_size;
     
-    /* Get metadata for content-type and user metadata */
-    buckets_xl_meta_t meta;
-    memset(&meta, 0, sizeof(meta));
+    /* Get metadata for content-type and user metadata, unless the caller
+     * already read it along with the object */
+    buckets_xl_meta_t head_meta;
+    memset(&head_meta, 0, sizeof(head_meta));
+    bool own_meta = false;
+    if (!meta && buckets_head_object(req->bucket, req->key, &head_meta) == 0) {
+        meta = &head_meta;
+        own_meta = true;
+    }
     
-    if (buckets_head_object(req->bucket, req->key, &meta) == 0) {
+    if (meta) {
         /* Set content type from metadata */
-        if (meta.meta.content_type && meta.meta.content_type[0] != '\0') {
-            strncpy(res->content_type, meta.meta.content_type, sizeof(res->content_type) - 1);
+        if (meta->meta.content_type && meta->meta.content_type[0] != '\0') {
+            strncpy(res->content_type, meta->meta.content_type, sizeof(res->content_type) - 1);
             res->content_type[sizeof(res->content_type) - 1] = '\0';
         } else {
             strcpy(res->content_type, "application/octet-stream");
         }
         
         /* Copy user metadata to response */
-        for (u32 i = 0; i < meta.meta.user_count && res->user_meta_count < BUCKETS_S3_MAX_USER_METADATA; i++) {
-            res->user_meta_keys[res->user_meta_count] = buckets_strdup(meta.meta.user_keys[i]);
-            res->user_meta_values[res->user_meta_count] = buckets_strdup(meta.meta.user_values[i]);
+        for (u32 i = 0; i < meta->meta.user_count && res->user_meta_count < BUCKETS_S3_MAX_USER_METADATA; i++) {
+            res->user_meta_keys[res->user_meta_count] = buckets_strdup(meta->meta.user_keys[i]);
+            res->user_meta_values[res->user_meta_count] = buckets_strdup(meta->meta.user_values[i]);
             res->user_meta_count++;
             buckets_debug("GET: returning user metadata: %s = %s", 
-                         meta.meta.user_keys[i], meta.meta.user_values[i]);
+                         meta->meta.user_keys[i], meta->meta.user_values[i]);
         }
         
         /* Free metadata (we've copied what we need) */
-        buckets_xl_meta_free(&meta);
+        if (own_meta) {
+            buckets_xl_meta_free(&head_meta);
+        }
     } else {
         /* Fallback - no metadata available */
         strcpy(res->content_type, "application/octet-stream");
@@ -381,9 +409,50 @@ int buckets_s3_get_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
     /* Format last modified time */
     buckets_s3_format_timestamp(time(NULL), res->last_modified);
     
+    /* Offer to the cache (copied; refused if a PUT/DELETE raced this read) */
+    if (buckets_object_cache_enabled()) {
+        buckets_cached_object_t entry = {
+            .data = res->body,
+            .size = res->body_len,
+            .content_type = res->content_type,
+            .user_keys = res->user_meta_keys,
+            .user_values = res->user_meta_values,
+            .user_count = (u32)res->user_meta_count,
+        };
+        snprintf(entry.etag, sizeof(entry.etag), "%s", res->etag);
+        buckets_object_cache_admit(req->bucket, req->key, &entry, cache_token);
+    }
+    
     buckets_info("GET object: %s/%s (%zu bytes, ETag: %s, user_meta=%d) - read from distributed storage",
                  req->bucket, req->key, res->body_len, res->etag, res->user_meta_count);
+}
+
+int buckets_s3_get_object(buckets_s3_request_t *req, buckets_s3_response_t *res)
+{
+    if (!req || !res) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    u64 cache_token = 0;
+    if (buckets_s3_get_object_prepare(req, res, &cache_token)) {
+        return BUCKETS_OK;
+    }
     
+    /* Use distributed storage layer */
+    void *object_data = NULL;
+    size_t object_size = 0;
+    
+    int ret = buckets_get_object_coalesced(req->bucket, req->key, NULL,
+                                           &object_data, &object_size);
+    if (ret != 0) {
+        /* Object not found or error */
+        buckets_s3_xml_error(res, "NoSuchKey",
+                            "The specified key does not exist",
+                            req->key);
+        return BUCKETS_OK;
+    }
+    
+    buckets_s3_get_object_complete(req, res, object_data, object_size, NULL, cache_token);
     return BUCKETS_OK;
 }
 
@@ -429,6 +498,8 @@ int buckets_s3_delete_object(buckets_s3_request_t *req, buckets_s3_response_t *r
     /* Release semaphore */
     sem_post(&g_delete_semaphore);
     
+    buckets_object_cache_publish_invalidation(req->bucket, req->key);
+    
     if (ret != 0) {
         /* Object might not exist - S3 DELETE is idempotent, so we still return 204 */
         buckets_debug("DELETE object (distributed): %s/%s - not found or error", 
@@ -0,0 +1,511 @@
+/**
+ * Per-Tenant QoS
+ *
+ * Hierarchical token buckets keyed by access key and bucket, built on the
+ * migration throttle (see buckets_s3.h). The HTTP server calls in at two
+ * points: admission once a request's headers are complete, and charging
+ * as body and response bytes move (see s3_streaming.c).
+ *
+ * Request buckets count milli-requests so low rates refill smoothly.
+ *
+ * Tenants live in a fixed table. A request holds a reference to its tenant
+ * until buckets_s3_qos_release; once the table is full, a tenant with no
+ * references and no bucket tenants under it that has been idle for
+ * idle_ms (its buckets long refilled) is evicted to make room.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "buckets.h"
+#include "buckets_s3.h"
+#include "buckets_hash.h"
+#include "buckets_migration.h"
+
+#define QOS_REQUEST_UNITS   1000    /* Tokens per request */
+#define QOS_HASH_BUCKETS    1024
+#define QOS_EVICT_SCAN      64      /* Tenants looked at per eviction */
+
+struct buckets_s3_qos_tenant {
+    buckets_throttle_t requests;
+    buckets_throttle_t bytes;
+    buckets_s3_qos_tenant_t *parent;   /* Access key totals (NULL for a key) */
+    buckets_s3_qos_tenant_t *next;     /* Hash chain */
+    char access_key[128];
+    char bucket[64];
+    u32 refs;                          /* Requests holding it (atomic) */
+    u32 children;                      /* Bucket tenants under a key */
+    u64 last_used_ms;                  /* Atomic */
+
+    /* Usage (atomic) */
+    u64 requests_admitted;
+    u64 rejected;
+    u64 throttled;
+    u64 bytes_in;
+    u64 bytes_out;
+};
+
+static struct {
+    bool enabled;
+    buckets_s3_qos_config_t config;
+    buckets_s3_qos_tenant_t *tenants;  /* BUCKETS_S3_QOS_MAX_TENANTS */
+    size_t count;
+    size_t hand;                       /* Eviction clock hand */
+    u64 evicted;
+    buckets_s3_qos_tenant_t *hash[QOS_HASH_BUCKETS];
+    buckets_s3_qos_tenant_t overflow;  /* Everyone past the table limit */
+} g_qos;
+
+static pthread_mutex_t g_qos_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ===================================================================
+ * Tenant Table (caller holds g_qos_lock)
+ * ===================================================================*/
+
+static u64 qos_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+static size_t tenant_slot(const char *access_key, const char *bucket)
+{
+    u64 h = buckets_xxhash64(0, access_key, strlen(access_key));
+    h = buckets_xxhash64(h, bucket, strlen(bucket));
+    return h % QOS_HASH_BUCKETS;
+}
+
+static void tenant_ref(buckets_s3_qos_tenant_t *t)
+{
+    __atomic_add_fetch(&t->refs, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&t->last_used_ms, qos_now_ms(), __ATOMIC_RELAXED);
+}
+
+static void tenant_unref(buckets_s3_qos_tenant_t *t)
+{
+    __atomic_store_n(&t->last_used_ms, qos_now_ms(), __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&t->refs, 1, __ATOMIC_ACQ_REL);
+}
+
+/* Unlink an idle tenant and hand back its entry, or NULL if none is idle */
+static buckets_s3_qos_tenant_t* tenant_evict(void)
+{
+    u64 now = qos_now_ms();
+    for (size_t i = 0; i < QOS_EVICT_SCAN && i < g_qos.count; i++) {
+        buckets_s3_qos_tenant_t *t = &g_qos.tenants[g_qos.hand];
+        g_qos.hand = (g_qos.hand + 1) % g_qos.count;
+
+        if (__atomic_load_n(&t->refs, __ATOMIC_ACQUIRE) != 0 || t->children != 0 ||
+            now - __atomic_load_n(&t->last_used_ms, __ATOMIC_RELAXED) < g_qos.config.idle_ms) {
+            continue;
+        }
+
+        size_t slot = tenant_slot(t->access_key, t->bucket);
+        for (buckets_s3_qos_tenant_t **pp = &g_qos.hash[slot]; *pp; pp = &(*pp)->next) {
+            if (*pp == t) {
+                *pp = t->next;
+                break;
+            }
+        }
+        if (t->parent) {
+            t->parent->children--;
+        }
+        buckets_throttle_cleanup(&t->requests);
+        buckets_throttle_cleanup(&t->bytes);
+        g_qos.evicted++;
+        return t;
+    }
+    return NULL;
+}
+
+static void tenant_init(buckets_s3_qos_tenant_t *t, const char *access_key,
+                        const char *bucket, buckets_s3_qos_tenant_t *parent)
+{
+    u32 rps = parent ? g_qos.config.bucket_rps : g_qos.config.key_rps;
+    u64 bps = parent ? g_qos.config.bucket_bps : g_qos.config.key_bps;
+
+    memset(t, 0, sizeof(*t));
+    snprintf(t->access_key, sizeof(t->access_key), "%s", access_key);
+    snprintf(t->bucket, sizeof(t->bucket), "%s", bucket);
+    t->parent = parent;
+    t->last_used_ms = qos_now_ms();
+
+    /* One second of burst at each level */
+    buckets_throttle_init(&t->requests, (i64)rps * QOS_REQUEST_UNITS,
+                          (i64)rps * QOS_REQUEST_UNITS);
+    buckets_throttle_init(&t->bytes, (i64)bps, (i64)bps);
+}
+
+static buckets_s3_qos_tenant_t* tenant_get(const char *access_key, const char *bucket,
+                                           buckets_s3_qos_tenant_t *parent)
+{
+    size_t slot = tenant_slot(access_key, bucket);
+
+    for (buckets_s3_qos_tenant_t *t = g_qos.hash[slot]; t; t = t->next) {
+        if (strcmp(t->access_key, access_key) == 0 && strcmp(t->bucket, bucket) == 0) {
+            return t;
+        }
+    }
+
+    buckets_s3_qos_tenant_t *t = NULL;
+    if (g_qos.count < BUCKETS_S3_QOS_MAX_TENANTS) {
+        t = &g_qos.tenants[g_qos.count++];
+    } else {
+        t = tenant_evict();
+    }
+    if (!t) {
+        return &g_qos.overflow;
+    }
+
+    tenant_init(t, access_key, bucket, parent);
+    if (parent) {
+        parent->children++;
+    }
+    t->next = g_qos.hash[slot];
+    g_qos.hash[slot] = t;
+    return t;
+}
+
+/* ===================================================================
+ * Initialization
+ * ===================================================================*/
+
+int buckets_s3_qos_init(const buckets_s3_qos_config_t *config)
+{
+    if (!config) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    buckets_s3_qos_cleanup();
+
+    bool enabled = config->key_rps || config->key_bps ||
+                   config->bucket_rps || config->bucket_bps;
+    if (!enabled) {
+        return BUCKETS_OK;
+    }
+
+    buckets_s3_qos_tenant_t *tenants = buckets_calloc(BUCKETS_S3_QOS_MAX_TENANTS,
+                                                      sizeof(*tenants));
+    if (!tenants) {
+        return BUCKETS_ERR_NOMEM;
+    }
+
+    pthread_mutex_lock(&g_qos_lock);
+    g_qos.config = *config;
+    if (g_qos.config.max_delay_ms == 0) {
+        g_qos.config.max_delay_ms = BUCKETS_S3_QOS_DEFAULT_MAX_DELAY_MS;
+    }
+    if (g_qos.config.idle_ms == 0) {
+        g_qos.config.idle_ms = BUCKETS_S3_QOS_DEFAULT_IDLE_MS;
+    }
+    g_qos.tenants = tenants;
+    g_qos.count = 0;
+    g_qos.hand = 0;
+    g_qos.evicted = 0;
+    memset(g_qos.hash, 0, sizeof(g_qos.hash));
+    tenant_init(&g_qos.overflow, "*", "", NULL);
+    g_qos.enabled = true;
+    pthread_mutex_unlock(&g_qos_lock);
+
+    buckets_info("Tenant QoS: %u req/s, %lu B/s per access key; %u req/s, %lu B/s per bucket "
+                 "(0 = unlimited, max delay %u ms)",
+                 config->key_rps, (unsigned long)config->key_bps,
+                 config->bucket_rps, (unsigned long)config->bucket_bps,
+                 g_qos.config.max_delay_ms);
+    return BUCKETS_OK;
+}
+
+static u64 env_u64(const char *name)
+{
+    const char *env = getenv(name);
+    if (!env) {
+        return 0;
+    }
+    long long v = atoll(env);
+    return v > 0 ? (u64)v : 0;
+}
+
+/* Split a limit between processes without rounding it down to unlimited */
+static u64 qos_share(u64 limit, u32 shares)
+{
+    if (limit == 0 || shares <= 1) {
+        return limit;
+    }
+    return limit / shares > 0 ? limit / shares : 1;
+}
+
+int buckets_s3_qos_init_from_env(u32 shares)
+{
+    buckets_s3_qos_config_t config = {0};
+    config.key_rps = (u32)qos_share(env_u64("BUCKETS_QOS_KEY_RPS"), shares);
+    config.key_bps = qos_share(env_u64("BUCKETS_QOS_KEY_MBPS") * 1024 * 1024, shares);
+    config.bucket_rps = (u32)qos_share(env_u64("BUCKETS_QOS_BUCKET_RPS"), shares);
+    config.bucket_bps = qos_share(env_u64("BUCKETS_QOS_BUCKET_MBPS") * 1024 * 1024, shares);
+    config.max_delay_ms = (u32)env_u64("BUCKETS_QOS_MAX_DELAY_MS");
+    config.idle_ms = (u32)env_u64("BUCKETS_QOS_IDLE_MS");
+
+    return buckets_s3_qos_init(&config);
+}
+
+void buckets_s3_qos_cleanup(void)
+{
+    pthread_mutex_lock(&g_qos_lock);
+    if (g_qos.enabled) {
+        for (size_t i = 0; i < g_qos.count; i++) {
+            buckets_throttle_cleanup(&g_qos.tenants[i].requests);
+            buckets_throttle_cleanup(&g_qos.tenants[i].bytes);
+        }
+        buckets_throttle_cleanup(&g_qos.overflow.requests);
+        buckets_throttle_cleanup(&g_qos.overflow.bytes);
+        buckets_free(g_qos.tenants);
+    }
+    memset(&g_qos, 0, sizeof(g_qos));
+    pthread_mutex_unlock(&g_qos_lock);
+}
+
+bool buckets_s3_qos_enabled(void)
+{
+    return g_qos.enabled;
+}
+
+/* ===================================================================
+ * Tenant Identification
+ * ===================================================================*/
+
+/* Copy up to the first of `stops` (or the end) */
+static void copy_until(char *out, size_t out_len, const char *src, const char *stops)
+{
+    size_t n = strcspn(src, stops);
+    if (n >= out_len) {
+        n = out_len - 1;
+    }
+    memcpy(out, src, n);
+    out[n] = '\0';
+}
+
+/* Find a query parameter's value in url */
+static const char* query_param(const char *url, const char *name)
+{
+    const char *q = strchr(url, '?');
+    size_t name_len = strlen(name);
+    while (q) {
+        q++;
+        if (strncmp(q, name, name_len) == 0 && q[name_len] == '=') {
+            return q + name_len + 1;
+        }
+        q = strchr(q, '&');
+    }
+    return NULL;
+}
+
+void buckets_s3_qos_identify(const char *authorization, const char *url,
+                             char *access_key, size_t access_key_len,
+                             char *bucket, size_t bucket_len)
+{
+    const char *p = NULL;
+    const char *stops = "";
+
+    if (authorization && (p = strstr(authorization, "Credential=")) != NULL) {
+        p += 11;
+        stops = "/, ";
+    } else if (authorization && strncmp(authorization, "AWS ", 4) == 0) {
+        p = authorization + 4;
+        stops = ":";
+    } else if (url && (p = query_param(url, "X-Amz-Credential")) != NULL) {
+        stops = "/%&";
+    } else if (url && (p = query_param(url, "AWSAccessKeyId")) != NULL) {
+        stops = "&";
+    }
+
+    if (p && *p && !strchr(stops, *p)) {
+        copy_until(access_key, access_key_len, p, stops);
+    } else {
+        copy_until(access_key, access_key_len, BUCKETS_S3_QOS_ANONYMOUS, "");
+    }
+
+    /* First path segment; "/_admin/..." and friends have no bucket */
+    const char *path = url ? url : "";
+    while (*path == '/') {
+        path++;
+    }
+    if (*path == '_') {
+        path = "";
+    }
+    copy_until(bucket, bucket_len, path, "/?");
+}
+
+void buckets_s3_qos_identify_client(const char *client_addr,
+                                    char *access_key, size_t access_key_len)
+{
+    if (client_addr && client_addr[0]) {
+        snprintf(access_key, access_key_len, "%s@%s", BUCKETS_S3_QOS_ANONYMOUS, client_addr);
+    } else {
+        copy_until(access_key, access_key_len, BUCKETS_S3_QOS_ANONYMOUS, "");
+    }
+}
+
+/* ===================================================================
+ * Admission and Charging
+ * ===================================================================*/
+
+/* Add to a usage counter of a tenant and its access key */
+#define QOS_COUNT(tenant, field, n) \
+    for (buckets_s3_qos_tenant_t *c_ = (tenant); c_; c_ = c_->parent) \
+        __atomic_add_fetch(&c_->field, (u64)(n), __ATOMIC_RELAXED)
+
+int buckets_s3_qos_admit(const char *access_key, const char *bucket,
+                         buckets_s3_qos_tenant_t **tenant)
+{
+    if (!access_key || !bucket || !tenant) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    *tenant = NULL;
+    if (!g_qos.enabled) {
+        return BUCKETS_OK;
+    }
+
+    pthread_mutex_lock(&g_qos_lock);
+    buckets_s3_qos_tenant_t *key = tenant_get(access_key, "", NULL);
+    buckets_s3_qos_tenant_t *t = key;
+    if (bucket[0] && key != &g_qos.overflow) {
+        /* Pinned so making room for the bucket cannot evict it */
+        tenant_ref(key);
+        t = tenant_get(access_key, bucket, key);
+        tenant_unref(key);
+    }
+    tenant_ref(t);
+    pthread_mutex_unlock(&g_qos_lock);
+
+    /* Too far behind on bandwidth: pacing alone would stall this request
+     * longer than the client should wait for an answer */
+    i64 max_delay_us = (i64)g_qos.config.max_delay_ms * 1000;
+    bool ok = true;
+    for (buckets_s3_qos_tenant_t *n = t; n && ok; n = n->parent) {
+        ok = buckets_throttle_charge(&n->bytes, 0) <= max_delay_us;
+    }
+
+    /* A request token at every level, or none taken */
+    buckets_s3_qos_tenant_t *taken = NULL;      /* Last level that gave one */
+    for (buckets_s3_qos_tenant_t *n = t; n && ok; n = n->parent) {
+        ok = buckets_throttle_try_consume(&n->requests, QOS_REQUEST_UNITS);
+        if (ok) {
+            taken = n;
+        }
+    }
+    if (!ok) {
+        for (buckets_s3_qos_tenant_t *r = t; taken && r; r = r->parent) {
+            buckets_throttle_charge(&r->requests, -QOS_REQUEST_UNITS);
+            if (r == taken) {
+                break;
+            }
+        }
+        QOS_COUNT(t, rejected, 1);
+        tenant_unref(t);
+        return BUCKETS_ERR_LIMIT;
+    }
+
+    QOS_COUNT(t, requests_admitted, 1);
+    *tenant = t;
+    return BUCKETS_OK;
+}
+
+int buckets_s3_qos_authenticate(buckets_s3_qos_tenant_t *admitted, const char *access_key,
+                                const char *bucket, buckets_s3_qos_tenant_t **tenant)
+{
+    if (!access_key || !bucket || !tenant) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    /* The request is the key's now: give the anonymous tenant its token back */
+    if (admitted) {
+        for (buckets_s3_qos_tenant_t *n = admitted; n; n = n->parent) {
+            buckets_throttle_charge(&n->requests, -QOS_REQUEST_UNITS);
+            __atomic_sub_fetch(&n->requests_admitted, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return buckets_s3_qos_admit(access_key, bucket, tenant);
+}
+
+void buckets_s3_qos_release(buckets_s3_qos_tenant_t *tenant)
+{
+    if (tenant) {
+        tenant_unref(tenant);
+    }
+}
+
+u64 buckets_s3_qos_charge(buckets_s3_qos_tenant_t *tenant, size_t bytes, bool inbound)
+{
+    if (!tenant || bytes == 0) {
+        return 0;
+    }
+
+    i64 debt_us = 0;
+    for (buckets_s3_qos_tenant_t *n = tenant; n; n = n->parent) {
+        i64 d = buckets_throttle_charge(&n->bytes, (i64)bytes);
+        if (d > debt_us) {
+            debt_us = d;
+        }
+    }
+
+    if (inbound) {
+        QOS_COUNT(tenant, bytes_in, bytes);
+    } else {
+        QOS_COUNT(tenant, bytes_out, bytes);
+    }
+    if (debt_us > 0) {
+        QOS_COUNT(tenant, throttled, 1);
+    }
+    return (u64)debt_us;
+}
+
+static void usage_copy(buckets_s3_qos_usage_t *u, const buckets_s3_qos_tenant_t *t)
+{
+    memcpy(u->access_key, t->access_key, sizeof(u->access_key));
+    memcpy(u->bucket, t->bucket, sizeof(u->bucket));
+    u->requests = __atomic_load_n(&t->requests_admitted, __ATOMIC_RELAXED);
+    u->rejected = __atomic_load_n(&t->rejected, __ATOMIC_RELAXED);
+    u->throttled = __atomic_load_n(&t->throttled, __ATOMIC_RELAXED);
+    u->bytes_in = __atomic_load_n(&t->bytes_in, __ATOMIC_RELAXED);
+    u->bytes_out = __atomic_load_n(&t->bytes_out, __ATOMIC_RELAXED);
+}
+
+size_t buckets_s3_qos_get_usage(buckets_s3_qos_usage_t *usage, size_t max)
+{
+    if (!usage) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_qos_lock);
+    size_t n = 0;
+
+    /* Evicted entries are reused, so a key's buckets can sit anywhere in
+     * the table: walk each key's children explicitly */
+    for (size_t i = 0; i < g_qos.count && n < max && g_qos.enabled; i++) {
+        const buckets_s3_qos_tenant_t *key = &g_qos.tenants[i];
+        if (key->parent) {
+            continue;
+        }
+        usage_copy(&usage[n++], key);
+        for (size_t j = 0; j < g_qos.count && n < max && key->children; j++) {
+            if (g_qos.tenants[j].parent == key) {
+                usage_copy(&usage[n++], &g_qos.tenants[j]);
+            }
+        }
+    }
+
+    /* The overflow tenant last, and only once used */
+    const buckets_s3_qos_tenant_t *o = &g_qos.overflow;
+    if (g_qos.enabled && n < max &&
+        (__atomic_load_n(&o->requests_admitted, __ATOMIC_RELAXED) != 0 ||
+         __atomic_load_n(&o->rejected, __ATOMIC_RELAXED) != 0)) {
+        usage_copy(&usage[n++], o);
+    }
+    pthread_mutex_unlock(&g_qos_lock);
+
+    return n;
+}
@@ -0,0 +1,330 @@
+/**
+ * Resumable S3 Object Handlers
+ *
+ * GET and HEAD of an object as a chain of stages on the async HTTP server
+ * (see "Resumable Async Handlers" in uv_server_internal.h) instead of one
+ * pool thread blocked for the whole request:
+ *
+ *   lookup  - auth, object cache, coalescing, xl.meta; forks one leg per
+ *             data shard (in the bulk lane for large objects)
+ *   decode  - forks legs for the remaining shards if a data shard was
+ *             missing (or the other copies if a replica was corrupt),
+ *             otherwise reconstructs and responds
+ *   joined  - for a request that joined an identical in-flight GET: parked
+ *             without a thread until the leader lands, then responds
+ *
+ * The storage calls are still blocking; each stage or leg holds a thread
+ * only for its own I/O.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+#include "buckets_mem_budget.h"
+#include "buckets_s3.h"
+#include "buckets_storage.h"
+#include "s3_streaming.h"
+
+typedef struct s3_get_stage s3_get_stage_t;
+
+/* One shard read forked from a stage */
+typedef struct {
+    s3_get_stage_t *get;
+    u32 index;
+} s3_shard_leg_t;
+
+struct s3_get_stage {
+    buckets_s3_request_t *req;
+    buckets_s3_response_t *res;
+    const char *method;             /* "GET" or "HEAD" */
+    u64 cache_token;
+
+    /* Leading a coalesced read (NULL when following or not coalescing) */
+    buckets_get_flight_t *flight;
+    buckets_object_read_t rd;
+    bool located;
+    bool parity_read;
+    s3_shard_leg_t legs[BUCKETS_MAX_CHUNKS];
+
+    /* Result handed over by the flight we joined */
+    uv_async_work_t *parked;
+    int joined_result;
+    void *joined_data;
+    size_t joined_size;
+};
+
+static pthread_once_t g_stages_once = PTHREAD_ONCE_INIT;
+static bool g_stages_enabled = true;
+
+static void stages_init_once(void)
+{
+    const char *env = getenv("BUCKETS_STAGED_HANDLERS");
+    if (env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0)) {
+        g_stages_enabled = false;
+        buckets_info("Resumable S3 object handlers disabled");
+    }
+}
+
+static bool has_query(const buckets_s3_request_t *req, const char *key)
+{
+    for (int i = 0; i < req->query_count; i++) {
+        if (req->query_params_keys[i] && strcmp(req->query_params_keys[i], key) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===================================================================
+ * Completion
+ * ===================================================================*/
+
+static void get_stage_free(s3_get_stage_t *get)
+{
+    if (get->located) {
+        buckets_object_read_free(&get->rd);
+    }
+    if (get->joined_data) {
+        buckets_free(get->joined_data);
+    }
+    buckets_s3_response_free(get->res);
+    buckets_s3_request_free(get->req);
+    buckets_free(get);
+}
+
+/* Buffer the response (sent once the last stage returns) and finish */
+static void get_stage_respond(uv_http_conn_t *conn, s3_get_stage_t *get)
+{
+    buckets_http_response_t http_res;
+    memset(&http_res, 0, sizeof(http_res));
+    buckets_s3_to_http_response(get->method, get->res, &http_res);
+    s3_send_http_response(conn, &http_res);
+    get_stage_free(get);
+}
+
+static void get_stage_not_found(uv_http_conn_t *conn, s3_get_stage_t *get)
+{
+    buckets_s3_xml_error(get->res, "NoSuchKey",
+                         "The specified key does not exist",
+                         get->req->key);
+    get_stage_respond(conn, get);
+}
+
+/* Hand the leader's result to its followers; keeps our own copy */
+static void get_stage_land(s3_get_stage_t *get, int result, void **data, size_t *size)
+{
+    if (get->flight) {
+        buckets_get_coalesce_land(get->flight, result, data, size);
+        get->flight = NULL;
+    }
+}
+
+/* ===================================================================
+ * Stages
+ * ===================================================================*/
+
+static void get_stage_decode(uv_http_conn_t *conn, void *ctx);
+static void get_stage_joined(uv_http_conn_t *conn, void *ctx);
+
+static void shard_leg(void *leg_ctx)
+{
+    s3_shard_leg_t *leg = (s3_shard_leg_t*)leg_ctx;
+    buckets_object_read_shard(&leg->get->rd, leg->index);
+}
+
+/* Fork a leg for every shard in [first, last) not read yet */
+static u32 fork_shard_legs(uv_http_conn_t *conn, s3_get_stage_t *get, u32 first, u32 last)
+{
+    u32 forked = 0;
+    for (u32 i = first; i < last; i++) {
+        if (get->rd.shards[i]) {
+            continue;
+        }
+        get->legs[i].get = get;
+        get->legs[i].index = i;
+        if (uv_http_async_fork(conn, shard_leg, &get->legs[i]) == BUCKETS_OK) {
+            forked++;
+        } else {
+            /* Out of memory: read it on this stage's thread instead */
+            buckets_object_read_shard(&get->rd, i);
+        }
+    }
+    return forked;
+}
+
+/* Delivered on the leader's thread when the flight we joined lands */
+static void on_flight_landed(void *arg, int result, void *data, size_t size)
+{
+    s3_get_stage_t *get = (s3_get_stage_t*)arg;
+    get->joined_result = result;
+    get->joined_data = data;
+    get->joined_size = size;
+    uv_http_async_resume(get->parked);
+}
+
+static void get_stage_lookup(uv_http_conn_t *conn, s3_get_stage_t *get)
+{
+    buckets_s3_request_t *req = get->req;
+
+    if (buckets_s3_get_object_prepare(req, get->res, &get->cache_token)) {
+        get_stage_respond(conn, get);
+        return;
+    }
+
+    /* Park before joining: the leader may land before join returns */
+    get->parked = uv_http_async_suspend(conn);
+    int joined = buckets_get_coalesce_join(req->bucket, req->key, NULL,
+                                           on_flight_landed, get, &get->flight);
+    if (joined == 1) {
+        uv_http_async_then(conn, get_stage_joined, get);
+        return;
+    }
+    /* Leading (or not coalescing): nothing to wait for but our own legs */
+    uv_http_async_resume(get->parked);
+    get->parked = NULL;
+
+    get->located = true;
+    if (buckets_object_read_locate(&get->rd, req->bucket, req->key) != 0) {
+        get_stage_land(get, -1, NULL, NULL);
+        get_stage_not_found(conn, get);
+        return;
+    }
+
+    /* Large objects read their shards in the bulk lane */
+    if (uv_http_is_bulk_size(conn, get->rd.meta.stat.size)) {
+        uv_http_async_set_lane(conn, UV_HTTP_LANE_BULK);
+    }
+
+    if (buckets_xl_meta_is_segmented(&get->rd.meta)) {
+        /* Segments are read in parallel by the decode, in its own stage so
+         * it runs in the bulk lane */
+        uv_http_async_then(conn, get_stage_decode, get);
+        return;
+    }
+
+    if (get->rd.k == 0) {
+        /* Inline object: everything is already in xl.meta */
+        get_stage_decode(conn, get);
+        return;
+    }
+
+    fork_shard_legs(conn, get, 0, get->rd.k);
+    uv_http_async_then(conn, get_stage_decode, get);
+}
+
+static void get_stage_decode(uv_http_conn_t *conn, void *ctx)
+{
+    s3_get_stage_t *get = (s3_get_stage_t*)ctx;
+    buckets_object_read_t *rd = &get->rd;
+
+    /* Skipped after a disconnect unless other readers wait on this flight */
+    bool give_up = uv_http_async_cancelled(conn) && !get->flight;
+
+    void *data = NULL;
+    size_t size = 0;
+    int ret = -1;
+    if (!give_up) {
+        if (buckets_object_read_shards_available(rd) >= rd->k) {
+            ret = buckets_object_read_decode(rd, &data, &size);
+        }
+        /* A data shard was missing, or a replica failed its checksum (and
+         * was dropped): fetch parity / the other copies once */
+        if (ret != 0 && rd->k > 0 && !get->parity_read) {
+            get->parity_read = true;
+            if (fork_shard_legs(conn, get, 0, rd->k + rd->m) > 0) {
+                uv_http_async_then(conn, get_stage_decode, get);
+                return;
+            }
+            ret = buckets_object_read_decode(rd, &data, &size);
+        }
+    }
+    get_stage_land(get, ret, &data, &size);
+    if (ret != 0) {
+        get_stage_not_found(conn, get);
+        return;
+    }
+
+    buckets_s3_get_object_complete(get->req, get->res, data, size,
+                                   &rd->meta, get->cache_token);
+    get_stage_respond(conn, get);
+}
+
+static void get_stage_joined(uv_http_conn_t *conn, void *ctx)
+{
+    s3_get_stage_t *get = (s3_get_stage_t*)ctx;
+
+    if (get->joined_result != 0) {
+        get_stage_not_found(conn, get);
+        return;
+    }
+
+    /* The leader made our copy; its memory is ours to answer for */
+    buckets_mem_budget_charge(get->joined_size);
+    void *data = get->joined_data;
+    get->joined_data = NULL;
+    buckets_s3_get_object_complete(get->req, get->res, data, get->joined_size,
+                                   NULL, get->cache_token);
+    get_stage_respond(conn, get);
+}
+
+/* ===================================================================
+ * Entry Point
+ * ===================================================================*/
+
+bool s3_object_stages_begin(uv_http_conn_t *conn, buckets_http_request_t *http_req,
+                            buckets_s3_request_t **accepted)
+{
+    *accepted = NULL;
+    pthread_once(&g_stages_once, stages_init_once);
+    if (!g_stages_enabled || !conn->async_work || !http_req->method || !http_req->uri) {
+        return false;
+    }
+
+    const char *method = http_req->method;
+    if (strcmp(method, "GET") != 0 && strcmp(method, "HEAD") != 0) {
+        return false;
+    }
+    /* /health, /rpc and /_admin/ are not objects */
+    if (strcmp(http_req->uri, "/health") == 0 || strcmp(http_req->uri, "/rpc") == 0 ||
+        strncmp(http_req->uri, "/_admin/", 8) == 0) {
+        return false;
+    }
+
+    buckets_http_response_t http_res;
+    memset(&http_res, 0, sizeof(http_res));
+    buckets_s3_request_t *req = NULL;
+    if (buckets_s3_accept_request(http_req, &http_res, &req) != BUCKETS_OK) {
+        s3_send_http_response(conn, &http_res);
+        return true;
+    }
+
+    if (req->bucket[0] == '\0' || req->key[0] == '\0' ||
+        has_query(req, "uploadId") || buckets_s3_has_version_id(req)) {
+        /* Handed back so the fallback does not parse and verify again */
+        *accepted = req;
+        return false;
+    }
+
+    s3_get_stage_t *get = buckets_calloc(1, sizeof(s3_get_stage_t));
+    buckets_s3_response_t *res = buckets_calloc(1, sizeof(buckets_s3_response_t));
+    if (!get || !res) {
+        buckets_free(get);
+        buckets_free(res);
+        *accepted = req;
+        return false;
+    }
+
+    /* http_req lives on this stage's stack only */
+    req->http_req = NULL;
+    get->req = req;
+    get->res = res;
+    get->method = strcmp(method, "HEAD") == 0 ? "HEAD" : "GET";
+
+    /* Already on a pool thread: run the first stage here */
+    get_stage_lookup(conn, get);
+    return true;
+}
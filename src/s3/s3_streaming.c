@@ -15,6 +15,7 @@
 #include "buckets_net.h"
 #include "buckets_storage.h"
 #include "buckets_crypto.h"
+#include "buckets_s3.h"
 #include "s3_streaming.h"
 #include "../net/uv_server_internal.h"  /* For uv_http_server_add_async_route */
 
@@ -551,6 +552,8 @@ int s3_stream_upload_complete(s3_stream_upload_t *upload)
         }
     }
     
+    buckets_object_cache_publish_invalidation(upload->bucket, upload->key);
+    
     /* Free metadata strings */
     if (meta.meta.content_type) {
         buckets_free(meta.meta.content_type);
@@ -721,6 +724,20 @@ int s3_stream_on_body_chunk(uv_stream_request_t *req,
     return s3_stream_upload_process(upload, data, len);
 }
 
+/* Pool-thread stage that commits a fully received upload */
+static void s3_stream_commit_stage(uv_http_conn_t *conn, void *ctx)
+{
+    s3_stream_upload_t *upload = (s3_stream_upload_t*)ctx;
+    
+    if (s3_stream_upload_complete(upload) == 0) {
+        send_put_success(conn, upload->etag, upload->version_id);
+    } else {
+        send_error_response(conn, 500, "Upload failed");
+    }
+    
+    s3_stream_upload_free(upload);
+}
+
 int s3_stream_on_request_complete(uv_stream_request_t *req, void *user_data)
 {
     (void)user_data;
@@ -730,7 +747,15 @@ int s3_stream_on_request_complete(uv_stream_request_t *req, void *user_data)
         return -1;
     }
     
-    /* Complete the upload synchronously in the event loop.
+    /* Encoding the tail and writing the shards blocks; hand the upload to a
+     * resumable handler so the event loop keeps serving other connections */
+    req->conn->stream_ctx = NULL;
+    if (uv_http_async_start(req->conn, s3_stream_commit_stage, upload) == BUCKETS_OK) {
+        return 0;
+    }
+    req->conn->stream_ctx = upload;
+    
+    /* Could not queue: complete the upload synchronously in the event loop.
      * 
      * NOTE: This works because buckets_get_bucket_versioning() has been optimized
      * to return immediately on cache miss (defaulting to "disabled"). The cache
@@ -813,37 +838,9 @@ int s3_streaming_init_default(void)
  * Legacy S3 Handler Wrapper (for non-streaming ops)
  * ===================================================================*/
 
-/**
- * Wrapper that adapts UV connection to buckets_http_request/response format
- * and calls the existing S3 handler
- */
-static void s3_legacy_uv_handler(uv_http_conn_t *conn, void *user_data)
+void s3_send_http_response(uv_http_conn_t *conn, buckets_http_response_t *http_res)
 {
-    (void)user_data;
-    
-    /* Build buckets_http_request_t from connection */
-    buckets_http_request_t http_req;
-    memset(&http_req, 0, sizeof(http_req));
-    
-    http_req.method = llhttp_method_name(llhttp_get_method(&conn->parser));
-    http_req.uri = conn->url;
-    http_req.query_string = strchr(conn->url, '?');
-    http_req.body = conn->body;
-    http_req.body_len = conn->body_len;
-    http_req.internal = conn;  /* For header access */
-    
-    /* Create response structure */
-    buckets_http_response_t http_res;
-    memset(&http_res, 0, sizeof(http_res));
-    
-    /* Call the S3 handler */
-    extern void buckets_s3_handler(buckets_http_request_t *req,
-                                    buckets_http_response_t *res,
-                                    void *user_data);
-    buckets_s3_handler(&http_req, &http_res, NULL);
-    
-    /* Send response using UV server API */
-    if (http_res.status_code > 0) {
+    if (http_res->status_code > 0) {
         /* Parse all headers from the headers string (format: "Name: value\r\n...") */
         /* Max 64 headers (32 name-value pairs) */
         const char *headers[64];
@@ -855,8 +852,8 @@ static void s3_legacy_uv_handler(uv_http_conn_t *conn, void *user_data)
         char header_values[32][512];
         int parsed_count = 0;
         
-        if (http_res.headers && http_res.headers[0] != '\0') {
-            const char *p = http_res.headers;
+        if (http_res->headers && http_res->headers[0] != '\0') {
+            const char *p = http_res->headers;
             
             while (*p && parsed_count < 32) {
                 /* Find the colon separating name from value */
@@ -904,25 +901,25 @@ static void s3_legacy_uv_handler(uv_http_conn_t *conn, void *user_data)
         }
         
         /* Default Content-Type if not set */
-        if (parsed_count == 0 && http_res.body_len > 0) {
+        if (parsed_count == 0 && http_res->body_len > 0) {
             headers[header_count++] = "Content-Type";
             headers[header_count++] = "application/xml";
         }
         
         headers[header_count] = NULL;
         
-        uv_http_response_start(conn, http_res.status_code, headers, header_count, 
-                               http_res.body_len);
+        uv_http_response_start(conn, http_res->status_code, headers, header_count, 
+                               http_res->body_len);
         
-        if (http_res.body && http_res.body_len > 0) {
+        if (http_res->body && http_res->body_len > 0) {
             /* Write large responses in chunks to avoid blocking */
             const size_t CHUNK_SIZE = 64 * 1024;  /* 64KB chunks */
             size_t offset = 0;
             
-            while (offset < http_res.body_len) {
-                size_t remaining = http_res.body_len - offset;
+            while (offset < http_res->body_len) {
+                size_t remaining = http_res->body_len - offset;
                 size_t write_size = (remaining < CHUNK_SIZE) ? remaining : CHUNK_SIZE;
-                uv_http_response_write(conn, (char*)http_res.body + offset, write_size);
+                uv_http_response_write(conn, (char*)http_res->body + offset, write_size);
                 offset += write_size;
             }
         }
@@ -936,12 +933,98 @@ static void s3_legacy_uv_handler(uv_http_conn_t *conn, void *user_data)
     }
     
     /* Free response body if allocated */
-    if (http_res.body) {
-        buckets_free(http_res.body);
+    if (http_res->body) {
+        buckets_free(http_res->body);
+    }
+    if (http_res->headers) {
+        buckets_free(http_res->headers);
+    }
+}
+
+/**
+ * Wrapper that adapts UV connection to buckets_http_request/response format
+ * and calls the existing S3 handler
+ */
+static void s3_legacy_uv_handler(uv_http_conn_t *conn, void *user_data)
+{
+    (void)user_data;
+    
+    /* Build buckets_http_request_t from connection */
+    buckets_http_request_t http_req;
+    memset(&http_req, 0, sizeof(http_req));
+    
+    http_req.method = llhttp_method_name(llhttp_get_method(&conn->parser));
+    http_req.uri = conn->url;
+    http_req.query_string = strchr(conn->url, '?');
+    http_req.body = conn->body;
+    http_req.body_len = conn->body_len;
+    http_req.internal = conn;  /* For header access */
+    
+    /* Object GET/HEAD run as resumable stages (s3_stages.c) */
+    buckets_s3_request_t *accepted = NULL;
+    if (s3_object_stages_begin(conn, &http_req, &accepted)) {
+        return;
+    }
+    
+    /* Create response structure */
+    buckets_http_response_t http_res;
+    memset(&http_res, 0, sizeof(http_res));
+    
+    /* Call the S3 handler (skipping parse and auth if the stages did them) */
+    if (accepted) {
+        buckets_s3_handle_accepted(&http_req, accepted, &http_res);
+    } else {
+        buckets_s3_handler(&http_req, &http_res, NULL);
+    }
+    
+    s3_send_http_response(conn, &http_res);
+}
+
+/* ===================================================================
+ * Tenant QoS Hooks
+ * ===================================================================*/
+
+static const char s3_slowdown_xml[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<Error>\n"
+    "  <Code>SlowDown</Code>\n"
+    "  <Message>Please reduce your request rate.</Message>\n"
+    "</Error>\n";
+
+static int s3_qos_admit(uv_http_conn_t *conn, void **tenant)
+{
+    char access_key[128];
+    char bucket[64];
+    if (buckets_s3_auth_enabled()) {
+        /* Unverified: charge the client; the handler moves the request
+         * onto its key once the signature checks out */
+        char addr[64];
+        bool have_addr = uv_http_get_client_addr(conn, addr, sizeof(addr)) == 0;
+        buckets_s3_qos_identify_client(have_addr ? addr : NULL,
+                                       access_key, sizeof(access_key));
+        bucket[0] = '\0';
+    } else {
+        buckets_s3_qos_identify(uv_http_get_header(conn, "Authorization"), conn->url,
+                                access_key, sizeof(access_key), bucket, sizeof(bucket));
     }
-    if (http_res.headers) {
-        buckets_free(http_res.headers);
+    
+    buckets_s3_qos_tenant_t *t = NULL;
+    if (buckets_s3_qos_admit(access_key, bucket, &t) != BUCKETS_OK) {
+        buckets_debug("SlowDown: %s/%s over its limit", access_key, bucket);
+        return 503;
     }
+    *tenant = t;
+    return 0;
+}
+
+static uint64_t s3_qos_charge(void *tenant, size_t bytes, bool inbound)
+{
+    return buckets_s3_qos_charge((buckets_s3_qos_tenant_t*)tenant, bytes, inbound);
+}
+
+static void s3_qos_release(void *tenant)
+{
+    buckets_s3_qos_release((buckets_s3_qos_tenant_t*)tenant);
 }
 
 int s3_streaming_register_handlers(uv_http_server_t *server)
@@ -1013,5 +1096,17 @@ int s3_streaming_register_handlers(uv_http_server_t *server)
     
     buckets_info("Registered ASYNC S3 handler for GET/DELETE/HEAD/LIST (runs in thread pool)");
     
+    if (buckets_s3_qos_enabled()) {
+        uv_http_qos_t qos = {
+            .admit = s3_qos_admit,
+            .charge = s3_qos_charge,
+            .release = s3_qos_release,
+            .refusal_body = s3_slowdown_xml,
+            .refusal_content_type = "application/xml",
+        };
+        uv_http_server_set_qos(server, &qos);
+        buckets_info("Per-tenant QoS enabled for S3 requests");
+    }
+    
     return BUCKETS_OK;
 }
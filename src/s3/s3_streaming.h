@@ -13,6 +13,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "buckets_s3.h"
 #include "../net/uv_server_internal.h"
 #include "../net/async_io.h"
 
@@ -202,6 +203,40 @@ int s3_stream_on_body_chunk(uv_stream_request_t *req,
 int s3_stream_on_request_complete(uv_stream_request_t *req, void *user_data);
 void s3_stream_on_request_error(uv_stream_request_t *req, int error, void *user_data);
 
+/**
+ * Send a buffered S3 handler response on a connection
+ * 
+ * Frees the response body and headers.
+ * 
+ * @param conn HTTP connection
+ * @param http_res Response built by buckets_s3_handler or a stage
+ */
+void s3_send_http_response(uv_http_conn_t *conn, buckets_http_response_t *http_res);
+
+/* ===================================================================
+ * Resumable Object Handlers
+ * ===================================================================*/
+
+/**
+ * Start a GET/HEAD object request as resumable stages
+ * 
+ * Called from the async default handler. Plain object GET and HEAD (no
+ * versionId, no multipart query) are parsed, authenticated and continued
+ * as stages that hold a pool thread only while their own shard reads run:
+ * data shards are fetched as parallel legs, parity only if one of them
+ * failed, and a request waiting on an identical in-flight GET parks without
+ * a thread. Disabled with BUCKETS_STAGED_HANDLERS=0.
+ * 
+ * @param conn HTTP connection (inside an async handler)
+ * @param http_req Request built from conn; only used during this call
+ * @param accepted Output: on false, the already authenticated request if
+ *                 parsing got that far (pass to buckets_s3_handle_accepted),
+ *                 else NULL (use buckets_s3_handler)
+ * @return true if the request was taken over
+ */
+bool s3_object_stages_begin(uv_http_conn_t *conn, buckets_http_request_t *http_req,
+                            buckets_s3_request_t **accepted);
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@
 #include "buckets.h"
 #include "buckets_s3.h"
 #include "buckets_storage.h"
+#include "buckets_shm_cache.h"
 #include "cJSON.h"
 
 /* ===================================================================
@@ -54,6 +55,10 @@ static versioning_cache_entry_t g_versioning_cache[VERSIONING_CACHE_SIZE];
 static pthread_rwlock_t g_versioning_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
 static bool g_versioning_cache_initialized = false;
 
+/* Shared copy used instead of the table above by forked workers, so a
+ * versioning change made through one worker is seen by all of them */
+static buckets_shm_cache_t *g_versioning_shared = NULL;
+
 static void versioning_cache_init(void)
 {
     if (g_versioning_cache_initialized) return;
@@ -72,6 +77,18 @@ static unsigned int versioning_cache_hash(const char *bucket)
 
 static bool versioning_cache_get(const char *bucket, bool *enabled, bool *suspended)
 {
+    if (g_versioning_shared) {
+        bool status[2];
+        u32 len = 0;
+        if (!buckets_shm_cache_get(g_versioning_shared, bucket, status,
+                                   sizeof(status), &len) || len != sizeof(status)) {
+            return false;
+        }
+        *enabled = status[0];
+        *suspended = status[1];
+        return true;
+    }
+    
     versioning_cache_init();
     
     unsigned int idx = versioning_cache_hash(bucket);
@@ -91,6 +108,12 @@ static bool versioning_cache_get(const char *bucket, bool *enabled, bool *suspen
 
 static void versioning_cache_put(const char *bucket, bool enabled, bool suspended)
 {
+    if (g_versioning_shared) {
+        bool status[2] = { enabled, suspended };
+        buckets_shm_cache_put(g_versioning_shared, bucket, status, sizeof(status));
+        return;
+    }
+    
     versioning_cache_init();
     
     unsigned int idx = versioning_cache_hash(bucket);
@@ -125,6 +148,17 @@ static void versioning_cache_put(const char *bucket, bool enabled, bool suspende
  * }
  */
 
+int buckets_s3_versioning_cache_share(void)
+{
+    if (g_versioning_shared) {
+        return BUCKETS_OK;
+    }
+    
+    g_versioning_shared = buckets_shm_cache_create("versioning", VERSIONING_CACHE_SIZE,
+                                                   255, 2 * sizeof(bool), 0);
+    return g_versioning_shared ? BUCKETS_OK : BUCKETS_ERR_NOMEM;
+}
+
 /**
  * Get versioning configuration file path
  */
@@ -380,8 +414,8 @@ int buckets_s3_get_object_version(buckets_s3_request_t *req,
     void *data = NULL;
     size_t size = 0;
     
-    int ret = buckets_get_object_by_version(req->bucket, req->key, version_id,
-                                             &data, &size);
+    int ret = buckets_get_object_coalesced(req->bucket, req->key, version_id,
+                                           &data, &size);
     
     if (ret == -2) {
         /* Delete marker - return 404 with special header */
@@ -435,6 +469,10 @@ int buckets_s3_delete_object_versioned(buckets_s3_request_t *req,
     if (version_id && strlen(version_id) > 0) {
         /* Hard delete specific version */
         int ret = buckets_delete_version(req->bucket, req->key, version_id);
+        
+        /* Deleting the latest version changes what GET returns */
+        buckets_object_cache_publish_invalidation(req->bucket, req->key);
+        
         if (ret != 0) {
             buckets_s3_xml_error(res, "NoSuchVersion",
                                 "The specified version does not exist",
@@ -457,6 +495,7 @@ int buckets_s3_delete_object_versioned(buckets_s3_request_t *req,
         char delete_marker_version[64];
         int ret = buckets_delete_object_versioned(req->bucket, req->key,
                                                    delete_marker_version);
+        buckets_object_cache_publish_invalidation(req->bucket, req->key);
         if (ret != 0) {
             buckets_s3_xml_error(res, "InternalError",
                                 "Failed to create delete marker",
@@ -1,43 +1,78 @@
 /**
  * Async Replication Implementation
- * 
- * Lock-free queue with background worker threads for async replication.
+ *
+ * Replicas are queued per destination peer and shipped in coalesced
+ * batches: a peer's batch is sent once it is full or its oldest entry has
+ * waited for the batching window. Each batch is one storage.writeXlMetaBatch
+ * RPC (or one local group commit), instead of one RPC per replica.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
 #include <unistd.h>
 
 #include "buckets.h"
 #include "async_replication.h"
 
-/* Maximum pending replications before blocking */
-#define MAX_QUEUE_SIZE 10000
+/* Maximum pending replicas before producers are pushed back */
+#define MAX_QUEUE_SIZE 32768
 
-/* Replication work item */
-typedef struct replication_work {
+/* Batching defaults (override with BUCKETS_REPL_BATCH_WINDOW_MS / _MAX) */
+#define DEFAULT_BATCH_WINDOW_MS 2
+#define DEFAULT_BATCH_MAX_ENTRIES 64
+#define BATCH_MAX_BYTES (1024 * 1024)
+
+/* How long a producer waits for queue space before giving up */
+#define ENQUEUE_WAIT_MS 100
+
+#define LOCAL_PEER "local"
+
+/* One replica (xl.meta copy for one disk) */
+typedef struct replication_entry {
     char *bucket;
     char *object;
-    char *object_path;
-    buckets_xl_meta_t meta;
-    buckets_placement_result_t *placement;
-    struct replication_work *next;
-} replication_work_t;
+    char *disk_path;
+    char *meta_json;
+    u64 enqueue_us;
+    struct replication_entry *next;
+} replication_entry_t;
+
+/* Pending replicas for one destination peer */
+typedef struct peer_queue {
+    char endpoint[256];             /* Node endpoint, or LOCAL_PEER */
+    replication_entry_t *head;
+    replication_entry_t *tail;
+    size_t count;
+    size_t bytes;
+    bool in_flight;                 /* A batch for this peer is being shipped */
+    struct peer_queue *next;
+} peer_queue_t;
 
 /* Replication queue */
 typedef struct {
-    replication_work_t *head;
-    replication_work_t *tail;
+    peer_queue_t *peers;
     pthread_mutex_t lock;
-    pthread_cond_t cond;
-    size_t count;
+    pthread_cond_t cond;            /* Workers: batch may be ready */
+    pthread_cond_t space_cond;      /* Producers: queue space freed */
+    size_t count;                   /* Pending replicas across peers */
+    size_t max_count;
+    u64 window_us;
+    size_t batch_max;
     bool shutdown;
-    
+
     /* Stats */
     size_t completed;
     size_t failed;
+    size_t dropped;
+    u64 batches;
+    u64 batched_entries;
+    u64 backpressure_waits;
+    u64 lag_sum_us;
+    u64 lag_max_us;
 } replication_queue_t;
 
 /* Worker thread pool */
@@ -49,58 +84,161 @@ typedef struct {
 
 static replication_pool_t g_replication_pool = {0};
 
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static u64 now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000 + (u64)ts.tv_nsec / 1000;
+}
+
+static void entry_free(replication_entry_t *e)
+{
+    buckets_free(e->bucket);
+    buckets_free(e->object);
+    buckets_free(e->disk_path);
+    buckets_free(e->meta_json);
+    buckets_free(e);
+}
+
+static size_t env_size(const char *name, size_t def)
+{
+    const char *env = getenv(name);
+    if (!env || env[0] == '\0') {
+        return def;
+    }
+    char *end = NULL;
+    unsigned long v = strtoul(env, &end, 10);
+    return (end != env && *end == '\0') ? (size_t)v : def;
+}
+
 /* ===================================================================
  * Queue Operations
  * ===================================================================*/
 
-static replication_work_t* dequeue_work(replication_queue_t *queue)
+static peer_queue_t* find_peer(replication_queue_t *queue, const char *endpoint)
 {
-    pthread_mutex_lock(&queue->lock);
-    
-    while (queue->head == NULL && !queue->shutdown) {
-        pthread_cond_wait(&queue->cond, &queue->lock);
+    for (peer_queue_t *p = queue->peers; p; p = p->next) {
+        if (strcmp(p->endpoint, endpoint) == 0) {
+            return p;
+        }
     }
-    
-    if (queue->shutdown && queue->head == NULL) {
-        pthread_mutex_unlock(&queue->lock);
-        return NULL;
+
+    peer_queue_t *p = buckets_calloc(1, sizeof(peer_queue_t));
+    snprintf(p->endpoint, sizeof(p->endpoint), "%s", endpoint);
+    p->next = queue->peers;
+    queue->peers = p;
+    return p;
+}
+
+static bool peer_ready(replication_queue_t *queue, peer_queue_t *p, u64 now)
+{
+    if (p->in_flight || p->count == 0) {
+        return false;
     }
-    
-    replication_work_t *work = queue->head;
-    queue->head = work->next;
-    if (queue->head == NULL) {
-        queue->tail = NULL;
+    return queue->shutdown ||
+           p->count >= queue->batch_max ||
+           p->bytes >= BATCH_MAX_BYTES ||
+           now - p->head->enqueue_us >= queue->window_us;
+}
+
+/**
+ * Take the next ready batch (caller holds lock)
+ *
+ * Returns NULL and sets *wait_us to the time until the earliest batch
+ * becomes ready (0 = nothing pending).
+ */
+static peer_queue_t* take_ready_batch(replication_queue_t *queue, replication_entry_t **batch,
+                                      size_t *batch_count, u64 *wait_us)
+{
+    u64 now = now_us();
+    *wait_us = 0;
+
+    for (peer_queue_t *p = queue->peers; p; p = p->next) {
+        if (peer_ready(queue, p, now)) {
+            /* Detach up to batch_max entries */
+            replication_entry_t *head = p->head;
+            replication_entry_t *last = head;
+            size_t n = 1;
+            size_t bytes = strlen(head->meta_json);
+            while (last->next && n < queue->batch_max && bytes < BATCH_MAX_BYTES) {
+                last = last->next;
+                bytes += strlen(last->meta_json);
+                n++;
+            }
+            p->head = last->next;
+            if (!p->head) {
+                p->tail = NULL;
+            }
+            last->next = NULL;
+            p->count -= n;
+            p->bytes -= bytes;
+            p->in_flight = true;
+
+            *batch = head;
+            *batch_count = n;
+            return p;
+        }
+
+        if (!p->in_flight && p->count > 0) {
+            u64 remaining = queue->window_us - (now - p->head->enqueue_us);
+            if (*wait_us == 0 || remaining < *wait_us) {
+                *wait_us = remaining;
+            }
+        }
     }
-    queue->count--;
-    
-    pthread_mutex_unlock(&queue->lock);
-    return work;
+    return NULL;
 }
 
-static int enqueue_work(replication_queue_t *queue, replication_work_t *work)
+static int enqueue_entries(replication_queue_t *queue, replication_entry_t **entries,
+                           char (*endpoints)[256], size_t n)
 {
     pthread_mutex_lock(&queue->lock);
-    
-    if (queue->count >= MAX_QUEUE_SIZE) {
-        pthread_mutex_unlock(&queue->lock);
-        buckets_warn("Replication queue full (%zu items), dropping replication", 
-                    queue->count);
-        return -1;
+
+    /* Backpressure: wait briefly for workers to drain before giving up */
+    if (queue->count + n > queue->max_count) {
+        queue->backpressure_waits++;
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += ENQUEUE_WAIT_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+
+        while (queue->count + n > queue->max_count && !queue->shutdown) {
+            if (pthread_cond_timedwait(&queue->space_cond, &queue->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (queue->count + n > queue->max_count || queue->shutdown) {
+            queue->dropped += n;
+            pthread_mutex_unlock(&queue->lock);
+            buckets_warn("Replication queue full (%zu replicas), dropping replication",
+                        queue->count);
+            return -1;
+        }
     }
-    
-    work->next = NULL;
-    
-    if (queue->tail) {
-        queue->tail->next = work;
-    } else {
-        queue->head = work;
+
+    for (size_t i = 0; i < n; i++) {
+        peer_queue_t *p = find_peer(queue, endpoints[i]);
+        replication_entry_t *e = entries[i];
+        e->next = NULL;
+        if (p->tail) {
+            p->tail->next = e;
+        } else {
+            p->head = e;
+        }
+        p->tail = e;
+        p->count++;
+        p->bytes += strlen(e->meta_json);
     }
-    queue->tail = work;
-    queue->count++;
-    
-    pthread_cond_signal(&queue->cond);
+    queue->count += n;
+
+    pthread_cond_broadcast(&queue->cond);
     pthread_mutex_unlock(&queue->lock);
-    
+
     return 0;
 }
 
@@ -108,61 +246,123 @@ static int enqueue_work(replication_queue_t *queue, replication_work_t *work)
  * Worker Thread
  * ===================================================================*/
 
+static void ship_batch(const char *endpoint, replication_entry_t *batch, size_t n,
+                       buckets_xl_meta_batch_item_t *items)
+{
+    size_t i = 0;
+    for (replication_entry_t *e = batch; e; e = e->next, i++) {
+        items[i].bucket = e->bucket;
+        items[i].object = e->object;
+        items[i].disk_path = e->disk_path;
+        items[i].meta_json = e->meta_json;
+        items[i].result = -1;
+    }
+
+    if (strcmp(endpoint, LOCAL_PEER) == 0) {
+        buckets_write_xl_meta_batch(items, n);
+    } else {
+        buckets_distributed_write_xlmeta_batch(endpoint, items, n);
+    }
+}
+
+/* Hand a failed replica to the heal queue for retry (checked against
+ * the target only: the committed copies are not tracked here) */
+static void heal_replica(const char *endpoint, const replication_entry_t *e)
+{
+    buckets_xl_meta_t meta;
+    if (buckets_xl_meta_from_json(e->meta_json, &meta) != 0) {
+        return;
+    }
+
+    char object_path[PATH_MAX];
+    buckets_compute_object_path(e->bucket, e->object, object_path, sizeof(object_path));
+    buckets_heal_queue_xl_meta(e->bucket, e->object, object_path, e->disk_path,
+                               strcmp(endpoint, LOCAL_PEER) == 0 ? NULL : endpoint, &meta, NULL);
+    buckets_xl_meta_free(&meta);
+}
+
 static void* replication_worker(void *arg)
 {
     replication_queue_t *queue = (replication_queue_t*)arg;
-    
+    buckets_xl_meta_batch_item_t *items = buckets_calloc(queue->batch_max,
+                                                         sizeof(buckets_xl_meta_batch_item_t));
+
     buckets_info("Replication worker thread started");
-    
+
+    pthread_mutex_lock(&queue->lock);
     while (1) {
-        replication_work_t *work = dequeue_work(queue);
-        if (!work) {
-            break;  /* Shutdown */
+        replication_entry_t *batch = NULL;
+        size_t n = 0;
+        u64 wait_us = 0;
+        peer_queue_t *peer = take_ready_batch(queue, &batch, &n, &wait_us);
+
+        if (!peer) {
+            if (queue->shutdown && queue->count == 0) {
+                break;
+            }
+            if (wait_us > 0) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += (time_t)(wait_us / 1000000);
+                deadline.tv_nsec += (long)(wait_us % 1000000) * 1000L;
+                deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+                deadline.tv_nsec %= 1000000000L;
+                pthread_cond_timedwait(&queue->cond, &queue->lock, &deadline);
+            } else {
+                pthread_cond_wait(&queue->cond, &queue->lock);
+            }
+            continue;
+        }
+
+        char endpoint[256];
+        snprintf(endpoint, sizeof(endpoint), "%s", peer->endpoint);
+        pthread_mutex_unlock(&queue->lock);
+
+        ship_batch(endpoint, batch, n, items);
+
+        u64 done = now_us();
+        size_t ok = 0;
+        u64 lag_sum = 0;
+        u64 lag_max = 0;
+        size_t i = 0;
+        for (replication_entry_t *e = batch; e; i++) {
+            replication_entry_t *next = e->next;
+            u64 lag = done - e->enqueue_us;
+            lag_sum += lag;
+            if (lag > lag_max) {
+                lag_max = lag;
+            }
+            if (items[i].result == 0) {
+                ok++;
+            } else {
+                buckets_warn("Async replication failed: %s/%s on %s:%s",
+                            e->bucket, e->object, endpoint, e->disk_path);
+                heal_replica(endpoint, e);
+            }
+            entry_free(e);
+            e = next;
         }
-        
-        /* Perform replication */
-        extern int buckets_parallel_write_metadata(const char *bucket,
-                                                   const char *object,
-                                                   const char *object_path,
-                                                   buckets_placement_result_t *placement,
-                                                   char **disk_paths,
-                                                   const buckets_xl_meta_t *base_meta,
-                                                   u32 num_disks,
-                                                   bool has_endpoints);
-        
-        bool has_endpoints = (work->placement && work->placement->disk_endpoints && 
-                             work->placement->disk_endpoints[0] && 
-                             work->placement->disk_endpoints[0][0] != '\0');
-        
-        int ret = buckets_parallel_write_metadata(work->bucket, work->object, 
-                                                  work->object_path,
-                                                  work->placement, 
-                                                  work->placement->disk_paths,
-                                                  &work->meta, 
-                                                  work->placement->disk_count, 
-                                                  has_endpoints);
-        
+
         pthread_mutex_lock(&queue->lock);
-        if (ret == 0) {
-            queue->completed++;
-            buckets_debug("Async replication succeeded: %s/%s (%zu completed)", 
-                         work->bucket, work->object, queue->completed);
-        } else {
-            queue->failed++;
-            buckets_warn("Async replication failed: %s/%s (%zu failed)", 
-                        work->bucket, work->object, queue->failed);
+        peer->in_flight = false;
+        queue->count -= n;
+        queue->completed += ok;
+        queue->failed += n - ok;
+        queue->batches++;
+        queue->batched_entries += n;
+        queue->lag_sum_us += lag_sum;
+        if (lag_max > queue->lag_max_us) {
+            queue->lag_max_us = lag_max;
         }
-        pthread_mutex_unlock(&queue->lock);
-        
-        /* Cleanup work item */
-        buckets_free(work->bucket);
-        buckets_free(work->object);
-        buckets_free(work->object_path);
-        buckets_xl_meta_free(&work->meta);
-        buckets_placement_free_result(work->placement);
-        buckets_free(work);
+        buckets_debug("Async replication batch: %zu/%zu replicas to %s", ok, n, endpoint);
+
+        /* Peer may have accumulated a full batch meanwhile; producers may be waiting */
+        pthread_cond_broadcast(&queue->cond);
+        pthread_cond_broadcast(&queue->space_cond);
     }
-    
+    pthread_mutex_unlock(&queue->lock);
+
+    buckets_free(items);
     buckets_info("Replication worker thread exiting");
     return NULL;
 }
@@ -176,55 +376,77 @@ int async_replication_init(int num_workers)
     if (num_workers <= 0) {
         num_workers = 4;  /* Default */
     }
-    
+
     memset(&g_replication_pool, 0, sizeof(g_replication_pool));
-    
-    pthread_mutex_init(&g_replication_pool.queue.lock, NULL);
-    pthread_cond_init(&g_replication_pool.queue.cond, NULL);
-    
+
+    replication_queue_t *queue = &g_replication_pool.queue;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    pthread_cond_init(&queue->space_cond, NULL);
+    queue->max_count = env_size("BUCKETS_REPL_QUEUE_MAX", MAX_QUEUE_SIZE);
+    queue->window_us = env_size("BUCKETS_REPL_BATCH_WINDOW_MS", DEFAULT_BATCH_WINDOW_MS) * 1000;
+    queue->batch_max = env_size("BUCKETS_REPL_BATCH_MAX", DEFAULT_BATCH_MAX_ENTRIES);
+    if (queue->batch_max == 0) {
+        queue->batch_max = 1;
+    } else if (queue->batch_max > BUCKETS_XL_META_BATCH_MAX) {
+        queue->batch_max = BUCKETS_XL_META_BATCH_MAX;   /* Peers reject larger batches */
+    }
+
     g_replication_pool.num_workers = num_workers;
     g_replication_pool.threads = buckets_calloc(num_workers, sizeof(pthread_t));
-    
+
     if (!g_replication_pool.threads) {
         return -1;
     }
-    
+
     /* Start worker threads */
     for (int i = 0; i < num_workers; i++) {
         int ret = pthread_create(&g_replication_pool.threads[i], NULL,
-                                replication_worker, &g_replication_pool.queue);
+                                replication_worker, queue);
         if (ret != 0) {
             buckets_error("Failed to create replication worker %d", i);
             /* Continue with fewer workers */
         }
     }
-    
-    buckets_info("Async replication initialized with %d workers", num_workers);
+
+    buckets_info("Async replication initialized with %d workers "
+                 "(batch window %lu ms, max %zu per batch, queue %zu)",
+                 num_workers, queue->window_us / 1000, queue->batch_max, queue->max_count);
     return 0;
 }
 
 void async_replication_shutdown(void)
 {
     replication_queue_t *queue = &g_replication_pool.queue;
-    
-    /* Signal shutdown */
+
+    /* Signal shutdown: workers flush remaining batches without waiting */
     pthread_mutex_lock(&queue->lock);
     queue->shutdown = true;
     pthread_cond_broadcast(&queue->cond);
+    pthread_cond_broadcast(&queue->space_cond);
     pthread_mutex_unlock(&queue->lock);
-    
+
     /* Wait for workers to finish */
     for (int i = 0; i < g_replication_pool.num_workers; i++) {
         if (g_replication_pool.threads[i]) {
             pthread_join(g_replication_pool.threads[i], NULL);
         }
     }
-    
-    buckets_info("Async replication shutdown complete (completed=%zu, failed=%zu)",
-                queue->completed, queue->failed);
-    
+
+    buckets_info("Async replication shutdown complete (completed=%zu, failed=%zu, batches=%lu)",
+                queue->completed, queue->failed, queue->batches);
+
+    peer_queue_t *p = queue->peers;
+    while (p) {
+        peer_queue_t *next = p->next;
+        buckets_free(p);
+        p = next;
+    }
+    queue->peers = NULL;
+
     pthread_mutex_destroy(&queue->lock);
     pthread_cond_destroy(&queue->cond);
+    pthread_cond_destroy(&queue->space_cond);
     buckets_free(g_replication_pool.threads);
 }
 
@@ -237,51 +459,58 @@ int async_replication_queue(const char *bucket,
     if (!bucket || !object || !object_path || !meta || !placement) {
         return -1;
     }
-    
-    /* Create work item */
-    replication_work_t *work = buckets_calloc(1, sizeof(replication_work_t));
-    if (!work) {
+
+    u32 n = placement->disk_count;
+    if (n == 0 || !g_replication_pool.threads) {
         return -1;
     }
-    
-    work->bucket = buckets_strdup(bucket);
-    work->object = buckets_strdup(object);
-    work->object_path = buckets_strdup(object_path);
-    
-    /* Deep copy metadata */
-    memcpy(&work->meta, meta, sizeof(buckets_xl_meta_t));
-    
-    /* Deep copy strings in metadata */
-    if (meta->bucket) work->meta.bucket = buckets_strdup(meta->bucket);
-    if (meta->object) work->meta.object = buckets_strdup(meta->object);
-    if (meta->inline_data) work->meta.inline_data = buckets_strdup(meta->inline_data);
-    if (meta->meta.content_type) work->meta.meta.content_type = buckets_strdup(meta->meta.content_type);
-    
-    /* Copy user metadata */
-    if (meta->meta.user_count > 0) {
-        work->meta.meta.user_keys = buckets_calloc(meta->meta.user_count, sizeof(char*));
-        work->meta.meta.user_values = buckets_calloc(meta->meta.user_count, sizeof(char*));
-        for (u32 i = 0; i < meta->meta.user_count; i++) {
-            work->meta.meta.user_keys[i] = buckets_strdup(meta->meta.user_keys[i]);
-            work->meta.meta.user_values[i] = buckets_strdup(meta->meta.user_values[i]);
+
+    /* One replica per disk, each carrying its own erasure index */
+    replication_entry_t **entries = buckets_calloc(n, sizeof(replication_entry_t*));
+    char (*endpoints)[256] = buckets_calloc(n, sizeof(*endpoints));
+    buckets_xl_meta_t replica = *meta;
+    u64 enqueued = now_us();
+
+    for (u32 i = 0; i < n; i++) {
+        const char *disk_endpoint = placement->disk_endpoints ? placement->disk_endpoints[i] : NULL;
+        if (!disk_endpoint || buckets_distributed_is_local_disk(disk_endpoint) ||
+            buckets_distributed_extract_node_endpoint(disk_endpoint, endpoints[i],
+                                                      sizeof(endpoints[i])) != 0) {
+            snprintf(endpoints[i], sizeof(endpoints[i]), "%s", LOCAL_PEER);
+        }
+
+        replica.erasure.index = i + 1;
+        replication_entry_t *e = buckets_calloc(1, sizeof(replication_entry_t));
+        e->bucket = buckets_strdup(bucket);
+        e->object = buckets_strdup(object);
+        e->disk_path = buckets_strdup(placement->disk_paths[i]);
+        e->meta_json = buckets_xl_meta_to_json(&replica);
+        e->enqueue_us = enqueued;
+        entries[i] = e;
+
+        if (!e->meta_json) {
+            for (u32 j = 0; j <= i; j++) {
+                entry_free(entries[j]);
+            }
+            buckets_free(entries);
+            buckets_free(endpoints);
+            return -1;
         }
     }
-    
-    /* Placement will be freed by worker, so caller must not free it */
-    work->placement = placement;
-    
-    /* Enqueue work */
-    if (enqueue_work(&g_replication_pool.queue, work) != 0) {
-        /* Queue full, cleanup */
-        buckets_free(work->bucket);
-        buckets_free(work->object);
-        buckets_free(work->object_path);
-        buckets_xl_meta_free(&work->meta);
-        buckets_free(work);
-        return -1;
+
+    int ret = enqueue_entries(&g_replication_pool.queue, entries, endpoints, n);
+    if (ret != 0) {
+        for (u32 i = 0; i < n; i++) {
+            entry_free(entries[i]);
+        }
+    } else {
+        /* Placement ownership was transferred to us; replicas no longer need it */
+        buckets_placement_free_result(placement);
     }
-    
-    return 0;
+
+    buckets_free(entries);
+    buckets_free(endpoints);
+    return ret;
 }
 
 void async_replication_stats(size_t *pending_out,
@@ -289,10 +518,49 @@ void async_replication_stats(size_t *pending_out,
                              size_t *failed_out)
 {
     replication_queue_t *queue = &g_replication_pool.queue;
-    
+
     pthread_mutex_lock(&queue->lock);
     if (pending_out) *pending_out = queue->count;
     if (completed_out) *completed_out = queue->completed;
     if (failed_out) *failed_out = queue->failed;
     pthread_mutex_unlock(&queue->lock);
 }
+
+void async_replication_get_metrics(async_replication_metrics_t *metrics)
+{
+    if (!metrics) {
+        return;
+    }
+    replication_queue_t *queue = &g_replication_pool.queue;
+
+    memset(metrics, 0, sizeof(*metrics));
+    if (!g_replication_pool.threads) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    metrics->pending = queue->count;
+    metrics->capacity = queue->max_count;
+    metrics->completed = queue->completed;
+    metrics->failed = queue->failed;
+    metrics->dropped = queue->dropped;
+    metrics->batches = queue->batches;
+    metrics->avg_batch_size = queue->batches ?
+        (double)queue->batched_entries / queue->batches : 0.0;
+    metrics->backpressure_waits = queue->backpressure_waits;
+    metrics->avg_lag_ms = queue->batched_entries ?
+        (double)queue->lag_sum_us / queue->batched_entries / 1000.0 : 0.0;
+    metrics->max_lag_ms = (double)queue->lag_max_us / 1000.0;
+
+    /* Age of the oldest replica still waiting */
+    u64 now = now_us();
+    for (peer_queue_t *p = queue->peers; p; p = p->next) {
+        if (p->head) {
+            double age_ms = (double)(now - p->head->enqueue_us) / 1000.0;
+            if (age_ms > metrics->oldest_pending_ms) {
+                metrics->oldest_pending_ms = age_ms;
+            }
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
@@ -3,6 +3,13 @@
  * 
  * Provides background replication of small objects after local write succeeds.
  * Allows fast responses while maintaining eventual consistency and redundancy.
+ * 
+ * Replicas are coalesced per destination peer and shipped as one
+ * storage.writeXlMetaBatch RPC per batch (one group commit on the peer).
+ * A peer's batch is sent when it reaches BUCKETS_REPL_BATCH_MAX entries
+ * (default 64) or its oldest entry has waited BUCKETS_REPL_BATCH_WINDOW_MS
+ * (default 2). The queue is bounded by BUCKETS_REPL_QUEUE_MAX replicas;
+ * producers wait briefly for space and then fail.
  */
 
 #ifndef BUCKETS_ASYNC_REPLICATION_H
@@ -39,8 +46,8 @@ void async_replication_shutdown(void);
  * @param object Object key
  * @param object_path Hashed object path
  * @param meta Object metadata to replicate
- * @param placement Placement info with target disks
- * @return 0 if queued successfully
+ * @param placement Placement info with target disks (freed on success)
+ * @return 0 if queued, -1 if the queue stayed full (caller keeps placement)
  */
 int async_replication_queue(const char *bucket,
                             const char *object,
@@ -51,14 +58,38 @@ int async_replication_queue(const char *bucket,
 /**
  * Get replication queue stats
  * 
- * @param pending_out Number of pending replications
- * @param completed_out Number of completed replications
- * @param failed_out Number of failed replications
+ * @param pending_out Number of pending replicas
+ * @param completed_out Number of completed replicas
+ * @param failed_out Number of failed replicas
  */
 void async_replication_stats(size_t *pending_out,
                              size_t *completed_out,
                              size_t *failed_out);
 
+/**
+ * Replication queue metrics
+ */
+typedef struct {
+    size_t pending;                 /* Replicas waiting or in flight */
+    size_t capacity;                /* Queue bound */
+    size_t completed;               /* Replicas written */
+    size_t failed;                  /* Replicas that failed (handed to heal queue) */
+    size_t dropped;                 /* Replicas rejected by backpressure */
+    u64 batches;                    /* Batches shipped */
+    double avg_batch_size;          /* Replicas per batch */
+    u64 backpressure_waits;         /* Producers that found the queue full */
+    double avg_lag_ms;              /* Enqueue to durable on replica */
+    double max_lag_ms;
+    double oldest_pending_ms;       /* Age of the oldest waiting replica */
+} async_replication_metrics_t;
+
+/**
+ * Get replication queue metrics
+ * 
+ * @param metrics Output
+ */
+void async_replication_get_metrics(async_replication_metrics_t *metrics);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,9 @@
  * Async Write Completion Implementation
  * 
  * Background worker threads that complete chunk writes after client ACK.
+ * Jobs are journaled (async_write_journal.c) before the ACK so they can be
+ * finished after a crash. A failed job is retried with backoff until it
+ * lands or a newer version of the object is found on a read quorum.
  */
 
 #include <stdio.h>
@@ -11,6 +14,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <errno.h>
+#include <limits.h>
 
 #include "buckets.h"
 #include "buckets_async_write.h"
@@ -22,6 +26,15 @@ static async_write_queue_t *g_async_queue = NULL;
 static uint64_t g_next_job_id = 1;
 static pthread_mutex_t g_job_id_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* Write-ahead journal (NULL when BUCKETS_ASYNC_JOURNAL=off) */
+static buckets_async_journal_t *g_journal = NULL;
+
+/* Jobs recovered at init, waiting for buckets_async_write_replay() */
+static async_write_job_t *g_recovered = NULL;
+static uint64_t g_replayed = 0;
+static uint64_t g_superseded = 0;
+static uint64_t g_discarded = 0;
+
 /* Get current time in microseconds */
 static uint64_t get_time_us(void)
 {
@@ -39,6 +52,187 @@ static uint64_t alloc_job_id(void)
     return id;
 }
 
+void buckets_async_write_job_free(async_write_job_t *job)
+{
+    if (!job) {
+        return;
+    }
+    
+    if (job->chunk_data) {
+        for (u32 i = 0; i < job->num_chunks; i++) {
+            buckets_free(job->chunk_data[i]);
+        }
+        buckets_free(job->chunk_data);
+    }
+    
+    if (job->placement) {
+        buckets_placement_free_result(job->placement);
+    }
+    
+    buckets_xl_meta_free(&job->meta);
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->cond);
+    buckets_free(job);
+}
+
+/* Append a job to the run queue (caller has already journaled it) */
+static void enqueue_job(async_write_queue_t *queue, async_write_job_t *job)
+{
+    job->next = NULL;
+    
+    pthread_mutex_lock(&queue->lock);
+    
+    if (queue->tail) {
+        queue->tail->next = job;
+    } else {
+        queue->head = job;
+    }
+    queue->tail = job;
+    queue->count++;
+    queue->total_queued++;
+    
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/* Read one xl.meta copy of the job's object (local disk or over RPC) */
+static int read_job_meta(const async_write_job_t *job, u32 i, buckets_xl_meta_t *meta)
+{
+    const buckets_placement_result_t *p = job->placement;
+    const char *endpoint = p->disk_endpoints ? p->disk_endpoints[i] : NULL;
+    
+    if (!endpoint || endpoint[0] == '\0' || buckets_distributed_is_local_disk(endpoint)) {
+        return buckets_read_xl_meta(p->disk_paths[i], job->object_path, meta);
+    }
+    
+    char node_endpoint[256];
+    if (buckets_distributed_extract_node_endpoint(endpoint, node_endpoint,
+                                                  sizeof(node_endpoint)) != 0) {
+        return -1;
+    }
+    extern int buckets_distributed_read_xlmeta(const char *peer_endpoint,
+                                               const char *bucket, const char *object,
+                                               const char *disk_path,
+                                               buckets_xl_meta_t *meta);
+    return buckets_distributed_read_xlmeta(node_endpoint, job->bucket, job->object,
+                                           p->disk_paths[i], meta);
+}
+
+/*
+ * True if the object's quorum xl.meta is at least as new as the job's:
+ * the newest version held by a read quorum (K) of the set's disks is
+ * newer, or is the job's own version (lost done record). A newer copy on
+ * fewer disks is an unacknowledged write and does not count.
+ */
+static bool job_superseded(const async_write_job_t *job)
+{
+    const buckets_placement_result_t *p = job->placement;
+    if (!p || p->disk_count == 0) {
+        return false;
+    }
+    
+    u32 n = p->disk_count;
+    char (*mod_times)[32] = buckets_calloc(n, sizeof(*mod_times));
+    char **etags = buckets_calloc(n, sizeof(char*));
+    bool *have = buckets_calloc(n, sizeof(bool));
+    
+    for (u32 i = 0; i < n; i++) {
+        buckets_xl_meta_t current;
+        memset(&current, 0, sizeof(current));
+        if (read_job_meta(job, i, &current) != 0) {
+            continue;  /* Missing or unreachable */
+        }
+        have[i] = true;
+        memcpy(mod_times[i], current.stat.modTime, sizeof(mod_times[i]));
+        etags[i] = current.meta.etag ? buckets_strdup(current.meta.etag) : NULL;
+        buckets_xl_meta_free(&current);
+    }
+    
+    u32 quorum = job->meta.erasure.data > 0 ? job->meta.erasure.data : n / 2 + 1;
+    int best = -1;
+    for (u32 i = 0; i < n; i++) {
+        if (!have[i]) {
+            continue;
+        }
+        u32 votes = 0;
+        for (u32 j = 0; j < n; j++) {
+            if (have[j] && strcmp(mod_times[i], mod_times[j]) == 0 &&
+                (etags[i] == etags[j] ||
+                 (etags[i] && etags[j] && strcmp(etags[i], etags[j]) == 0))) {
+                votes++;
+            }
+        }
+        if (votes >= quorum && (best < 0 || strcmp(mod_times[i], mod_times[best]) > 0)) {
+            best = (int)i;
+        }
+    }
+    
+    bool superseded = false;
+    if (best >= 0) {
+        int cmp = strcmp(mod_times[best], job->meta.stat.modTime);
+        bool same_etag = etags[best] && job->meta.meta.etag &&
+                         strcmp(etags[best], job->meta.meta.etag) == 0;
+        superseded = cmp > 0 || (cmp == 0 && same_etag);
+    }
+    
+    for (u32 i = 0; i < n; i++) {
+        buckets_free(etags[i]);
+    }
+    buckets_free(etags);
+    buckets_free(mod_times);
+    buckets_free(have);
+    return superseded;
+}
+
+/* Move retries whose backoff expired to the run queue; returns the
+ * earliest remaining deadline (0 if none). Caller holds queue->lock. */
+static uint64_t promote_retries_locked(async_write_queue_t *queue, uint64_t now)
+{
+    uint64_t earliest = 0;
+    async_write_job_t **pp = &queue->retry;
+    
+    while (*pp) {
+        async_write_job_t *job = *pp;
+        if (job->not_before_us > now) {
+            if (earliest == 0 || job->not_before_us < earliest) {
+                earliest = job->not_before_us;
+            }
+            pp = &job->next;
+            continue;
+        }
+        *pp = job->next;
+        queue->retry_count--;
+        
+        job->next = NULL;
+        if (queue->tail) {
+            queue->tail->next = job;
+        } else {
+            queue->head = job;
+        }
+        queue->tail = job;
+        queue->count++;
+    }
+    return earliest;
+}
+
+/* Park a failed job until its backoff expires */
+static void schedule_retry(async_write_queue_t *queue, async_write_job_t *job)
+{
+    job->attempts++;
+    uint64_t delay_ms = (uint64_t)ASYNC_WRITE_RETRY_BASE_MS << (job->attempts < 16 ? job->attempts - 1 : 15);
+    if (delay_ms > ASYNC_WRITE_RETRY_MAX_MS) {
+        delay_ms = ASYNC_WRITE_RETRY_MAX_MS;
+    }
+    job->not_before_us = get_time_us() + delay_ms * 1000;
+    
+    pthread_mutex_lock(&queue->lock);
+    job->next = queue->retry;
+    queue->retry = job;
+    queue->retry_count++;
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
 /* Worker thread function */
 static void* async_write_worker(void *arg)
 {
@@ -49,11 +243,23 @@ static void* async_write_worker(void *arg)
     while (1) {
         async_write_job_t *job = NULL;
         
-        /* Dequeue job */
+        /* Dequeue job (retries join the run queue once their backoff expires) */
         pthread_mutex_lock(&queue->lock);
         
-        while (queue->head == NULL && !queue->shutdown) {
-            pthread_cond_wait(&queue->cond, &queue->lock);
+        while (!queue->shutdown) {
+            uint64_t next_retry = promote_retries_locked(queue, get_time_us());
+            if (queue->head) {
+                break;
+            }
+            if (next_retry == 0) {
+                pthread_cond_wait(&queue->cond, &queue->lock);
+            } else {
+                struct timespec until = {
+                    .tv_sec = (time_t)(next_retry / 1000000),
+                    .tv_nsec = (long)(next_retry % 1000000) * 1000L
+                };
+                pthread_cond_timedwait(&queue->cond, &queue->lock, &until);
+            }
         }
         
         if (queue->shutdown && queue->head == NULL) {
@@ -72,6 +278,20 @@ static void* async_write_worker(void *arg)
         
         if (!job) continue;
         
+        /* A retry may have been overtaken by a newer PUT in the meantime */
+        if (job->attempts > 0 && job_superseded(job)) {
+            buckets_info("[ASYNC_WRITE] Job %lu (%s/%s) superseded before retry, dropping",
+                         job->job_id, job->bucket, job->object);
+            if (g_journal) {
+                buckets_async_journal_complete(g_journal, job->job_id);
+            }
+            pthread_mutex_lock(&queue->lock);
+            queue->total_superseded++;
+            pthread_mutex_unlock(&queue->lock);
+            buckets_async_write_job_free(job);
+            continue;
+        }
+        
         /* Process job */
         PROFILE_START(async_write_job);
         
@@ -126,6 +346,14 @@ static void* async_write_worker(void *arg)
         pthread_cond_broadcast(&job->cond);
         pthread_mutex_unlock(&job->lock);
         
+        /* GETs between the ACK and now may have cached the previous version */
+        buckets_object_cache_publish_invalidation(job->bucket, job->object);
+        
+        /* A failed job keeps its journal record and is retried with backoff */
+        if (result == 0 && g_journal) {
+            buckets_async_journal_complete(g_journal, job->job_id);
+        }
+        
         /* Update stats */
         pthread_mutex_lock(&queue->lock);
         if (result == 0) {
@@ -134,32 +362,79 @@ static void* async_write_worker(void *arg)
                         job->job_id, queue->total_completed);
         } else {
             queue->total_failed++;
-            buckets_error("[ASYNC_WRITE] Job %lu failed (total failures: %lu)",
-                         job->job_id, queue->total_failed);
+            buckets_error("[ASYNC_WRITE] Job %lu failed (attempt %u, total failures: %lu), "
+                          "retrying", job->job_id, job->attempts + 1, queue->total_failed);
         }
         pthread_mutex_unlock(&queue->lock);
         
-        /* Cleanup job resources */
-        for (u32 i = 0; i < job->num_chunks; i++) {
-            buckets_free(job->chunk_data[i]);
-        }
-        buckets_free(job->chunk_data);
-        
-        if (job->placement) {
-            buckets_placement_free_result(job->placement);
+        if (result != 0) {
+            schedule_retry(queue, job);
+            continue;
         }
         
-        buckets_xl_meta_free(&job->meta);
-        
-        pthread_mutex_destroy(&job->lock);
-        pthread_cond_destroy(&job->cond);
-        buckets_free(job);
+        /* Cleanup job resources */
+        buckets_async_write_job_free(job);
     }
     
     buckets_info("[ASYNC_WRITE] Worker thread exiting");
     return NULL;
 }
 
+/*
+ * Open the journal and collect the jobs it still owes. Without a usable
+ * journal pipelined ACK would lose acknowledged data on a crash, so init
+ * fails unless the journal was explicitly turned off.
+ */
+static int async_write_journal_init(void)
+{
+    char path[PATH_MAX];
+    const char *env = getenv("BUCKETS_ASYNC_JOURNAL");
+    
+    if (env && (strcmp(env, "off") == 0 || strcmp(env, "0") == 0)) {
+        buckets_warn("[ASYNC_WRITE] Journal disabled - acknowledged writes can be lost on crash");
+        return BUCKETS_OK;
+    }
+    
+    if (env && env[0] != '\0') {
+        snprintf(path, sizeof(path), "%s", env);
+    } else {
+        char data_dir[PATH_MAX - sizeof(BUCKETS_ASYNC_JOURNAL_FILE) - 1];
+        buckets_get_data_dir(data_dir, sizeof(data_dir));
+        snprintf(path, sizeof(path), "%s/%s", data_dir, BUCKETS_ASYNC_JOURNAL_FILE);
+    }
+    
+    async_write_job_t *pending = NULL;
+    size_t count = 0, discarded = 0;
+    if (buckets_async_journal_load(path, &pending, &count, &discarded) != BUCKETS_OK) {
+        buckets_error("[ASYNC_WRITE] Cannot read journal %s: %s", path, strerror(errno));
+        return BUCKETS_ERR_IO;
+    }
+    
+    g_journal = buckets_async_journal_open(path, pending);
+    if (!g_journal) {
+        while (pending) {
+            async_write_job_t *next = pending->next;
+            buckets_async_write_job_free(pending);
+            pending = next;
+        }
+        return BUCKETS_ERR_IO;
+    }
+    
+    /* Keep job ids unique against the records carried over */
+    for (async_write_job_t *job = pending; job; job = job->next) {
+        if (job->job_id >= g_next_job_id) {
+            g_next_job_id = job->job_id + 1;
+        }
+    }
+    
+    g_recovered = pending;
+    g_discarded = discarded;
+    if (count > 0) {
+        buckets_info("[ASYNC_WRITE] Recovered %zu unfinished jobs from journal", count);
+    }
+    return BUCKETS_OK;
+}
+
 int buckets_async_write_init(size_t num_workers)
 {
     if (g_async_queue) {
@@ -171,6 +446,11 @@ int buckets_async_write_init(size_t num_workers)
         num_workers = 4;  /* Default */
     }
     
+    int ret = async_write_journal_init();
+    if (ret != BUCKETS_OK) {
+        return ret;
+    }
+    
     g_async_queue = buckets_calloc(1, sizeof(*g_async_queue));
     if (!g_async_queue) {
         return BUCKETS_ERR_NOMEM;
@@ -230,27 +510,29 @@ void buckets_async_write_shutdown(void)
     
     buckets_free(g_async_queue->workers);
     
-    /* Free remaining jobs */
+    /* Free remaining jobs (still in the journal, replayed on next start) */
     async_write_job_t *job = g_async_queue->head;
     while (job) {
         async_write_job_t *next = job->next;
-        
-        for (u32 i = 0; i < job->num_chunks; i++) {
-            buckets_free(job->chunk_data[i]);
-        }
-        buckets_free(job->chunk_data);
-        
-        if (job->placement) {
-            buckets_placement_free_result(job->placement);
-        }
-        
-        buckets_xl_meta_free(&job->meta);
-        pthread_mutex_destroy(&job->lock);
-        pthread_cond_destroy(&job->cond);
-        buckets_free(job);
-        
+        buckets_async_write_job_free(job);
+        job = next;
+    }
+    job = g_async_queue->retry;
+    while (job) {
+        async_write_job_t *next = job->next;
+        buckets_async_write_job_free(job);
+        job = next;
+    }
+    job = g_recovered;
+    while (job) {
+        async_write_job_t *next = job->next;
+        buckets_async_write_job_free(job);
         job = next;
     }
+    g_recovered = NULL;
+    
+    buckets_async_journal_close(g_journal);
+    g_journal = NULL;
     
     pthread_mutex_destroy(&g_async_queue->lock);
     pthread_cond_destroy(&g_async_queue->cond);
@@ -277,7 +559,7 @@ int buckets_async_write_queue(const char *bucket,
     
     /* Check queue depth */
     pthread_mutex_lock(&g_async_queue->lock);
-    if (g_async_queue->count >= MAX_ASYNC_WRITES) {
+    if (g_async_queue->count + g_async_queue->retry_count >= MAX_ASYNC_WRITES) {
         pthread_mutex_unlock(&g_async_queue->lock);
         buckets_error("Async write queue full (%d jobs)", MAX_ASYNC_WRITES);
         return BUCKETS_ERR_NOMEM;
@@ -300,51 +582,42 @@ int buckets_async_write_queue(const char *bucket,
     job->num_chunks = num_chunks;
     job->placement = placement;
     
-    /* Copy metadata */
-    memcpy(&job->meta, meta, sizeof(*meta));
-    
-    /* Deep copy metadata strings */
-    if (meta->meta.content_type) {
-        job->meta.meta.content_type = buckets_strdup(meta->meta.content_type);
-    }
-    if (meta->meta.user_count > 0) {
-        job->meta.meta.user_keys = buckets_malloc(meta->meta.user_count * sizeof(char*));
-        job->meta.meta.user_values = buckets_malloc(meta->meta.user_count * sizeof(char*));
-        for (u32 i = 0; i < meta->meta.user_count; i++) {
-            job->meta.meta.user_keys[i] = buckets_strdup(meta->meta.user_keys[i]);
-            job->meta.meta.user_values[i] = buckets_strdup(meta->meta.user_values[i]);
-        }
-    }
-    if (meta->erasure.distribution) {
-        size_t dist_size = (meta->erasure.data + meta->erasure.parity) * sizeof(u32);
-        job->meta.erasure.distribution = buckets_malloc(dist_size);
-        memcpy(job->meta.erasure.distribution, meta->erasure.distribution, dist_size);
-    }
-    if (meta->erasure.checksums) {
-        size_t cs_size = (meta->erasure.data + meta->erasure.parity) * sizeof(buckets_checksum_t);
-        job->meta.erasure.checksums = buckets_malloc(cs_size);
-        memcpy(job->meta.erasure.checksums, meta->erasure.checksums, cs_size);
+    /* Deep copy metadata (all strings, checksums, inline data) */
+    char *meta_json = buckets_xl_meta_to_json(meta);
+    if (!meta_json || buckets_xl_meta_from_json(meta_json, &job->meta) != 0) {
+        buckets_free(meta_json);
+        buckets_free(job);
+        return BUCKETS_ERR_NOMEM;
     }
+    buckets_free(meta_json);
     
     job->state = ASYNC_WRITE_PENDING;
     job->queued_time_us = get_time_us();
     pthread_mutex_init(&job->lock, NULL);
     pthread_cond_init(&job->cond, NULL);
     
-    /* Enqueue */
-    pthread_mutex_lock(&g_async_queue->lock);
-    
-    if (g_async_queue->tail) {
-        g_async_queue->tail->next = job;
-    } else {
-        g_async_queue->head = job;
+    /* Journal and make durable before the caller ACKs */
+    if (g_journal) {
+        uint64_t seq = 0;
+        int ret = buckets_async_journal_append(g_journal, job, &seq);
+        if (ret == BUCKETS_OK) {
+            ret = buckets_async_journal_sync(g_journal, seq);
+            if (ret != BUCKETS_OK) {
+                /* Caller writes synchronously; a late-durable record is superseded */
+                buckets_async_journal_complete(g_journal, job->job_id);
+            }
+        }
+        if (ret != BUCKETS_OK) {
+            /* Chunks and placement stay with the caller for the sync path */
+            job->chunk_data = NULL;
+            job->placement = NULL;
+            buckets_async_write_job_free(job);
+            return ret;
+        }
     }
-    g_async_queue->tail = job;
-    g_async_queue->count++;
-    g_async_queue->total_queued++;
     
-    pthread_cond_signal(&g_async_queue->cond);
-    pthread_mutex_unlock(&g_async_queue->lock);
+    /* Enqueue */
+    enqueue_job(g_async_queue, job);
     
     buckets_info("[ASYNC_WRITE] Queued job %lu: %s/%s (%u chunks, queue_depth=%zu)",
                  job->job_id, bucket, object, num_chunks, g_async_queue->count);
@@ -374,3 +647,52 @@ void buckets_async_write_stats(uint64_t *queued, uint64_t *completed,
     if (queue_depth) *queue_depth = g_async_queue->count;
     pthread_mutex_unlock(&g_async_queue->lock);
 }
+
+int buckets_async_write_replay(void)
+{
+    if (!g_async_queue) {
+        return 0;
+    }
+    
+    async_write_job_t *job = g_recovered;
+    g_recovered = NULL;
+    int queued = 0;
+    
+    while (job) {
+        async_write_job_t *next = job->next;
+        
+        if (job_superseded(job)) {
+            /* Already applied (lost done record) or overwritten since */
+            buckets_info("[ASYNC_WRITE] Journal job %lu (%s/%s) already applied, dropping",
+                         job->job_id, job->bucket, job->object);
+            if (g_journal) {
+                buckets_async_journal_complete(g_journal, job->job_id);
+            }
+            buckets_async_write_job_free(job);
+            g_superseded++;
+        } else {
+            buckets_info("[ASYNC_WRITE] Replaying journal job %lu: %s/%s",
+                         job->job_id, job->bucket, job->object);
+            job->queued_time_us = get_time_us();
+            enqueue_job(g_async_queue, job);
+            g_replayed++;
+            queued++;
+        }
+        
+        job = next;
+    }
+    
+    return queued;
+}
+
+void buckets_async_write_journal_stats(buckets_async_journal_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    
+    buckets_async_journal_get_stats(g_journal, stats);
+    stats->replayed = g_replayed;
+    stats->superseded = g_superseded;
+    stats->discarded = g_discarded;
+}
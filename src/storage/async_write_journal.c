@@ -0,0 +1,681 @@
+/**
+ * Async Write Journal Implementation
+ *
+ * Local append-only write-ahead journal backing the pipelined-ACK queue.
+ *
+ * Record layout (host byte order, the file never leaves this node):
+ *   header  { magic, type, job_id, payload_len, payload_hash, header_hash }
+ *   payload { u32 json_len, json, chunk[0..num_chunks) }   (job records)
+ *
+ * The JSON carries names, placement and xl.meta; chunk bytes follow raw.
+ * Done records have no payload. A job is pending while it has a job record
+ * and no done record. The scan stops at the first record whose hashes do
+ * not verify - that is a torn append from a crash, and since the ACK only
+ * happens after fdatasync, nothing past it was ever acknowledged.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "buckets.h"
+#include "buckets_async_write.h"
+#include "buckets_hash.h"
+#include "buckets_placement.h"
+#include "buckets_storage.h"
+#include "cJSON.h"
+
+#define JOURNAL_MAGIC       0x4a574142U     /* "BAWJ" */
+#define JOURNAL_REC_JOB     1
+#define JOURNAL_REC_DONE    2
+#define JOURNAL_MAX_JSON    (1024 * 1024)
+
+typedef struct {
+    u32 magic;
+    u32 type;
+    u64 job_id;
+    u64 payload_len;
+    u64 payload_hash;           /* xxhash64 of payload */
+    u64 header_hash;            /* xxhash64 of the fields above */
+} journal_record_hdr_t;
+
+struct buckets_async_journal {
+    char *path;
+    int fd;
+    u64 max_bytes;
+
+    pthread_mutex_t lock;
+    pthread_cond_t sync_cond;
+    bool syncing;               /* A leader is inside fdatasync */
+    u64 appended_seq;           /* Last record appended */
+    u64 synced_seq;             /* Last record known durable */
+
+    buckets_async_journal_stats_t stats;
+};
+
+/* ===================================================================
+ * Record Encoding
+ * ===================================================================*/
+
+static u64 header_hash(const journal_record_hdr_t *hdr)
+{
+    return buckets_xxhash64(0, hdr, offsetof(journal_record_hdr_t, header_hash));
+}
+
+static void init_header(journal_record_hdr_t *hdr, u32 type, u64 job_id,
+                        u64 payload_len, u64 payload_hash)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = JOURNAL_MAGIC;
+    hdr->type = type;
+    hdr->job_id = job_id;
+    hdr->payload_len = payload_len;
+    hdr->payload_hash = payload_hash;
+    hdr->header_hash = header_hash(hdr);
+}
+
+/* Serialize everything but the chunk bytes */
+static char* job_to_json(const async_write_job_t *job)
+{
+    char *meta_json = buckets_xl_meta_to_json(&job->meta);
+    if (!meta_json) {
+        return NULL;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "bucket", job->bucket);
+    cJSON_AddStringToObject(root, "object", job->object);
+    cJSON_AddStringToObject(root, "objectPath", job->object_path);
+    cJSON_AddNumberToObject(root, "chunkSize", (double)job->chunk_size);
+    cJSON_AddNumberToObject(root, "numChunks", job->num_chunks);
+    cJSON_AddStringToObject(root, "meta", meta_json);
+    buckets_free(meta_json);
+
+    const buckets_placement_result_t *p = job->placement;
+    if (p) {
+        cJSON *pj = cJSON_AddObjectToObject(root, "placement");
+        cJSON_AddNumberToObject(pj, "pool", p->pool_idx);
+        cJSON_AddNumberToObject(pj, "set", p->set_idx);
+        cJSON_AddNumberToObject(pj, "generation", (double)p->generation);
+        cJSON *disks = cJSON_AddArrayToObject(pj, "disks");
+        for (u32 i = 0; i < p->disk_count; i++) {
+            cJSON *d = cJSON_CreateObject();
+            cJSON_AddStringToObject(d, "path", p->disk_paths && p->disk_paths[i] ?
+                                    p->disk_paths[i] : "");
+            cJSON_AddStringToObject(d, "uuid", p->disk_uuids && p->disk_uuids[i] ?
+                                    p->disk_uuids[i] : "");
+            cJSON_AddStringToObject(d, "endpoint", p->disk_endpoints && p->disk_endpoints[i] ?
+                                    p->disk_endpoints[i] : "");
+            cJSON_AddItemToArray(disks, d);
+        }
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static const char* json_string(const cJSON *obj, const char *key)
+{
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+static buckets_placement_result_t* placement_from_json(const cJSON *pj)
+{
+    const cJSON *disks = cJSON_GetObjectItem(pj, "disks");
+    if (!cJSON_IsArray(disks)) {
+        return NULL;
+    }
+
+    buckets_placement_result_t *p = buckets_calloc(1, sizeof(*p));
+    p->pool_idx = (u32)cJSON_GetNumberValue(cJSON_GetObjectItem(pj, "pool"));
+    p->set_idx = (u32)cJSON_GetNumberValue(cJSON_GetObjectItem(pj, "set"));
+    p->generation = (u64)cJSON_GetNumberValue(cJSON_GetObjectItem(pj, "generation"));
+    p->disk_count = (u32)cJSON_GetArraySize(disks);
+    p->disk_paths = buckets_calloc(p->disk_count, sizeof(char *));
+    p->disk_uuids = buckets_calloc(p->disk_count, sizeof(char *));
+    p->disk_endpoints = buckets_calloc(p->disk_count, sizeof(char *));
+
+    for (u32 i = 0; i < p->disk_count; i++) {
+        const cJSON *d = cJSON_GetArrayItem(disks, (int)i);
+        const char *path = json_string(d, "path");
+        const char *uuid = json_string(d, "uuid");
+        const char *endpoint = json_string(d, "endpoint");
+        p->disk_paths[i] = buckets_strdup(path ? path : "");
+        p->disk_uuids[i] = buckets_strdup(uuid ? uuid : "");
+        p->disk_endpoints[i] = buckets_strdup(endpoint ? endpoint : "");
+    }
+    return p;
+}
+
+/* Rebuild a job from its JSON; chunk_data is allocated but not filled */
+static async_write_job_t* job_from_json(u64 job_id, const char *json, size_t len)
+{
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!root) {
+        return NULL;
+    }
+
+    async_write_job_t *job = NULL;
+    const char *bucket = json_string(root, "bucket");
+    const char *object = json_string(root, "object");
+    const char *object_path = json_string(root, "objectPath");
+    const char *meta_json = json_string(root, "meta");
+    const cJSON *pj = cJSON_GetObjectItem(root, "placement");
+    double num_chunks = cJSON_GetNumberValue(cJSON_GetObjectItem(root, "numChunks"));
+    double chunk_size = cJSON_GetNumberValue(cJSON_GetObjectItem(root, "chunkSize"));
+
+    if (!bucket || !object || !object_path || !meta_json || !cJSON_IsObject(pj) ||
+        !(num_chunks >= 1 && num_chunks <= BUCKETS_MAX_CHUNKS) || !(chunk_size >= 0)) {
+        goto out;
+    }
+
+    job = buckets_calloc(1, sizeof(*job));
+    job->job_id = job_id;
+    snprintf(job->bucket, sizeof(job->bucket), "%s", bucket);
+    snprintf(job->object, sizeof(job->object), "%s", object);
+    snprintf(job->object_path, sizeof(job->object_path), "%s", object_path);
+    job->num_chunks = (u32)num_chunks;
+    job->chunk_size = (size_t)chunk_size;
+    job->state = ASYNC_WRITE_PENDING;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->cond, NULL);
+
+    job->placement = placement_from_json(pj);
+    job->chunk_data = buckets_calloc(job->num_chunks, sizeof(void *));
+
+    if (!job->placement || job->placement->disk_count < job->num_chunks ||
+        buckets_xl_meta_from_json(meta_json, &job->meta) != 0) {
+        buckets_async_write_job_free(job);
+        job = NULL;
+    }
+
+out:
+    cJSON_Delete(root);
+    return job;
+}
+
+/* ===================================================================
+ * Low-level I/O
+ * ===================================================================*/
+
+static int write_all_iov(int fd, struct iovec *iov, int iovcnt)
+{
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt > IOV_MAX ? IOV_MAX : iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+static int read_full(int fd, void *buf, size_t len)
+{
+    size_t off = 0;
+    while (off < len) {
+        ssize_t n = read(fd, (char *)buf + off, len - off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;  /* Short record: torn tail */
+        }
+        off += (size_t)n;
+    }
+    return 0;
+}
+
+/* Write a job record to fd; returns bytes written or -1 */
+static ssize_t write_job_record(int fd, const async_write_job_t *job)
+{
+    char *json = job_to_json(job);
+    if (!json) {
+        return -1;
+    }
+
+    u32 json_len = (u32)strlen(json);
+    u64 payload_len = sizeof(json_len) + json_len + (u64)job->num_chunks * job->chunk_size;
+
+    buckets_xxhash_state_t hs;
+    buckets_xxhash_init(&hs, 0);
+    buckets_xxhash_update(&hs, &json_len, sizeof(json_len));
+    buckets_xxhash_update(&hs, json, json_len);
+    for (u32 i = 0; i < job->num_chunks; i++) {
+        buckets_xxhash_update(&hs, job->chunk_data[i], job->chunk_size);
+    }
+
+    journal_record_hdr_t hdr;
+    init_header(&hdr, JOURNAL_REC_JOB, job->job_id, payload_len, buckets_xxhash_final(&hs));
+
+    struct iovec iov[3 + BUCKETS_MAX_CHUNKS];
+    int iovcnt = 0;
+    iov[iovcnt++] = (struct iovec){ &hdr, sizeof(hdr) };
+    iov[iovcnt++] = (struct iovec){ &json_len, sizeof(json_len) };
+    iov[iovcnt++] = (struct iovec){ json, json_len };
+    for (u32 i = 0; i < job->num_chunks && i < BUCKETS_MAX_CHUNKS; i++) {
+        iov[iovcnt++] = (struct iovec){ job->chunk_data[i], job->chunk_size };
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+    int rc = write_all_iov(fd, iov, iovcnt);
+    buckets_free(json);
+    return rc == 0 ? (ssize_t)(sizeof(hdr) + payload_len) : -1;
+}
+
+static int fsync_parent_dir(const char *path)
+{
+    char *copy = buckets_strdup(path);
+    int dfd = open(dirname(copy), O_RDONLY | O_DIRECTORY);
+    buckets_free(copy);
+    if (dfd < 0) {
+        return -1;
+    }
+    int rc = fsync(dfd);
+    close(dfd);
+    return rc;
+}
+
+/* ===================================================================
+ * Recovery
+ * ===================================================================*/
+
+/* Read one job payload; returns job or NULL if the record does not verify */
+static async_write_job_t* read_job_payload(int fd, const journal_record_hdr_t *hdr)
+{
+    u32 json_len;
+    if (hdr->payload_len < sizeof(json_len) || read_full(fd, &json_len, sizeof(json_len)) != 0 ||
+        json_len > JOURNAL_MAX_JSON || json_len > hdr->payload_len - sizeof(json_len)) {
+        return NULL;
+    }
+
+    char *json = buckets_malloc(json_len + 1);
+    if (read_full(fd, json, json_len) != 0) {
+        buckets_free(json);
+        return NULL;
+    }
+    json[json_len] = '\0';
+
+    buckets_xxhash_state_t hs;
+    buckets_xxhash_init(&hs, 0);
+    buckets_xxhash_update(&hs, &json_len, sizeof(json_len));
+    buckets_xxhash_update(&hs, json, json_len);
+
+    async_write_job_t *job = job_from_json(hdr->job_id, json, json_len);
+    buckets_free(json);
+    if (!job || sizeof(json_len) + json_len + (u64)job->num_chunks * job->chunk_size !=
+                hdr->payload_len) {
+        buckets_async_write_job_free(job);
+        return NULL;
+    }
+
+    for (u32 i = 0; i < job->num_chunks; i++) {
+        job->chunk_data[i] = buckets_malloc(job->chunk_size ? job->chunk_size : 1);
+        if (read_full(fd, job->chunk_data[i], job->chunk_size) != 0) {
+            buckets_async_write_job_free(job);
+            return NULL;
+        }
+        buckets_xxhash_update(&hs, job->chunk_data[i], job->chunk_size);
+    }
+
+    if (buckets_xxhash_final(&hs) != hdr->payload_hash) {
+        buckets_async_write_job_free(job);
+        return NULL;
+    }
+    return job;
+}
+
+int buckets_async_journal_load(const char *path, async_write_job_t **jobs_out,
+                               size_t *count_out, size_t *discarded_out)
+{
+    if (!path || !jobs_out || !count_out) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    *jobs_out = NULL;
+    *count_out = 0;
+    if (discarded_out) {
+        *discarded_out = 0;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT ? BUCKETS_OK : BUCKETS_ERR_IO;
+    }
+
+    struct stat st;
+    u64 file_size = (fstat(fd, &st) == 0) ? (u64)st.st_size : 0;
+    u64 offset = 0;
+    async_write_job_t *head = NULL, *tail = NULL;
+    size_t count = 0;
+
+    while (offset < file_size) {
+        journal_record_hdr_t hdr;
+        if (read_full(fd, &hdr, sizeof(hdr)) != 0 || hdr.magic != JOURNAL_MAGIC ||
+            hdr.header_hash != header_hash(&hdr) ||
+            hdr.payload_len > file_size - offset - sizeof(hdr)) {
+            break;
+        }
+
+        if (hdr.type == JOURNAL_REC_DONE) {
+            /* Drop the matching pending job */
+            async_write_job_t *prev = NULL;
+            for (async_write_job_t *j = head; j; prev = j, j = j->next) {
+                if (j->job_id == hdr.job_id) {
+                    if (prev) {
+                        prev->next = j->next;
+                    } else {
+                        head = j->next;
+                    }
+                    if (tail == j) {
+                        tail = prev;
+                    }
+                    buckets_async_write_job_free(j);
+                    count--;
+                    break;
+                }
+            }
+        } else if (hdr.type == JOURNAL_REC_JOB) {
+            async_write_job_t *job = read_job_payload(fd, &hdr);
+            if (!job) {
+                break;
+            }
+            job->next = NULL;
+            if (tail) {
+                tail->next = job;
+            } else {
+                head = job;
+            }
+            tail = job;
+            count++;
+        } else {
+            break;
+        }
+
+        offset += sizeof(hdr) + hdr.payload_len;
+    }
+
+    close(fd);
+
+    if (offset < file_size) {
+        buckets_warn("[ASYNC_WRITE] Journal %s: discarding %lu bytes of torn/corrupt "
+                     "records at offset %lu (never acknowledged)",
+                     path, file_size - offset, offset);
+        if (discarded_out) {
+            *discarded_out = 1;
+        }
+    }
+
+    *jobs_out = head;
+    *count_out = count;
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * Open / Close
+ * ===================================================================*/
+
+buckets_async_journal_t* buckets_async_journal_open(const char *path,
+                                                    const async_write_job_t *pending)
+{
+    if (!path) {
+        return NULL;
+    }
+
+    /* Rewrite pending jobs into a fresh file, then swap it in atomically */
+    char tmp_path[PATH_MAX];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.new", path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        buckets_error("[ASYNC_WRITE] Cannot create journal %s: %s", tmp_path, strerror(errno));
+        return NULL;
+    }
+
+    u64 size = 0, carried = 0;
+    for (const async_write_job_t *job = pending; job; job = job->next) {
+        ssize_t n = write_job_record(fd, job);
+        if (n < 0) {
+            buckets_error("[ASYNC_WRITE] Failed to carry job %lu into journal: %s",
+                          job->job_id, strerror(errno));
+            close(fd);
+            unlink(tmp_path);
+            return NULL;
+        }
+        size += (u64)n;
+        carried++;
+    }
+
+    if (fdatasync(fd) != 0 || rename(tmp_path, path) != 0 || fsync_parent_dir(path) != 0) {
+        buckets_error("[ASYNC_WRITE] Failed to install journal %s: %s", path, strerror(errno));
+        close(fd);
+        unlink(tmp_path);
+        return NULL;
+    }
+    close(fd);
+
+    fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) {
+        buckets_error("[ASYNC_WRITE] Cannot open journal %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    buckets_async_journal_t *journal = buckets_calloc(1, sizeof(*journal));
+    journal->path = buckets_strdup(path);
+    journal->fd = fd;
+    journal->stats.size_bytes = size;
+    journal->stats.pending = carried;
+
+    u64 max_mb = BUCKETS_ASYNC_JOURNAL_DEFAULT_MAX_MB;
+    const char *env = getenv("BUCKETS_ASYNC_JOURNAL_MAX_MB");
+    if (env && atoll(env) > 0) {
+        max_mb = (u64)atoll(env);
+    }
+    journal->max_bytes = max_mb * 1024 * 1024;
+
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->sync_cond, NULL);
+
+    buckets_info("[ASYNC_WRITE] Journal %s opened (%lu pending jobs, %lu bytes, cap %lu MB)",
+                 path, carried, size, max_mb);
+    return journal;
+}
+
+void buckets_async_journal_close(buckets_async_journal_t *journal)
+{
+    if (!journal) {
+        return;
+    }
+
+    if (fdatasync(journal->fd) != 0) {
+        buckets_warn("[ASYNC_WRITE] Journal sync on close failed: %s", strerror(errno));
+    }
+    close(journal->fd);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_cond_destroy(&journal->sync_cond);
+    buckets_free(journal->path);
+    buckets_free(journal);
+}
+
+/* ===================================================================
+ * Append / Sync / Complete
+ * ===================================================================*/
+
+int buckets_async_journal_append(buckets_async_journal_t *journal,
+                                 const async_write_job_t *job, uint64_t *seq_out)
+{
+    if (!journal || !job || job->num_chunks > BUCKETS_MAX_CHUNKS) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    u64 record_size = sizeof(journal_record_hdr_t) + sizeof(u32) +
+                      (u64)job->num_chunks * job->chunk_size;
+
+    pthread_mutex_lock(&journal->lock);
+
+    if (journal->stats.size_bytes + record_size > journal->max_bytes) {
+        pthread_mutex_unlock(&journal->lock);
+        buckets_warn("[ASYNC_WRITE] Journal full (%lu bytes, %lu pending)",
+                     journal->stats.size_bytes, journal->stats.pending);
+        return BUCKETS_ERR_NOMEM;
+    }
+
+    ssize_t n = write_job_record(journal->fd, job);
+    if (n < 0) {
+        /* Cut off the partial record so later appends stay readable */
+        int saved = errno;
+        if (ftruncate(journal->fd, (off_t)journal->stats.size_bytes) != 0) {
+            buckets_error("[ASYNC_WRITE] Journal truncate after failed append: %s",
+                          strerror(errno));
+        }
+        pthread_mutex_unlock(&journal->lock);
+        buckets_error("[ASYNC_WRITE] Journal append failed for job %lu: %s",
+                      job->job_id, strerror(saved));
+        return BUCKETS_ERR_IO;
+    }
+
+    journal->stats.size_bytes += (u64)n;
+    journal->stats.bytes_written += (u64)n;
+    journal->stats.appends++;
+    journal->stats.pending++;
+    u64 seq = ++journal->appended_seq;
+
+    pthread_mutex_unlock(&journal->lock);
+
+    if (seq_out) {
+        *seq_out = seq;
+    }
+    return BUCKETS_OK;
+}
+
+int buckets_async_journal_sync(buckets_async_journal_t *journal, uint64_t seq)
+{
+    if (!journal) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    int result = BUCKETS_OK;
+    pthread_mutex_lock(&journal->lock);
+
+    while (journal->synced_seq < seq) {
+        if (journal->syncing) {
+            /* Someone is already syncing; their fdatasync may cover us */
+            pthread_cond_wait(&journal->sync_cond, &journal->lock);
+            continue;
+        }
+
+        /* Become the leader: one fdatasync for everything appended so far */
+        journal->syncing = true;
+        u64 target = journal->appended_seq;
+        pthread_mutex_unlock(&journal->lock);
+
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+        int rc = fdatasync(journal->fd);
+        int saved = errno;
+
+        pthread_mutex_lock(&journal->lock);
+        journal->syncing = false;
+        journal->stats.syncs++;
+        if (rc == 0 && target > journal->synced_seq) {
+            journal->synced_seq = target;
+        }
+        pthread_cond_broadcast(&journal->sync_cond);
+
+        if (rc != 0) {
+            buckets_error("[ASYNC_WRITE] Journal fdatasync failed: %s", strerror(saved));
+            result = BUCKETS_ERR_IO;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+    return result;
+}
+
+int buckets_async_journal_complete(buckets_async_journal_t *journal, uint64_t job_id)
+{
+    if (!journal) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    journal_record_hdr_t hdr;
+    init_header(&hdr, JOURNAL_REC_DONE, job_id, 0, buckets_xxhash64(0, NULL, 0));
+
+    pthread_mutex_lock(&journal->lock);
+
+    if (journal->stats.pending > 0) {
+        journal->stats.pending--;
+    }
+    journal->stats.completions++;
+
+    /* Idle and large: nothing in the file is needed any more */
+    if (journal->stats.pending == 0 && !journal->syncing &&
+        journal->stats.size_bytes >= BUCKETS_ASYNC_JOURNAL_COMPACT_BYTES) {
+        if (ftruncate(journal->fd, 0) == 0) {
+            journal->stats.size_bytes = 0;
+            journal->stats.compactions++;
+            pthread_mutex_unlock(&journal->lock);
+            return BUCKETS_OK;
+        }
+        buckets_warn("[ASYNC_WRITE] Journal compaction failed: %s", strerror(errno));
+    }
+
+    struct iovec iov = { &hdr, sizeof(hdr) };
+    int result = BUCKETS_OK;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+    if (write_all_iov(journal->fd, &iov, 1) != 0) {
+        if (ftruncate(journal->fd, (off_t)journal->stats.size_bytes) != 0) {
+            buckets_error("[ASYNC_WRITE] Journal truncate after failed append: %s",
+                          strerror(errno));
+        }
+        buckets_warn("[ASYNC_WRITE] Journal done record for job %lu failed: %s "
+                     "(job will be replayed on restart)", job_id, strerror(errno));
+        result = BUCKETS_ERR_IO;
+    } else {
+        journal->stats.size_bytes += sizeof(hdr);
+        journal->stats.bytes_written += sizeof(hdr);
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+    return result;
+}
+
+void buckets_async_journal_get_stats(buckets_async_journal_t *journal,
+                                     buckets_async_journal_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!journal) {
+        return;
+    }
+
+    pthread_mutex_lock(&journal->lock);
+    *stats = journal->stats;
+    pthread_mutex_unlock(&journal->lock);
+}
@@ -201,7 +201,8 @@ int buckets_binary_batch_write_chunks(const char *peer_endpoint,
     
     size_t total_sent = 0;
     while (total_sent < total_to_send) {
-        ssize_t n = writev(fd, iov, iov_count);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SEND);
+        ssize_t n = buckets_peer_writev(fd, iov, iov_count);
         if (n < 0) {
             if (errno == EINTR) continue;
             buckets_error("[BATCH_WRITE] writev failed: %s", strerror(errno));
@@ -243,7 +244,8 @@ int buckets_binary_batch_write_chunks(const char *peer_endpoint,
     char *headers_end = NULL;
     
     while (resp_len < sizeof(response) - 1) {
-        ssize_t n = recv(fd, response + resp_len, sizeof(response) - resp_len - 1, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t n = buckets_peer_recv(fd, response + resp_len, sizeof(response) - resp_len - 1);
         if (n <= 0) {
             buckets_error("[BATCH_WRITE] Failed to receive response");
             close_tcp_connection(fd);
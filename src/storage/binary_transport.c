@@ -141,6 +141,8 @@ void cache_connection(int fd, const char *host, int port)
     /* No empty slot, replace oldest */
     pthread_mutex_lock(&g_conn_cache[oldest_slot].lock);
     if (g_conn_cache[oldest_slot].fd >= 0) {
+        buckets_peer_tls_close(g_conn_cache[oldest_slot].fd);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         close(g_conn_cache[oldest_slot].fd);
         DEBUG_DEC(g_stats.conn_pool_active);
     }
@@ -217,6 +219,8 @@ static char* url_decode(const char *str)
 void close_tcp_connection(int fd)
 {
     if (fd >= 0) {
+        buckets_peer_tls_close(fd);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         close(fd);
         DEBUG_DEC(g_stats.conn_pool_active);
     }
@@ -247,6 +251,7 @@ int create_tcp_connection(const char *host, int port)
     }
     
     for (rp = result; rp != NULL; rp = rp->ai_next) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SOCKET);
         fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
         if (fd == -1) continue;
         
@@ -267,17 +272,26 @@ int create_tcp_connection(const char *host, int port)
         setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
         setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
         
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CONNECT);
         if (connect(fd, rp->ai_addr, rp->ai_addrlen) == 0) {
             break;  /* Success */
         }
         
         buckets_warn("[TCP_CONNECT] connect() failed for %s:%d: %s", host, port, strerror(errno));
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         close(fd);  /* Don't use close_tcp_connection here - connection never succeeded */
         fd = -1;
     }
     
     freeaddrinfo(result);
     
+    /* Mutual TLS when the cluster runs encrypted peer transport */
+    if (fd != -1 && buckets_peer_tls_connect(fd, host, port) != BUCKETS_OK) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+        close(fd);
+        fd = -1;
+    }
+    
     if (fd == -1) {
         buckets_error("[TCP_CONNECT] Failed to connect to %s:%d after all attempts", host, port);
         DEBUG_INC(g_stats.conn_pool_failures);
@@ -304,7 +318,8 @@ static int send_all(int fd, const void *data, size_t len)
     size_t remaining = len;
     
     while (remaining > 0) {
-        ssize_t sent = send(fd, ptr, remaining, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_SEND);
+        ssize_t sent = buckets_peer_send(fd, ptr, remaining);
         if (sent < 0) {
             if (errno == EINTR) continue;
             buckets_error("send failed: %s", strerror(errno));
@@ -329,7 +344,8 @@ static int recv_all(int fd, void *data, size_t len)
     size_t remaining = len;
     
     while (remaining > 0) {
-        ssize_t received = recv(fd, ptr, remaining, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t received = buckets_peer_recv(fd, ptr, remaining);
         if (received < 0) {
             if (errno == EINTR) continue;
             buckets_error("recv failed: %s", strerror(errno));
@@ -520,7 +536,8 @@ int buckets_binary_write_chunk(const char *peer_endpoint,
     char *headers_end = NULL;
     
     while (resp_len < sizeof(response) - 1) {
-        ssize_t n = recv(fd, response + resp_len, sizeof(response) - resp_len - 1, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t n = buckets_peer_recv(fd, response + resp_len, sizeof(response) - resp_len - 1);
         if (n <= 0) {
             buckets_error("[BINARY_WRITE] chunk=%u failed to receive response", chunk_index);
             close_tcp_connection(fd);
@@ -646,7 +663,8 @@ int buckets_binary_read_chunk(const char *peer_endpoint,
     char *headers_end = NULL;
     
     while (header_len < sizeof(header_buf) - 1) {
-        ssize_t n = recv(fd, header_buf + header_len, sizeof(header_buf) - header_len - 1, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t n = buckets_peer_recv(fd, header_buf + header_len, sizeof(header_buf) - header_len - 1);
         if (n <= 0) {
             buckets_error("Failed to receive response headers");
             close_tcp_connection(fd);
@@ -715,7 +733,8 @@ int buckets_binary_read_chunk(const char *peer_endpoint,
     char *write_ptr = (char*)data + body_in_buffer;
     
     while (remaining > 0) {
-        ssize_t n = recv(fd, write_ptr, remaining, 0);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RECV);
+        ssize_t n = buckets_peer_recv(fd, write_ptr, remaining);
         if (n <= 0) {
             buckets_error("Failed to receive chunk data");
             buckets_free(data);
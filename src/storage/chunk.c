@@ -12,7 +12,6 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
-#include <libgen.h>
 #include <errno.h>
 #include <pthread.h>
 
@@ -22,6 +21,8 @@
 #include "buckets_io.h"
 #include "buckets_group_commit.h"
 #include "buckets_io_uring.h"
+#include "buckets_fault.h"
+#include "buckets_numa.h"
 
 /* ===================================================================
  * io_uring Context (for async I/O)
@@ -41,6 +42,12 @@ static void init_io_uring_ctx(void)
         .io_poll = false         /* Keep disabled (not needed for block devices) */
     };
     
+    /* Keep the kernel submission thread on the worker's socket */
+    if (buckets_numa_home_cpu() >= 0 && buckets_numa_node_count() > 1) {
+        config.sq_thread_pin = true;
+        config.sq_thread_cpu = (u32)buckets_numa_home_cpu();
+    }
+    
     g_io_uring_ctx = buckets_io_uring_init(&config);
     if (!g_io_uring_ctx) {
         buckets_warn("Failed to initialize io_uring, falling back to blocking I/O");
@@ -78,74 +85,54 @@ void buckets_chunk_reinit_after_fork(void)
 }
 
 /* ===================================================================
- * Directory Cache (avoids repeated ensure_directory calls)
+ * Write Mode Selection
  * ===================================================================*/
 
-#define DIR_CACHE_SIZE 1024
+static buckets_chunk_write_mode_t g_chunk_write_mode = BUCKETS_CHUNK_WRITE_AUTO;
+static pthread_once_t g_chunk_write_mode_once = PTHREAD_ONCE_INIT;
 
-typedef struct {
-    char paths[DIR_CACHE_SIZE][PATH_MAX];
-    int count;
-    pthread_mutex_t lock;
-} directory_cache_t;
+static void init_chunk_write_mode(void)
+{
+    const char *mode = getenv("BUCKETS_CHUNK_WRITE_MODE");
+    if (!mode || mode[0] == '\0' || strcmp(mode, "auto") == 0) {
+        return;
+    }
 
-static directory_cache_t g_dir_cache = {0};
-static pthread_once_t g_dir_cache_once = PTHREAD_ONCE_INIT;
+    if (strcmp(mode, "io_uring") == 0) {
+        g_chunk_write_mode = BUCKETS_CHUNK_WRITE_IO_URING;
+    } else if (strcmp(mode, "group_commit") == 0) {
+        g_chunk_write_mode = BUCKETS_CHUNK_WRITE_GROUP_COMMIT;
+    } else if (strcmp(mode, "atomic") == 0) {
+        g_chunk_write_mode = BUCKETS_CHUNK_WRITE_ATOMIC;
+    } else {
+        buckets_warn("Unknown BUCKETS_CHUNK_WRITE_MODE '%s', using auto", mode);
+        return;
+    }
 
-static void init_dir_cache(void)
-{
-    pthread_mutex_init(&g_dir_cache.lock, NULL);
-    g_dir_cache.count = 0;
+    buckets_info("Chunk write mode: %s", buckets_chunk_write_mode_name(g_chunk_write_mode));
 }
 
-static bool is_dir_cached(const char *path)
+void buckets_chunk_set_write_mode(buckets_chunk_write_mode_t mode)
 {
-    pthread_once(&g_dir_cache_once, init_dir_cache);
-    
-    pthread_mutex_lock(&g_dir_cache.lock);
-    
-    for (int i = 0; i < g_dir_cache.count; i++) {
-        if (strcmp(g_dir_cache.paths[i], path) == 0) {
-            pthread_mutex_unlock(&g_dir_cache.lock);
-            return true;
-        }
-    }
-    
-    pthread_mutex_unlock(&g_dir_cache.lock);
-    return false;
+    pthread_once(&g_chunk_write_mode_once, init_chunk_write_mode);
+    __atomic_store_n(&g_chunk_write_mode, mode, __ATOMIC_RELEASE);
 }
 
-static void cache_dir(const char *path)
+buckets_chunk_write_mode_t buckets_chunk_get_write_mode(void)
 {
-    pthread_once(&g_dir_cache_once, init_dir_cache);
-    
-    pthread_mutex_lock(&g_dir_cache.lock);
-    
-    /* Simple ring buffer - overwrite oldest if full */
-    int idx = g_dir_cache.count % DIR_CACHE_SIZE;
-    snprintf(g_dir_cache.paths[idx], PATH_MAX, "%s", path);
-    
-    if (g_dir_cache.count < DIR_CACHE_SIZE) {
-        g_dir_cache.count++;
-    }
-    
-    pthread_mutex_unlock(&g_dir_cache.lock);
+    pthread_once(&g_chunk_write_mode_once, init_chunk_write_mode);
+    return __atomic_load_n(&g_chunk_write_mode, __ATOMIC_ACQUIRE);
 }
 
-static int ensure_directory_cached(const char *path)
+const char* buckets_chunk_write_mode_name(buckets_chunk_write_mode_t mode)
 {
-    /* Fast path: already cached */
-    if (is_dir_cached(path)) {
-        return BUCKETS_OK;
+    switch (mode) {
+        case BUCKETS_CHUNK_WRITE_AUTO:         return "auto";
+        case BUCKETS_CHUNK_WRITE_IO_URING:     return "io_uring";
+        case BUCKETS_CHUNK_WRITE_GROUP_COMMIT: return "group_commit";
+        case BUCKETS_CHUNK_WRITE_ATOMIC:       return "atomic";
+        default:                               return "unknown";
     }
-    
-    /* Slow path: create and cache */
-    int ret = buckets_ensure_directory(path);
-    if (ret == BUCKETS_OK) {
-        cache_dir(path);
-    }
-    
-    return ret;
 }
 
 /* ===================================================================
@@ -161,17 +148,15 @@ int buckets_read_chunk(const char *disk_path, const char *object_path,
         return -1;
     }
 
-    /* Construct chunk path */
-    char chunk_path[PATH_MAX];
-    snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u",
-             disk_path, object_path, chunk_index);
-
-    /* Read chunk file */
-    if (buckets_atomic_read(chunk_path, data, size) != 0) {
-        buckets_error("Failed to read chunk: %s", chunk_path);
+    /* Read chunk file relative to the disk's prefix directory */
+    char chunk_name[32];
+    snprintf(chunk_name, sizeof(chunk_name), "part.%u", chunk_index);
+    if (buckets_disk_read_file(disk_path, object_path, chunk_name, data, size) != 0) {
+        buckets_error("Failed to read chunk: %s/%s%s", disk_path, object_path, chunk_name);
         return -1;
     }
 
+    buckets_numa_record_io(disk_path, *size);
     return 0;
 }
 
@@ -215,37 +200,48 @@ int buckets_write_chunk(const char *disk_path, const char *object_path,
         buckets_error("NULL parameter in write_chunk");
         return -1;
     }
+    
+    buckets_numa_record_io(disk_path, size);
 
-    /* Construct chunk path */
+    /* Construct chunk path (for faults and errors; I/O goes through the
+     * disk's directory handles) */
+    char chunk_name[32];
     char chunk_path[PATH_MAX];
-    snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u",
-             disk_path, object_path, chunk_index);
-
-    /* Try io_uring first for async I/O */
-    buckets_io_uring_context_t *io_ctx = buckets_chunk_get_io_uring_ctx();
+    snprintf(chunk_name, sizeof(chunk_name), "part.%u", chunk_index);
+    snprintf(chunk_path, sizeof(chunk_path), "%s/%s%s",
+             disk_path, object_path, chunk_name);
+
+    /* Pick write path: io_uring first for async I/O unless pinned otherwise */
+    buckets_chunk_write_mode_t mode = buckets_chunk_get_write_mode();
+    buckets_io_uring_context_t *io_ctx = NULL;
+    buckets_group_commit_context_t *gc_ctx = NULL;
+    
+    if (mode == BUCKETS_CHUNK_WRITE_AUTO || mode == BUCKETS_CHUNK_WRITE_IO_URING) {
+        io_ctx = buckets_chunk_get_io_uring_ctx();
+    }
+    if (mode != BUCKETS_CHUNK_WRITE_ATOMIC) {
+        gc_ctx = buckets_storage_get_group_commit_ctx();
+    }
+    
+    /* Injected disk faults (atomic write path applies its own) */
+    if ((io_ctx || gc_ctx) &&
+        buckets_fault_disk_io(chunk_path) != BUCKETS_OK) {
+        buckets_error("Injected fault on chunk write: %s", chunk_path);
+        return -1;
+    }
     
     if (io_ctx) {
         /* Async path with io_uring */
         
-        /* Ensure parent directory exists (with caching) */
-        char *path_copy = buckets_strdup(chunk_path);
-        char *dir_name = dirname(path_copy);
-        char *dir_path = buckets_strdup(dir_name);
-        buckets_free(path_copy);
-        
-        int ret = ensure_directory_cached(dir_path);
-        buckets_free(dir_path);
-        
-        if (ret != BUCKETS_OK) {
-            return -1;
-        }
-        
-        /* Open file for writing (without O_DIRECT for now - requires aligned buffers) */
-        int fd = open(chunk_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        /* Open file for writing (without O_DIRECT for now - requires aligned buffers);
+         * creates the object directory if missing */
+        int fd = buckets_disk_openat(disk_path, object_path, chunk_name,
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
         if (fd < 0) {
             buckets_error("Failed to open chunk file %s: %s", chunk_path, strerror(errno));
             return -1;
         }
+        buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_SHARD, size, false);
         
         /* Prepare completion context */
         async_write_ctx_t *async_ctx = buckets_malloc(sizeof(*async_ctx));
@@ -263,7 +259,7 @@ int buckets_write_chunk(const char *disk_path, const char *object_path,
         snprintf(async_ctx->chunk_path, sizeof(async_ctx->chunk_path), "%s", chunk_path);
         
         /* Submit async write */
-        ret = buckets_io_uring_write_async(io_ctx, fd, data, size,
+        int ret = buckets_io_uring_write_async(io_ctx, fd, data, size,
                                            chunk_write_completion_cb, async_ctx);
         if (ret < 0) {
             buckets_error("Failed to submit async write");
@@ -272,7 +268,10 @@ int buckets_write_chunk(const char *disk_path, const char *object_path,
             goto fallback_blocking;
         }
         
-        /* Submit to kernel - the poller thread will process completions */
+        /* Submit to kernel - the poller thread will process completions.
+         * Accounted as one write plus the close done by the completion callback. */
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         int submitted = buckets_io_uring_submit(io_ctx);
         if (submitted < 0) {
             buckets_error("Failed to submit io_uring operations");
@@ -314,8 +313,6 @@ int buckets_write_chunk(const char *disk_path, const char *object_path,
 fallback_blocking:
     /* Fallback: Try to use group commit if available */
     ;  /* Empty statement to allow label */
-    buckets_group_commit_context_t *gc_ctx = buckets_storage_get_group_commit_ctx();
-    
     if (gc_ctx) {
         /* Optimized path: write with group commit (batched fsync) */
         static bool logged_once = false;
@@ -324,25 +321,14 @@ fallback_blocking:
             logged_once = true;
         }
         
-        /* Ensure parent directory exists (with caching) */
-        char *path_copy = buckets_strdup(chunk_path);
-        char *dir_name = dirname(path_copy);
-        char *dir_path = buckets_strdup(dir_name);
-        buckets_free(path_copy);
-        
-        int ret = ensure_directory_cached(dir_path);
-        buckets_free(dir_path);
-        
-        if (ret != BUCKETS_OK) {
-            return -1;
-        }
-        
-        /* Open file for writing */
-        int fd = open(chunk_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        /* Open file for writing (creates the object directory if missing) */
+        int fd = buckets_disk_openat(disk_path, object_path, chunk_name,
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
         if (fd < 0) {
             buckets_error("Failed to open chunk file %s: %s", chunk_path, strerror(errno));
             return -1;
         }
+        buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_SHARD, size, false);
         
         /* Write with group commit */
         ssize_t written = buckets_group_commit_write(gc_ctx, fd, data, size);
@@ -351,7 +337,7 @@ fallback_blocking:
             close(fd);
             buckets_error("Failed to write chunk %s: written=%zd expected=%zu", 
                          chunk_path, written, size);
-            unlink(chunk_path);
+            buckets_disk_unlink_file(disk_path, object_path, chunk_name);
             return -1;
         }
         
@@ -359,15 +345,16 @@ fallback_blocking:
         if (buckets_group_commit_flush_fd(gc_ctx, fd) != 0) {
             close(fd);
             buckets_error("Failed to flush chunk %s", chunk_path);
-            unlink(chunk_path);
+            buckets_disk_unlink_file(disk_path, object_path, chunk_name);
             return -1;
         }
         
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
         close(fd);
         return 0;
     } else {
         /* Fallback: use atomic write with immediate fsync */
-        if (buckets_atomic_write(chunk_path, data, size) != 0) {
+        if (buckets_disk_write_file(disk_path, object_path, chunk_name, data, size) != 0) {
             buckets_error("Failed to write chunk: %s", chunk_path);
             return -1;
         }
@@ -423,14 +410,11 @@ int buckets_delete_chunk(const char *disk_path, const char *object_path,
         return -1;
     }
 
-    /* Construct chunk path */
-    char chunk_path[PATH_MAX];
-    snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u",
-             disk_path, object_path, chunk_index);
-
     /* Delete chunk file */
-    if (unlink(chunk_path) != 0) {
-        buckets_error("Failed to delete chunk: %s", chunk_path);
+    char chunk_name[32];
+    snprintf(chunk_name, sizeof(chunk_name), "part.%u", chunk_index);
+    if (buckets_disk_unlink_file(disk_path, object_path, chunk_name) != 0) {
+        buckets_error("Failed to delete chunk: %s/%s%s", disk_path, object_path, chunk_name);
         return -1;
     }
 
@@ -445,11 +429,22 @@ bool buckets_chunk_exists(const char *disk_path, const char *object_path,
         return false;
     }
 
-    /* Construct chunk path */
-    char chunk_path[PATH_MAX];
-    snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u",
-             disk_path, object_path, chunk_index);
+    char chunk_name[32];
+    snprintf(chunk_name, sizeof(chunk_name), "part.%u", chunk_index);
 
     /* Check if file exists */
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, chunk_name, rel, sizeof(rel));
+    if (dirfd >= 0) {
+        if (faccessat(dirfd, rel, F_OK, 0) == 0) {
+            return true;
+        }
+        buckets_disk_dirs_io_error(disk_path, errno);
+        return false;
+    }
+
+    char chunk_path[PATH_MAX];
+    snprintf(chunk_path, sizeof(chunk_path), "%s/%s%s",
+             disk_path, object_path, chunk_name);
     return (access(chunk_path, F_OK) == 0);
 }
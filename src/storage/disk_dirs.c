@@ -0,0 +1,816 @@
+/**
+ * Disk Directory Handles
+ *
+ * One directory fd per local disk plus its 256 hash-prefix directories,
+ * opened on first use. Object file I/O goes through
+ * openat/mkdirat/renameat/unlinkat relative to the prefix fd.
+ *
+ * The table is an open-addressed hash of disk paths. Slots are published
+ * with a release store and never reused while the process runs, so lookups
+ * take no lock; only opening a new disk does.
+ *
+ * A disk's fds are not pinned forever:
+ * - A failed disk (EIO/ESTALE, marked offline, root gone) is dropped: its
+ *   fd numbers are pointed at /dev/null with dup3, which releases the mount
+ *   while any in-flight *at() call on them fails with ENOTDIR instead of
+ *   resolving against a reused fd number. Dropped disks use the path code.
+ * - A disk whose root changed identity (replaced or remounted) is reopened
+ *   by dup3-ing the new directory fds over the old numbers.
+ * The root identity is rechecked at most every BUCKETS_DISK_DIRS_CHECK_MS.
+ * A disk dropped because its root vanished comes back by itself once the
+ * root is there again; one dropped through buckets_disk_dirs_drop waits
+ * for buckets_disk_dirs_reopen (heal), so an unmounted disk's empty mount
+ * point is never adopted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_io.h"
+#include "buckets_fault.h"
+
+#define DISK_TABLE_SLOTS (BUCKETS_DISK_DIRS_MAX * 2)
+
+typedef struct {
+    char *path;
+    int root_fd;
+    int prefix_fd[BUCKETS_DISK_PREFIX_DIRS];
+    dev_t dev;                      /* Root identity when opened */
+    ino_t ino;
+    bool dropped;                   /* Failed: use paths (atomic) */
+    bool failed;                    /* Dropped by the caller: wait for reopen */
+    u64 next_check_us;              /* Next root identity check (atomic) */
+} disk_dirs_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;           /* Serializes opening, reopening and dropping */
+    bool enabled;
+    int placeholder_fd;             /* O_PATH /dev/null dup3'd over dropped fds */
+    u32 count;
+    disk_dirs_t *slots[DISK_TABLE_SLOTS];
+} g_disk_dirs = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .enabled = true,
+    .placeholder_fd = -1
+};
+
+static void disk_dirs_init_once(void)
+{
+    const char *env = getenv("BUCKETS_DISK_DIRFDS");
+    if (env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0)) {
+        g_disk_dirs.enabled = false;
+        buckets_info("Disk directory handles disabled, using absolute paths");
+        return;
+    }
+    g_disk_dirs.placeholder_fd = open("/dev/null", O_PATH | O_CLOEXEC);
+    if (g_disk_dirs.placeholder_fd < 0) {
+        buckets_warn("Disk directory handles: no /dev/null placeholder, "
+                     "failed disks keep their handles: %s", strerror(errno));
+    }
+}
+
+static u64 now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000ULL + (u64)ts.tv_nsec / 1000;
+}
+
+/* FNV-1a */
+static u32 path_hash(const char *path)
+{
+    u32 h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)path; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static disk_dirs_t* lookup(const char *disk_path)
+{
+    u32 slot = path_hash(disk_path) % DISK_TABLE_SLOTS;
+    for (u32 probe = 0; probe < DISK_TABLE_SLOTS; probe++) {
+        disk_dirs_t *d = __atomic_load_n(&g_disk_dirs.slots[slot], __ATOMIC_ACQUIRE);
+        if (!d) {
+            return NULL;
+        }
+        if (strcmp(d->path, disk_path) == 0) {
+            return d;
+        }
+        slot = (slot + 1) % DISK_TABLE_SLOTS;
+    }
+    return NULL;
+}
+
+static void close_disk(disk_dirs_t *d)
+{
+    for (u32 i = 0; i < BUCKETS_DISK_PREFIX_DIRS; i++) {
+        if (d->prefix_fd[i] >= 0) {
+            close(d->prefix_fd[i]);
+        }
+    }
+    if (d->root_fd >= 0) {
+        close(d->root_fd);
+    }
+    buckets_free(d->path);
+    buckets_free(d);
+}
+
+static disk_dirs_t* open_disk(const char *disk_path)
+{
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int root = open(disk_path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (root < 0) {
+        return NULL;
+    }
+
+    disk_dirs_t *d = buckets_calloc(1, sizeof(disk_dirs_t));
+    d->path = buckets_strdup(disk_path);
+    d->root_fd = root;
+    for (u32 i = 0; i < BUCKETS_DISK_PREFIX_DIRS; i++) {
+        d->prefix_fd[i] = -1;
+    }
+    struct stat st;
+    if (fstat(root, &st) == 0) {
+        d->dev = st.st_dev;
+        d->ino = st.st_ino;
+    }
+    d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+
+    char name[3];
+    for (u32 i = 0; i < BUCKETS_DISK_PREFIX_DIRS; i++) {
+        snprintf(name, sizeof(name), "%02x", i);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_MKDIR);
+        if (mkdirat(root, name, 0755) != 0 && errno != EEXIST) {
+            buckets_warn("Disk %s: cannot create prefix directory %s: %s",
+                         disk_path, name, strerror(errno));
+            continue;
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+        d->prefix_fd[i] = openat(root, name, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (d->prefix_fd[i] < 0) {
+            buckets_warn("Disk %s: cannot open prefix directory %s: %s",
+                         disk_path, name, strerror(errno));
+            if (errno == EMFILE || errno == ENFILE) {
+                /* Out of descriptors: give the ones we hold back */
+                close_disk(d);
+                return NULL;
+            }
+        }
+    }
+    return d;
+}
+
+/* ===================================================================
+ * Drop / Reopen
+ * ===================================================================*/
+
+/* Replace what fd number `*slot` refers to; caller holds the table lock */
+static void replace_fd(int *slot, int fresh)
+{
+    int old = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (old < 0) {
+        /* Never opened: publish the new number */
+        __atomic_store_n(slot, fresh, __ATOMIC_RELEASE);
+        return;
+    }
+    int src = fresh >= 0 ? fresh : g_disk_dirs.placeholder_fd;
+    if (src >= 0 && dup3(src, old, O_CLOEXEC) < 0) {
+        buckets_warn("Disk handle swap failed: %s", strerror(errno));
+    }
+    if (fresh >= 0) {
+        close(fresh);
+    }
+}
+
+/* Point every fd of d at the placeholder; caller holds the table lock */
+static void drop_locked(disk_dirs_t *d, const char *why)
+{
+    if (__atomic_load_n(&d->dropped, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&d->dropped, true, __ATOMIC_RELEASE);
+    if (g_disk_dirs.placeholder_fd >= 0) {
+        for (u32 i = 0; i < BUCKETS_DISK_PREFIX_DIRS; i++) {
+            if (d->prefix_fd[i] >= 0) {
+                dup3(g_disk_dirs.placeholder_fd, d->prefix_fd[i], O_CLOEXEC);
+            }
+        }
+        dup3(g_disk_dirs.placeholder_fd, d->root_fd, O_CLOEXEC);
+    }
+    buckets_warn("Disk %s: directory handles released (%s)", d->path, why);
+}
+
+/* Open the disk afresh and move the new fds onto d's numbers; caller holds
+ * the table lock. Drops d if the root cannot be opened. */
+static int reopen_locked(disk_dirs_t *d)
+{
+    d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+
+    disk_dirs_t *fresh = open_disk(d->path);
+    if (!fresh) {
+        drop_locked(d, strerror(errno));
+        return -1;
+    }
+
+    replace_fd(&d->root_fd, fresh->root_fd);
+    for (u32 i = 0; i < BUCKETS_DISK_PREFIX_DIRS; i++) {
+        replace_fd(&d->prefix_fd[i], fresh->prefix_fd[i]);
+    }
+    d->dev = fresh->dev;
+    d->ino = fresh->ino;
+    d->failed = false;
+    bool was_dropped = __atomic_load_n(&d->dropped, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&d->dropped, false, __ATOMIC_RELEASE);
+
+    /* The fds now belong to d */
+    buckets_free(fresh->path);
+    buckets_free(fresh);
+
+    buckets_info("Disk %s: directory handles %s", d->path,
+                 was_dropped ? "reopened after failure" : "reopened");
+    return 0;
+}
+
+/* Periodic root identity check; caller holds the table lock */
+static void check_root_locked(disk_dirs_t *d)
+{
+    if (d->failed) {
+        d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+        return;
+    }
+    struct stat st;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (stat(d->path, &st) != 0) {
+        d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+        drop_locked(d, strerror(errno));
+        return;
+    }
+    if (__atomic_load_n(&d->dropped, __ATOMIC_ACQUIRE) ||
+        st.st_dev != d->dev || st.st_ino != d->ino) {
+        /* Back, or replaced / remounted under the same path */
+        reopen_locked(d);
+        return;
+    }
+    d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+}
+
+void buckets_disk_dirs_drop(const char *disk_path)
+{
+    pthread_once(&g_disk_dirs.once, disk_dirs_init_once);
+    if (!disk_path) {
+        return;
+    }
+    pthread_mutex_lock(&g_disk_dirs.lock);
+    disk_dirs_t *d = lookup(disk_path);
+    if (d) {
+        drop_locked(d, "disk marked failed");
+        d->failed = true;
+        d->next_check_us = now_us() + BUCKETS_DISK_DIRS_CHECK_MS * 1000ULL;
+    }
+    pthread_mutex_unlock(&g_disk_dirs.lock);
+}
+
+int buckets_disk_dirs_reopen(const char *disk_path)
+{
+    pthread_once(&g_disk_dirs.once, disk_dirs_init_once);
+    if (!g_disk_dirs.enabled || !disk_path) {
+        return BUCKETS_ERR_LIMIT;
+    }
+    pthread_mutex_lock(&g_disk_dirs.lock);
+    disk_dirs_t *d = lookup(disk_path);
+    int ret = BUCKETS_OK;
+    if (d) {
+        ret = reopen_locked(d) == 0 ? BUCKETS_OK : BUCKETS_ERR_IO;
+    }
+    pthread_mutex_unlock(&g_disk_dirs.lock);
+    return d ? ret : buckets_disk_dirs_open(disk_path);
+}
+
+void buckets_disk_dirs_io_error(const char *disk_path, int err)
+{
+    if (err == EIO || err == ESTALE) {
+        int saved = errno;
+        buckets_disk_dirs_reopen(disk_path);
+        errno = saved;
+    }
+}
+
+static void check_io_error(const char *disk_path)
+{
+    buckets_disk_dirs_io_error(disk_path, errno);
+}
+
+/* ===================================================================
+ * Table Management
+ * ===================================================================*/
+
+static disk_dirs_t* get_disk(const char *disk_path)
+{
+    pthread_once(&g_disk_dirs.once, disk_dirs_init_once);
+    if (!g_disk_dirs.enabled || !disk_path) {
+        return NULL;
+    }
+
+    disk_dirs_t *d = lookup(disk_path);
+    if (d) {
+        u64 due = __atomic_load_n(&d->next_check_us, __ATOMIC_RELAXED);
+        if (now_us() >= due) {
+            pthread_mutex_lock(&g_disk_dirs.lock);
+            if (now_us() >= d->next_check_us) {
+                check_root_locked(d);
+            }
+            pthread_mutex_unlock(&g_disk_dirs.lock);
+        }
+        return __atomic_load_n(&d->dropped, __ATOMIC_ACQUIRE) ? NULL : d;
+    }
+
+    pthread_mutex_lock(&g_disk_dirs.lock);
+    d = lookup(disk_path);
+    if (!d && g_disk_dirs.count < BUCKETS_DISK_DIRS_MAX) {
+        d = open_disk(disk_path);
+        if (d) {
+            u32 slot = path_hash(disk_path) % DISK_TABLE_SLOTS;
+            while (g_disk_dirs.slots[slot]) {
+                slot = (slot + 1) % DISK_TABLE_SLOTS;
+            }
+            __atomic_store_n(&g_disk_dirs.slots[slot], d, __ATOMIC_RELEASE);
+            g_disk_dirs.count++;
+            buckets_debug("Opened disk %s with %u prefix directories",
+                          disk_path, BUCKETS_DISK_PREFIX_DIRS);
+        }
+    }
+    pthread_mutex_unlock(&g_disk_dirs.lock);
+    return d;
+}
+
+int buckets_disk_dirs_open(const char *disk_path)
+{
+    pthread_once(&g_disk_dirs.once, disk_dirs_init_once);
+    if (!g_disk_dirs.enabled) {
+        return BUCKETS_ERR_LIMIT;
+    }
+    if (get_disk(disk_path)) {
+        return BUCKETS_OK;
+    }
+    return g_disk_dirs.count >= BUCKETS_DISK_DIRS_MAX ? BUCKETS_ERR_LIMIT : BUCKETS_ERR_IO;
+}
+
+void buckets_disk_dirs_close_all(void)
+{
+    pthread_mutex_lock(&g_disk_dirs.lock);
+    for (u32 i = 0; i < DISK_TABLE_SLOTS; i++) {
+        disk_dirs_t *d = g_disk_dirs.slots[i];
+        if (d) {
+            __atomic_store_n(&g_disk_dirs.slots[i], NULL, __ATOMIC_RELEASE);
+            close_disk(d);
+        }
+    }
+    g_disk_dirs.count = 0;
+    pthread_mutex_unlock(&g_disk_dirs.lock);
+}
+
+/* ===================================================================
+ * Path Resolution
+ * ===================================================================*/
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+int buckets_disk_object_at(const char *disk_path, const char *object_path,
+                           const char *file, char *rel, size_t rel_len)
+{
+    if (!object_path || !rel) {
+        return -1;
+    }
+
+    /* Only "<2 hex>/..." paths live under a prefix directory */
+    int hi = hex_digit(object_path[0]);
+    int lo = hi >= 0 ? hex_digit(object_path[1]) : -1;
+    if (lo < 0 || object_path[2] != '/' || object_path[3] == '\0') {
+        return -1;
+    }
+
+    disk_dirs_t *d = get_disk(disk_path);
+    if (!d) {
+        return -1;
+    }
+    int fd = __atomic_load_n(&d->prefix_fd[hi * 16 + lo], __ATOMIC_ACQUIRE);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Same concatenation as the "%s/%s%s" the path-based code uses */
+    int n = snprintf(rel, rel_len, "%s%s", object_path + 3, file ? file : "");
+    if (n < 0 || (size_t)n >= rel_len) {
+        return -1;
+    }
+    return fd;
+}
+
+/* mkdirat every directory component of rel (up to and excluding the
+ * last component unless it ends in '/') */
+static int mkdirs_at(int dirfd, const char *rel)
+{
+    char buf[PATH_MAX];
+    snprintf(buf, sizeof(buf), "%s", rel);
+
+    for (char *p = buf; *p; p++) {
+        if (*p != '/' || p == buf || p[-1] == '/') {
+            continue;
+        }
+        *p = '\0';
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_MKDIR);
+        if (mkdirat(dirfd, buf, 0755) != 0 && errno != EEXIST) {
+            buckets_error("Failed to create directory %s: %s", buf, strerror(errno));
+            return -1;
+        }
+        *p = '/';
+    }
+    return 0;
+}
+
+static void full_path(char *out, size_t out_len, const char *disk_path,
+                      const char *object_path, const char *file)
+{
+    snprintf(out, out_len, "%s/%s%s", disk_path, object_path, file ? file : "");
+}
+
+/* ===================================================================
+ * File Operations
+ * ===================================================================*/
+
+int buckets_disk_mkdir_object(const char *disk_path, const char *object_path)
+{
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, NULL, rel, sizeof(rel));
+    if (dirfd < 0) {
+        char path[PATH_MAX * 2];
+        full_path(path, sizeof(path), disk_path, object_path, NULL);
+        return buckets_ensure_directory(path) == BUCKETS_OK ? 0 : -1;
+    }
+
+    /* Usually one mkdirat: the object's own directory */
+    size_t len = strlen(rel);
+    if (len > 0 && rel[len - 1] != '/' && len + 1 < sizeof(rel)) {
+        rel[len] = '/';
+        rel[len + 1] = '\0';
+    }
+    return mkdirs_at(dirfd, rel);
+}
+
+int buckets_disk_openat(const char *disk_path, const char *object_path,
+                        const char *file, int flags, mode_t mode)
+{
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, file, rel, sizeof(rel));
+    if (dirfd < 0) {
+        char path[PATH_MAX * 2];
+        full_path(path, sizeof(path), disk_path, object_path, file);
+        if (flags & O_CREAT) {
+            char *slash = strrchr(path, '/');
+            if (slash) {
+                *slash = '\0';
+                buckets_ensure_directory(path);
+                *slash = '/';
+            }
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+        return open(path, flags | O_CLOEXEC, mode);
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int fd = openat(dirfd, rel, flags | O_CLOEXEC, mode);
+    if (fd < 0 && errno == ENOENT && (flags & O_CREAT)) {
+        /* Object directory not there yet */
+        if (mkdirs_at(dirfd, rel) != 0) {
+            return -1;
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+        fd = openat(dirfd, rel, flags | O_CLOEXEC, mode);
+    }
+    if (fd < 0) {
+        check_io_error(disk_path);
+    }
+    return fd;
+}
+
+int buckets_disk_read_file(const char *disk_path, const char *object_path,
+                           const char *file, void **data, size_t *size)
+{
+    if (!data || !size) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    *data = NULL;
+    *size = 0;
+
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, file, rel, sizeof(rel));
+    if (dirfd < 0 || buckets_fault_enabled()) {
+        char path[PATH_MAX * 2];
+        full_path(path, sizeof(path), disk_path, object_path, file);
+        return buckets_atomic_read(path, data, size);
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int fd = openat(dirfd, rel, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        buckets_debug("Failed to open %s/%s%s: %s", disk_path, object_path,
+                      file ? file : "", strerror(errno));
+        check_io_error(disk_path);
+        return BUCKETS_ERR_IO;
+    }
+
+    struct stat st;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return BUCKETS_ERR_IO;
+    }
+
+    size_t len = (size_t)st.st_size;
+    char *buf = buckets_malloc(len + 1);    /* +1 for null terminator */
+    size_t done = 0;
+    while (done < len) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_READ);
+        ssize_t n = read(fd, buf + done, len - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+    close(fd);
+
+    if (done != len) {
+        buckets_error("Short read of %s/%s%s: %zu/%zu bytes", disk_path, object_path,
+                      file ? file : "", done, len);
+        buckets_free(buf);
+        return BUCKETS_ERR_IO;
+    }
+
+    buf[len] = '\0';
+    *data = buf;
+    *size = len;
+    return BUCKETS_OK;
+}
+
+int buckets_disk_write_file(const char *disk_path, const char *object_path,
+                            const char *file, const void *data, size_t size)
+{
+    if (!file || !data) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    char rel[PATH_MAX];
+    char tmp_rel[PATH_MAX + 64];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, file, rel, sizeof(rel));
+    if (dirfd < 0 || buckets_fault_enabled()) {
+        char path[PATH_MAX * 2];
+        full_path(path, sizeof(path), disk_path, object_path, file);
+        return buckets_atomic_write(path, data, size);
+    }
+    char tmp_name[64];
+    buckets_disk_temp_name(tmp_name, sizeof(tmp_name), "");
+    snprintf(tmp_rel, sizeof(tmp_rel), "%s%s", rel, tmp_name);
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int fd = openat(dirfd, tmp_rel, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT) {
+        if (mkdirs_at(dirfd, rel) != 0) {
+            return BUCKETS_ERR_IO;
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+        fd = openat(dirfd, tmp_rel, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        buckets_error("Failed to create %s/%s%s.tmp: %s", disk_path, object_path,
+                      file, strerror(errno));
+        check_io_error(disk_path);
+        return BUCKETS_ERR_IO;
+    }
+    buckets_disk_prepare_file(fd, strncmp(file, "part.", 5) == 0 ?
+                              BUCKETS_FILE_LIFE_SHARD : BUCKETS_FILE_LIFE_METADATA,
+                              size, false);
+
+    const char *p = data;
+    size_t left = size;
+    while (left > 0) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+        ssize_t n = write(fd, p, left);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+    bool ok = left == 0 && fsync(fd) == 0;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+    close(fd);
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RENAME);
+    if (!ok || renameat(dirfd, tmp_rel, dirfd, rel) != 0) {
+        buckets_error("Failed to write %s/%s%s: %s", disk_path, object_path,
+                      file, strerror(errno));
+        int saved = errno;
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_UNLINK);
+        unlinkat(dirfd, tmp_rel, 0);
+        errno = saved;
+        check_io_error(disk_path);
+        return BUCKETS_ERR_IO;
+    }
+
+    /* Persist the rename */
+    buckets_disk_sync_object_dir(disk_path, object_path);
+    return BUCKETS_OK;
+}
+
+void buckets_disk_temp_name(char *out, size_t out_len, const char *file)
+{
+    static u64 seq;
+    u64 n = __atomic_add_fetch(&seq, 1, __ATOMIC_RELAXED);
+    snprintf(out, out_len, "%s.tmp.%d.%llu", file, getpid(), (unsigned long long)n);
+}
+
+int buckets_disk_sync_object_dir(const char *disk_path, const char *object_path)
+{
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, NULL, rel, sizeof(rel));
+    if (dirfd < 0) {
+        full_path(rel, sizeof(rel), disk_path, object_path, NULL);
+        dirfd = AT_FDCWD;
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int dfd = openat(dirfd, rel, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0) {
+        return -1;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+    int ret = fsync(dfd);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+    close(dfd);
+    return ret == 0 ? 0 : -1;
+}
+
+int buckets_disk_rename_file(const char *disk_path, const char *object_path,
+                             const char *from, const char *to)
+{
+    char from_rel[PATH_MAX];
+    char to_rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, from,
+                                       from_rel, sizeof(from_rel));
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RENAME);
+    if (dirfd >= 0 &&
+        buckets_disk_object_at(disk_path, object_path, to, to_rel, sizeof(to_rel)) >= 0) {
+        if (renameat(dirfd, from_rel, dirfd, to_rel) == 0) {
+            return 0;
+        }
+        check_io_error(disk_path);
+        return -1;
+    }
+
+    char from_path[PATH_MAX * 2];
+    char to_path[PATH_MAX * 2];
+    full_path(from_path, sizeof(from_path), disk_path, object_path, from);
+    full_path(to_path, sizeof(to_path), disk_path, object_path, to);
+    return rename(from_path, to_path) == 0 ? 0 : -1;
+}
+
+int buckets_disk_unlink_file(const char *disk_path, const char *object_path,
+                             const char *file)
+{
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, file, rel, sizeof(rel));
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_UNLINK);
+    if (dirfd >= 0) {
+        if (unlinkat(dirfd, rel, 0) == 0) {
+            return 0;
+        }
+        check_io_error(disk_path);
+        return -1;
+    }
+
+    char path[PATH_MAX * 2];
+    full_path(path, sizeof(path), disk_path, object_path, file);
+    return unlink(path) == 0 ? 0 : -1;
+}
+
+int buckets_disk_rmdir_object(const char *disk_path, const char *object_path)
+{
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, NULL, rel, sizeof(rel));
+    if (dirfd < 0) {
+        full_path(rel, sizeof(rel), disk_path, object_path, NULL);
+    }
+
+    /* Remove trailing slash */
+    size_t len = strlen(rel);
+    if (len > 0 && rel[len - 1] == '/') {
+        rel[len - 1] = '\0';
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_UNLINK);
+    if (dirfd >= 0) {
+        return unlinkat(dirfd, rel, AT_REMOVEDIR) == 0 ? 0 : -1;
+    }
+    return rmdir(rel) == 0 ? 0 : -1;
+}
+
+/* ===================================================================
+ * Preallocation and Write-Lifetime Hints
+ * ===================================================================*/
+
+#define PREALLOC_DEFAULT_MIN (64 * 1024)
+
+static struct {
+    pthread_once_t once;
+    bool prealloc;
+    bool hints;                     /* Cleared if the kernel rejects them */
+    size_t prealloc_min;
+} g_file_prep = {
+    .once = PTHREAD_ONCE_INIT,
+    .prealloc = true,
+    .hints = true,
+    .prealloc_min = PREALLOC_DEFAULT_MIN
+};
+
+static bool env_off(const char *name)
+{
+    const char *env = getenv(name);
+    return env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0);
+}
+
+static void file_prep_init_once(void)
+{
+    g_file_prep.prealloc = !env_off("BUCKETS_PREALLOC");
+    g_file_prep.hints = !env_off("BUCKETS_WRITE_HINTS");
+
+    const char *min = getenv("BUCKETS_PREALLOC_MIN");
+    if (min && *min) {
+        g_file_prep.prealloc_min = (size_t)strtoull(min, NULL, 10);
+    }
+#ifndef F_SET_RW_HINT
+    g_file_prep.hints = false;
+#endif
+    buckets_debug("File preparation: prealloc=%s (min %zu), write hints=%s",
+                  g_file_prep.prealloc ? "on" : "off", g_file_prep.prealloc_min,
+                  g_file_prep.hints ? "on" : "off");
+}
+
+void buckets_disk_prepare_file(int fd, buckets_file_life_t life,
+                               size_t size, bool keep_size)
+{
+    if (fd < 0) {
+        return;
+    }
+    pthread_once(&g_file_prep.once, file_prep_init_once);
+
+#ifdef F_SET_RW_HINT
+    if (__atomic_load_n(&g_file_prep.hints, __ATOMIC_RELAXED)) {
+        /* Per inode: new files start at RWH_WRITE_LIFE_NOT_SET */
+        uint64_t hint = life == BUCKETS_FILE_LIFE_METADATA ?
+                        RWH_WRITE_LIFE_SHORT : RWH_WRITE_LIFE_LONG;
+        if (fcntl(fd, F_SET_RW_HINT, &hint) != 0 && errno == EINVAL) {
+            /* Kernel without lifetime hints: stop asking */
+            __atomic_store_n(&g_file_prep.hints, false, __ATOMIC_RELAXED);
+        }
+    }
+#else
+    (void)life;
+#endif
+
+    if (!g_file_prep.prealloc || size == 0 || size < g_file_prep.prealloc_min) {
+        return;
+    }
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FALLOCATE);
+    if (fallocate(fd, keep_size ? FALLOC_FL_KEEP_SIZE : 0, 0, (off_t)size) != 0 &&
+        errno != EOPNOTSUPP && errno != ENOSYS) {
+        /* ENOSPC and friends surface again on the write itself */
+        buckets_debug("fallocate(%zu) failed: %s", size, strerror(errno));
+    }
+}
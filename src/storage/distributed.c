@@ -24,6 +24,10 @@ static buckets_conn_pool_t *g_conn_pool = NULL;
 /* Current node's endpoint (for determining local vs remote) */
 static char g_local_node_endpoint[256] = {0};
 
+/* Gossip membership (NULL unless started) */
+static buckets_gossip_t *g_gossip = NULL;
+static buckets_gossip_shared_t *g_gossip_shared = NULL;   /* Worker pool */
+
 /* ===================================================================
  * Initialization
  * ===================================================================*/
@@ -68,6 +72,15 @@ int buckets_distributed_storage_init(void)
  */
 void buckets_distributed_storage_cleanup(void)
 {
+    if (g_gossip) {
+        buckets_gossip_free(g_gossip);
+        g_gossip = NULL;
+    }
+    if (g_gossip_shared) {
+        buckets_gossip_shared_destroy(g_gossip_shared);
+        g_gossip_shared = NULL;
+    }
+    
     if (g_rpc_ctx) {
         buckets_rpc_context_free(g_rpc_ctx);
         g_rpc_ctx = NULL;
@@ -111,6 +124,106 @@ int buckets_distributed_set_local_endpoint(const char *node_endpoint)
     return BUCKETS_OK;
 }
 
+/* ===================================================================
+ * Gossip Membership
+ * ===================================================================*/
+
+static void gossip_member_changed(const char *node_id, const char *endpoint,
+                                  buckets_member_state_t state, void *user_data)
+{
+    (void)user_data;
+    static const char *names[] = { "alive", "suspect", "dead" };
+    buckets_info("Cluster member %s (%s) is %s", node_id, endpoint, names[state]);
+}
+
+static void gossip_topology_generation(i64 generation, void *user_data)
+{
+    (void)user_data;
+    buckets_cluster_topology_t *topology = buckets_topology_manager_get();
+    if (topology && topology->generation >= generation) {
+        return;
+    }
+    buckets_info("Gossip: topology generation %ld announced, reloading", (long)generation);
+    buckets_topology_manager_load();
+}
+
+static void gossip_invalidate(const char *bucket, const char *object, void *user_data)
+{
+    (void)user_data;
+    buckets_get_coalesce_forget(bucket, object);
+    buckets_object_cache_invalidate(bucket, object);
+}
+
+static void gossip_topology_changed(buckets_cluster_topology_t *topology, void *user_data)
+{
+    buckets_gossip_publish_topology((buckets_gossip_t*)user_data, topology->generation);
+}
+
+static bool gossip_disabled(void)
+{
+    const char *env = getenv("BUCKETS_GOSSIP");
+    return env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0 ||
+                   strcmp(env, "false") == 0);
+}
+
+int buckets_distributed_gossip_share(void)
+{
+    if (gossip_disabled() || g_gossip_shared) {
+        return BUCKETS_OK;
+    }
+    g_gossip_shared = buckets_gossip_shared_create();
+    return g_gossip_shared ? BUCKETS_OK : BUCKETS_ERR_NOMEM;
+}
+
+int buckets_distributed_gossip_start(bool agent)
+{
+    if (gossip_disabled()) {
+        buckets_info("Gossip membership disabled");
+        return BUCKETS_OK;
+    }
+    if (!g_rpc_ctx || g_gossip) {
+        return g_rpc_ctx ? BUCKETS_OK : BUCKETS_ERR_INIT;
+    }
+    
+    extern buckets_config_t* buckets_get_global_config(void);
+    buckets_config_t *config = buckets_get_global_config();
+    if (!config || !config->cluster.enabled || !config->node.id ||
+        !config->node.endpoint || config->node.endpoint[0] == '\0') {
+        return BUCKETS_OK;
+    }
+    
+    g_gossip = buckets_gossip_create(g_rpc_ctx, config->node.id, config->node.endpoint, NULL);
+    if (!g_gossip) {
+        return BUCKETS_ERR_INIT;
+    }
+    
+    for (int i = 0; i < config->cluster.node_count; i++) {
+        buckets_cluster_node_t *node = &config->cluster.nodes[i];
+        if (node->id && node->endpoint && node->endpoint[0] != '\0') {
+            buckets_gossip_add_member(g_gossip, node->id, node->endpoint);
+        }
+    }
+    
+    buckets_gossip_callbacks_t callbacks = {
+        .member_changed = gossip_member_changed,
+        .topology_generation = gossip_topology_generation,
+        .invalidate = gossip_invalidate,
+        .user_data = NULL
+    };
+    buckets_gossip_set_callbacks(g_gossip, &callbacks);
+    buckets_topology_manager_set_callback(gossip_topology_changed, g_gossip);
+    if (g_gossip_shared) {
+        buckets_gossip_share(g_gossip, g_gossip_shared, agent);
+    }
+    
+    int ret = buckets_gossip_start(g_gossip);
+    if (ret != BUCKETS_OK) {
+        buckets_gossip_free(g_gossip);
+        g_gossip = NULL;
+    }
+    return ret;
+}
+
 /**
  * Extract node endpoint from full disk endpoint
  * 
@@ -185,6 +298,21 @@ bool buckets_distributed_is_local_disk(const char *disk_endpoint)
     return (strcmp(node_endpoint, g_local_node_endpoint) == 0);
 }
 
+bool buckets_distributed_disk_available(const char *disk_endpoint, const char *disk_path)
+{
+    if (!disk_endpoint || disk_endpoint[0] == '\0' ||
+        buckets_distributed_is_local_disk(disk_endpoint)) {
+        return buckets_multidisk_disk_online(disk_path);
+    }
+    
+    char node_endpoint[256];
+    if (buckets_distributed_extract_node_endpoint(disk_endpoint, node_endpoint,
+                                                  sizeof(node_endpoint)) != BUCKETS_OK) {
+        return true;
+    }
+    return !buckets_gossip_endpoint_dead(g_gossip, node_endpoint);
+}
+
 /* ===================================================================
  * Helper Functions
  * ===================================================================*/
@@ -505,6 +633,147 @@ int buckets_distributed_write_xlmeta(const char *peer_endpoint,
     return BUCKETS_OK;
 }
 
+/**
+ * Write many xl.meta files to remote node in one RPC
+ * 
+ * @param peer_endpoint Remote node endpoint
+ * @param items Entries to write (result set per entry)
+ * @param count Number of entries
+ * @return BUCKETS_OK if the RPC completed (check per-entry results)
+ */
+int buckets_distributed_write_xlmeta_batch(const char *peer_endpoint,
+                                           buckets_xl_meta_batch_item_t *items,
+                                           size_t count)
+{
+    if (!g_rpc_ctx) {
+        buckets_error("Distributed storage not initialized");
+        return BUCKETS_ERR_INIT;
+    }
+    
+    if (!peer_endpoint || !items || count == 0 || count > BUCKETS_XL_META_BATCH_MAX) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    /* Build RPC parameters */
+    cJSON *params = cJSON_CreateObject();
+    cJSON *array = cJSON_AddArrayToObject(params, "items");
+    for (size_t i = 0; i < count; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "bucket", items[i].bucket);
+        cJSON_AddStringToObject(item, "object", items[i].object);
+        cJSON_AddStringToObject(item, "disk_path", items[i].disk_path);
+        cJSON_AddStringToObject(item, "xl_meta_json", items[i].meta_json);
+        cJSON_AddItemToArray(array, item);
+        items[i].result = -1;
+    }
+    
+    /* Call RPC */
+    buckets_rpc_response_t *response = NULL;
+    int ret = buckets_rpc_call(g_rpc_ctx, peer_endpoint, "storage.writeXlMetaBatch",
+                               params, &response, 30000);  /* 30 second timeout */
+    
+    cJSON_Delete(params);
+    
+    if (ret != BUCKETS_OK || !response) {
+        buckets_error("RPC call to %s failed: storage.writeXlMetaBatch", peer_endpoint);
+        if (response) {
+            buckets_rpc_response_free(response);
+        }
+        return BUCKETS_ERR_RPC;
+    }
+    
+    if (response->error_code != 0) {
+        buckets_error("Remote writeXlMetaBatch failed: %s",
+                     response->error_message ? response->error_message : "unknown error");
+        buckets_rpc_response_free(response);
+        return BUCKETS_ERR_RPC;
+    }
+    
+    /* Per-entry results, in request order */
+    cJSON *results = response->result ? cJSON_GetObjectItem(response->result, "results") : NULL;
+    if (cJSON_IsArray(results) && (size_t)cJSON_GetArraySize(results) == count) {
+        for (size_t i = 0; i < count; i++) {
+            cJSON *r = cJSON_GetArrayItem(results, (int)i);
+            items[i].result = cJSON_IsNumber(r) ? r->valueint : -1;
+        }
+    }
+    
+    buckets_rpc_response_free(response);
+    
+    buckets_debug("Distributed write xl.meta batch: %zu entries to %s", count, peer_endpoint);
+    
+    return BUCKETS_OK;
+}
+
+int buckets_distributed_invalidate_object(const char *bucket, const char *object)
+{
+    if (!g_rpc_ctx || !bucket || !object) {
+        return 0;
+    }
+    
+    extern buckets_config_t* buckets_get_global_config(void);
+    buckets_config_t *config = buckets_get_global_config();
+    if (!config || !config->cluster.enabled || config->cluster.node_count == 0) {
+        return 0;
+    }
+    
+    int count = config->cluster.node_count;
+    const char **endpoints = buckets_calloc(count, sizeof(char*));
+    buckets_rpc_response_t **responses = buckets_calloc(count, sizeof(buckets_rpc_response_t*));
+    if (!endpoints || !responses) {
+        buckets_free(endpoints);
+        buckets_free(responses);
+        return count;
+    }
+    
+    /* Peers gossip has declared dead are left to the gossip fallback below */
+    int unreachable = 0;
+    for (int i = 0; i < count; i++) {
+        const char *endpoint = config->cluster.nodes[i].endpoint;
+        if (!endpoint || endpoint[0] == '\0' ||
+            (g_local_node_endpoint[0] != '\0' && strcmp(endpoint, g_local_node_endpoint) == 0)) {
+            continue;
+        }
+        if (buckets_gossip_endpoint_dead(g_gossip, endpoint)) {
+            unreachable++;
+            continue;
+        }
+        endpoints[i] = endpoint;
+    }
+    
+    cJSON *params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "bucket", bucket);
+    cJSON_AddStringToObject(params, "object", object);
+    
+    /* All peers at once: one round trip instead of one per peer */
+    buckets_rpc_fanout(g_rpc_ctx, endpoints, count, "storage.invalidateObject",
+                       params, responses, 1000);  /* 1 second timeout */
+    
+    for (int i = 0; i < count; i++) {
+        if (!endpoints[i]) {
+            continue;
+        }
+        if (responses[i]) {
+            buckets_rpc_response_free(responses[i]);
+        } else {
+            buckets_warn("Cache invalidation of %s/%s not delivered to %s",
+                         bucket, object, endpoints[i]);
+            unreachable++;
+        }
+    }
+    
+    /* Gossip reaches the missed peers once they are back or reachable
+     * through others */
+    if (unreachable > 0 && g_gossip) {
+        buckets_gossip_publish_invalidation(g_gossip, bucket, object);
+    }
+    
+    cJSON_Delete(params);
+    buckets_free(endpoints);
+    buckets_free(responses);
+    return unreachable;
+}
+
 /**
  * Read xl.meta from remote node via RPC
  * 
@@ -635,6 +904,11 @@ int buckets_distributed_delete_object(const char *bucket, const char *object)
     char object_path[PATH_MAX];
     buckets_compute_object_path(bucket, object, object_path, sizeof(object_path));
     
+    /* Segments are only found through the manifest: read it before it goes
+     * (no lookup unless segmentation is or was enabled here) */
+    buckets_xl_meta_t manifest;
+    bool segmented = buckets_segments_find_manifest(bucket, object, &manifest);
+    
     /* Use parallel delete */
     extern int buckets_parallel_delete_chunks(const char *bucket,
                                                const char *object,
@@ -643,6 +917,14 @@ int buckets_distributed_delete_object(const char *bucket, const char *object)
     
     ret = buckets_parallel_delete_chunks(bucket, object, object_path, placement);
     
+    if (segmented) {
+        if (ret == 0) {
+            /* A GET may still be reading them through the old manifest */
+            buckets_segments_defer_reclaim(bucket, object, &manifest);
+        }
+        buckets_xl_meta_free(&manifest);
+    }
+    
     /* Delete from registry (only once, not per-disk)
      * Skip registry delete if this IS a registry entry (to avoid recursion) */
     if (strcmp(bucket, ".buckets-registry") != 0) {
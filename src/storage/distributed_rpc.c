@@ -395,6 +395,144 @@ static int rpc_handler_write_xlmeta(const char *method,
     return BUCKETS_OK;
 }
 
+/* ===================================================================
+ * RPC Method: storage.writeXlMetaBatch
+ * 
+ * Writes many xl.meta files to local disks with one group commit.
+ * Used by async replication to coalesce replicas per peer.
+ * 
+ * Request params:
+ * {
+ *   "items": [
+ *     { "bucket": "...", "object": "...", "disk_path": "...", "xl_meta_json": "..." },
+ *     ...
+ *   ]
+ * }
+ * 
+ * At most BUCKETS_XL_META_BATCH_MAX items per request.
+ * 
+ * Response result:
+ * {
+ *   "results": [0, 0, -1, ...]
+ * }
+ * ===================================================================*/
+
+/**
+ * RPC handler: storage.writeXlMetaBatch
+ */
+static int rpc_handler_write_xlmeta_batch(const char *method,
+                                          cJSON *params,
+                                          cJSON **result,
+                                          int *error_code,
+                                          char *error_message,
+                                          void *user_data)
+{
+    (void)method;
+    (void)user_data;
+    
+    *error_code = 0;
+    error_message[0] = '\0';
+    
+    cJSON *items_json = cJSON_GetObjectItem(params, "items");
+    if (!cJSON_IsArray(items_json)) {
+        *error_code = -1;
+        snprintf(error_message, 256, "Missing required parameters");
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    size_t count = (size_t)cJSON_GetArraySize(items_json);
+    if (count > BUCKETS_XL_META_BATCH_MAX) {
+        *error_code = -1;
+        snprintf(error_message, 256, "Batch of %zu entries exceeds %d",
+                 count, BUCKETS_XL_META_BATCH_MAX);
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    buckets_xl_meta_batch_item_t *items = buckets_calloc(count ? count : 1,
+                                                         sizeof(buckets_xl_meta_batch_item_t));
+    
+    size_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        cJSON *item = cJSON_GetArrayItem(items_json, (int)i);
+        cJSON *bucket_json = cJSON_GetObjectItem(item, "bucket");
+        cJSON *object_json = cJSON_GetObjectItem(item, "object");
+        cJSON *disk_path_json = cJSON_GetObjectItem(item, "disk_path");
+        cJSON *xl_meta_json = cJSON_GetObjectItem(item, "xl_meta_json");
+        
+        if (!cJSON_IsString(bucket_json) || !cJSON_IsString(object_json) ||
+            !cJSON_IsString(disk_path_json) || !cJSON_IsString(xl_meta_json)) {
+            *error_code = -1;
+            snprintf(error_message, 256, "Malformed batch entry %zu", i);
+            buckets_free(items);
+            return BUCKETS_ERR_INVALID_ARG;
+        }
+        
+        items[valid].bucket = bucket_json->valuestring;
+        items[valid].object = object_json->valuestring;
+        items[valid].disk_path = disk_path_json->valuestring;
+        items[valid].meta_json = xl_meta_json->valuestring;
+        valid++;
+    }
+    
+    int failed = buckets_write_xl_meta_batch(items, valid);
+    
+    *result = cJSON_CreateObject();
+    cJSON *results = cJSON_AddArrayToObject(*result, "results");
+    for (size_t i = 0; i < valid; i++) {
+        cJSON_AddItemToArray(results, cJSON_CreateNumber(items[i].result));
+    }
+    buckets_free(items);
+    
+    buckets_debug("RPC writeXlMetaBatch: %zu entries (%d failed)", valid, failed);
+    
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * RPC Method: storage.invalidateObject
+ * 
+ * Drops an object from this node's hot object cache after it was
+ * overwritten or deleted through another node.
+ * 
+ * Request params:
+ * {
+ *   "bucket": "mybucket",
+ *   "object": "mykey"
+ * }
+ * ===================================================================*/
+
+/**
+ * RPC handler: storage.invalidateObject
+ */
+static int rpc_handler_invalidate_object(const char *method,
+                                         cJSON *params,
+                                         cJSON **result,
+                                         int *error_code,
+                                         char *error_message,
+                                         void *user_data)
+{
+    (void)method;
+    (void)user_data;
+    
+    *error_code = 0;
+    error_message[0] = '\0';
+    
+    cJSON *bucket_json = cJSON_GetObjectItem(params, "bucket");
+    cJSON *object_json = cJSON_GetObjectItem(params, "object");
+    if (!cJSON_IsString(bucket_json) || !cJSON_IsString(object_json)) {
+        *error_code = -1;
+        snprintf(error_message, 256, "Missing required parameters");
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    
+    buckets_get_coalesce_forget(bucket_json->valuestring, object_json->valuestring);
+    buckets_object_cache_invalidate(bucket_json->valuestring, object_json->valuestring);
+    
+    *result = cJSON_CreateObject();
+    cJSON_AddBoolToObject(*result, "success", true);
+    return BUCKETS_OK;
+}
+
 /* ===================================================================
  * RPC Method: storage.readXlMeta
  * 
@@ -547,29 +685,21 @@ static int rpc_handler_delete_chunk(const char *method, cJSON *params, cJSON **r
     int deleted = 0;
     
     /* Delete chunk file */
-    char chunk_path[PATH_MAX * 2];
-    snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u", disk_path, object_path, chunk_index);
-    if (unlink(chunk_path) == 0) {
-        buckets_debug("RPC deleteChunk: deleted chunk %s", chunk_path);
+    char chunk_name[32];
+    snprintf(chunk_name, sizeof(chunk_name), "part.%u", chunk_index);
+    if (buckets_disk_unlink_file(disk_path, object_path, chunk_name) == 0) {
+        buckets_debug("RPC deleteChunk: deleted chunk %s/%s%s", disk_path, object_path, chunk_name);
         deleted++;
     }
     
     /* Delete xl.meta */
-    char meta_path[PATH_MAX * 2];
-    snprintf(meta_path, sizeof(meta_path), "%s/%sxl.meta", disk_path, object_path);
-    if (unlink(meta_path) == 0) {
-        buckets_debug("RPC deleteChunk: deleted xl.meta %s", meta_path);
+    if (buckets_delete_xl_meta(disk_path, object_path) == 0) {
+        buckets_debug("RPC deleteChunk: deleted xl.meta %s/%sxl.meta", disk_path, object_path);
         deleted++;
     }
     
     /* Try to remove object directory */
-    char dir_path[PATH_MAX * 2];
-    snprintf(dir_path, sizeof(dir_path), "%s/%s", disk_path, object_path);
-    size_t len = strlen(dir_path);
-    if (len > 0 && dir_path[len-1] == '/') {
-        dir_path[len-1] = '\0';
-    }
-    rmdir(dir_path);
+    buckets_disk_rmdir_object(disk_path, object_path);
     
     /* Build success response */
     *result = cJSON_CreateObject();
@@ -686,6 +816,70 @@ static int rpc_handler_create_bucket_dir(const char *method, cJSON *params, cJSO
  * }
  * ===================================================================*/
 
+typedef struct {
+    const char *bucket;
+    const char *prefix;
+    int max_keys;
+    int found;
+    cJSON *objects;
+} list_objects_ctx_t;
+
+/* Add one xl.meta to the listing if it matches bucket and prefix */
+static void list_add_meta(list_objects_ctx_t *list, const char *meta_content)
+{
+    cJSON *meta_json = cJSON_Parse(meta_content);
+    if (!meta_json) return;
+    
+    /* Get bucket and object from xl.meta */
+    cJSON *meta_bucket = cJSON_GetObjectItem(meta_json, "bucket");
+    cJSON *meta_object = cJSON_GetObjectItem(meta_json, "object");
+    
+    if (!meta_bucket || !cJSON_IsString(meta_bucket) ||
+        !meta_object || !cJSON_IsString(meta_object) ||
+        strcmp(meta_bucket->valuestring, list->bucket) != 0 ||   /* Bucket match */
+        meta_bucket->valuestring[0] == '.' ||                    /* Internal buckets */
+        (list->prefix && strncmp(meta_object->valuestring, list->prefix,
+                                 strlen(list->prefix)) != 0)) {
+        cJSON_Delete(meta_json);
+        return;
+    }
+    
+    /* Get size and mod_time from stat */
+    size_t obj_size = 0;
+    const char *mod_time = "";
+    cJSON *stat = cJSON_GetObjectItem(meta_json, "stat");
+    if (stat) {
+        cJSON *size_json = cJSON_GetObjectItem(stat, "size");
+        if (size_json && cJSON_IsNumber(size_json)) {
+            obj_size = (size_t)size_json->valuedouble;
+        }
+        cJSON *mod_time_json = cJSON_GetObjectItem(stat, "modTime");
+        if (mod_time_json && cJSON_IsString(mod_time_json)) {
+            mod_time = mod_time_json->valuestring;
+        }
+    }
+    
+    /* Add to results */
+    cJSON *obj_entry = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj_entry, "bucket", meta_bucket->valuestring);
+    cJSON_AddStringToObject(obj_entry, "object", meta_object->valuestring);
+    cJSON_AddNumberToObject(obj_entry, "size", (double)obj_size);
+    cJSON_AddStringToObject(obj_entry, "mod_time", mod_time);
+    cJSON_AddItemToArray(list->objects, obj_entry);
+    list->found++;
+    
+    cJSON_Delete(meta_json);
+}
+
+static int list_log_entry(const char *object_path, const char *json, size_t len, void *arg)
+{
+    (void)object_path;
+    (void)len;
+    list_objects_ctx_t *list = (list_objects_ctx_t*)arg;
+    list_add_meta(list, json);
+    return list->found >= list->max_keys;
+}
+
 static int rpc_handler_list_objects(const char *method, cJSON *params, cJSON **result,
                                      int *error_code, char *error_message,
                                      void *user_data)
@@ -722,11 +916,16 @@ static int rpc_handler_list_objects(const char *method, cJSON *params, cJSON **r
     const char *base_dir = storage_config->data_dir;
     
     /* Create result array */
-    cJSON *objects_array = cJSON_CreateArray();
-    int found = 0;
+    list_objects_ctx_t list = {
+        .bucket = bucket,
+        .prefix = prefix,
+        .max_keys = max_keys,
+        .found = 0,
+        .objects = cJSON_CreateArray()
+    };
     
     /* Scan all local disks (disk1, disk2, disk3, disk4) */
-    for (int disk_num = 1; disk_num <= 4 && found < max_keys; disk_num++) {
+    for (int disk_num = 1; disk_num <= 4 && list.found < max_keys; disk_num++) {
         char disk_path[PATH_MAX];
         snprintf(disk_path, sizeof(disk_path), "%s/disk%d", base_dir, disk_num);
         
@@ -735,7 +934,7 @@ static int rpc_handler_list_objects(const char *method, cJSON *params, cJSON **r
         
         /* Scan hash prefix directories (00-ff) */
         struct dirent *prefix_entry;
-        while ((prefix_entry = readdir(disk_dir)) != NULL && found < max_keys) {
+        while ((prefix_entry = readdir(disk_dir)) != NULL && list.found < max_keys) {
             if (prefix_entry->d_name[0] == '.') continue;
             if (strlen(prefix_entry->d_name) != 2) continue;
             
@@ -758,9 +957,17 @@ static int rpc_handler_list_objects(const char *method, cJSON *params, cJSON **r
             if (!hash_dir) continue;
             
             struct dirent *hash_entry;
-            while ((hash_entry = readdir(hash_dir)) != NULL && found < max_keys) {
+            while ((hash_entry = readdir(hash_dir)) != NULL && list.found < max_keys) {
                 if (hash_entry->d_name[0] == '.') continue;
                 
+                /* Objects in the metadata log are listed from it below */
+                char object_path[PATH_MAX];
+                snprintf(object_path, sizeof(object_path), "%s/%s/",
+                         prefix_entry->d_name, hash_entry->d_name);
+                if (buckets_meta_log_contains(disk_path, object_path)) {
+                    continue;
+                }
+
                 /* Read xl.meta */
                 char meta_path[PATH_MAX * 2];
                 snprintf(meta_path, sizeof(meta_path), "%s/%s/xl.meta", 
@@ -788,80 +995,28 @@ static int rpc_handler_list_objects(const char *method, cJSON *params, cJSON **r
                 fclose(f);
                 meta_content[read_size] = '\0';
                 
-                /* Parse xl.meta JSON */
-                cJSON *meta_json = cJSON_Parse(meta_content);
+                list_add_meta(&list, meta_content);
                 buckets_free(meta_content);
-                if (!meta_json) continue;
-                
-                /* Get bucket and object from xl.meta */
-                cJSON *meta_bucket = cJSON_GetObjectItem(meta_json, "bucket");
-                cJSON *meta_object = cJSON_GetObjectItem(meta_json, "object");
-                
-                if (!meta_bucket || !cJSON_IsString(meta_bucket) ||
-                    !meta_object || !cJSON_IsString(meta_object)) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Check bucket match */
-                if (strcmp(meta_bucket->valuestring, bucket) != 0) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Skip internal buckets */
-                if (meta_bucket->valuestring[0] == '.') {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Check prefix match */
-                if (prefix && strncmp(meta_object->valuestring, prefix, strlen(prefix)) != 0) {
-                    cJSON_Delete(meta_json);
-                    continue;
-                }
-                
-                /* Get size and mod_time from stat */
-                size_t obj_size = 0;
-                const char *mod_time = "";
-                cJSON *stat = cJSON_GetObjectItem(meta_json, "stat");
-                if (stat) {
-                    cJSON *size_json = cJSON_GetObjectItem(stat, "size");
-                    if (size_json && cJSON_IsNumber(size_json)) {
-                        obj_size = (size_t)size_json->valuedouble;
-                    }
-                    cJSON *mod_time_json = cJSON_GetObjectItem(stat, "modTime");
-                    if (mod_time_json && cJSON_IsString(mod_time_json)) {
-                        mod_time = mod_time_json->valuestring;
-                    }
-                }
-                
-                /* Add to results */
-                cJSON *obj_entry = cJSON_CreateObject();
-                cJSON_AddStringToObject(obj_entry, "bucket", meta_bucket->valuestring);
-                cJSON_AddStringToObject(obj_entry, "object", meta_object->valuestring);
-                cJSON_AddNumberToObject(obj_entry, "size", (double)obj_size);
-                cJSON_AddStringToObject(obj_entry, "mod_time", mod_time);
-                cJSON_AddItemToArray(objects_array, obj_entry);
-                found++;
-                
-                cJSON_Delete(meta_json);
             }
             
             closedir(hash_dir);
         }
         
         closedir(disk_dir);
+
+        if (list.found < max_keys) {
+            buckets_meta_log_foreach(disk_path, list_log_entry, &list);
+        }
     }
     
     /* Build success response */
     *result = cJSON_CreateObject();
     cJSON_AddBoolToObject(*result, "success", true);
-    cJSON_AddItemToObject(*result, "objects", objects_array);
-    cJSON_AddNumberToObject(*result, "count", found);
+    cJSON_AddItemToObject(*result, "objects", list.objects);
+    cJSON_AddNumberToObject(*result, "count", list.found);
     
     buckets_debug("RPC listObjects: bucket=%s prefix=%s found=%d",
-                  bucket, prefix ? prefix : "(none)", found);
+                  bucket, prefix ? prefix : "(none)", list.found);
     
     return BUCKETS_OK;
 }
@@ -903,6 +1058,22 @@ int buckets_distributed_rpc_init(buckets_rpc_context_t *rpc_ctx)
         return ret;
     }
     
+    /* Register writeXlMetaBatch handler */
+    ret = buckets_rpc_register_handler(rpc_ctx, "storage.writeXlMetaBatch",
+                                       rpc_handler_write_xlmeta_batch, NULL);
+    if (ret != BUCKETS_OK) {
+        buckets_error("Failed to register storage.writeXlMetaBatch handler");
+        return ret;
+    }
+    
+    /* Register invalidateObject handler */
+    ret = buckets_rpc_register_handler(rpc_ctx, "storage.invalidateObject",
+                                       rpc_handler_invalidate_object, NULL);
+    if (ret != BUCKETS_OK) {
+        buckets_error("Failed to register storage.invalidateObject handler");
+        return ret;
+    }
+    
     /* Register readXlMeta handler */
     ret = buckets_rpc_register_handler(rpc_ctx, "storage.readXlMeta",
                                        rpc_handler_read_xlmeta, NULL);
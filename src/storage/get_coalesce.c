@@ -0,0 +1,443 @@
+/**
+ * GET Request Coalescing
+ *
+ * Single-flight for object reads: when many clients ask for the same object
+ * at once, the first request (the leader) performs the registry lookup,
+ * shard reads and decode, and identical requests that arrive meanwhile
+ * (followers) wait for it and receive the leader's bytes.
+ *
+ * - Flights are keyed by (bucket, object, version); "" means latest.
+ * - Each caller owns its result buffer, so followers get a copy of the
+ *   decoded object. The last follower out takes the leader's original
+ *   buffer instead of copying it.
+ * - A PUT/DELETE detaches the key's flights: requests that arrive after the
+ *   mutation start a new read instead of joining one that may return the
+ *   previous version. Requests already waiting overlapped the mutation and
+ *   keep the result they attached to.
+ * - Mutations are also counted in a per-key epoch table shared with forked
+ *   BUCKETS_WORKERS siblings. A flight started under an older epoch is not
+ *   joined, so a PUT handled by one worker detaches every worker's reads.
+ * - Event-driven callers join without blocking (buckets_get_coalesce_join):
+ *   they leave a callback instead of a waiting thread, and the leader hands
+ *   them their copy when it lands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_hash.h"
+#include "buckets_mem_budget.h"
+
+#define FLIGHT_TABLE_SIZE 1024
+#define FORGET_EPOCH_SLOTS 4096
+
+/**
+ * Request that joined a flight without blocking
+ */
+typedef struct flight_waiter {
+    buckets_get_flight_cb_t cb;
+    void *arg;
+    struct flight_waiter *next;
+} flight_waiter_t;
+
+/**
+ * One in-progress read
+ */
+typedef struct get_flight {
+    char *bucket;
+    char *object;
+    char *version;                  /* "" = latest */
+    u64 hash;                       /* Of bucket/object only */
+    u64 epoch;                      /* Shared forget epoch at start */
+    bool done;
+    bool detached;                  /* Removed from the table */
+    int result;
+    void *data;                     /* Leader's buffer (owned while shared) */
+    size_t size;
+    u32 followers;                  /* Followers that have not copied yet */
+    flight_waiter_t *waiters;       /* Callbacks to run when it lands */
+    pthread_cond_t cond;
+    struct get_flight *next;
+} get_flight_t;
+
+static get_flight_t *g_flights[FLIGHT_TABLE_SIZE];
+static pthread_mutex_t g_flights_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool g_coalesce_enabled = true;
+static buckets_get_coalesce_stats_t g_coalesce_stats;
+static _Atomic u64 *g_forget_epochs = NULL;     /* MAP_SHARED, set before fork */
+
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static u64 flight_hash(const char *bucket, const char *object)
+{
+    buckets_xxhash_state_t state;
+    buckets_xxhash_init(&state, 0);
+    buckets_xxhash_update(&state, bucket, strlen(bucket) + 1);
+    buckets_xxhash_update(&state, object, strlen(object));
+    return buckets_xxhash_final(&state);
+}
+
+static u64 forget_epoch(u64 hash)
+{
+    return g_forget_epochs ? atomic_load(&g_forget_epochs[hash % FORGET_EPOCH_SLOTS]) : 0;
+}
+
+static void flight_free(get_flight_t *f)
+{
+    pthread_cond_destroy(&f->cond);
+    buckets_free(f->bucket);
+    buckets_free(f->object);
+    buckets_free(f->version);
+    buckets_free(f);
+}
+
+/* Caller holds g_flights_lock */
+static void flight_unlink(get_flight_t *f)
+{
+    get_flight_t **pp = &g_flights[f->hash % FLIGHT_TABLE_SIZE];
+    while (*pp) {
+        if (*pp == f) {
+            *pp = f->next;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+    f->next = NULL;
+    f->detached = true;
+}
+
+/* Caller holds g_flights_lock */
+static get_flight_t* flight_find(u64 hash, const char *bucket, const char *object,
+                                 const char *version)
+{
+    u64 epoch = forget_epoch(hash);
+    get_flight_t *f = g_flights[hash % FLIGHT_TABLE_SIZE];
+    while (f) {
+        get_flight_t *next = f->next;
+        if (f->hash == hash && strcmp(f->bucket, bucket) == 0 &&
+            strcmp(f->object, object) == 0 && strcmp(f->version, version) == 0) {
+            if (f->epoch == epoch) {
+                return f;
+            }
+            /* A sibling worker mutated the object after this read began */
+            flight_unlink(f);
+            g_coalesce_stats.detached++;
+        }
+        f = next;
+    }
+    return NULL;
+}
+
+/* Caller holds g_flights_lock */
+static get_flight_t* flight_start(u64 hash, const char *bucket, const char *object,
+                                  const char *version)
+{
+    get_flight_t *f = buckets_calloc(1, sizeof(get_flight_t));
+    f->bucket = buckets_strdup(bucket);
+    f->object = buckets_strdup(object);
+    f->version = buckets_strdup(version);
+    f->hash = hash;
+    f->epoch = forget_epoch(hash);
+    pthread_cond_init(&f->cond, NULL);
+    f->next = g_flights[hash % FLIGHT_TABLE_SIZE];
+    g_flights[hash % FLIGHT_TABLE_SIZE] = f;
+    g_coalesce_stats.leaders++;
+    g_coalesce_stats.in_flight++;
+    return f;
+}
+
+static void* copy_buffer_uncharged(const void *data, size_t size)
+{
+    void *copy = buckets_malloc(size ? size : 1);
+    if (size) {
+        memcpy(copy, data, size);
+    }
+    return copy;
+}
+
+/* Caller must not hold g_flights_lock (the charge may wait) */
+static void* copy_buffer(const void *data, size_t size)
+{
+    buckets_mem_budget_charge(size);
+    return copy_buffer_uncharged(data, size);
+}
+
+/* Follower side: wait for the leader and take a copy of its result */
+static int flight_follow(get_flight_t *f, void **data, size_t *size)
+{
+    while (!f->done) {
+        pthread_cond_wait(&f->cond, &g_flights_lock);
+    }
+
+    int result = f->result;
+    if (result != 0) {
+        *data = NULL;
+        *size = 0;
+    } else if (f->followers == 1) {
+        /* Everyone else has copied: hand over the original */
+        *data = f->data;
+        *size = f->size;
+        f->data = NULL;
+    } else {
+        pthread_mutex_unlock(&g_flights_lock);
+        *data = copy_buffer(f->data, f->size);
+        *size = f->size;
+        pthread_mutex_lock(&g_flights_lock);
+        g_coalesce_stats.bytes_copied += f->size;
+    }
+
+    if (--f->followers == 0) {
+        buckets_free(f->data);
+        flight_free(f);
+    }
+    return result;
+}
+
+/* ===================================================================
+ * Public API
+ * ===================================================================*/
+
+void buckets_get_coalesce_init_from_env(void)
+{
+    const char *env = getenv("BUCKETS_GET_COALESCE");
+    bool enabled = !(env && (strcmp(env, "0") == 0 || strcmp(env, "off") == 0));
+
+    pthread_mutex_lock(&g_flights_lock);
+    g_coalesce_enabled = enabled;
+    if (!g_forget_epochs) {
+        void *epochs = mmap(NULL, FORGET_EPOCH_SLOTS * sizeof(_Atomic u64),
+                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (epochs != MAP_FAILED) {
+            g_forget_epochs = epochs;
+        } else {
+            buckets_warn("GET coalescing: forget epochs not shared with workers");
+        }
+    }
+    pthread_mutex_unlock(&g_flights_lock);
+
+    if (!enabled) {
+        buckets_info("GET coalescing disabled (BUCKETS_GET_COALESCE=%s)", env);
+    }
+}
+
+void buckets_get_coalesce_set_enabled(bool enabled)
+{
+    pthread_mutex_lock(&g_flights_lock);
+    g_coalesce_enabled = enabled;
+    pthread_mutex_unlock(&g_flights_lock);
+}
+
+int buckets_get_coalesce_do(const char *bucket, const char *object,
+                            const char *version_id,
+                            buckets_get_fetch_fn_t fetch, void *arg,
+                            void **data, size_t *size)
+{
+    if (!bucket || !object || !fetch || !data || !size) {
+        return -1;
+    }
+    const char *version = version_id ? version_id : "";
+
+    pthread_mutex_lock(&g_flights_lock);
+    if (!g_coalesce_enabled) {
+        pthread_mutex_unlock(&g_flights_lock);
+        return fetch(arg, data, size);
+    }
+
+    u64 hash = flight_hash(bucket, object);
+    get_flight_t *f = flight_find(hash, bucket, object, version);
+    if (f) {
+        f->followers++;
+        g_coalesce_stats.followers++;
+        int ret = flight_follow(f, data, size);
+        pthread_mutex_unlock(&g_flights_lock);
+        return ret;
+    }
+    f = flight_start(hash, bucket, object, version);
+    pthread_mutex_unlock(&g_flights_lock);
+
+    void *buf = NULL;
+    size_t len = 0;
+    int ret = fetch(arg, &buf, &len);
+    buckets_get_coalesce_land(f, ret, &buf, &len);
+    *data = buf;
+    *size = len;
+    return ret;
+}
+
+int buckets_get_coalesce_join(const char *bucket, const char *object,
+                              const char *version_id,
+                              buckets_get_flight_cb_t cb, void *arg,
+                              buckets_get_flight_t **flight)
+{
+    if (!flight) {
+        return -1;
+    }
+    *flight = NULL;
+    if (!bucket || !object || !cb) {
+        return -1;
+    }
+    const char *version = version_id ? version_id : "";
+
+    pthread_mutex_lock(&g_flights_lock);
+    if (!g_coalesce_enabled) {
+        pthread_mutex_unlock(&g_flights_lock);
+        return 0;
+    }
+
+    u64 hash = flight_hash(bucket, object);
+    get_flight_t *f = flight_find(hash, bucket, object, version);
+    if (f) {
+        flight_waiter_t *w = buckets_malloc(sizeof(flight_waiter_t));
+        w->cb = cb;
+        w->arg = arg;
+        w->next = f->waiters;
+        f->waiters = w;
+        g_coalesce_stats.followers++;
+        pthread_mutex_unlock(&g_flights_lock);
+        return 1;
+    }
+    *flight = flight_start(hash, bucket, object, version);
+    pthread_mutex_unlock(&g_flights_lock);
+    return 0;
+}
+
+void buckets_get_coalesce_land(buckets_get_flight_t *f, int result,
+                               void **data, size_t *size)
+{
+    if (!f || (result == 0 && (!data || !size))) {
+        return;
+    }
+    void *buf = data ? *data : NULL;
+    size_t len = size ? *size : 0;
+    if (result != 0) {
+        if (buf) {
+            buckets_free(buf);
+        }
+        buf = NULL;
+        len = 0;
+        if (data) {
+            *data = NULL;
+        }
+        if (size) {
+            *size = 0;
+        }
+    }
+
+    /* Once unlinked no one else can join, so the follower count is final */
+    pthread_mutex_lock(&g_flights_lock);
+    if (!f->detached) {
+        flight_unlink(f);
+    }
+    g_coalesce_stats.in_flight--;
+    u32 followers = f->followers;
+    flight_waiter_t *waiters = f->waiters;
+    f->waiters = NULL;
+    pthread_mutex_unlock(&g_flights_lock);
+
+    /* Non-blocking joiners each get a copy straight away, charged by the
+     * joiner's own request rather than this one */
+    u64 copied = 0;
+    while (waiters) {
+        flight_waiter_t *next = waiters->next;
+        void *copy = result == 0 ? copy_buffer_uncharged(buf, len) : NULL;
+        if (result == 0) {
+            copied += len;
+        }
+        waiters->cb(waiters->arg, result, copy, result == 0 ? len : 0);
+        buckets_free(waiters);
+        waiters = next;
+    }
+
+    if (followers == 0) {
+        pthread_mutex_lock(&g_flights_lock);
+        g_coalesce_stats.bytes_copied += copied;
+        pthread_mutex_unlock(&g_flights_lock);
+        flight_free(f);
+        return;
+    }
+
+    /* Take the leader's copy before followers can claim the original */
+    if (result == 0) {
+        *data = copy_buffer(buf, len);
+    }
+
+    pthread_mutex_lock(&g_flights_lock);
+    if (result == 0) {
+        copied += len;
+    }
+    g_coalesce_stats.bytes_copied += copied;
+    f->data = buf;
+    f->size = len;
+    f->result = result;
+    f->done = true;
+    pthread_cond_broadcast(&f->cond);
+    pthread_mutex_unlock(&g_flights_lock);
+}
+
+typedef struct {
+    const char *bucket;
+    const char *object;
+    const char *version_id;
+} object_read_t;
+
+static int fetch_object(void *arg, void **data, size_t *size)
+{
+    object_read_t *r = (object_read_t *)arg;
+    if (r->version_id) {
+        return buckets_get_object_by_version(r->bucket, r->object, r->version_id,
+                                             data, size);
+    }
+    return buckets_get_object(r->bucket, r->object, data, size);
+}
+
+int buckets_get_object_coalesced(const char *bucket, const char *object,
+                                 const char *version_id,
+                                 void **data, size_t *size)
+{
+    object_read_t r = { .bucket = bucket, .object = object, .version_id = version_id };
+    return buckets_get_coalesce_do(bucket, object, version_id, fetch_object, &r,
+                                   data, size);
+}
+
+void buckets_get_coalesce_forget(const char *bucket, const char *object)
+{
+    if (!bucket || !object) {
+        return;
+    }
+
+    u64 hash = flight_hash(bucket, object);
+    if (g_forget_epochs) {
+        atomic_fetch_add(&g_forget_epochs[hash % FORGET_EPOCH_SLOTS], 1);
+    }
+
+    pthread_mutex_lock(&g_flights_lock);
+    get_flight_t *f = g_flights[hash % FLIGHT_TABLE_SIZE];
+    while (f) {
+        get_flight_t *next = f->next;
+        if (f->hash == hash && strcmp(f->bucket, bucket) == 0 &&
+            strcmp(f->object, object) == 0) {
+            flight_unlink(f);
+            g_coalesce_stats.detached++;
+        }
+        f = next;
+    }
+    pthread_mutex_unlock(&g_flights_lock);
+}
+
+void buckets_get_coalesce_get_stats(buckets_get_coalesce_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    pthread_mutex_lock(&g_flights_lock);
+    *stats = g_coalesce_stats;
+    pthread_mutex_unlock(&g_flights_lock);
+}
@@ -96,6 +96,7 @@ static int do_sync(buckets_group_commit_context_t *ctx, int fd)
         return 0;
     }
     
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
     if (ctx->config.use_fdatasync) {
         ret = fdatasync(fd);
     } else {
@@ -255,6 +256,7 @@ ssize_t buckets_group_commit_write(buckets_group_commit_context_t *ctx,
     }
     
     /* Perform write */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
     ssize_t written = write(fd, buf, count);
     if (written < 0) {
         return -1;
@@ -302,6 +304,7 @@ ssize_t buckets_group_commit_pwrite(buckets_group_commit_context_t *ctx,
     }
     
     /* Perform write */
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
     ssize_t written = pwrite(fd, buf, count, offset);
     if (written < 0) {
         return -1;
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -73,7 +74,8 @@ void buckets_compute_object_hash(const char *object_key, char *hash, size_t hash
     snprintf(hash, hash_len, "%016lx", (unsigned long)hash_value);
 }
 
-/* Create directory hierarchy for object */
+/* Create directory hierarchy for object: one mkdirat under the disk's
+ * prefix directory (see disk_dirs.c) */
 int buckets_create_object_dir(const char *disk_path, const char *object_path)
 {
     if (!disk_path || !object_path) {
@@ -81,46 +83,7 @@ int buckets_create_object_dir(const char *disk_path, const char *object_path)
         return -1;
     }
 
-    /* Construct full path */
-    char full_path[PATH_MAX];
-    snprintf(full_path, sizeof(full_path), "%s/%s", disk_path, object_path);
-
-    /* Create directory recursively */
-    char tmp_path[PATH_MAX];
-    char *p = NULL;
-    size_t len;
-
-    snprintf(tmp_path, sizeof(tmp_path), "%s", full_path);
-    len = strlen(tmp_path);
-    
-    /* Remove trailing slash */
-    if (tmp_path[len - 1] == '/') {
-        tmp_path[len - 1] = '\0';
-    }
-
-    /* Create directories one by one */
-    for (p = tmp_path + 1; *p; p++) {
-        if (*p == '/') {
-            *p = '\0';
-            
-            if (mkdir(tmp_path, 0755) != 0 && errno != EEXIST) {
-                buckets_error("Failed to create directory %s: %s",
-                            tmp_path, strerror(errno));
-                return -1;
-            }
-            
-            *p = '/';
-        }
-    }
-
-    /* Create final directory */
-    if (mkdir(tmp_path, 0755) != 0 && errno != EEXIST) {
-        buckets_error("Failed to create directory %s: %s",
-                    tmp_path, strerror(errno));
-        return -1;
-    }
-
-    return 0;
+    return buckets_disk_mkdir_object(disk_path, object_path);
 }
 
 /* Check if object exists */
@@ -130,12 +93,26 @@ bool buckets_object_exists(const char *disk_path, const char *object_path)
         return false;
     }
 
+    if (buckets_meta_log_contains(disk_path, object_path)) {
+        return true;
+    }
+
     /* Check if xl.meta exists */
+    struct stat st;
+    char rel[PATH_MAX];
+    int dirfd = buckets_disk_object_at(disk_path, object_path, "xl.meta", rel, sizeof(rel));
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (dirfd >= 0) {
+        if (fstatat(dirfd, rel, &st, 0) == 0) {
+            return true;
+        }
+        buckets_disk_dirs_io_error(disk_path, errno);
+        return false;
+    }
+
     char meta_path[PATH_MAX];
     snprintf(meta_path, sizeof(meta_path), "%s/%s/xl.meta", 
              disk_path, object_path);
-
-    struct stat st;
     return (stat(meta_path, &st) == 0);
 }
 
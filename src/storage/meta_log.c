@@ -0,0 +1,1115 @@
+/**
+ * Per-Disk Metadata Log
+ *
+ * Optional engine (BUCKETS_META_LOG=on) that keeps xl.meta records in one
+ * append-only file per disk, <disk>/.buckets.sys/meta.log, instead of one
+ * xl.meta file per object directory. A PUT commit or DELETE is a single
+ * O_APPEND write plus a group-committed fdatasync; a HEAD is a hash lookup
+ * and one pread. Only plain object paths (<prefix>/<hash>/) are served;
+ * version directories keep their files.
+ *
+ * Record: fixed header (magic, checksum, object hash, value length, type)
+ * followed by the xl.meta JSON. The in-memory index maps the 64-bit object
+ * hash to the offset of its latest PUT and is rebuilt by replaying the log.
+ *
+ * Forked workers append to the same file. Every process tails the log
+ * (fstat, then replay whatever it has not indexed yet), so the index picks
+ * up other processes' writes in log order. meta.log.lock arbitrates:
+ * appenders hold it shared around their write, recovery and compaction
+ * hold it exclusive. Compaction writes the live records to a new file,
+ * renames it over meta.log and appends a SEAL record to the old one;
+ * processes still reading the old file reopen when they replay the seal.
+ * The seal is only a hint: a compactor can die or fail to write it after
+ * the rename, so every catch-up also checks that its fd is still the file
+ * named meta.log (link count, inode) and reopens if not. Appenders do this
+ * under the shared flock, so no record lands in an unlinked file.
+ *
+ * Objects written before the log was enabled keep their xl.meta files:
+ * lookups that miss the index fall back to the file, and deletes remove
+ * both.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_hash.h"
+#include "buckets_fault.h"
+#include "buckets_group_commit.h"
+
+#define META_LOG_DIR            ".buckets.sys"
+#define META_LOG_FILE           "meta.log"
+#define META_LOG_COMPACT_FILE   "meta.log.compact"
+#define META_LOG_LOCK_FILE      "meta.log.lock"
+
+#define META_LOG_MAGIC          0x474f4c4du     /* "MLOG" */
+#define META_LOG_READ_WINDOW    (1024 * 1024)
+#define META_LOG_MAX_VALUE      (16 * 1024 * 1024)
+#define META_LOG_INDEX_INITIAL  1024
+#define META_LOG_TABLE_SLOTS    (BUCKETS_DISK_DIRS_MAX * 2)
+#define META_LOG_COMPACT_MIN_MB 64
+
+typedef enum {
+    RECORD_PUT = 1,
+    RECORD_DEL = 2,
+    RECORD_SEAL = 3                     /* Log was compacted: reopen meta.log */
+} record_type_t;
+
+typedef struct {
+    u32 magic;
+    u32 checksum;                       /* xxhash64 of the rest of the record */
+    u64 key;                            /* Object hash */
+    u32 value_len;
+    u8 type;
+    u8 reserved[3];
+} meta_record_t;
+
+#define RECORD_HDR ((u64)sizeof(meta_record_t))
+
+typedef struct {
+    u64 key;
+    u64 offset;                         /* Of the record header */
+    u32 value_len;
+    bool used;
+} index_slot_t;
+
+typedef struct {
+    char *disk_path;
+    pid_t pid;                          /* Opened by this process */
+    int sys_fd;                         /* .buckets.sys */
+    int fd;                             /* meta.log, O_APPEND; -1 if unusable */
+    int lock_fd;                        /* meta.log.lock (flock) */
+
+    pthread_rwlock_t rw;                /* Index and fd; write-locked to replay */
+    index_slot_t *slots;
+    u32 capacity;
+    u32 count;
+    u64 indexed_end;                    /* Bytes of the log replayed so far */
+    u64 live_bytes;                     /* Record bytes the index points at */
+
+    /* Group commit: one fdatasync covers every append before it */
+    pthread_mutex_t sync_lock;
+    pthread_cond_t sync_cond;
+    bool syncing;
+    u64 appended;
+    u64 synced;
+
+    u64 appends;
+    u64 syncs;
+    u64 compactions;
+} meta_log_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;               /* Serializes opening logs */
+    bool enabled;
+    u64 compact_min_bytes;
+    meta_log_t *slots[META_LOG_TABLE_SLOTS];
+} g_meta_log = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .enabled = false,
+    .compact_min_bytes = (u64)META_LOG_COMPACT_MIN_MB * 1024 * 1024
+};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static void meta_log_init_once(void)
+{
+    const char *env = getenv("BUCKETS_META_LOG");
+    if (env && (strcmp(env, "1") == 0 || strcmp(env, "on") == 0)) {
+        g_meta_log.enabled = true;
+        buckets_info("Per-disk metadata log enabled");
+    }
+
+    const char *mb = getenv("BUCKETS_META_LOG_COMPACT_MB");
+    if (mb && *mb) {
+        g_meta_log.compact_min_bytes = strtoull(mb, NULL, 10) * 1024 * 1024;
+    }
+}
+
+bool buckets_meta_log_enabled(void)
+{
+    pthread_once(&g_meta_log.once, meta_log_init_once);
+    return g_meta_log.enabled;
+}
+
+void buckets_meta_log_set_enabled(bool enabled)
+{
+    pthread_once(&g_meta_log.once, meta_log_init_once);
+    g_meta_log.enabled = enabled;
+}
+
+/* "<prefix>/<16 hex>/" -> object hash; anything else is not ours */
+static bool path_key(const char *object_path, u64 *key)
+{
+    if (!object_path || strlen(object_path) != 20 ||
+        object_path[2] != '/' || object_path[19] != '/' ||
+        object_path[0] != object_path[3] || object_path[1] != object_path[4]) {
+        return false;
+    }
+
+    u64 k = 0;
+    for (int i = 3; i < 19; i++) {
+        char c = object_path[i];
+        int v = (c >= '0' && c <= '9') ? c - '0' :
+                (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (v < 0) {
+            return false;
+        }
+        k = (k << 4) | (u64)v;
+    }
+    *key = k;
+    return true;
+}
+
+static void key_path(u64 key, char *object_path, size_t len)
+{
+    snprintf(object_path, len, "%02x/%016llx/", (unsigned)(key >> 56),
+             (unsigned long long)key);
+}
+
+static u32 record_checksum(const meta_record_t *hdr, const void *value)
+{
+    buckets_xxhash_state_t st;
+    buckets_xxhash_init(&st, 0);
+    buckets_xxhash_update(&st, (const u8*)hdr + 8, sizeof(*hdr) - 8);
+    if (hdr->value_len > 0) {
+        buckets_xxhash_update(&st, value, hdr->value_len);
+    }
+    return (u32)buckets_xxhash_final(&st);
+}
+
+/* ===================================================================
+ * Index
+ * ===================================================================*/
+
+static inline u32 slot_of(u64 key, u32 capacity)
+{
+    /* Object hashes are already uniform; mix anyway for crafted keys */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (u32)(key & (capacity - 1));
+}
+
+static index_slot_t* index_find(meta_log_t *log, u64 key)
+{
+    u32 i = slot_of(key, log->capacity);
+    while (log->slots[i].used) {
+        if (log->slots[i].key == key) {
+            return &log->slots[i];
+        }
+        i = (i + 1) & (log->capacity - 1);
+    }
+    return NULL;
+}
+
+static void index_insert(index_slot_t *slots, u32 capacity, u64 key,
+                         u64 offset, u32 value_len)
+{
+    u32 i = slot_of(key, capacity);
+    while (slots[i].used && slots[i].key != key) {
+        i = (i + 1) & (capacity - 1);
+    }
+    slots[i].key = key;
+    slots[i].offset = offset;
+    slots[i].value_len = value_len;
+    slots[i].used = true;
+}
+
+static int index_grow(meta_log_t *log)
+{
+    u32 capacity = log->capacity * 2;
+    index_slot_t *slots = buckets_calloc(capacity, sizeof(index_slot_t));
+    if (!slots) {
+        return -1;
+    }
+    for (u32 i = 0; i < log->capacity; i++) {
+        if (log->slots[i].used) {
+            index_insert(slots, capacity, log->slots[i].key,
+                         log->slots[i].offset, log->slots[i].value_len);
+        }
+    }
+    buckets_free(log->slots);
+    log->slots = slots;
+    log->capacity = capacity;
+    return 0;
+}
+
+static void index_put(meta_log_t *log, u64 key, u64 offset, u32 value_len)
+{
+    index_slot_t *s = index_find(log, key);
+    if (s) {
+        log->live_bytes -= RECORD_HDR + s->value_len;
+        s->offset = offset;
+        s->value_len = value_len;
+    } else {
+        if ((log->count + 1) * 10 > log->capacity * 7 && index_grow(log) != 0) {
+            return;
+        }
+        index_insert(log->slots, log->capacity, key, offset, value_len);
+        log->count++;
+    }
+    log->live_bytes += RECORD_HDR + value_len;
+}
+
+/* Linear-probe removal: shift the rest of the cluster back */
+static void index_del(meta_log_t *log, u64 key)
+{
+    index_slot_t *s = index_find(log, key);
+    if (!s) {
+        return;
+    }
+    log->live_bytes -= RECORD_HDR + s->value_len;
+    log->count--;
+
+    u32 mask = log->capacity - 1;
+    u32 hole = (u32)(s - log->slots);
+    u32 i = (hole + 1) & mask;
+    while (log->slots[i].used) {
+        u32 home = slot_of(log->slots[i].key, log->capacity);
+        /* Move i into the hole if its home is not in (hole, i] */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            log->slots[hole] = log->slots[i];
+            hole = i;
+        }
+        i = (i + 1) & mask;
+    }
+    log->slots[hole].used = false;
+}
+
+static void index_reset(meta_log_t *log)
+{
+    memset(log->slots, 0, (size_t)log->capacity * sizeof(index_slot_t));
+    log->count = 0;
+    log->live_bytes = 0;
+    log->indexed_end = 0;
+}
+
+/* ===================================================================
+ * Replay
+ * ===================================================================*/
+
+typedef struct {
+    int fd;
+    u8 *buf;
+    size_t cap;
+    u64 off;                            /* File offset of buf[0] */
+    size_t len;
+} log_reader_t;
+
+/* Bytes [pos, pos + n) of the log, or NULL if not all of them exist yet */
+static const u8* reader_get(log_reader_t *r, u64 pos, size_t n, u64 end)
+{
+    if (pos + n > end) {
+        return NULL;
+    }
+    if (pos >= r->off && pos + n <= r->off + r->len) {
+        return r->buf + (pos - r->off);
+    }
+
+    size_t want = n > META_LOG_READ_WINDOW ? n : META_LOG_READ_WINDOW;
+    if (want > end - pos) {
+        want = (size_t)(end - pos);
+    }
+    if (want > r->cap) {
+        u8 *buf = buckets_realloc(r->buf, want);
+        if (!buf) {
+            return NULL;
+        }
+        r->buf = buf;
+        r->cap = want;
+    }
+
+    size_t got = 0;
+    while (got < want) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_READ);
+        ssize_t k = pread(r->fd, r->buf + got, want - got, (off_t)(pos + got));
+        if (k < 0 && errno == EINTR) {
+            continue;
+        }
+        if (k <= 0) {
+            break;
+        }
+        got += (size_t)k;
+    }
+    r->off = pos;
+    r->len = got;
+    return got >= n ? r->buf : NULL;
+}
+
+typedef enum {
+    REPLAY_OK = 0,
+    REPLAY_SEALED,
+    REPLAY_ERROR
+} replay_result_t;
+
+/**
+ * Index the records appended since the last replay (write lock held)
+ *
+ * Stops at a record that is not complete yet (another process may be
+ * mid-write). A complete record with a bad magic or checksum is
+ * corruption: skip forward to the next record that verifies. With
+ * truncate (recovery, exclusive lock held) an incomplete tail is torn
+ * and cut off.
+ */
+static replay_result_t replay(meta_log_t *log, bool truncate)
+{
+    struct stat st;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (fstat(log->fd, &st) != 0) {
+        return REPLAY_ERROR;
+    }
+    u64 end = (u64)st.st_size;
+    if (end <= log->indexed_end) {
+        return REPLAY_OK;
+    }
+
+    log_reader_t r = { .fd = log->fd };
+    replay_result_t result = REPLAY_OK;
+    u64 pos = log->indexed_end;
+    u64 skipped = 0;
+
+    while (pos < end) {
+        const u8 *p = reader_get(&r, pos, (size_t)RECORD_HDR, end);
+        if (!p) {
+            break;
+        }
+        meta_record_t hdr;
+        memcpy(&hdr, p, sizeof(hdr));
+        if (hdr.magic != META_LOG_MAGIC || hdr.value_len > META_LOG_MAX_VALUE) {
+            pos++;
+            skipped++;
+            continue;
+        }
+
+        p = reader_get(&r, pos, (size_t)(RECORD_HDR + hdr.value_len), end);
+        if (!p) {
+            break;
+        }
+        if (record_checksum(&hdr, p + RECORD_HDR) != hdr.checksum) {
+            pos++;
+            skipped++;
+            continue;
+        }
+
+        if (hdr.type == RECORD_PUT) {
+            index_put(log, hdr.key, pos, hdr.value_len);
+        } else if (hdr.type == RECORD_DEL) {
+            index_del(log, hdr.key);
+        } else if (hdr.type == RECORD_SEAL) {
+            result = REPLAY_SEALED;
+            pos += RECORD_HDR;
+            break;
+        }
+        pos += RECORD_HDR + hdr.value_len;
+    }
+
+    if (skipped > 0) {
+        buckets_warn("Metadata log %s: skipped %lu corrupt bytes", log->disk_path, skipped);
+    }
+    if (truncate && result == REPLAY_OK && pos < end) {
+        buckets_warn("Metadata log %s: truncating %lu byte torn tail",
+                     log->disk_path, end - pos);
+        if (ftruncate(log->fd, (off_t)pos) != 0) {
+            buckets_error("Metadata log %s: truncate failed: %s",
+                          log->disk_path, strerror(errno));
+        }
+    }
+    log->indexed_end = pos;
+    buckets_free(r.buf);
+    return result;
+}
+
+static int open_log_file(meta_log_t *log)
+{
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int fd = openat(log->sys_fd, META_LOG_FILE,
+                    O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        buckets_error("Failed to open metadata log %s/%s/%s: %s", log->disk_path,
+                      META_LOG_DIR, META_LOG_FILE, strerror(errno));
+        return -1;
+    }
+    buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_METADATA, 0, false);
+    return fd;
+}
+
+/* Has meta.log been renamed over or removed since log->fd was opened? */
+static bool log_replaced(meta_log_t *log)
+{
+    struct stat cur, named;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (fstat(log->fd, &cur) != 0) {
+        return false;
+    }
+    if (cur.st_nlink == 0) {
+        return true;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (fstatat(log->sys_fd, META_LOG_FILE, &named, 0) != 0) {
+        return errno == ENOENT;
+    }
+    return named.st_ino != cur.st_ino || named.st_dev != cur.st_dev;
+}
+
+/* Replay to the current end, following seals (or an unsealed rename by a
+ * compactor that failed or died) to the compacted file */
+static int catch_up(meta_log_t *log, bool truncate)
+{
+    for (;;) {
+        replay_result_t r = replay(log, truncate);
+        if (r == REPLAY_ERROR) {
+            return -1;
+        }
+        if (r == REPLAY_OK && !log_replaced(log)) {
+            return 0;
+        }
+
+        /* meta.log now names the compacted file */
+        int fd = open_log_file(log);
+        if (fd < 0) {
+            return -1;
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+        close(log->fd);
+        log->fd = fd;
+        index_reset(log);
+    }
+}
+
+/* ===================================================================
+ * Log Table
+ * ===================================================================*/
+
+static u32 disk_hash(const char *path)
+{
+    u32 h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)path; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static void close_log(meta_log_t *log)
+{
+    if (log->fd >= 0) {
+        close(log->fd);
+    }
+    if (log->lock_fd >= 0) {
+        close(log->lock_fd);
+    }
+    if (log->sys_fd >= 0) {
+        close(log->sys_fd);
+    }
+    pthread_rwlock_destroy(&log->rw);
+    pthread_mutex_destroy(&log->sync_lock);
+    pthread_cond_destroy(&log->sync_cond);
+    buckets_free(log->slots);
+    buckets_free(log->disk_path);
+    buckets_free(log);
+}
+
+/* Open a disk's log and replay it; a log with fd -1 marks a failed disk */
+static meta_log_t* open_log(const char *disk_path)
+{
+    meta_log_t *log = buckets_calloc(1, sizeof(meta_log_t));
+    log->disk_path = buckets_strdup(disk_path);
+    log->pid = getpid();
+    log->fd = -1;
+    log->lock_fd = -1;
+    log->sys_fd = -1;
+    log->capacity = META_LOG_INDEX_INITIAL;
+    log->slots = buckets_calloc(log->capacity, sizeof(index_slot_t));
+    pthread_rwlock_init(&log->rw, NULL);
+    pthread_mutex_init(&log->sync_lock, NULL);
+    pthread_cond_init(&log->sync_cond, NULL);
+
+    char sys_path[PATH_MAX];
+    snprintf(sys_path, sizeof(sys_path), "%s/%s", disk_path, META_LOG_DIR);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_MKDIR);
+    if (mkdir(sys_path, 0755) != 0 && errno != EEXIST) {
+        buckets_error("Failed to create %s: %s", sys_path, strerror(errno));
+        return log;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    log->sys_fd = open(sys_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (log->sys_fd < 0) {
+        return log;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    log->lock_fd = openat(log->sys_fd, META_LOG_LOCK_FILE,
+                          O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (log->lock_fd < 0) {
+        return log;
+    }
+    log->fd = open_log_file(log);
+    if (log->fd < 0) {
+        return log;
+    }
+
+    /* Recovery: with appenders shut out, an incomplete tail is torn */
+    double start = now_ms();
+    flock(log->lock_fd, LOCK_EX);
+    int ret = catch_up(log, true);
+    flock(log->lock_fd, LOCK_UN);
+    if (ret != 0) {
+        close(log->fd);
+        log->fd = -1;
+        return log;
+    }
+
+    buckets_info("Metadata log %s: %u objects, %lu bytes replayed in %.1f ms",
+                 disk_path, log->count, log->indexed_end,
+                 now_ms() - start);
+    return log;
+}
+
+static meta_log_t* lookup(const char *disk_path)
+{
+    u32 slot = disk_hash(disk_path) % META_LOG_TABLE_SLOTS;
+    for (u32 probe = 0; probe < META_LOG_TABLE_SLOTS; probe++) {
+        meta_log_t *log = __atomic_load_n(&g_meta_log.slots[slot], __ATOMIC_ACQUIRE);
+        if (!log) {
+            return NULL;
+        }
+        if (strcmp(log->disk_path, disk_path) == 0) {
+            return log;
+        }
+        slot = (slot + 1) % META_LOG_TABLE_SLOTS;
+    }
+    return NULL;
+}
+
+/* Log serving object_path on disk_path, or NULL to use xl.meta files */
+static meta_log_t* get_log(const char *disk_path, const char *object_path, u64 *key)
+{
+    if (!disk_path || !buckets_meta_log_enabled() || buckets_fault_enabled() ||
+        !path_key(object_path, key)) {
+        return NULL;
+    }
+
+    meta_log_t *log = lookup(disk_path);
+    if (!log) {
+        pthread_mutex_lock(&g_meta_log.lock);
+        log = lookup(disk_path);
+        if (!log) {
+            u32 slot = disk_hash(disk_path) % META_LOG_TABLE_SLOTS;
+            u32 probes = 0;
+            while (g_meta_log.slots[slot] && probes++ < META_LOG_TABLE_SLOTS) {
+                slot = (slot + 1) % META_LOG_TABLE_SLOTS;
+            }
+            if (!g_meta_log.slots[slot]) {
+                log = open_log(disk_path);
+                __atomic_store_n(&g_meta_log.slots[slot], log, __ATOMIC_RELEASE);
+            }
+        }
+        pthread_mutex_unlock(&g_meta_log.lock);
+    }
+    return log && log->fd >= 0 ? log : NULL;
+}
+
+/* Read-lock the log with everything appended so far indexed */
+static int lock_current(meta_log_t *log)
+{
+    pthread_rwlock_rdlock(&log->rw);
+    struct stat st;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_STAT);
+    if (fstat(log->fd, &st) == 0 && (u64)st.st_size <= log->indexed_end &&
+        st.st_nlink > 0) {
+        return 0;
+    }
+    pthread_rwlock_unlock(&log->rw);
+
+    pthread_rwlock_wrlock(&log->rw);
+    int ret = catch_up(log, false);
+    pthread_rwlock_unlock(&log->rw);
+    if (ret != 0) {
+        return -1;
+    }
+    pthread_rwlock_rdlock(&log->rw);
+    return 0;
+}
+
+/* ===================================================================
+ * Append and Group Commit
+ * ===================================================================*/
+
+static bool durability_none(void)
+{
+    buckets_group_commit_context_t *gc = buckets_storage_get_group_commit_ctx();
+    const buckets_group_commit_config_t *cfg = gc ? buckets_group_commit_get_config(gc) : NULL;
+    return cfg && cfg->durability == BUCKETS_DURABILITY_NONE;
+}
+
+static void maybe_compact(meta_log_t *log);
+
+/* Append one record; returns the group commit ticket, 0 on failure */
+static u64 append_record(meta_log_t *log, record_type_t type, u64 key,
+                         const void *value, u32 value_len)
+{
+    size_t len = (size_t)(RECORD_HDR + value_len);
+    u8 *rec = buckets_malloc(len);
+    meta_record_t hdr = {
+        .magic = META_LOG_MAGIC,
+        .key = key,
+        .value_len = value_len,
+        .type = (u8)type
+    };
+    hdr.checksum = record_checksum(&hdr, value);
+    memcpy(rec, &hdr, sizeof(hdr));
+    if (value_len > 0) {
+        memcpy(rec + RECORD_HDR, value, value_len);
+    }
+
+    pthread_rwlock_wrlock(&log->rw);
+    flock(log->lock_fd, LOCK_SH);
+
+    /* A compaction may have replaced this file since we last looked */
+    bool ok = catch_up(log, false) == 0;
+    ssize_t n = -1;
+    if (ok) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+        do {
+            n = write(log->fd, rec, len);
+        } while (n < 0 && errno == EINTR);
+    }
+    flock(log->lock_fd, LOCK_UN);
+
+    if (n != (ssize_t)len) {
+        if (n >= 0) {
+            /* Short write: the partial record fails its checksum on replay */
+            errno = EIO;
+        }
+        buckets_error("Metadata log %s: append failed: %s", log->disk_path, strerror(errno));
+        pthread_rwlock_unlock(&log->rw);
+        buckets_free(rec);
+        return 0;
+    }
+    catch_up(log, false);
+    log->appends++;
+    pthread_rwlock_unlock(&log->rw);
+    buckets_free(rec);
+
+    pthread_mutex_lock(&log->sync_lock);
+    u64 ticket = ++log->appended;
+    pthread_mutex_unlock(&log->sync_lock);
+
+    maybe_compact(log);
+    return ticket;
+}
+
+/* Wait until the append with this ticket is durable; the first waiter
+ * syncs for everyone queued behind it */
+static int sync_ticket(meta_log_t *log, u64 ticket)
+{
+    if (durability_none()) {
+        return 0;
+    }
+
+    int ret = 0;
+    pthread_mutex_lock(&log->sync_lock);
+    while (log->synced < ticket) {
+        if (log->syncing) {
+            pthread_cond_wait(&log->sync_cond, &log->sync_lock);
+            continue;
+        }
+        log->syncing = true;
+        u64 target = log->appended;
+        pthread_mutex_unlock(&log->sync_lock);
+
+        /* dup: a compaction may swap (and close) log->fd meanwhile */
+        pthread_rwlock_rdlock(&log->rw);
+        int fd = dup(log->fd);
+        pthread_rwlock_unlock(&log->rw);
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+        int err = fd >= 0 ? fdatasync(fd) : -1;
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        pthread_mutex_lock(&log->sync_lock);
+        log->syncing = false;
+        log->syncs++;
+        if (err == 0) {
+            log->synced = target > log->synced ? target : log->synced;
+        } else {
+            buckets_error("Metadata log %s: fdatasync failed: %s",
+                          log->disk_path, strerror(errno));
+            ret = -1;
+        }
+        pthread_cond_broadcast(&log->sync_cond);
+        if (ret != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&log->sync_lock);
+    return ret;
+}
+
+/* ===================================================================
+ * Compaction
+ * ===================================================================*/
+
+static bool needs_compaction(const meta_log_t *log)
+{
+    return g_meta_log.compact_min_bytes > 0 &&
+           log->indexed_end >= g_meta_log.compact_min_bytes &&
+           log->live_bytes * 2 < log->indexed_end;
+}
+
+/* Write live records to meta.log.compact and rename it in
+ * (write lock and exclusive flock held) */
+static int compact_locked(meta_log_t *log)
+{
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_OPEN);
+    int out = openat(log->sys_fd, META_LOG_COMPACT_FILE,
+                     O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (out < 0) {
+        buckets_error("Metadata log %s: cannot create compaction file: %s",
+                      log->disk_path, strerror(errno));
+        return -1;
+    }
+    /* KEEP_SIZE: the records are appended after the reservation, not into it */
+    buckets_disk_prepare_file(out, BUCKETS_FILE_LIFE_METADATA,
+                              (size_t)log->live_bytes, true);
+
+    index_slot_t *slots = buckets_calloc(log->capacity, sizeof(index_slot_t));
+    u8 *buf = buckets_malloc(META_LOG_READ_WINDOW);
+    size_t buf_len = 0;
+    u64 out_off = 0;
+    bool ok = true;
+
+    for (u32 i = 0; i < log->capacity && ok; i++) {
+        index_slot_t *s = &log->slots[i];
+        if (!s->used) {
+            continue;
+        }
+        size_t len = (size_t)(RECORD_HDR + s->value_len);
+        if (buf_len + len > META_LOG_READ_WINDOW && buf_len > 0) {
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+            ok = write(out, buf, buf_len) == (ssize_t)buf_len;
+            buf_len = 0;
+        }
+        if (len > META_LOG_READ_WINDOW) {
+            u8 *big = buckets_malloc(len);
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_READ);
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+            ok = ok && pread(log->fd, big, len, (off_t)s->offset) == (ssize_t)len &&
+                 write(out, big, len) == (ssize_t)len;
+            buckets_free(big);
+        } else if (ok) {
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_READ);
+            ok = pread(log->fd, buf + buf_len, len, (off_t)s->offset) == (ssize_t)len;
+            buf_len += len;
+        }
+        slots[i] = *s;
+        slots[i].offset = out_off;
+        out_off += len;
+    }
+    if (ok && buf_len > 0) {
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+        ok = write(out, buf, buf_len) == (ssize_t)buf_len;
+    }
+    buckets_free(buf);
+
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_RENAME);
+    if (!ok || fdatasync(out) != 0 ||
+        renameat(log->sys_fd, META_LOG_COMPACT_FILE, log->sys_fd, META_LOG_FILE) != 0) {
+        buckets_error("Metadata log %s: compaction failed: %s",
+                      log->disk_path, strerror(errno));
+        close(out);
+        unlinkat(log->sys_fd, META_LOG_COMPACT_FILE, 0);
+        buckets_free(slots);
+        return -1;
+    }
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_FSYNC);
+    fsync(log->sys_fd);
+
+    /* Tell other processes still on the old file to reopen */
+    meta_record_t seal = { .magic = META_LOG_MAGIC, .type = RECORD_SEAL };
+    seal.checksum = record_checksum(&seal, NULL);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_WRITE);
+    if (write(log->fd, &seal, sizeof(seal)) != (ssize_t)sizeof(seal)) {
+        buckets_warn("Metadata log %s: failed to seal old log", log->disk_path);
+    }
+
+    u64 before = log->indexed_end;
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+    close(log->fd);
+    log->fd = out;
+    buckets_free(log->slots);
+    log->slots = slots;
+    log->indexed_end = out_off;
+    log->compactions++;
+
+    buckets_info("Metadata log %s compacted: %lu -> %lu bytes (%u objects)",
+                 log->disk_path, before, out_off, log->count);
+    return 0;
+}
+
+static int compact(meta_log_t *log, bool force)
+{
+    pthread_rwlock_wrlock(&log->rw);
+    int ret = 0;
+    /* Skip if another process is appending or compacting right now */
+    if (flock(log->lock_fd, force ? LOCK_EX : LOCK_EX | LOCK_NB) != 0) {
+        pthread_rwlock_unlock(&log->rw);
+        return force ? -1 : 0;
+    }
+    if (catch_up(log, false) != 0) {
+        ret = -1;
+    } else if (force || needs_compaction(log)) {
+        ret = compact_locked(log);
+    }
+    flock(log->lock_fd, LOCK_UN);
+    pthread_rwlock_unlock(&log->rw);
+    return ret;
+}
+
+static void maybe_compact(meta_log_t *log)
+{
+    pthread_rwlock_rdlock(&log->rw);
+    bool due = needs_compaction(log);
+    pthread_rwlock_unlock(&log->rw);
+    if (due) {
+        compact(log, false);
+    }
+}
+
+/* ===================================================================
+ * Public API
+ * ===================================================================*/
+
+int buckets_meta_log_get(const char *disk_path, const char *object_path,
+                         char **json, size_t *len)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, object_path, &key);
+    if (!log) {
+        return BUCKETS_ERR_UNSUPPORTED;
+    }
+    if (!json || !len) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    if (lock_current(log) != 0) {
+        return BUCKETS_ERR_IO;
+    }
+
+    index_slot_t *s = index_find(log, key);
+    if (!s) {
+        pthread_rwlock_unlock(&log->rw);
+        return BUCKETS_ERR_NOT_FOUND;
+    }
+
+    size_t rec_len = (size_t)(RECORD_HDR + s->value_len);
+    u8 *buf = buckets_malloc(rec_len + 1);
+    BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_READ);
+    ssize_t n = pread(log->fd, buf, rec_len, (off_t)s->offset);
+    pthread_rwlock_unlock(&log->rw);
+
+    meta_record_t hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (n != (ssize_t)rec_len || hdr.key != key ||
+        record_checksum(&hdr, buf + RECORD_HDR) != hdr.checksum) {
+        buckets_error("Metadata log %s: bad record for %s", disk_path, object_path);
+        buckets_free(buf);
+        return BUCKETS_ERR_CORRUPT;
+    }
+
+    memmove(buf, buf + RECORD_HDR, hdr.value_len);
+    buf[hdr.value_len] = '\0';
+    *json = (char*)buf;
+    *len = hdr.value_len;
+    return BUCKETS_OK;
+}
+
+bool buckets_meta_log_contains(const char *disk_path, const char *object_path)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, object_path, &key);
+    if (!log || lock_current(log) != 0) {
+        return false;
+    }
+    bool found = index_find(log, key) != NULL;
+    pthread_rwlock_unlock(&log->rw);
+    return found;
+}
+
+int buckets_meta_log_append(const char *disk_path, const char *object_path,
+                            const char *json, size_t len, u64 *ticket)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, object_path, &key);
+    if (!log) {
+        return BUCKETS_ERR_UNSUPPORTED;
+    }
+    if (!json || len > META_LOG_MAX_VALUE) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    u64 t = append_record(log, RECORD_PUT, key, json, (u32)len);
+    if (ticket) {
+        *ticket = t;
+    }
+    return t ? BUCKETS_OK : BUCKETS_ERR_IO;
+}
+
+int buckets_meta_log_sync(const char *disk_path, u64 ticket)
+{
+    u64 key;
+    /* Any path in the log's format resolves the disk */
+    meta_log_t *log = get_log(disk_path, "00/0000000000000000/", &key);
+    if (!log) {
+        return BUCKETS_ERR_UNSUPPORTED;
+    }
+    return sync_ticket(log, ticket) == 0 ? BUCKETS_OK : BUCKETS_ERR_IO;
+}
+
+int buckets_meta_log_put(const char *disk_path, const char *object_path,
+                         const char *json, size_t len)
+{
+    u64 ticket = 0;
+    int ret = buckets_meta_log_append(disk_path, object_path, json, len, &ticket);
+    if (ret != BUCKETS_OK) {
+        return ret;
+    }
+    return buckets_meta_log_sync(disk_path, ticket);
+}
+
+int buckets_meta_log_delete(const char *disk_path, const char *object_path)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, object_path, &key);
+    if (!log) {
+        return BUCKETS_ERR_UNSUPPORTED;
+    }
+    if (!buckets_meta_log_contains(disk_path, object_path)) {
+        return BUCKETS_ERR_NOT_FOUND;
+    }
+
+    u64 ticket = append_record(log, RECORD_DEL, key, NULL, 0);
+    if (!ticket) {
+        return BUCKETS_ERR_IO;
+    }
+    return sync_ticket(log, ticket) == 0 ? BUCKETS_OK : BUCKETS_ERR_IO;
+}
+
+int buckets_meta_log_foreach(const char *disk_path, buckets_meta_log_fn fn, void *arg)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, "00/0000000000000000/", &key);
+    if (!log || !fn) {
+        return log ? BUCKETS_ERR_INVALID_ARG : BUCKETS_ERR_UNSUPPORTED;
+    }
+    if (lock_current(log) != 0) {
+        return BUCKETS_ERR_IO;
+    }
+
+    /* Snapshot the keys; each is then read like a HEAD so fn runs unlocked */
+    u64 *keys = buckets_malloc(((size_t)log->count + 1) * sizeof(u64));
+    u32 count = 0;
+    for (u32 i = 0; i < log->capacity; i++) {
+        if (log->slots[i].used) {
+            keys[count++] = log->slots[i].key;
+        }
+    }
+    pthread_rwlock_unlock(&log->rw);
+
+    for (u32 i = 0; i < count; i++) {
+        char object_path[32];
+        key_path(keys[i], object_path, sizeof(object_path));
+        char *json = NULL;
+        size_t len = 0;
+        if (buckets_meta_log_get(disk_path, object_path, &json, &len) != BUCKETS_OK) {
+            continue;       /* Deleted since the snapshot */
+        }
+        int stop = fn(object_path, json, len, arg);
+        buckets_free(json);
+        if (stop) {
+            break;
+        }
+    }
+    buckets_free(keys);
+    return BUCKETS_OK;
+}
+
+int buckets_meta_log_compact(const char *disk_path)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, "00/0000000000000000/", &key);
+    if (!log) {
+        return BUCKETS_ERR_UNSUPPORTED;
+    }
+    return compact(log, true) == 0 ? BUCKETS_OK : BUCKETS_ERR_IO;
+}
+
+int buckets_meta_log_get_stats(const char *disk_path, buckets_meta_log_stats_t *stats)
+{
+    u64 key;
+    meta_log_t *log = get_log(disk_path, "00/0000000000000000/", &key);
+    if (!log || !stats) {
+        return log ? BUCKETS_ERR_INVALID_ARG : BUCKETS_ERR_UNSUPPORTED;
+    }
+    if (lock_current(log) != 0) {
+        return BUCKETS_ERR_IO;
+    }
+    stats->objects = log->count;
+    stats->live_bytes = log->live_bytes;
+    stats->log_bytes = log->indexed_end;
+    stats->appends = log->appends;
+    stats->compactions = log->compactions;
+    pthread_rwlock_unlock(&log->rw);
+
+    pthread_mutex_lock(&log->sync_lock);
+    stats->syncs = log->syncs;
+    pthread_mutex_unlock(&log->sync_lock);
+    return BUCKETS_OK;
+}
+
+void buckets_meta_log_close_all(void)
+{
+    pthread_mutex_lock(&g_meta_log.lock);
+    for (u32 i = 0; i < META_LOG_TABLE_SLOTS; i++) {
+        meta_log_t *log = g_meta_log.slots[i];
+        if (log) {
+            __atomic_store_n(&g_meta_log.slots[i], NULL, __ATOMIC_RELEASE);
+            close_log(log);
+        }
+    }
+    pthread_mutex_unlock(&g_meta_log.lock);
+}
+
+void buckets_meta_log_reinit_after_fork(void)
+{
+    /* flock belongs to the open file description, which the parent still
+     * holds: drop the inherited logs and reopen our own on first use */
+    pthread_mutex_init(&g_meta_log.lock, NULL);
+    for (u32 i = 0; i < META_LOG_TABLE_SLOTS; i++) {
+        meta_log_t *log = g_meta_log.slots[i];
+        if (log && log->pid != getpid()) {
+            g_meta_log.slots[i] = NULL;
+            pthread_rwlock_init(&log->rw, NULL);
+            pthread_mutex_init(&log->sync_lock, NULL);
+            pthread_cond_init(&log->sync_cond, NULL);
+            close_log(log);
+        }
+    }
+}
@@ -9,11 +9,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "buckets.h"
 #include "buckets_storage.h"
 #include "buckets_json.h"
 #include "buckets_io.h"
+#include "buckets_group_commit.h"
+#include "buckets_io_priority.h"
 #include "cJSON.h"
 
 /* Serialize xl.meta to JSON */
@@ -134,6 +139,16 @@ char* buckets_xl_meta_to_json(const buckets_xl_meta_t *meta)
         cJSON_AddStringToObject(root, "inline", meta->inline_data);
     }
 
+    /* Segment layout (optional) */
+    if (meta->segments.count > 0) {
+        cJSON *segments = cJSON_CreateObject();
+        cJSON_AddNumberToObject(segments, "count", meta->segments.count);
+        cJSON_AddNumberToObject(segments, "size", (double)meta->segments.size);
+        cJSON_AddStringToObject(segments, "prefix",
+                                meta->segments.prefix ? meta->segments.prefix : "");
+        cJSON_AddItemToObject(root, "segments", segments);
+    }
+
     /* Convert to string */
     char *json_str = cJSON_Print(root);
     cJSON_Delete(root);
@@ -364,6 +379,20 @@ int buckets_xl_meta_from_json(const char *json, buckets_xl_meta_t *meta)
         meta->inline_data = buckets_strdup(inline_data->valuestring);
     }
 
+    /* Segment layout */
+    cJSON *segments = cJSON_GetObjectItem(root, "segments");
+    if (segments) {
+        cJSON *count = cJSON_GetObjectItem(segments, "count");
+        cJSON *size = cJSON_GetObjectItem(segments, "size");
+        cJSON *prefix = cJSON_GetObjectItem(segments, "prefix");
+        if (count && cJSON_IsNumber(count) && size && cJSON_IsNumber(size) &&
+            prefix && cJSON_IsString(prefix)) {
+            meta->segments.count = (u32)count->valueint;
+            meta->segments.size = (u64)size->valuedouble;
+            meta->segments.prefix = buckets_strdup(prefix->valuestring);
+        }
+    }
+
     cJSON_Delete(root);
     return 0;
 }
@@ -458,6 +487,13 @@ void buckets_xl_meta_free(buckets_xl_meta_t *meta)
         meta->inline_data = NULL;
     }
 
+    /* Free segment layout */
+    if (meta->segments.prefix) {
+        buckets_free(meta->segments.prefix);
+        meta->segments.prefix = NULL;
+    }
+    meta->segments.count = 0;
+
     /* Free versioning data */
     if (meta->versioning.versionId) {
         buckets_free(meta->versioning.versionId);
@@ -472,25 +508,21 @@ void buckets_xl_meta_free(buckets_xl_meta_t *meta)
     meta->meta.user_count = 0;
 }
 
-/* Read xl.meta from disk */
-int buckets_read_xl_meta(const char *disk_path, const char *object_path,
-                         buckets_xl_meta_t *meta)
+static int read_xl_meta(const char *disk_path, const char *object_path,
+                        buckets_xl_meta_t *meta)
 {
-    if (!disk_path || !object_path || !meta) {
-        buckets_error("NULL parameter in read_xl_meta");
+    char *json = NULL;
+    size_t json_size = 0;
+    int ret = buckets_meta_log_get(disk_path, object_path, &json, &json_size);
+    if (ret == BUCKETS_ERR_CORRUPT || ret == BUCKETS_ERR_IO) {
         return -1;
     }
 
-    /* Construct xl.meta path */
-    char meta_path[PATH_MAX];
-    snprintf(meta_path, sizeof(meta_path), "%s/%sxl.meta", 
-             disk_path, object_path);
-
-    /* Read file */
-    char *json = NULL;
-    size_t json_size = 0;
-    if (buckets_atomic_read(meta_path, (void**)&json, &json_size) != 0) {
-        buckets_error("Failed to read xl.meta: %s", meta_path);
+    /* Not in the log: read the file (relative to the disk's prefix directory) */
+    if (ret != BUCKETS_OK &&
+        buckets_disk_read_file(disk_path, object_path, "xl.meta",
+                               (void**)&json, &json_size) != 0) {
+        buckets_error("Failed to read xl.meta: %s/%sxl.meta", disk_path, object_path);
         return -1;
     }
 
@@ -501,6 +533,21 @@ int buckets_read_xl_meta(const char *disk_path, const char *object_path,
     return result;
 }
 
+/* Read xl.meta from disk (ahead of bulk shard I/O on the same disk) */
+int buckets_read_xl_meta(const char *disk_path, const char *object_path,
+                         buckets_xl_meta_t *meta)
+{
+    if (!disk_path || !object_path || !meta) {
+        buckets_error("NULL parameter in read_xl_meta");
+        return -1;
+    }
+
+    buckets_io_class_t prev = buckets_io_class_set(BUCKETS_IO_CLASS_META);
+    int result = read_xl_meta(disk_path, object_path, meta);
+    buckets_io_class_set(prev);
+    return result;
+}
+
 /* Write xl.meta to disk (atomic) */
 int buckets_write_xl_meta(const char *disk_path, const char *object_path,
                           const buckets_xl_meta_t *meta)
@@ -517,19 +564,208 @@ int buckets_write_xl_meta(const char *disk_path, const char *object_path,
         return -1;
     }
 
-    /* Construct xl.meta path */
-    char meta_path[PATH_MAX];
-    snprintf(meta_path, sizeof(meta_path), "%s/%sxl.meta", 
-             disk_path, object_path);
-
-    /* Write atomically */
-    int result = buckets_atomic_write(meta_path, json, strlen(json));
+    /* Log append, or atomic file write when the log does not apply */
+    buckets_io_class_t prev = buckets_io_class_set(BUCKETS_IO_CLASS_META);
+    int result = buckets_meta_log_put(disk_path, object_path, json, strlen(json));
+    if (result == BUCKETS_ERR_UNSUPPORTED) {
+        result = buckets_disk_write_file(disk_path, object_path, "xl.meta",
+                                         json, strlen(json));
+    }
+    buckets_io_class_set(prev);
     buckets_free(json);
 
     if (result != 0) {
-        buckets_error("Failed to write xl.meta: %s", meta_path);
+        buckets_error("Failed to write xl.meta: %s/%sxl.meta", disk_path, object_path);
         return -1;
     }
 
     return 0;
 }
+
+/* Index of a later entry writing the same file (it wins), or -1 */
+static ssize_t batch_later_duplicate(const buckets_xl_meta_batch_item_t *items,
+                                     size_t count, size_t i)
+{
+    for (size_t j = count; j-- > i + 1;) {
+        if (strcmp(items[j].object, items[i].object) == 0 &&
+            strcmp(items[j].bucket, items[i].bucket) == 0 &&
+            strcmp(items[j].disk_path, items[i].disk_path) == 0) {
+            return (ssize_t)j;
+        }
+    }
+    return -1;
+}
+
+static int write_xl_meta_batch(buckets_xl_meta_batch_item_t *items, size_t count)
+{
+    buckets_group_commit_context_t *gc_ctx = buckets_storage_get_group_commit_ctx();
+    int failed = 0;
+
+    /* Same file twice in one batch: only the last entry is written */
+    ssize_t *winner = buckets_malloc(count * sizeof(ssize_t));
+    for (size_t i = 0; i < count; i++) {
+        winner[i] = batch_later_duplicate(items, count, i);
+    }
+
+    /* Log-backed entries: append them all, then one fdatasync per disk */
+    u64 *tickets = NULL;
+    bool *in_log = NULL;
+    if (buckets_meta_log_enabled()) {
+        tickets = buckets_calloc(count, sizeof(u64));
+        in_log = buckets_calloc(count, sizeof(bool));
+        for (size_t i = 0; i < count; i++) {
+            if (winner[i] >= 0) {
+                continue;
+            }
+            char object_path[PATH_MAX];
+            buckets_compute_object_path(items[i].bucket, items[i].object,
+                                        object_path, sizeof(object_path));
+            int ret = buckets_meta_log_append(items[i].disk_path, object_path,
+                                              items[i].meta_json,
+                                              strlen(items[i].meta_json), &tickets[i]);
+            if (ret == BUCKETS_ERR_UNSUPPORTED) {
+                continue;
+            }
+            in_log[i] = true;
+            items[i].result = ret == BUCKETS_OK ? 1 : -1;   /* 1: synced below */
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (in_log[i] && items[i].result == 1) {
+                items[i].result = buckets_meta_log_sync(items[i].disk_path,
+                                                        tickets[i]) == BUCKETS_OK ? 0 : -1;
+            }
+        }
+    }
+
+    if (!gc_ctx) {
+        /* No group commit: one atomic write (and fsync) per file */
+        for (size_t i = 0; i < count; i++) {
+            if (winner[i] >= 0 || (in_log && in_log[i])) {
+                continue;
+            }
+            char object_path[PATH_MAX];
+            buckets_compute_object_path(items[i].bucket, items[i].object,
+                                        object_path, sizeof(object_path));
+
+            items[i].result = buckets_disk_write_file(items[i].disk_path, object_path,
+                                                      "xl.meta", items[i].meta_json,
+                                                      strlen(items[i].meta_json)) == 0 ? 0 : -1;
+        }
+        goto results;
+    }
+
+    int *fds = buckets_malloc(count * sizeof(int));
+    char (*tmp_names)[64] = buckets_malloc(count * sizeof(*tmp_names));
+
+    /* Phase 1: write every file to its own temporary name */
+    for (size_t i = 0; i < count; i++) {
+        fds[i] = -1;
+        if (winner[i] >= 0 || (in_log && in_log[i])) {
+            continue;
+        }
+        char object_path[PATH_MAX];
+        buckets_compute_object_path(items[i].bucket, items[i].object,
+                                    object_path, sizeof(object_path));
+        items[i].result = -1;
+
+        /* Creates the object directory if missing */
+        buckets_disk_temp_name(tmp_names[i], sizeof(tmp_names[i]), "xl.meta");
+        int fd = buckets_disk_openat(items[i].disk_path, object_path, tmp_names[i],
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            buckets_error("Failed to open %s/%s%s: %s", items[i].disk_path, object_path,
+                          tmp_names[i], strerror(errno));
+            continue;
+        }
+
+        size_t len = strlen(items[i].meta_json);
+        buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_METADATA, len, false);
+        if (buckets_group_commit_write(gc_ctx, fd, items[i].meta_json, len) != (ssize_t)len) {
+            buckets_error("Failed to write %s/%s%s", items[i].disk_path, object_path,
+                          tmp_names[i]);
+            BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+            close(fd);
+            buckets_disk_unlink_file(items[i].disk_path, object_path, tmp_names[i]);
+            continue;
+        }
+        fds[i] = fd;
+    }
+
+    /* Phase 2: one flush makes the whole batch durable */
+    bool synced = (buckets_group_commit_flush_all(gc_ctx) == 0);
+
+    /* Phase 3: publish, then persist the rename */
+    for (size_t i = 0; i < count; i++) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        BUCKETS_ACCOUNT_SYSCALL(BUCKETS_SYS_CLOSE);
+        close(fds[i]);
+
+        char object_path[PATH_MAX];
+        buckets_compute_object_path(items[i].bucket, items[i].object,
+                                    object_path, sizeof(object_path));
+
+        if (!synced || buckets_disk_rename_file(items[i].disk_path, object_path,
+                                                tmp_names[i], "xl.meta") != 0) {
+            buckets_error("Failed to publish %s/%sxl.meta", items[i].disk_path, object_path);
+            buckets_disk_unlink_file(items[i].disk_path, object_path, tmp_names[i]);
+            continue;
+        }
+        if (buckets_disk_sync_object_dir(items[i].disk_path, object_path) != 0) {
+            buckets_error("Failed to sync directory of %s/%sxl.meta",
+                          items[i].disk_path, object_path);
+            continue;
+        }
+        items[i].result = 0;
+    }
+
+    buckets_free(tmp_names);
+    buckets_free(fds);
+
+results:
+    for (size_t i = 0; i < count; i++) {
+        if (winner[i] >= 0) {
+            items[i].result = items[winner[i]].result;
+        }
+        failed += items[i].result != 0;
+    }
+    buckets_free(winner);
+    buckets_free(tickets);
+    buckets_free(in_log);
+    return failed;
+}
+
+/* Write many xl.meta files with one group commit */
+int buckets_write_xl_meta_batch(buckets_xl_meta_batch_item_t *items, size_t count)
+{
+    if (!items) {
+        return (int)count;
+    }
+    if (count > BUCKETS_XL_META_BATCH_MAX) {
+        buckets_error("xl.meta batch of %zu entries exceeds %d", count,
+                      BUCKETS_XL_META_BATCH_MAX);
+        for (size_t i = 0; i < count; i++) {
+            items[i].result = -1;
+        }
+        return (int)count;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    buckets_io_class_t prev = buckets_io_class_set(BUCKETS_IO_CLASS_META);
+    int failed = write_xl_meta_batch(items, count);
+    buckets_io_class_set(prev);
+    return failed;
+}
+
+/* Delete xl.meta: log record and any file from before the log */
+int buckets_delete_xl_meta(const char *disk_path, const char *object_path)
+{
+    buckets_io_class_t prev = buckets_io_class_set(BUCKETS_IO_CLASS_META);
+    int logged = buckets_meta_log_delete(disk_path, object_path);
+    int unlinked = buckets_disk_unlink_file(disk_path, object_path, "xl.meta");
+    buckets_io_class_set(prev);
+    return (logged == BUCKETS_OK || unlinked == 0) ? 0 : -1;
+}
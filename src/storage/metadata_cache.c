@@ -113,6 +113,11 @@ static buckets_xl_meta_t* clone_xl_meta(const buckets_xl_meta_t *src)
     if (src->inline_data) {
         dst->inline_data = buckets_strdup(src->inline_data);
     }
+    if (src->segments.prefix) {
+        dst->segments.count = src->segments.count;
+        dst->segments.size = src->segments.size;
+        dst->segments.prefix = buckets_strdup(src->segments.prefix);
+    }
     if (src->versioning.versionId) {
         dst->versioning.versionId = buckets_strdup(src->versioning.versionId);
     }
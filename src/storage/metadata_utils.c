@@ -143,12 +143,42 @@ int buckets_generate_version_id(char *versionId)
     return 0;
 }
 
+static int put_object_with_metadata_placed(const char *bucket, const char *object,
+                                           const void *data, size_t size,
+                                           buckets_xl_meta_t *provided_meta,
+                                           bool enable_versioning,
+                                           char *versionId);
+
 /* Put object with metadata and versioning */
 int buckets_put_object_with_metadata(const char *bucket, const char *object,
                                      const void *data, size_t size,
                                      buckets_xl_meta_t *provided_meta,
                                      bool enable_versioning,
                                      char *versionId)
+{
+    /* An overwritten segmented object leaves its segments behind (a new
+     * version keeps the old one, segments included) */
+    buckets_xl_meta_t replaced;
+    bool replacing = !enable_versioning &&
+                     buckets_segments_find_manifest(bucket, object, &replaced);
+
+    int result = put_object_with_metadata_placed(bucket, object, data, size, provided_meta,
+                                                 enable_versioning, versionId);
+
+    if (replacing) {
+        if (result == 0) {
+            buckets_segments_defer_reclaim(bucket, object, &replaced);
+        }
+        buckets_xl_meta_free(&replaced);
+    }
+    return result;
+}
+
+static int put_object_with_metadata_placed(const char *bucket, const char *object,
+                                           const void *data, size_t size,
+                                           buckets_xl_meta_t *provided_meta,
+                                           bool enable_versioning,
+                                           char *versionId)
 {
     PROFILE_START(with_metadata_total);
     PROFILE_MARK("PUT with metadata: %s/%s size=%zu", bucket, object, size);
@@ -265,9 +295,29 @@ int buckets_put_object_with_metadata(const char *bucket, const char *object,
     
     /* Store object using existing function */
     int result;
+
+    /* Very large objects: segments spread over every set, xl.meta lists them */
+    if (buckets_segments_should_split(bucket, size)) {
+        result = buckets_write_segments(bucket, object, object_path, placement, disk_path,
+                                        data, size, &meta);
+        buckets_xl_meta_free(&meta);
+        if (result == 0) {
+            extern void record_object_location(const char *bucket, const char *object,
+                                              size_t size, buckets_placement_result_t *placement);
+            record_object_location(bucket, object, size, placement);
+        }
+        if (placement) {
+            buckets_placement_free_result(placement);
+        }
+        return result;
+    }
+
+    /* Replicas below the bucket's size cut-off, erasure coding above */
+    buckets_storage_class_t sc;
+    buckets_storage_class_select(bucket, size, placement ? placement->disk_count : 0, &sc);
     
     /* Check if should inline */
-    if (buckets_should_inline_object(size)) {
+    if (sc.type == BUCKETS_STORAGE_CLASS_INLINE) {
         buckets_debug("Inlining object with metadata (size=%zu)", size);
         
         /* Encode as base64 */
@@ -300,10 +350,13 @@ int buckets_put_object_with_metadata(const char *bucket, const char *object,
             /* Local-only inline: write xl.meta to single disk */
             result = buckets_write_xl_meta(disk_path, object_path, &meta);
         }
+    } else if (sc.type == BUCKETS_STORAGE_CLASS_REPLICATED) {
+        result = buckets_write_replicas(bucket, object, object_path, placement,
+                                        data, size, sc.parity + 1, &meta);
     } else {
         /* Erasure encode large object */
-        u32 k = config->default_ec_k;
-        u32 m = config->default_ec_m;
+        u32 k = sc.data;
+        u32 m = sc.parity;
         
         buckets_debug("Erasure encoding object with metadata: size=%zu, k=%u, m=%u", 
                      size, k, m);
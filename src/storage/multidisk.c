@@ -46,6 +46,43 @@ typedef struct {
 /* Global multi-disk context */
 static multidisk_ctx_t *g_multidisk_ctx = NULL;
 
+/* ===================================================================
+ * Parallel Format Loading
+ * ===================================================================*/
+
+#define FORMAT_LOAD_MAX_THREADS 16
+
+typedef struct {
+    const char **disk_paths;
+    buckets_format_t **formats;
+} format_load_job_t;
+
+static int format_load_worker(void *arg, int i)
+{
+    format_load_job_t *job = (format_load_job_t*)arg;
+    
+    if (job->disk_paths[i]) {
+        job->formats[i] = buckets_format_load(job->disk_paths[i]);
+    }
+    return 0;
+}
+
+/**
+ * Load format.json from every disk, one thread per disk up to a cap
+ * 
+ * @return Array of disk_count formats (NULL where unreadable); caller frees
+ */
+static buckets_format_t** multidisk_load_formats(const char **disk_paths, int disk_count)
+{
+    format_load_job_t job = {
+        .disk_paths = disk_paths,
+        .formats = buckets_calloc(disk_count, sizeof(buckets_format_t*))
+    };
+    
+    buckets_parallel_for(disk_count, FORMAT_LOAD_MAX_THREADS, format_load_worker, &job);
+    return job.formats;
+}
+
 /**
  * Initialize multi-disk context from disk paths
  * 
@@ -71,11 +108,16 @@ int buckets_multidisk_init(const char **disk_paths, int disk_count)
     g_multidisk_ctx = buckets_malloc(sizeof(multidisk_ctx_t));
     memset(g_multidisk_ctx, 0, sizeof(multidisk_ctx_t));
     
-    /* Load format from first disk */
+    /* Load every disk's format once, concurrently */
+    buckets_format_t **formats = multidisk_load_formats(disk_paths, disk_count);
+    
+    /* Use the format from the first disk that has one */
     buckets_format_t *format = NULL;
+    int format_disk = -1;
     for (int i = 0; i < disk_count; i++) {
-        format = buckets_format_load(disk_paths[i]);
-        if (format) {
+        if (formats[i]) {
+            format = formats[i];
+            format_disk = i;
             buckets_info("Loaded format from disk: %s", disk_paths[i]);
             break;
         }
@@ -83,6 +125,7 @@ int buckets_multidisk_init(const char **disk_paths, int disk_count)
     
     if (!format) {
         buckets_error("Failed to load format from any disk");
+        buckets_free(formats);
         buckets_free(g_multidisk_ctx);
         g_multidisk_ctx = NULL;
         return -1;
@@ -111,18 +154,14 @@ int buckets_multidisk_init(const char **disk_paths, int disk_count)
             
             /* Find matching disk path */
             for (int i = 0; i < disk_count; i++) {
-                buckets_format_t *disk_format = buckets_format_load(disk_paths[i]);
-                if (disk_format && strcmp(disk_format->erasure.this_disk, disk_uuid) == 0) {
+                if (formats[i] && strcmp(formats[i]->erasure.this_disk, disk_uuid) == 0) {
                     set->disk_paths[disk_idx] = buckets_strdup(disk_paths[i]);
                     set->disk_online[disk_idx] = true;
-                    buckets_format_free(disk_format);
+                    buckets_disk_dirs_open(disk_paths[i]);
                     buckets_info("Set %d, Disk %d: %s (UUID: %.8s...)", 
                                 set_idx, disk_idx, disk_paths[i], disk_uuid);
                     break;
                 }
-                if (disk_format) {
-                    buckets_format_free(disk_format);
-                }
             }
             
             if (!set->disk_paths[disk_idx]) {
@@ -132,6 +171,14 @@ int buckets_multidisk_init(const char **disk_paths, int disk_count)
         }
     }
     
+    /* The cluster format stays with the context; the rest were only for mapping */
+    for (int i = 0; i < disk_count; i++) {
+        if (i != format_disk && formats[i]) {
+            buckets_format_free(formats[i]);
+        }
+    }
+    buckets_free(formats);
+    
     /* Load topology */
     g_multidisk_ctx->topology = buckets_topology_load(disk_paths[0]);
     if (!g_multidisk_ctx->topology) {
@@ -391,6 +438,34 @@ int buckets_multidisk_get_online_count(int set_index)
     return online_count;
 }
 
+/**
+ * Check whether a local disk is online
+ * 
+ * @param disk_path Disk path
+ * @return false only for a known disk marked offline
+ */
+bool buckets_multidisk_disk_online(const char *disk_path)
+{
+    if (!g_multidisk_ctx || !disk_path) {
+        return true;
+    }
+    
+    bool online = true;
+    pthread_rwlock_rdlock(&g_multidisk_ctx->lock);
+    for (int s = 0; s < g_multidisk_ctx->set_count; s++) {
+        disk_set_t *set = &g_multidisk_ctx->sets[s];
+        for (int i = 0; i < set->disk_count; i++) {
+            if (set->disk_paths[i] && strcmp(set->disk_paths[i], disk_path) == 0) {
+                online = set->disk_online[i];
+                goto out;
+            }
+        }
+    }
+out:
+    pthread_rwlock_unlock(&g_multidisk_ctx->lock);
+    return online;
+}
+
 /**
  * Mark disk as offline
  * 
@@ -414,13 +489,59 @@ int buckets_multidisk_mark_offline(int set_index, int disk_index)
     }
     
     set->disk_online[disk_index] = false;
+    char *path = set->disk_paths[disk_index] ?
+                 buckets_strdup(set->disk_paths[disk_index]) : NULL;
     
     pthread_rwlock_unlock(&g_multidisk_ctx->lock);
     
+    /* Release the disk's directory handles so it can be unmounted */
+    if (path) {
+        buckets_disk_dirs_drop(path);
+        buckets_free(path);
+    }
+    
     buckets_warn("Marked disk offline: set=%d, disk=%d", set_index, disk_index);
     return 0;
 }
 
+/**
+ * Mark disk as online again (replaced or healed disk)
+ * 
+ * @param set_index Set index
+ * @param disk_index Disk index within set
+ * @return 0 on success, -1 on error
+ */
+int buckets_multidisk_mark_online(int set_index, int disk_index)
+{
+    if (!g_multidisk_ctx || set_index < 0 || set_index >= g_multidisk_ctx->set_count) {
+        return -1;
+    }
+    
+    pthread_rwlock_wrlock(&g_multidisk_ctx->lock);
+    
+    disk_set_t *set = &g_multidisk_ctx->sets[set_index];
+    
+    if (disk_index < 0 || disk_index >= set->disk_count) {
+        pthread_rwlock_unlock(&g_multidisk_ctx->lock);
+        return -1;
+    }
+    
+    set->disk_online[disk_index] = true;
+    char *path = set->disk_paths[disk_index] ?
+                 buckets_strdup(set->disk_paths[disk_index]) : NULL;
+    
+    pthread_rwlock_unlock(&g_multidisk_ctx->lock);
+    
+    /* The disk may have been replaced or remounted: never reuse old handles */
+    if (path) {
+        buckets_disk_dirs_reopen(path);
+        buckets_free(path);
+    }
+    
+    buckets_info("Marked disk online: set=%d, disk=%d", set_index, disk_index);
+    return 0;
+}
+
 /**
  * Get cluster statistics
  * 
@@ -653,6 +774,24 @@ int buckets_multidisk_scrub_set(int set_index, bool auto_heal)
     
     buckets_info("Starting scrub of set %d (auto_heal=%d)", set_index, auto_heal);
     
+    /* Bring back offline disks that are formatted again (replaced/remounted) */
+    int found = 0;
+    disk_set_t *set = &g_multidisk_ctx->sets[set_index];
+    for (int i = 0; i < set->disk_count; i++) {
+        pthread_rwlock_rdlock(&g_multidisk_ctx->lock);
+        bool offline = !set->disk_online[i];
+        char *path = set->disk_paths[i] ? buckets_strdup(set->disk_paths[i]) : NULL;
+        pthread_rwlock_unlock(&g_multidisk_ctx->lock);
+        
+        if (offline && path && buckets_disk_is_formatted(path)) {
+            found++;
+            if (auto_heal) {
+                buckets_multidisk_mark_online(set_index, i);
+            }
+        }
+        buckets_free(path);
+    }
+    
     /* TODO: Implement full directory traversal and scrubbing
      * This is a placeholder that would:
      * 1. Enumerate all objects on disks in the set
@@ -663,7 +802,7 @@ int buckets_multidisk_scrub_set(int set_index, bool auto_heal)
      */
     
     buckets_warn("Full scrubbing not yet implemented");
-    return 0;
+    return found;
 }
 
 #pragma GCC diagnostic pop
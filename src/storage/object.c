@@ -21,6 +21,7 @@
 #include "buckets_placement.h"
 #include "buckets_group_commit.h"
 #include "buckets_profile.h"
+#include "buckets_mem_budget.h"
 #include "storage/async_replication.h"
 
 /* Global storage configuration */
@@ -63,6 +64,12 @@ void record_object_location(const char *bucket, const char *object, size_t size,
         return;
     }
     
+    /* Segments are only reached through their object's manifest */
+    if (strcmp(bucket, BUCKETS_SYSTEM_BUCKET) == 0 &&
+        strncmp(object, BUCKETS_SEGMENT_PREFIX, strlen(BUCKETS_SEGMENT_PREFIX)) == 0) {
+        return;
+    }
+    
     /* Check if registry is available (it's optional) */
     /* We check by trying to get config - if NULL, registry not initialized */
     const buckets_registry_config_t *config = buckets_registry_get_config();
@@ -126,13 +133,32 @@ int buckets_storage_init(const buckets_storage_config_t *config)
     g_storage_config.verify_checksums = config->verify_checksums;
 
     /* Initialize group commit for batched fsync */
-    g_group_commit_ctx = buckets_group_commit_init(NULL);  /* Use defaults */
+    const char *durability = getenv("BUCKETS_DURABILITY");
+    if (durability && strcmp(durability, "none") == 0) {
+        buckets_group_commit_config_t gc_config =
+            buckets_group_commit_config_for_durability(BUCKETS_DURABILITY_NONE);
+        g_group_commit_ctx = buckets_group_commit_init(&gc_config);
+    } else if (durability && strcmp(durability, "immediate") == 0) {
+        buckets_group_commit_config_t gc_config =
+            buckets_group_commit_config_for_durability(BUCKETS_DURABILITY_IMMEDIATE);
+        g_group_commit_ctx = buckets_group_commit_init(&gc_config);
+    } else {
+        g_group_commit_ctx = buckets_group_commit_init(NULL);  /* Use defaults */
+    }
     if (!g_group_commit_ctx) {
         buckets_warn("Failed to initialize group commit, will use immediate fsync");
     } else {
         buckets_info("✓ Group commit initialized successfully");
     }
 
+    /* Optional hot object cache (BUCKETS_OBJECT_CACHE_MB) */
+    if (buckets_object_cache_init_from_env() != BUCKETS_OK) {
+        buckets_warn("Failed to initialize object cache, serving GETs from disk");
+    }
+    buckets_get_coalesce_init_from_env();
+    buckets_storage_policy_init_from_env();
+    buckets_segments_open(g_storage_config.data_dir);
+
     buckets_info("Storage initialized: data_dir=%s, inline_threshold=%u, ec=%u+%u",
                  g_storage_config.data_dir, 
                  g_storage_config.inline_threshold,
@@ -145,6 +171,9 @@ int buckets_storage_init(const buckets_storage_config_t *config)
 /* Cleanup storage system */
 void buckets_storage_cleanup(void)
 {
+    buckets_segments_cleanup();
+    buckets_object_cache_cleanup();
+    
     /* Print group commit stats before cleanup */
     if (g_group_commit_ctx) {
         buckets_group_commit_stats_t stats;
@@ -161,6 +190,9 @@ void buckets_storage_cleanup(void)
         buckets_free(g_storage_config.data_dir);
         g_storage_config.data_dir = NULL;
     }
+
+    buckets_meta_log_close_all();
+    buckets_disk_dirs_close_all();
 }
 
 /* Get current storage configuration */
@@ -175,6 +207,32 @@ buckets_group_commit_context_t* buckets_storage_get_group_commit_ctx(void)
     return g_group_commit_ctx;
 }
 
+/* Recreate group commit context with a new durability level */
+int buckets_storage_set_durability(int durability)
+{
+    if (durability < BUCKETS_DURABILITY_NONE || durability > BUCKETS_DURABILITY_IMMEDIATE) {
+        buckets_error("Invalid durability level: %d", durability);
+        return -1;
+    }
+
+    buckets_group_commit_config_t gc_config =
+        buckets_group_commit_config_for_durability((buckets_durability_level_t)durability);
+    buckets_group_commit_context_t *ctx = buckets_group_commit_init(&gc_config);
+    if (!ctx) {
+        buckets_error("Failed to initialize group commit (durability=%d)", durability);
+        return -1;
+    }
+
+    if (g_group_commit_ctx) {
+        buckets_group_commit_flush_all(g_group_commit_ctx);
+        buckets_group_commit_cleanup(g_group_commit_ctx);
+    }
+    g_group_commit_ctx = ctx;
+
+    buckets_info("Group commit durability set to %d", durability);
+    return 0;
+}
+
 /* Base64 encode for inline data */
 static char* base64_encode(const u8 *data, size_t size)
 {
@@ -252,10 +310,34 @@ static u8* base64_decode(const char *encoded, size_t *decoded_size)
     return decoded;
 }
 
+static int put_object_placed(const char *bucket, const char *object,
+                             const void *data, size_t size,
+                             const char *content_type);
+
 /* Put object (write) - with consistent hash placement and distributed erasure coding */
 int buckets_put_object(const char *bucket, const char *object,
                        const void *data, size_t size,
                        const char *content_type)
+{
+    /* Whatever the new object is written as, a segmented one it replaces
+     * leaves its segments behind (looked up only while segments may exist) */
+    buckets_xl_meta_t replaced;
+    bool replacing = buckets_segments_find_manifest(bucket, object, &replaced);
+
+    int result = put_object_placed(bucket, object, data, size, content_type);
+
+    if (replacing) {
+        if (result == 0) {
+            buckets_segments_defer_reclaim(bucket, object, &replaced);
+        }
+        buckets_xl_meta_free(&replaced);
+    }
+    return result;
+}
+
+static int put_object_placed(const char *bucket, const char *object,
+                             const void *data, size_t size,
+                             const char *content_type)
 {
     struct timespec start_total, end_total;
     clock_gettime(CLOCK_MONOTONIC, &start_total);
@@ -326,6 +408,18 @@ int buckets_put_object(const char *bucket, const char *object,
         meta.meta.content_type = buckets_strdup(content_type);
     }
 
+    /* Very large objects: segments spread over every set, xl.meta lists them */
+    if (buckets_segments_should_split(bucket, size)) {
+        result = buckets_write_segments(bucket, object, object_path, placement, disk_path,
+                                        data, size, &meta);
+        if (result == 0) {
+            record_object_location(bucket, object, size, placement);
+        }
+        buckets_xl_meta_free(&meta);
+        buckets_placement_free_result(placement);
+        return result;
+    }
+
     /* Check if should inline */
     if (buckets_should_inline_object(size)) {
         buckets_debug("Inlining object (size=%zu)", size);
@@ -398,9 +492,25 @@ int buckets_put_object(const char *bucket, const char *object,
         return result;
     }
 
+    /* Storage class: whole-object replicas below the policy's size cut-off,
+     * erasure coding above it */
+    buckets_storage_class_t sc;
+    buckets_storage_class_select(bucket, size, placement ? placement->disk_count : 0, &sc);
+
+    if (sc.type == BUCKETS_STORAGE_CLASS_REPLICATED) {
+        result = buckets_write_replicas(bucket, object, object_path, placement,
+                                        data, size, sc.parity + 1, &meta);
+        if (result == 0) {
+            record_object_location(bucket, object, size, placement);
+        }
+        buckets_xl_meta_free(&meta);
+        buckets_placement_free_result(placement);
+        return result;
+    }
+
     /* Erasure encode */
-    u32 k = g_storage_config.default_ec_k;
-    u32 m = g_storage_config.default_ec_m;
+    u32 k = sc.data;
+    u32 m = sc.parity;
     
     PROFILE_START(put_total);
     PROFILE_MARK("═══════ PUT OBJECT: %s/%s size=%zu ═══════", bucket, object, size);
@@ -565,15 +675,15 @@ int buckets_put_object(const char *bucket, const char *object,
         struct timespec start_write, end_write;
         clock_gettime(CLOCK_MONOTONIC, &start_write);
         
-        extern int buckets_batched_parallel_write_chunks(const char *bucket, const char *object,
-                                                         const char *object_path,
-                                                         buckets_placement_result_t *placement,
-                                                         const void **chunk_data_array,
-                                                         size_t chunk_size, u32 num_chunks);
+        /* Acknowledge at write quorum (all shards unless configured lower) */
+        u32 write_quorum = buckets_write_quorum(k, m);
         
-        PROFILE_MARK("Starting batched chunk writes: %u chunks, chunk_size=%zu", k + m, chunk_size);
-        int write_result = buckets_batched_parallel_write_chunks(bucket, object, object_path, placement,
-                                                                 chunk_array, chunk_size, k + m);
+        PROFILE_MARK("Starting batched chunk writes: %u chunks, chunk_size=%zu, quorum=%u",
+                     k + m, chunk_size, write_quorum);
+        int write_result = buckets_batched_parallel_write_chunks_quorum(bucket, object, object_path,
+                                                                        placement, chunk_array,
+                                                                        chunk_size, k + m,
+                                                                        write_quorum, &meta);
         
         clock_gettime(CLOCK_MONOTONIC, &end_write);
         double write_time = (end_write.tv_sec - start_write.tv_sec) + 
@@ -590,25 +700,16 @@ int buckets_put_object(const char *bucket, const char *object,
         
         buckets_info("⏱️  Parallel chunk writes: %.3f ms (%.2f MB/s)", 
                      write_time * 1000, (size / 1024.0 / 1024.0) / write_time);
-        buckets_info("Parallel write complete: %u chunks written", k + m);
+        buckets_info("Parallel write committed: %u/%u chunks required", write_quorum, k + m);
         
         /* Write xl.meta to all disks (local and remote) in PARALLEL */
         PROFILE_START(metadata);
         struct timespec start_meta, end_meta;
         clock_gettime(CLOCK_MONOTONIC, &start_meta);
         
-        extern int buckets_parallel_write_metadata(const char *bucket,
-                                                   const char *object,
-                                                   const char *object_path,
-                                                   buckets_placement_result_t *placement,
-                                                   char **disk_paths,
-                                                   const buckets_xl_meta_t *base_meta,
-                                                   u32 num_disks,
-                                                   bool has_endpoints);
-        
-        result = buckets_parallel_write_metadata(bucket, object, object_path,
-                                                 placement, set_disk_paths, &meta,
-                                                 k + m, has_endpoints);
+        result = buckets_parallel_write_metadata_quorum(bucket, object, object_path,
+                                                        placement, set_disk_paths, &meta,
+                                                        k + m, has_endpoints, write_quorum);
         
         clock_gettime(CLOCK_MONOTONIC, &end_meta);
         double meta_time = (end_meta.tv_sec - start_meta.tv_sec) + 
@@ -646,23 +747,28 @@ cleanup_chunks:
     return result;
 }
 
-/* Get object (read) - with registry lookup and multi-disk erasure decoding */
-int buckets_get_object(const char *bucket, const char *object,
-                       void **data, size_t *size)
+/* ===================================================================
+ * Staged Object Read
+ * ===================================================================*/
+
+int buckets_object_read_locate(buckets_object_read_t *rd,
+                               const char *bucket, const char *object)
 {
-    buckets_debug("GET object: %s/%s", bucket ? bucket : "(null)", 
-                  object ? object : "(null)");
-    
-    if (!bucket || !object || !data || !size) {
-        buckets_error("NULL parameter in get_object");
+    if (!rd) {
         return -1;
     }
+    memset(rd, 0, sizeof(*rd));
+    if (!bucket || !object) {
+        buckets_error("NULL parameter in object_read_locate");
+        return -1;
+    }
+    rd->bucket = buckets_strdup(bucket);
+    rd->object = buckets_strdup(object);
 
     /* Compute object path */
-    char object_path[PATH_MAX];
-    buckets_compute_object_path(bucket, object, object_path, sizeof(object_path));
+    buckets_compute_object_path(bucket, object, rd->object_path, sizeof(rd->object_path));
     
-    buckets_debug("Object path: %s", object_path);
+    buckets_debug("Object path: %s", rd->object_path);
 
     /* Try registry lookup first to find object location */
     buckets_object_location_t *location = NULL;
@@ -703,6 +809,10 @@ int buckets_get_object(const char *bucket, const char *object,
         buckets_info("GET_OBJECT_DEBUG: Registry miss, computing placement");
         buckets_debug("Registry miss, computing placement");
         
+        if (placement) {
+            buckets_placement_free_result(placement);
+            placement = NULL;
+        }
         if (buckets_placement_compute(bucket, object, &placement) == 0) {
             set_disk_paths = placement->disk_paths;
             set_disk_count = placement->disk_count;
@@ -737,9 +847,12 @@ int buckets_get_object(const char *bucket, const char *object,
     if (location) {
         buckets_registry_location_free(location);
     }
+    rd->placement = placement;
+    rd->disk_paths = set_disk_paths;
+    rd->disk_count = set_disk_count;
 
     /* Try to read xl.meta from first available disk (local or remote) */
-    buckets_xl_meta_t meta;
+    buckets_xl_meta_t *meta = &rd->meta;
     int meta_found = 0;
     
     buckets_debug("Reading xl.meta: set_disk_count=%d, placement=%p", 
@@ -752,7 +865,7 @@ int buckets_get_object(const char *bucket, const char *object,
     
     for (int i = 0; i < set_disk_count && !meta_found; i++) {
         /* Try local read first */
-        if (buckets_read_xl_meta(set_disk_paths[i], object_path, &meta) == 0) {
+        if (buckets_read_xl_meta(set_disk_paths[i], rd->object_path, meta) == 0) {
             buckets_debug("Read xl.meta from local disk %d: %s", i + 1, set_disk_paths[i]);
             meta_found = 1;
             break;
@@ -780,7 +893,7 @@ int buckets_get_object(const char *bucket, const char *object,
                                                               buckets_xl_meta_t *meta);
                     
                     int ret = buckets_distributed_read_xlmeta(node_endpoint, bucket, object,
-                                                             set_disk_paths[i], &meta);
+                                                             set_disk_paths[i], meta);
                     if (ret == 0) {
                         buckets_debug("Read xl.meta from remote disk %d via RPC: %s:%s", 
                                      i + 1, node_endpoint, set_disk_paths[i]);
@@ -797,104 +910,146 @@ int buckets_get_object(const char *bucket, const char *object,
                      bucket, object);
         return -1;
     }
+    rd->have_meta = true;
 
-    /* Check if inline */
-    if (meta.inline_data) {
-        buckets_debug("Reading inline object");
-        *data = base64_decode(meta.inline_data, size);
-        buckets_xl_meta_free(&meta);
-        if (placement) {
-            buckets_placement_free_result(placement);
-        }
+    if (meta->inline_data) {
         return 0;
     }
 
-    /* Read chunks from distributed disks */
-    u32 k = meta.erasure.data;
-    u32 m = meta.erasure.parity;
-    size_t chunk_size = meta.erasure.blockSize;
-    u32 total_chunks = k + m;
+    if (buckets_xl_meta_is_segmented(meta)) {
+        /* No shards here: each segment is read (and charged) as an object */
+        buckets_debug("Reading segmented object: %u segments, size=%zu",
+                      meta->segments.count, meta->stat.size);
+        return 0;
+    }
 
-    buckets_debug("Reading erasure-coded object: k=%u, m=%u, chunk_size=%zu, total_chunks=%u (PARALLEL)",
-                  k, m, chunk_size, total_chunks);
+    rd->k = meta->erasure.data;
+    rd->m = meta->erasure.parity;
+    if (rd->k == 0 || rd->k + rd->m > BUCKETS_MAX_CHUNKS) {
+        buckets_error("Invalid erasure layout for %s/%s: k=%u, m=%u",
+                     bucket, object, rd->k, rd->m);
+        return -1;
+    }
 
-    /* Allocate chunk arrays */
-    u8 *chunks[total_chunks];
-    size_t chunk_sizes[total_chunks];
-    
-    /* Initialize chunk arrays */
-    for (u32 i = 0; i < total_chunks; i++) {
-        chunks[i] = NULL;
-        chunk_sizes[i] = 0;
+    if (buckets_xl_meta_is_replicated(meta)) {
+        /* One copy is the object: nothing to decode */
+        buckets_debug("Reading replicated object: %u copies, size=%zu",
+                      rd->k + rd->m, meta->stat.size);
+        buckets_mem_budget_charge((u64)meta->erasure.blockSize);
+        return 0;
     }
-    
-    int available_chunks = 0;
-    
-    /* Use parallel reads if placement is available, otherwise sequential */
-    if (placement) {
-        /* Read all chunks in parallel */
-        extern int buckets_parallel_read_chunks(const char *bucket, const char *object,
-                                                const char *object_path,
-                                                buckets_placement_result_t *placement,
-                                                void **chunk_data_array,
-                                                size_t *chunk_sizes_array,
-                                                u32 num_chunks);
-        
-        available_chunks = buckets_parallel_read_chunks(bucket, object, object_path, placement,
-                                                            (void**)chunks, chunk_sizes, total_chunks);
-        
-        if (available_chunks < 0) {
-            buckets_error("Parallel chunk read failed");
-            buckets_xl_meta_free(&meta);
-            buckets_placement_free_result(placement);
+
+    buckets_debug("Reading erasure-coded object: k=%u, m=%u, chunk_size=%zu, total_chunks=%u",
+                  rd->k, rd->m, meta->erasure.blockSize, rd->k + rd->m);
+
+    /* Shards, then the decoded object that replaces them */
+    buckets_mem_budget_charge((u64)meta->erasure.blockSize * (rd->k + rd->m));
+    return 0;
+}
+
+int buckets_object_read_shard(buckets_object_read_t *rd, u32 index)
+{
+    if (!rd || !rd->have_meta || index >= rd->k + rd->m || rd->shards[index]) {
+        return -1;
+    }
+
+    if (rd->placement && buckets_xl_meta_is_replicated(&rd->meta)) {
+        /* Copies live on the disks recorded in erasure.distribution */
+        buckets_replica_view_t view;
+        if (buckets_replica_view(rd->placement, &rd->meta, &view) != 0) {
             return -1;
         }
-    } else {
-        /* No placement - read chunks sequentially from single disk */
-        buckets_warn("No placement available, using sequential single-disk read");
-        
-        extern int buckets_read_chunk(const char *disk_path, const char *object_path,
-                                      u32 chunk_index, void **data, size_t *size);
-        
-        const char *disk_path = set_disk_paths[0];
-        
-        for (u32 i = 0; i < total_chunks; i++) {
-            void *chunk_data = NULL;
-            size_t chunk_len = 0;
-            
-            if (buckets_read_chunk(disk_path, object_path, i + 1, &chunk_data, &chunk_len) == 0) {
-                chunks[i] = chunk_data;
-                chunk_sizes[i] = chunk_len;
-                available_chunks++;
-            }
+        return buckets_read_placed_chunk(rd->bucket, rd->object, rd->object_path,
+                                         &view.placement, index,
+                                         &rd->shards[index], &rd->shard_sizes[index]);
+    }
+
+    if (rd->placement) {
+        return buckets_read_placed_chunk(rd->bucket, rd->object, rd->object_path,
+                                         rd->placement, index,
+                                         &rd->shards[index], &rd->shard_sizes[index]);
+    }
+
+    /* No placement - every shard lives on the single fallback disk */
+    extern int buckets_read_chunk(const char *disk_path, const char *object_path,
+                                  u32 chunk_index, void **data, size_t *size);
+    return buckets_read_chunk(rd->disk_paths[0], rd->object_path, index + 1,
+                              &rd->shards[index], &rd->shard_sizes[index]);
+}
+
+u32 buckets_object_read_shards_available(const buckets_object_read_t *rd)
+{
+    u32 available = 0;
+    for (u32 i = 0; rd && i < rd->k + rd->m; i++) {
+        if (rd->shards[i]) {
+            available++;
         }
     }
-    
-    u32 available_chunks_u32 = (u32)available_chunks;
-    buckets_info("Parallel read: %u/%u chunks available", available_chunks_u32, total_chunks);
+    return available;
+}
+
+int buckets_object_read_decode(buckets_object_read_t *rd, void **data, size_t *size)
+{
+    if (!rd || !rd->have_meta || !data || !size) {
+        return -1;
+    }
+
+    /* Check if inline */
+    if (rd->meta.inline_data) {
+        buckets_debug("Reading inline object");
+        *data = base64_decode(rd->meta.inline_data, size);
+        return *data ? 0 : -1;
+    }
+
+    if (buckets_xl_meta_is_segmented(&rd->meta)) {
+        if (buckets_read_segments(&rd->meta, data, size) != 0) {
+            return -1;
+        }
+        buckets_info("Object read: %s/%s (size=%zu, %u segments)", rd->bucket, rd->object,
+                     *size, rd->meta.segments.count);
+        return 0;
+    }
+
+    /* Replicated: hand over the first intact copy; corrupt ones are dropped
+     * so a retry reads the others */
+    if (buckets_xl_meta_is_replicated(&rd->meta)) {
+        if (buckets_replica_pick(&rd->meta, rd->shards, rd->shard_sizes,
+                                 rd->k + rd->m, data, size) != 0) {
+            return -1;
+        }
+        buckets_info("Object read: %s/%s (size=%zu, replicated)", rd->bucket, rd->object, *size);
+        return 0;
+    }
+
+    u32 k = rd->k;
+    u32 m = rd->m;
+    u32 total_chunks = k + m;
+    size_t chunk_size = rd->meta.erasure.blockSize;
+    u32 available_chunks = buckets_object_read_shards_available(rd);
+    buckets_info("Parallel read: %u/%u chunks available", available_chunks, total_chunks);
     
     /* Check if we have enough chunks to reconstruct (need at least K) */
-    if (available_chunks_u32 < k) {
+    if (available_chunks < k) {
         buckets_error("Not enough chunks available: %u/%u (need at least %u)", 
-                     available_chunks_u32, total_chunks, k);
-        goto cleanup_read;
+                     available_chunks, total_chunks, k);
+        return -1;
     }
     
     buckets_info("Successfully read %u/%u chunks (need %u for reconstruction)", 
                 available_chunks, total_chunks, k);
 
     /* Allocate output buffer */
-    *data = buckets_malloc(meta.stat.size);
-    *size = meta.stat.size;
+    *data = buckets_malloc(rd->meta.stat.size);
+    *size = rd->meta.stat.size;
 
     /* Decode object */
     buckets_debug("Preparing to decode: k=%u, m=%u, chunk_size=%zu, data_size=%zu",
-                 k, m, chunk_size, meta.stat.size);
+                 k, m, chunk_size, rd->meta.stat.size);
     
     /* Debug: show which chunks are available */
     for (u32 i = 0; i < total_chunks; i++) {
-        if (chunks[i]) {
-            buckets_debug("  Chunk %u: available (%p)", i, (void*)chunks[i]);
+        if (rd->shards[i]) {
+            buckets_debug("  Chunk %u: available (%p)", i, rd->shards[i]);
         } else {
             buckets_debug("  Chunk %u: NULL", i);
         }
@@ -905,47 +1060,108 @@ int buckets_get_object(const char *bucket, const char *object,
         buckets_error("Failed to initialize erasure context");
         buckets_free(*data);
         *data = NULL;
-        goto cleanup_read;
+        return -1;
     }
 
-    if (buckets_ec_decode(&ec_ctx, chunks, chunk_size, *data, meta.stat.size) != 0) {
+    if (buckets_ec_decode(&ec_ctx, (u8 **)rd->shards, chunk_size, *data, rd->meta.stat.size) != 0) {
         buckets_error("Failed to decode object");
         buckets_ec_free(&ec_ctx);
         buckets_free(*data);
         *data = NULL;
-        goto cleanup_read;
+        return -1;
     }
     
     buckets_debug("Decode completed successfully");
     
     buckets_ec_free(&ec_ctx);
-    buckets_info("Object read: %s/%s (size=%zu)", bucket, object, *size);
+    buckets_info("Object read: %s/%s (size=%zu)", rd->bucket, rd->object, *size);
+    return 0;
+}
 
-    /* Success - free chunks and metadata */
-    for (u32 i = 0; i < total_chunks; i++) {
-        if (chunks[i]) {
-            buckets_free(chunks[i]);
+void buckets_object_read_free(buckets_object_read_t *rd)
+{
+    if (!rd) {
+        return;
+    }
+    for (u32 i = 0; i < BUCKETS_MAX_CHUNKS; i++) {
+        if (rd->shards[i]) {
+            buckets_free(rd->shards[i]);
+            rd->shards[i] = NULL;
         }
     }
-    buckets_xl_meta_free(&meta);
-    if (placement) {
-        buckets_placement_free_result(placement);
+    if (rd->have_meta) {
+        buckets_xl_meta_free(&rd->meta);
+        rd->have_meta = false;
     }
-    return 0;
+    if (rd->placement) {
+        buckets_placement_free_result(rd->placement);
+        rd->placement = NULL;
+    }
+    buckets_free(rd->bucket);
+    buckets_free(rd->object);
+    rd->bucket = NULL;
+    rd->object = NULL;
+}
 
-cleanup_read:
-    /* Error cleanup - free any allocated chunks */
-    for (u32 i = 0; i < total_chunks; i++) {
-        if (chunks[i]) {
-            buckets_free(chunks[i]);
+/* Get object (read) - with registry lookup and multi-disk erasure decoding */
+int buckets_get_object(const char *bucket, const char *object,
+                       void **data, size_t *size)
+{
+    buckets_debug("GET object: %s/%s", bucket ? bucket : "(null)", 
+                  object ? object : "(null)");
+    
+    if (!bucket || !object || !data || !size) {
+        buckets_error("NULL parameter in get_object");
+        return -1;
+    }
+
+    buckets_object_read_t rd;
+    int ret = -1;
+    if (buckets_object_read_locate(&rd, bucket, object) != 0) {
+        goto out;
+    }
+
+    /* Replicated: one copy at a time until an intact one decodes */
+    if (buckets_xl_meta_is_replicated(&rd.meta)) {
+        for (u32 i = 0; i < rd.k + rd.m && ret != 0; i++) {
+            if (buckets_object_read_shard(&rd, i) == 0) {
+                ret = buckets_object_read_decode(&rd, data, size);
+            }
         }
+        goto out;
     }
-    buckets_xl_meta_free(&meta);
-    if (placement) {
-        buckets_placement_free_result(placement);
+
+    /* Read chunks from distributed disks (none for inline and segmented) */
+    if (rd.k > 0) {
+        u32 total_chunks = rd.k + rd.m;
+        if (rd.placement) {
+            /* Read all chunks in parallel */
+            extern int buckets_parallel_read_chunks(const char *bucket, const char *object,
+                                                    const char *object_path,
+                                                    buckets_placement_result_t *placement,
+                                                    void **chunk_data_array,
+                                                    size_t *chunk_sizes_array,
+                                                    u32 num_chunks);
+            
+            if (buckets_parallel_read_chunks(bucket, object, rd.object_path, rd.placement,
+                                             rd.shards, rd.shard_sizes, total_chunks) < 0) {
+                buckets_error("Parallel chunk read failed");
+                goto out;
+            }
+        } else {
+            /* No placement - read chunks sequentially from single disk */
+            buckets_warn("No placement available, using sequential single-disk read");
+            for (u32 i = 0; i < total_chunks; i++) {
+                buckets_object_read_shard(&rd, i);
+            }
+        }
     }
 
-    return -1;
+    ret = buckets_object_read_decode(&rd, data, size);
+
+out:
+    buckets_object_read_free(&rd);
+    return ret;
 }
 
 /* Delete object */
@@ -980,19 +1196,13 @@ int buckets_delete_object(const char *bucket, const char *object)
     }
 
     /* Delete xl.meta */
-    char meta_path[PATH_MAX * 2];
-    snprintf(meta_path, sizeof(meta_path), "%s/%sxl.meta", disk_path, object_path);
-    unlink(meta_path);
+    buckets_delete_xl_meta(disk_path, object_path);
+
+    /* Segments may still be streaming to a reader of this manifest */
+    buckets_segments_defer_reclaim(bucket, object, &meta);
 
     /* Try to remove directory (will fail if not empty) */
-    char dir_path[PATH_MAX * 2];
-    snprintf(dir_path, sizeof(dir_path), "%s/%s", disk_path, object_path);
-    /* Remove trailing slash */
-    size_t len = strlen(dir_path);
-    if (len > 0 && dir_path[len-1] == '/') {
-        dir_path[len-1] = '\0';
-    }
-    rmdir(dir_path);
+    buckets_disk_rmdir_object(disk_path, object_path);
 
     buckets_xl_meta_free(&meta);
     
@@ -0,0 +1,581 @@
+/**
+ * Hot Object Cache
+ *
+ * In-memory cache of small, decoded objects so skewed GET traffic skips
+ * registry lookup, shard reads, checksum verification and decode.
+ *
+ * - Memory budget in bytes; objects above a size limit are never cached.
+ * - Admission is TinyLFU: every lookup increments a 4-row count-min sketch
+ *   (periodically halved so it tracks recent popularity). A new object only
+ *   displaces LRU victims that are requested less often than it is.
+ * - PUT/DELETE/version changes invalidate the key here and on peers. A
+ *   per-key epoch makes a GET that raced an invalidation discard its result
+ *   instead of caching stale data; a TTL bounds any missed peer message.
+ * - The epoch table lives in an anonymous MAP_SHARED mapping created before
+ *   BUCKETS_WORKERS forks, so an invalidation in one worker (local PUT or
+ *   peer RPC) also retires the key in every sibling worker's cache: each
+ *   entry remembers the epoch it was admitted under and is dropped on
+ *   lookup once the shared epoch has moved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_hash.h"
+
+#define SKETCH_DEPTH        4
+#define SKETCH_MAX_COUNT    15          /* 4-bit counters, as in TinyLFU */
+#define SKETCH_MIN_WIDTH    1024
+#define SKETCH_MAX_WIDTH    (1u << 20)
+#define EPOCH_SLOTS         16384       /* Shared; collisions only cost misses */
+#define ENTRY_OVERHEAD      256         /* Key, metadata, bookkeeping */
+
+/**
+ * Cache entry (refcounted so hits copy data outside the lock)
+ */
+typedef struct object_cache_entry {
+    char *key;                              /* "bucket/object" */
+    u64 hash;
+    buckets_cached_object_t obj;
+    size_t charge;                          /* Bytes counted against budget */
+    time_t inserted;
+    u64 epoch;                              /* Shared epoch at admission */
+    u32 refs;                               /* Cache reference + readers */
+    struct object_cache_entry *next;        /* Hash chain */
+    struct object_cache_entry *lru_prev;    /* Toward most recent */
+    struct object_cache_entry *lru_next;    /* Toward least recent */
+} object_cache_entry_t;
+
+/**
+ * Object cache
+ */
+typedef struct {
+    object_cache_entry_t **table;
+    u32 table_size;
+    object_cache_entry_t *lru_head;         /* Most recent */
+    object_cache_entry_t *lru_tail;         /* Least recent */
+
+    /* TinyLFU frequency sketch */
+    u8 *sketch;                             /* SKETCH_DEPTH rows of sketch_width */
+    u32 sketch_width;                       /* Power of two */
+    u64 sketch_additions;
+    u64 sketch_sample;                      /* Halve all counters after this many */
+
+    /* Invalidation epochs, indexed by key hash (shared with forked workers) */
+    _Atomic u64 *epochs;
+    bool epochs_shared;                     /* mmap'd rather than heap */
+
+    u64 max_bytes;
+    size_t max_object_size;
+    u32 ttl_seconds;
+    pthread_mutex_t lock;
+
+    buckets_object_cache_stats_t stats;
+} object_cache_t;
+
+static object_cache_t *g_object_cache = NULL;
+
+/* ===================================================================
+ * Helpers
+ * ===================================================================*/
+
+static char* make_key(const char *bucket, const char *object, u64 *hash)
+{
+    char *key = buckets_format("%s/%s", bucket, object);
+    *hash = buckets_xxhash64(0, key, strlen(key));
+    return key;
+}
+
+static _Atomic u64* epoch_slot(object_cache_t *cache, u64 hash)
+{
+    return &cache->epochs[hash % EPOCH_SLOTS];
+}
+
+static u32 next_pow2(u64 v)
+{
+    u32 p = 1;
+    while (p < v && p < SKETCH_MAX_WIDTH) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static u32 sketch_index(const object_cache_t *cache, u64 hash, u32 row)
+{
+    /* Double hashing: independent-enough row positions from one 64-bit hash */
+    u64 h = hash + row * ((hash >> 32) | 1);
+    return row * cache->sketch_width + (u32)(h & (cache->sketch_width - 1));
+}
+
+static void sketch_increment(object_cache_t *cache, u64 hash)
+{
+    for (u32 row = 0; row < SKETCH_DEPTH; row++) {
+        u8 *c = &cache->sketch[sketch_index(cache, hash, row)];
+        if (*c < SKETCH_MAX_COUNT) {
+            (*c)++;
+        }
+    }
+
+    /* Aging: halve everything so old popularity fades */
+    if (++cache->sketch_additions >= cache->sketch_sample) {
+        u32 n = SKETCH_DEPTH * cache->sketch_width;
+        for (u32 i = 0; i < n; i++) {
+            cache->sketch[i] >>= 1;
+        }
+        cache->sketch_additions /= 2;
+    }
+}
+
+static u8 sketch_estimate(const object_cache_t *cache, u64 hash)
+{
+    u8 min = SKETCH_MAX_COUNT;
+    for (u32 row = 0; row < SKETCH_DEPTH; row++) {
+        u8 c = cache->sketch[sketch_index(cache, hash, row)];
+        if (c < min) {
+            min = c;
+        }
+    }
+    return min;
+}
+
+static void copy_object(buckets_cached_object_t *dst, const buckets_cached_object_t *src)
+{
+    memset(dst, 0, sizeof(*dst));
+    dst->data = buckets_malloc(src->size ? src->size : 1);
+    memcpy(dst->data, src->data, src->size);
+    dst->size = src->size;
+    memcpy(dst->etag, src->etag, sizeof(dst->etag));
+    dst->etag[sizeof(dst->etag) - 1] = '\0';
+    if (src->content_type) {
+        dst->content_type = buckets_strdup(src->content_type);
+    }
+    if (src->user_count > 0) {
+        dst->user_keys = buckets_calloc(src->user_count, sizeof(char *));
+        dst->user_values = buckets_calloc(src->user_count, sizeof(char *));
+        for (u32 i = 0; i < src->user_count; i++) {
+            dst->user_keys[i] = buckets_strdup(src->user_keys[i]);
+            dst->user_values[i] = buckets_strdup(src->user_values[i]);
+        }
+        dst->user_count = src->user_count;
+    }
+}
+
+void buckets_cached_object_free(buckets_cached_object_t *obj)
+{
+    if (!obj) {
+        return;
+    }
+
+    buckets_free(obj->data);
+    buckets_free(obj->content_type);
+    for (u32 i = 0; i < obj->user_count; i++) {
+        buckets_free(obj->user_keys[i]);
+        buckets_free(obj->user_values[i]);
+    }
+    buckets_free(obj->user_keys);
+    buckets_free(obj->user_values);
+    memset(obj, 0, sizeof(*obj));
+}
+
+static void entry_release(object_cache_entry_t *entry)
+{
+    /* Caller holds the cache lock */
+    if (--entry->refs == 0) {
+        buckets_cached_object_free(&entry->obj);
+        buckets_free(entry->key);
+        buckets_free(entry);
+    }
+}
+
+static void lru_unlink(object_cache_t *cache, object_cache_entry_t *entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(object_cache_t *cache, object_cache_entry_t *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    }
+    cache->lru_head = entry;
+    if (!cache->lru_tail) {
+        cache->lru_tail = entry;
+    }
+}
+
+static object_cache_entry_t* table_find(object_cache_t *cache, const char *key, u64 hash)
+{
+    object_cache_entry_t *entry = cache->table[hash % cache->table_size];
+    while (entry) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+        entry = entry->next;
+    }
+    return NULL;
+}
+
+/* Unlink from table and LRU and drop the cache's reference */
+static void remove_entry(object_cache_t *cache, object_cache_entry_t *entry)
+{
+    object_cache_entry_t **slot = &cache->table[entry->hash % cache->table_size];
+    while (*slot && *slot != entry) {
+        slot = &(*slot)->next;
+    }
+    if (*slot) {
+        *slot = entry->next;
+    }
+
+    lru_unlink(cache, entry);
+    cache->stats.bytes -= entry->charge;
+    cache->stats.entries--;
+    entry_release(entry);
+}
+
+/* ===================================================================
+ * Lifecycle
+ * ===================================================================*/
+
+int buckets_object_cache_init(u64 max_bytes, size_t max_object_size, u32 ttl_seconds)
+{
+    if (g_object_cache) {
+        return BUCKETS_OK;
+    }
+    if (max_bytes == 0 || max_object_size == 0) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    object_cache_t *cache = buckets_calloc(1, sizeof(*cache));
+
+    /* Size the sketch for the most entries the budget could hold (small
+     * objects), so frequency estimates stay accurate for the working set. */
+    u64 expected = max_bytes / 4096;
+    if (expected < SKETCH_MIN_WIDTH) {
+        expected = SKETCH_MIN_WIDTH;
+    }
+    cache->sketch_width = next_pow2(expected);
+    cache->sketch = buckets_calloc((size_t)SKETCH_DEPTH * cache->sketch_width, 1);
+    cache->sketch_sample = (u64)cache->sketch_width * 10;
+
+    cache->table_size = cache->sketch_width;
+    cache->table = buckets_calloc(cache->table_size, sizeof(object_cache_entry_t *));
+
+    cache->max_bytes = max_bytes;
+    cache->max_object_size = max_object_size;
+    cache->ttl_seconds = ttl_seconds;
+    cache->stats.max_bytes = max_bytes;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    /* Created before the worker fork, so all workers see one table */
+    size_t epochs_size = EPOCH_SLOTS * sizeof(_Atomic u64);
+    void *epochs = mmap(NULL, epochs_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (epochs != MAP_FAILED) {
+        cache->epochs = epochs;
+        cache->epochs_shared = true;
+    } else {
+        buckets_warn("Object cache epochs not shared (mmap: %s); "
+                     "forked workers will rely on the TTL", strerror(errno));
+        cache->epochs = buckets_calloc(EPOCH_SLOTS, sizeof(_Atomic u64));
+    }
+
+    g_object_cache = cache;
+
+    buckets_info("Object cache initialized: %lu MB budget, objects <= %zu KB, ttl=%us",
+                 max_bytes / (1024 * 1024), max_object_size / 1024, ttl_seconds);
+    return BUCKETS_OK;
+}
+
+int buckets_object_cache_init_from_env(void)
+{
+    const char *env = getenv("BUCKETS_OBJECT_CACHE_MB");
+    if (!env || atoll(env) <= 0) {
+        return BUCKETS_OK;
+    }
+    u64 max_bytes = (u64)atoll(env) * 1024 * 1024;
+
+    size_t max_object_kb = BUCKETS_OBJECT_CACHE_DEFAULT_MAX_OBJECT_KB;
+    env = getenv("BUCKETS_OBJECT_CACHE_MAX_OBJECT_KB");
+    if (env && atoll(env) > 0) {
+        max_object_kb = (size_t)atoll(env);
+    }
+
+    u32 ttl = BUCKETS_OBJECT_CACHE_DEFAULT_TTL_SEC;
+    env = getenv("BUCKETS_OBJECT_CACHE_TTL_SEC");
+    if (env && atoi(env) >= 0) {
+        ttl = (u32)atoi(env);
+    }
+
+    return buckets_object_cache_init(max_bytes, max_object_kb * 1024, ttl);
+}
+
+void buckets_object_cache_cleanup(void)
+{
+    object_cache_t *cache = g_object_cache;
+    if (!cache) {
+        return;
+    }
+    g_object_cache = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    while (cache->lru_head) {
+        remove_entry(cache, cache->lru_head);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    buckets_info("Object cache cleanup: hits=%lu misses=%lu admissions=%lu rejections=%lu",
+                 cache->stats.hits, cache->stats.misses, cache->stats.admissions,
+                 cache->stats.rejections);
+
+    pthread_mutex_destroy(&cache->lock);
+    if (cache->epochs_shared) {
+        munmap((void *)cache->epochs, EPOCH_SLOTS * sizeof(_Atomic u64));
+    } else {
+        buckets_free((void *)cache->epochs);
+    }
+    buckets_free(cache->table);
+    buckets_free(cache->sketch);
+    buckets_free(cache);
+}
+
+bool buckets_object_cache_enabled(void)
+{
+    return g_object_cache != NULL;
+}
+
+/* ===================================================================
+ * Lookup / Admission / Invalidation
+ * ===================================================================*/
+
+int buckets_object_cache_get(const char *bucket, const char *object,
+                             buckets_cached_object_t *out, u64 *token)
+{
+    object_cache_t *cache = g_object_cache;
+    if (!cache || !bucket || !object || !out) {
+        return -1;
+    }
+
+    u64 hash;
+    char *key = make_key(bucket, object, &hash);
+
+    pthread_mutex_lock(&cache->lock);
+
+    sketch_increment(cache, hash);
+    u64 epoch = atomic_load(epoch_slot(cache, hash));
+    if (token) {
+        *token = epoch;
+    }
+
+    object_cache_entry_t *entry = table_find(cache, key, hash);
+    if (entry && entry->epoch != epoch) {
+        /* Invalidated by a sibling worker since it was admitted */
+        remove_entry(cache, entry);
+        cache->stats.invalidations++;
+        entry = NULL;
+    } else if (entry && cache->ttl_seconds > 0 &&
+        time(NULL) - entry->inserted > (time_t)cache->ttl_seconds) {
+        remove_entry(cache, entry);
+        cache->stats.expirations++;
+        entry = NULL;
+    }
+
+    if (!entry) {
+        cache->stats.misses++;
+        pthread_mutex_unlock(&cache->lock);
+        buckets_free(key);
+        return -1;
+    }
+
+    lru_unlink(cache, entry);
+    lru_push_front(cache, entry);
+    entry->refs++;
+    cache->stats.hits++;
+    pthread_mutex_unlock(&cache->lock);
+
+    /* Copy outside the lock; our reference keeps the entry alive */
+    copy_object(out, &entry->obj);
+
+    pthread_mutex_lock(&cache->lock);
+    entry_release(entry);
+    pthread_mutex_unlock(&cache->lock);
+
+    buckets_free(key);
+    return 0;
+}
+
+int buckets_object_cache_admit(const char *bucket, const char *object,
+                               const buckets_cached_object_t *obj, u64 token)
+{
+    object_cache_t *cache = g_object_cache;
+    if (!cache || !bucket || !object || !obj || (!obj->data && obj->size > 0)) {
+        return -1;
+    }
+
+    size_t charge = obj->size + ENTRY_OVERHEAD;
+    if (obj->size > cache->max_object_size || charge > cache->max_bytes) {
+        pthread_mutex_lock(&cache->lock);
+        cache->stats.oversized++;
+        pthread_mutex_unlock(&cache->lock);
+        return -1;
+    }
+
+    u64 hash;
+    char *key = make_key(bucket, object, &hash);
+
+    /* Build the entry before taking the lock */
+    object_cache_entry_t *entry = buckets_calloc(1, sizeof(*entry));
+    entry->key = key;
+    entry->hash = hash;
+    entry->charge = charge;
+    entry->epoch = token;
+    entry->refs = 1;
+    copy_object(&entry->obj, obj);
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (atomic_load(epoch_slot(cache, hash)) != token) {
+        /* A PUT/DELETE landed while this GET was reading */
+        cache->stats.stale_admits++;
+        entry_release(entry);
+        pthread_mutex_unlock(&cache->lock);
+        return -1;
+    }
+
+    object_cache_entry_t *existing = table_find(cache, key, hash);
+    if (existing) {
+        remove_entry(cache, existing);
+    }
+
+    /* TinyLFU: every victim needed to make room must be colder than us */
+    if (cache->stats.bytes + charge > cache->max_bytes) {
+        u8 candidate_freq = sketch_estimate(cache, hash);
+        u64 freed = 0;
+        u64 needed = cache->stats.bytes + charge - cache->max_bytes;
+        object_cache_entry_t *victim = cache->lru_tail;
+
+        while (victim && freed < needed) {
+            if (sketch_estimate(cache, victim->hash) >= candidate_freq) {
+                cache->stats.rejections++;
+                entry_release(entry);
+                pthread_mutex_unlock(&cache->lock);
+                return -1;
+            }
+            freed += victim->charge;
+            victim = victim->lru_prev;
+        }
+
+        while (cache->lru_tail && cache->stats.bytes + charge > cache->max_bytes) {
+            remove_entry(cache, cache->lru_tail);
+            cache->stats.evictions++;
+        }
+    }
+
+    u32 slot = (u32)(hash % cache->table_size);
+    entry->next = cache->table[slot];
+    cache->table[slot] = entry;
+    entry->inserted = time(NULL);
+    lru_push_front(cache, entry);
+    cache->stats.bytes += charge;
+    cache->stats.entries++;
+    cache->stats.admissions++;
+
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+void buckets_object_cache_invalidate(const char *bucket, const char *object)
+{
+    object_cache_t *cache = g_object_cache;
+    if (!cache || !bucket || !object) {
+        return;
+    }
+
+    u64 hash;
+    char *key = make_key(bucket, object, &hash);
+
+    pthread_mutex_lock(&cache->lock);
+    atomic_fetch_add(epoch_slot(cache, hash), 1);
+    object_cache_entry_t *entry = table_find(cache, key, hash);
+    if (entry) {
+        remove_entry(cache, entry);
+        cache->stats.invalidations++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    buckets_free(key);
+}
+
+void buckets_object_cache_publish_invalidation(const char *bucket, const char *object)
+{
+    /* Later GETs must not join a read of the previous version, here or on
+     * a peer, even when no node caches objects: coalescing is on by default */
+    buckets_get_coalesce_forget(bucket, object);
+    buckets_object_cache_invalidate(bucket, object);
+    buckets_distributed_invalidate_object(bucket, object);
+}
+
+int buckets_object_cache_keys(char ***keys, u32 *count, u32 max)
+{
+    if (!keys || !count) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    *keys = NULL;
+    *count = 0;
+
+    object_cache_t *cache = g_object_cache;
+    if (!cache || max == 0) {
+        return BUCKETS_OK;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    u32 n = cache->stats.entries < max ? cache->stats.entries : max;
+    char **out = buckets_calloc(n > 0 ? n : 1, sizeof(char*));
+    u32 i = 0;
+    for (object_cache_entry_t *entry = cache->lru_head; entry && i < n;
+         entry = entry->lru_next) {
+        out[i++] = buckets_strdup(entry->key);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    *keys = out;
+    *count = i;
+    return BUCKETS_OK;
+}
+
+void buckets_object_cache_get_stats(buckets_object_cache_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    object_cache_t *cache = g_object_cache;
+    if (!cache) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
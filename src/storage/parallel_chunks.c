@@ -15,6 +15,7 @@
 #include "buckets_storage.h"
 #include "buckets_placement.h"
 #include "buckets_net.h"
+#include "buckets_numa.h"
 #include "cJSON.h"
 
 /* Maximum number of concurrent chunk operations */
@@ -57,7 +58,9 @@ static void* chunk_write_worker(void *arg)
     chunk_task_t *task = (chunk_task_t*)arg;
     
     if (task->is_local) {
-        /* Local write */
+        /* Local write, issued from the socket the disk hangs off */
+        buckets_numa_run_on_node(buckets_numa_node_of_path(task->disk_path));
+        
         extern int buckets_write_chunk(const char *disk_path, const char *object_path,
                                        u32 chunk_index, const void *data, size_t size);
         
@@ -104,14 +107,11 @@ static void* chunk_write_worker(void *arg)
 }
 
 /**
- * Worker thread for chunk read
+ * Read one chunk on the calling thread
  */
-static void* chunk_read_worker(void *arg)
+static void chunk_read_task(chunk_task_t *task)
 {
-    chunk_task_t *task = (chunk_task_t*)arg;
-    
     if (task->is_local) {
-        /* Local read */
         extern int buckets_read_chunk(const char *disk_path, const char *object_path,
                                       u32 chunk_index, void **data, size_t *size);
         
@@ -162,14 +162,114 @@ static void* chunk_read_worker(void *arg)
                          task->chunk_index, task->node_endpoint, task->disk_path);
         }
     }
+}
+
+/**
+ * Worker thread for chunk read
+ */
+static void* chunk_read_worker(void *arg)
+{
+    chunk_task_t *task = (chunk_task_t*)arg;
     
+    /* Local read, issued from the socket the disk hangs off. Only threads
+     * of our own are moved: a caller's thread keeps its placement. */
+    if (task->is_local) {
+        buckets_numa_run_on_node(buckets_numa_node_of_path(task->disk_path));
+    }
+    chunk_read_task(task);
     return NULL;
 }
 
+/**
+ * Set up a read task for chunk i (0-based) of a placement
+ */
+static int init_read_task(chunk_task_t *task, const char *bucket, const char *object,
+                          const char *object_path, buckets_placement_result_t *placement,
+                          u32 i)
+{
+    /* Check if we have endpoints for distributed mode */
+    bool has_endpoints = (placement->disk_endpoints && 
+                         placement->disk_endpoints[0] && 
+                         placement->disk_endpoints[0][0] != '\0');
+    
+    task->chunk_index = i + 1;
+    strncpy(task->bucket, bucket, sizeof(task->bucket) - 1);
+    strncpy(task->object, object, sizeof(task->object) - 1);
+    strncpy(task->object_path, object_path, sizeof(task->object_path) - 1);
+    
+    /* NULL check for disk_path to prevent segfault in strncpy */
+    if (placement->disk_paths[i] == NULL) {
+        buckets_error("NULL disk_path at index %u for object %s/%s", i, bucket, object);
+        return -1;
+    }
+    strncpy(task->disk_path, placement->disk_paths[i], sizeof(task->disk_path) - 1);
+    
+    task->chunk_data_out = NULL;
+    task->chunk_size = 0;
+    
+    /* Determine if local or remote */
+    if (has_endpoints) {
+        /* NULL check for disk_endpoint to prevent segfault */
+        if (placement->disk_endpoints[i] == NULL) {
+            buckets_error("NULL disk_endpoint at index %u for object %s/%s", i, bucket, object);
+            return -1;
+        }
+        extern bool buckets_distributed_is_local_disk(const char *disk_endpoint);
+        task->is_local = buckets_distributed_is_local_disk(placement->disk_endpoints[i]);
+        
+        if (!task->is_local) {
+            extern int buckets_distributed_extract_node_endpoint(const char *disk_endpoint,
+                                                                 char *node_endpoint, size_t size);
+            if (buckets_distributed_extract_node_endpoint(placement->disk_endpoints[i],
+                                                         task->node_endpoint,
+                                                         sizeof(task->node_endpoint)) != 0) {
+                buckets_error("Failed to extract node endpoint from: %s",
+                             placement->disk_endpoints[i]);
+                task->is_local = true;  /* Fall back to local */
+            }
+        }
+    } else {
+        task->is_local = true;  /* No endpoints = local only mode */
+    }
+    
+    task->result = -1;  /* Initialize as failed */
+    return 0;
+}
+
 /* ===================================================================
  * Public API
  * ===================================================================*/
 
+int buckets_read_placed_chunk(const char *bucket, const char *object,
+                              const char *object_path,
+                              buckets_placement_result_t *placement,
+                              u32 index, void **data, size_t *size)
+{
+    if (!bucket || !object || !object_path || !placement || !data || !size ||
+        index >= placement->disk_count) {
+        return -1;
+    }
+    
+    chunk_task_t *task = buckets_calloc(1, sizeof(chunk_task_t));
+    if (!task) {
+        return -1;
+    }
+    
+    int ret = -1;
+    if (init_read_task(task, bucket, object, object_path, placement, index) == 0) {
+        /* Inline on the caller's (pool) thread, which is not re-pinned */
+        chunk_read_task(task);
+        ret = task->result;
+        if (ret == 0) {
+            *data = task->chunk_data_out;
+            *size = task->chunk_size;
+        }
+    }
+    
+    buckets_free(task);
+    return ret;
+}
+
 /**
  * Write multiple chunks in parallel (local + RPC)
  * 
@@ -263,7 +363,7 @@ int buckets_parallel_write_chunks(const char *bucket,
     
     /* Launch threads */
     for (u32 i = 0; i < num_chunks; i++) {
-        int ret = pthread_create(&tasks[i].thread, NULL, chunk_write_worker, &tasks[i]);
+        int ret = buckets_account_thread_create(&tasks[i].thread, chunk_write_worker, &tasks[i]);
         if (ret != 0) {
             buckets_error("Failed to create thread for chunk %u: %d", i + 1, ret);
             /* Mark as failed but continue launching other threads */
@@ -326,11 +426,6 @@ int buckets_parallel_read_chunks(const char *bucket,
     
     buckets_info("Parallel read: %u chunks for %s/%s", num_chunks, bucket, object);
     
-    /* Check if we have endpoints for distributed mode */
-    bool has_endpoints = (placement->disk_endpoints && 
-                         placement->disk_endpoints[0] && 
-                         placement->disk_endpoints[0][0] != '\0');
-    
     /* Allocate task array */
     chunk_task_t *tasks = buckets_calloc(num_chunks, sizeof(chunk_task_t));
     if (!tasks) {
@@ -339,56 +434,15 @@ int buckets_parallel_read_chunks(const char *bucket,
     
     /* Initialize tasks */
     for (u32 i = 0; i < num_chunks; i++) {
-        chunk_task_t *task = &tasks[i];
-        
-        task->chunk_index = i + 1;
-        strncpy(task->bucket, bucket, sizeof(task->bucket) - 1);
-        strncpy(task->object, object, sizeof(task->object) - 1);
-        strncpy(task->object_path, object_path, sizeof(task->object_path) - 1);
-        
-        /* NULL check for disk_path to prevent segfault in strncpy */
-        if (placement->disk_paths[i] == NULL) {
-            buckets_error("NULL disk_path at index %u for object %s/%s", i, bucket, object);
+        if (init_read_task(&tasks[i], bucket, object, object_path, placement, i) != 0) {
             buckets_free(tasks);
             return -1;
         }
-        strncpy(task->disk_path, placement->disk_paths[i], sizeof(task->disk_path) - 1);
-        
-        task->chunk_data_out = NULL;
-        task->chunk_size = 0;
-        
-        /* Determine if local or remote */
-        if (has_endpoints) {
-            /* NULL check for disk_endpoint to prevent segfault */
-            if (placement->disk_endpoints[i] == NULL) {
-                buckets_error("NULL disk_endpoint at index %u for object %s/%s", i, bucket, object);
-                buckets_free(tasks);
-                return -1;
-            }
-            extern bool buckets_distributed_is_local_disk(const char *disk_endpoint);
-            task->is_local = buckets_distributed_is_local_disk(placement->disk_endpoints[i]);
-            
-            if (!task->is_local) {
-                extern int buckets_distributed_extract_node_endpoint(const char *disk_endpoint,
-                                                                     char *node_endpoint, size_t size);
-                if (buckets_distributed_extract_node_endpoint(placement->disk_endpoints[i],
-                                                             task->node_endpoint,
-                                                             sizeof(task->node_endpoint)) != 0) {
-                    buckets_error("Failed to extract node endpoint from: %s",
-                                 placement->disk_endpoints[i]);
-                    task->is_local = true;  /* Fall back to local */
-                }
-            }
-        } else {
-            task->is_local = true;  /* No endpoints = local only mode */
-        }
-        
-        task->result = -1;  /* Initialize as failed */
     }
     
     /* Launch threads */
     for (u32 i = 0; i < num_chunks; i++) {
-        int ret = pthread_create(&tasks[i].thread, NULL, chunk_read_worker, &tasks[i]);
+        int ret = buckets_account_thread_create(&tasks[i].thread, chunk_read_worker, &tasks[i]);
         if (ret != 0) {
             buckets_error("Failed to create thread for chunk %u: %d", i + 1, ret);
             tasks[i].result = -1;
@@ -439,9 +493,19 @@ typedef struct {
     buckets_xl_meta_t meta;        /* Metadata to write (copied) */
     
     int result;                    /* Operation result */
+    buckets_quorum_tracker_t *tracker;  /* Set for quorum writes */
     pthread_t thread;              /* Thread handle */
 } metadata_task_t;
 
+/**
+ * Quorum metadata write state, owned by the tracker once the fan-out starts
+ */
+typedef struct {
+    metadata_task_t *tasks;
+    u32 num_disks;
+    buckets_xl_meta_t meta;        /* Deep copy shared by all tasks */
+} metadata_quorum_t;
+
 /**
  * Worker thread for metadata write
  */
@@ -449,6 +513,15 @@ static void* metadata_write_worker(void *arg)
 {
     metadata_task_t *task = (metadata_task_t*)arg;
     
+    /* Quorum writes may outlive the request (see batch_write_worker) */
+    buckets_account_t account;
+    if (task->tracker) {
+        memset(&account, 0, sizeof(account));
+        if (buckets_account_enabled()) {
+            buckets_account_attach(&account);
+        }
+    }
+    
     if (task->is_local) {
         /* Local write */
         extern int buckets_write_xl_meta(const char *disk_path, const char *object_path,
@@ -478,9 +551,49 @@ static void* metadata_write_worker(void *arg)
         }
     }
     
+    if (task->tracker) {
+        if (buckets_account_enabled()) {
+            buckets_account_attach(NULL);
+        }
+        buckets_quorum_tracker_done(task->tracker, task->result == 0 ? 1 : 0,
+                                    task->result == 0 ? 0 : 1, &account);
+    }
+    
     return NULL;
 }
 
+/**
+ * Quorum metadata write completion: heal failed copies of a committed write
+ */
+static void metadata_quorum_finish(void *owner, bool committed)
+{
+    metadata_quorum_t *mq = (metadata_quorum_t*)owner;
+    
+    /* Heals check the version against a copy that did commit */
+    buckets_heal_ref_t ref = { NULL, NULL };
+    for (u32 i = 0; committed && i < mq->num_disks; i++) {
+        if (mq->tasks[i].result == 0) {
+            ref.disk_path = mq->tasks[i].disk_path;
+            ref.node_endpoint = mq->tasks[i].is_local ? NULL : mq->tasks[i].node_endpoint;
+            break;
+        }
+    }
+    
+    for (u32 i = 0; committed && i < mq->num_disks; i++) {
+        metadata_task_t *task = &mq->tasks[i];
+        if (task->result != 0) {
+            buckets_heal_queue_xl_meta(task->bucket, task->object, task->object_path,
+                                       task->disk_path,
+                                       task->is_local ? NULL : task->node_endpoint,
+                                       &task->meta, &ref);
+        }
+    }
+    
+    buckets_xl_meta_free(&mq->meta);
+    buckets_free(mq->tasks);
+    buckets_free(mq);
+}
+
 /**
  * Write xl.meta to multiple disks in parallel
  */
@@ -492,6 +605,24 @@ int buckets_parallel_write_metadata(const char *bucket,
                                      const buckets_xl_meta_t *base_meta,
                                      u32 num_disks,
                                      bool has_endpoints)
+{
+    return buckets_parallel_write_metadata_quorum(bucket, object, object_path, placement,
+                                                  disk_paths, base_meta, num_disks,
+                                                  has_endpoints, num_disks);
+}
+
+/**
+ * Write xl.meta in parallel, returning at write quorum (see buckets_storage.h)
+ */
+int buckets_parallel_write_metadata_quorum(const char *bucket,
+                                           const char *object,
+                                           const char *object_path,
+                                           buckets_placement_result_t *placement,
+                                           char **disk_paths,
+                                           const buckets_xl_meta_t *base_meta,
+                                           u32 num_disks,
+                                           bool has_endpoints,
+                                           u32 write_quorum)
 {
     if (!bucket || !object || !object_path || !disk_paths || !base_meta) {
         buckets_error("Invalid parameters for parallel metadata write");
@@ -509,6 +640,23 @@ int buckets_parallel_write_metadata(const char *bucket,
         return -1;
     }
     
+    /* Stragglers outlive base_meta: give the tasks a deep copy to share */
+    metadata_quorum_t *mq = NULL;
+    if (write_quorum < num_disks) {
+        char *json = buckets_xl_meta_to_json(base_meta);
+        mq = buckets_calloc(1, sizeof(metadata_quorum_t));
+        if (!json || buckets_xl_meta_from_json(json, &mq->meta) != 0) {
+            buckets_free(json);
+            buckets_free(mq);
+            buckets_free(tasks);
+            return -1;
+        }
+        buckets_free(json);
+        mq->tasks = tasks;
+        mq->num_disks = num_disks;
+        base_meta = &mq->meta;
+    }
+    
     /* Initialize tasks */
     for (u32 i = 0; i < num_disks; i++) {
         metadata_task_t *task = &tasks[i];
@@ -546,9 +694,39 @@ int buckets_parallel_write_metadata(const char *bucket,
         task->result = -1;  /* Initialize as failed */
     }
     
+    if (mq) {
+        buckets_quorum_tracker_t *tracker =
+            buckets_quorum_tracker_create(num_disks, write_quorum, num_disks,
+                                          metadata_quorum_finish, mq);
+        if (!tracker) {
+            metadata_quorum_finish(mq, false);
+            return -1;
+        }
+        
+        for (u32 i = 0; i < num_disks; i++) {
+            tasks[i].tracker = tracker;
+            int ret = buckets_account_thread_create(&tasks[i].thread, metadata_write_worker, &tasks[i]);
+            if (ret != 0) {
+                buckets_error("Failed to create thread for metadata write to disk %u: %d",
+                             i + 1, ret);
+                buckets_quorum_tracker_done(tracker, 0, 1, NULL);
+            } else {
+                pthread_detach(tasks[i].thread);
+            }
+        }
+        
+        /* mq belongs to the tracker from here on */
+        int result = buckets_quorum_tracker_wait(tracker);
+        if (result != 0) {
+            buckets_error("Parallel metadata write: quorum %u/%u not reached",
+                         write_quorum, num_disks);
+        }
+        return result;
+    }
+    
     /* Launch threads */
     for (u32 i = 0; i < num_disks; i++) {
-        int ret = pthread_create(&tasks[i].thread, NULL, metadata_write_worker, &tasks[i]);
+        int ret = buckets_account_thread_create(&tasks[i].thread, metadata_write_worker, &tasks[i]);
         if (ret != 0) {
             buckets_error("Failed to create thread for metadata write to disk %u: %d", 
                          i + 1, ret);
@@ -608,33 +786,25 @@ static void* chunk_delete_worker(void *arg)
     
     if (task->is_local) {
         /* Local delete - delete chunk and xl.meta directly */
-        char chunk_path[PATH_MAX * 2];
-        char meta_path[PATH_MAX * 2];
-        char dir_path[PATH_MAX * 2];
+        char chunk_name[32];
         
         /* Delete chunk file */
-        snprintf(chunk_path, sizeof(chunk_path), "%s/%spart.%u", 
-                 task->disk_path, task->object_path, task->chunk_index);
-        unlink(chunk_path);  /* Ignore errors - file may not exist */
+        snprintf(chunk_name, sizeof(chunk_name), "part.%u", task->chunk_index);
+        /* Ignore errors - file may not exist */
+        buckets_disk_unlink_file(task->disk_path, task->object_path, chunk_name);
         
         /* Delete xl.meta */
-        snprintf(meta_path, sizeof(meta_path), "%s/%sxl.meta", 
-                 task->disk_path, task->object_path);
-        if (unlink(meta_path) == 0) {
+        if (buckets_delete_xl_meta(task->disk_path, task->object_path) == 0) {
             task->result = 0;
-            buckets_debug("Parallel delete: Removed %s", meta_path);
+            buckets_debug("Parallel delete: Removed %s/%sxl.meta",
+                          task->disk_path, task->object_path);
         } else {
             /* Not necessarily an error - may already be deleted */
             task->result = 0;
         }
         
         /* Try to remove object directory (will fail if not empty, that's ok) */
-        snprintf(dir_path, sizeof(dir_path), "%s/%s", task->disk_path, task->object_path);
-        size_t len = strlen(dir_path);
-        if (len > 0 && dir_path[len-1] == '/') {
-            dir_path[len-1] = '\0';
-        }
-        rmdir(dir_path);  /* Ignore errors */
+        buckets_disk_rmdir_object(task->disk_path, task->object_path);
         
     } else {
         /* Remote delete via RPC */
@@ -784,7 +954,7 @@ int buckets_parallel_delete_chunks(const char *bucket,
     
     /* Launch all delete threads in parallel */
     for (u32 i = 0; i < num_disks; i++) {
-        int ret = pthread_create(&tasks[i].thread, NULL, chunk_delete_worker, &tasks[i]);
+        int ret = buckets_account_thread_create(&tasks[i].thread, chunk_delete_worker, &tasks[i]);
         if (ret != 0) {
             buckets_error("Failed to create delete thread for disk %u: %d", i + 1, ret);
             tasks[i].result = -1;
@@ -963,7 +1133,7 @@ int buckets_parallel_read_metadata(const char *bucket,
     
     /* Launch all threads in parallel */
     for (u32 i = 0; i < num_disks; i++) {
-        int ret = pthread_create(&tasks[i].thread, NULL, metadata_read_worker, &tasks[i]);
+        int ret = buckets_account_thread_create(&tasks[i].thread, metadata_read_worker, &tasks[i]);
         if (ret != 0) {
             buckets_error("Failed to create thread for metadata read from disk %u: %d", i, ret);
             tasks[i].thread = 0;
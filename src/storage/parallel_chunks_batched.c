@@ -9,6 +9,9 @@
  *   WITH batching:    3 HTTP requests (4 chunks each)
  *   
  * Expected improvement: 30-50% throughput increase for distributed writes.
+ * 
+ * With a write quorum below K+M, the call returns as soon as the quorum of
+ * shards is durable; the remaining batches finish in the background.
  */
 
 #include <stdio.h>
@@ -32,9 +35,22 @@ typedef struct {
     size_t chunk_count;               /* Number of chunks */
     bool is_local;                    /* True if local writes */
     int result;                       /* Batch write result */
+    int chunk_results[MAX_BATCH_SIZE];  /* Per-chunk result */
+    buckets_quorum_tracker_t *tracker;  /* Set for quorum writes */
     pthread_t thread;                 /* Thread for this batch */
 } node_batch_t;
 
+/**
+ * Quorum write state, owned by the tracker once the fan-out starts
+ */
+typedef struct {
+    node_batch_t *batches;            /* Heap copy of the used batches */
+    size_t batch_count;
+    u8 *data;                         /* Private copy of all chunk data */
+    char object_path[1536];
+    buckets_xl_meta_t version;        /* modTime/ETag the shards commit under */
+} quorum_write_t;
+
 /**
  * Worker thread for batched chunk write
  */
@@ -42,6 +58,16 @@ static void* batch_write_worker(void *arg)
 {
     node_batch_t *batch = (node_batch_t*)arg;
     
+    /* Quorum writes may outlive the request: keep a private account and
+     * hand it over only if the request is still waiting */
+    buckets_account_t account;
+    if (batch->tracker) {
+        memset(&account, 0, sizeof(account));
+        if (buckets_account_enabled()) {
+            buckets_account_attach(&account);
+        }
+    }
+    
     if (batch->is_local) {
         /* Local writes - process each chunk sequentially in this thread */
         batch->result = 0;
@@ -62,6 +88,7 @@ static void* batch_write_worker(void *arg)
             int ret = buckets_write_chunk(chunk->disk_path, object_path,
                                          chunk->chunk_index, chunk->chunk_data, 
                                          chunk->chunk_size);
+            batch->chunk_results[i] = ret;
             if (ret != 0) {
                 buckets_error("[BATCH_LOCAL] Failed to write chunk %u locally", chunk->chunk_index);
                 batch->result = -1;
@@ -78,6 +105,9 @@ static void* batch_write_worker(void *arg)
         batch->result = buckets_binary_batch_write_chunks(batch->node_endpoint,
                                                           batch->chunks,
                                                           batch->chunk_count);
+        for (size_t i = 0; i < batch->chunk_count; i++) {
+            batch->chunk_results[i] = batch->result;
+        }
         
         if (batch->result == 0) {
             buckets_debug("[BATCH_REMOTE] Wrote %zu chunks to %s", 
@@ -88,9 +118,130 @@ static void* batch_write_worker(void *arg)
         }
     }
     
+    if (batch->tracker) {
+        u32 ok = 0;
+        for (size_t i = 0; i < batch->chunk_count; i++) {
+            if (batch->chunk_results[i] == 0) {
+                ok++;
+            }
+        }
+        if (buckets_account_enabled()) {
+            buckets_account_attach(NULL);
+        }
+        buckets_quorum_tracker_done(batch->tracker, ok, (u32)batch->chunk_count - ok, &account);
+    }
+    
     return NULL;
 }
 
+/**
+ * Quorum write completion: runs after the last batch finished
+ *
+ * Shards that failed on a committed write go to the heal queue; the
+ * private data copy is released.
+ */
+static void quorum_write_finish(void *owner, bool committed)
+{
+    quorum_write_t *qw = (quorum_write_t*)owner;
+    
+    /* Heals check the version against a shard that did commit */
+    buckets_heal_ref_t ref = { NULL, NULL };
+    for (size_t b = 0; committed && !ref.disk_path && b < qw->batch_count; b++) {
+        node_batch_t *batch = &qw->batches[b];
+        for (size_t i = 0; i < batch->chunk_count; i++) {
+            if (batch->chunk_results[i] == 0) {
+                ref.disk_path = batch->chunks[i].disk_path;
+                ref.node_endpoint = batch->is_local ? NULL : batch->node_endpoint;
+                break;
+            }
+        }
+    }
+    
+    for (size_t b = 0; b < qw->batch_count; b++) {
+        node_batch_t *batch = &qw->batches[b];
+        for (size_t i = 0; committed && i < batch->chunk_count; i++) {
+            if (batch->chunk_results[i] == 0) {
+                continue;
+            }
+            buckets_batch_chunk_t *chunk = &batch->chunks[i];
+            buckets_heal_queue_shard(chunk->bucket, chunk->object, qw->object_path,
+                                     chunk->chunk_index, chunk->disk_path,
+                                     batch->is_local ? NULL : batch->node_endpoint,
+                                     chunk->chunk_data, chunk->chunk_size,
+                                     &qw->version, &ref);
+        }
+    }
+    
+    buckets_free(qw->version.meta.etag);
+    buckets_free(qw->data);
+    buckets_free(qw->batches);
+    buckets_free(qw);
+}
+
+/**
+ * Launch batches and return at write quorum
+ *
+ * Batches run on a private copy of the chunk data so stragglers can keep
+ * writing after the caller has freed its buffers.
+ */
+static int write_batches_quorum(node_batch_t *stack_batches, size_t batch_count,
+                                const char *object_path, size_t chunk_size,
+                                u32 num_chunks, u32 write_quorum,
+                                const buckets_xl_meta_t *meta)
+{
+    quorum_write_t *qw = buckets_calloc(1, sizeof(quorum_write_t));
+    memcpy(qw->version.stat.modTime, meta->stat.modTime, sizeof(qw->version.stat.modTime));
+    qw->version.meta.etag = meta->meta.etag ? buckets_strdup(meta->meta.etag) : NULL;
+    qw->batches = buckets_malloc(batch_count * sizeof(node_batch_t));
+    memcpy(qw->batches, stack_batches, batch_count * sizeof(node_batch_t));
+    qw->batch_count = batch_count;
+    qw->data = buckets_malloc((size_t)num_chunks * chunk_size);
+    snprintf(qw->object_path, sizeof(qw->object_path), "%s", object_path);
+    
+    u8 *dst = qw->data;
+    for (size_t b = 0; b < batch_count; b++) {
+        for (size_t i = 0; i < qw->batches[b].chunk_count; i++) {
+            buckets_batch_chunk_t *chunk = &qw->batches[b].chunks[i];
+            memcpy(dst, chunk->chunk_data, chunk_size);
+            chunk->chunk_data = dst;
+            dst += chunk_size;
+        }
+    }
+    
+    buckets_quorum_tracker_t *tracker =
+        buckets_quorum_tracker_create(num_chunks, write_quorum, (u32)batch_count,
+                                      quorum_write_finish, qw);
+    if (!tracker) {
+        quorum_write_finish(qw, false);
+        return -1;
+    }
+    
+    for (size_t b = 0; b < batch_count; b++) {
+        node_batch_t *batch = &qw->batches[b];
+        batch->tracker = tracker;
+        for (size_t i = 0; i < batch->chunk_count; i++) {
+            batch->chunk_results[i] = -1;
+        }
+        
+        int ret = buckets_account_thread_create(&batch->thread, batch_write_worker, batch);
+        if (ret != 0) {
+            buckets_error("Failed to create batch write thread %zu: %d", b, ret);
+            buckets_quorum_tracker_done(tracker, 0, (u32)batch->chunk_count, NULL);
+        } else {
+            pthread_detach(batch->thread);
+        }
+    }
+    
+    /* qw belongs to the tracker from here on */
+    int result = buckets_quorum_tracker_wait(tracker);
+    if (result != 0) {
+        buckets_warn("[BATCHED_WRITE] Write quorum %u/%u not reached", write_quorum, num_chunks);
+    } else {
+        buckets_info("[BATCHED_WRITE] Write quorum %u/%u reached", write_quorum, num_chunks);
+    }
+    return result;
+}
+
 /**
  * Write multiple chunks in parallel with automatic batching by node
  * 
@@ -115,6 +266,25 @@ int buckets_batched_parallel_write_chunks(const char *bucket,
                                           const void **chunk_data_array,
                                           size_t chunk_size,
                                           u32 num_chunks)
+{
+    return buckets_batched_parallel_write_chunks_quorum(bucket, object, object_path, placement,
+                                                        chunk_data_array, chunk_size,
+                                                        num_chunks, num_chunks, NULL);
+}
+
+/**
+ * Batched parallel chunk write that returns at write quorum
+ * (see buckets_storage.h)
+ */
+int buckets_batched_parallel_write_chunks_quorum(const char *bucket,
+                                                 const char *object,
+                                                 const char *object_path,
+                                                 buckets_placement_result_t *placement,
+                                                 const void **chunk_data_array,
+                                                 size_t chunk_size,
+                                                 u32 num_chunks,
+                                                 u32 write_quorum,
+                                                 const buckets_xl_meta_t *meta)
 {
     if (!bucket || !object || !object_path || !placement || !chunk_data_array) {
         buckets_error("Invalid parameters for batched parallel write");
@@ -155,6 +325,7 @@ int buckets_batched_parallel_write_chunks(const char *bucket,
         batches[i].chunk_count = 0;
         batches[i].is_local = false;
         batches[i].result = -1;
+        batches[i].tracker = NULL;
         batches[i].thread = 0;
         batches[i].node_endpoint[0] = '\0';
     }
@@ -237,9 +408,14 @@ int buckets_batched_parallel_write_chunks(const char *bucket,
                      batches[b].node_endpoint);
     }
     
+    if (write_quorum < num_chunks && meta) {
+        return write_batches_quorum(batches, batch_count, object_path, chunk_size,
+                                    num_chunks, write_quorum, meta);
+    }
+    
     /* Launch batch write threads */
     for (size_t b = 0; b < batch_count; b++) {
-        int ret = pthread_create(&batches[b].thread, NULL, batch_write_worker, &batches[b]);
+        int ret = buckets_account_thread_create(&batches[b].thread, batch_write_worker, &batches[b]);
         if (ret != 0) {
             buckets_error("Failed to create batch write thread %zu: %d", b, ret);
             batches[b].result = -1;
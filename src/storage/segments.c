@@ -0,0 +1,694 @@
+/**
+ * Segmented Objects
+ *
+ * A multi-hundred-GB object placed by its own key lands on one erasure
+ * set, so its throughput is capped by that set's K+M disks and it fills
+ * them unevenly. Above BUCKETS_SEGMENT_MB such objects are cut into
+ * fixed-size segments stored as system-bucket objects, each placed by its
+ * own key, and up to BUCKETS_SEGMENT_PARALLEL of them are written or read
+ * at once through the regular object path.
+ *
+ * Segment ids are fresh per PUT, so an overwrite never writes over
+ * segments that a reader of the old manifest may be fetching. Segments a
+ * write or delete leaves unreferenced are not deleted on the spot: they
+ * are queued and reclaimed after a grace period, and only if the object's
+ * current manifest does not name them by then. The same check catches
+ * the loser of two concurrent overwrites, which queues its own segments.
+ * The queue is per process and drained on shutdown.
+ *
+ * Finding a replaced manifest costs a set-wide xl.meta lookup, so PUTs and
+ * deletes only do it while segments may exist: segmentation is enabled,
+ * or was when a marker file was left in the data directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_registry.h"
+#include "buckets_placement.h"
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;
+    buckets_segment_config_t config;
+    bool seen;                      /* Segments may exist (atomic) */
+    char marker[PATH_MAX];          /* Records that segmentation was on */
+} g_segments = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .config = {
+        .segment_size = 0,
+        .parallel = BUCKETS_SEGMENT_PARALLEL_DEFAULT,
+        .grace_ms = BUCKETS_SEGMENT_GRACE_S_DEFAULT * 1000,
+    }
+};
+
+static void segments_init_once(void)
+{
+    const char *env = getenv("BUCKETS_SEGMENT_MB");
+    if (env && *env) {
+        g_segments.config.segment_size = strtoull(env, NULL, 10) << 20;
+    }
+    env = getenv("BUCKETS_SEGMENT_PARALLEL");
+    if (env && *env) {
+        int n = atoi(env);
+        g_segments.config.parallel = n > 0 ? (u32)n : 1;
+    }
+    env = getenv("BUCKETS_SEGMENT_GRACE_S");
+    if (env && *env) {
+        g_segments.config.grace_ms = (u32)strtoul(env, NULL, 10) * 1000;
+    }
+    if (g_segments.config.segment_size > 0) {
+        buckets_info("Segmented objects: %llu MB segments, %u in parallel",
+                     (unsigned long long)(g_segments.config.segment_size >> 20),
+                     g_segments.config.parallel);
+    }
+}
+
+void buckets_segments_init_from_env(void)
+{
+    pthread_once(&g_segments.once, segments_init_once);
+}
+
+/* Leave the marker once segmentation is on; caller holds the lock */
+static void segments_mark_locked(void)
+{
+    __atomic_store_n(&g_segments.seen, true, __ATOMIC_RELAXED);
+    if (g_segments.marker[0] == '\0' || access(g_segments.marker, F_OK) == 0) {
+        return;
+    }
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", g_segments.marker);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        *slash = '\0';
+        mkdir(dir, 0755);
+    }
+    int fd = open(g_segments.marker, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        buckets_warn("Cannot create segment marker %s: %s", g_segments.marker,
+                     strerror(errno));
+        return;
+    }
+    close(fd);
+}
+
+void buckets_segments_open(const char *data_dir)
+{
+    buckets_segments_init_from_env();
+
+    pthread_mutex_lock(&g_segments.lock);
+    g_segments.marker[0] = '\0';
+    if (data_dir && *data_dir) {
+        snprintf(g_segments.marker, sizeof(g_segments.marker), "%s/%s", data_dir,
+                 BUCKETS_SEGMENT_MARKER);
+    }
+    bool marked = g_segments.marker[0] != '\0' && access(g_segments.marker, F_OK) == 0;
+    __atomic_store_n(&g_segments.seen, marked, __ATOMIC_RELAXED);
+    if (g_segments.config.segment_size > 0) {
+        segments_mark_locked();
+    } else if (marked) {
+        buckets_info("Segmentation is off, still reclaiming earlier segments");
+    }
+    pthread_mutex_unlock(&g_segments.lock);
+}
+
+void buckets_segments_configure(const buckets_segment_config_t *config)
+{
+    if (!config) {
+        return;
+    }
+    buckets_segments_init_from_env();
+
+    pthread_mutex_lock(&g_segments.lock);
+    g_segments.config = *config;
+    if (g_segments.config.parallel == 0) {
+        g_segments.config.parallel = 1;
+    }
+    if (g_segments.config.segment_size > 0) {
+        segments_mark_locked();
+    }
+    pthread_mutex_unlock(&g_segments.lock);
+}
+
+bool buckets_segments_may_exist(void)
+{
+    buckets_segments_init_from_env();
+    return __atomic_load_n(&g_segments.seen, __ATOMIC_RELAXED);
+}
+
+void buckets_segments_get_config(buckets_segment_config_t *config)
+{
+    if (!config) {
+        return;
+    }
+    buckets_segments_init_from_env();
+
+    pthread_mutex_lock(&g_segments.lock);
+    *config = g_segments.config;
+    pthread_mutex_unlock(&g_segments.lock);
+}
+
+bool buckets_segments_should_split(const char *bucket, size_t size)
+{
+    if (!bucket || strcmp(bucket, BUCKETS_SYSTEM_BUCKET) == 0 ||
+        strcmp(bucket, BUCKETS_REGISTRY_BUCKET) == 0) {
+        return false;
+    }
+    buckets_segment_config_t config;
+    buckets_segments_get_config(&config);
+    return config.segment_size > 0 && size > config.segment_size;
+}
+
+bool buckets_xl_meta_is_segmented(const buckets_xl_meta_t *meta)
+{
+    return meta && meta->segments.count > 0 && meta->segments.prefix;
+}
+
+void buckets_segment_key(const char *prefix, u32 index, char *key, size_t size)
+{
+    snprintf(key, size, "%s/%u", prefix, index);
+}
+
+/* ===================================================================
+ * Parallel Segment I/O
+ * ===================================================================*/
+
+typedef enum {
+    SEGMENT_OP_PUT,
+    SEGMENT_OP_GET,
+    SEGMENT_OP_DELETE
+} segment_op_t;
+
+typedef struct {
+    segment_op_t op;
+    const char *prefix;
+    u32 count;
+    u64 segment_size;
+    u64 total_size;
+    const u8 *src;              /* PUT: whole object */
+    u8 *dst;                    /* GET: whole object */
+    u32 done;                   /* Segments completed */
+    int failed;
+} segment_job_t;
+
+static size_t segment_len(const segment_job_t *job, u32 index)
+{
+    u64 offset = (u64)index * job->segment_size;
+    u64 left = job->total_size - offset;
+    return (size_t)(left < job->segment_size ? left : job->segment_size);
+}
+
+static int segment_run_one(segment_job_t *job, u32 index)
+{
+    char key[PATH_MAX];
+    buckets_segment_key(job->prefix, index, key, sizeof(key));
+    u64 offset = (u64)index * job->segment_size;
+    size_t len = segment_len(job, index);
+
+    switch (job->op) {
+    case SEGMENT_OP_PUT:
+        return buckets_put_object(BUCKETS_SYSTEM_BUCKET, key, job->src + offset, len, NULL);
+    case SEGMENT_OP_GET: {
+        void *data = NULL;
+        size_t size = 0;
+        if (buckets_get_object(BUCKETS_SYSTEM_BUCKET, key, &data, &size) != 0) {
+            return -1;
+        }
+        int ret = -1;
+        if (size == len) {
+            memcpy(job->dst + offset, data, len);
+            ret = 0;
+        } else {
+            buckets_error("Segment %s has %zu bytes, expected %zu", key, size, len);
+        }
+        buckets_free(data);
+        return ret;
+    }
+    case SEGMENT_OP_DELETE: {
+        extern int buckets_distributed_delete_object(const char *bucket, const char *object);
+        return buckets_distributed_delete_object(BUCKETS_SYSTEM_BUCKET, key);
+    }
+    }
+    return -1;
+}
+
+static int segment_worker(void *arg, int index)
+{
+    segment_job_t *job = (segment_job_t*)arg;
+
+    if (segment_run_one(job, (u32)index) != 0) {
+        buckets_warn("Segment %s/%d failed (op %d)", job->prefix, index, (int)job->op);
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        /* PUT and GET stop at the first failure; DELETE tries every segment */
+        return job->op != SEGMENT_OP_DELETE ? -1 : 0;
+    }
+    __atomic_add_fetch(&job->done, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* Run the job on up to parallel threads, the caller being one of them */
+static int segment_job_run(segment_job_t *job)
+{
+    buckets_segment_config_t config;
+    buckets_segments_get_config(&config);
+
+    buckets_parallel_for((int)job->count, (int)config.parallel, segment_worker, job);
+    return job->failed ? -1 : 0;
+}
+
+int buckets_read_segments(const buckets_xl_meta_t *meta, void **data, size_t *size)
+{
+    if (!buckets_xl_meta_is_segmented(meta) || !data || !size) {
+        return -1;
+    }
+
+    u8 *buf = buckets_malloc(meta->stat.size > 0 ? meta->stat.size : 1);
+    if (!buf) {
+        return -1;
+    }
+    segment_job_t job = {
+        .op = SEGMENT_OP_GET,
+        .prefix = meta->segments.prefix,
+        .count = meta->segments.count,
+        .segment_size = meta->segments.size,
+        .total_size = meta->stat.size,
+        .dst = buf,
+    };
+    if ((u64)(job.count - 1) * job.segment_size >= job.total_size ||
+        (u64)job.count * job.segment_size < job.total_size) {
+        buckets_error("Invalid segment layout: %u x %llu for %zu bytes", job.count,
+                      (unsigned long long)job.segment_size, meta->stat.size);
+        buckets_free(buf);
+        return -1;
+    }
+    if (segment_job_run(&job) != 0) {
+        buckets_free(buf);
+        return -1;
+    }
+
+    *data = buf;
+    *size = meta->stat.size;
+    return 0;
+}
+
+int buckets_delete_segments(const buckets_xl_meta_t *meta)
+{
+    if (!buckets_xl_meta_is_segmented(meta)) {
+        return 0;
+    }
+    segment_job_t job = {
+        .op = SEGMENT_OP_DELETE,
+        .prefix = meta->segments.prefix,
+        .count = meta->segments.count,
+        .segment_size = meta->segments.size,
+        .total_size = meta->stat.size,
+    };
+    return segment_job_run(&job);
+}
+
+/* ===================================================================
+ * Manifests
+ * ===================================================================*/
+
+int buckets_segments_read_manifest(const char *bucket, const char *object,
+                                   const char *object_path,
+                                   buckets_placement_result_t *placement,
+                                   const char *disk_path,
+                                   buckets_xl_meta_t *meta)
+{
+    if (!bucket || !object || !object_path || !meta) {
+        return -1;
+    }
+    memset(meta, 0, sizeof(*meta));
+
+    if (!placement || placement->disk_count == 0) {
+        if (disk_path && buckets_read_xl_meta(disk_path, object_path, meta) == 0) {
+            if (buckets_xl_meta_is_segmented(meta)) {
+                return 0;
+            }
+            buckets_xl_meta_free(meta);
+        }
+        return -1;
+    }
+
+    /* Local disks first: any copy of the manifest will do */
+    for (u32 i = 0; i < placement->disk_count; i++) {
+        if (buckets_read_xl_meta(placement->disk_paths[i], object_path, meta) == 0) {
+            if (buckets_xl_meta_is_segmented(meta)) {
+                return 0;
+            }
+            buckets_xl_meta_free(meta);
+            return -1;
+        }
+    }
+
+    bool has_endpoints = (placement->disk_endpoints && placement->disk_endpoints[0] &&
+                          placement->disk_endpoints[0][0] != '\0');
+    for (u32 i = 0; has_endpoints && i < placement->disk_count; i++) {
+        if (!placement->disk_endpoints[i] ||
+            buckets_distributed_is_local_disk(placement->disk_endpoints[i])) {
+            continue;
+        }
+        char node_endpoint[256];
+        if (buckets_distributed_extract_node_endpoint(placement->disk_endpoints[i],
+                                                      node_endpoint,
+                                                      sizeof(node_endpoint)) != 0) {
+            continue;
+        }
+        extern int buckets_distributed_read_xlmeta(const char *peer_endpoint,
+                                                   const char *bucket, const char *object,
+                                                   const char *disk_path,
+                                                   buckets_xl_meta_t *meta);
+        if (buckets_distributed_read_xlmeta(node_endpoint, bucket, object,
+                                            placement->disk_paths[i], meta) == 0) {
+            if (buckets_xl_meta_is_segmented(meta)) {
+                return 0;
+            }
+            buckets_xl_meta_free(meta);
+            return -1;
+        }
+    }
+    return -1;
+}
+
+static int write_manifest(const char *bucket, const char *object, const char *object_path,
+                          buckets_placement_result_t *placement, const char *disk_path,
+                          const buckets_xl_meta_t *meta)
+{
+    if (!placement || placement->disk_count == 0) {
+        return buckets_write_xl_meta(disk_path, object_path, meta);
+    }
+
+    /* Every disk of the set holds the manifest, like a replicated object */
+    bool has_endpoints = (placement->disk_endpoints && placement->disk_endpoints[0] &&
+                          placement->disk_endpoints[0][0] != '\0');
+    u32 write_quorum = buckets_write_quorum(1, placement->disk_count - 1);
+    return buckets_parallel_write_metadata_quorum(bucket, object, object_path,
+                                                  placement, placement->disk_paths, meta,
+                                                  placement->disk_count, has_endpoints,
+                                                  write_quorum);
+}
+
+int buckets_write_segments(const char *bucket, const char *object,
+                           const char *object_path,
+                           buckets_placement_result_t *placement,
+                           const char *disk_path,
+                           const void *data, size_t size,
+                           buckets_xl_meta_t *meta)
+{
+    if (!bucket || !object || !object_path || !data || !meta) {
+        return -1;
+    }
+    buckets_segment_config_t config;
+    buckets_segments_get_config(&config);
+    if (config.segment_size == 0) {
+        return -1;
+    }
+
+    char id[37];
+    if (buckets_generate_version_id(id) != 0) {
+        return -1;
+    }
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), BUCKETS_SEGMENT_PREFIX "%s", id);
+
+    meta->segments.count = (u32)((size + config.segment_size - 1) / config.segment_size);
+    meta->segments.size = config.segment_size;
+    meta->segments.prefix = buckets_strdup(prefix);
+
+    buckets_info("Writing %s/%s as %u segments of %llu bytes (%s)", bucket, object,
+                 meta->segments.count, (unsigned long long)config.segment_size, prefix);
+
+    segment_job_t job = {
+        .op = SEGMENT_OP_PUT,
+        .prefix = meta->segments.prefix,
+        .count = meta->segments.count,
+        .segment_size = config.segment_size,
+        .total_size = size,
+        .src = (const u8*)data,
+    };
+    int ret = segment_job_run(&job);
+    if (ret == 0) {
+        ret = write_manifest(bucket, object, object_path, placement, disk_path, meta);
+    }
+
+    if (ret != 0) {
+        buckets_error("Segmented write failed for %s/%s (%u/%u segments written)",
+                      bucket, object, job.done, meta->segments.count);
+        buckets_delete_segments(meta);
+    } else if (config.grace_ms > 0) {
+        /* A concurrent overwrite may land its manifest over ours: ours are
+         * then reclaimed once the grace period shows they lost */
+        buckets_segments_defer_reclaim(bucket, object, meta);
+    }
+    return ret;
+}
+
+/* ===================================================================
+ * Deferred Reclaim
+ * ===================================================================*/
+
+typedef struct segment_retired {
+    char *bucket;
+    char *object;
+    char *prefix;
+    u32 count;
+    u64 segment_size;
+    u64 total_size;
+    u64 due_ms;
+    struct segment_retired *next;
+} segment_retired_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    segment_retired_t *head;        /* Sorted by due_ms */
+    pthread_t thread;
+    bool running;
+    bool stop;
+    pid_t pid;                      /* Process the queue belongs to */
+    u64 reclaimed;
+} g_reclaim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static u64 reclaim_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+static void retired_free(segment_retired_t *r)
+{
+    buckets_free(r->bucket);
+    buckets_free(r->object);
+    buckets_free(r->prefix);
+    buckets_free(r);
+}
+
+bool buckets_segments_find_manifest(const char *bucket, const char *object,
+                                    buckets_xl_meta_t *meta)
+{
+    if (!bucket || !object || !meta || strcmp(bucket, BUCKETS_SYSTEM_BUCKET) == 0 ||
+        strcmp(bucket, BUCKETS_REGISTRY_BUCKET) == 0 || !buckets_segments_may_exist()) {
+        return false;
+    }
+
+    char object_path[PATH_MAX];
+    buckets_compute_object_path(bucket, object, object_path, sizeof(object_path));
+    buckets_placement_result_t *placement = NULL;
+    if (buckets_placement_compute(bucket, object, &placement) != 0) {
+        placement = NULL;
+    }
+    const buckets_storage_config_t *storage = buckets_storage_get_config();
+    bool found = buckets_segments_read_manifest(bucket, object, object_path, placement,
+                                                storage ? storage->data_dir : NULL,
+                                                meta) == 0;
+    if (placement) {
+        buckets_placement_free_result(placement);
+    }
+    return found;
+}
+
+/* Delete r's segments unless the object's manifest still names them */
+static bool reclaim_one(const segment_retired_t *r)
+{
+    buckets_xl_meta_t current;
+    if (buckets_segments_find_manifest(r->bucket, r->object, &current)) {
+        bool live = strcmp(current.segments.prefix, r->prefix) == 0;
+        buckets_xl_meta_free(&current);
+        if (live) {
+            return false;
+        }
+    }
+
+    buckets_xl_meta_t meta = {0};
+    meta.segments.prefix = r->prefix;
+    meta.segments.count = r->count;
+    meta.segments.size = r->segment_size;
+    meta.stat.size = r->total_size;
+    buckets_debug("Reclaiming %u segments of %s/%s (%s)", r->count, r->bucket,
+                  r->object, r->prefix);
+    buckets_delete_segments(&meta);
+    __atomic_add_fetch(&g_reclaim.reclaimed, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* A child inherits the parent's queue, which the parent reclaims */
+static void reclaim_check_fork_locked(void)
+{
+    if (g_reclaim.pid == getpid()) {
+        return;
+    }
+    g_reclaim.pid = getpid();
+    g_reclaim.head = NULL;
+    g_reclaim.running = false;
+    g_reclaim.stop = false;
+}
+
+static void* reclaim_thread(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_reclaim.lock);
+    while (!g_reclaim.stop) {
+        if (!g_reclaim.head) {
+            pthread_cond_wait(&g_reclaim.cond, &g_reclaim.lock);
+            continue;
+        }
+        u64 now = reclaim_now_ms();
+        if (g_reclaim.head->due_ms > now) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            u64 wait_ms = g_reclaim.head->due_ms - now;
+            ts.tv_sec += (time_t)(wait_ms / 1000);
+            ts.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&g_reclaim.cond, &g_reclaim.lock, &ts);
+            continue;
+        }
+        pthread_mutex_unlock(&g_reclaim.lock);
+        buckets_segments_reap(false);
+        pthread_mutex_lock(&g_reclaim.lock);
+    }
+    pthread_mutex_unlock(&g_reclaim.lock);
+    return NULL;
+}
+
+void buckets_segments_defer_reclaim(const char *bucket, const char *object,
+                                    const buckets_xl_meta_t *manifest)
+{
+    if (!bucket || !object || !buckets_xl_meta_is_segmented(manifest)) {
+        return;
+    }
+
+    segment_retired_t *r = buckets_calloc(1, sizeof(*r));
+    r->bucket = buckets_strdup(bucket);
+    r->object = buckets_strdup(object);
+    r->prefix = buckets_strdup(manifest->segments.prefix);
+    r->count = manifest->segments.count;
+    r->segment_size = manifest->segments.size;
+    r->total_size = manifest->stat.size;
+
+    buckets_segment_config_t config;
+    buckets_segments_get_config(&config);
+    if (config.grace_ms == 0) {
+        reclaim_one(r);
+        retired_free(r);
+        return;
+    }
+    r->due_ms = reclaim_now_ms() + config.grace_ms;
+
+    pthread_mutex_lock(&g_reclaim.lock);
+    reclaim_check_fork_locked();
+    segment_retired_t **pp = &g_reclaim.head;
+    while (*pp && (*pp)->due_ms <= r->due_ms) {
+        pp = &(*pp)->next;
+    }
+    r->next = *pp;
+    *pp = r;
+    if (!g_reclaim.running && !g_reclaim.stop) {
+        if (buckets_account_thread_create(&g_reclaim.thread, reclaim_thread, NULL) == 0) {
+            g_reclaim.running = true;
+        } else {
+            buckets_warn("No segment reclaim thread, reclaiming on shutdown: %s",
+                         strerror(errno));
+        }
+    }
+    pthread_cond_signal(&g_reclaim.cond);
+    pthread_mutex_unlock(&g_reclaim.lock);
+}
+
+u32 buckets_segments_reap(bool all)
+{
+    pthread_mutex_lock(&g_reclaim.lock);
+    reclaim_check_fork_locked();
+    u64 now = reclaim_now_ms();
+    segment_retired_t *due = g_reclaim.head;
+    segment_retired_t **tail = &g_reclaim.head;
+    while (*tail && (all || (*tail)->due_ms <= now)) {
+        tail = &(*tail)->next;
+    }
+    g_reclaim.head = *tail;
+    *tail = NULL;
+    pthread_mutex_unlock(&g_reclaim.lock);
+
+    u32 reclaimed = 0;
+    while (due) {
+        segment_retired_t *next = due->next;
+        if (reclaim_one(due)) {
+            reclaimed++;
+        }
+        retired_free(due);
+        due = next;
+    }
+    return reclaimed;
+}
+
+void buckets_segments_cleanup(void)
+{
+    pthread_mutex_lock(&g_reclaim.lock);
+    reclaim_check_fork_locked();
+    bool running = g_reclaim.running;
+    g_reclaim.stop = true;
+    pthread_cond_signal(&g_reclaim.cond);
+    pthread_mutex_unlock(&g_reclaim.lock);
+    if (running) {
+        pthread_join(g_reclaim.thread, NULL);
+    }
+
+    /* Readers in this process are gone: nothing left to wait for */
+    buckets_segments_reap(true);
+
+    pthread_mutex_lock(&g_reclaim.lock);
+    g_reclaim.running = false;
+    g_reclaim.stop = false;
+    pthread_mutex_unlock(&g_reclaim.lock);
+}
+
+void buckets_segments_reinit_after_fork(void)
+{
+    /* The parent's reclaim thread did not come along, and may have held
+     * the lock at fork time */
+    pthread_mutex_init(&g_reclaim.lock, NULL);
+    pthread_cond_init(&g_reclaim.cond, NULL);
+    g_reclaim.pid = getpid();
+    g_reclaim.head = NULL;
+    g_reclaim.running = false;
+    g_reclaim.stop = false;
+}
@@ -0,0 +1,461 @@
+/**
+ * Storage Classes
+ *
+ * Per-object choice between full replicas and erasure coding. Small and
+ * mid-size objects pay one file, one fsync and one network write per copy
+ * instead of K+M tiny shards; large objects keep the space efficiency of
+ * K+M. Policies come from the environment (see buckets_storage.h) and can
+ * be changed per bucket at runtime.
+ *
+ * Replicas start at a disk chosen by the object's hash and skip disks that
+ * are offline or on dead nodes, so small objects spread over the whole set
+ * instead of always landing on its first disks. erasure.distribution
+ * records the set disk (1-based) holding each copy.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_hash.h"
+
+#define POLICY_MAX_BUCKETS 256
+
+typedef struct {
+    char bucket[256];
+    buckets_storage_policy_t policy;
+} bucket_policy_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_rwlock_t lock;
+    buckets_storage_policy_t fallback;
+    bucket_policy_t buckets[POLICY_MAX_BUCKETS];
+    u32 bucket_count;
+} g_policies = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_RWLOCK_INITIALIZER,
+    .fallback = {
+        .replica_max = BUCKETS_REPLICA_MAX_DEFAULT,
+        .replicas = BUCKETS_REPLICAS_DEFAULT,
+    }
+};
+
+/* ===================================================================
+ * Policy Parsing
+ * ===================================================================*/
+
+/* "4194304", "4M", "512K", "1G" */
+static bool parse_size(const char *s, u64 *out)
+{
+    char *end = NULL;
+    unsigned long long n = strtoull(s, &end, 10);
+    if (end == s) {
+        return false;
+    }
+    switch (*end) {
+    case 'K': case 'k': n <<= 10; end++; break;
+    case 'M': case 'm': n <<= 20; end++; break;
+    case 'G': case 'g': n <<= 30; end++; break;
+    default: break;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    *out = n;
+    return true;
+}
+
+int buckets_storage_policy_parse(const char *spec, buckets_storage_policy_t *policy)
+{
+    if (!spec || !policy) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    buckets_storage_policy_t parsed = *policy;
+    char buf[256];
+    if (strlen(spec) >= sizeof(buf)) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    strcpy(buf, spec);
+
+    char *save = NULL;
+    for (char *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(item, '=');
+        if (!eq) {
+            return BUCKETS_ERR_INVALID_ARG;
+        }
+        *eq = '\0';
+        const char *key = item;
+        const char *value = eq + 1;
+
+        if (strcmp(key, "replicas") == 0) {
+            u64 n = 0;
+            if (!parse_size(value, &n) || n < 1 || n > BUCKETS_MAX_CHUNKS) {
+                return BUCKETS_ERR_INVALID_ARG;
+            }
+            parsed.replicas = (u32)n;
+        } else if (strcmp(key, "replica_max") == 0) {
+            if (!parse_size(value, &parsed.replica_max)) {
+                return BUCKETS_ERR_INVALID_ARG;
+            }
+        } else if (strcmp(key, "ec") == 0) {
+            unsigned int k = 0, m = 0;
+            char extra;
+            if (sscanf(value, "%u+%u%c", &k, &m, &extra) != 2 || k == 0 ||
+                k + m > BUCKETS_MAX_CHUNKS) {
+                return BUCKETS_ERR_INVALID_ARG;
+            }
+            parsed.ec_k = k;
+            parsed.ec_m = m;
+        } else {
+            return BUCKETS_ERR_INVALID_ARG;
+        }
+    }
+
+    *policy = parsed;
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * Policy Table
+ * ===================================================================*/
+
+/* Caller holds the lock */
+static bucket_policy_t* find_bucket(const char *bucket)
+{
+    for (u32 i = 0; i < g_policies.bucket_count; i++) {
+        if (strcmp(g_policies.buckets[i].bucket, bucket) == 0) {
+            return &g_policies.buckets[i];
+        }
+    }
+    return NULL;
+}
+
+static void policy_init_once(void)
+{
+    const char *env = getenv("BUCKETS_STORAGE_POLICY");
+    if (env && env[0] != '\0') {
+        if (buckets_storage_policy_parse(env, &g_policies.fallback) != BUCKETS_OK) {
+            buckets_warn("Ignoring invalid BUCKETS_STORAGE_POLICY=%s", env);
+        }
+    }
+
+    env = getenv("BUCKETS_BUCKET_STORAGE_POLICY");
+    if (env && env[0] != '\0') {
+        char *list = buckets_strdup(env);
+        char *save = NULL;
+        for (char *entry = strtok_r(list, ";", &save); entry;
+             entry = strtok_r(NULL, ";", &save)) {
+            char *colon = strchr(entry, ':');
+            buckets_storage_policy_t policy = g_policies.fallback;
+            if (!colon || colon == entry ||
+                buckets_storage_policy_parse(colon + 1, &policy) != BUCKETS_OK) {
+                buckets_warn("Ignoring invalid bucket storage policy: %s", entry);
+                continue;
+            }
+            *colon = '\0';
+            if (g_policies.bucket_count < POLICY_MAX_BUCKETS && strlen(entry) < 256) {
+                bucket_policy_t *bp = &g_policies.buckets[g_policies.bucket_count++];
+                strcpy(bp->bucket, entry);
+                bp->policy = policy;
+            }
+        }
+        buckets_free(list);
+    }
+
+    buckets_info("Storage policy: replicas=%u below %lu bytes, %u bucket override(s)",
+                 g_policies.fallback.replicas, g_policies.fallback.replica_max,
+                 g_policies.bucket_count);
+}
+
+void buckets_storage_policy_init_from_env(void)
+{
+    pthread_once(&g_policies.once, policy_init_once);
+}
+
+int buckets_storage_policy_set(const char *bucket, const buckets_storage_policy_t *policy)
+{
+    buckets_storage_policy_init_from_env();
+    if ((!bucket && !policy) || (policy && (policy->replicas == 0 ||
+                                            policy->replicas > BUCKETS_MAX_CHUNKS ||
+                                            policy->ec_k + policy->ec_m > BUCKETS_MAX_CHUNKS))) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    if (bucket && strlen(bucket) >= sizeof(g_policies.buckets[0].bucket)) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    int ret = BUCKETS_OK;
+    pthread_rwlock_wrlock(&g_policies.lock);
+    if (!bucket) {
+        g_policies.fallback = *policy;
+    } else {
+        bucket_policy_t *bp = find_bucket(bucket);
+        if (!policy) {
+            if (bp) {
+                *bp = g_policies.buckets[--g_policies.bucket_count];
+            }
+        } else if (bp) {
+            bp->policy = *policy;
+        } else if (g_policies.bucket_count < POLICY_MAX_BUCKETS) {
+            bp = &g_policies.buckets[g_policies.bucket_count++];
+            strcpy(bp->bucket, bucket);
+            bp->policy = *policy;
+        } else {
+            ret = BUCKETS_ERR_NOMEM;
+        }
+    }
+    pthread_rwlock_unlock(&g_policies.lock);
+    return ret;
+}
+
+void buckets_storage_policy_get(const char *bucket, buckets_storage_policy_t *policy)
+{
+    if (!policy) {
+        return;
+    }
+    buckets_storage_policy_init_from_env();
+
+    pthread_rwlock_rdlock(&g_policies.lock);
+    bucket_policy_t *bp = bucket ? find_bucket(bucket) : NULL;
+    *policy = bp ? bp->policy : g_policies.fallback;
+    pthread_rwlock_unlock(&g_policies.lock);
+}
+
+/* ===================================================================
+ * Class Selection
+ * ===================================================================*/
+
+void buckets_storage_class_select(const char *bucket, size_t size, u32 set_disks,
+                                  buckets_storage_class_t *sc)
+{
+    if (!sc) {
+        return;
+    }
+
+    if (buckets_should_inline_object(size)) {
+        sc->type = BUCKETS_STORAGE_CLASS_INLINE;
+        sc->data = 0;
+        sc->parity = 0;
+        return;
+    }
+
+    buckets_storage_policy_t policy;
+    buckets_storage_policy_get(bucket, &policy);
+
+    if (size < policy.replica_max && policy.replicas >= 1 && set_disks >= policy.replicas) {
+        sc->type = BUCKETS_STORAGE_CLASS_REPLICATED;
+        sc->data = 1;
+        sc->parity = policy.replicas - 1;
+        return;
+    }
+
+    sc->type = BUCKETS_STORAGE_CLASS_ERASURE;
+    if (policy.ec_k > 0) {
+        sc->data = policy.ec_k;
+        sc->parity = policy.ec_m;
+    } else {
+        const buckets_storage_config_t *config = buckets_storage_get_config();
+        sc->data = config ? config->default_ec_k : 0;
+        sc->parity = config ? config->default_ec_m : 0;
+    }
+}
+
+bool buckets_xl_meta_is_replicated(const buckets_xl_meta_t *meta)
+{
+    return meta && !meta->inline_data &&
+           strcmp(meta->erasure.algorithm, BUCKETS_ALGO_REPLICATION) == 0;
+}
+
+/* ===================================================================
+ * Replicated I/O
+ * ===================================================================*/
+
+/* Seed for the replica start disk, unrelated to the set hash */
+#define REPLICA_START_SEED 0x7265706c69636173ULL
+
+/**
+ * Pick the set disks for each copy: walk the set from a hash-chosen start,
+ * healthy disks first, then the rest so the write quorum still decides
+ */
+static void replica_choose_disks(const char *bucket, const char *object,
+                                 const buckets_placement_result_t *placement,
+                                 u32 copies, u32 *distribution)
+{
+    u32 n = placement->disk_count;
+    char key[PATH_MAX];
+    int len = snprintf(key, sizeof(key), "%s/%s", bucket, object);
+    u32 start = (u32)(buckets_xxhash64(REPLICA_START_SEED, key,
+                                       len > 0 ? (size_t)len : 0) % n);
+
+    u32 chosen = 0;
+    u32 skipped = 0;
+    for (u32 i = 0; i < n && chosen < copies; i++) {
+        u32 d = (start + i) % n;
+        if (buckets_distributed_disk_available(
+                placement->disk_endpoints ? placement->disk_endpoints[d] : NULL,
+                placement->disk_paths[d])) {
+            distribution[chosen++] = d + 1;
+        } else {
+            skipped++;
+        }
+    }
+
+    /* Not enough healthy disks: fill up with the skipped ones in order */
+    for (u32 i = 0; i < n && chosen < copies && skipped > 0; i++) {
+        u32 d = (start + i) % n;
+        bool taken = false;
+        for (u32 c = 0; c < chosen && !taken; c++) {
+            taken = distribution[c] == d + 1;
+        }
+        if (!taken) {
+            distribution[chosen++] = d + 1;
+        }
+    }
+}
+
+int buckets_replica_view(const buckets_placement_result_t *placement,
+                         const buckets_xl_meta_t *meta,
+                         buckets_replica_view_t *view)
+{
+    if (!placement || !meta || !view) {
+        return -1;
+    }
+    u32 copies = meta->erasure.data + meta->erasure.parity;
+    if (copies == 0 || copies > BUCKETS_MAX_CHUNKS) {
+        return -1;
+    }
+
+    view->placement = *placement;
+    view->placement.disk_count = copies;
+    view->placement.disk_paths = view->disk_paths;
+    view->placement.disk_uuids = placement->disk_uuids ? view->disk_uuids : NULL;
+    view->placement.disk_endpoints = placement->disk_endpoints ? view->disk_endpoints : NULL;
+
+    for (u32 i = 0; i < copies; i++) {
+        /* Objects written before distribution was recorded: copy i on disk i */
+        u32 d = i;
+        if (meta->erasure.distribution && meta->erasure.distribution[i] >= 1 &&
+            meta->erasure.distribution[i] <= placement->disk_count) {
+            d = meta->erasure.distribution[i] - 1;
+        }
+        if (d >= placement->disk_count) {
+            return -1;
+        }
+        view->disk_paths[i] = placement->disk_paths[d];
+        if (placement->disk_uuids) {
+            view->disk_uuids[i] = placement->disk_uuids[d];
+        }
+        if (placement->disk_endpoints) {
+            view->disk_endpoints[i] = placement->disk_endpoints[d];
+        }
+    }
+    return 0;
+}
+
+int buckets_write_replicas(const char *bucket, const char *object,
+                           const char *object_path,
+                           buckets_placement_result_t *placement,
+                           const void *data, size_t size, u32 copies,
+                           buckets_xl_meta_t *meta)
+{
+    if (!placement || copies == 0 || placement->disk_count < copies ||
+        copies > BUCKETS_MAX_CHUNKS || !meta) {
+        return -1;
+    }
+
+    meta->erasure.data = 1;
+    meta->erasure.parity = copies - 1;
+    meta->erasure.blockSize = size;
+    meta->erasure.index = 1;
+    strcpy(meta->erasure.algorithm, BUCKETS_ALGO_REPLICATION);
+
+    meta->erasure.distribution = buckets_malloc(copies * sizeof(u32));
+    meta->erasure.checksums = buckets_malloc(copies * sizeof(buckets_checksum_t));
+    const void **copy_array = buckets_malloc(copies * sizeof(void*));
+    if (!meta->erasure.distribution || !meta->erasure.checksums || !copy_array) {
+        buckets_free(copy_array);
+        return -1;
+    }
+
+    /* Every copy is the same bytes: one checksum for all of them */
+    extern int buckets_compute_chunk_checksum(const void *data, size_t size,
+                                               buckets_checksum_t *checksum);
+    buckets_compute_chunk_checksum(data, size, &meta->erasure.checksums[0]);
+    replica_choose_disks(bucket, object, placement, copies, meta->erasure.distribution);
+    for (u32 i = 0; i < copies; i++) {
+        meta->erasure.checksums[i] = meta->erasure.checksums[0];
+        copy_array[i] = data;
+    }
+
+    /* Copy i goes to the i-th chosen disk */
+    buckets_replica_view_t view;
+    if (buckets_replica_view(placement, meta, &view) != 0) {
+        buckets_free(copy_array);
+        return -1;
+    }
+
+    bool has_endpoints = (placement->disk_endpoints &&
+                          placement->disk_endpoints[0] &&
+                          placement->disk_endpoints[0][0] != '\0');
+    u32 write_quorum = buckets_write_quorum(1, copies - 1);
+
+    buckets_info("Writing %u replicas of %s/%s from disk %u (size=%zu, quorum=%u)",
+                 copies, bucket, object, meta->erasure.distribution[0], size, write_quorum);
+
+    int ret = buckets_batched_parallel_write_chunks_quorum(bucket, object, object_path,
+                                                           &view.placement, copy_array, size,
+                                                           copies, write_quorum, meta);
+    buckets_free(copy_array);
+    if (ret != 0) {
+        buckets_error("Replica write failed for %s/%s", bucket, object);
+        return -1;
+    }
+
+    /* xl.meta goes to every disk of the set, not just the copies: readers
+     * take the first one they find, and an earlier version's xl.meta on a
+     * disk without a copy would otherwise still be served */
+    u32 meta_quorum = buckets_write_quorum(1, placement->disk_count - 1);
+    return buckets_parallel_write_metadata_quorum(bucket, object, object_path,
+                                                  placement, placement->disk_paths, meta,
+                                                  placement->disk_count, has_endpoints,
+                                                  meta_quorum);
+}
+
+int buckets_replica_pick(const buckets_xl_meta_t *meta, void **copies,
+                         const size_t *sizes, u32 count,
+                         void **data, size_t *size)
+{
+    if (!meta || !copies || !sizes || !data || !size) {
+        return -1;
+    }
+
+    const buckets_storage_config_t *config = buckets_storage_get_config();
+    bool verify = meta->erasure.checksums && (!config || config->verify_checksums);
+
+    for (u32 i = 0; i < count; i++) {
+        if (!copies[i]) {
+            continue;
+        }
+        bool intact = sizes[i] == meta->stat.size &&
+                      (!verify || buckets_verify_chunk(copies[i], sizes[i],
+                                                       &meta->erasure.checksums[i]));
+        if (!intact) {
+            buckets_warn("Replica %u is corrupt (size=%zu, expected %zu), skipping",
+                         i + 1, sizes[i], meta->stat.size);
+            buckets_free(copies[i]);
+            copies[i] = NULL;
+            continue;
+        }
+        *data = copies[i];
+        *size = sizes[i];
+        copies[i] = NULL;
+        return 0;
+    }
+    return -1;
+}
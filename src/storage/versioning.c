@@ -22,6 +22,7 @@
 #include "buckets_storage.h"
 #include "buckets_io.h"
 #include "buckets_erasure.h"
+#include "buckets_mem_budget.h"
 
 /* Version directory structure */
 #define VERSION_DIR_NAME "versions"
@@ -478,6 +479,33 @@ int buckets_get_object_by_version(const char *bucket, const char *object,
         return 0;
     }
     
+    /* Replicated version: any intact copy is the object */
+    if (buckets_xl_meta_is_replicated(&meta)) {
+        u32 copies = meta.erasure.data + meta.erasure.parity;
+        buckets_mem_budget_charge((u64)meta.stat.size);
+
+        int ret = -1;
+        for (u32 i = 0; i < copies && i < BUCKETS_MAX_CHUNKS && ret != 0; i++) {
+            char copy_path[PATH_MAX * 3];
+            snprintf(copy_path, sizeof(copy_path), "%s/%s/part.%u",
+                     disk_path, version_path, i + 1);
+
+            void *copy[BUCKETS_MAX_CHUNKS] = {0};
+            size_t copy_sizes[BUCKETS_MAX_CHUNKS] = {0};
+            if (buckets_atomic_read(copy_path, &copy[i], &copy_sizes[i]) == 0) {
+                ret = buckets_replica_pick(&meta, copy, copy_sizes, i + 1, data, size);
+            }
+        }
+        if (ret == 0) {
+            buckets_info("Read versioned object: %s/%s version=%s size=%zu (replicated)",
+                         bucket, object, target_version, *size);
+        } else {
+            buckets_error("No intact replica of version %s", target_version);
+        }
+        buckets_xl_meta_free(&meta);
+        return ret;
+    }
+    
     /* Read erasure-coded chunks from version directory */
     u32 k = meta.erasure.data;
     u32 m = meta.erasure.parity;
@@ -494,6 +522,9 @@ int buckets_get_object_by_version(const char *bucket, const char *object,
     buckets_debug("Reading erasure-coded versioned object: k=%u, m=%u, chunk_size=%zu",
                   k, m, chunk_size);
     
+    /* Shards, then the decoded object that replaces them */
+    buckets_mem_budget_charge((u64)chunk_size * total_chunks);
+    
     /* Construct full version path for chunk reads */
     char full_version_path[PATH_MAX * 2];
     snprintf(full_version_path, sizeof(full_version_path), "%s/%s",
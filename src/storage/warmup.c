@@ -0,0 +1,406 @@
+/**
+ * Startup Timing and Cache Warm-up
+ *
+ * A restarted node serves its first minutes from cold registry and metadata
+ * caches: every hot key costs a disk (or peer) round trip until traffic has
+ * refilled them. With BUCKETS_CACHE_SNAPSHOT set, the keys (never the
+ * values) of the registry and object caches are saved on shutdown and
+ * looked up again by background threads after the next start, so the
+ * working set is back in memory shortly after the server starts accepting
+ * requests instead of after users have paid for every miss.
+ *
+ * Time to ready (serving) and time to warm (snapshot replayed) are both
+ * measured from buckets_startup_begin and logged.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_registry.h"
+#include "buckets_io.h"
+#include "buckets_io_priority.h"
+#include "cJSON.h"
+
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    char *key;
+    bool object;                    /* Object cache key, else registry key */
+} warmup_item_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;
+    char path[PATH_MAX];
+    bool enabled;
+    u32 max_keys;
+    u32 threads;
+
+    u64 begin_ms;
+    buckets_startup_stats_t stats;
+
+    /* Running warm-up */
+    warmup_item_t *items;
+    u32 item_count;
+    u32 next;
+    u32 active;
+    bool stop;
+    pthread_t *workers;
+    u32 worker_count;
+} g_warmup = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .max_keys = BUCKETS_CACHE_SNAPSHOT_DEFAULT_KEYS,
+    .threads = BUCKETS_WARMUP_DEFAULT_THREADS,
+};
+
+static u64 monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+/* Milliseconds since buckets_startup_begin (at least 1, so 0 stays "not yet") */
+static u64 since_begin_ms(void)
+{
+    u64 begin = __atomic_load_n(&g_warmup.begin_ms, __ATOMIC_ACQUIRE);
+    u64 elapsed = begin ? monotonic_ms() - begin : 0;
+    return elapsed > 0 ? elapsed : 1;
+}
+
+static void warmup_init_once(void)
+{
+    const char *env = getenv("BUCKETS_CACHE_SNAPSHOT");
+    if (env && *env && strcmp(env, "0") != 0 && strcmp(env, "off") != 0 &&
+        strcmp(env, "false") != 0) {
+        /* Forked workers have private caches, so one file each */
+        const char *worker = getenv("BUCKETS_WORKER_ID");
+        if (worker && *worker) {
+            snprintf(g_warmup.path, sizeof(g_warmup.path), "%s.w%s", env, worker);
+        } else {
+            snprintf(g_warmup.path, sizeof(g_warmup.path), "%s", env);
+        }
+        g_warmup.enabled = true;
+    }
+    env = getenv("BUCKETS_CACHE_SNAPSHOT_KEYS");
+    if (env && *env) {
+        g_warmup.max_keys = (u32)strtoul(env, NULL, 10);
+    }
+    env = getenv("BUCKETS_WARMUP_THREADS");
+    if (env && *env) {
+        int n = atoi(env);
+        g_warmup.threads = n > 0 ? (u32)n : 1;
+    }
+}
+
+/* ===================================================================
+ * Startup Timing
+ * ===================================================================*/
+
+void buckets_startup_begin(void)
+{
+    u64 expected = 0;
+    __atomic_compare_exchange_n(&g_warmup.begin_ms, &expected, monotonic_ms(),
+                                false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+void buckets_startup_ready(void)
+{
+    buckets_startup_begin();
+
+    pthread_mutex_lock(&g_warmup.lock);
+    if (g_warmup.stats.ready_ms == 0) {
+        g_warmup.stats.ready_ms = since_begin_ms();
+        buckets_info("Startup: ready to serve in %lu ms", g_warmup.stats.ready_ms);
+    }
+    pthread_mutex_unlock(&g_warmup.lock);
+}
+
+void buckets_startup_get_stats(buckets_startup_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    pthread_mutex_lock(&g_warmup.lock);
+    *stats = g_warmup.stats;
+    pthread_mutex_unlock(&g_warmup.lock);
+
+    /* Counted by the warm-up threads without the lock */
+    stats->warm_keys = __atomic_load_n(&g_warmup.stats.warm_keys, __ATOMIC_RELAXED);
+    stats->warm_failed = __atomic_load_n(&g_warmup.stats.warm_failed, __ATOMIC_RELAXED);
+}
+
+/* ===================================================================
+ * Snapshot
+ * ===================================================================*/
+
+const char* buckets_cache_snapshot_path(void)
+{
+    pthread_once(&g_warmup.once, warmup_init_once);
+    return g_warmup.enabled ? g_warmup.path : NULL;
+}
+
+static u32 add_keys(cJSON *array, char **keys, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        cJSON_AddItemToArray(array, cJSON_CreateString(keys[i]));
+        buckets_free(keys[i]);
+    }
+    buckets_free(keys);
+    return count;
+}
+
+int buckets_cache_snapshot_save(const char *path)
+{
+    if (!path) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    pthread_once(&g_warmup.once, warmup_init_once);
+
+    char **keys = NULL;
+    u32 count = 0;
+    u32 saved = 0;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "version", SNAPSHOT_VERSION);
+
+    cJSON *registry = cJSON_AddArrayToObject(root, "registry");
+    if (buckets_registry_cache_keys(&keys, &count, g_warmup.max_keys) == 0) {
+        saved += add_keys(registry, keys, count);
+    }
+
+    cJSON *objects = cJSON_AddArrayToObject(root, "objects");
+    if (buckets_object_cache_keys(&keys, &count, g_warmup.max_keys) == BUCKETS_OK) {
+        saved += add_keys(objects, keys, count);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) {
+        return BUCKETS_ERR_NOMEM;
+    }
+
+    int ret = buckets_atomic_write(path, json, strlen(json));
+    cJSON_free(json);
+    if (ret != BUCKETS_OK) {
+        buckets_warn("Failed to save cache snapshot to %s", path);
+        return ret;
+    }
+
+    pthread_mutex_lock(&g_warmup.lock);
+    g_warmup.stats.saved_keys = saved;
+    pthread_mutex_unlock(&g_warmup.lock);
+
+    buckets_info("Saved cache snapshot: %u keys to %s", saved, path);
+    return BUCKETS_OK;
+}
+
+/* ===================================================================
+ * Warm-up
+ * ===================================================================*/
+
+/* Registry keys are "bucket/object/version-id"; objects may contain '/' */
+static int warm_registry_key(const char *key)
+{
+    const char *first = strchr(key, '/');
+    const char *last = strrchr(key, '/');
+    if (!first || last == first) {
+        return -1;
+    }
+
+    char *bucket = buckets_format("%.*s", (int)(first - key), key);
+    char *object = buckets_format("%.*s", (int)(last - first - 1), first + 1);
+    buckets_object_location_t *location = NULL;
+    int ret = buckets_registry_lookup(bucket, object, last + 1, &location);
+    buckets_registry_location_free(location);
+    buckets_free(bucket);
+    buckets_free(object);
+    return ret;
+}
+
+/* Object cache keys are "bucket/object"; reading the metadata refills the
+ * registry and metadata paths the first GET would otherwise wait on */
+static int warm_object_key(const char *key)
+{
+    const char *slash = strchr(key, '/');
+    if (!slash || slash[1] == '\0') {
+        return -1;
+    }
+
+    char *bucket = buckets_format("%.*s", (int)(slash - key), key);
+    buckets_xl_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    int ret = buckets_head_object(bucket, slash + 1, &meta);
+    if (ret == 0) {
+        buckets_xl_meta_free(&meta);
+    }
+    buckets_free(bucket);
+    return ret;
+}
+
+static void* warmup_worker(void *arg)
+{
+    (void)arg;
+    buckets_io_class_set(BUCKETS_IO_CLASS_BULK);
+
+    for (;;) {
+        if (__atomic_load_n(&g_warmup.stop, __ATOMIC_RELAXED)) {
+            break;
+        }
+        u32 i = __atomic_fetch_add(&g_warmup.next, 1, __ATOMIC_RELAXED);
+        if (i >= g_warmup.item_count) {
+            break;
+        }
+        warmup_item_t *item = &g_warmup.items[i];
+        int ret = item->object ? warm_object_key(item->key) : warm_registry_key(item->key);
+        __atomic_add_fetch(ret == 0 ? &g_warmup.stats.warm_keys : &g_warmup.stats.warm_failed,
+                           1, __ATOMIC_RELAXED);
+    }
+
+    /* The last thread out reports */
+    if (__atomic_sub_fetch(&g_warmup.active, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&g_warmup.lock);
+        g_warmup.stats.warm_ms = since_begin_ms();
+        buckets_info("Startup: caches warm in %lu ms (%u keys, %u no longer present)%s",
+                     g_warmup.stats.warm_ms,
+                     __atomic_load_n(&g_warmup.stats.warm_keys, __ATOMIC_RELAXED),
+                     __atomic_load_n(&g_warmup.stats.warm_failed, __ATOMIC_RELAXED),
+                     __atomic_load_n(&g_warmup.stop, __ATOMIC_RELAXED) ? ", stopped early" : "");
+        pthread_mutex_unlock(&g_warmup.lock);
+    }
+    return NULL;
+}
+
+/* Append a JSON array of keys in reverse, so the most recent are looked up
+ * last and end up at the head of the LRU lists */
+static void load_keys(cJSON *array, bool object, warmup_item_t *items, u32 *count)
+{
+    for (int i = cJSON_GetArraySize(array) - 1; i >= 0; i--) {
+        cJSON *key = cJSON_GetArrayItem(array, i);
+        if (cJSON_IsString(key) && key->valuestring[0] != '\0') {
+            items[*count].key = buckets_strdup(key->valuestring);
+            items[*count].object = object;
+            (*count)++;
+        }
+    }
+}
+
+int buckets_cache_warmup_start(const char *path)
+{
+    if (!path) {
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+    pthread_once(&g_warmup.once, warmup_init_once);
+    buckets_startup_begin();
+
+    /* No snapshot is the normal first start, not an error */
+    void *data = NULL;
+    size_t size = 0;
+    if (access(path, R_OK) != 0 ||
+        buckets_atomic_read(path, &data, &size) != BUCKETS_OK || !data) {
+        buckets_debug("No cache snapshot at %s", path);
+        return BUCKETS_ERR_NOT_FOUND;
+    }
+    cJSON *root = cJSON_ParseWithLength((const char*)data, size);
+    buckets_free(data);
+
+    cJSON *version = cJSON_GetObjectItem(root, "version");
+    if (!root || !cJSON_IsNumber(version) || version->valueint != SNAPSHOT_VERSION) {
+        buckets_warn("Ignoring unreadable cache snapshot %s", path);
+        cJSON_Delete(root);
+        return BUCKETS_ERR_INVALID_ARG;
+    }
+
+    cJSON *registry = cJSON_GetObjectItem(root, "registry");
+    cJSON *objects = cJSON_GetObjectItem(root, "objects");
+    int total = cJSON_GetArraySize(registry) + cJSON_GetArraySize(objects);
+
+    pthread_mutex_lock(&g_warmup.lock);
+    if (g_warmup.workers) {
+        pthread_mutex_unlock(&g_warmup.lock);
+        cJSON_Delete(root);
+        buckets_warn("Cache warm-up already running");
+        return BUCKETS_ERR_EXISTS;
+    }
+
+    g_warmup.items = buckets_calloc(total > 0 ? total : 1, sizeof(warmup_item_t));
+    g_warmup.item_count = 0;
+    load_keys(registry, false, g_warmup.items, &g_warmup.item_count);
+    load_keys(objects, true, g_warmup.items, &g_warmup.item_count);
+    cJSON_Delete(root);
+
+    g_warmup.next = 0;
+    g_warmup.stop = false;
+    g_warmup.stats.warm_ms = 0;
+    g_warmup.stats.warm_keys = 0;
+    g_warmup.stats.warm_failed = 0;
+
+    u32 threads = g_warmup.threads < g_warmup.item_count ? g_warmup.threads : g_warmup.item_count;
+    g_warmup.workers = buckets_calloc(threads > 0 ? threads : 1, sizeof(pthread_t));
+    g_warmup.worker_count = 0;
+    g_warmup.active = threads > 0 ? threads : 1;
+
+    for (u32 i = 0; i < threads; i++) {
+        if (buckets_account_thread_create(&g_warmup.workers[g_warmup.worker_count],
+                                          warmup_worker, NULL) != 0) {
+            __atomic_sub_fetch(&g_warmup.active, 1, __ATOMIC_ACQ_REL);
+            continue;
+        }
+        g_warmup.worker_count++;
+    }
+    u32 started = g_warmup.worker_count;
+    if (started == 0) {
+        g_warmup.active = 1;
+    }
+    pthread_mutex_unlock(&g_warmup.lock);
+
+    buckets_info("Warming caches from %s: %u keys on %u threads",
+                 path, g_warmup.item_count, started);
+
+    /* Nothing to replay, or no thread could be started: do it here */
+    if (started == 0) {
+        warmup_worker(NULL);
+    }
+    return BUCKETS_OK;
+}
+
+void buckets_cache_warmup_wait(void)
+{
+    pthread_mutex_lock(&g_warmup.lock);
+    pthread_t *workers = g_warmup.workers;
+    u32 count = g_warmup.worker_count;
+    pthread_mutex_unlock(&g_warmup.lock);
+
+    if (!workers) {
+        return;
+    }
+    for (u32 i = 0; i < count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&g_warmup.lock);
+    for (u32 i = 0; i < g_warmup.item_count; i++) {
+        buckets_free(g_warmup.items[i].key);
+    }
+    buckets_free(g_warmup.items);
+    buckets_free(g_warmup.workers);
+    g_warmup.items = NULL;
+    g_warmup.item_count = 0;
+    g_warmup.workers = NULL;
+    g_warmup.worker_count = 0;
+    pthread_mutex_unlock(&g_warmup.lock);
+}
+
+void buckets_cache_warmup_stop(void)
+{
+    __atomic_store_n(&g_warmup.stop, true, __ATOMIC_RELAXED);
+    buckets_cache_warmup_wait();
+}
@@ -0,0 +1,564 @@
+/**
+ * Write Quorum and Heal Queue
+ *
+ * Quorum tracking for PUT fan-outs (chunk and xl.meta writes) so the
+ * request is acknowledged once enough copies are durable instead of after
+ * the slowest disk or peer. Writes that fail after a committed
+ * acknowledgement are retried in the background by the heal queue.
+ *
+ * Shards and xl.meta live at the unversioned object path, so a late write
+ * can clobber a newer PUT of the same key or bring back a deleted object.
+ * The heal queue checks that a committed copy still carries the version it
+ * repairs before every attempt, but a straggler already in flight cannot
+ * be recalled. Early acknowledgement is therefore opt-in: the default
+ * policy waits for every shard.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+/* Heal queue limits: entries hold a private copy of the shard */
+#define HEAL_QUEUE_MAX_ENTRIES 4096
+#define HEAL_QUEUE_MAX_BYTES   (256UL * 1024 * 1024)
+#define HEAL_MAX_ATTEMPTS      5
+#define HEAL_BASE_BACKOFF_MS   200
+
+/* ===================================================================
+ * Quorum Policy
+ * ===================================================================*/
+
+typedef enum {
+    QUORUM_POLICY_K,
+    QUORUM_POLICY_K_PLUS_1,
+    QUORUM_POLICY_ALL,
+    QUORUM_POLICY_FIXED
+} quorum_policy_t;
+
+static quorum_policy_t g_quorum_policy = QUORUM_POLICY_ALL;
+static u32 g_quorum_fixed = 0;
+static pthread_once_t g_quorum_once = PTHREAD_ONCE_INIT;
+
+static void quorum_policy_init(void)
+{
+    const char *env = getenv("BUCKETS_WRITE_QUORUM");
+    if (!env || env[0] == '\0') {
+        return;
+    }
+
+    if (strcmp(env, "k") == 0) {
+        g_quorum_policy = QUORUM_POLICY_K;
+    } else if (strcmp(env, "k+1") == 0) {
+        g_quorum_policy = QUORUM_POLICY_K_PLUS_1;
+    } else if (strcmp(env, "all") == 0) {
+        g_quorum_policy = QUORUM_POLICY_ALL;
+    } else {
+        char *end = NULL;
+        unsigned long n = strtoul(env, &end, 10);
+        if (end != env && *end == '\0' && n > 0) {
+            g_quorum_policy = QUORUM_POLICY_FIXED;
+            g_quorum_fixed = (u32)n;
+        } else {
+            buckets_warn("Ignoring invalid BUCKETS_WRITE_QUORUM=%s", env);
+            return;
+        }
+    }
+    buckets_info("Write quorum policy: %s", env);
+}
+
+u32 buckets_write_quorum(u32 data_shards, u32 parity_shards)
+{
+    pthread_once(&g_quorum_once, quorum_policy_init);
+
+    u32 total = data_shards + parity_shards;
+    u32 quorum;
+    switch (g_quorum_policy) {
+    case QUORUM_POLICY_K:
+        quorum = data_shards;
+        break;
+    case QUORUM_POLICY_FIXED:
+        quorum = g_quorum_fixed;
+        break;
+    case QUORUM_POLICY_K_PLUS_1:
+        quorum = data_shards + 1;
+        break;
+    case QUORUM_POLICY_ALL:
+    default:
+        quorum = total;
+        break;
+    }
+
+    /* Never below K (data would be unrecoverable) or above K+M */
+    if (quorum < data_shards) {
+        quorum = data_shards;
+    }
+    if (quorum > total) {
+        quorum = total;
+    }
+    return quorum;
+}
+
+/* ===================================================================
+ * Statistics
+ * ===================================================================*/
+
+static buckets_write_quorum_stats_t g_quorum_stats;
+
+#define STAT_ADD(field, n) __atomic_fetch_add(&g_quorum_stats.field, (n), __ATOMIC_RELAXED)
+
+void buckets_write_quorum_get_stats(buckets_write_quorum_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    stats->writes = __atomic_load_n(&g_quorum_stats.writes, __ATOMIC_RELAXED);
+    stats->early_acks = __atomic_load_n(&g_quorum_stats.early_acks, __ATOMIC_RELAXED);
+    stats->quorum_failures = __atomic_load_n(&g_quorum_stats.quorum_failures, __ATOMIC_RELAXED);
+    stats->stragglers = __atomic_load_n(&g_quorum_stats.stragglers, __ATOMIC_RELAXED);
+    stats->straggler_failures = __atomic_load_n(&g_quorum_stats.straggler_failures, __ATOMIC_RELAXED);
+    stats->heal_queued = __atomic_load_n(&g_quorum_stats.heal_queued, __ATOMIC_RELAXED);
+    stats->heal_repaired = __atomic_load_n(&g_quorum_stats.heal_repaired, __ATOMIC_RELAXED);
+    stats->heal_failed = __atomic_load_n(&g_quorum_stats.heal_failed, __ATOMIC_RELAXED);
+    stats->heal_superseded = __atomic_load_n(&g_quorum_stats.heal_superseded, __ATOMIC_RELAXED);
+    stats->heal_dropped = __atomic_load_n(&g_quorum_stats.heal_dropped, __ATOMIC_RELAXED);
+    stats->heal_pending = __atomic_load_n(&g_quorum_stats.heal_pending, __ATOMIC_RELAXED);
+}
+
+/* ===================================================================
+ * Quorum Tracker
+ * ===================================================================*/
+
+struct buckets_quorum_tracker {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    u32 total;
+    u32 quorum;
+    u32 ok;
+    u32 failed;
+    u32 refs;                       /* Workers + waiter */
+    bool acked;                     /* Waiter has returned */
+    bool committed;                 /* Quorum was reached at acknowledgement */
+    buckets_account_t account;      /* Work finished before the acknowledgement */
+    void (*finish)(void *owner, bool committed);
+    void *owner;
+};
+
+static bool tracker_decided(const buckets_quorum_tracker_t *t)
+{
+    return t->ok >= t->quorum ||
+           t->failed > t->total - t->quorum ||
+           t->ok + t->failed >= t->total;
+}
+
+static void tracker_release(buckets_quorum_tracker_t *t)
+{
+    /* Caller holds t->lock */
+    bool last = (--t->refs == 0);
+    pthread_mutex_unlock(&t->lock);
+    if (!last) {
+        return;
+    }
+
+    if (t->finish) {
+        t->finish(t->owner, t->committed);
+    }
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->cond);
+    buckets_free(t);
+}
+
+buckets_quorum_tracker_t* buckets_quorum_tracker_create(u32 total, u32 quorum, u32 workers,
+                                                        void (*finish)(void *owner, bool committed),
+                                                        void *owner)
+{
+    buckets_quorum_tracker_t *t = buckets_calloc(1, sizeof(*t));
+    if (!t) {
+        return NULL;
+    }
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+    t->total = total;
+    t->quorum = quorum > total ? total : quorum;
+    t->refs = workers + 1;
+    t->finish = finish;
+    t->owner = owner;
+    return t;
+}
+
+void buckets_quorum_tracker_done(buckets_quorum_tracker_t *t, u32 ok_shards,
+                                 u32 failed_shards, const buckets_account_t *account)
+{
+    pthread_mutex_lock(&t->lock);
+    t->ok += ok_shards;
+    t->failed += failed_shards;
+
+    if (t->acked) {
+        /* Straggler: the request has been answered and its account is gone */
+        STAT_ADD(stragglers, ok_shards + failed_shards);
+        STAT_ADD(straggler_failures, failed_shards);
+    } else {
+        buckets_account_add(&t->account, account);
+        if (tracker_decided(t)) {
+            pthread_cond_signal(&t->cond);
+        }
+    }
+
+    tracker_release(t);
+}
+
+int buckets_quorum_tracker_wait(buckets_quorum_tracker_t *t)
+{
+    pthread_mutex_lock(&t->lock);
+    while (!tracker_decided(t)) {
+        pthread_cond_wait(&t->cond, &t->lock);
+    }
+
+    t->acked = true;
+    t->committed = (t->ok >= t->quorum);
+    u32 outstanding = t->total - t->ok - t->failed;
+
+    STAT_ADD(writes, 1);
+    if (!t->committed) {
+        STAT_ADD(quorum_failures, 1);
+    } else if (outstanding > 0) {
+        STAT_ADD(early_acks, 1);
+    }
+    buckets_account_add(buckets_account_current(), &t->account);
+
+    int result = t->committed ? 0 : -1;
+    if (t->committed && outstanding > 0) {
+        buckets_debug("[QUORUM] Acknowledged at %u/%u shards (%u failed, %u outstanding)",
+                      t->ok, t->total, t->failed, outstanding);
+    }
+
+    tracker_release(t);
+    return result;
+}
+
+/* ===================================================================
+ * Heal Queue
+ * ===================================================================*/
+
+typedef struct heal_entry {
+    bool is_meta;
+    char *bucket;
+    char *object;
+    char *object_path;
+    char *disk_path;
+    char *node_endpoint;            /* NULL for a local disk */
+    u32 chunk_index;
+    void *data;                     /* Shard data */
+    size_t size;
+    char *meta_json;                /* Serialized xl.meta */
+    char mod_time[32];              /* Version being repaired (xl.meta modTime) */
+    char *etag;                     /* ... and its ETag (may be NULL) */
+    char *ref_disk_path;            /* Disk with a committed copy (NULL: the target) */
+    char *ref_node_endpoint;        /* Its remote node, NULL for a local disk */
+    u32 attempts;
+    u64 not_before_ms;
+    struct heal_entry *next;
+} heal_entry_t;
+
+typedef struct {
+    heal_entry_t *head;
+    heal_entry_t *tail;
+    size_t count;
+    size_t bytes;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} heal_queue_t;
+
+static heal_queue_t g_heal_queue = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+static pthread_once_t g_heal_once = PTHREAD_ONCE_INIT;
+
+static u64 heal_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+static size_t heal_entry_bytes(const heal_entry_t *e)
+{
+    return e->size + (e->meta_json ? strlen(e->meta_json) : 0);
+}
+
+static void heal_entry_free(heal_entry_t *e)
+{
+    buckets_free(e->bucket);
+    buckets_free(e->object);
+    buckets_free(e->object_path);
+    buckets_free(e->disk_path);
+    buckets_free(e->node_endpoint);
+    buckets_free(e->data);
+    buckets_free(e->meta_json);
+    buckets_free(e->etag);
+    buckets_free(e->ref_disk_path);
+    buckets_free(e->ref_node_endpoint);
+    buckets_free(e);
+}
+
+extern int buckets_distributed_read_xlmeta(const char *peer_endpoint,
+                                           const char *bucket, const char *object,
+                                           const char *disk_path,
+                                           buckets_xl_meta_t *meta);
+
+typedef enum {
+    HEAL_CURRENT,                   /* Committed copy matches: write */
+    HEAL_UNKNOWN,                   /* No committed copy visible yet: retry */
+    HEAL_SUPERSEDED                 /* A newer write or a delete won: drop */
+} heal_check_t;
+
+/**
+ * Check that the version being repaired is still the object's version
+ *
+ * Reads xl.meta from the reference disk (a copy that committed). Without
+ * a reference, the target itself is read and only a newer version there
+ * counts as superseded.
+ */
+static heal_check_t heal_entry_check(const heal_entry_t *e)
+{
+    const char *disk = e->ref_disk_path ? e->ref_disk_path : e->disk_path;
+    const char *node = e->ref_disk_path ? e->ref_node_endpoint : e->node_endpoint;
+
+    buckets_xl_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    int ret = node ? buckets_distributed_read_xlmeta(node, e->bucket, e->object, disk, &meta)
+                   : buckets_read_xl_meta(disk, e->object_path, &meta);
+    if (ret != 0) {
+        /* Shard heals may run before the xl.meta write lands; a reference
+         * that stays empty was deleted and the entry ages out */
+        return e->ref_disk_path ? HEAL_UNKNOWN : HEAL_CURRENT;
+    }
+
+    heal_check_t result;
+    bool same_etag = (!e->etag && !meta.meta.etag) ||
+                     (e->etag && meta.meta.etag && strcmp(e->etag, meta.meta.etag) == 0);
+    int cmp = strcmp(meta.stat.modTime, e->mod_time);
+    if (cmp == 0 && same_etag) {
+        result = HEAL_CURRENT;
+    } else if (e->ref_disk_path || cmp >= 0) {
+        result = HEAL_SUPERSEDED;
+    } else {
+        result = HEAL_CURRENT;      /* Target still holds an older version */
+    }
+    buckets_xl_meta_free(&meta);
+    return result;
+}
+
+static int heal_entry_write(heal_entry_t *e)
+{
+    if (!e->is_meta) {
+        if (e->node_endpoint) {
+            return buckets_binary_write_chunk(e->node_endpoint, e->bucket, e->object,
+                                              e->chunk_index, e->data, e->size, e->disk_path);
+        }
+        return buckets_write_chunk(e->disk_path, e->object_path, e->chunk_index,
+                                   e->data, e->size);
+    }
+
+    buckets_xl_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    if (buckets_xl_meta_from_json(e->meta_json, &meta) != 0) {
+        return -1;
+    }
+
+    int ret;
+    if (e->node_endpoint) {
+        extern int buckets_distributed_write_xlmeta(const char *peer_endpoint,
+                                                    const char *bucket, const char *object,
+                                                    const char *disk_path,
+                                                    const buckets_xl_meta_t *meta);
+        ret = buckets_distributed_write_xlmeta(e->node_endpoint, e->bucket, e->object,
+                                               e->disk_path, &meta);
+    } else {
+        ret = buckets_write_xl_meta(e->disk_path, e->object_path, &meta);
+    }
+    buckets_xl_meta_free(&meta);
+    return ret;
+}
+
+static void heal_push_locked(heal_entry_t *e)
+{
+    e->next = NULL;
+    if (g_heal_queue.tail) {
+        g_heal_queue.tail->next = e;
+    } else {
+        g_heal_queue.head = e;
+    }
+    g_heal_queue.tail = e;
+    g_heal_queue.count++;
+    g_heal_queue.bytes += heal_entry_bytes(e);
+    STAT_ADD(heal_pending, 1);
+    pthread_cond_signal(&g_heal_queue.cond);
+}
+
+static void* heal_worker(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&g_heal_queue.lock);
+    while (1) {
+        while (!g_heal_queue.head) {
+            pthread_cond_wait(&g_heal_queue.cond, &g_heal_queue.lock);
+        }
+
+        /* Entries are FIFO with the same backoff schedule; wait for the head */
+        heal_entry_t *e = g_heal_queue.head;
+        u64 now = heal_now_ms();
+        if (e->not_before_ms > now) {
+            struct timespec until = {
+                .tv_sec = (time_t)(e->not_before_ms / 1000),
+                .tv_nsec = (long)(e->not_before_ms % 1000) * 1000000L
+            };
+            pthread_cond_timedwait(&g_heal_queue.cond, &g_heal_queue.lock, &until);
+            continue;
+        }
+
+        g_heal_queue.head = e->next;
+        if (!g_heal_queue.head) {
+            g_heal_queue.tail = NULL;
+        }
+        g_heal_queue.count--;
+        g_heal_queue.bytes -= heal_entry_bytes(e);
+        __atomic_fetch_sub(&g_quorum_stats.heal_pending, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&g_heal_queue.lock);
+
+        heal_check_t check = heal_entry_check(e);
+        int ret = check == HEAL_CURRENT ? heal_entry_write(e) : -1;
+        e->attempts++;
+
+        pthread_mutex_lock(&g_heal_queue.lock);
+        if (check == HEAL_SUPERSEDED) {
+            STAT_ADD(heal_superseded, 1);
+            buckets_info("[HEAL] Dropping %s %s/%s on %s: version %s was superseded",
+                         e->is_meta ? "xl.meta" : "shard", e->bucket, e->object,
+                         e->disk_path, e->mod_time);
+            heal_entry_free(e);
+        } else if (ret == 0) {
+            STAT_ADD(heal_repaired, 1);
+            buckets_info("[HEAL] Repaired %s %s/%s on %s%s%s",
+                         e->is_meta ? "xl.meta" : "shard", e->bucket, e->object,
+                         e->node_endpoint ? e->node_endpoint : "",
+                         e->node_endpoint ? ":" : "", e->disk_path);
+            heal_entry_free(e);
+        } else if (e->attempts >= HEAL_MAX_ATTEMPTS) {
+            STAT_ADD(heal_failed, 1);
+            buckets_error("[HEAL] Giving up on %s %s/%s on %s after %u attempts "
+                          "(left for scrub)",
+                          e->is_meta ? "xl.meta" : "shard", e->bucket, e->object,
+                          e->disk_path, e->attempts);
+            heal_entry_free(e);
+        } else {
+            e->not_before_ms = heal_now_ms() + ((u64)HEAL_BASE_BACKOFF_MS << e->attempts);
+            heal_push_locked(e);
+        }
+    }
+
+    return NULL;
+}
+
+static void heal_queue_init(void)
+{
+    /* Not charged to any request: plain pthread_create */
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, heal_worker, NULL) != 0) {
+        buckets_error("Failed to start heal queue worker");
+        return;
+    }
+    pthread_detach(thread);
+}
+
+static int heal_enqueue(heal_entry_t *e)
+{
+    pthread_once(&g_heal_once, heal_queue_init);
+
+    pthread_mutex_lock(&g_heal_queue.lock);
+    if (g_heal_queue.count >= HEAL_QUEUE_MAX_ENTRIES ||
+        g_heal_queue.bytes + heal_entry_bytes(e) > HEAL_QUEUE_MAX_BYTES) {
+        pthread_mutex_unlock(&g_heal_queue.lock);
+        STAT_ADD(heal_dropped, 1);
+        buckets_warn("[HEAL] Queue full (%zu entries), leaving %s/%s on %s for scrub",
+                     g_heal_queue.count, e->bucket, e->object, e->disk_path);
+        heal_entry_free(e);
+        return -1;
+    }
+
+    e->not_before_ms = heal_now_ms() + HEAL_BASE_BACKOFF_MS;
+    heal_push_locked(e);
+    pthread_mutex_unlock(&g_heal_queue.lock);
+
+    STAT_ADD(heal_queued, 1);
+    return 0;
+}
+
+static heal_entry_t* heal_entry_new(const char *bucket, const char *object,
+                                    const char *object_path, const char *disk_path,
+                                    const char *node_endpoint, const buckets_xl_meta_t *meta,
+                                    const buckets_heal_ref_t *ref)
+{
+    heal_entry_t *e = buckets_calloc(1, sizeof(*e));
+    e->bucket = buckets_strdup(bucket);
+    e->object = buckets_strdup(object);
+    e->object_path = buckets_strdup(object_path);
+    e->disk_path = buckets_strdup(disk_path);
+    e->node_endpoint = node_endpoint ? buckets_strdup(node_endpoint) : NULL;
+    snprintf(e->mod_time, sizeof(e->mod_time), "%s", meta->stat.modTime);
+    e->etag = meta->meta.etag ? buckets_strdup(meta->meta.etag) : NULL;
+    if (ref && ref->disk_path) {
+        e->ref_disk_path = buckets_strdup(ref->disk_path);
+        e->ref_node_endpoint = ref->node_endpoint ? buckets_strdup(ref->node_endpoint) : NULL;
+    }
+    return e;
+}
+
+int buckets_heal_queue_shard(const char *bucket, const char *object, const char *object_path,
+                             u32 chunk_index, const char *disk_path, const char *node_endpoint,
+                             const void *data, size_t size, const buckets_xl_meta_t *meta,
+                             const buckets_heal_ref_t *ref)
+{
+    if (!bucket || !object || !object_path || !disk_path || !data || !meta) {
+        return -1;
+    }
+
+    heal_entry_t *e = heal_entry_new(bucket, object, object_path, disk_path, node_endpoint,
+                                     meta, ref);
+    e->chunk_index = chunk_index;
+    e->data = buckets_malloc(size);
+    memcpy(e->data, data, size);
+    e->size = size;
+
+    buckets_warn("[HEAL] Queued shard %u of %s/%s for %s", chunk_index, bucket, object, disk_path);
+    return heal_enqueue(e);
+}
+
+int buckets_heal_queue_xl_meta(const char *bucket, const char *object, const char *object_path,
+                               const char *disk_path, const char *node_endpoint,
+                               const buckets_xl_meta_t *meta, const buckets_heal_ref_t *ref)
+{
+    if (!bucket || !object || !object_path || !disk_path || !meta) {
+        return -1;
+    }
+
+    char *json = buckets_xl_meta_to_json(meta);
+    if (!json) {
+        return -1;
+    }
+
+    heal_entry_t *e = heal_entry_new(bucket, object, object_path, disk_path, node_endpoint,
+                                     meta, ref);
+    e->is_meta = true;
+    e->meta_json = json;
+
+    buckets_warn("[HEAL] Queued xl.meta of %s/%s for %s", bucket, object, disk_path);
+    return heal_enqueue(e);
+}
@@ -368,3 +368,40 @@ Test(throttle, set_rate_zero)
     cr_assert_eq(ret, BUCKETS_OK, "Should succeed");
     cr_assert_lt(elapsed_us, 10000, "Should be instant when disabled (<10ms)");
 }
+
+/**
+ * Test 16: Non-blocking consume
+ */
+Test(throttle, try_consume)
+{
+    g_ctx.throttle = buckets_throttle_create(1, 1);   // 1 MB/s, 1 MB burst
+    
+    cr_assert(buckets_throttle_try_consume(g_ctx.throttle, 512 * 1024), "Should fit in burst");
+    cr_assert(buckets_throttle_try_consume(g_ctx.throttle, 512 * 1024), "Should fit in burst");
+    cr_assert(!buckets_throttle_try_consume(g_ctx.throttle, 512 * 1024),
+              "Should fail once the bucket is empty");
+    
+    // Failure takes nothing: a small request still fits after a short refill
+    usleep(20000);
+    cr_assert(buckets_throttle_try_consume(g_ctx.throttle, 4096), "Should fit after refill");
+}
+
+/**
+ * Test 17: Charge into debt and refund
+ */
+Test(throttle, charge_debt)
+{
+    g_ctx.throttle = buckets_throttle_create(1, 1);   // 1 MB/s, 1 MB burst
+    
+    cr_assert_eq(buckets_throttle_charge(g_ctx.throttle, 1024 * 1024), 0, "Burst is free");
+    
+    i64 debt_us = buckets_throttle_charge(g_ctx.throttle, 256 * 1024);
+    cr_assert_geq(debt_us, 200000, "Should owe ~250ms");
+    cr_assert_leq(debt_us, 250000, "Should owe ~250ms");
+    cr_assert_leq(buckets_throttle_charge(g_ctx.throttle, 0), debt_us, "Query charges nothing");
+    
+    // Refunds pay the debt back, but never past a full bucket
+    cr_assert_eq(buckets_throttle_charge(g_ctx.throttle, -4LL * 1024 * 1024), 0, "Refund clears debt");
+    cr_assert(buckets_throttle_try_consume(g_ctx.throttle, 1024 * 1024), "Bucket full again");
+    cr_assert(!buckets_throttle_try_consume(g_ctx.throttle, 1024 * 1024), "But not beyond burst");
+}
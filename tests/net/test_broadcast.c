@@ -151,3 +151,52 @@ Test(broadcast, default_timeout)
     /* Cleanup */
     buckets_broadcast_result_free(result);
 }
+
+Test(broadcast, failures_keep_peer_order)
+{
+    /* Unreachable peers all fail, reported in grid order */
+    buckets_peer_grid_add_peer(grid, "http://127.0.0.1:19104");
+    buckets_peer_grid_add_peer(grid, "http://127.0.0.1:19105");
+    buckets_peer_grid_add_peer(grid, "http://127.0.0.1:19106");
+    
+    buckets_broadcast_result_t *result = NULL;
+    int ret = buckets_rpc_broadcast(ctx, grid, "test.method", NULL, &result, 1000);
+    
+    cr_assert_eq(ret, BUCKETS_OK, "Broadcast should succeed");
+    cr_assert_eq(result->total, 3, "Total should be 3");
+    cr_assert_eq(result->failed, 3, "All peers should fail");
+    
+    int count = 0;
+    buckets_peer_t **peers = buckets_peer_grid_get_peers(grid, &count);
+    for (int i = 0; i < count; i++) {
+        cr_assert_str_eq(result->failed_peers[i], peers[i]->endpoint);
+    }
+    
+    /* Cleanup */
+    buckets_free(peers);
+    buckets_broadcast_result_free(result);
+}
+
+/* ===================================================================
+ * Fan-out Tests
+ * ===================================================================*/
+
+Test(broadcast, fanout_skips_null_endpoints)
+{
+    const char *endpoints[] = {
+        "http://127.0.0.1:19107", NULL, "http://127.0.0.1:19108"
+    };
+    buckets_rpc_response_t *responses[3];
+    memset(responses, 0xff, sizeof(responses));
+    
+    int ret = buckets_rpc_fanout(ctx, endpoints, 3, "test.method", NULL, responses, 1000);
+    
+    cr_assert_eq(ret, BUCKETS_OK, "Fan-out should succeed");
+    for (int i = 0; i < 3; i++) {
+        cr_assert_null(responses[i], "Failed call %d should have no response", i);
+    }
+    
+    /* Nothing to call */
+    cr_assert_eq(buckets_rpc_fanout(ctx, NULL, 0, "test.method", NULL, NULL, 1000), BUCKETS_OK);
+    cr_assert_neq(buckets_rpc_fanout(ctx, endpoints, 3, NULL, NULL, responses, 1000), BUCKETS_OK);
+}
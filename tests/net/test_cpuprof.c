@@ -0,0 +1,243 @@
+/**
+ * CPU Profiler Tests
+ *
+ * Unit tests for the SIGPROF sampling profiler and the
+ * /_admin/profile/cpu endpoint that serves it.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+#include "buckets_cpuprof.h"
+
+extern void buckets_admin_http_handler(buckets_http_request_t *req,
+                                       buckets_http_response_t *res);
+
+void setup(void) {
+    buckets_init();
+}
+
+void teardown(void) {
+    buckets_cleanup();
+}
+
+TestSuite(cpuprof, .init = setup, .fini = teardown);
+TestSuite(admin_profile, .init = setup, .fini = teardown);
+
+/* Keeps a core busy so ITIMER_PROF has CPU time to fire on */
+static volatile bool g_spin_stop;
+static volatile u64 g_spin_count;
+
+static void* spinner(void *arg) {
+    (void)arg;
+    while (!g_spin_stop) {
+        g_spin_count++;
+    }
+    return NULL;
+}
+
+static void start_spinner(pthread_t *thread) {
+    g_spin_stop = false;
+    pthread_create(thread, NULL, spinner, NULL);
+}
+
+static void stop_spinner(pthread_t thread) {
+    g_spin_stop = true;
+    pthread_join(thread, NULL);
+}
+
+typedef struct {
+    int ret;
+    buckets_cpuprof_result_t result;
+} collector_t;
+
+static void* collector(void *arg) {
+    collector_t *c = (collector_t *)arg;
+    c->ret = buckets_cpuprof_collect(300, 0, &c->result);
+    return NULL;
+}
+
+/* ===================================================================
+ * Profiler Tests
+ * ===================================================================*/
+
+Test(cpuprof, rejects_invalid_arguments) {
+    buckets_cpuprof_result_t result;
+    cr_assert_eq(buckets_cpuprof_collect(0, 0, &result), BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_cpuprof_collect(100, BUCKETS_CPUPROF_MAX_HZ + 1, &result),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_cpuprof_collect(BUCKETS_CPUPROF_MAX_SECONDS * 1000 + 1, 0, &result),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_cpuprof_collect(100, 0, NULL), BUCKETS_ERR_INVALID_ARG);
+}
+
+Test(cpuprof, samples_a_busy_thread_as_folded_stacks) {
+    pthread_t thread;
+    start_spinner(&thread);
+
+    buckets_cpuprof_result_t result;
+    cr_assert_eq(buckets_cpuprof_collect(300, 500, &result), BUCKETS_OK);
+    stop_spinner(thread);
+
+    cr_assert_gt(result.samples, 0);
+    cr_assert_eq(result.hz, 500);
+    cr_assert_eq(result.duration_ms, 300);
+    cr_assert_not_null(result.folded);
+    cr_assert_eq(strlen(result.folded), result.folded_len);
+
+    /* Every line is "frame;frame;... count" */
+    u64 total = 0;
+    char *save = NULL;
+    for (char *line = strtok_r(result.folded, "\n", &save); line;
+         line = strtok_r(NULL, "\n", &save)) {
+        char *space = strrchr(line, ' ');
+        cr_assert_not_null(space, "no count on line: %s", line);
+        char *end = NULL;
+        unsigned long count = strtoul(space + 1, &end, 10);
+        cr_assert_eq(*end, '\0');
+        cr_assert_gt(count, 0);
+        total += count;
+    }
+    cr_assert_eq(total, result.samples);
+
+    buckets_cpuprof_result_free(&result);
+    cr_assert_null(result.folded);
+    cr_assert_not(buckets_cpuprof_running());
+}
+
+Test(cpuprof, one_profile_at_a_time) {
+    collector_t first = {0};
+    pthread_t thread;
+    pthread_create(&thread, NULL, collector, &first);
+    while (!buckets_cpuprof_running()) {
+        sched_yield();
+    }
+
+    buckets_cpuprof_result_t result;
+    cr_assert_eq(buckets_cpuprof_collect(100, 0, &result), BUCKETS_ERR_LIMIT);
+
+    pthread_join(thread, NULL);
+    cr_assert_eq(first.ret, BUCKETS_OK);
+    buckets_cpuprof_result_free(&first.result);
+
+    /* And the next one is allowed */
+    cr_assert_eq(buckets_cpuprof_collect(50, 0, &result), BUCKETS_OK);
+    buckets_cpuprof_result_free(&result);
+}
+
+Test(cpuprof, late_sigprof_after_profile_is_harmless) {
+    pthread_t thread;
+    start_spinner(&thread);
+
+    buckets_cpuprof_result_t result;
+    cr_assert_eq(buckets_cpuprof_collect(100, BUCKETS_CPUPROF_MAX_HZ, &result), BUCKETS_OK);
+    buckets_cpuprof_result_free(&result);
+
+    /* A SIGPROF still pending when the timer is disarmed must neither
+     * terminate the process nor touch the freed sample buffer */
+    for (int i = 0; i < 100; i++) {
+        pthread_kill(thread, SIGPROF);
+        raise(SIGPROF);
+    }
+    stop_spinner(thread);
+
+    cr_assert_not(buckets_cpuprof_running());
+}
+
+/* ===================================================================
+ * Admin Endpoint Tests
+ * ===================================================================*/
+
+static void admin_get(const char *uri, buckets_http_response_t *res) {
+    buckets_http_request_t req;
+    memset(&req, 0, sizeof(req));
+    memset(res, 0, sizeof(*res));
+    req.method = "GET";
+    req.uri = uri;
+    const char *query = strchr(uri, '?');
+    req.query_string = query ? query + 1 : NULL;
+    buckets_admin_http_handler(&req, res);
+}
+
+static void response_free(buckets_http_response_t *res) {
+    buckets_free(res->body);
+    buckets_free(res->headers);
+}
+
+Test(admin_profile, disabled_by_default) {
+    unsetenv("BUCKETS_CPUPROF");
+
+    buckets_http_response_t res;
+    admin_get("/_admin/profile/cpu?seconds=1", &res);
+    cr_assert_eq(res.status_code, 404);
+    cr_assert_not(buckets_cpuprof_running());
+    response_free(&res);
+}
+
+Test(admin_profile, rejects_out_of_range_parameters) {
+    setenv("BUCKETS_CPUPROF", "1", 1);
+
+    buckets_http_response_t res;
+    admin_get("/_admin/profile/cpu?seconds=0", &res);
+    cr_assert_eq(res.status_code, 400);
+    response_free(&res);
+
+    admin_get("/_admin/profile/cpu?seconds=1&hz=5000", &res);
+    cr_assert_eq(res.status_code, 400);
+    response_free(&res);
+
+    unsetenv("BUCKETS_CPUPROF");
+}
+
+Test(admin_profile, returns_folded_stacks) {
+    setenv("BUCKETS_CPUPROF", "1", 1);
+    pthread_t thread;
+    start_spinner(&thread);
+
+    buckets_http_response_t res;
+    admin_get("/_admin/profile/cpu?seconds=1&hz=200", &res);
+    stop_spinner(thread);
+
+    cr_assert_eq(res.status_code, 200);
+    cr_assert_not_null(res.headers);
+    cr_assert_not_null(strstr(res.headers, "Content-Type: text/plain"));
+    cr_assert_not_null(strstr(res.headers, "X-Profile-Hz: 200"));
+    cr_assert_not_null(strstr(res.headers, "X-Profile-Samples: "));
+    cr_assert_not_null(res.body);
+    cr_assert_gt(res.body_len, 0);
+    response_free(&res);
+
+    unsetenv("BUCKETS_CPUPROF");
+}
+
+Test(admin_profile, busy_profiler_returns_conflict) {
+    setenv("BUCKETS_CPUPROF", "1", 1);
+
+    collector_t first = {0};
+    pthread_t thread;
+    pthread_create(&thread, NULL, collector, &first);
+    while (!buckets_cpuprof_running()) {
+        sched_yield();
+    }
+
+    buckets_http_response_t res;
+    admin_get("/_admin/profile/cpu?seconds=1", &res);
+    cr_assert_eq(res.status_code, 409);
+    response_free(&res);
+
+    pthread_join(thread, NULL);
+    buckets_cpuprof_result_free(&first.result);
+    unsetenv("BUCKETS_CPUPROF");
+}
+
+Test(admin_profile, unknown_endpoint_is_not_found) {
+    buckets_http_response_t res;
+    admin_get("/_admin/nothing", &res);
+    cr_assert_eq(res.status_code, 404);
+    response_free(&res);
+}
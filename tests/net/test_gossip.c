@@ -0,0 +1,428 @@
+/**
+ * Gossip Membership Tests
+ *
+ * Messages are delivered with buckets_rpc_dispatch and probes go to a
+ * closed port, so no server is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <criterion/criterion.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+#include "cJSON.h"
+
+#define DEAD_ENDPOINT "http://127.0.0.1:1"
+
+/* ===================================================================
+ * Test Fixtures
+ * ===================================================================*/
+
+static buckets_conn_pool_t *pool = NULL;
+static buckets_rpc_context_t *ctx = NULL;
+static buckets_gossip_t *gossip = NULL;
+static buckets_gossip_shared_t *shared = NULL;
+
+static int invalidations = 0;
+static char last_invalidated[128];
+static i64 last_generation = 0;
+static int deaths = 0;
+
+static void on_member(const char *node_id, const char *endpoint,
+                      buckets_member_state_t state, void *user_data)
+{
+    (void)node_id;
+    (void)endpoint;
+    (void)user_data;
+    if (state == BUCKETS_MEMBER_DEAD) {
+        deaths++;
+    }
+}
+
+static void on_topology(i64 generation, void *user_data)
+{
+    (void)user_data;
+    last_generation = generation;
+}
+
+static void on_invalidate(const char *bucket, const char *object, void *user_data)
+{
+    (void)user_data;
+    invalidations++;
+    snprintf(last_invalidated, sizeof(last_invalidated), "%s/%s", bucket, object);
+}
+
+void setup_gossip(void)
+{
+    buckets_init();
+    buckets_set_log_level(BUCKETS_LOG_ERROR);
+    pool = buckets_conn_pool_create(10);
+    ctx = buckets_rpc_context_create(pool);
+
+    buckets_gossip_config_t config;
+    buckets_gossip_config_default(&config);
+    config.period_ms = 50;
+    config.probe_timeout_ms = 50;
+    gossip = buckets_gossip_create(ctx, "node-a", "http://127.0.0.1:2", &config);
+
+    buckets_gossip_callbacks_t callbacks = {
+        .member_changed = on_member,
+        .topology_generation = on_topology,
+        .invalidate = on_invalidate
+    };
+    buckets_gossip_set_callbacks(gossip, &callbacks);
+
+    invalidations = 0;
+    last_invalidated[0] = '\0';
+    last_generation = 0;
+    deaths = 0;
+}
+
+void teardown_gossip(void)
+{
+    buckets_gossip_free(gossip);
+    buckets_gossip_shared_destroy(shared);
+    shared = NULL;
+    buckets_rpc_context_free(ctx);
+    buckets_conn_pool_free(pool);
+    buckets_cleanup();
+}
+
+TestSuite(gossip, .init = setup_gossip, .fini = teardown_gossip);
+
+static cJSON* ping_from(const char *node_id, u64 incarnation)
+{
+    cJSON *params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "from", node_id);
+    cJSON_AddStringToObject(params, "endpoint", DEAD_ENDPOINT);
+    cJSON_AddNumberToObject(params, "inc", (double)incarnation);
+    cJSON_AddItemToObject(params, "updates", cJSON_CreateArray());
+    return params;
+}
+
+static cJSON* add_update(cJSON *params, const char *type)
+{
+    cJSON *update = cJSON_CreateObject();
+    cJSON_AddStringToObject(update, "t", type);
+    cJSON_AddItemToArray(cJSON_GetObjectItem(params, "updates"), update);
+    return update;
+}
+
+/* Deliver params as gossip.ping to one process; returns the ack (caller
+ * frees response) */
+static buckets_rpc_response_t* deliver_to(buckets_rpc_context_t *to, cJSON *params)
+{
+    buckets_rpc_request_t request = {0};
+    strcpy(request.method, "gossip.ping");
+    request.params = params;
+
+    buckets_rpc_response_t *response = NULL;
+    cr_assert_eq(buckets_rpc_dispatch(to, &request, &response), BUCKETS_OK);
+    cr_assert_eq(response->error_code, 0);
+    cr_assert_not_null(response->result);
+    cJSON_Delete(params);
+    return response;
+}
+
+static buckets_rpc_response_t* deliver(cJSON *params)
+{
+    return deliver_to(ctx, params);
+}
+
+/* Find a piggybacked update of the given type (and node, for members) */
+static cJSON* find_update(buckets_rpc_response_t *response, const char *type, const char *node)
+{
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(response->result, "updates")) {
+        cJSON *t = cJSON_GetObjectItem(item, "t");
+        cJSON *n = cJSON_GetObjectItem(item, "n");
+        if (strcmp(t->valuestring, type) == 0 &&
+            (!node || (cJSON_IsString(n) && strcmp(n->valuestring, node) == 0))) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static buckets_member_state_t member_state(const char *node_id)
+{
+    buckets_gossip_member_t *members = NULL;
+    int count = 0;
+    cr_assert_eq(buckets_gossip_get_members(gossip, &members, &count), BUCKETS_OK);
+    int state = -1;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(members[i].node_id, node_id) == 0) {
+            state = members[i].state;
+        }
+    }
+    buckets_free(members);
+    cr_assert_neq(state, -1, "member %s not found", node_id);
+    return (buckets_member_state_t)state;
+}
+
+/* ===================================================================
+ * Phi Detector Tests
+ * ===================================================================*/
+
+Test(gossip, phi_grows_with_silence)
+{
+    buckets_phi_detector_t detector = {0};
+    cr_assert_float_eq(buckets_phi_value(&detector, 5000), 0.0, 1e-9);
+
+    for (u64 t = 1000; t <= 11000; t += 1000) {
+        buckets_phi_heartbeat(&detector, t);
+    }
+
+    double on_time = buckets_phi_value(&detector, 12000);
+    double late = buckets_phi_value(&detector, 12500);
+    double gone = buckets_phi_value(&detector, 14000);
+    cr_assert_lt(on_time, 1.0, "phi at the mean interval is %f", on_time);
+    cr_assert_gt(late, on_time);
+    cr_assert_gt(gone, 8.0, "phi after three missed intervals is %f", gone);
+}
+
+/* ===================================================================
+ * Message Tests
+ * ===================================================================*/
+
+Test(gossip, ping_merges_sender_and_updates)
+{
+    cJSON *params = ping_from("node-b", 5);
+    cJSON *inv = add_update(params, "x");
+    cJSON_AddStringToObject(inv, "id", "00000000000000ab");
+    cJSON_AddStringToObject(inv, "b", "bucket");
+    cJSON_AddStringToObject(inv, "o", "key");
+    cJSON *gen = add_update(params, "g");
+    cJSON_AddNumberToObject(gen, "g", 7);
+
+    buckets_rpc_response_t *response = deliver(params);
+    cr_assert_str_eq(cJSON_GetObjectItem(response->result, "from")->valuestring, "node-a");
+    cr_assert_not_null(find_update(response, "m", "node-a"), "ack should announce this node");
+    buckets_rpc_response_free(response);
+
+    cr_assert_eq(member_state("node-b"), BUCKETS_MEMBER_ALIVE);
+    cr_assert_eq(invalidations, 1);
+    cr_assert_str_eq(last_invalidated, "bucket/key");
+
+    /* Topology callbacks run on the protocol thread */
+    cr_assert_eq(last_generation, 0);
+    buckets_gossip_tick(gossip);
+    cr_assert_eq(last_generation, 7);
+
+    /* The same invalidation is not applied twice */
+    params = ping_from("node-b", 5);
+    inv = add_update(params, "x");
+    cJSON_AddStringToObject(inv, "id", "00000000000000ab");
+    cJSON_AddStringToObject(inv, "b", "bucket");
+    cJSON_AddStringToObject(inv, "o", "key");
+    buckets_rpc_response_free(deliver(params));
+    cr_assert_eq(invalidations, 1);
+}
+
+Test(gossip, suspicion_of_self_is_refuted)
+{
+    cJSON *params = ping_from("node-b", 1);
+    cJSON *suspect = add_update(params, "m");
+    cJSON_AddNumberToObject(suspect, "s", BUCKETS_MEMBER_SUSPECT);
+    cJSON_AddStringToObject(suspect, "n", "node-a");
+    cJSON_AddNumberToObject(suspect, "i", 4e9);
+
+    buckets_rpc_response_t *response = deliver(params);
+    cJSON *alive = find_update(response, "m", "node-a");
+    cr_assert_not_null(alive);
+    cr_assert_eq(cJSON_GetObjectItem(alive, "s")->valueint, BUCKETS_MEMBER_ALIVE);
+    cr_assert_float_eq(cJSON_GetObjectItem(alive, "i")->valuedouble, 4e9 + 1, 0.5);
+    buckets_rpc_response_free(response);
+
+    buckets_gossip_stats_t stats;
+    buckets_gossip_get_stats(gossip, &stats);
+    cr_assert_eq(stats.refutations, 1);
+}
+
+Test(gossip, published_invalidation_is_piggybacked)
+{
+    buckets_gossip_publish_invalidation(gossip, "photos", "cat.jpg");
+
+    buckets_rpc_response_t *response = deliver(ping_from("node-b", 1));
+    cJSON *inv = find_update(response, "x", NULL);
+    cr_assert_not_null(inv);
+    cr_assert_str_eq(cJSON_GetObjectItem(inv, "b")->valuestring, "photos");
+    cr_assert_str_eq(cJSON_GetObjectItem(inv, "o")->valuestring, "cat.jpg");
+
+    /* Our own invalidation coming back is not applied locally */
+    cJSON *params = ping_from("node-b", 1);
+    cJSON_AddItemToArray(cJSON_GetObjectItem(params, "updates"), cJSON_Duplicate(inv, true));
+    buckets_rpc_response_free(response);
+    buckets_rpc_response_free(deliver(params));
+    cr_assert_eq(invalidations, 0);
+}
+
+/* ===================================================================
+ * Failure Detection Tests
+ * ===================================================================*/
+
+Test(gossip, unreachable_member_is_suspected_then_dead)
+{
+    cr_assert_eq(buckets_gossip_add_member(gossip, "node-c", DEAD_ENDPOINT), BUCKETS_OK);
+    cr_assert_not(buckets_gossip_endpoint_dead(gossip, DEAD_ENDPOINT));
+
+    /* Direct ping fails and there is nobody to ask for an indirect one */
+    buckets_gossip_tick(gossip);
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_SUSPECT);
+
+    /* Suspicion times out after suspicion_mult periods in a small cluster */
+    usleep(250 * 1000);
+    buckets_gossip_tick(gossip);
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_DEAD);
+    cr_assert(buckets_gossip_endpoint_dead(gossip, DEAD_ENDPOINT));
+    cr_assert_eq(deaths, 1);
+
+    buckets_gossip_stats_t stats;
+    buckets_gossip_get_stats(gossip, &stats);
+    cr_assert_eq(stats.suspicions, 1);
+    cr_assert_eq(stats.deaths, 1);
+
+    /* A higher incarnation brings it back */
+    buckets_rpc_response_free(deliver(ping_from("node-c", 4e9)));
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_ALIVE);
+}
+
+Test(gossip, dead_sender_is_told_so)
+{
+    cr_assert_eq(buckets_gossip_add_member(gossip, "node-c", DEAD_ENDPOINT), BUCKETS_OK);
+    buckets_gossip_tick(gossip);
+    usleep(250 * 1000);
+    buckets_gossip_tick(gossip);
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_DEAD);
+
+    /* Same incarnation: stays dead, and the ack tells it so it can refute */
+    buckets_rpc_response_t *response = deliver(ping_from("node-c", 0));
+    cJSON *notice = find_update(response, "m", "node-c");
+    cr_assert_not_null(notice);
+    cr_assert_eq(cJSON_GetObjectItem(notice, "s")->valueint, BUCKETS_MEMBER_DEAD);
+    buckets_rpc_response_free(response);
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_DEAD);
+}
+
+/* ===================================================================
+ * Worker Pool Tests
+ * ===================================================================*/
+
+/* Another worker of node-a, following the fixture's gossip as its agent */
+static buckets_gossip_t* follower_create(buckets_rpc_context_t *follower_ctx)
+{
+    if (!shared) {
+        shared = buckets_gossip_shared_create();
+        cr_assert_not_null(shared);
+        buckets_gossip_share(gossip, shared, true);
+    }
+    buckets_gossip_t *follower = buckets_gossip_create(follower_ctx, "node-a",
+                                                       "http://127.0.0.1:2", NULL);
+    cr_assert_not_null(follower);
+    buckets_gossip_share(follower, shared, false);
+    cr_assert_eq(buckets_gossip_start(follower), BUCKETS_OK);
+    return follower;
+}
+
+static u64 acked_incarnation(buckets_rpc_response_t *response)
+{
+    return (u64)cJSON_GetObjectItem(response->result, "inc")->valuedouble;
+}
+
+Test(gossip, follower_forwards_to_agent)
+{
+    buckets_rpc_context_t *follower_ctx = buckets_rpc_context_create(pool);
+    buckets_gossip_t *follower = follower_create(follower_ctx);
+    cr_assert_eq(buckets_gossip_start(gossip), BUCKETS_OK);
+
+    cJSON *params = ping_from("node-b", 5);
+    cJSON *inv = add_update(params, "x");
+    cJSON_AddStringToObject(inv, "id", "00000000000000cd");
+    cJSON_AddStringToObject(inv, "b", "bucket");
+    cJSON_AddStringToObject(inv, "o", "key");
+
+    /* Answered for the node, with the agent's incarnation */
+    buckets_rpc_response_t *agent_ack = deliver(ping_from("node-c", 1));
+    buckets_rpc_response_t *response = deliver_to(follower_ctx, params);
+    cr_assert_str_eq(cJSON_GetObjectItem(response->result, "from")->valuestring, "node-a");
+    cr_assert_eq(acked_incarnation(response), acked_incarnation(agent_ack));
+    buckets_rpc_response_free(response);
+    buckets_rpc_response_free(agent_ack);
+
+    /* Applied by the agent alone */
+    for (int i = 0; i < 100 && invalidations == 0; i++) {
+        usleep(10 * 1000);
+    }
+    cr_assert_eq(invalidations, 1);
+    cr_assert_str_eq(last_invalidated, "bucket/key");
+    member_state("node-b");
+
+    buckets_gossip_stats_t stats;
+    buckets_gossip_get_stats(follower, &stats);
+    cr_assert_eq(stats.forwarded, 1);
+    cr_assert_eq(stats.probes, 0);
+
+    buckets_gossip_free(follower);
+    buckets_rpc_context_free(follower_ctx);
+}
+
+Test(gossip, follower_reads_agents_view)
+{
+    buckets_rpc_context_t *follower_ctx = buckets_rpc_context_create(pool);
+    buckets_gossip_t *follower = follower_create(follower_ctx);
+
+    cr_assert_eq(buckets_gossip_add_member(gossip, "node-c", DEAD_ENDPOINT), BUCKETS_OK);
+    buckets_gossip_tick(gossip);
+    usleep(250 * 1000);
+    buckets_gossip_tick(gossip);
+    cr_assert_eq(member_state("node-c"), BUCKETS_MEMBER_DEAD);
+
+    /* The follower never probed, yet agrees */
+    buckets_gossip_tick(follower);
+    cr_assert(buckets_gossip_endpoint_dead(follower, DEAD_ENDPOINT));
+
+    buckets_gossip_member_t *members = NULL;
+    int count = 0;
+    cr_assert_eq(buckets_gossip_get_members(follower, &members, &count), BUCKETS_OK);
+    cr_assert_eq(count, 1);
+    cr_assert_str_eq(members[0].node_id, "node-c");
+    cr_assert_eq(members[0].state, BUCKETS_MEMBER_DEAD);
+    buckets_free(members);
+
+    buckets_gossip_free(follower);
+    buckets_rpc_context_free(follower_ctx);
+}
+
+Test(gossip, suspicion_via_follower_is_refuted_by_agent)
+{
+    buckets_rpc_context_t *follower_ctx = buckets_rpc_context_create(pool);
+    buckets_gossip_t *follower = follower_create(follower_ctx);
+    cr_assert_eq(buckets_gossip_start(gossip), BUCKETS_OK);
+
+    cJSON *params = ping_from("node-b", 1);
+    cJSON *suspect = add_update(params, "m");
+    cJSON_AddNumberToObject(suspect, "s", BUCKETS_MEMBER_SUSPECT);
+    cJSON_AddStringToObject(suspect, "n", "node-a");
+    cJSON_AddNumberToObject(suspect, "i", 4e9);
+    buckets_rpc_response_free(deliver_to(follower_ctx, params));
+
+    /* One refutation, which every worker then answers with */
+    u64 incarnation = 0;
+    for (int i = 0; i < 100 && incarnation <= (u64)4e9; i++) {
+        usleep(10 * 1000);
+        buckets_rpc_response_t *response = deliver_to(follower_ctx, ping_from("node-b", 1));
+        incarnation = acked_incarnation(response);
+        buckets_rpc_response_free(response);
+    }
+    cr_assert_eq(incarnation, (u64)4e9 + 1);
+
+    buckets_gossip_stats_t stats;
+    buckets_gossip_get_stats(gossip, &stats);
+    cr_assert_eq(stats.refutations, 1);
+
+    buckets_gossip_free(follower);
+    buckets_rpc_context_free(follower_ctx);
+}
@@ -0,0 +1,161 @@
+/**
+ * Memory Budget Tests
+ *
+ * Unit tests for the node-wide in-flight memory budget.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "buckets.h"
+#include "buckets_mem_budget.h"
+
+#define MB (1024ULL * 1024ULL)
+
+void setup(void) {
+    buckets_init();
+    buckets_mem_budget_init(8 * MB, 2000);
+}
+
+void teardown(void) {
+    buckets_mem_budget_cleanup();
+    buckets_cleanup();
+}
+
+TestSuite(mem_budget, .init = setup, .fini = teardown);
+
+static u64 used_bytes(void) {
+    buckets_mem_budget_stats_t stats;
+    buckets_mem_budget_get_stats(&stats);
+    return stats.used;
+}
+
+/* ===================================================================
+ * Event Loop Reservation Tests
+ * ===================================================================*/
+
+Test(mem_budget, try_reserve_respects_limit) {
+    cr_assert(buckets_mem_budget_try_reserve(6 * MB));
+    cr_assert_not(buckets_mem_budget_try_reserve(4 * MB));
+    cr_assert_eq(used_bytes(), 6 * MB);
+
+    buckets_mem_budget_release(6 * MB);
+    cr_assert(buckets_mem_budget_try_reserve(4 * MB));
+    buckets_mem_budget_release(4 * MB);
+    cr_assert_eq(used_bytes(), 0);
+
+    buckets_mem_budget_stats_t stats;
+    buckets_mem_budget_get_stats(&stats);
+    cr_assert_eq(stats.deferred, 1);
+    cr_assert_eq(stats.peak, 6 * MB);
+}
+
+Test(mem_budget, small_requests_are_not_tracked) {
+    cr_assert(buckets_mem_budget_try_reserve(8 * MB));
+    cr_assert(buckets_mem_budget_try_reserve(64 * 1024));
+    buckets_mem_budget_release(64 * 1024);
+    cr_assert_eq(used_bytes(), 8 * MB);
+    buckets_mem_budget_release(8 * MB);
+}
+
+Test(mem_budget, oversized_request_runs_alone) {
+    cr_assert(buckets_mem_budget_try_reserve(32 * MB));
+    cr_assert_not(buckets_mem_budget_try_reserve(2 * MB));
+    buckets_mem_budget_release(32 * MB);
+}
+
+Test(mem_budget, disabled_budget_admits_everything) {
+    buckets_mem_budget_init(0, 0);
+    cr_assert(buckets_mem_budget_try_reserve(1024 * MB));
+    cr_assert(buckets_mem_budget_try_reserve(1024 * MB));
+    cr_assert_eq(used_bytes(), 0);
+}
+
+static int g_hook_calls;
+
+static void count_hook(void *arg) {
+    (void)arg;
+    g_hook_calls++;
+}
+
+Test(mem_budget, release_runs_hooks) {
+    g_hook_calls = 0;
+    cr_assert_eq(buckets_mem_budget_add_hook(count_hook, &g_hook_calls), BUCKETS_OK);
+    buckets_mem_budget_try_reserve(2 * MB);
+    buckets_mem_budget_release(2 * MB);
+    cr_assert_eq(g_hook_calls, 1);
+
+    buckets_mem_budget_remove_hook(count_hook, &g_hook_calls);
+    buckets_mem_budget_try_reserve(2 * MB);
+    buckets_mem_budget_release(2 * MB);
+    cr_assert_eq(g_hook_calls, 1);
+}
+
+/* ===================================================================
+ * Request Scope Tests
+ * ===================================================================*/
+
+Test(mem_budget, charges_outside_a_scope_are_ignored) {
+    buckets_mem_budget_charge(4 * MB);
+    cr_assert_eq(used_bytes(), 0);
+}
+
+Test(mem_budget, scope_collects_charges) {
+    buckets_mem_budget_scope_begin();
+    buckets_mem_budget_charge(2 * MB);
+    buckets_mem_budget_charge(3 * MB);
+    buckets_mem_budget_charge(1024);
+    u64 held = buckets_mem_budget_scope_end();
+
+    cr_assert_eq(held, 5 * MB);
+    cr_assert_eq(used_bytes(), 5 * MB);
+    buckets_mem_budget_release(held);
+    cr_assert_eq(used_bytes(), 0);
+}
+
+static void* charging_request(void *arg) {
+    u64 *held = (u64 *)arg;
+    buckets_mem_budget_scope_begin();
+    buckets_mem_budget_charge(6 * MB);
+    *held = buckets_mem_budget_scope_end();
+    return NULL;
+}
+
+Test(mem_budget, charge_waits_for_release) {
+    cr_assert(buckets_mem_budget_try_reserve(6 * MB));
+
+    u64 held = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, charging_request, &held);
+
+    /* The request blocks until the first reservation is returned */
+    usleep(100 * 1000);
+    cr_assert_eq(used_bytes(), 6 * MB);
+    buckets_mem_budget_release(6 * MB);
+    pthread_join(thread, NULL);
+
+    cr_assert_eq(held, 6 * MB);
+    buckets_mem_budget_stats_t stats;
+    buckets_mem_budget_get_stats(&stats);
+    cr_assert_eq(stats.waits, 1);
+    cr_assert_eq(stats.overdrafts, 0);
+    buckets_mem_budget_release(held);
+}
+
+Test(mem_budget, long_wait_overdrafts) {
+    buckets_mem_budget_init(8 * MB, 50);
+    cr_assert(buckets_mem_budget_try_reserve(6 * MB));
+
+    u64 held = 0;
+    charging_request(&held);
+    cr_assert_eq(held, 6 * MB);
+    cr_assert_eq(used_bytes(), 12 * MB);
+
+    buckets_mem_budget_stats_t stats;
+    buckets_mem_budget_get_stats(&stats);
+    cr_assert_eq(stats.overdrafts, 1);
+    buckets_mem_budget_release(held);
+    buckets_mem_budget_release(6 * MB);
+}
@@ -0,0 +1,66 @@
+/**
+ * NUMA Placement Tests
+ *
+ * Unit tests for topology discovery and disk locality accounting. These
+ * run on any host; on a single-node machine everything is node 0.
+ */
+
+#include <criterion/criterion.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "buckets.h"
+#include "buckets_numa.h"
+
+void setup(void) {
+    buckets_init();
+}
+
+void teardown(void) {
+    buckets_cleanup();
+}
+
+TestSuite(numa, .init = setup, .fini = teardown);
+
+Test(numa, topology_is_discovered) {
+    u32 nodes = buckets_numa_node_count();
+    cr_assert_geq(nodes, 1);
+    cr_assert_leq(nodes, BUCKETS_NUMA_MAX_NODES);
+
+    int node = buckets_numa_current_node();
+    cr_assert(node >= -1 && node < (int)nodes);
+}
+
+Test(numa, placement_is_off_by_default) {
+    unsetenv("BUCKETS_NUMA");
+    cr_assert_not(buckets_numa_enabled());
+    cr_assert_eq(buckets_numa_pin_worker(3), BUCKETS_OK);
+    cr_assert_eq(buckets_numa_home_node(), -1);
+    cr_assert_eq(buckets_numa_home_cpu(), -1);
+}
+
+Test(numa, disk_node_is_cached_and_bounded) {
+    int node = buckets_numa_node_of_path("/");
+    cr_assert(node >= -1 && node < (int)buckets_numa_node_count());
+    cr_assert_eq(buckets_numa_node_of_path("/"), node);
+    cr_assert_eq(buckets_numa_node_of_path(NULL), -1);
+}
+
+Test(numa, every_io_is_counted_once) {
+    buckets_numa_stats_t before, after;
+    buckets_numa_get_stats(&before);
+
+    for (int i = 0; i < 10; i++) {
+        buckets_numa_record_io("/", 4096);
+    }
+
+    buckets_numa_get_stats(&after);
+    u64 ops = (after.local_ops - before.local_ops) +
+              (after.remote_ops - before.remote_ops) +
+              (after.unknown_ops - before.unknown_ops);
+    cr_assert_eq(ops, 10);
+    cr_assert_eq((after.local_bytes - before.local_bytes) +
+                 (after.remote_bytes - before.remote_bytes),
+                 (after.local_ops - before.local_ops +
+                  after.remote_ops - before.remote_ops) * 4096);
+}
@@ -0,0 +1,231 @@
+/**
+ * Peer TLS Tests
+ *
+ * Tests for mutually authenticated TLS on node-to-node sockets.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <openssl/ssl.h>
+
+#include "buckets.h"
+#include "buckets_net.h"
+
+#define TEST_CERT "tests/net/certs/cert.pem"
+#define TEST_KEY  "tests/net/certs/key.pem"
+
+/* ===================================================================
+ * Test Fixtures
+ * ===================================================================*/
+
+static SSL_CTX *server_ctx = NULL;
+static int listen_sock = -1;
+static int listen_port = 0;
+static pthread_t server_thread;
+static volatile bool server_plain = false;   /* Accept and hang up, no TLS */
+static volatile int client_certs_seen = 0;
+
+/**
+ * TLS echo server: one connection at a time, echoes until EOF
+ */
+static void* server_thread_func(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        int fd = accept(listen_sock, NULL, NULL);
+        if (fd < 0) {
+            return NULL;
+        }
+        if (server_plain) {
+            close(fd);
+            continue;
+        }
+
+        SSL *ssl = SSL_new(server_ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_accept(ssl) == 1) {
+            X509 *peer = SSL_get_peer_certificate(ssl);
+            if (peer && SSL_get_verify_result(ssl) == X509_V_OK) {
+                client_certs_seen++;
+            }
+            X509_free(peer);
+
+            char buf[4096];
+            size_t n = 0;
+            while (SSL_read_ex(ssl, buf, sizeof(buf), &n) == 1) {
+                size_t written = 0;
+                SSL_write_ex(ssl, buf, n, &written);
+            }
+            SSL_shutdown(ssl);
+        }
+        SSL_free(ssl);
+        close(fd);
+    }
+}
+
+void setup(void)
+{
+    buckets_init();
+
+    server_ctx = SSL_CTX_new(TLS_server_method());
+    cr_assert_not_null(server_ctx);
+    cr_assert_eq(SSL_CTX_use_certificate_file(server_ctx, TEST_CERT, SSL_FILETYPE_PEM), 1);
+    cr_assert_eq(SSL_CTX_use_PrivateKey_file(server_ctx, TEST_KEY, SSL_FILETYPE_PEM), 1);
+    cr_assert_eq(SSL_CTX_load_verify_locations(server_ctx, TEST_CERT, NULL), 1);
+    SSL_CTX_set_verify(server_ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+    static const unsigned char sid_ctx[] = "test";
+    SSL_CTX_set_session_id_context(server_ctx, sid_ctx, sizeof(sid_ctx) - 1);
+
+    listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+    cr_assert_geq(listen_sock, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    cr_assert_eq(bind(listen_sock, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    cr_assert_eq(listen(listen_sock, 8), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listen_sock, (struct sockaddr*)&addr, &len);
+    listen_port = ntohs(addr.sin_port);
+
+    server_plain = false;
+    client_certs_seen = 0;
+    pthread_create(&server_thread, NULL, server_thread_func, NULL);
+
+    cr_assert_eq(buckets_peer_tls_init(TEST_CERT, TEST_KEY, TEST_CERT), BUCKETS_OK);
+}
+
+void teardown(void)
+{
+    buckets_peer_tls_cleanup();
+
+    shutdown(listen_sock, SHUT_RDWR);
+    close(listen_sock);
+    pthread_join(server_thread, NULL);
+    SSL_CTX_free(server_ctx);
+
+    buckets_cleanup();
+}
+
+TestSuite(peer_tls, .init = setup, .fini = teardown);
+
+static int connect_peer(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    cr_assert_geq(fd, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(listen_port);
+    cr_assert_eq(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    return fd;
+}
+
+static void recv_exact(int fd, char *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = buckets_peer_recv(fd, buf + got, len - got);
+        cr_assert_gt(n, 0);
+        got += n;
+    }
+}
+
+static void close_peer(int fd)
+{
+    buckets_peer_tls_close(fd);
+    close(fd);
+}
+
+/* ===================================================================
+ * Handshake Tests
+ * ===================================================================*/
+
+Test(peer_tls, mutual_handshake_and_echo) {
+    cr_assert(buckets_peer_tls_enabled());
+    cr_assert_str_eq(buckets_peer_tls_ca_file(), TEST_CERT);
+
+    int fd = connect_peer();
+    cr_assert_eq(buckets_peer_tls_connect(fd, "127.0.0.1", listen_port), BUCKETS_OK);
+
+    char buf[64];
+    cr_assert_eq(buckets_peer_send(fd, "hello", 5), 5);
+    recv_exact(fd, buf, 5);
+    cr_assert_eq(memcmp(buf, "hello", 5), 0);
+
+    struct iovec iov[3] = {
+        { .iov_base = "head:", .iov_len = 5 },
+        { .iov_base = "", .iov_len = 0 },
+        { .iov_base = "body", .iov_len = 4 },
+    };
+    cr_assert_eq(buckets_peer_writev(fd, iov, 3), 9);
+    recv_exact(fd, buf, 9);
+    cr_assert_eq(memcmp(buf, "head:body", 9), 0);
+
+    close_peer(fd);
+    cr_assert_eq(client_certs_seen, 1);
+}
+
+Test(peer_tls, reconnect_resumes_session) {
+    for (int i = 0; i < 3; i++) {
+        int fd = connect_peer();
+        cr_assert_eq(buckets_peer_tls_connect(fd, "127.0.0.1", listen_port), BUCKETS_OK);
+        char buf[4];
+        cr_assert_eq(buckets_peer_send(fd, "ping", 4), 4);
+        recv_exact(fd, buf, 4);
+        close_peer(fd);
+    }
+
+    buckets_peer_tls_stats_t stats;
+    buckets_peer_tls_get_stats(&stats);
+    cr_assert_eq(stats.handshakes, 3);
+    cr_assert_eq(stats.resumed, 2);
+    cr_assert_eq(stats.failures, 0);
+}
+
+Test(peer_tls, plaintext_peer_fails_handshake) {
+    server_plain = true;
+
+    int fd = connect_peer();
+    cr_assert_neq(buckets_peer_tls_connect(fd, "127.0.0.1", listen_port), BUCKETS_OK);
+    close(fd);
+
+    buckets_peer_tls_stats_t stats;
+    buckets_peer_tls_get_stats(&stats);
+    cr_assert_eq(stats.failures, 1);
+    cr_assert_eq(stats.handshakes, 0);
+}
+
+/* ===================================================================
+ * Disabled Tests
+ * ===================================================================*/
+
+Test(peer_tls, disabled_is_plain_socket_io) {
+    cr_assert_eq(buckets_peer_tls_init(NULL, NULL, NULL), BUCKETS_OK);
+    cr_assert_not(buckets_peer_tls_enabled());
+    cr_assert_null(buckets_peer_tls_ca_file());
+
+    int sv[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    cr_assert_eq(buckets_peer_tls_connect(sv[0], "peer", 9000), BUCKETS_OK);
+
+    char buf[8];
+    cr_assert_eq(buckets_peer_send(sv[0], "plain", 5), 5);
+    cr_assert_eq(recv(sv[1], buf, sizeof(buf), 0), 5);
+    cr_assert_eq(send(sv[1], "back", 4, 0), 4);
+    cr_assert_eq(buckets_peer_recv(sv[0], buf, sizeof(buf)), 4);
+    cr_assert_eq(memcmp(buf, "back", 4), 0);
+
+    buckets_peer_tls_close(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+}
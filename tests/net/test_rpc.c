@@ -271,6 +271,26 @@ Test(rpc, register_duplicate_handler)
     cr_assert_neq(ret, BUCKETS_OK, "Duplicate registration should fail");
 }
 
+Test(rpc, unregister_handler)
+{
+    buckets_rpc_register_handler(ctx, "test.first", test_handler, NULL);
+    buckets_rpc_register_handler(ctx, "test.gone", test_handler, NULL);
+    buckets_rpc_register_handler(ctx, "test.last", test_handler, NULL);
+
+    int ret = buckets_rpc_unregister_handler(ctx, "test.gone");
+    cr_assert_eq(ret, BUCKETS_OK, "Unregister should succeed");
+    ret = buckets_rpc_unregister_handler(ctx, "test.gone");
+    cr_assert_eq(ret, BUCKETS_ERR_NOT_FOUND, "Second unregister should fail");
+
+    /* The method can be registered again; the others are untouched */
+    ret = buckets_rpc_register_handler(ctx, "test.gone", test_handler, NULL);
+    cr_assert_eq(ret, BUCKETS_OK, "Re-registration should succeed");
+    ret = buckets_rpc_register_handler(ctx, "test.first", test_handler, NULL);
+    cr_assert_neq(ret, BUCKETS_OK, "Other handlers should remain");
+    ret = buckets_rpc_register_handler(ctx, "test.last", test_handler, NULL);
+    cr_assert_neq(ret, BUCKETS_OK, "Other handlers should remain");
+}
+
 Test(rpc, dispatch_success)
 {
     /* Register handler */
@@ -12,9 +12,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sys/time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <openssl/ssl.h>
 
 #include "buckets.h"
 #include "buckets_net.h"
@@ -22,6 +24,7 @@
 
 /* Test port - use a high port to avoid conflicts */
 #define TEST_PORT 19876
+#define TEST_TLS_PORT 19877
 
 /* Simple test handler */
 static void test_handler(uv_http_conn_t *conn, void *user_data)
@@ -623,6 +626,701 @@ static int test_multiple_keep_alive(void)
     return 0;
 }
 
+/* ===================================================================
+ * TLS Tests
+ * ===================================================================*/
+
+/* Helper: `requests` keep-alive GETs over one TLS connection, optionally
+ * offering `resume`; returns the number of 200 responses */
+static int tls_get(SSL_CTX *ctx, SSL_SESSION *resume, int requests,
+                   SSL_SESSION **session_out, bool *reused)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_TLS_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, sock);
+    if (resume) {
+        SSL_set_session(ssl, resume);
+    }
+    if (SSL_connect(ssl) != 1) {
+        SSL_free(ssl);
+        close(sock);
+        return -1;
+    }
+    
+    int ok = 0;
+    for (int i = 0; i < requests; i++) {
+        char request[256];
+        int req_len = snprintf(request, sizeof(request),
+            "GET /tls%d HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n", i);
+        if (SSL_write(ssl, request, req_len) != req_len) {
+            break;
+        }
+        
+        /* Body ends with the "Body Length" line */
+        char response[4096];
+        size_t total = 0;
+        while (total < sizeof(response) - 1) {
+            int n = SSL_read(ssl, response + total, sizeof(response) - 1 - total);
+            if (n <= 0) break;
+            total += n;
+            response[total] = '\0';
+            if (strstr(response, "Body Length: 0\n")) break;
+        }
+        response[total] = '\0';
+        
+        char expected[32];
+        snprintf(expected, sizeof(expected), "URL: /tls%d", i);
+        if (strstr(response, "HTTP/1.1 200") && strstr(response, expected)) {
+            ok++;
+        }
+    }
+    
+    if (reused) {
+        *reused = SSL_session_reused(ssl);
+    }
+    if (session_out) {
+        *session_out = SSL_get1_session(ssl);
+    }
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(sock);
+    return ok;
+}
+
+static SSL_CTX* tls_client_ctx(int max_version, bool tickets)
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_max_proto_version(ctx, max_version);
+    if (!tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    return ctx;
+}
+
+/* Test: requests over TLS, including several on one connection */
+static int test_tls_keep_alive(void)
+{
+    SSL_CTX *ctx = tls_client_ctx(TLS1_3_VERSION, true);
+    int ok = tls_get(ctx, NULL, 3, NULL, NULL);
+    SSL_CTX_free(ctx);
+    
+    if (ok != 3) {
+        printf("FAIL: test_tls_keep_alive (%d of 3 responses)\n", ok);
+        return 1;
+    }
+    printf("PASS: test_tls_keep_alive\n");
+    return 0;
+}
+
+/* Test: a second connection resumes the first one's session */
+static int test_tls_resumption(const char *name, int max_version, bool tickets)
+{
+    SSL_CTX *ctx = tls_client_ctx(max_version, tickets);
+    SSL_SESSION *session = NULL;
+    bool reused = true;
+    
+    int ok = tls_get(ctx, NULL, 1, &session, &reused);
+    if (ok != 1 || reused || !session) {
+        printf("FAIL: %s: first connection (ok=%d, reused=%d)\n", name, ok, reused);
+        SSL_SESSION_free(session);
+        SSL_CTX_free(ctx);
+        return 1;
+    }
+    
+    ok = tls_get(ctx, session, 1, NULL, &reused);
+    SSL_SESSION_free(session);
+    SSL_CTX_free(ctx);
+    
+    if (ok != 1 || !reused) {
+        printf("FAIL: %s: not resumed (ok=%d, reused=%d)\n", name, ok, reused);
+        return 1;
+    }
+    printf("PASS: %s\n", name);
+    return 0;
+}
+
+/* Test: a client stuck mid-handshake doesn't hold up anyone else */
+static int test_tls_stalled_handshake(void)
+{
+    int stalled = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_TLS_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (stalled < 0 || connect(stalled, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        printf("FAIL: test_tls_stalled_handshake: connect\n");
+        return 1;
+    }
+    
+    /* A record header promising more than we send */
+    static const unsigned char partial[] = { 0x16, 0x03, 0x01, 0x02, 0x00, 0x01 };
+    if (send(stalled, partial, sizeof(partial), 0) != (ssize_t)sizeof(partial)) {
+        close(stalled);
+        printf("FAIL: test_tls_stalled_handshake: send\n");
+        return 1;
+    }
+    
+    SSL_CTX *ctx = tls_client_ctx(TLS1_3_VERSION, true);
+    int ok = tls_get(ctx, NULL, 1, NULL, NULL);
+    SSL_CTX_free(ctx);
+    close(stalled);
+    
+    if (ok != 1) {
+        printf("FAIL: test_tls_stalled_handshake\n");
+        return 1;
+    }
+    printf("PASS: test_tls_stalled_handshake\n");
+    return 0;
+}
+
+/* Helper: status code of one GET over a fresh TLS connection */
+static int tls_status(SSL_CTX *ctx, const char *path)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_TLS_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (sock < 0 || connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    
+    int status = -1;
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, sock);
+    if (SSL_connect(ssl) == 1) {
+        char request[256];
+        int req_len = snprintf(request, sizeof(request),
+            "GET %s HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Connection: close\r\n"
+            "\r\n", path);
+        char response[64] = {0};
+        if (SSL_write(ssl, request, req_len) == req_len &&
+            SSL_read(ssl, response, sizeof(response) - 1) > 0) {
+            sscanf(response, "HTTP/1.1 %d", &status);
+        }
+        SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+    close(sock);
+    return status;
+}
+
+/* Test: internal routes need a client certificate from the peer CA */
+static int test_tls_peer_routes(void)
+{
+    SSL_CTX *anon = tls_client_ctx(TLS1_3_VERSION, true);
+    SSL_CTX *node = tls_client_ctx(TLS1_2_VERSION, true);
+    SSL_CTX_use_certificate_file(node, "tests/net/certs/cert.pem", SSL_FILETYPE_PEM);
+    SSL_CTX_use_PrivateKey_file(node, "tests/net/certs/key.pem", SSL_FILETYPE_PEM);
+    
+    int anon_public = tls_status(anon, "/public");
+    int anon_chunk = tls_status(anon, "/_internal/chunk");
+    int anon_rpc = tls_status(anon, "/rpc");
+    int node_chunk = tls_status(node, "/_internal/chunk");
+    int node_rpc = tls_status(node, "/rpc");
+    int anon_rpc_like = tls_status(anon, "/rpcfoo");
+    SSL_CTX_free(anon);
+    SSL_CTX_free(node);
+    
+    if (anon_public != 200 || anon_chunk != 403 || anon_rpc != 403 ||
+        node_chunk != 200 || node_rpc != 200 || anon_rpc_like != 200) {
+        printf("FAIL: test_tls_peer_routes (%d %d %d %d %d %d)\n", anon_public,
+               anon_chunk, anon_rpc, node_chunk, node_rpc, anon_rpc_like);
+        return 1;
+    }
+    printf("PASS: test_tls_peer_routes\n");
+    return 0;
+}
+
+static int run_tls_tests(void)
+{
+    uv_http_server_t *server = uv_http_server_create("127.0.0.1", TEST_TLS_PORT);
+    if (!server) {
+        printf("FAIL: Failed to create TLS server\n");
+        return 1;
+    }
+    
+    uv_http_server_set_handler(server, test_handler, NULL);
+    if (uv_http_server_enable_tls(server, "tests/net/certs/cert.pem",
+                                  "tests/net/certs/key.pem") != BUCKETS_OK ||
+        uv_http_server_require_peer_certs(server, "tests/net/certs/cert.pem") != BUCKETS_OK ||
+        uv_http_server_start(server) != BUCKETS_OK) {
+        printf("FAIL: Failed to start TLS server\n");
+        uv_http_server_free(server);
+        return 1;
+    }
+    usleep(100000);
+    
+    int failures = 0;
+    failures += test_tls_keep_alive();
+    failures += test_tls_resumption("test_tls13_ticket_resumption", TLS1_3_VERSION, true);
+    failures += test_tls_resumption("test_tls12_ticket_resumption", TLS1_2_VERSION, true);
+    failures += test_tls_resumption("test_tls12_session_cache_resumption", TLS1_2_VERSION, false);
+    failures += test_tls_stalled_handshake();
+    failures += test_tls_peer_routes();
+    
+    uv_http_server_stop(server);
+    uv_http_server_free(server);
+    return failures;
+}
+
+/* ===================================================================
+ * Tenant QoS
+ * ===================================================================*/
+
+static int qos_tenant;                 /* Stands in for a tenant handle */
+static size_t qos_bytes_in;
+static size_t qos_bytes_out;
+static int qos_inbound_pauses;
+
+static int qos_admit(uv_http_conn_t *conn, void **tenant)
+{
+    if (strstr(conn->url, "/slow")) {
+        return 503;
+    }
+    *tenant = &qos_tenant;
+    return 0;
+}
+
+static uint64_t qos_charge(void *tenant, size_t bytes, bool inbound)
+{
+    if (tenant != &qos_tenant) {
+        return 0;
+    }
+    if (!inbound) {
+        __atomic_add_fetch(&qos_bytes_out, bytes, __ATOMIC_RELAXED);
+        return 0;
+    }
+    __atomic_add_fetch(&qos_bytes_in, bytes, __ATOMIC_RELAXED);
+    /* Owe 200 ms once per request body */
+    return __atomic_fetch_add(&qos_inbound_pauses, 1, __ATOMIC_RELAXED) == 0 ? 200000 : 0;
+}
+
+static int test_tenant_qos(void)
+{
+    printf("TEST: test_tenant_qos\n");
+    
+    uv_http_server_t *server = uv_http_server_create("127.0.0.1", TEST_PORT);
+    if (!server) {
+        printf("FAIL: Failed to create QoS server\n");
+        return 1;
+    }
+    uv_http_qos_t qos = {
+        .admit = qos_admit,
+        .charge = qos_charge,
+        .refusal_body = "<Error><Code>SlowDown</Code></Error>",
+        .refusal_content_type = "application/xml",
+    };
+    uv_http_server_set_handler(server, test_handler, NULL);
+    if (uv_http_server_set_qos(server, &qos) != BUCKETS_OK ||
+        uv_http_server_start(server) != BUCKETS_OK) {
+        printf("FAIL: Failed to start QoS server\n");
+        uv_http_server_free(server);
+        return 1;
+    }
+    usleep(100000);
+    
+    int failures = 0;
+    char response[8192];
+    
+    /* Refused with the hook's status and body; its body is dropped */
+    int len = send_request("PUT", "/slow/key", "ignored", 7, response, sizeof(response));
+    if (len <= 0 || !strstr(response, "503") || !strstr(response, "<Code>SlowDown</Code>") ||
+        !strstr(response, "application/xml") || qos_bytes_in != 0) {
+        printf("FAIL: refusal (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    }
+    
+    /* Admitted bodies are charged and reading pauses for what is owed */
+    size_t body_len = 96 * 1024;
+    char *body = malloc(body_len);
+    memset(body, 'q', body_len);
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    len = send_request("POST", "/paced", body, body_len, response, sizeof(response));
+    gettimeofday(&end, NULL);
+    free(body);
+    long elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+    
+    if (len <= 0 || !strstr(response, "200 OK") || !strstr(response, "Body Length: 98304")) {
+        printf("FAIL: paced request (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    } else if (qos_bytes_in != body_len || qos_bytes_out == 0 || qos_inbound_pauses < 1) {
+        printf("FAIL: charged %zu in, %zu out\n", qos_bytes_in, qos_bytes_out);
+        failures++;
+    } else if (elapsed_ms < 190) {
+        printf("FAIL: body not paced (%ld ms)\n", elapsed_ms);
+        failures++;
+    }
+    
+    uv_http_server_stop(server);
+    uv_http_server_free(server);
+    
+    if (failures == 0) {
+        printf("PASS: test_tenant_qos (%d body reads, %ld ms)\n", qos_inbound_pauses, elapsed_ms);
+    }
+    return failures;
+}
+
+/* ===================================================================
+ * Priority Lanes
+ * ===================================================================*/
+
+static int lane_bulk_active;
+static int lane_bulk_max;
+static int lane_bulk_seen;
+
+static void lane_handler(uv_http_conn_t *conn, void *user_data)
+{
+    (void)user_data;
+    
+    if (conn->lane == UV_HTTP_LANE_BULK) {
+        int active = __atomic_add_fetch(&lane_bulk_active, 1, __ATOMIC_ACQ_REL);
+        int max = __atomic_load_n(&lane_bulk_max, __ATOMIC_ACQUIRE);
+        while (active > max &&
+               !__atomic_compare_exchange_n(&lane_bulk_max, &max, active, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        }
+        __atomic_add_fetch(&lane_bulk_seen, 1, __ATOMIC_RELAXED);
+        usleep(300000);
+        __atomic_sub_fetch(&lane_bulk_active, 1, __ATOMIC_ACQ_REL);
+    }
+    test_handler(conn, NULL);
+    uv_http_response_end(conn);
+}
+
+static void* lane_bulk_client(void *arg)
+{
+    char *response = malloc(8192);
+    char body[4096];
+    memset(body, 'b', sizeof(body));
+    int len = send_request("PUT", "/bulk", body, sizeof(body), response, 8192);
+    *(int*)arg = len > 0 && strstr(response, "Body Length: 4096") != NULL;
+    free(response);
+    return NULL;
+}
+
+static int test_priority_lanes(void)
+{
+    printf("TEST: test_priority_lanes\n");
+    
+    uv_http_server_t *server = uv_http_server_create("127.0.0.1", TEST_PORT);
+    if (!server) {
+        printf("FAIL: Failed to create lanes server\n");
+        return 1;
+    }
+    uv_http_server_set_async_handler(server, lane_handler, NULL);
+    if (uv_http_server_set_lanes(server, 1, 1024) != BUCKETS_OK ||
+        uv_http_server_start(server) != BUCKETS_OK) {
+        printf("FAIL: Failed to start lanes server\n");
+        uv_http_server_free(server);
+        return 1;
+    }
+    usleep(100000);
+    
+    int failures = 0;
+    
+    /* Three uploads over the bulk size share one pool thread */
+    pthread_t clients[3];
+    int ok[3] = {0};
+    for (int i = 0; i < 3; i++) {
+        pthread_create(&clients[i], NULL, lane_bulk_client, &ok[i]);
+    }
+    usleep(100000);
+    
+    /* A small request is not queued behind them */
+    char response[8192];
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    int len = send_request("GET", "/small", NULL, 0, response, sizeof(response));
+    gettimeofday(&end, NULL);
+    long elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
+    
+    for (int i = 0; i < 3; i++) {
+        pthread_join(clients[i], NULL);
+    }
+    
+    if (len <= 0 || !strstr(response, "200 OK")) {
+        printf("FAIL: interactive request (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    } else if (elapsed_ms > 200) {
+        printf("FAIL: interactive request waited %ld ms behind bulk\n", elapsed_ms);
+        failures++;
+    }
+    if (!ok[0] || !ok[1] || !ok[2] || lane_bulk_seen != 3) {
+        printf("FAIL: bulk requests (%d/%d/%d, %d in bulk lane)\n",
+               ok[0], ok[1], ok[2], lane_bulk_seen);
+        failures++;
+    }
+    if (lane_bulk_max != 1) {
+        printf("FAIL: %d bulk handlers ran at once with a cap of 1\n", lane_bulk_max);
+        failures++;
+    }
+    
+    uv_http_server_stop(server);
+    uv_http_server_free(server);
+    
+    if (failures == 0) {
+        printf("PASS: test_priority_lanes (interactive in %ld ms)\n", elapsed_ms);
+    }
+    return failures;
+}
+
+/* ===================================================================
+ * Resumable Handlers
+ * ===================================================================*/
+
+#define STAGE_LEGS 4
+
+static struct {
+    int legs_done;                 /* Legs that have finished (atomic) */
+    int legs_at_stage;             /* legs_done seen by the next stage */
+    int resumed;                   /* Set by the resuming thread before resume */
+    int resumed_at_stage;
+    int cancel_ran;                /* Stage after a disconnect has run */
+    int cancel_seen;               /* ... and saw uv_http_async_cancelled */
+} stage_state;
+
+static void stage_respond(uv_http_conn_t *conn, const char *text)
+{
+    const char *headers[] = { "Content-Type", "text/plain", NULL };
+    size_t len = strlen(text);
+    uv_http_response_start(conn, 200, headers, 2, len);
+    uv_http_response_write(conn, text, len);
+    uv_http_response_end(conn);
+}
+
+static void stage_leg(void *leg_ctx)
+{
+    (void)leg_ctx;
+    buckets_free(buckets_malloc(64));   /* Charged to the request */
+    usleep(50000);
+    __atomic_add_fetch(&stage_state.legs_done, 1, __ATOMIC_ACQ_REL);
+}
+
+static void stage_slow_leg(void *leg_ctx)
+{
+    (void)leg_ctx;
+    usleep(300000);
+}
+
+static void stage_after_legs(uv_http_conn_t *conn, void *ctx)
+{
+    (void)ctx;
+    stage_state.legs_at_stage = __atomic_load_n(&stage_state.legs_done, __ATOMIC_ACQUIRE);
+    char body[64];
+    snprintf(body, sizeof(body), "legs=%d", stage_state.legs_at_stage);
+    stage_respond(conn, body);
+}
+
+static void* stage_resumer(void *arg)
+{
+    usleep(100000);
+    __atomic_store_n(&stage_state.resumed, 1, __ATOMIC_RELEASE);
+    uv_http_async_resume((uv_async_work_t*)arg);
+    return NULL;
+}
+
+static void stage_after_resume(uv_http_conn_t *conn, void *ctx)
+{
+    (void)ctx;
+    stage_state.resumed_at_stage = __atomic_load_n(&stage_state.resumed, __ATOMIC_ACQUIRE);
+    stage_respond(conn, stage_state.resumed_at_stage ? "resumed" : "early");
+}
+
+static void stage_after_disconnect(uv_http_conn_t *conn, void *ctx)
+{
+    (void)ctx;
+    /* Touches the connection: must not have been freed under us */
+    __atomic_store_n(&stage_state.cancel_seen, uv_http_async_cancelled(conn), __ATOMIC_RELEASE);
+    __atomic_store_n(&stage_state.cancel_ran, 1, __ATOMIC_RELEASE);
+    stage_respond(conn, "too late");
+}
+
+static void stage_handler(uv_http_conn_t *conn, void *user_data)
+{
+    (void)user_data;
+    
+    if (strcmp(conn->url, "/fork") == 0) {
+        for (int i = 0; i < STAGE_LEGS; i++) {
+            uv_http_async_fork(conn, stage_leg, NULL);
+        }
+        uv_http_async_then(conn, stage_after_legs, NULL);
+    } else if (strcmp(conn->url, "/suspend") == 0) {
+        pthread_t thread;
+        uv_async_work_t *handle = uv_http_async_suspend(conn);
+        uv_http_async_then(conn, stage_after_resume, NULL);
+        pthread_create(&thread, NULL, stage_resumer, handle);
+        pthread_detach(thread);
+    } else if (strcmp(conn->url, "/disconnect") == 0) {
+        uv_http_async_fork(conn, stage_slow_leg, NULL);
+        uv_http_async_then(conn, stage_after_disconnect, NULL);
+    } else {
+        stage_respond(conn, "plain");
+    }
+}
+
+/* Send a request and hang up without reading the response */
+static int send_and_disconnect(const char *path)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "GET %s HTTP/1.1\r\nHost: localhost:%d\r\n\r\n", path, TEST_PORT);
+    int ret = send(sock, request, len, 0) == len ? 0 : -1;
+    usleep(50000);
+    close(sock);
+    return ret;
+}
+
+static bool wait_until(int *flag, int timeout_ms)
+{
+    for (int waited = 0; waited < timeout_ms; waited += 10) {
+        if (__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static int test_resumable_handlers(void)
+{
+    printf("TEST: test_resumable_handlers\n");
+    
+    uv_http_server_t *server = uv_http_server_create("127.0.0.1", TEST_PORT);
+    if (!server) {
+        printf("FAIL: Failed to create stages server\n");
+        return 1;
+    }
+    uv_http_server_set_async_handler(server, stage_handler, NULL);
+    if (uv_http_server_start(server) != BUCKETS_OK) {
+        printf("FAIL: Failed to start stages server\n");
+        uv_http_server_free(server);
+        return 1;
+    }
+    usleep(100000);
+    memset(&stage_state, 0, sizeof(stage_state));
+    
+    int failures = 0;
+    char response[4096];
+    
+    /* fork + then: the next stage runs only after every leg */
+    buckets_account_enable(true);
+    buckets_account_reset_totals();
+    pthread_mutex_lock(&g_uv_metrics.lock);
+    u64 cost_before = g_uv_metrics.request_cost_count;
+    pthread_mutex_unlock(&g_uv_metrics.lock);
+    int len = send_request("GET", "/fork", NULL, 0, response, sizeof(response));
+    if (len <= 0 || !strstr(response, "200 OK") || !strstr(response, "legs=4")) {
+        printf("FAIL: fork/then (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    }
+    
+    /* Two stages and four legs are still one request, legs included */
+    buckets_account_t totals;
+    u64 requests = 0;
+    buckets_account_get_totals(&totals, &requests);
+    buckets_account_enable(false);
+    if (requests != 1 || totals.allocs < STAGE_LEGS) {
+        printf("FAIL: accounting saw %lu requests, %lu allocs\n",
+               (unsigned long)requests, (unsigned long)totals.allocs);
+        failures++;
+    }
+    
+    /* ... and it reaches the server metrics */
+    pthread_mutex_lock(&g_uv_metrics.lock);
+    u64 cost_count = g_uv_metrics.request_cost_count - cost_before;
+    u64 cost_allocs = g_uv_metrics.request_cost_max_allocs;
+    pthread_mutex_unlock(&g_uv_metrics.lock);
+    if (cost_count != 1 || cost_allocs < STAGE_LEGS) {
+        printf("FAIL: metrics saw %lu accounted requests, max %lu allocs\n",
+               (unsigned long)cost_count, (unsigned long)cost_allocs);
+        failures++;
+    }
+    
+    /* suspend/resume: the next stage waits for the resume */
+    len = send_request("GET", "/suspend", NULL, 0, response, sizeof(response));
+    if (len <= 0 || !strstr(response, "resumed")) {
+        printf("FAIL: suspend/resume (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    }
+    
+    /* Client gone mid-stage: the next stage still runs, told it is
+     * cancelled, and the connection is freed only once it unwinds */
+    if (send_and_disconnect("/disconnect") != 0) {
+        printf("FAIL: could not send the disconnect request\n");
+        failures++;
+    } else if (!wait_until(&stage_state.cancel_ran, 2000)) {
+        printf("FAIL: stage after disconnect never ran\n");
+        failures++;
+    } else if (!stage_state.cancel_seen) {
+        printf("FAIL: stage after disconnect was not told it was cancelled\n");
+        failures++;
+    }
+    
+    /* The deferred free happened: no connection is left behind */
+    int remaining = -1;
+    for (int waited = 0; waited < 2000; waited += 10) {
+        remaining = __atomic_load_n(&server->connection_count, __ATOMIC_ACQUIRE);
+        if (remaining == 0) {
+            break;
+        }
+        usleep(10000);
+    }
+    if (remaining != 0) {
+        printf("FAIL: %d connections still open after the disconnect\n", remaining);
+        failures++;
+    }
+    
+    /* The server keeps serving afterwards */
+    len = send_request("GET", "/plain", NULL, 0, response, sizeof(response));
+    if (len <= 0 || !strstr(response, "plain")) {
+        printf("FAIL: request after disconnect (%s)\n", len > 0 ? response : "no response");
+        failures++;
+    }
+    
+    uv_http_server_stop(server);
+    uv_http_server_free(server);
+    
+    if (failures == 0) {
+        printf("PASS: test_resumable_handlers\n");
+    }
+    return failures;
+}
+
 int main(void)
 {
     printf("=== UV HTTP Server Tests ===\n\n");
@@ -664,6 +1362,11 @@ int main(void)
     uv_http_server_stop(server);
     uv_http_server_free(server);
     
+    failures += test_tenant_qos();
+    failures += test_priority_lanes();
+    failures += test_resumable_handlers();
+    failures += run_tls_tests();
+    
     printf("\n=== Results: %d failures ===\n", failures);
     
     return failures > 0 ? 1 : 0;
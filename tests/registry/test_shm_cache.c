@@ -0,0 +1,197 @@
+/**
+ * Shared-Memory Cache Tests
+ *
+ * Unit tests for the cache shared by forked workers.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "buckets.h"
+#include "buckets_shm_cache.h"
+#include "buckets_registry.h"
+
+static buckets_shm_cache_t *g_cache;
+
+void setup(void) {
+    buckets_init();
+    g_cache = buckets_shm_cache_create("test", 64, 64, 128, 0);
+    cr_assert_not_null(g_cache);
+}
+
+void teardown(void) {
+    buckets_shm_cache_destroy(g_cache);
+    buckets_cleanup();
+}
+
+TestSuite(shm_cache, .init = setup, .fini = teardown);
+
+static bool get_string(buckets_shm_cache_t *cache, const char *key, char *out) {
+    u32 len = 0;
+    if (!buckets_shm_cache_get(cache, key, out, 128, &len)) {
+        return false;
+    }
+    out[len] = '\0';
+    return true;
+}
+
+/* ===================================================================
+ * Basic Operation Tests
+ * ===================================================================*/
+
+Test(shm_cache, put_get_invalidate) {
+    char value[129];
+    cr_assert_eq(buckets_shm_cache_put(g_cache, "a/b", "loc1", 4), BUCKETS_OK);
+    cr_assert(get_string(g_cache, "a/b", value));
+    cr_assert_str_eq(value, "loc1");
+
+    cr_assert_eq(buckets_shm_cache_put(g_cache, "a/b", "loc2", 4), BUCKETS_OK);
+    cr_assert(get_string(g_cache, "a/b", value));
+    cr_assert_str_eq(value, "loc2");
+
+    cr_assert(buckets_shm_cache_invalidate(g_cache, "a/b"));
+    cr_assert_not(get_string(g_cache, "a/b", value));
+
+    buckets_shm_cache_stats_t stats;
+    buckets_shm_cache_get_stats(g_cache, &stats);
+    cr_assert_eq(stats.hits, 2);
+    cr_assert_eq(stats.misses, 1);
+    cr_assert_eq(stats.entries, 0);
+}
+
+Test(shm_cache, oversized_entries_are_skipped) {
+    char long_key[100];
+    memset(long_key, 'k', sizeof(long_key) - 1);
+    long_key[sizeof(long_key) - 1] = '\0';
+    char big[200] = {0};
+
+    cr_assert_eq(buckets_shm_cache_put(g_cache, long_key, "x", 1), BUCKETS_ERR_LIMIT);
+    cr_assert_eq(buckets_shm_cache_put(g_cache, "key", big, sizeof(big)), BUCKETS_ERR_LIMIT);
+
+    buckets_shm_cache_stats_t stats;
+    buckets_shm_cache_get_stats(g_cache, &stats);
+    cr_assert_eq(stats.oversized, 2);
+    cr_assert_eq(stats.entries, 0);
+}
+
+Test(shm_cache, full_cache_evicts) {
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "obj-%d", i);
+        cr_assert_eq(buckets_shm_cache_put(g_cache, key, &i, sizeof(i)), BUCKETS_OK);
+    }
+
+    buckets_shm_cache_stats_t stats;
+    buckets_shm_cache_get_stats(g_cache, &stats);
+    cr_assert_eq(stats.capacity, 64);
+    cr_assert_leq(stats.entries, 64);
+    cr_assert_eq(stats.evictions, 1000 - stats.entries);
+
+    /* The most recent insert always survives */
+    int value = 0;
+    cr_assert(buckets_shm_cache_get(g_cache, "obj-999", &value, sizeof(value), NULL));
+    cr_assert_eq(value, 999);
+}
+
+Test(shm_cache, entries_expire) {
+    buckets_shm_cache_t *cache = buckets_shm_cache_create("ttl", 8, 16, 16, 1);
+    cr_assert_eq(buckets_shm_cache_put(cache, "k", "v", 1), BUCKETS_OK);
+    char value[16];
+    cr_assert(buckets_shm_cache_get(cache, "k", value, sizeof(value), NULL));
+    sleep(2);
+    cr_assert_not(buckets_shm_cache_get(cache, "k", value, sizeof(value), NULL));
+    buckets_shm_cache_destroy(cache);
+}
+
+Test(shm_cache, clear_drops_everything) {
+    buckets_shm_cache_put(g_cache, "one", "1", 1);
+    buckets_shm_cache_put(g_cache, "two", "2", 1);
+    buckets_shm_cache_clear(g_cache);
+
+    char value[129];
+    cr_assert_not(get_string(g_cache, "one", value));
+    cr_assert_not(get_string(g_cache, "two", value));
+}
+
+/* ===================================================================
+ * Multi-Process Tests
+ * ===================================================================*/
+
+Test(shm_cache, forked_workers_share_entries) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* Worker: fill an entry and drop one the parent added */
+        buckets_shm_cache_put(g_cache, "from-child", "warm", 4);
+        buckets_shm_cache_invalidate(g_cache, "stale");
+        _exit(0);
+    }
+
+    buckets_shm_cache_put(g_cache, "stale", "old", 3);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    cr_assert(WIFEXITED(status));
+
+    char value[129];
+    cr_assert(get_string(g_cache, "from-child", value));
+    cr_assert_str_eq(value, "warm");
+}
+
+Test(shm_cache, concurrent_workers_keep_counts_consistent) {
+    pid_t pids[4];
+    for (int w = 0; w < 4; w++) {
+        pids[w] = fork();
+        if (pids[w] == 0) {
+            char key[32];
+            for (int i = 0; i < 2000; i++) {
+                snprintf(key, sizeof(key), "k%d", (i * 7 + w) % 200);
+                if (i % 3 == 0) {
+                    buckets_shm_cache_invalidate(g_cache, key);
+                } else {
+                    buckets_shm_cache_put(g_cache, key, &i, sizeof(i));
+                }
+            }
+            _exit(0);
+        }
+    }
+    for (int w = 0; w < 4; w++) {
+        waitpid(pids[w], NULL, 0);
+    }
+
+    /* Recount live entries through the public API */
+    u64 live = 0;
+    char key[32];
+    int value;
+    for (int i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        if (buckets_shm_cache_get(g_cache, key, &value, sizeof(value), NULL)) {
+            live++;
+        }
+    }
+    buckets_shm_cache_stats_t stats;
+    buckets_shm_cache_get_stats(g_cache, &stats);
+    cr_assert_eq(stats.entries, live);
+}
+
+/* ===================================================================
+ * Registry Integration Tests
+ * ===================================================================*/
+
+Test(shm_cache, registry_cache_can_be_shared) {
+    buckets_registry_config_t config = {
+        .cache_size = 1024,
+        .cache_ttl_seconds = 300,
+        .enable_cache = true
+    };
+    cr_assert_eq(buckets_registry_init(&config), 0);
+    cr_assert_eq(buckets_registry_cache_share(), 0);
+    cr_assert_eq(buckets_registry_cache_share(), 0);
+
+    cr_assert_eq(buckets_registry_cache_invalidate("bucket", "photo.jpg", NULL), -1);
+
+    buckets_registry_stats_t stats;
+    cr_assert_eq(buckets_registry_get_stats(&stats), 0);
+    cr_assert_eq(stats.total_entries, 0);
+    buckets_registry_cleanup();
+}
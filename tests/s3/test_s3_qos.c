@@ -0,0 +1,301 @@
+/**
+ * Tenant QoS Tests
+ *
+ * Tests for per-access-key and per-bucket request and bandwidth limits.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "buckets.h"
+#include "buckets_s3.h"
+
+void setup(void)
+{
+    buckets_init();
+}
+
+void teardown(void)
+{
+    buckets_s3_qos_cleanup();
+    buckets_cleanup();
+}
+
+TestSuite(s3_qos, .init = setup, .fini = teardown);
+
+static void qos_init(u32 key_rps, u64 key_bps, u32 bucket_rps, u64 bucket_bps)
+{
+    buckets_s3_qos_config_t config = {
+        .key_rps = key_rps,
+        .key_bps = key_bps,
+        .bucket_rps = bucket_rps,
+        .bucket_bps = bucket_bps,
+        .max_delay_ms = 500,
+    };
+    cr_assert_eq(buckets_s3_qos_init(&config), BUCKETS_OK);
+}
+
+static int admit(const char *key, const char *bucket)
+{
+    buckets_s3_qos_tenant_t *tenant = NULL;
+    return buckets_s3_qos_admit(key, bucket, &tenant);
+}
+
+static buckets_s3_qos_usage_t find_usage(const char *key, const char *bucket)
+{
+    static buckets_s3_qos_usage_t usage[16];
+    size_t n = buckets_s3_qos_get_usage(usage, 16);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(usage[i].access_key, key) == 0 && strcmp(usage[i].bucket, bucket) == 0) {
+            return usage[i];
+        }
+    }
+    cr_assert_fail("No usage for %s/%s", key, bucket);
+    return usage[0];
+}
+
+/* ===================================================================
+ * Identification Tests
+ * ===================================================================*/
+
+Test(s3_qos, identify_tenant) {
+    char key[128], bucket[64];
+
+    buckets_s3_qos_identify("AWS4-HMAC-SHA256 Credential=AKIDV4/20260101/us-east-1/s3/aws4_request, "
+                            "SignedHeaders=host, Signature=abc",
+                            "/photos/2026/a.jpg", key, sizeof(key), bucket, sizeof(bucket));
+    cr_assert_str_eq(key, "AKIDV4");
+    cr_assert_str_eq(bucket, "photos");
+
+    buckets_s3_qos_identify("AWS AKIDV2:c2lnbmF0dXJl", "/logs?list-type=2",
+                            key, sizeof(key), bucket, sizeof(bucket));
+    cr_assert_str_eq(key, "AKIDV2");
+    cr_assert_str_eq(bucket, "logs");
+
+    buckets_s3_qos_identify(NULL, "/data/obj?X-Amz-Algorithm=AWS4-HMAC-SHA256"
+                            "&X-Amz-Credential=AKIDPRE%2F20260101%2Fus-east-1",
+                            key, sizeof(key), bucket, sizeof(bucket));
+    cr_assert_str_eq(key, "AKIDPRE");
+    cr_assert_str_eq(bucket, "data");
+
+    buckets_s3_qos_identify(NULL, "/", key, sizeof(key), bucket, sizeof(bucket));
+    cr_assert_str_eq(key, "anonymous");
+    cr_assert_str_eq(bucket, "");
+
+    buckets_s3_qos_identify("AWS AKIDV2:sig", "/_admin/qos", key, sizeof(key), bucket, sizeof(bucket));
+    cr_assert_str_eq(bucket, "");
+
+    buckets_s3_qos_identify_client("10.0.0.7", key, sizeof(key));
+    cr_assert_str_eq(key, "anonymous@10.0.0.7");
+    buckets_s3_qos_identify_client(NULL, key, sizeof(key));
+    cr_assert_str_eq(key, "anonymous");
+}
+
+static bool has_usage(const buckets_s3_qos_usage_t *usage, size_t n, const char *key)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(usage[i].access_key, key) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===================================================================
+ * Admission Tests
+ * ===================================================================*/
+
+Test(s3_qos, disabled_admits_everything) {
+    qos_init(0, 0, 0, 0);
+    cr_assert_not(buckets_s3_qos_enabled());
+
+    buckets_s3_qos_tenant_t *tenant = (void*)1;
+    for (int i = 0; i < 1000; i++) {
+        cr_assert_eq(buckets_s3_qos_admit("k", "b", &tenant), BUCKETS_OK);
+    }
+    cr_assert_null(tenant);
+    cr_assert_eq(buckets_s3_qos_charge(tenant, 1 << 20, true), 0);
+}
+
+Test(s3_qos, request_rate_per_key) {
+    qos_init(10, 0, 0, 0);
+
+    int admitted = 0;
+    for (int i = 0; i < 20; i++) {
+        if (admit("alice", "b1") == BUCKETS_OK) {
+            admitted++;
+        }
+    }
+    cr_assert_eq(admitted, 10);
+    cr_assert_eq(admit("alice", "b2"), BUCKETS_ERR_LIMIT);
+
+    /* Other tenants are unaffected */
+    cr_assert_eq(admit("bob", "b1"), BUCKETS_OK);
+
+    /* Refills at the configured rate */
+    usleep(250 * 1000);
+    cr_assert_eq(admit("alice", "b1"), BUCKETS_OK);
+
+    buckets_s3_qos_usage_t key = find_usage("alice", "");
+    cr_assert_eq(key.requests, 11);
+    cr_assert_eq(key.rejected, 11);
+}
+
+Test(s3_qos, bucket_limit_under_key_limit) {
+    qos_init(100, 0, 5, 0);
+
+    for (int i = 0; i < 5; i++) {
+        cr_assert_eq(admit("alice", "hot"), BUCKETS_OK);
+    }
+    cr_assert_eq(admit("alice", "hot"), BUCKETS_ERR_LIMIT);
+    cr_assert_eq(admit("alice", "cold"), BUCKETS_OK);
+
+    /* A bucket refusal gives back nothing it did not take from the key */
+    buckets_s3_qos_usage_t key = find_usage("alice", "");
+    cr_assert_eq(key.requests, 6);
+    cr_assert_eq(key.rejected, 1);
+    buckets_s3_qos_usage_t hot = find_usage("alice", "hot");
+    cr_assert_eq(hot.requests, 5);
+    cr_assert_eq(hot.rejected, 1);
+}
+
+Test(s3_qos, key_refusal_returns_bucket_token) {
+    qos_init(10, 0, 1, 0);
+
+    for (int i = 0; i < 10; i++) {
+        char bucket[16];
+        snprintf(bucket, sizeof(bucket), "b%d", i);
+        cr_assert_eq(admit("alice", bucket), BUCKETS_OK);
+    }
+    cr_assert_eq(admit("alice", "x"), BUCKETS_ERR_LIMIT);
+
+    /* The key refills long before "x" would have on its own */
+    usleep(150 * 1000);
+    cr_assert_eq(admit("alice", "x"), BUCKETS_OK);
+}
+
+Test(s3_qos, unverified_requests_charge_the_client) {
+    qos_init(2, 0, 0, 0);
+
+    /* A flood naming alice's key is charged to its address */
+    buckets_s3_qos_tenant_t *anon = NULL;
+    cr_assert_eq(buckets_s3_qos_admit("anonymous@10.0.0.7", "", &anon), BUCKETS_OK);
+    cr_assert_eq(admit("anonymous@10.0.0.7", ""), BUCKETS_OK);
+    cr_assert_eq(admit("anonymous@10.0.0.7", ""), BUCKETS_ERR_LIMIT);
+
+    /* Once verified the request moves onto alice and off the address */
+    buckets_s3_qos_tenant_t *tenant = NULL;
+    cr_assert_eq(buckets_s3_qos_authenticate(anon, "alice", "b", &tenant), BUCKETS_OK);
+    cr_assert_not_null(tenant);
+    buckets_s3_qos_release(anon);
+    cr_assert_eq(admit("anonymous@10.0.0.7", ""), BUCKETS_OK);
+
+    buckets_s3_qos_usage_t key = find_usage("alice", "");
+    cr_assert_eq(key.requests, 1);
+    buckets_s3_qos_usage_t client = find_usage("anonymous@10.0.0.7", "");
+    cr_assert_eq(client.requests, 2);
+    cr_assert_eq(client.rejected, 1);
+    buckets_s3_qos_release(tenant);
+}
+
+Test(s3_qos, idle_tenants_are_evicted) {
+    buckets_s3_qos_config_t config = { .key_rps = 100, .idle_ms = 200 };
+    cr_assert_eq(buckets_s3_qos_init(&config), BUCKETS_OK);
+
+    /* One held tenant, then fill the table with made-up keys */
+    buckets_s3_qos_tenant_t *held = NULL;
+    cr_assert_eq(buckets_s3_qos_admit("held", "", &held), BUCKETS_OK);
+    for (int i = 1; i < BUCKETS_S3_QOS_MAX_TENANTS; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "fake%d", i);
+        buckets_s3_qos_tenant_t *t = NULL;
+        cr_assert_eq(buckets_s3_qos_admit(key, "", &t), BUCKETS_OK);
+        buckets_s3_qos_release(t);
+    }
+
+    /* Full and nothing idle yet: the newcomer shares the overflow tenant */
+    cr_assert_eq(admit("early", ""), BUCKETS_OK);
+
+    usleep(300 * 1000);
+    buckets_s3_qos_tenant_t *t = NULL;
+    cr_assert_eq(buckets_s3_qos_admit("real", "b", &t), BUCKETS_OK);
+    buckets_s3_qos_release(t);
+
+    size_t max = BUCKETS_S3_QOS_MAX_TENANTS + 1;
+    buckets_s3_qos_usage_t *usage = buckets_calloc(max, sizeof(*usage));
+    size_t n = buckets_s3_qos_get_usage(usage, max);
+    cr_assert(has_usage(usage, n, "real"));
+    cr_assert(has_usage(usage, n, "held"));
+    cr_assert(has_usage(usage, n, "*"));
+    cr_assert_not(has_usage(usage, n, "early"));
+
+    /* A key's totals still precede its buckets */
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(usage[i].access_key, "real") == 0) {
+            cr_assert_str_eq(usage[i].bucket, "");
+            cr_assert_str_eq(usage[i + 1].access_key, "real");
+            cr_assert_str_eq(usage[i + 1].bucket, "b");
+            break;
+        }
+    }
+    buckets_free(usage);
+    buckets_s3_qos_release(held);
+}
+
+/* ===================================================================
+ * Bandwidth Tests
+ * ===================================================================*/
+
+Test(s3_qos, bandwidth_charges_pause) {
+    qos_init(0, 1024 * 1024, 0, 0);
+
+    buckets_s3_qos_tenant_t *tenant = NULL;
+    cr_assert_eq(buckets_s3_qos_admit("alice", "b", &tenant), BUCKETS_OK);
+    cr_assert_not_null(tenant);
+
+    /* The one-second burst is free, the next half second is owed */
+    cr_assert_eq(buckets_s3_qos_charge(tenant, 1024 * 1024, true), 0);
+    u64 pause = buckets_s3_qos_charge(tenant, 512 * 1024, false);
+    cr_assert_geq(pause, 450 * 1000);
+    cr_assert_leq(pause, 500 * 1000);
+
+    buckets_s3_qos_usage_t key = find_usage("alice", "");
+    cr_assert_eq(key.bytes_in, 1024 * 1024);
+    cr_assert_eq(key.bytes_out, 512 * 1024);
+    cr_assert_eq(key.throttled, 1);
+    buckets_s3_qos_usage_t b = find_usage("alice", "b");
+    cr_assert_eq(b.bytes_in, 1024 * 1024);
+}
+
+Test(s3_qos, refuses_when_too_far_behind) {
+    qos_init(0, 0, 0, 1024 * 1024);
+
+    buckets_s3_qos_tenant_t *tenant = NULL;
+    cr_assert_eq(buckets_s3_qos_admit("alice", "big", &tenant), BUCKETS_OK);
+
+    /* Two seconds behind with a 500 ms limit */
+    u64 pause = buckets_s3_qos_charge(tenant, 3 * 1024 * 1024, true);
+    cr_assert_gt(pause, 500 * 1000);
+    cr_assert_eq(admit("alice", "big"), BUCKETS_ERR_LIMIT);
+    cr_assert_eq(admit("alice", "other"), BUCKETS_OK);
+}
+
+Test(s3_qos, env_limits_split_between_workers) {
+    setenv("BUCKETS_QOS_KEY_RPS", "9", 1);
+    setenv("BUCKETS_QOS_BUCKET_MBPS", "1", 1);
+    cr_assert_eq(buckets_s3_qos_init_from_env(3), BUCKETS_OK);
+    unsetenv("BUCKETS_QOS_KEY_RPS");
+    unsetenv("BUCKETS_QOS_BUCKET_MBPS");
+    cr_assert(buckets_s3_qos_enabled());
+
+    int admitted = 0;
+    for (int i = 0; i < 10; i++) {
+        if (admit("alice", "b") == BUCKETS_OK) {
+            admitted++;
+        }
+    }
+    cr_assert_eq(admitted, 3);
+}
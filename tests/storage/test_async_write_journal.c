@@ -0,0 +1,381 @@
+/**
+ * Async Write Journal Tests
+ *
+ * Unit tests for the write-ahead journal behind pipelined-ACK writes.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_async_write.h"
+
+static char g_dir[64];
+static char g_path[128];
+
+void setup(void) {
+    buckets_init();
+    snprintf(g_dir, sizeof(g_dir), "/tmp/buckets-journal-XXXXXX");
+    cr_assert_not_null(mkdtemp(g_dir));
+    snprintf(g_path, sizeof(g_path), "%s/%s", g_dir, BUCKETS_ASYNC_JOURNAL_FILE);
+}
+
+void teardown(void) {
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", g_dir);
+    (void)system(cmd);
+    buckets_cleanup();
+}
+
+TestSuite(async_write_journal, .init = setup, .fini = teardown);
+
+/* Build a 2+1 job whose chunk bytes are derived from its id */
+static async_write_job_t* make_job(u64 job_id, const char *object)
+{
+    async_write_job_t *job = buckets_calloc(1, sizeof(*job));
+    job->job_id = job_id;
+    snprintf(job->bucket, sizeof(job->bucket), "bucket");
+    snprintf(job->object, sizeof(job->object), "%s", object);
+    snprintf(job->object_path, sizeof(job->object_path), "ab/%s", object);
+    job->num_chunks = 3;
+    job->chunk_size = 4096;
+    job->chunk_data = buckets_calloc(job->num_chunks, sizeof(void *));
+    for (u32 i = 0; i < job->num_chunks; i++) {
+        job->chunk_data[i] = buckets_malloc(job->chunk_size);
+        memset(job->chunk_data[i], (int)(job_id * 7 + i), job->chunk_size);
+    }
+
+    buckets_placement_result_t *p = buckets_calloc(1, sizeof(*p));
+    p->disk_count = 3;
+    p->disk_paths = buckets_calloc(3, sizeof(char *));
+    p->disk_uuids = buckets_calloc(3, sizeof(char *));
+    p->disk_endpoints = buckets_calloc(3, sizeof(char *));
+    for (u32 i = 0; i < 3; i++) {
+        p->disk_paths[i] = buckets_format("/nonexistent/disk%u", i);
+        p->disk_uuids[i] = buckets_format("uuid-%u", i);
+        p->disk_endpoints[i] = buckets_strdup("");
+    }
+    job->placement = p;
+
+    job->meta.version = 1;
+    strcpy(job->meta.format, "xl");
+    strcpy(job->meta.stat.modTime, "2026-01-01T00:00:00Z");
+    job->meta.stat.size = 8192;
+    strcpy(job->meta.erasure.algorithm, "ReedSolomon");
+    job->meta.erasure.data = 2;
+    job->meta.erasure.parity = 1;
+    job->meta.erasure.blockSize = job->chunk_size;
+    job->meta.erasure.distribution = buckets_calloc(3, sizeof(u32));
+    job->meta.erasure.checksums = buckets_calloc(3, sizeof(buckets_checksum_t));
+    for (u32 i = 0; i < 3; i++) {
+        job->meta.erasure.distribution[i] = i + 1;
+        strcpy(job->meta.erasure.checksums[i].algo, "BLAKE2b-256");
+    }
+
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->cond, NULL);
+    return job;
+}
+
+static void free_list(async_write_job_t *job) {
+    while (job) {
+        async_write_job_t *next = job->next;
+        buckets_async_write_job_free(job);
+        job = next;
+    }
+}
+
+/* ===================================================================
+ * Append / Load Tests
+ * ===================================================================*/
+
+Test(async_write_journal, missing_file_has_no_pending_jobs) {
+    async_write_job_t *jobs = NULL;
+    size_t count = 99;
+    cr_assert_eq(buckets_async_journal_load(g_path, &jobs, &count, NULL), BUCKETS_OK);
+    cr_assert_eq(count, 0);
+    cr_assert_null(jobs);
+}
+
+Test(async_write_journal, pending_jobs_survive_reopen) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    cr_assert_not_null(j);
+
+    async_write_job_t *a = make_job(1, "a");
+    async_write_job_t *b = make_job(2, "b");
+    uint64_t seq = 0;
+    cr_assert_eq(buckets_async_journal_append(j, a, &seq), BUCKETS_OK);
+    cr_assert_eq(buckets_async_journal_append(j, b, &seq), BUCKETS_OK);
+    cr_assert_eq(buckets_async_journal_sync(j, seq), BUCKETS_OK);
+    cr_assert_eq(buckets_async_journal_complete(j, 1), BUCKETS_OK);
+    buckets_async_journal_close(j);
+
+    async_write_job_t *jobs = NULL;
+    size_t count = 0;
+    cr_assert_eq(buckets_async_journal_load(g_path, &jobs, &count, NULL), BUCKETS_OK);
+    cr_assert_eq(count, 1);
+    cr_assert_eq(jobs->job_id, 2);
+    cr_assert_str_eq(jobs->object, "b");
+    cr_assert_str_eq(jobs->object_path, "ab/b");
+    cr_assert_eq(jobs->num_chunks, 3);
+    cr_assert_eq(jobs->placement->disk_count, 3);
+    cr_assert_str_eq(jobs->placement->disk_uuids[2], "uuid-2");
+    cr_assert_str_eq(jobs->meta.stat.modTime, "2026-01-01T00:00:00Z");
+    for (u32 i = 0; i < 3; i++) {
+        cr_assert_eq(memcmp(jobs->chunk_data[i], b->chunk_data[i], b->chunk_size), 0);
+    }
+
+    free_list(jobs);
+    buckets_async_write_job_free(a);
+    buckets_async_write_job_free(b);
+}
+
+Test(async_write_journal, torn_tail_is_rolled_back) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    async_write_job_t *a = make_job(1, "a");
+    async_write_job_t *b = make_job(2, "b");
+    uint64_t seq = 0;
+    buckets_async_journal_append(j, a, &seq);
+    buckets_async_journal_append(j, b, &seq);
+    buckets_async_journal_sync(j, seq);
+    buckets_async_journal_close(j);
+
+    /* Simulate a crash in the middle of the second append */
+    struct stat st;
+    cr_assert_eq(stat(g_path, &st), 0);
+    cr_assert_eq(truncate(g_path, st.st_size - 100), 0);
+
+    async_write_job_t *jobs = NULL;
+    size_t count = 0, discarded = 0;
+    cr_assert_eq(buckets_async_journal_load(g_path, &jobs, &count, &discarded), BUCKETS_OK);
+    cr_assert_eq(count, 1);
+    cr_assert_eq(discarded, 1);
+    cr_assert_eq(jobs->job_id, 1);
+
+    free_list(jobs);
+    buckets_async_write_job_free(a);
+    buckets_async_write_job_free(b);
+}
+
+Test(async_write_journal, corrupt_payload_is_rolled_back) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    async_write_job_t *a = make_job(1, "a");
+    uint64_t seq = 0;
+    buckets_async_journal_append(j, a, &seq);
+    buckets_async_journal_sync(j, seq);
+    buckets_async_journal_close(j);
+
+    /* Flip a byte inside the chunk data */
+    int fd = open(g_path, O_RDWR);
+    cr_assert(fd >= 0);
+    struct stat st;
+    fstat(fd, &st);
+    char byte = 0x5a;
+    cr_assert_eq(pwrite(fd, &byte, 1, st.st_size - 10), 1);
+    close(fd);
+
+    async_write_job_t *jobs = NULL;
+    size_t count = 0;
+    cr_assert_eq(buckets_async_journal_load(g_path, &jobs, &count, NULL), BUCKETS_OK);
+    cr_assert_eq(count, 0);
+    cr_assert_null(jobs);
+
+    buckets_async_write_job_free(a);
+}
+
+/* ===================================================================
+ * Compaction / Group Commit Tests
+ * ===================================================================*/
+
+Test(async_write_journal, reopen_compacts_completed_records) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    uint64_t seq = 0;
+    for (u64 id = 1; id <= 4; id++) {
+        async_write_job_t *job = make_job(id, "obj");
+        buckets_async_journal_append(j, job, &seq);
+        buckets_async_write_job_free(job);
+    }
+    buckets_async_journal_sync(j, seq);
+    for (u64 id = 1; id <= 3; id++) {
+        buckets_async_journal_complete(j, id);
+    }
+    buckets_async_journal_close(j);
+
+    struct stat before, after;
+    stat(g_path, &before);
+
+    async_write_job_t *jobs = NULL;
+    size_t count = 0;
+    buckets_async_journal_load(g_path, &jobs, &count, NULL);
+    cr_assert_eq(count, 1);
+
+    j = buckets_async_journal_open(g_path, jobs);
+    cr_assert_not_null(j);
+    buckets_async_journal_stats_t stats;
+    buckets_async_journal_get_stats(j, &stats);
+    cr_assert_eq(stats.pending, 1);
+    buckets_async_journal_close(j);
+
+    stat(g_path, &after);
+    cr_assert_lt(after.st_size * 3, before.st_size);
+    free_list(jobs);
+
+    buckets_async_journal_load(g_path, &jobs, &count, NULL);
+    cr_assert_eq(count, 1);
+    cr_assert_eq(jobs->job_id, 4);
+    free_list(jobs);
+}
+
+typedef struct {
+    buckets_async_journal_t *journal;
+    u64 job_id;
+} appender_arg_t;
+
+static void* appender(void *arg) {
+    appender_arg_t *a = (appender_arg_t *)arg;
+    async_write_job_t *job = make_job(a->job_id, "concurrent");
+    uint64_t seq = 0;
+    cr_assert_eq(buckets_async_journal_append(a->journal, job, &seq), BUCKETS_OK);
+    cr_assert_eq(buckets_async_journal_sync(a->journal, seq), BUCKETS_OK);
+    buckets_async_write_job_free(job);
+    return NULL;
+}
+
+Test(async_write_journal, concurrent_appends_share_syncs) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    pthread_t threads[16];
+    appender_arg_t args[16];
+    for (int i = 0; i < 16; i++) {
+        args[i] = (appender_arg_t){ .journal = j, .job_id = (u64)i + 1 };
+        pthread_create(&threads[i], NULL, appender, &args[i]);
+    }
+    for (int i = 0; i < 16; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    buckets_async_journal_stats_t stats;
+    buckets_async_journal_get_stats(j, &stats);
+    cr_assert_eq(stats.appends, 16);
+    cr_assert_eq(stats.pending, 16);
+    cr_assert_leq(stats.syncs, 16);
+    buckets_async_journal_close(j);
+
+    async_write_job_t *jobs = NULL;
+    size_t count = 0;
+    buckets_async_journal_load(g_path, &jobs, &count, NULL);
+    cr_assert_eq(count, 16);
+    free_list(jobs);
+}
+
+/* ===================================================================
+ * Replay and Retry Tests
+ * ===================================================================*/
+
+/* Point a job's disks at <g_dir>/<name><i> */
+static void use_disks(async_write_job_t *job, const char *name) {
+    for (u32 i = 0; i < job->placement->disk_count; i++) {
+        buckets_free(job->placement->disk_paths[i]);
+        job->placement->disk_paths[i] = buckets_format("%s/%s%u", g_dir, name, i);
+    }
+}
+
+static void journal_job(async_write_job_t *job) {
+    buckets_async_journal_t *j = buckets_async_journal_open(g_path, NULL);
+    uint64_t seq = 0;
+    cr_assert_eq(buckets_async_journal_append(j, job, &seq), BUCKETS_OK);
+    cr_assert_eq(buckets_async_journal_sync(j, seq), BUCKETS_OK);
+    buckets_async_journal_close(j);
+}
+
+/* Write a newer xl.meta for the job's object to its first `copies` disks */
+static void write_newer_meta(const async_write_job_t *job, u32 copies) {
+    buckets_xl_meta_t newer = {0};
+    newer.version = 1;
+    strcpy(newer.format, "xl");
+    strcpy(newer.stat.modTime, "2026-06-01T00:00:00Z");
+    for (u32 i = 0; i < copies; i++) {
+        mkdir(job->placement->disk_paths[i], 0755);
+        cr_assert_eq(buckets_write_xl_meta(job->placement->disk_paths[i],
+                                           job->object_path, &newer), 0);
+    }
+}
+
+Test(async_write_journal, replay_drops_job_only_if_quorum_is_newer) {
+    setenv("BUCKETS_ASYNC_JOURNAL", g_path, 1);
+
+    /* Newer copy on one disk (below K=2): an unacknowledged write */
+    async_write_job_t *a = make_job(1, "minority");
+    use_disks(a, "m");
+    journal_job(a);
+    write_newer_meta(a, 1);
+    cr_assert_eq(buckets_async_write_init(1), BUCKETS_OK);
+    cr_assert_eq(buckets_async_write_replay(), 1);
+    buckets_async_write_shutdown();
+    buckets_async_write_job_free(a);
+    unlink(g_path);
+
+    /* Newer copy on K disks: the job was overtaken */
+    async_write_job_t *b = make_job(2, "quorum");
+    use_disks(b, "q");
+    journal_job(b);
+    write_newer_meta(b, 2);
+    cr_assert_eq(buckets_async_write_init(1), BUCKETS_OK);
+    cr_assert_eq(buckets_async_write_replay(), 0);
+
+    buckets_async_journal_stats_t stats;
+    buckets_async_write_journal_stats(&stats);
+    cr_assert_eq(stats.superseded, 1);
+    cr_assert_eq(stats.pending, 0);
+    buckets_async_write_shutdown();
+    buckets_async_write_job_free(b);
+    unsetenv("BUCKETS_ASYNC_JOURNAL");
+}
+
+Test(async_write_journal, failed_job_is_retried_at_runtime) {
+    setenv("BUCKETS_ASYNC_JOURNAL", g_path, 1);
+    cr_assert_eq(buckets_async_write_init(1), BUCKETS_OK);
+
+    /* Disks sit under a regular file, so the first attempt fails */
+    char blocker[128];
+    snprintf(blocker, sizeof(blocker), "%s/blocked", g_dir);
+    int fd = open(blocker, O_CREAT | O_WRONLY, 0644);
+    cr_assert_geq(fd, 0);
+    close(fd);
+
+    async_write_job_t *job = make_job(1, "retry");
+    use_disks(job, "blocked/d");
+    cr_assert_eq(buckets_async_write_queue(job->bucket, job->object, job->object_path,
+                                           job->placement, job->chunk_data, job->chunk_size,
+                                           job->num_chunks, &job->meta, NULL), BUCKETS_OK);
+    job->placement = NULL;
+    job->chunk_data = NULL;
+
+    uint64_t failed = 0, completed = 0;
+    for (int i = 0; i < 100 && failed == 0; i++) {
+        usleep(10000);
+        buckets_async_write_stats(NULL, NULL, &failed, NULL);
+    }
+    cr_assert_geq(failed, 1);
+
+    /* Disks become writable: the retry lands without a restart */
+    unlink(blocker);
+    mkdir(blocker, 0755);
+    for (int i = 0; i < 300 && completed == 0; i++) {
+        usleep(10000);
+        buckets_async_write_stats(NULL, &completed, NULL, NULL);
+    }
+    cr_assert_eq(completed, 1);
+
+    buckets_async_journal_stats_t stats;
+    buckets_async_write_journal_stats(&stats);
+    cr_assert_eq(stats.pending, 0);
+
+    buckets_async_write_shutdown();
+    buckets_async_write_job_free(job);
+    unsetenv("BUCKETS_ASYNC_JOURNAL");
+}
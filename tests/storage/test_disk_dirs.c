@@ -0,0 +1,252 @@
+/**
+ * Disk Directory Handle Tests
+ *
+ * Unit tests for per-disk directory fds and *at() object file I/O.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+static char g_disk[64];
+
+void setup(void) {
+    buckets_init();
+    snprintf(g_disk, sizeof(g_disk), "/tmp/buckets-test-diskdirs-%d", getpid());
+    mkdir(g_disk, 0755);
+}
+
+void teardown(void) {
+    buckets_disk_dirs_close_all();
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", g_disk);
+    cr_assert_eq(system(cmd), 0);
+    buckets_cleanup();
+}
+
+TestSuite(disk_dirs, .init = setup, .fini = teardown);
+
+static bool path_exists(const char *rel) {
+    char path[256];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", g_disk, rel);
+    return stat(path, &st) == 0;
+}
+
+/* ===================================================================
+ * Disk Open Tests
+ * ===================================================================*/
+
+Test(disk_dirs, open_creates_prefix_directories) {
+    cr_assert_eq(buckets_disk_dirs_open(g_disk), BUCKETS_OK);
+    cr_assert_eq(buckets_disk_dirs_open(g_disk), BUCKETS_OK);
+    cr_assert(path_exists("00"));
+    cr_assert(path_exists("7f"));
+    cr_assert(path_exists("ff"));
+}
+
+Test(disk_dirs, missing_disk_is_not_opened) {
+    cr_assert_eq(buckets_disk_dirs_open("/tmp/buckets-test-diskdirs-missing/x"),
+                 BUCKETS_ERR_IO);
+}
+
+Test(disk_dirs, object_at_resolves_relative_name) {
+    char rel[256];
+    int fd = buckets_disk_object_at(g_disk, "a7/a7b3c9d2e5f81234/", "part.3",
+                                    rel, sizeof(rel));
+    cr_assert_geq(fd, 0);
+    cr_assert_str_eq(rel, "a7b3c9d2e5f81234/part.3");
+
+    /* Not under a prefix directory: callers fall back to paths */
+    cr_assert_eq(buckets_disk_object_at(g_disk, ".buckets.sys/", "format.json",
+                                        rel, sizeof(rel)), -1);
+}
+
+/* ===================================================================
+ * File Operation Tests
+ * ===================================================================*/
+
+Test(disk_dirs, write_read_roundtrip_creates_object_dir) {
+    const char *object_path = "3c/3c00112233445566/";
+    const char *json = "{\"version\":1}";
+    cr_assert_eq(buckets_disk_write_file(g_disk, object_path, "xl.meta",
+                                         json, strlen(json)), BUCKETS_OK);
+    cr_assert(path_exists("3c/3c00112233445566/xl.meta"));
+
+    void *data = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_disk_read_file(g_disk, object_path, "xl.meta", &data, &size),
+                 BUCKETS_OK);
+    cr_assert_eq(size, strlen(json));
+    cr_assert_str_eq((char*)data, json);
+    buckets_free(data);
+
+    cr_assert_neq(buckets_disk_read_file(g_disk, object_path, "part.1", &data, &size),
+                  BUCKETS_OK);
+    cr_assert_null(data);
+}
+
+Test(disk_dirs, openat_create_rename_unlink_rmdir) {
+    const char *object_path = "e0/e0ffeeddccbbaa99/";
+    int fd = buckets_disk_openat(g_disk, object_path, "xl.meta.tmp",
+                                 O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    cr_assert_geq(fd, 0);
+    cr_assert_eq(write(fd, "x", 1), 1);
+    close(fd);
+
+    cr_assert_eq(buckets_disk_rename_file(g_disk, object_path, "xl.meta.tmp", "xl.meta"), 0);
+    cr_assert(path_exists("e0/e0ffeeddccbbaa99/xl.meta"));
+    cr_assert_not(path_exists("e0/e0ffeeddccbbaa99/xl.meta.tmp"));
+
+    /* Not empty yet */
+    cr_assert_eq(buckets_disk_rmdir_object(g_disk, object_path), -1);
+    cr_assert_eq(buckets_disk_unlink_file(g_disk, object_path, "xl.meta"), 0);
+    cr_assert_eq(buckets_disk_rmdir_object(g_disk, object_path), 0);
+    cr_assert_not(path_exists("e0/e0ffeeddccbbaa99"));
+}
+
+Test(disk_dirs, versioned_paths_create_nested_dirs) {
+    const char *version_path = "5a/5a0123456789abcd//versions/v1";
+    cr_assert_eq(buckets_disk_mkdir_object(g_disk, version_path), 0);
+    cr_assert(path_exists("5a/5a0123456789abcd/versions/v1"));
+}
+
+Test(disk_dirs, create_object_dir_uses_prefix_fd) {
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("bucket", "key", object_path, sizeof(object_path));
+
+    extern int buckets_create_object_dir(const char *disk_path, const char *object_path);
+    cr_assert_eq(buckets_create_object_dir(g_disk, object_path), 0);
+    cr_assert_eq(buckets_create_object_dir(g_disk, object_path), 0);
+    cr_assert(path_exists(object_path));
+}
+
+/* ===================================================================
+ * Preallocation Tests
+ * ===================================================================*/
+
+static int create_file(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", g_disk, name);
+    return open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+}
+
+Test(disk_dirs, prepare_file_preallocates_final_size) {
+    int fd = create_file("part.1");
+    cr_assert_geq(fd, 0);
+
+    buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_SHARD, 1024 * 1024, false);
+
+    struct stat st;
+    cr_assert_eq(fstat(fd, &st), 0);
+    /* Filesystems without fallocate leave the file empty */
+    cr_assert(st.st_size == 1024 * 1024 || st.st_size == 0);
+    if (st.st_size > 0) {
+        cr_assert_geq((size_t)st.st_blocks * 512, (size_t)1024 * 1024);
+    }
+    close(fd);
+}
+
+Test(disk_dirs, prepare_file_keep_size_reserves_only) {
+    int fd = create_file("part.2");
+    cr_assert_geq(fd, 0);
+
+    buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_SHARD, 1024 * 1024, true);
+
+    struct stat st;
+    cr_assert_eq(fstat(fd, &st), 0);
+    cr_assert_eq(st.st_size, 0);
+    close(fd);
+}
+
+Test(disk_dirs, prepare_file_skips_small_files) {
+    int fd = create_file("xl.meta");
+    cr_assert_geq(fd, 0);
+
+    buckets_disk_prepare_file(fd, BUCKETS_FILE_LIFE_METADATA, 512, false);
+    buckets_disk_prepare_file(-1, BUCKETS_FILE_LIFE_METADATA, 512, false);
+
+    struct stat st;
+    cr_assert_eq(fstat(fd, &st), 0);
+    cr_assert_eq(st.st_size, 0);
+    close(fd);
+}
+
+Test(disk_dirs, write_file_leaves_exact_size) {
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("bucket", "big", object_path, sizeof(object_path));
+
+    size_t size = 300 * 1024;
+    char *data = buckets_malloc(size);
+    memset(data, 'z', size);
+    cr_assert_eq(buckets_disk_write_file(g_disk, object_path, "part.1", data, size),
+                 BUCKETS_OK);
+
+    void *back = NULL;
+    size_t back_size = 0;
+    cr_assert_eq(buckets_disk_read_file(g_disk, object_path, "part.1", &back, &back_size),
+                 BUCKETS_OK);
+    cr_assert_eq(back_size, size);
+    cr_assert_eq(memcmp(back, data, size), 0);
+    buckets_free(back);
+    buckets_free(data);
+}
+
+/* ===================================================================
+ * Drop / Reopen Tests
+ * ===================================================================*/
+
+Test(disk_dirs, dropped_disk_uses_paths_until_reopened) {
+    char rel[256];
+    const char *object_path = "5a/5a00112233445566/";
+    cr_assert_eq(buckets_disk_dirs_open(g_disk), BUCKETS_OK);
+    int fd = buckets_disk_object_at(g_disk, object_path, "xl.meta", rel, sizeof(rel));
+    cr_assert_geq(fd, 0);
+
+    buckets_disk_dirs_drop(g_disk);
+    cr_assert_eq(buckets_disk_object_at(g_disk, object_path, "xl.meta",
+                                        rel, sizeof(rel)), -1);
+
+    /* The old fd number no longer reaches the disk */
+    cr_assert_lt(openat(fd, ".", O_RDONLY | O_DIRECTORY), 0);
+
+    /* Path fallback still works */
+    cr_assert_eq(buckets_disk_write_file(g_disk, object_path, "xl.meta", "x", 1),
+                 BUCKETS_OK);
+    cr_assert(path_exists("5a/5a00112233445566/xl.meta"));
+
+    cr_assert_eq(buckets_disk_dirs_reopen(g_disk), BUCKETS_OK);
+    cr_assert_eq(buckets_disk_object_at(g_disk, object_path, "xl.meta",
+                                        rel, sizeof(rel)), fd);
+    cr_assert_eq(faccessat(fd, rel, F_OK, 0), 0);
+}
+
+Test(disk_dirs, replaced_root_is_reopened) {
+    char rel[256];
+    char old[96];
+    const char *object_path = "5b/5b00112233445566/";
+    cr_assert_eq(buckets_disk_dirs_open(g_disk), BUCKETS_OK);
+
+    /* Swap a new directory in under the same path, as a remount would */
+    snprintf(old, sizeof(old), "%s.old", g_disk);
+    cr_assert_eq(rename(g_disk, old), 0);
+    cr_assert_eq(mkdir(g_disk, 0755), 0);
+    usleep((BUCKETS_DISK_DIRS_CHECK_MS + 100) * 1000);
+
+    cr_assert_eq(buckets_disk_write_file(g_disk, object_path, "xl.meta", "x", 1),
+                 BUCKETS_OK);
+    cr_assert(path_exists("5b/5b00112233445566/xl.meta"));
+    cr_assert_geq(buckets_disk_object_at(g_disk, object_path, "xl.meta",
+                                         rel, sizeof(rel)), 0);
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", old);
+    cr_assert_eq(system(cmd), 0);
+}
@@ -0,0 +1,396 @@
+/**
+ * GET Coalescing Tests
+ *
+ * Unit tests for single-flight reads of the same object.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_mem_budget.h"
+
+#define OBJ_SIZE 4096
+#define READERS  8
+
+/* Fake object read: counts calls and blocks until released */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int calls;
+    bool released;
+    int result;
+    char fill;
+} fake_read_t;
+
+static fake_read_t g_read;
+
+void setup(void) {
+    buckets_init();
+    memset(&g_read, 0, sizeof(g_read));
+    pthread_mutex_init(&g_read.lock, NULL);
+    pthread_cond_init(&g_read.cond, NULL);
+    g_read.fill = 'a';
+    buckets_get_coalesce_set_enabled(true);
+}
+
+void teardown(void) {
+    pthread_cond_destroy(&g_read.cond);
+    pthread_mutex_destroy(&g_read.lock);
+    buckets_cleanup();
+}
+
+TestSuite(get_coalesce, .init = setup, .fini = teardown);
+
+static int fake_fetch(void *arg, void **data, size_t *size) {
+    (void)arg;
+    pthread_mutex_lock(&g_read.lock);
+    g_read.calls++;
+    while (!g_read.released) {
+        pthread_cond_wait(&g_read.cond, &g_read.lock);
+    }
+    char fill = g_read.fill++;
+    int result = g_read.result;
+    pthread_mutex_unlock(&g_read.lock);
+
+    if (result != 0) {
+        return result;
+    }
+    *data = buckets_malloc(OBJ_SIZE);
+    memset(*data, fill, OBJ_SIZE);
+    *size = OBJ_SIZE;
+    return 0;
+}
+
+static void release_reads(void) {
+    pthread_mutex_lock(&g_read.lock);
+    g_read.released = true;
+    pthread_cond_broadcast(&g_read.cond);
+    pthread_mutex_unlock(&g_read.lock);
+}
+
+static int fetch_calls(void) {
+    pthread_mutex_lock(&g_read.lock);
+    int calls = g_read.calls;
+    pthread_mutex_unlock(&g_read.lock);
+    return calls;
+}
+
+typedef struct {
+    const char *object;
+    const char *version;
+    int ret;
+    void *data;
+    size_t size;
+} reader_t;
+
+static void* reader(void *arg) {
+    reader_t *r = (reader_t *)arg;
+    r->ret = buckets_get_coalesce_do("bucket", r->object, r->version,
+                                     fake_fetch, NULL, &r->data, &r->size);
+    return NULL;
+}
+
+/* Wait until the stats show the expected number of attached followers */
+static void wait_for_followers(u64 base, u64 count) {
+    for (int i = 0; i < 5000; i++) {
+        buckets_get_coalesce_stats_t stats;
+        buckets_get_coalesce_get_stats(&stats);
+        if (stats.followers - base >= count) {
+            return;
+        }
+        usleep(1000);
+    }
+    cr_assert_fail("followers never attached");
+}
+
+static u64 followers_now(void) {
+    buckets_get_coalesce_stats_t stats;
+    buckets_get_coalesce_get_stats(&stats);
+    return stats.followers;
+}
+
+/* ===================================================================
+ * Coalescing Tests
+ * ===================================================================*/
+
+Test(get_coalesce, lone_request_reads_directly) {
+    release_reads();
+    void *data = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_get_coalesce_do("bucket", "solo", NULL, fake_fetch, NULL,
+                                         &data, &size), 0);
+    cr_assert_eq(size, OBJ_SIZE);
+    cr_assert_eq(((char *)data)[0], 'a');
+    cr_assert_eq(fetch_calls(), 1);
+    buckets_free(data);
+}
+
+Test(get_coalesce, concurrent_requests_share_one_read) {
+    u64 base = followers_now();
+    pthread_t threads[READERS];
+    reader_t readers[READERS];
+    for (int i = 0; i < READERS; i++) {
+        readers[i] = (reader_t){ .object = "hot.jpg" };
+        pthread_create(&threads[i], NULL, reader, &readers[i]);
+    }
+
+    wait_for_followers(base, READERS - 1);
+    release_reads();
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    cr_assert_eq(fetch_calls(), 1);
+    for (int i = 0; i < READERS; i++) {
+        cr_assert_eq(readers[i].ret, 0);
+        cr_assert_eq(readers[i].size, OBJ_SIZE);
+        cr_assert_eq(((char *)readers[i].data)[OBJ_SIZE - 1], 'a');
+        for (int j = 0; j < i; j++) {
+            cr_assert_neq(readers[i].data, readers[j].data, "buffers must not be shared");
+        }
+    }
+    for (int i = 0; i < READERS; i++) {
+        buckets_free(readers[i].data);
+    }
+
+    buckets_get_coalesce_stats_t stats;
+    buckets_get_coalesce_get_stats(&stats);
+    cr_assert_eq(stats.in_flight, 0);
+}
+
+Test(get_coalesce, errors_reach_every_waiter) {
+    g_read.result = -2;
+    u64 base = followers_now();
+    pthread_t threads[3];
+    reader_t readers[3];
+    for (int i = 0; i < 3; i++) {
+        readers[i] = (reader_t){ .object = "deleted" };
+        pthread_create(&threads[i], NULL, reader, &readers[i]);
+    }
+
+    wait_for_followers(base, 2);
+    release_reads();
+    for (int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+        cr_assert_eq(readers[i].ret, -2);
+        cr_assert_null(readers[i].data);
+    }
+    cr_assert_eq(fetch_calls(), 1);
+}
+
+Test(get_coalesce, different_versions_read_separately) {
+    pthread_t threads[2];
+    reader_t readers[2] = {
+        { .object = "doc", .version = "v1" },
+        { .object = "doc", .version = "v2" },
+    };
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, reader, &readers[i]);
+    }
+    while (fetch_calls() < 2) {
+        usleep(1000);
+    }
+    release_reads();
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        buckets_free(readers[i].data);
+    }
+    cr_assert_eq(fetch_calls(), 2);
+}
+
+/* ===================================================================
+ * Non-Blocking Join Tests
+ * ===================================================================*/
+
+typedef struct {
+    int calls;
+    int result;
+    void *data;
+    size_t size;
+} joiner_t;
+
+static void on_landed(void *arg, int result, void *data, size_t size) {
+    joiner_t *j = (joiner_t *)arg;
+    j->calls++;
+    j->result = result;
+    j->data = data;
+    j->size = size;
+}
+
+Test(get_coalesce, joiners_are_called_back_when_leader_lands) {
+    buckets_get_flight_t *flight = NULL;
+    joiner_t joiners[3] = {0};
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "evented", NULL, on_landed,
+                                           &joiners[0], &flight), 0);
+    cr_assert_not_null(flight);
+
+    buckets_get_flight_t *other = NULL;
+    for (int i = 1; i < 3; i++) {
+        cr_assert_eq(buckets_get_coalesce_join("bucket", "evented", NULL, on_landed,
+                                               &joiners[i], &other), 1);
+        cr_assert_null(other);
+    }
+
+    /* A blocking reader attaches to the same flight */
+    pthread_t thread;
+    reader_t sync_reader = { .object = "evented" };
+    u64 base = followers_now();
+    pthread_create(&thread, NULL, reader, &sync_reader);
+    wait_for_followers(base, 1);
+
+    void *data = buckets_malloc(OBJ_SIZE);
+    memset(data, 'z', OBJ_SIZE);
+    size_t size = OBJ_SIZE;
+    buckets_get_coalesce_land(flight, 0, &data, &size);
+    pthread_join(thread, NULL);
+
+    cr_assert_eq(fetch_calls(), 0);
+    cr_assert_eq(sync_reader.ret, 0);
+    cr_assert_eq(((char *)sync_reader.data)[0], 'z');
+    for (int i = 1; i < 3; i++) {
+        cr_assert_eq(joiners[i].calls, 1);
+        cr_assert_eq(joiners[i].result, 0);
+        cr_assert_eq(joiners[i].size, OBJ_SIZE);
+        cr_assert_eq(((char *)joiners[i].data)[OBJ_SIZE - 1], 'z');
+        cr_assert_neq(joiners[i].data, data, "buffers must not be shared");
+        buckets_free(joiners[i].data);
+    }
+    cr_assert_eq(joiners[0].calls, 0, "the leader is not called back");
+    buckets_free(sync_reader.data);
+    buckets_free(data);
+
+    buckets_get_coalesce_stats_t stats;
+    buckets_get_coalesce_get_stats(&stats);
+    cr_assert_eq(stats.in_flight, 0);
+}
+
+Test(get_coalesce, failed_land_reports_error_to_joiners) {
+    buckets_get_flight_t *flight = NULL;
+    joiner_t joiner = {0};
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "gone", NULL, on_landed,
+                                           NULL, &flight), 0);
+    buckets_get_flight_t *other = NULL;
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "gone", NULL, on_landed,
+                                           &joiner, &other), 1);
+
+    buckets_get_coalesce_land(flight, -1, NULL, NULL);
+    cr_assert_eq(joiner.calls, 1);
+    cr_assert_eq(joiner.result, -1);
+    cr_assert_null(joiner.data);
+}
+
+Test(get_coalesce, joiner_copies_are_not_charged_to_the_leader) {
+    size_t big = 2 * BUCKETS_MEM_BUDGET_MIN_RESERVE;
+    buckets_mem_budget_init(64ULL * 1024 * 1024, 50);
+
+    buckets_get_flight_t *flight = NULL;
+    joiner_t joiners[3] = {0};
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "budgeted", NULL, on_landed,
+                                           &joiners[0], &flight), 0);
+    buckets_get_flight_t *other = NULL;
+    for (int i = 1; i < 3; i++) {
+        cr_assert_eq(buckets_get_coalesce_join("bucket", "budgeted", NULL, on_landed,
+                                               &joiners[i], &other), 1);
+    }
+
+    buckets_mem_budget_scope_begin();
+    void *data = buckets_malloc(big);
+    memset(data, 'b', big);
+    size_t size = big;
+    buckets_get_coalesce_land(flight, 0, &data, &size);
+    u64 charged = buckets_mem_budget_scope_end();
+
+    cr_assert_eq(charged, 0, "leader charged %llu bytes for joiner copies",
+                 (unsigned long long)charged);
+    for (int i = 1; i < 3; i++) {
+        cr_assert_eq(joiners[i].size, big);
+        buckets_free(joiners[i].data);
+    }
+    buckets_free(data);
+    buckets_mem_budget_cleanup();
+}
+
+/* ===================================================================
+ * Invalidation Tests
+ * ===================================================================*/
+
+Test(get_coalesce, request_after_put_does_not_join_old_read) {
+    pthread_t first;
+    reader_t old_read = { .object = "config" };
+    pthread_create(&first, NULL, reader, &old_read);
+    while (fetch_calls() < 1) {
+        usleep(1000);
+    }
+
+    /* PUT completes while the first GET is still reading */
+    buckets_get_coalesce_forget("bucket", "config");
+
+    pthread_t second;
+    reader_t new_read = { .object = "config" };
+    pthread_create(&second, NULL, reader, &new_read);
+    while (fetch_calls() < 2) {
+        usleep(1000);
+    }
+
+    release_reads();
+    pthread_join(first, NULL);
+    pthread_join(second, NULL);
+    cr_assert_neq(((char *)old_read.data)[0], ((char *)new_read.data)[0]);
+    buckets_free(old_read.data);
+    buckets_free(new_read.data);
+
+    buckets_get_coalesce_stats_t stats;
+    buckets_get_coalesce_get_stats(&stats);
+    cr_assert_geq(stats.detached, 1);
+}
+
+Test(get_coalesce, put_in_sibling_worker_detaches_old_read) {
+    /* Shared epochs are set up before the fork, as in BUCKETS_WORKERS mode */
+    buckets_get_coalesce_init_from_env();
+
+    buckets_get_flight_t *old_flight = NULL;
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "shared", NULL, on_landed,
+                                           NULL, &old_flight), 0);
+
+    /* Another worker handles the PUT */
+    pid_t pid = fork();
+    cr_assert_neq(pid, -1);
+    if (pid == 0) {
+        buckets_get_coalesce_forget("bucket", "shared");
+        _exit(0);
+    }
+    int status = 0;
+    cr_assert_eq(waitpid(pid, &status, 0), pid);
+
+    /* A later GET here starts its own read */
+    buckets_get_flight_t *new_flight = NULL;
+    cr_assert_eq(buckets_get_coalesce_join("bucket", "shared", NULL, on_landed,
+                                           NULL, &new_flight), 0);
+    cr_assert_not_null(new_flight);
+
+    buckets_get_coalesce_land(old_flight, -1, NULL, NULL);
+    buckets_get_coalesce_land(new_flight, -1, NULL, NULL);
+
+    buckets_get_coalesce_stats_t stats;
+    buckets_get_coalesce_get_stats(&stats);
+    cr_assert_eq(stats.in_flight, 0);
+    cr_assert_geq(stats.detached, 1);
+}
+
+Test(get_coalesce, disabled_reads_every_time) {
+    buckets_get_coalesce_set_enabled(false);
+    release_reads();
+    for (int i = 0; i < 3; i++) {
+        void *data = NULL;
+        size_t size = 0;
+        cr_assert_eq(buckets_get_coalesce_do("bucket", "obj", NULL, fake_fetch, NULL,
+                                             &data, &size), 0);
+        buckets_free(data);
+    }
+    cr_assert_eq(fetch_calls(), 3);
+}
@@ -0,0 +1,101 @@
+/**
+ * Disk I/O Priority Tests
+ *
+ * Unit tests for per-thread I/O classes. Best-effort priorities may be
+ * set by any process, so these run unprivileged.
+ */
+
+#include <criterion/criterion.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "buckets.h"
+#include "buckets_io_priority.h"
+#include "buckets_storage.h"
+
+/* Best-effort class, levels 0, 4 and 7 (<linux/ioprio.h>) */
+#define IOPRIO_BE_META      ((2 << 13) | 0)
+#define IOPRIO_BE_DEFAULT   ((2 << 13) | 4)
+#define IOPRIO_BE_BULK      ((2 << 13) | 7)
+
+void setup(void)
+{
+    buckets_init();
+}
+
+void teardown(void)
+{
+    buckets_cleanup();
+}
+
+TestSuite(io_priority, .init = setup, .fini = teardown);
+
+static long thread_ioprio(void)
+{
+    return syscall(SYS_ioprio_get, 1 /* IOPRIO_WHO_PROCESS */, 0);
+}
+
+static void* child_class(void *arg)
+{
+    *(buckets_io_class_t*)arg = buckets_io_class_get();
+    return NULL;
+}
+
+Test(io_priority, scope_sets_and_restores) {
+    cr_assert(buckets_io_priority_enabled());
+    cr_assert_eq(buckets_io_class_get(), BUCKETS_IO_CLASS_DEFAULT);
+    cr_assert_eq(buckets_io_class_sqe_ioprio(), IOPRIO_BE_DEFAULT);
+
+    buckets_io_class_t prev = buckets_io_class_set(BUCKETS_IO_CLASS_BULK);
+    cr_assert_eq(prev, BUCKETS_IO_CLASS_DEFAULT);
+    cr_assert_eq(thread_ioprio(), IOPRIO_BE_BULK);
+    cr_assert_eq(buckets_io_class_sqe_ioprio(), IOPRIO_BE_BULK);
+
+    /* Nested metadata scope */
+    prev = buckets_io_class_set(BUCKETS_IO_CLASS_META);
+    cr_assert_eq(prev, BUCKETS_IO_CLASS_BULK);
+    cr_assert_eq(thread_ioprio(), IOPRIO_BE_META);
+    buckets_io_class_set(prev);
+    cr_assert_eq(thread_ioprio(), IOPRIO_BE_BULK);
+
+    buckets_io_class_set(BUCKETS_IO_CLASS_DEFAULT);
+    cr_assert_eq(buckets_io_class_get(), BUCKETS_IO_CLASS_DEFAULT);
+    cr_assert_eq(buckets_io_class_sqe_ioprio(), IOPRIO_BE_DEFAULT);
+
+    buckets_io_priority_stats_t stats;
+    buckets_io_priority_get_stats(&stats);
+    cr_assert_eq(stats.bulk_scopes, 2);
+    cr_assert_eq(stats.meta_scopes, 1);
+    cr_assert_eq(stats.failures, 0);
+}
+
+Test(io_priority, threads_inherit_class) {
+    buckets_io_class_set(BUCKETS_IO_CLASS_BULK);
+
+    pthread_t thread;
+    buckets_io_class_t seen = BUCKETS_IO_CLASS_DEFAULT;
+    pthread_create(&thread, NULL, child_class, &seen);
+    pthread_join(thread, NULL);
+    cr_assert_eq(seen, BUCKETS_IO_CLASS_BULK);
+
+    buckets_io_class_set(BUCKETS_IO_CLASS_DEFAULT);
+    pthread_create(&thread, NULL, child_class, &seen);
+    pthread_join(thread, NULL);
+    cr_assert_eq(seen, BUCKETS_IO_CLASS_DEFAULT);
+}
+
+Test(io_priority, metadata_runs_in_meta_class) {
+    buckets_io_class_set(BUCKETS_IO_CLASS_BULK);
+
+    buckets_io_priority_stats_t before, after;
+    buckets_io_priority_get_stats(&before);
+    buckets_delete_xl_meta("/nonexistent-disk", "bucket/object/");
+    buckets_io_priority_get_stats(&after);
+
+    /* Raised for the call, back to bulk afterwards */
+    cr_assert_eq(after.meta_scopes, before.meta_scopes + 1);
+    cr_assert_eq(buckets_io_class_get(), BUCKETS_IO_CLASS_BULK);
+    cr_assert_eq(thread_ioprio(), IOPRIO_BE_BULK);
+}
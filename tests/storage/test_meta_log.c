@@ -0,0 +1,333 @@
+/**
+ * Metadata Log Tests
+ *
+ * Unit tests for the per-disk append-only xl.meta log.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+static char g_disk[64];
+
+void setup(void) {
+    buckets_init();
+    snprintf(g_disk, sizeof(g_disk), "/tmp/buckets-test-metalog-%d", getpid());
+    mkdir(g_disk, 0755);
+    buckets_meta_log_set_enabled(true);
+}
+
+void teardown(void) {
+    buckets_meta_log_close_all();
+    buckets_disk_dirs_close_all();
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", g_disk);
+    cr_assert_eq(system(cmd), 0);
+    buckets_cleanup();
+}
+
+TestSuite(meta_log, .init = setup, .fini = teardown);
+
+static void object_path(const char *key, char *path, size_t len) {
+    buckets_compute_object_path("bucket", key, path, len);
+}
+
+static char* get_json(const char *path) {
+    char *json = NULL;
+    size_t len = 0;
+    if (buckets_meta_log_get(g_disk, path, &json, &len) != BUCKETS_OK) {
+        return NULL;
+    }
+    cr_assert_eq(strlen(json), len);
+    return json;
+}
+
+/* ===================================================================
+ * Record Tests
+ * ===================================================================*/
+
+Test(meta_log, put_get_roundtrip) {
+    char path[64];
+    object_path("a", path, sizeof(path));
+
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{\"v\":1}", 7), BUCKETS_OK);
+    char *json = get_json(path);
+    cr_assert_not_null(json);
+    cr_assert_str_eq(json, "{\"v\":1}");
+    buckets_free(json);
+
+    /* No xl.meta file and no object directory */
+    char file[256];
+    struct stat st;
+    snprintf(file, sizeof(file), "%s/%s", g_disk, path);
+    cr_assert_neq(stat(file, &st), 0);
+}
+
+Test(meta_log, overwrite_and_delete) {
+    char path[64];
+    object_path("b", path, sizeof(path));
+
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{\"v\":1}", 7), BUCKETS_OK);
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{\"v\":22}", 8), BUCKETS_OK);
+    char *json = get_json(path);
+    cr_assert_str_eq(json, "{\"v\":22}");
+    buckets_free(json);
+
+    cr_assert(buckets_meta_log_contains(g_disk, path));
+    cr_assert_eq(buckets_meta_log_delete(g_disk, path), BUCKETS_OK);
+    cr_assert_not(buckets_meta_log_contains(g_disk, path));
+    cr_assert_eq(buckets_meta_log_delete(g_disk, path), BUCKETS_ERR_NOT_FOUND);
+
+    char *missing = NULL;
+    size_t len = 0;
+    cr_assert_eq(buckets_meta_log_get(g_disk, path, &missing, &len), BUCKETS_ERR_NOT_FOUND);
+}
+
+Test(meta_log, versioned_paths_stay_on_files) {
+    char *json = NULL;
+    size_t len = 0;
+    cr_assert_eq(buckets_meta_log_put(g_disk, "ab/ab00000000000001//versions/v1", "{}", 2),
+                 BUCKETS_ERR_UNSUPPORTED);
+    cr_assert_eq(buckets_meta_log_get(g_disk, "ab/ab00000000000001//versions/v1", &json, &len),
+                 BUCKETS_ERR_UNSUPPORTED);
+
+    buckets_meta_log_set_enabled(false);
+    char path[64];
+    object_path("c", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{}", 2), BUCKETS_ERR_UNSUPPORTED);
+}
+
+/* ===================================================================
+ * Recovery Tests
+ * ===================================================================*/
+
+Test(meta_log, replays_after_reopen) {
+    char path[64];
+    for (int i = 0; i < 100; i++) {
+        char key[16], json[32];
+        snprintf(key, sizeof(key), "k%d", i);
+        snprintf(json, sizeof(json), "{\"i\":%d}", i);
+        object_path(key, path, sizeof(path));
+        cr_assert_eq(buckets_meta_log_put(g_disk, path, json, strlen(json)), BUCKETS_OK);
+    }
+    object_path("k7", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_delete(g_disk, path), BUCKETS_OK);
+
+    buckets_meta_log_close_all();
+
+    buckets_meta_log_stats_t stats;
+    cr_assert_eq(buckets_meta_log_get_stats(g_disk, &stats), BUCKETS_OK);
+    cr_assert_eq(stats.objects, 99);
+    cr_assert_not(buckets_meta_log_contains(g_disk, path));
+
+    object_path("k42", path, sizeof(path));
+    char *json = get_json(path);
+    cr_assert_str_eq(json, "{\"i\":42}");
+    buckets_free(json);
+}
+
+Test(meta_log, torn_tail_is_truncated) {
+    char path[64];
+    object_path("torn", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{\"ok\":true}", 11), BUCKETS_OK);
+    buckets_meta_log_close_all();
+
+    char log_path[256];
+    snprintf(log_path, sizeof(log_path), "%s/.buckets.sys/meta.log", g_disk);
+    struct stat st;
+    cr_assert_eq(stat(log_path, &st), 0);
+    off_t good = st.st_size;
+
+    /* Half a header, as if the process died mid-append */
+    int fd = open(log_path, O_WRONLY | O_APPEND);
+    cr_assert_geq(fd, 0);
+    cr_assert_eq(write(fd, "MLOGxxxxxx", 10), 10);
+    close(fd);
+
+    char *json = get_json(path);
+    cr_assert_str_eq(json, "{\"ok\":true}");
+    buckets_free(json);
+    cr_assert_eq(stat(log_path, &st), 0);
+    cr_assert_eq(st.st_size, good);
+
+    /* Appends after recovery land on a clean boundary */
+    object_path("after", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{}", 2), BUCKETS_OK);
+    buckets_meta_log_close_all();
+    cr_assert(buckets_meta_log_contains(g_disk, path));
+}
+
+/* ===================================================================
+ * Compaction and Iteration Tests
+ * ===================================================================*/
+
+Test(meta_log, compaction_keeps_live_records) {
+    char path[64];
+    char value[512];
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 20; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "c%d", i);
+            object_path(key, path, sizeof(path));
+            value[0] = (char)('0' + round);
+            cr_assert_eq(buckets_meta_log_put(g_disk, path, value, strlen(value)), BUCKETS_OK);
+        }
+    }
+
+    buckets_meta_log_stats_t before, after;
+    cr_assert_eq(buckets_meta_log_get_stats(g_disk, &before), BUCKETS_OK);
+    cr_assert_eq(buckets_meta_log_compact(g_disk), BUCKETS_OK);
+    cr_assert_eq(buckets_meta_log_get_stats(g_disk, &after), BUCKETS_OK);
+
+    cr_assert_eq(after.objects, 20);
+    cr_assert_eq(after.log_bytes, after.live_bytes);
+    cr_assert_lt(after.log_bytes * 5, before.log_bytes);
+    cr_assert_eq(after.compactions, 1);
+
+    object_path("c3", path, sizeof(path));
+    char *json = get_json(path);
+    cr_assert_eq(json[0], '9');
+    buckets_free(json);
+
+    /* Survives a reopen of the compacted file */
+    buckets_meta_log_close_all();
+    json = get_json(path);
+    cr_assert_not_null(json);
+    cr_assert_eq(json[0], '9');
+    buckets_free(json);
+}
+
+static int count_entry(const char *object_path, const char *json, size_t len, void *arg) {
+    (void)object_path;
+    (void)json;
+    cr_assert_gt(len, 0);
+    (*(int*)arg)++;
+    return 0;
+}
+
+Test(meta_log, foreach_visits_live_records) {
+    char path[64];
+    for (int i = 0; i < 30; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "f%d", i);
+        object_path(key, path, sizeof(path));
+        cr_assert_eq(buckets_meta_log_put(g_disk, path, "{}", 2), BUCKETS_OK);
+    }
+    object_path("f0", path, sizeof(path));
+    buckets_meta_log_delete(g_disk, path);
+
+    int seen = 0;
+    cr_assert_eq(buckets_meta_log_foreach(g_disk, count_entry, &seen), BUCKETS_OK);
+    cr_assert_eq(seen, 29);
+}
+
+/* ===================================================================
+ * Integration Tests
+ * ===================================================================*/
+
+Test(meta_log, xl_meta_api_uses_log) {
+    char path[64];
+    object_path("meta", path, sizeof(path));
+
+    extern bool buckets_object_exists(const char *disk_path, const char *object_path);
+
+    buckets_xl_meta_t meta = {0};
+    meta.version = 1;
+    strcpy(meta.format, "xl");
+    meta.stat.size = 123;
+    meta.bucket = buckets_strdup("bucket");
+    meta.object = buckets_strdup("meta");
+    cr_assert_eq(buckets_write_xl_meta(g_disk, path, &meta), 0);
+    buckets_xl_meta_free(&meta);
+
+    cr_assert(buckets_meta_log_contains(g_disk, path));
+    cr_assert(buckets_object_exists(g_disk, path));
+
+    buckets_xl_meta_t back = {0};
+    cr_assert_eq(buckets_read_xl_meta(g_disk, path, &back), 0);
+    cr_assert_eq(back.stat.size, 123);
+    buckets_xl_meta_free(&back);
+
+    cr_assert_eq(buckets_delete_xl_meta(g_disk, path), 0);
+    cr_assert_not(buckets_object_exists(g_disk, path));
+    cr_assert_eq(buckets_delete_xl_meta(g_disk, path), -1);
+}
+
+Test(meta_log, legacy_file_read_until_rewritten) {
+    char path[64];
+    object_path("legacy", path, sizeof(path));
+
+    buckets_meta_log_set_enabled(false);
+    cr_assert_eq(buckets_disk_write_file(g_disk, path, "xl.meta", "{\"old\":1}", 9), BUCKETS_OK);
+    buckets_meta_log_set_enabled(true);
+
+    extern bool buckets_object_exists(const char *disk_path, const char *object_path);
+    cr_assert_not(buckets_meta_log_contains(g_disk, path));
+    cr_assert(buckets_object_exists(g_disk, path));
+
+    /* Delete removes the file too */
+    cr_assert_eq(buckets_delete_xl_meta(g_disk, path), 0);
+    cr_assert_not(buckets_object_exists(g_disk, path));
+}
+
+Test(meta_log, sees_appends_from_other_processes) {
+    char path[64];
+    object_path("parent", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{}", 2), BUCKETS_OK);
+
+    pid_t pid = fork();
+    cr_assert_geq(pid, 0);
+    if (pid == 0) {
+        buckets_meta_log_reinit_after_fork();
+        char child_path[64];
+        object_path("child", child_path, sizeof(child_path));
+        _exit(buckets_meta_log_put(g_disk, child_path, "{\"c\":1}", 7) == BUCKETS_OK ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    cr_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    object_path("child", path, sizeof(path));
+    char *json = get_json(path);
+    cr_assert_not_null(json);
+    cr_assert_str_eq(json, "{\"c\":1}");
+    buckets_free(json);
+}
+
+Test(meta_log, unsealed_compaction_is_followed) {
+    char path[64];
+    object_path("before", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{}", 2), BUCKETS_OK);
+
+    /* A compactor that renamed its file in and died before sealing the old one */
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "cd %s/.buckets.sys && cp meta.log meta.log.compact && "
+             "mv meta.log.compact meta.log", g_disk);
+    cr_assert_eq(system(cmd), 0);
+
+    object_path("after", path, sizeof(path));
+    cr_assert_eq(buckets_meta_log_put(g_disk, path, "{\"a\":1}", 7), BUCKETS_OK);
+
+    /* The append landed in the file named meta.log, not the unlinked one */
+    buckets_meta_log_close_all();
+    char *json = get_json(path);
+    cr_assert_not_null(json);
+    cr_assert_str_eq(json, "{\"a\":1}");
+    buckets_free(json);
+
+    object_path("before", path, sizeof(path));
+    json = get_json(path);
+    cr_assert_not_null(json);
+    buckets_free(json);
+}
@@ -484,3 +484,44 @@ Test(metadata, etag_computed_automatically, .init = setup, .fini = teardown) {
     buckets_xl_meta_free(&meta);
     buckets_xl_meta_free(&read_meta);
 }
+
+/* ===== Batched xl.meta Write Tests ===== */
+
+static char* batch_meta_json(const char *mod_time) {
+    buckets_xl_meta_t meta = {0};
+    meta.version = 1;
+    strcpy(meta.format, "xl");
+    strcpy(meta.stat.modTime, mod_time);
+    return buckets_xl_meta_to_json(&meta);
+}
+
+Test(metadata, batch_write_same_file_last_wins, .init = setup, .fini = teardown) {
+    char *older = batch_meta_json("2026-10-18T10:00:01.000Z");
+    char *newer = batch_meta_json("2026-10-18T10:00:02.000Z");
+    buckets_xl_meta_batch_item_t items[2] = {
+        { "testbucket", "dup.txt", test_data_dir, older, -1 },
+        { "testbucket", "dup.txt", test_data_dir, newer, -1 }
+    };
+
+    cr_assert_eq(buckets_write_xl_meta_batch(items, 2), 0);
+    cr_assert_eq(items[0].result, 0);
+    cr_assert_eq(items[1].result, 0);
+
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("testbucket", "dup.txt", object_path, sizeof(object_path));
+    buckets_xl_meta_t read_meta;
+    cr_assert_eq(buckets_read_xl_meta(test_data_dir, object_path, &read_meta), 0);
+    cr_assert_str_eq(read_meta.stat.modTime, "2026-10-18T10:00:02.000Z");
+    buckets_xl_meta_free(&read_meta);
+
+    buckets_free(older);
+    buckets_free(newer);
+}
+
+Test(metadata, batch_write_rejects_oversized_batch, .init = setup, .fini = teardown) {
+    size_t count = BUCKETS_XL_META_BATCH_MAX + 1;
+    buckets_xl_meta_batch_item_t *items = buckets_calloc(count, sizeof(*items));
+    cr_assert_eq(buckets_write_xl_meta_batch(items, count), (int)count);
+    cr_assert_eq(items[0].result, -1);
+    buckets_free(items);
+}
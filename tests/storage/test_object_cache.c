@@ -0,0 +1,212 @@
+/**
+ * Hot Object Cache Tests
+ *
+ * Unit tests for TinyLFU admission, the memory budget and invalidation.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+#define OBJ_SIZE 1024
+#define SLOT     (OBJ_SIZE + 256)   /* Object plus per-entry overhead */
+
+static char g_payload[OBJ_SIZE];
+
+void setup(void) {
+    buckets_init();
+    memset(g_payload, 'x', sizeof(g_payload));
+    /* Room for exactly four objects */
+    cr_assert_eq(buckets_object_cache_init(4 * SLOT, 2 * OBJ_SIZE, 0), BUCKETS_OK);
+}
+
+void teardown(void) {
+    buckets_object_cache_cleanup();
+    buckets_cleanup();
+}
+
+TestSuite(object_cache, .init = setup, .fini = teardown);
+
+/* Miss, then offer the object as a GET would */
+static int get_or_admit(const char *key) {
+    buckets_cached_object_t out;
+    u64 token = 0;
+    if (buckets_object_cache_get("bucket", key, &out, &token) == 0) {
+        buckets_cached_object_free(&out);
+        return 1;
+    }
+
+    buckets_cached_object_t obj = { .data = g_payload, .size = OBJ_SIZE };
+    snprintf(obj.etag, sizeof(obj.etag), "etag-%s", key);
+    buckets_object_cache_admit("bucket", key, &obj, token);
+    return 0;
+}
+
+static bool is_cached(const char *key) {
+    buckets_object_cache_stats_t before, after;
+    buckets_object_cache_get_stats(&before);
+    buckets_cached_object_t out;
+    bool hit = buckets_object_cache_get("bucket", key, &out, NULL) == 0;
+    if (hit) {
+        buckets_cached_object_free(&out);
+    }
+    buckets_object_cache_get_stats(&after);
+    cr_assert_eq(after.hits + after.misses, before.hits + before.misses + 1);
+    return hit;
+}
+
+/* ===================================================================
+ * Basic Tests
+ * ===================================================================*/
+
+Test(object_cache, hit_returns_stored_object) {
+    char *keys[] = { "ct" };
+    char *values[] = { "v" };
+    buckets_cached_object_t obj = {
+        .data = g_payload, .size = OBJ_SIZE, .content_type = "image/png",
+        .user_keys = keys, .user_values = values, .user_count = 1,
+    };
+    snprintf(obj.etag, sizeof(obj.etag), "\"abc123\"");
+
+    buckets_cached_object_t out;
+    u64 token = 0;
+    cr_assert_eq(buckets_object_cache_get("bucket", "thumb.png", &out, &token), -1);
+    cr_assert_eq(buckets_object_cache_admit("bucket", "thumb.png", &obj, token), 0);
+
+    cr_assert_eq(buckets_object_cache_get("bucket", "thumb.png", &out, NULL), 0);
+    cr_assert_eq(out.size, OBJ_SIZE);
+    cr_assert_eq(memcmp(out.data, g_payload, OBJ_SIZE), 0);
+    cr_assert_str_eq(out.etag, "\"abc123\"");
+    cr_assert_str_eq(out.content_type, "image/png");
+    cr_assert_eq(out.user_count, 1);
+    cr_assert_str_eq(out.user_keys[0], "ct");
+    cr_assert_str_eq(out.user_values[0], "v");
+    buckets_cached_object_free(&out);
+}
+
+Test(object_cache, oversized_objects_are_not_cached) {
+    static char big[4 * OBJ_SIZE];
+    buckets_cached_object_t obj = { .data = big, .size = sizeof(big) };
+    u64 token = 0;
+    buckets_cached_object_t out;
+    buckets_object_cache_get("bucket", "big", &out, &token);
+    cr_assert_eq(buckets_object_cache_admit("bucket", "big", &obj, token), -1);
+
+    buckets_object_cache_stats_t stats;
+    buckets_object_cache_get_stats(&stats);
+    cr_assert_eq(stats.oversized, 1);
+    cr_assert_eq(stats.entries, 0);
+}
+
+/* ===================================================================
+ * Invalidation Tests
+ * ===================================================================*/
+
+Test(object_cache, invalidate_drops_entry) {
+    get_or_admit("manifest.json");
+    cr_assert(is_cached("manifest.json"));
+
+    buckets_object_cache_invalidate("bucket", "manifest.json");
+    cr_assert_not(is_cached("manifest.json"));
+}
+
+Test(object_cache, invalidation_reaches_forked_workers) {
+    /* Cache created before the fork, as in BUCKETS_WORKERS mode */
+    get_or_admit("shared");
+    cr_assert(is_cached("shared"));
+
+    /* A sibling worker handles the PUT */
+    pid_t pid = fork();
+    cr_assert_neq(pid, -1);
+    if (pid == 0) {
+        buckets_object_cache_invalidate("bucket", "shared");
+        _exit(0);
+    }
+    int status = 0;
+    cr_assert_eq(waitpid(pid, &status, 0), pid);
+    cr_assert(WIFEXITED(status));
+
+    cr_assert_not(is_cached("shared"));
+}
+
+Test(object_cache, read_racing_a_put_is_not_admitted) {
+    buckets_cached_object_t out;
+    u64 token = 0;
+    cr_assert_eq(buckets_object_cache_get("bucket", "config", &out, &token), -1);
+
+    /* PUT completes while the GET is still reading the old version */
+    buckets_object_cache_invalidate("bucket", "config");
+
+    buckets_cached_object_t obj = { .data = g_payload, .size = OBJ_SIZE };
+    cr_assert_eq(buckets_object_cache_admit("bucket", "config", &obj, token), -1);
+    cr_assert_not(is_cached("config"));
+
+    buckets_object_cache_stats_t stats;
+    buckets_object_cache_get_stats(&stats);
+    cr_assert_eq(stats.stale_admits, 1);
+}
+
+/* ===================================================================
+ * Admission Tests
+ * ===================================================================*/
+
+Test(object_cache, budget_is_respected) {
+    char key[16];
+    for (int i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "hot-%d", i);
+        get_or_admit(key);
+    }
+
+    buckets_object_cache_stats_t stats;
+    buckets_object_cache_get_stats(&stats);
+    cr_assert_eq(stats.entries, 4);
+    cr_assert_leq(stats.bytes, stats.max_bytes);
+}
+
+Test(object_cache, cold_object_does_not_displace_hot_ones) {
+    char key[16];
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 4; i++) {
+            snprintf(key, sizeof(key), "hot-%d", i);
+            get_or_admit(key);
+        }
+    }
+
+    /* A one-off scan must not flush the working set */
+    for (int i = 0; i < 20; i++) {
+        snprintf(key, sizeof(key), "scan-%d", i);
+        get_or_admit(key);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "hot-%d", i);
+        cr_assert(is_cached(key), "%s was evicted by a scan", key);
+    }
+
+    buckets_object_cache_stats_t stats;
+    buckets_object_cache_get_stats(&stats);
+    cr_assert_geq(stats.rejections, 20);
+}
+
+Test(object_cache, popular_object_replaces_colder_entry) {
+    char key[16];
+    for (int i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "warm-%d", i);
+        get_or_admit(key);
+    }
+
+    /* Requested repeatedly: eventually more popular than the LRU victim */
+    for (int i = 0; i < 4; i++) {
+        get_or_admit("rising");
+    }
+    cr_assert(is_cached("rising"));
+
+    buckets_object_cache_stats_t stats;
+    buckets_object_cache_get_stats(&stats);
+    cr_assert_eq(stats.entries, 4);
+    cr_assert_geq(stats.evictions, 1);
+}
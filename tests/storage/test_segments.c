@@ -0,0 +1,354 @@
+/**
+ * Segmented Object Tests
+ *
+ * Unit tests for splitting large objects into independently placed
+ * segments. Segments are kept below the inline threshold so the tests run
+ * on a single data directory.
+ */
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+#define SEGMENT_SIZE (64 * 1024)
+#define OBJECT_SIZE  (3 * SEGMENT_SIZE + 8192)
+
+static char test_data_dir[PATH_MAX];
+
+void setup(void)
+{
+    buckets_init();
+    buckets_set_log_level(BUCKETS_LOG_ERROR);
+
+    snprintf(test_data_dir, sizeof(test_data_dir), "/tmp/buckets_segments_%d", getpid());
+    mkdir(test_data_dir, 0755);
+
+    buckets_storage_config_t config = {
+        .data_dir = test_data_dir,
+        .inline_threshold = 128 * 1024,
+        .default_ec_k = 8,
+        .default_ec_m = 4,
+        .verify_checksums = true
+    };
+    cr_assert_eq(buckets_storage_init(&config), 0);
+
+    buckets_segment_config_t seg = { .segment_size = SEGMENT_SIZE, .parallel = 3 };
+    buckets_segments_configure(&seg);
+}
+
+void teardown(void)
+{
+    buckets_segment_config_t seg = { .segment_size = 0, .parallel = 0 };
+    buckets_segments_configure(&seg);
+    buckets_storage_cleanup();
+
+    char cmd[PATH_MAX + 32];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s 2>/dev/null", test_data_dir);
+    int ret = system(cmd);
+    (void)ret;
+    buckets_cleanup();
+}
+
+TestSuite(segments, .init = setup, .fini = teardown);
+
+static u8* make_object(u8 seed)
+{
+    u8 *data = malloc(OBJECT_SIZE);
+    for (size_t i = 0; i < OBJECT_SIZE; i++) {
+        data[i] = (u8)(i * 31 + seed);
+    }
+    return data;
+}
+
+static void read_manifest(const char *object, buckets_xl_meta_t *meta)
+{
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("bucket", object, object_path, sizeof(object_path));
+    cr_assert_eq(buckets_read_xl_meta(test_data_dir, object_path, meta), 0);
+}
+
+static bool segment_exists(const char *prefix, u32 index)
+{
+    char key[PATH_MAX];
+    buckets_segment_key(prefix, index, key, sizeof(key));
+    void *data = NULL;
+    size_t size = 0;
+    if (buckets_get_object(BUCKETS_SYSTEM_BUCKET, key, &data, &size) != 0) {
+        return false;
+    }
+    buckets_free(data);
+    return true;
+}
+
+/* ===================================================================
+ * Layout Tests
+ * ===================================================================*/
+
+Test(segments, manifest_json_round_trip) {
+    buckets_xl_meta_t meta = {0};
+    meta.version = 1;
+    strcpy(meta.format, "xl");
+    meta.stat.size = OBJECT_SIZE;
+    meta.segments.count = 4;
+    meta.segments.size = SEGMENT_SIZE;
+    meta.segments.prefix = buckets_strdup("segments/abc");
+
+    char *json = buckets_xl_meta_to_json(&meta);
+    cr_assert_not_null(json);
+
+    buckets_xl_meta_t parsed;
+    cr_assert_eq(buckets_xl_meta_from_json(json, &parsed), 0);
+    cr_assert(buckets_xl_meta_is_segmented(&parsed));
+    cr_assert_eq(parsed.segments.count, 4);
+    cr_assert_eq(parsed.segments.size, SEGMENT_SIZE);
+    cr_assert_str_eq(parsed.segments.prefix, "segments/abc");
+
+    buckets_free(json);
+    buckets_xl_meta_free(&parsed);
+    buckets_xl_meta_free(&meta);
+    cr_assert_null(meta.segments.prefix);
+}
+
+Test(segments, split_only_large_user_objects) {
+    cr_assert(buckets_segments_should_split("bucket", SEGMENT_SIZE + 1));
+    cr_assert_not(buckets_segments_should_split("bucket", SEGMENT_SIZE));
+    cr_assert_not(buckets_segments_should_split(BUCKETS_SYSTEM_BUCKET, OBJECT_SIZE));
+
+    buckets_segment_config_t off = { .segment_size = 0, .parallel = 4 };
+    buckets_segments_configure(&off);
+    cr_assert_not(buckets_segments_should_split("bucket", OBJECT_SIZE));
+}
+
+/* ===================================================================
+ * Object Tests
+ * ===================================================================*/
+
+Test(segments, put_and_get_segmented_object) {
+    u8 *data = make_object(7);
+    cr_assert_eq(buckets_put_object("bucket", "big", data, OBJECT_SIZE, "video/mp4"), 0);
+
+    buckets_xl_meta_t meta;
+    read_manifest("big", &meta);
+    cr_assert(buckets_xl_meta_is_segmented(&meta));
+    cr_assert_eq(meta.segments.count, 4);
+    cr_assert_eq(meta.stat.size, OBJECT_SIZE);
+    cr_assert_null(meta.inline_data);
+    cr_assert_str_eq(meta.meta.content_type, "video/mp4");
+    for (u32 i = 0; i < 4; i++) {
+        cr_assert(segment_exists(meta.segments.prefix, i));
+    }
+    cr_assert_not(segment_exists(meta.segments.prefix, 4));
+    buckets_xl_meta_free(&meta);
+
+    void *out = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_get_object("bucket", "big", &out, &size), 0);
+    cr_assert_eq(size, OBJECT_SIZE);
+    cr_assert_eq(memcmp(out, data, OBJECT_SIZE), 0);
+
+    buckets_free(out);
+    free(data);
+}
+
+Test(segments, overwrite_reclaims_old_segments) {
+    u8 *first = make_object(1);
+    u8 *second = make_object(2);
+
+    cr_assert_eq(buckets_put_object("bucket", "big", first, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t old;
+    read_manifest("big", &old);
+
+    cr_assert_eq(buckets_put_object("bucket", "big", second, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t meta;
+    read_manifest("big", &meta);
+    cr_assert_str_neq(meta.segments.prefix, old.segments.prefix);
+    for (u32 i = 0; i < old.segments.count; i++) {
+        cr_assert_not(segment_exists(old.segments.prefix, i));
+    }
+
+    void *out = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_get_object("bucket", "big", &out, &size), 0);
+    cr_assert_eq(memcmp(out, second, OBJECT_SIZE), 0);
+
+    buckets_free(out);
+    buckets_xl_meta_free(&meta);
+    buckets_xl_meta_free(&old);
+    free(first);
+    free(second);
+}
+
+Test(segments, delete_removes_segments) {
+    u8 *data = make_object(3);
+    cr_assert_eq(buckets_put_object("bucket", "big", data, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t meta;
+    read_manifest("big", &meta);
+
+    cr_assert_eq(buckets_delete_object("bucket", "big"), 0);
+    for (u32 i = 0; i < meta.segments.count; i++) {
+        cr_assert_not(segment_exists(meta.segments.prefix, i));
+    }
+
+    void *out = NULL;
+    size_t size = 0;
+    cr_assert_neq(buckets_get_object("bucket", "big", &out, &size), 0);
+
+    buckets_xl_meta_free(&meta);
+    free(data);
+}
+
+Test(segments, reads_work_with_segmentation_off) {
+    u8 *data = make_object(4);
+    cr_assert_eq(buckets_put_object("bucket", "big", data, OBJECT_SIZE, NULL), 0);
+
+    buckets_segment_config_t off = { .segment_size = 0, .parallel = 4 };
+    buckets_segments_configure(&off);
+
+    void *out = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_get_object("bucket", "big", &out, &size), 0);
+    cr_assert_eq(size, OBJECT_SIZE);
+    cr_assert_eq(memcmp(out, data, OBJECT_SIZE), 0);
+
+    buckets_free(out);
+    free(data);
+}
+
+/* ===================================================================
+ * Reclaim Tests
+ * ===================================================================*/
+
+static void enable_grace(u32 grace_ms)
+{
+    buckets_segment_config_t seg = { .segment_size = SEGMENT_SIZE, .parallel = 3,
+                                     .grace_ms = grace_ms };
+    buckets_segments_configure(&seg);
+}
+
+Test(segments, overwrite_keeps_old_segments_for_grace_period) {
+    enable_grace(100);
+    u8 *first = make_object(5);
+    u8 *second = make_object(6);
+
+    cr_assert_eq(buckets_put_object("bucket", "big", first, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t old;
+    read_manifest("big", &old);
+    cr_assert_eq(buckets_put_object("bucket", "big", second, OBJECT_SIZE, NULL), 0);
+
+    /* A reader still holding the old manifest can finish */
+    for (u32 i = 0; i < old.segments.count; i++) {
+        cr_assert(segment_exists(old.segments.prefix, i));
+    }
+
+    usleep(150 * 1000);
+    buckets_segments_reap(false);
+    for (u32 i = 0; i < old.segments.count; i++) {
+        cr_assert_not(segment_exists(old.segments.prefix, i));
+    }
+
+    /* The live object's own check keeps its segments */
+    buckets_xl_meta_t meta;
+    read_manifest("big", &meta);
+    for (u32 i = 0; i < meta.segments.count; i++) {
+        cr_assert(segment_exists(meta.segments.prefix, i));
+    }
+
+    buckets_xl_meta_free(&meta);
+    buckets_xl_meta_free(&old);
+    free(first);
+    free(second);
+}
+
+Test(segments, plain_put_reclaims_segments) {
+    u8 *data = make_object(8);
+    cr_assert_eq(buckets_put_object("bucket", "big", data, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t old;
+    read_manifest("big", &old);
+
+    cr_assert_eq(buckets_put_object("bucket", "big", "small", 5, NULL), 0);
+    for (u32 i = 0; i < old.segments.count; i++) {
+        cr_assert_not(segment_exists(old.segments.prefix, i));
+    }
+
+    buckets_xl_meta_free(&old);
+    free(data);
+}
+
+Test(segments, delete_reclaims_with_segmentation_off) {
+    u8 *data = make_object(9);
+    cr_assert_eq(buckets_put_object("bucket", "big", data, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t meta;
+    read_manifest("big", &meta);
+
+    buckets_segment_config_t off = { .segment_size = 0, .parallel = 4 };
+    buckets_segments_configure(&off);
+    cr_assert_eq(buckets_delete_object("bucket", "big"), 0);
+    for (u32 i = 0; i < meta.segments.count; i++) {
+        cr_assert_not(segment_exists(meta.segments.prefix, i));
+    }
+
+    buckets_xl_meta_free(&meta);
+    free(data);
+}
+
+Test(segments, losing_overwrite_reclaims_its_own_segments) {
+    enable_grace(50);
+    u8 *first = make_object(10);
+    u8 *second = make_object(11);
+
+    /* Two overwrites that both replaced the same manifest: the one whose
+     * manifest lands first loses */
+    cr_assert_eq(buckets_put_object("bucket", "big", first, OBJECT_SIZE, NULL), 0);
+    buckets_xl_meta_t loser;
+    read_manifest("big", &loser);
+
+    buckets_xl_meta_t winner = {0};
+    winner.version = 1;
+    strcpy(winner.format, "xl");
+    winner.stat.size = OBJECT_SIZE;
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("bucket", "big", object_path, sizeof(object_path));
+    cr_assert_eq(buckets_write_segments("bucket", "big", object_path, NULL, test_data_dir,
+                                        second, OBJECT_SIZE, &winner), 0);
+
+    usleep(100 * 1000);
+    buckets_segments_reap(false);
+    for (u32 i = 0; i < loser.segments.count; i++) {
+        cr_assert_not(segment_exists(loser.segments.prefix, i));
+    }
+    for (u32 i = 0; i < winner.segments.count; i++) {
+        cr_assert(segment_exists(winner.segments.prefix, i));
+    }
+
+    buckets_xl_meta_free(&winner);
+    buckets_xl_meta_free(&loser);
+    free(first);
+    free(second);
+}
+
+Test(segments, lookups_only_where_segmentation_was_enabled) {
+    /* setup enabled segmentation: the data directory remembers it */
+    char marker[PATH_MAX + 32];
+    snprintf(marker, sizeof(marker), "%s/%s", test_data_dir, BUCKETS_SEGMENT_MARKER);
+    cr_assert_eq(access(marker, F_OK), 0);
+
+    buckets_segment_config_t off = { .segment_size = 0, .parallel = 4 };
+    buckets_segments_configure(&off);
+
+    char fresh[PATH_MAX + 16];
+    snprintf(fresh, sizeof(fresh), "%s/fresh", test_data_dir);
+    mkdir(fresh, 0755);
+    buckets_segments_open(fresh);
+    cr_assert_not(buckets_segments_may_exist());
+    buckets_xl_meta_t meta;
+    cr_assert_not(buckets_segments_find_manifest("bucket", "big", &meta));
+
+    buckets_segments_open(test_data_dir);
+    cr_assert(buckets_segments_may_exist());
+}
@@ -0,0 +1,355 @@
+/**
+ * Storage Class Tests
+ *
+ * Unit tests for size/bucket-based choice between replicas and erasure
+ * coding, and for reading replicated objects.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+extern int buckets_compute_chunk_checksum(const void *data, size_t size,
+                                          buckets_checksum_t *checksum);
+
+void setup(void) {
+    buckets_init();
+}
+
+void teardown(void) {
+    buckets_cleanup();
+}
+
+TestSuite(storage_class, .init = setup, .fini = teardown);
+
+/* ===================================================================
+ * Policy Parsing Tests
+ * ===================================================================*/
+
+Test(storage_class, parse_full_spec) {
+    buckets_storage_policy_t policy = {0};
+    cr_assert_eq(buckets_storage_policy_parse("replicas=2,replica_max=512K,ec=6+3",
+                                              &policy), BUCKETS_OK);
+    cr_assert_eq(policy.replicas, 2);
+    cr_assert_eq(policy.replica_max, 512 * 1024);
+    cr_assert_eq(policy.ec_k, 6);
+    cr_assert_eq(policy.ec_m, 3);
+}
+
+Test(storage_class, parse_keeps_missing_keys) {
+    buckets_storage_policy_t policy = {
+        .replica_max = 4 * 1024 * 1024, .replicas = 3, .ec_k = 8, .ec_m = 4
+    };
+    cr_assert_eq(buckets_storage_policy_parse("ec=4+2", &policy), BUCKETS_OK);
+    cr_assert_eq(policy.replicas, 3);
+    cr_assert_eq(policy.replica_max, 4 * 1024 * 1024);
+    cr_assert_eq(policy.ec_k, 4);
+    cr_assert_eq(policy.ec_m, 2);
+}
+
+Test(storage_class, parse_rejects_garbage_unchanged) {
+    buckets_storage_policy_t policy = { .replicas = 3, .replica_max = 100 };
+    cr_assert_eq(buckets_storage_policy_parse("replica_max=1M,ec=0+2", &policy),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_storage_policy_parse("replicas=0", &policy),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_storage_policy_parse("copies=3", &policy),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(buckets_storage_policy_parse("replica_max=4X", &policy),
+                 BUCKETS_ERR_INVALID_ARG);
+    cr_assert_eq(policy.replicas, 3);
+    cr_assert_eq(policy.replica_max, 100);
+}
+
+/* ===================================================================
+ * Class Selection Tests
+ * ===================================================================*/
+
+Test(storage_class, small_objects_stay_inline) {
+    buckets_storage_class_t sc;
+    buckets_storage_class_select("bucket", 1024, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_INLINE);
+}
+
+Test(storage_class, mid_size_objects_are_replicated) {
+    buckets_storage_class_t sc;
+    buckets_storage_class_select("bucket", 1024 * 1024, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_REPLICATED);
+    cr_assert_eq(sc.data, 1);
+    cr_assert_eq(sc.parity, BUCKETS_REPLICAS_DEFAULT - 1);
+}
+
+Test(storage_class, large_objects_are_erasure_coded) {
+    buckets_storage_policy_t policy;
+    buckets_storage_policy_get(NULL, &policy);
+    policy.ec_k = 8;
+    policy.ec_m = 4;
+    cr_assert_eq(buckets_storage_policy_set(NULL, &policy), BUCKETS_OK);
+
+    buckets_storage_class_t sc;
+    buckets_storage_class_select("bucket", BUCKETS_REPLICA_MAX_DEFAULT, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_ERASURE);
+    cr_assert_eq(sc.data, 8);
+    cr_assert_eq(sc.parity, 4);
+}
+
+Test(storage_class, too_few_disks_falls_back_to_erasure) {
+    buckets_storage_class_t sc;
+    buckets_storage_class_select("bucket", 1024 * 1024, 2, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_ERASURE);
+    buckets_storage_class_select("bucket", 1024 * 1024, 0, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_ERASURE);
+}
+
+Test(storage_class, bucket_override_and_drop) {
+    buckets_storage_policy_t policy;
+    buckets_storage_policy_get(NULL, &policy);
+    policy.replica_max = 0;
+    policy.ec_k = 4;
+    policy.ec_m = 2;
+    cr_assert_eq(buckets_storage_policy_set("media", &policy), BUCKETS_OK);
+
+    buckets_storage_class_t sc;
+    buckets_storage_class_select("media", 1024 * 1024, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_ERASURE);
+    cr_assert_eq(sc.data, 4);
+    cr_assert_eq(sc.parity, 2);
+
+    /* Other buckets keep the default */
+    buckets_storage_class_select("logs", 1024 * 1024, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_REPLICATED);
+
+    cr_assert_eq(buckets_storage_policy_set("media", NULL), BUCKETS_OK);
+    buckets_storage_class_select("media", 1024 * 1024, 12, &sc);
+    cr_assert_eq(sc.type, BUCKETS_STORAGE_CLASS_REPLICATED);
+}
+
+/* ===================================================================
+ * Replica Read Tests
+ * ===================================================================*/
+
+static void make_replica_meta(buckets_xl_meta_t *meta, const void *data, size_t size,
+                              u32 copies) {
+    memset(meta, 0, sizeof(*meta));
+    meta->stat.size = size;
+    meta->erasure.data = 1;
+    meta->erasure.parity = copies - 1;
+    meta->erasure.blockSize = size;
+    strcpy(meta->erasure.algorithm, BUCKETS_ALGO_REPLICATION);
+    meta->erasure.checksums = buckets_malloc(copies * sizeof(buckets_checksum_t));
+    for (u32 i = 0; i < copies; i++) {
+        buckets_compute_chunk_checksum(data, size, &meta->erasure.checksums[i]);
+    }
+}
+
+Test(storage_class, replica_pick_skips_corrupt_copy) {
+    char object[300 * 1024];
+    memset(object, 'r', sizeof(object));
+    buckets_xl_meta_t meta;
+    make_replica_meta(&meta, object, sizeof(object), 3);
+    cr_assert(buckets_xl_meta_is_replicated(&meta));
+
+    void *copies[3];
+    size_t sizes[3] = { sizeof(object), sizeof(object), sizeof(object) };
+    for (int i = 0; i < 3; i++) {
+        copies[i] = buckets_malloc(sizeof(object));
+        memcpy(copies[i], object, sizeof(object));
+    }
+    ((char*)copies[0])[1000] ^= 0x5a;   /* bit rot */
+    sizes[1] = 10;                      /* truncated */
+
+    void *data = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_replica_pick(&meta, copies, sizes, 3, &data, &size), 0);
+    cr_assert_eq(size, sizeof(object));
+    cr_assert_eq(memcmp(data, object, size), 0);
+    cr_assert_null(copies[0]);
+    cr_assert_null(copies[1]);
+    cr_assert_null(copies[2]);
+
+    buckets_free(data);
+    buckets_free(meta.erasure.checksums);
+}
+
+Test(storage_class, replica_pick_fails_when_all_corrupt) {
+    char object[200 * 1024];
+    memset(object, 'x', sizeof(object));
+    buckets_xl_meta_t meta;
+    make_replica_meta(&meta, object, sizeof(object), 2);
+
+    void *copies[2];
+    size_t sizes[2] = { sizeof(object), sizeof(object) };
+    for (int i = 0; i < 2; i++) {
+        copies[i] = buckets_malloc(sizeof(object));
+        memset(copies[i], 'y', sizeof(object));
+    }
+
+    void *data = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_replica_pick(&meta, copies, sizes, 2, &data, &size), -1);
+    cr_assert_null(data);
+    cr_assert_null(copies[0]);
+    cr_assert_null(copies[1]);
+    buckets_free(meta.erasure.checksums);
+}
+
+/* ===================================================================
+ * Replica Placement Tests
+ * ===================================================================*/
+
+#define SET_DISKS 6
+
+Test(storage_class, replica_view_maps_copies_to_recorded_disks) {
+    char *paths[SET_DISKS] = { "/d1", "/d2", "/d3", "/d4", "/d5", "/d6" };
+    buckets_placement_result_t placement = { .disk_count = SET_DISKS, .disk_paths = paths };
+
+    buckets_xl_meta_t meta;
+    char byte = 0;
+    make_replica_meta(&meta, &byte, 1, 3);
+    u32 distribution[3] = { 5, 6, 1 };
+    meta.erasure.distribution = distribution;
+
+    buckets_replica_view_t view;
+    cr_assert_eq(buckets_replica_view(&placement, &meta, &view), 0);
+    cr_assert_eq(view.placement.disk_count, 3);
+    cr_assert_str_eq(view.placement.disk_paths[0], "/d5");
+    cr_assert_str_eq(view.placement.disk_paths[1], "/d6");
+    cr_assert_str_eq(view.placement.disk_paths[2], "/d1");
+    cr_assert_null(view.placement.disk_endpoints);
+
+    /* Written before distribution was recorded: copy i on disk i */
+    meta.erasure.distribution = NULL;
+    cr_assert_eq(buckets_replica_view(&placement, &meta, &view), 0);
+    cr_assert_str_eq(view.placement.disk_paths[2], "/d3");
+    buckets_free(meta.erasure.checksums);
+}
+
+Test(storage_class, replicas_spread_over_the_set) {
+    setenv("BUCKETS_CHUNK_WRITE_MODE", "atomic", 1);
+
+    char root[64];
+    snprintf(root, sizeof(root), "/tmp/buckets_replicas_%d", getpid());
+    mkdir(root, 0755);
+    char *paths[SET_DISKS];
+    for (int d = 0; d < SET_DISKS; d++) {
+        paths[d] = buckets_format("%s/disk%d", root, d + 1);
+        mkdir(paths[d], 0755);
+    }
+    buckets_placement_result_t placement = { .disk_count = SET_DISKS, .disk_paths = paths };
+
+    char data[4096];
+    memset(data, 'r', sizeof(data));
+    u32 starts[SET_DISKS] = {0};
+
+    for (int n = 0; n < 30; n++) {
+        char object[32];
+        snprintf(object, sizeof(object), "obj-%d", n);
+        char object_path[PATH_MAX];
+        buckets_compute_object_path("bucket", object, object_path, sizeof(object_path));
+
+        buckets_xl_meta_t meta;
+        memset(&meta, 0, sizeof(meta));
+        meta.stat.size = sizeof(data);
+        cr_assert_eq(buckets_write_replicas("bucket", object, object_path, &placement,
+                                            data, sizeof(data), 2, &meta), 0);
+
+        u32 first = meta.erasure.distribution[0];
+        u32 second = meta.erasure.distribution[1];
+        cr_assert(first >= 1 && first <= SET_DISKS);
+        cr_assert_eq(second, first % SET_DISKS + 1, "copies go to consecutive disks");
+        starts[first - 1]++;
+
+        /* Copies are on the chosen disks only, xl.meta on all of them */
+        for (int d = 0; d < SET_DISKS; d++) {
+            bool holds = (u32)(d + 1) == first || (u32)(d + 1) == second;
+            u32 part = (u32)(d + 1) == first ? 1 : 2;
+            void *copy = NULL;
+            size_t copy_size = 0;
+            int ret = buckets_read_chunk(paths[d], object_path, part, &copy, &copy_size);
+            cr_assert_eq(ret == 0, holds, "disk %d of %s", d + 1, object);
+            buckets_free(copy);
+
+            buckets_xl_meta_t on_disk;
+            cr_assert_eq(buckets_read_xl_meta(paths[d], object_path, &on_disk), 0);
+            cr_assert_eq(on_disk.erasure.distribution[0], first);
+            buckets_xl_meta_free(&on_disk);
+        }
+        buckets_xl_meta_free(&meta);
+    }
+
+    /* Not every object starts on the first disk */
+    int used = 0;
+    for (int d = 0; d < SET_DISKS; d++) {
+        used += starts[d] > 0;
+    }
+    cr_assert_geq(used, 4, "replica starts used only %d of %d disks", used, SET_DISKS);
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+    int ret = system(cmd);
+    (void)ret;
+    for (int d = 0; d < SET_DISKS; d++) {
+        buckets_free(paths[d]);
+    }
+}
+
+Test(storage_class, replicated_overwrite_replaces_every_xl_meta) {
+    setenv("BUCKETS_CHUNK_WRITE_MODE", "atomic", 1);
+
+    char root[64];
+    snprintf(root, sizeof(root), "/tmp/buckets_overwrite_%d", getpid());
+    mkdir(root, 0755);
+    char *paths[SET_DISKS];
+    for (int d = 0; d < SET_DISKS; d++) {
+        paths[d] = buckets_format("%s/disk%d", root, d + 1);
+        mkdir(paths[d], 0755);
+    }
+    buckets_placement_result_t placement = { .disk_count = SET_DISKS, .disk_paths = paths };
+    char object_path[PATH_MAX];
+    buckets_compute_object_path("bucket", "obj", object_path, sizeof(object_path));
+
+    /* An earlier inline version on every disk of the set */
+    buckets_xl_meta_t old;
+    memset(&old, 0, sizeof(old));
+    old.version = 1;
+    strcpy(old.format, "xl");
+    old.stat.size = 3;
+    old.inline_data = buckets_strdup("b2xk");
+    for (int d = 0; d < SET_DISKS; d++) {
+        cr_assert_eq(buckets_write_xl_meta(paths[d], object_path, &old), 0);
+    }
+    buckets_xl_meta_free(&old);
+
+    char data[4096];
+    memset(data, 'n', sizeof(data));
+    buckets_xl_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.version = 1;
+    strcpy(meta.format, "xl");
+    meta.stat.size = sizeof(data);
+    cr_assert_eq(buckets_write_replicas("bucket", "obj", object_path, &placement,
+                                        data, sizeof(data), 2, &meta), 0);
+    buckets_xl_meta_free(&meta);
+
+    /* Whichever disk a reader tries first, it sees the new object */
+    for (int d = 0; d < SET_DISKS; d++) {
+        buckets_xl_meta_t on_disk;
+        cr_assert_eq(buckets_read_xl_meta(paths[d], object_path, &on_disk), 0);
+        cr_assert(buckets_xl_meta_is_replicated(&on_disk), "disk %d is stale", d + 1);
+        cr_assert_null(on_disk.inline_data);
+        cr_assert_eq(on_disk.stat.size, sizeof(data));
+        buckets_xl_meta_free(&on_disk);
+    }
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+    int ret = system(cmd);
+    (void)ret;
+    for (int d = 0; d < SET_DISKS; d++) {
+        buckets_free(paths[d]);
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * Startup Timing and Cache Warm-up Tests
+ *
+ * Snapshot save/load against a temporary storage directory.
+ */
+
+#include <criterion/criterion.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+#include "buckets_io.h"
+#include "cJSON.h"
+
+static char test_data_dir[PATH_MAX];
+static char snapshot[PATH_MAX + 32];
+
+void setup(void) {
+    buckets_init();
+    buckets_set_log_level(BUCKETS_LOG_ERROR);
+
+    snprintf(test_data_dir, sizeof(test_data_dir), "/tmp/buckets_warmup_%d", getpid());
+    mkdir(test_data_dir, 0755);
+    snprintf(snapshot, sizeof(snapshot), "%s/cache.snapshot", test_data_dir);
+
+    buckets_storage_config_t config = {
+        .data_dir = test_data_dir,
+        .inline_threshold = 128 * 1024,
+        .default_ec_k = 2,
+        .default_ec_m = 2,
+        .verify_checksums = true
+    };
+    cr_assert_eq(buckets_storage_init(&config), 0);
+    if (!buckets_object_cache_enabled()) {
+        cr_assert_eq(buckets_object_cache_init(1024 * 1024, 64 * 1024, 0), BUCKETS_OK);
+    }
+}
+
+void teardown(void) {
+    buckets_cache_warmup_stop();
+    buckets_object_cache_cleanup();
+    buckets_storage_cleanup();
+
+    char cmd[PATH_MAX + 32];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s 2>/dev/null", test_data_dir);
+    int ret = system(cmd);
+    (void)ret;
+    buckets_cleanup();
+}
+
+TestSuite(warmup, .init = setup, .fini = teardown);
+
+static void cache_object(const char *key) {
+    buckets_cached_object_t out;
+    u64 token = 0;
+    cr_assert_eq(buckets_object_cache_get("bucket", key, &out, &token), -1);
+    buckets_cached_object_t obj = { .data = "data", .size = 4 };
+    cr_assert_eq(buckets_object_cache_admit("bucket", key, &obj, token), 0);
+}
+
+static void write_snapshot(const char *json) {
+    cr_assert_eq(buckets_atomic_write(snapshot, json, strlen(json)), BUCKETS_OK);
+}
+
+/* ===================================================================
+ * Startup Timing Tests
+ * ===================================================================*/
+
+Test(warmup, ready_is_recorded_once) {
+    buckets_startup_begin();
+    buckets_startup_ready();
+
+    buckets_startup_stats_t first, second;
+    buckets_startup_get_stats(&first);
+    cr_assert_gt(first.ready_ms, 0);
+
+    usleep(20 * 1000);
+    buckets_startup_ready();
+    buckets_startup_get_stats(&second);
+    cr_assert_eq(second.ready_ms, first.ready_ms);
+}
+
+/* ===================================================================
+ * Snapshot Tests
+ * ===================================================================*/
+
+Test(warmup, snapshot_lists_hot_objects_most_recent_first) {
+    cache_object("a");
+    cache_object("b");
+    cache_object("c");
+
+    cr_assert_eq(buckets_cache_snapshot_save(snapshot), BUCKETS_OK);
+
+    void *data = NULL;
+    size_t size = 0;
+    cr_assert_eq(buckets_atomic_read(snapshot, &data, &size), BUCKETS_OK);
+    cJSON *root = cJSON_ParseWithLength(data, size);
+    buckets_free(data);
+    cr_assert_not_null(root);
+
+    cJSON *objects = cJSON_GetObjectItem(root, "objects");
+    cr_assert_eq(cJSON_GetArraySize(objects), 3);
+    cr_assert_str_eq(cJSON_GetArrayItem(objects, 0)->valuestring, "bucket/c");
+    cr_assert_str_eq(cJSON_GetArrayItem(objects, 2)->valuestring, "bucket/a");
+    cr_assert(cJSON_IsArray(cJSON_GetObjectItem(root, "registry")));
+    cJSON_Delete(root);
+
+    buckets_startup_stats_t stats;
+    buckets_startup_get_stats(&stats);
+    cr_assert_eq(stats.saved_keys, 3);
+}
+
+Test(warmup, missing_or_unreadable_snapshot_is_ignored) {
+    cr_assert_eq(buckets_cache_warmup_start(snapshot), BUCKETS_ERR_NOT_FOUND);
+
+    write_snapshot("not json");
+    cr_assert_eq(buckets_cache_warmup_start(snapshot), BUCKETS_ERR_INVALID_ARG);
+
+    write_snapshot("{\"version\":99,\"registry\":[],\"objects\":[]}");
+    cr_assert_eq(buckets_cache_warmup_start(snapshot), BUCKETS_ERR_INVALID_ARG);
+}
+
+/* ===================================================================
+ * Warm-up Tests
+ * ===================================================================*/
+
+Test(warmup, replay_rereads_keys_from_storage) {
+    cr_assert_eq(buckets_put_object("bucket", "dir/present", "hello", 5, "text/plain"), 0);
+
+    /* One live object, one deleted since the snapshot, one malformed key */
+    write_snapshot("{\"version\":1,\"registry\":[\"nobucket\"],"
+                   "\"objects\":[\"bucket/dir/present\",\"bucket/gone\"]}");
+    cr_assert_eq(buckets_cache_warmup_start(snapshot), BUCKETS_OK);
+    buckets_cache_warmup_wait();
+
+    buckets_startup_stats_t stats;
+    buckets_startup_get_stats(&stats);
+    cr_assert_eq(stats.warm_keys, 1);
+    cr_assert_eq(stats.warm_failed, 2);
+    cr_assert_gt(stats.warm_ms, 0);
+}
+
+Test(warmup, empty_snapshot_is_warm_immediately) {
+    write_snapshot("{\"version\":1,\"registry\":[],\"objects\":[]}");
+    cr_assert_eq(buckets_cache_warmup_start(snapshot), BUCKETS_OK);
+    buckets_cache_warmup_wait();
+
+    buckets_startup_stats_t stats;
+    buckets_startup_get_stats(&stats);
+    cr_assert_eq(stats.warm_keys, 0);
+    cr_assert_gt(stats.warm_ms, 0);
+}
@@ -0,0 +1,196 @@
+/**
+ * Write Quorum Tests
+ *
+ * Unit tests for quorum policy and the quorum tracker used by PUT fan-outs.
+ */
+
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "buckets.h"
+#include "buckets_storage.h"
+
+void setup(void) {
+    buckets_init();
+}
+
+void teardown(void) {
+    buckets_cleanup();
+}
+
+TestSuite(write_quorum, .init = setup, .fini = teardown);
+
+/* ===================================================================
+ * Policy Tests
+ * ===================================================================*/
+
+Test(write_quorum, default_policy_waits_for_all) {
+    cr_assert_eq(buckets_write_quorum(8, 4), 12);
+    cr_assert_eq(buckets_write_quorum(4, 2), 6);
+}
+
+Test(write_quorum, clamped_to_set_size) {
+    cr_assert_eq(buckets_write_quorum(4, 0), 4);
+    cr_assert_eq(buckets_write_quorum(1, 0), 1);
+}
+
+/* ===================================================================
+ * Tracker Tests
+ * ===================================================================*/
+
+static int g_finish_calls = 0;
+static bool g_finish_committed = false;
+
+static void record_finish(void *owner, bool committed) {
+    (void)owner;
+    g_finish_calls++;
+    g_finish_committed = committed;
+}
+
+typedef struct {
+    buckets_quorum_tracker_t *tracker;
+    useconds_t delay_us;
+    bool ok;
+} worker_arg_t;
+
+static void* slow_worker(void *arg) {
+    worker_arg_t *w = (worker_arg_t *)arg;
+    usleep(w->delay_us);
+    buckets_quorum_tracker_done(w->tracker, w->ok ? 1 : 0, w->ok ? 0 : 1, NULL);
+    return NULL;
+}
+
+Test(write_quorum, all_workers_succeed) {
+    g_finish_calls = 0;
+    buckets_quorum_tracker_t *t = buckets_quorum_tracker_create(3, 3, 3, record_finish, NULL);
+    cr_assert_not_null(t);
+
+    for (int i = 0; i < 3; i++) {
+        buckets_quorum_tracker_done(t, 1, 0, NULL);
+    }
+    cr_assert_eq(buckets_quorum_tracker_wait(t), 0);
+    cr_assert_eq(g_finish_calls, 1);
+    cr_assert(g_finish_committed);
+}
+
+Test(write_quorum, returns_before_straggler) {
+    g_finish_calls = 0;
+    buckets_write_quorum_stats_t before, after;
+    buckets_write_quorum_get_stats(&before);
+
+    buckets_quorum_tracker_t *t = buckets_quorum_tracker_create(3, 2, 3, record_finish, NULL);
+    buckets_quorum_tracker_done(t, 1, 0, NULL);
+    buckets_quorum_tracker_done(t, 1, 0, NULL);
+
+    worker_arg_t straggler = { .tracker = t, .delay_us = 100000, .ok = true };
+    pthread_t thread;
+    pthread_create(&thread, NULL, slow_worker, &straggler);
+
+    cr_assert_eq(buckets_quorum_tracker_wait(t), 0);
+    cr_assert_eq(g_finish_calls, 0, "finish must wait for the straggler");
+
+    pthread_join(thread, NULL);
+    cr_assert_eq(g_finish_calls, 1);
+    cr_assert(g_finish_committed);
+
+    buckets_write_quorum_get_stats(&after);
+    cr_assert_eq(after.early_acks - before.early_acks, 1);
+    cr_assert_eq(after.stragglers - before.stragglers, 1);
+}
+
+Test(write_quorum, fails_once_quorum_unreachable) {
+    g_finish_calls = 0;
+    buckets_write_quorum_stats_t before, after;
+    buckets_write_quorum_get_stats(&before);
+
+    buckets_quorum_tracker_t *t = buckets_quorum_tracker_create(4, 3, 4, record_finish, NULL);
+    buckets_quorum_tracker_done(t, 0, 1, NULL);
+    buckets_quorum_tracker_done(t, 0, 1, NULL);
+
+    /* Two of four failed: quorum of 3 is unreachable without the rest */
+    cr_assert_eq(buckets_quorum_tracker_wait(t), -1);
+
+    buckets_write_quorum_get_stats(&after);
+    cr_assert_eq(after.quorum_failures - before.quorum_failures, 1);
+    cr_assert_eq(after.early_acks, before.early_acks, "a failed write is not an early ack");
+
+    buckets_quorum_tracker_done(t, 1, 0, NULL);
+    buckets_quorum_tracker_done(t, 1, 0, NULL);
+    cr_assert_eq(g_finish_calls, 1);
+    cr_assert_not(g_finish_committed);
+}
+
+Test(write_quorum, multi_shard_workers) {
+    buckets_quorum_tracker_t *t = buckets_quorum_tracker_create(6, 4, 2, NULL, NULL);
+    buckets_quorum_tracker_done(t, 3, 0, NULL);
+    buckets_quorum_tracker_done(t, 1, 2, NULL);
+    cr_assert_eq(buckets_quorum_tracker_wait(t), 0);
+}
+
+/* ===================================================================
+ * Heal Queue Tests
+ * ===================================================================*/
+
+static void heal_meta(buckets_xl_meta_t *meta, const char *mod_time, const char *etag) {
+    memset(meta, 0, sizeof(*meta));
+    meta->version = 1;
+    strcpy(meta->format, "xl");
+    strcpy(meta->stat.modTime, mod_time);
+    meta->stat.size = 4;
+    meta->meta.etag = (char *)etag;
+}
+
+static bool wait_heal_settled(const buckets_write_quorum_stats_t *before) {
+    for (int i = 0; i < 100; i++) {
+        buckets_write_quorum_stats_t now;
+        buckets_write_quorum_get_stats(&now);
+        if (now.heal_repaired + now.heal_superseded >
+            before->heal_repaired + before->heal_superseded) {
+            return true;
+        }
+        usleep(20000);
+    }
+    return false;
+}
+
+Test(write_quorum, heal_skips_superseded_version) {
+    char ref[64], target[64];
+    snprintf(ref, sizeof(ref), "/tmp/buckets_heal_ref_%d", getpid());
+    snprintf(target, sizeof(target), "/tmp/buckets_heal_target_%d", getpid());
+    mkdir(ref, 0755);
+    mkdir(target, 0755);
+
+    /* The committed copy already moved on to a newer PUT */
+    buckets_xl_meta_t newer, healed, out;
+    heal_meta(&newer, "2026-10-18T10:00:02.000Z", "bbbb");
+    heal_meta(&healed, "2026-10-18T10:00:01.000Z", "aaaa");
+    cr_assert_eq(buckets_write_xl_meta(ref, "ab/obj/", &newer), 0);
+
+    buckets_write_quorum_stats_t before, after;
+    buckets_write_quorum_get_stats(&before);
+    buckets_heal_ref_t r = { ref, NULL };
+    cr_assert_eq(buckets_heal_queue_xl_meta("bucket", "obj", "ab/obj/", target, NULL,
+                                            &healed, &r), 0);
+    cr_assert(wait_heal_settled(&before));
+
+    buckets_write_quorum_get_stats(&after);
+    cr_assert_eq(after.heal_superseded - before.heal_superseded, 1);
+    cr_assert_neq(buckets_read_xl_meta(target, "ab/obj/", &out), 0);
+
+    /* Same version on the committed copy: the heal goes through */
+    buckets_write_quorum_get_stats(&before);
+    cr_assert_eq(buckets_heal_queue_xl_meta("bucket", "obj", "ab/obj/", target, NULL,
+                                            &newer, &r), 0);
+    cr_assert(wait_heal_settled(&before));
+    cr_assert_eq(buckets_read_xl_meta(target, "ab/obj/", &out), 0);
+    cr_assert_str_eq(out.stat.modTime, newer.stat.modTime);
+    buckets_xl_meta_free(&out);
+
+    char cmd[192];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", ref, target);
+    int ret = system(cmd);
+    (void)ret;
+}